@@ -0,0 +1,58 @@
+#ifndef CLERIC_BENCH_H
+#define CLERIC_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Minimal helpers shared by the micro-benchmarks in bench/.
+// Benchmarks print one line per measurement; they are not part of the unit test run.
+// Every measurement is also recorded, so `bench_all --json=FILE` can write them all out
+// for regression tracking.
+
+// Monotonic clock in nanoseconds
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+// Sink for benchmark results so the measured work cannot be optimized away
+extern volatile uint64_t bench_sink;
+
+// One measurement. Metrics a benchmark does not have stay 0 and are left out of the JSON.
+typedef struct {
+    char name[64];            // e.g. "pipeline/deep_expr/parse"
+    long long size;           // Workload parameter (depth, declarations, chain length), 0 if none
+    double ns_per_op;
+    double mb_per_s;          // Source (or output) bytes processed per second
+    double nodes_per_s;       // Tokens, AST nodes or TAC instructions per second
+    size_t allocations;       // Arena allocations made by the measured work
+    size_t peak_arena_bytes;  // Arena high-water mark once the measured work is done
+    double cycles_per_op;       // CPU cycles of generated code (bench_codegen), where counters are available
+    double instructions_per_op; // Instructions retired by generated code (bench_codegen)
+} BenchResult;
+
+// Records a measurement for the JSON report (silently dropped once the report is full)
+void bench_record(const BenchResult *result);
+
+// Writes every recorded measurement as a JSON document
+void bench_write_json(FILE *out);
+
+// Synthetic workloads (bench_workloads.c), each a whole malloc'ed program:
+// one return expression nested `depth` levels deep
+char *bench_make_deep_expression(int depth);
+// `count` declarations in one block, each initialized from the previous one
+char *bench_make_wide_declarations(int count);
+// one return of `length` operands joined by `op` ("&&" or "||")
+char *bench_make_logical_chain(int length, const char *op);
+
+void run_lexer_benchmarks(void);
+void run_symbol_table_benchmarks(void);
+void run_strings_benchmarks(void);
+void run_parser_benchmarks(void);
+void run_arena_benchmarks(void);
+void run_pipeline_benchmarks(void);
+
+#endif // CLERIC_BENCH_H
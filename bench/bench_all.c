@@ -0,0 +1,46 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+
+volatile uint64_t bench_sink;
+
+// bench_all [--json=FILE]: runs every benchmark; with --json the measurements are also written to FILE
+int main(const int argc, char *argv[]) {
+    const char *json_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--json=", 7) == 0 && argv[i][7] != '\0') {
+            json_path = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Usage: %s [--json=FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("--- Lexer Benchmarks ---\n");
+    run_lexer_benchmarks();
+    printf("--- Symbol Table Benchmarks ---\n");
+    run_symbol_table_benchmarks();
+    printf("--- String Buffer Benchmarks ---\n");
+    run_strings_benchmarks();
+    printf("--- Arena Benchmarks ---\n");
+    run_arena_benchmarks();
+    printf("--- Parser Benchmarks ---\n");
+    run_parser_benchmarks();
+    printf("--- Pipeline Benchmarks ---\n");
+    run_pipeline_benchmarks();
+
+    if (json_path) {
+        FILE *out = fopen(json_path, "w");
+        if (!out) {
+            perror("Failed to open the JSON report");
+            return 1;
+        }
+        bench_write_json(out);
+        if (fclose(out) != 0) {
+            perror("Failed to write the JSON report");
+            return 1;
+        }
+    }
+    return 0;
+}
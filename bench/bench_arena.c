@@ -0,0 +1,69 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "memory/arena.h"
+
+#define ALLOCATIONS_PER_RUN 10000000
+
+// Node-sized requests, as the parser and IR generation make them
+static const size_t REQUEST_SIZES[] = {16, 24, 40, 8, 64, 32, 48, 16};
+#define NUM_REQUEST_SIZES (sizeof(REQUEST_SIZES) / sizeof(REQUEST_SIZES[0]))
+
+// Times small allocations from one arena, starting over (dirty) whenever a megabyte chunk fills
+static void bench_arena_alloc(const char *label, void *(*alloc)(Arena *, size_t)) {
+    Arena arena = arena_create(1024 * 1024);
+    if (!arena.start) {
+        printf("arena_alloc: out of memory\n");
+        return;
+    }
+    size_t handed_out = 0;
+    const uint64_t start = bench_now_ns();
+    for (int i = 0; i < ALLOCATIONS_PER_RUN; ++i) {
+        const size_t size = REQUEST_SIZES[i & (NUM_REQUEST_SIZES - 1)];
+        char *p = alloc(&arena, size);
+        if (!p) break;
+        p[0] = (char) i;
+        handed_out += size;
+        if (arena.offset + 64 > arena.total_size) {
+            arena_reset_with_mode(&arena, ARENA_RESET_DIRTY);
+        }
+    }
+    const uint64_t elapsed = bench_now_ns() - start;
+    bench_sink += handed_out;
+
+    BenchResult result = {.ns_per_op = (double) elapsed / ALLOCATIONS_PER_RUN,
+                          .mb_per_s = (double) handed_out / ((double) elapsed / 1e9) / 1e6,
+                          .allocations = ALLOCATIONS_PER_RUN,
+                          .peak_arena_bytes = arena_stats(&arena).peak_bytes};
+    snprintf(result.name, sizeof(result.name), "arena/%s", label);
+    bench_record(&result);
+    printf("%-17s %6.2f ns/alloc  %8.1f MB/s\n", result.name, result.ns_per_op, result.mb_per_s);
+    arena_destroy(&arena);
+}
+
+// Same requests through malloc/free, for scale
+static void bench_malloc(void) {
+    void *blocks[NUM_REQUEST_SIZES];
+    const uint64_t start = bench_now_ns();
+    for (int i = 0; i < ALLOCATIONS_PER_RUN; ++i) {
+        const size_t slot = (size_t) i & (NUM_REQUEST_SIZES - 1);
+        if (i >= (int) NUM_REQUEST_SIZES) free(blocks[slot]);
+        blocks[slot] = malloc(REQUEST_SIZES[slot]);
+        if (blocks[slot]) *(char *) blocks[slot] = (char) i;
+    }
+    const uint64_t elapsed = bench_now_ns() - start;
+    for (size_t slot = 0; slot < NUM_REQUEST_SIZES; ++slot) {
+        bench_sink += blocks[slot] != NULL;
+        free(blocks[slot]);
+    }
+    BenchResult result = {.name = "arena/malloc_free", .ns_per_op = (double) elapsed / ALLOCATIONS_PER_RUN};
+    bench_record(&result);
+    printf("%-17s %6.2f ns/alloc\n", result.name, result.ns_per_op);
+}
+
+void run_arena_benchmarks(void) {
+    bench_arena_alloc("alloc", arena_alloc);
+    bench_arena_alloc("alloc_zeroed", arena_alloc_zeroed);
+    bench_malloc();
+}
@@ -0,0 +1,429 @@
+#define _GNU_SOURCE // mkdtemp, syscall
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#include "bench.h"
+#include "compiler/compiler.h"
+#include "memory/arena.h"
+#include "strings/strings.h"
+
+// bench_codegen: how fast is the code cleric generates?
+//
+// Every corpus program is one function, bench_main, built four ways: by cleric at -O0 and -O1
+// (assembled and linked as run_assembler_linker does) and by gcc at -O0 and -O1. A harness built
+// once with gcc -O0 calls it CODEGEN_CALLS times. Each binary runs under hardware counters
+// (perf_event_open: user-space cycles and instructions) and the task clock, and once more with no
+// calls; the difference divided by the calls is the cost of one call, free of process start-up.
+// Where the hardware counters are not available (most virtual machines), only the time is reported.
+// The programs end in a value that all four builds must return alike, so a miscompilation shows
+// up as a mismatch rather than as a fast result.
+
+volatile uint64_t bench_sink;
+
+extern char **environ;
+
+// Calls of bench_main per measured run
+#define CODEGEN_CALLS 20000
+// Every binary keeps the cheapest of this many runs
+#define CODEGEN_REPEATS 5
+
+typedef enum { BUILD_CLERIC_O0, BUILD_CLERIC_O1, BUILD_GCC_O0, BUILD_GCC_O1, BUILD_COUNT } BuildKind;
+
+static const char *const BUILD_NAMES[BUILD_COUNT] = {"cleric-O0", "cleric-O1", "gcc-O0", "gcc-O1"};
+
+#ifdef __APPLE__
+#define CLERIC_LINK_FLAGS NULL
+#else
+// cleric names its functions with a leading underscore (see driver.c) and marks no stack as non-executable
+#define CLERIC_LINK_FLAGS "-Wl,--defsym,bench_main=_bench_main", "-Wl,-z,noexecstack"
+#endif
+
+static const char *const HARNESS_SOURCE =
+        "#include <stdlib.h>\n"
+        "int bench_main(void);\n"
+        "int main(int argc, char **argv) {\n"
+        "    long calls = argc > 1 ? strtol(argv[1], NULL, 10) : 1;\n"
+        "    int result = 0;\n"
+        "    for (long i = 0; i < calls; ++i) result = bench_main();\n"
+        "    return calls ? result & 0xff : 0;\n"
+        "}\n";
+
+// Counts of one run of a binary
+typedef struct {
+    uint64_t ns;           // Task clock of the process, or wall time without perf_event_open
+    uint64_t cycles;       // 0 without hardware counters
+    uint64_t instructions; // 0 without hardware counters
+} RunCounts;
+
+// --- Corpus ---
+
+// Three mixed recurrences, all kept below 1013 by the modulo
+static char *make_arithmetic(const int statements) {
+    char *source = malloc(128 + (size_t) statements * 64);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int bench_main(void) {\n    int a = 1;\n    int b = 2;\n    int c = 3;\n");
+    for (int i = 0; i < statements; i += 3) {
+        end += sprintf(end, "    a = (a * 7 + b * 3 - c + %d) %% 1009;\n", i & 15);
+        end += sprintf(end, "    b = (b * 5 - a + c * 2 + %d) %% 1013;\n", i & 7);
+        end += sprintf(end, "    c = (a + b * 3 - c * 4 + %d) %% 997;\n", i & 31);
+    }
+    strcpy(end, "    return a + b + c;\n}\n");
+    return source;
+}
+
+// Comparisons joined by && and ||, summed up as 0/1 values
+static char *make_predicates(const int statements) {
+    char *source = malloc(128 + (size_t) statements * 96);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int bench_main(void) {\n    int a = 5;\n    int b = 9;\n    int n = 0;\n");
+    for (int i = 0; i < statements; i += 3) {
+        end += sprintf(end, "    n = n + (a < b && b > %d || a == %d && !(b == 0) || a >= n);\n", i & 63, i & 15);
+        end += sprintf(end, "    a = (a + n + %d) %% 101;\n", i & 7);
+        end += sprintf(end, "    b = (b * 3 + a) %% 103;\n");
+    }
+    strcpy(end, "    return n + a + b;\n}\n");
+    return source;
+}
+
+// Division and modulo by constants and by a divisor that never reaches 0
+static char *make_division(const int statements) {
+    char *source = malloc(128 + (size_t) statements * 64);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int bench_main(void) {\n    int a = 1000003;\n    int b = 17;\n");
+    for (int i = 0; i < statements; i += 2) {
+        end += sprintf(end, "    a = a / 3 + a %% 7 * 1000 + %d;\n", i & 255);
+        end += sprintf(end, "    b = (a + b) %% 97 / (b %% 5 + 6) + b / 2 + %d;\n", i & 15);
+    }
+    strcpy(end, "    return a + b;\n}\n");
+    return source;
+}
+
+// `depth` nested blocks, each shadowing the previous block's y
+static char *make_deep_blocks(const int depth) {
+    char *source = malloc(128 + (size_t) depth * 80);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int bench_main(void) {\n    int x = 1;\n    int y = 2;\n");
+    for (int i = 0; i < depth; ++i) {
+        end += sprintf(end, "    { int y = x + %d; x = (x * 3 + y) %% 1001;\n", i & 31);
+    }
+    memset(end, '}', (size_t) depth);
+    strcpy(end + depth, "\n    return x + y;\n}\n");
+    return source;
+}
+
+typedef struct {
+    const char *name;
+    char *(*make)(int size);
+    int size; // Statements, or block depth
+} CorpusProgram;
+
+static const CorpusProgram CORPUS[] = {
+        {"arithmetic", make_arithmetic, 600},
+        {"predicates", make_predicates, 600},
+        {"division", make_division, 400},
+        {"deep_blocks", make_deep_blocks, 300},
+};
+
+// --- Building ---
+
+// Runs a tool to completion; false (with an error printed) unless it exited with 0
+static bool run_tool(char *const argv[]) {
+    pid_t pid;
+    const int error = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+    if (error != 0) {
+        fprintf(stderr, "Failed to start %s: %s\n", argv[0], strerror(error));
+        return false;
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s failed\n", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+static bool write_file(const char *path, const char *data, const size_t length) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    const bool ok = fwrite(data, 1, length, f) == length;
+    return fclose(f) == 0 && ok;
+}
+
+// Compiles the program with cleric into `assembly_path`
+static bool cleric_to_assembly(const char *source, const int optimization_level, const char *assembly_path) {
+    Arena arena = arena_create(strlen(source) * 32 + 64 * 1024);
+    if (!arena.start) {
+        fprintf(stderr, "Out of memory for the cleric arena.\n");
+        return false;
+    }
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = optimization_level;
+    options.fuse_validation = true; // Variables are only lowered by the fused walk
+    options.quiet = true;
+    StringBuffer assembly;
+    string_buffer_init(&assembly, &arena, 64 * 1024);
+    bool ok = compile_with_options(source, &options, &assembly, &arena, NULL);
+    if (ok) {
+        const char *text = string_buffer_flatten(&assembly);
+        ok = write_file(assembly_path, text, assembly.length);
+    }
+    arena_destroy(&arena);
+    return ok;
+}
+
+// Builds one binary of the program in `dir`: `dir`/program.c is the source, `dir`/harness.o the caller
+static bool build_binary(const char *dir, const char *source, const BuildKind kind, const char *binary) {
+    char harness[512], input[512];
+    snprintf(harness, sizeof(harness), "%s/harness.o", dir);
+    if (kind == BUILD_CLERIC_O0 || kind == BUILD_CLERIC_O1) {
+        snprintf(input, sizeof(input), "%s/program.s", dir);
+        if (!cleric_to_assembly(source, kind == BUILD_CLERIC_O1 ? 1 : 0, input)) {
+            return false;
+        }
+        char *argv[] = {"gcc", input, harness, "-o", (char *) binary, CLERIC_LINK_FLAGS, NULL};
+        return run_tool(argv);
+    }
+    snprintf(input, sizeof(input), "%s/program.c", dir);
+    char *argv[] = {"gcc", kind == BUILD_GCC_O1 ? "-O1" : "-O0", input, harness, "-o", (char *) binary, NULL};
+    return run_tool(argv);
+}
+
+// --- Running ---
+
+#ifdef __linux__
+// Opens a counter on a process that has not exec'ed yet; it starts counting at the exec
+static int open_counter(const pid_t pid, const uint32_t type, const uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = type == PERF_TYPE_HARDWARE; // Allowed at the default perf_event_paranoid
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+static uint64_t read_counter(const int fd) {
+    uint64_t value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != (ssize_t) sizeof(value)) {
+        value = 0;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    return value;
+}
+#endif
+
+// Runs `binary calls` once; false unless it exited normally. *out_status receives its exit status.
+static bool run_counted(const char *binary, const long calls, RunCounts *out, int *out_status) {
+    char calls_arg[32];
+    snprintf(calls_arg, sizeof(calls_arg), "%ld", calls);
+    int gate[2]; // The child waits on this until its counters are open
+    if (pipe(gate) != 0) {
+        perror("Failed to create pipe");
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        perror("Failed to fork");
+        close(gate[0]);
+        close(gate[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(gate[1]);
+        char go;
+        if (read(gate[0], &go, 1) == 1) {
+            execl(binary, binary, calls_arg, (char *) NULL);
+        }
+        _exit(127);
+    }
+    close(gate[0]);
+#ifdef __linux__
+    const int cycles_fd = open_counter(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    const int instructions_fd = open_counter(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    const int clock_fd = open_counter(pid, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+#endif
+    const uint64_t start = bench_now_ns();
+    const bool released = write(gate[1], "x", 1) == 1;
+    close(gate[1]);
+    int status;
+    const bool waited = waitpid(pid, &status, 0) == pid;
+    out->ns = bench_now_ns() - start;
+#ifdef __linux__
+    out->cycles = read_counter(cycles_fd);
+    out->instructions = read_counter(instructions_fd);
+    const uint64_t task_ns = read_counter(clock_fd);
+    if (task_ns) {
+        out->ns = task_ns;
+    }
+#else
+    out->cycles = 0;
+    out->instructions = 0;
+#endif
+    if (!released || !waited || !WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+        fprintf(stderr, "Failed to run %s\n", binary);
+        return false;
+    }
+    *out_status = WEXITSTATUS(status);
+    return true;
+}
+
+// Cheapest of CODEGEN_REPEATS runs, counter by counter
+static bool run_cheapest(const char *binary, const long calls, RunCounts *best, int *out_status) {
+    for (int repeat = 0; repeat < CODEGEN_REPEATS; ++repeat) {
+        RunCounts counts;
+        if (!run_counted(binary, calls, &counts, out_status)) {
+            return false;
+        }
+        if (repeat == 0 || counts.ns < best->ns) best->ns = counts.ns;
+        if (repeat == 0 || counts.cycles < best->cycles) best->cycles = counts.cycles;
+        if (repeat == 0 || counts.instructions < best->instructions) best->instructions = counts.instructions;
+    }
+    return true;
+}
+
+static double per_call(const uint64_t with_calls, const uint64_t without) {
+    return with_calls > without ? (double) (with_calls - without) / CODEGEN_CALLS : 0.0;
+}
+
+// --- Report ---
+
+// The cost one build's report is compared on: cycles where counted, else time
+static double cost_of(const BenchResult *result) {
+    return result->cycles_per_op > 0 ? result->cycles_per_op : result->ns_per_op;
+}
+
+static void print_ratio(const char *label, const double cost, const double reference) {
+    if (reference > 0) {
+        printf("  %8.2fx %s", cost / reference, label);
+    } else {
+        printf("  %9s %s", "-", label);
+    }
+}
+
+// Builds, checks and measures one corpus program in `dir`
+static bool bench_program(const char *dir, const CorpusProgram *program) {
+    char *source = program->make(program->size);
+    if (!source) {
+        printf("codegen %s: out of memory\n", program->name);
+        return false;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/program.c", dir);
+    bool ok = write_file(path, source, strlen(source));
+
+    BenchResult results[BUILD_COUNT];
+    int expected_status = -1;
+    for (int kind = 0; ok && kind < BUILD_COUNT; ++kind) {
+        char binary[512];
+        snprintf(binary, sizeof(binary), "%s/%s", dir, BUILD_NAMES[kind]);
+        RunCounts with_calls, without_calls;
+        int status, idle_status;
+        ok = build_binary(dir, source, (BuildKind) kind, binary) &&
+             run_cheapest(binary, CODEGEN_CALLS, &with_calls, &status) &&
+             run_cheapest(binary, 0, &without_calls, &idle_status);
+        if (!ok) {
+            printf("codegen %s %s: FAILED\n", program->name, BUILD_NAMES[kind]);
+            break;
+        }
+        if (expected_status < 0) {
+            expected_status = status;
+        } else if (status != expected_status) {
+            printf("codegen %s %s: returned %d, %s returned %d\n", program->name, BUILD_NAMES[kind], status,
+                   BUILD_NAMES[0], expected_status);
+            ok = false;
+            break;
+        }
+        BenchResult *result = &results[kind];
+        *result = (BenchResult){.size = program->size,
+                                .ns_per_op = per_call(with_calls.ns, without_calls.ns),
+                                .cycles_per_op = per_call(with_calls.cycles, without_calls.cycles),
+                                .instructions_per_op = per_call(with_calls.instructions, without_calls.instructions)};
+        snprintf(result->name, sizeof(result->name), "codegen/%s/%s", program->name, BUILD_NAMES[kind]);
+        bench_record(result);
+        remove(binary);
+    }
+
+    for (int kind = 0; ok && kind < BUILD_COUNT; ++kind) {
+        const BenchResult *r = &results[kind];
+        printf("%-32s size=%4lld  %10.1f ns/call", r->name, r->size, r->ns_per_op);
+        if (r->cycles_per_op > 0) {
+            printf("  %10.0f cycles  %10.0f instructions", r->cycles_per_op, r->instructions_per_op);
+        }
+        if (kind == BUILD_CLERIC_O0 || kind == BUILD_CLERIC_O1) {
+            print_ratio("of gcc -O0", cost_of(r), cost_of(&results[BUILD_GCC_O0]));
+            print_ratio("of gcc -O1", cost_of(r), cost_of(&results[BUILD_GCC_O1]));
+        }
+        printf("\n");
+    }
+    remove(path);
+    snprintf(path, sizeof(path), "%s/program.s", dir);
+    remove(path);
+    free(source);
+    return ok;
+}
+
+// bench_codegen [--json=FILE]: measures the generated code of every corpus program; with --json the
+// measurements are also written to FILE. Needs gcc in PATH.
+int main(const int argc, char *argv[]) {
+    const char *json_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--json=", 7) == 0 && argv[i][7] != '\0') {
+            json_path = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Usage: %s [--json=FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    char dir[] = "/tmp/cleric-bench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("Failed to create a scratch directory");
+        return 1;
+    }
+    char harness_c[512], harness_o[512];
+    snprintf(harness_c, sizeof(harness_c), "%s/harness.c", dir);
+    snprintf(harness_o, sizeof(harness_o), "%s/harness.o", dir);
+    char *compile_harness[] = {"gcc", "-O0", "-c", harness_c, "-o", harness_o, NULL};
+    bool ok = write_file(harness_c, HARNESS_SOURCE, strlen(HARNESS_SOURCE)) && run_tool(compile_harness);
+
+    printf("--- Generated Code Benchmarks (cost of one call, %d calls per run) ---\n", CODEGEN_CALLS);
+    for (size_t i = 0; ok && i < sizeof(CORPUS) / sizeof(CORPUS[0]); ++i) {
+        ok = bench_program(dir, &CORPUS[i]);
+    }
+    remove(harness_c);
+    remove(harness_o);
+    rmdir(dir);
+    if (!ok) {
+        return 1;
+    }
+
+    if (json_path) {
+        FILE *out = fopen(json_path, "w");
+        if (!out) {
+            perror("Failed to open the JSON report");
+            return 1;
+        }
+        bench_write_json(out);
+        if (fclose(out) != 0) {
+            perror("Failed to write the JSON report");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "lexer/keywords.h"
+#include "lexer/char_class.h"
+#include "lexer/lexer.h"
+#include "memory/arena.h"
+
+// All C99 keywords, in the order they would plausibly be added to the lexer
+static const char *const C_KEYWORDS[] = {
+    "int", "void", "return", "if", "else", "while", "for", "do", "break", "continue",
+    "char", "long", "short", "unsigned", "signed", "static", "const", "switch", "case", "default",
+    "goto", "sizeof", "struct", "union", "enum", "extern", "typedef", "volatile", "register", "auto",
+    "float", "double", "inline", "restrict", "_Bool", "_Complex", "_Imaginary"
+};
+#define NUM_C_KEYWORDS (sizeof(C_KEYWORDS) / sizeof(C_KEYWORDS[0]))
+
+// Identifiers as they show up in generated code: mostly non-keywords, some keywords
+static const char *const IDENTIFIERS[] = {
+    "main", "counter", "int", "tmp_0", "x", "buffer_length", "return", "i", "value", "result",
+    "void", "node_count", "while", "idx", "for", "next_temp_id", "label_counter", "y", "if", "state"
+};
+#define NUM_IDENTIFIERS (sizeof(IDENTIFIERS) / sizeof(IDENTIFIERS[0]))
+
+#define LOOKUP_ITERATIONS 2000000
+
+// The pre-hash approach: compare against every keyword in turn
+static bool linear_lookup(const size_t num_keywords, const char *str, const size_t len, TokenType *out_type) {
+    for (size_t k = 0; k < num_keywords; ++k) {
+        if (strlen(C_KEYWORDS[k]) == len && strncmp(str, C_KEYWORDS[k], len) == 0) {
+            *out_type = (TokenType) k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cost per identifier for a table of the first `num_keywords` keywords, hashed vs. linear scan
+static void bench_keyword_lookup(const size_t num_keywords) {
+    KeywordTable table;
+    memset(&table, 0, sizeof(table));
+    for (size_t k = 0; k < num_keywords; ++k) {
+        if (!keyword_table_add(&table, C_KEYWORDS[k], (TokenType) k)) {
+            printf("keyword_lookup: collision adding '%s'\n", C_KEYWORDS[k]);
+            return;
+        }
+    }
+
+    size_t lengths[NUM_IDENTIFIERS];
+    for (size_t i = 0; i < NUM_IDENTIFIERS; ++i) {
+        lengths[i] = strlen(IDENTIFIERS[i]);
+    }
+
+    uint64_t hits = 0;
+    TokenType type;
+    uint64_t start = bench_now_ns();
+    for (size_t n = 0; n < LOOKUP_ITERATIONS; ++n) {
+        const size_t i = n % NUM_IDENTIFIERS;
+        hits += keyword_table_lookup(&table, IDENTIFIERS[i], lengths[i], &type);
+    }
+    const uint64_t hash_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (size_t n = 0; n < LOOKUP_ITERATIONS; ++n) {
+        const size_t i = n % NUM_IDENTIFIERS;
+        hits += linear_lookup(num_keywords, IDENTIFIERS[i], lengths[i], &type);
+    }
+    const uint64_t linear_ns = bench_now_ns() - start;
+    bench_sink += hits;
+
+    BenchResult result = {.name = "keywords/hash", .size = (long long) num_keywords,
+                          .ns_per_op = (double) hash_ns / LOOKUP_ITERATIONS};
+    bench_record(&result);
+    snprintf(result.name, sizeof(result.name), "keywords/linear");
+    result.ns_per_op = (double) linear_ns / LOOKUP_ITERATIONS;
+    bench_record(&result);
+    printf("keyword_lookup keywords=%2zu  hash %6.2f ns/ident  linear %6.2f ns/ident\n", num_keywords,
+           (double) hash_ns / LOOKUP_ITERATIONS, (double) linear_ns / LOOKUP_ITERATIONS);
+}
+
+#define SCAN_INPUT_SIZE (4u * 1024 * 1024)
+#define SCAN_REPEATS 8
+
+// Builds input shaped like preprocessed .i files: deep indentation, blank lines, long identifiers
+static char *make_preprocessed_like_input(const size_t size) {
+    static const char *const lines[] = {
+        "                                                                                \n",
+        "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n",
+        "                                extern int __builtin_very_long_identifier_name_for_testing_purposes;\n",
+        "                                int counter_with_a_rather_descriptive_name_0123456789 = 1234567;\n",
+        "                                                return compute_something_expensive_here_in_a_helper;\n",
+    };
+    char *buffer = malloc(size + 1);
+    if (!buffer) {
+        return NULL;
+    }
+    size_t pos = 0;
+    for (size_t line = 0; pos < size; ++line) {
+        const char *text = lines[line % (sizeof(lines) / sizeof(lines[0]))];
+        for (; *text && pos < size; ++text) {
+            buffer[pos++] = *text;
+        }
+    }
+    buffer[size] = '\0';
+    return buffer;
+}
+
+// The pre-table loops: locale-aware ctype calls, one byte at a time
+static size_t ctype_scan_whitespace(const char *src, size_t pos, const size_t len) {
+    while (pos < len && isspace((unsigned char) src[pos])) pos++;
+    return pos;
+}
+
+static size_t ctype_scan_identifier(const char *src, size_t pos, const size_t len) {
+    while (pos < len && (isalnum((unsigned char) src[pos]) || src[pos] == '_')) pos++;
+    return pos;
+}
+
+// Alternates whitespace and identifier scans across the whole buffer; returns elapsed ns
+static uint64_t time_scan(const char *src, const size_t len,
+                          size_t (*scan_ws)(const char *, size_t, size_t),
+                          size_t (*scan_id)(const char *, size_t, size_t)) {
+    uint64_t runs = 0;
+    const uint64_t start = bench_now_ns();
+    for (int r = 0; r < SCAN_REPEATS; ++r) {
+        size_t pos = 0;
+        while (pos < len) {
+            pos = scan_ws(src, pos, len);
+            const size_t next = scan_id(src, pos, len);
+            pos = next == pos ? pos + 1 : next; // Step over symbols
+            runs++;
+        }
+    }
+    const uint64_t elapsed = bench_now_ns() - start;
+    bench_sink += runs;
+    return elapsed;
+}
+
+static double mb_per_s(const size_t bytes, const uint64_t ns) {
+    return ns == 0 ? 0.0 : (double) bytes / (1024.0 * 1024.0) / ((double) ns / 1e9);
+}
+
+static void bench_char_scan(void) {
+    char *src = make_preprocessed_like_input(SCAN_INPUT_SIZE);
+    if (!src) {
+        printf("char_scan: out of memory\n");
+        return;
+    }
+    const size_t total = (size_t) SCAN_INPUT_SIZE * SCAN_REPEATS;
+    const uint64_t table_ns = time_scan(src, SCAN_INPUT_SIZE, char_scan_whitespace, char_scan_identifier);
+    const uint64_t ctype_ns = time_scan(src, SCAN_INPUT_SIZE, ctype_scan_whitespace, ctype_scan_identifier);
+    const BenchResult table_result = {.name = "char_scan/table", .mb_per_s = mb_per_s(total, table_ns)};
+    bench_record(&table_result);
+    const BenchResult ctype_result = {.name = "char_scan/ctype", .mb_per_s = mb_per_s(total, ctype_ns)};
+    bench_record(&ctype_result);
+    printf("char_scan       %8.1f MB/s (table/SIMD)  %8.1f MB/s (ctype)\n",
+           mb_per_s(total, table_ns), mb_per_s(total, ctype_ns));
+
+    // Full tokenization of the same input
+    Arena arena = arena_create(SCAN_INPUT_SIZE * 4);
+    Lexer lexer;
+    lexer_init(&lexer, src, &arena);
+    TokenArray tokens;
+    const uint64_t start = bench_now_ns();
+    const bool ok = lexer_tokenize(&lexer, &tokens);
+    const uint64_t lex_ns = bench_now_ns() - start;
+    const BenchResult result = {.name = "lexer/tokenize", .mb_per_s = mb_per_s(SCAN_INPUT_SIZE, lex_ns),
+                                .nodes_per_s = ok ? (double) tokens.count / ((double) lex_ns / 1e9) : 0.0,
+                                .allocations = arena_stats(&arena).alloc_count,
+                                .peak_arena_bytes = arena_stats(&arena).peak_bytes};
+    bench_record(&result);
+    printf("lexer_tokenize  %8.1f MB/s  (%zu tokens)%s\n", mb_per_s(SCAN_INPUT_SIZE, lex_ns),
+           ok ? tokens.count : 0, ok ? "" : " FAILED");
+    arena_destroy(&arena);
+    free(src);
+}
+
+void run_lexer_benchmarks(void) {
+    bench_char_scan();
+    const size_t sizes[] = {3, 8, 16, 24, NUM_C_KEYWORDS};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        bench_keyword_lookup(sizes[s]);
+    }
+}
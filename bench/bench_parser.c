@@ -0,0 +1,78 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "validator/validator.h"
+#include "ir/ast_to_tac.h"
+#include "memory/arena.h"
+
+// Stress test for the explicit-stack walkers: one return expression nested this deep
+#define NESTING_DEPTH 100000
+
+// `int main(void) { return <prefix * depth> 1 <suffix * depth>; }`, malloc'ed
+static char *make_nested_source(const char *prefix, const char *suffix, const int depth) {
+    const size_t prefix_len = strlen(prefix);
+    const size_t suffix_len = strlen(suffix);
+    char *source = malloc(64 + (prefix_len + suffix_len) * (size_t) depth);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int main(void) { return ");
+    for (int i = 0; i < depth; ++i, end += prefix_len) memcpy(end, prefix, prefix_len);
+    *end++ = '1';
+    for (int i = 0; i < depth; ++i, end += suffix_len) memcpy(end, suffix, suffix_len);
+    strcpy(end, "; }");
+    return source;
+}
+
+// Parse, validate and lower one deeply nested expression, timing each phase per nesting level
+static void bench_nested_expression(const char *name, const char *prefix, const char *suffix) {
+    char *source = make_nested_source(prefix, suffix, NESTING_DEPTH);
+    if (!source) {
+        printf("%s: out of memory\n", name);
+        return;
+    }
+
+    Arena arena = arena_create(64 * 1024 * 1024);
+    Lexer lexer;
+    lexer_init(&lexer, source, &arena);
+    Parser parser;
+    parser_init(&parser, &lexer, &arena);
+
+    uint64_t start = bench_now_ns();
+    ProgramNode *program = parse_program(&parser);
+    const uint64_t parse_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    const bool valid = program && validate_program((AstNode *) program, &arena);
+    const uint64_t validate_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    const TacProgram *tac = valid ? ast_to_tac(program, &arena) : NULL;
+    const uint64_t lower_ns = bench_now_ns() - start;
+
+    const double levels = NESTING_DEPTH;
+    printf("%-12s depth=%d  parse %6.1f ns/level  validate %6.1f ns/level  lower %6.1f ns/level  (%zu nodes)%s\n",
+           name, NESTING_DEPTH, (double) parse_ns / levels, (double) validate_ns / levels, (double) lower_ns / levels,
+           parser.node_count, tac ? "" : " FAILED");
+    bench_sink += tac ? tac->functions[0]->instruction_count : 0;
+    const double seconds = (double) (parse_ns + validate_ns + lower_ns) / 1e9;
+    BenchResult result = {.size = NESTING_DEPTH,
+                          .ns_per_op = (double) (parse_ns + validate_ns + lower_ns) / levels,
+                          .nodes_per_s = seconds > 0 ? (double) parser.node_count / seconds : 0.0,
+                          .allocations = arena_stats(&arena).alloc_count,
+                          .peak_arena_bytes = arena_stats(&arena).peak_bytes};
+    snprintf(result.name, sizeof(result.name), "nested/%s", name);
+    bench_record(&result);
+    arena_destroy(&arena);
+    free(source);
+}
+
+void run_parser_benchmarks(void) {
+    bench_nested_expression("parentheses", "(", ")");
+    bench_nested_expression("negations", "- ", "");
+    bench_nested_expression("right_nested", "2 - (", ")");
+    bench_nested_expression("mixed", "1 * (", " + 3)");
+    bench_nested_expression("logical", "!(0 || ", ")");
+}
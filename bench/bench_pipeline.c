@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "validator/validator.h"
+#include "ir/ast_to_tac.h"
+#include "codegen/codegen.h"
+#include "memory/arena.h"
+
+// Every phase keeps its fastest of this many runs
+#define PIPELINE_REPEATS 5
+
+typedef enum {
+    PIPELINE_LEX,
+    PIPELINE_PARSE,
+    PIPELINE_VALIDATE,
+    PIPELINE_LOWER,
+    PIPELINE_CODEGEN,
+    PIPELINE_PHASE_COUNT
+} PipelinePhase;
+
+static const char *const PHASE_NAMES[PIPELINE_PHASE_COUNT] = {"lex", "parse", "validate", "lower", "codegen"};
+
+// One phase of one run: time, items handled, bytes read or written, arena counters
+typedef struct {
+    uint64_t ns;
+    size_t items;
+    size_t bytes;
+    size_t allocations;
+    size_t peak_arena_bytes;
+} PhaseSample;
+
+static void end_sample(PhaseSample *sample, const uint64_t start, const Arena *arena, const size_t allocs_before) {
+    sample->ns = bench_now_ns() - start;
+    const ArenaStats stats = arena_stats(arena);
+    sample->allocations = stats.alloc_count - allocs_before;
+    sample->peak_arena_bytes = stats.peak_bytes;
+}
+
+// Runs every phase once over a fresh arena; false if a phase failed
+static bool run_pipeline_once(const char *source, PhaseSample samples[PIPELINE_PHASE_COUNT]) {
+    const size_t length = strlen(source);
+    Arena arena = arena_create(length * 16 + 64 * 1024);
+    bool ok = arena.start != NULL;
+
+    // Token by token, as the streaming parser consumes them
+    if (ok) {
+        Lexer lexer;
+        lexer_init_with_length(&lexer, source, length, &arena);
+        size_t allocs = arena_stats(&arena).alloc_count;
+        uint64_t start = bench_now_ns();
+        size_t tokens = 0;
+        Token token;
+        while ((ok = lexer_next_token(&lexer, &token)) && token.type != TOKEN_EOF) {
+            tokens++;
+        }
+        end_sample(&samples[PIPELINE_LEX], start, &arena, allocs);
+        samples[PIPELINE_LEX].items = tokens;
+        samples[PIPELINE_LEX].bytes = length;
+
+        lexer_init_with_length(&lexer, source, length, &arena);
+        Parser parser;
+        allocs = arena_stats(&arena).alloc_count;
+        start = bench_now_ns();
+        parser_init(&parser, &lexer, &arena);
+        ProgramNode *program = ok ? parse_program(&parser) : NULL;
+        end_sample(&samples[PIPELINE_PARSE], start, &arena, allocs);
+        samples[PIPELINE_PARSE].items = parser.node_count;
+        samples[PIPELINE_PARSE].bytes = length;
+        ok = program && !parser.error_flag;
+
+        allocs = arena_stats(&arena).alloc_count;
+        start = bench_now_ns();
+        ok = ok && validate_program((AstNode *) program, &arena);
+        end_sample(&samples[PIPELINE_VALIDATE], start, &arena, allocs);
+        samples[PIPELINE_VALIDATE].items = parser.node_count;
+
+        allocs = arena_stats(&arena).alloc_count;
+        start = bench_now_ns();
+        // Only the fused lowering maps variables to temps, so it runs here even though the program
+        // has just been validated (its checks then find nothing)
+        TacProgram *tac = ok ? ast_to_tac_fused(program, &arena) : NULL;
+        end_sample(&samples[PIPELINE_LOWER], start, &arena, allocs);
+        samples[PIPELINE_LOWER].items = parser.node_count;
+        ok = tac != NULL;
+
+        StringBuffer assembly;
+        string_buffer_init(&assembly, &arena, length * 4);
+        allocs = arena_stats(&arena).alloc_count;
+        start = bench_now_ns();
+        ok = ok && codegen_generate_program(tac, &assembly);
+        end_sample(&samples[PIPELINE_CODEGEN], start, &arena, allocs);
+        samples[PIPELINE_CODEGEN].items = ok ? tac->functions[0]->instruction_count : 0;
+        samples[PIPELINE_CODEGEN].bytes = assembly.length;
+        bench_sink += assembly.length;
+    }
+    if (arena.start) {
+        arena_destroy(&arena);
+    }
+    return ok;
+}
+
+static double per_second(const size_t count, const uint64_t ns) {
+    return ns == 0 ? 0.0 : (double) count / ((double) ns / 1e9);
+}
+
+// Times each phase over one generated program, keeping the fastest run of each
+static void bench_workload(const char *workload, const int size, char *source) {
+    if (!source) {
+        printf("pipeline %s size=%d: out of memory\n", workload, size);
+        return;
+    }
+    PhaseSample best[PIPELINE_PHASE_COUNT];
+    for (int repeat = 0; repeat < PIPELINE_REPEATS; ++repeat) {
+        PhaseSample samples[PIPELINE_PHASE_COUNT] = {{0}};
+        if (!run_pipeline_once(source, samples)) {
+            printf("pipeline %s size=%d: FAILED\n", workload, size);
+            free(source);
+            return;
+        }
+        for (int phase = 0; phase < PIPELINE_PHASE_COUNT; ++phase) {
+            if (repeat == 0 || samples[phase].ns < best[phase].ns) {
+                best[phase] = samples[phase];
+            }
+        }
+    }
+
+    for (int phase = 0; phase < PIPELINE_PHASE_COUNT; ++phase) {
+        const PhaseSample *s = &best[phase];
+        BenchResult result = {.size = size,
+                              .ns_per_op = s->items ? (double) s->ns / (double) s->items : 0.0,
+                              .mb_per_s = per_second(s->bytes, s->ns) / 1e6,
+                              .nodes_per_s = per_second(s->items, s->ns),
+                              .allocations = s->allocations,
+                              .peak_arena_bytes = s->peak_arena_bytes};
+        snprintf(result.name, sizeof(result.name), "pipeline/%s/%s", workload, PHASE_NAMES[phase]);
+        bench_record(&result);
+        printf("%-30s size=%6d  %8.2f MB/s  %11.0f items/s  %7zu allocs  peak %9zu bytes\n", result.name, size,
+               result.mb_per_s, result.nodes_per_s, result.allocations, result.peak_arena_bytes);
+    }
+    free(source);
+}
+
+void run_pipeline_benchmarks(void) {
+    const int sizes[] = {1000, 10000, 100000};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        bench_workload("deep_expr", sizes[i], bench_make_deep_expression(sizes[i]));
+        bench_workload("wide_decls", sizes[i], bench_make_wide_declarations(sizes[i]));
+        bench_workload("and_chain", sizes[i], bench_make_logical_chain(sizes[i], "&&"));
+        bench_workload("or_chain", sizes[i], bench_make_logical_chain(sizes[i], "||"));
+    }
+}
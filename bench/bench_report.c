@@ -0,0 +1,32 @@
+#include <string.h>
+#include "bench.h"
+
+// More than the whole suite records
+#define BENCH_MAX_RESULTS 512
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static size_t result_count;
+
+void bench_record(const BenchResult *result) {
+    if (result_count < BENCH_MAX_RESULTS) {
+        results[result_count++] = *result;
+    }
+}
+
+void bench_write_json(FILE *out) {
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < result_count; ++i) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\"", r->name);
+        if (r->size) fprintf(out, ", \"size\": %lld", r->size);
+        if (r->ns_per_op > 0) fprintf(out, ", \"ns_per_op\": %.3f", r->ns_per_op);
+        if (r->mb_per_s > 0) fprintf(out, ", \"mb_per_s\": %.3f", r->mb_per_s);
+        if (r->nodes_per_s > 0) fprintf(out, ", \"nodes_per_s\": %.0f", r->nodes_per_s);
+        if (r->allocations) fprintf(out, ", \"allocations\": %zu", r->allocations);
+        if (r->peak_arena_bytes) fprintf(out, ", \"peak_arena_bytes\": %zu", r->peak_arena_bytes);
+        if (r->cycles_per_op > 0) fprintf(out, ", \"cycles_per_op\": %.1f", r->cycles_per_op);
+        if (r->instructions_per_op > 0) fprintf(out, ", \"instructions_per_op\": %.1f", r->instructions_per_op);
+        fprintf(out, "}%s\n", i + 1 < result_count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
@@ -0,0 +1,45 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include "bench.h"
+#include "strings/strings.h"
+
+#define LINES_PER_RUN 2000000
+
+// Emits a typical codegen line ("    movl -N(%rbp), %eax\n") through the printf path
+static void emit_formatted(StringBuffer *sb, const int offset) {
+    string_buffer_append(sb, "    movl -%d(%%rbp), %%eax\n", offset);
+}
+
+// Emits the same line with the verbatim appends and the hand-rolled integer formatter
+static void emit_plain(StringBuffer *sb, const int offset) {
+    string_buffer_append_str(sb, "    movl -");
+    string_buffer_append_int(sb, offset);
+    string_buffer_append_str(sb, "(%rbp), %eax\n");
+}
+
+static void bench_emit(const char *label, void (*emit)(StringBuffer *, int)) {
+    Arena arena = arena_create(256 * 1024 * 1024);
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 64 * 1024 * 1024);
+
+    const uint64_t start = bench_now_ns();
+    for (int i = 0; i < LINES_PER_RUN; ++i) {
+        emit(&sb, (i & 1023) * 8 + 8);
+    }
+    const uint64_t elapsed = bench_now_ns() - start;
+    bench_sink += sb.length;
+
+    BenchResult result = {.ns_per_op = (double) elapsed / LINES_PER_RUN,
+                          .mb_per_s = (double) sb.length / ((double) elapsed / 1e9) / 1e6,
+                          .allocations = arena_stats(&arena).alloc_count,
+                          .peak_arena_bytes = arena_stats(&arena).peak_bytes};
+    snprintf(result.name, sizeof(result.name), "string_buffer/%s", label);
+    bench_record(&result);
+    printf("string_buffer %-9s %6.2f ns/line  %7.1f MB/s\n", label, result.ns_per_op, result.mb_per_s);
+    arena_destroy(&arena);
+}
+
+void run_strings_benchmarks(void) {
+    bench_emit("printf", emit_formatted);
+    bench_emit("append", emit_plain);
+}
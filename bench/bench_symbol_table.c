@@ -0,0 +1,60 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include <stdio.h>
+#include "bench.h"
+#include "validator/symbol_table.h"
+#include "strings/interner.h"
+
+#define LOOKUPS_PER_SIZE 1000000
+
+// Declares `num_symbols` interned locals in one scope, then times lookups of declared names
+static void bench_lookup(const int num_symbols) {
+    Arena arena = arena_create(1024 * 1024);
+    StringInterner interner;
+    if (!interner_init(&interner, &arena, (size_t) num_symbols)) {
+        printf("symbol_lookup: out of memory\n");
+        arena_destroy(&arena);
+        return;
+    }
+    const char **names = arena_alloc(&arena, (size_t) num_symbols * sizeof(const char *));
+    SymbolTable st;
+    symbol_table_init_interned(&st, &arena, &interner);
+    symbol_table_enter_scope(&st); // Function body scope
+
+    const Token token = {TOKEN_IDENTIFIER, "v", 1, 0};
+    char name[32];
+    for (int i = 0; i < num_symbols; ++i) {
+        snprintf(name, sizeof(name), "local_var_%d", i);
+        names[i] = interner_intern(&interner, name);
+        if (!names[i] || !symbol_table_add_symbol(&st, names[i], token)) {
+            printf("symbol_lookup: failed to declare %s\n", name);
+            arena_destroy(&arena);
+            return;
+        }
+    }
+
+    uint64_t found = 0;
+    size_t index = 0;
+    const uint64_t start = bench_now_ns();
+    for (int n = 0; n < LOOKUPS_PER_SIZE; ++n) {
+        found += symbol_table_lookup_symbol(&st, names[index]) != NULL;
+        index = (index + 7919) % (size_t) num_symbols; // Stride through the names to defeat caching
+    }
+    const uint64_t elapsed = bench_now_ns() - start;
+    bench_sink += found;
+
+    const SymbolTableStats stats = symbol_table_stats(&st);
+    const BenchResult result = {.name = "symbol_table/lookup", .size = num_symbols,
+                                .ns_per_op = (double) elapsed / LOOKUPS_PER_SIZE};
+    bench_record(&result);
+    printf("symbol_lookup symbols=%6d  %6.2f ns/lookup  avg probes %.2f  max probes %zu\n", num_symbols,
+           (double) elapsed / LOOKUPS_PER_SIZE, (double) stats.total_probes / (double) stats.symbol_count,
+           stats.max_probes);
+    arena_destroy(&arena);
+}
+
+void run_symbol_table_benchmarks(void) {
+    const int sizes[] = {10, 100, 1000, 10000, 100000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        bench_lookup(sizes[s]);
+    }
+}
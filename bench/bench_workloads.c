@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+char *bench_make_deep_expression(const int depth) {
+    // `return (1 + (1 + ... 1 ...));`
+    char *source = malloc(64 + (size_t) depth * 6);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int main(void) { return ");
+    for (int i = 0; i < depth; ++i, end += 5) memcpy(end, "(1 + ", 5);
+    *end++ = '1';
+    memset(end, ')', (size_t) depth);
+    strcpy(end + depth, "; }");
+    return source;
+}
+
+char *bench_make_wide_declarations(const int count) {
+    // `int v0 = 1; int v1 = v0 + 1; ... return vN;`, every name looked up once more than declared
+    char *source = malloc(64 + (size_t) count * 48);
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int main(void) {\n    int v0 = 1;\n");
+    for (int i = 1; i < count; ++i) {
+        end += sprintf(end, "    int v%d = v%d + %d;\n", i, i - 1, i & 7);
+    }
+    sprintf(end, "    return v%d;\n}\n", count > 0 ? count - 1 : 0);
+    return source;
+}
+
+char *bench_make_logical_chain(const int length, const char *op) {
+    // `int a = 1; return a op a op ... a;`, lowered to one short-circuit jump per operand
+    const size_t op_len = strlen(op);
+    char *source = malloc(64 + (size_t) length * (op_len + 3));
+    if (!source) return NULL;
+    char *end = source + sprintf(source, "int main(void) { int a = 1; return a");
+    for (int i = 1; i < length; ++i) {
+        *end++ = ' ';
+        memcpy(end, op, op_len);
+        end += op_len;
+        memcpy(end, " a", 2);
+        end += 2;
+    }
+    strcpy(end, "; }");
+    return source;
+}
@@ -1,69 +1,317 @@
 #include "args.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
 
 // Parses CLI arguments. Sets flags and returns input_file or NULL on error.
 void print_usage(const char *prog_name) {
-    fprintf(stderr, "Usage: %s [<options>] <input_file.c>\n", prog_name);
+    fprintf(stderr, "Usage: %s [<options>] <input_file.c>...\n", prog_name);
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  --lex          Lex the input, print tokens to stdout, and exit.\n");
     fprintf(stderr, "  --parse        Lex and parse the input, print the AST to stdout, and exit.\n");
     fprintf(stderr, "  --validate     Lex, parse, and validate the input, then exit.\n");
     fprintf(stderr, "  --tac          Lex, parse, validate, and generate Three-Address Code; print TAC to stdout, and exit.\n");
     fprintf(stderr, "  --codegen      Lex, parse, validate, generate TAC, and then assembly; print assembly to stdout, and exit.\n");
+    fprintf(stderr, "  --time-report[=text|json]\n");
+    fprintf(stderr, "                 Print wall time, arena usage and allocation counts per phase to stderr.\n");
+    fprintf(stderr, "  --trace=FILE   Write begin/end events of phases, passes, functions and child processes\n");
+    fprintf(stderr, "                 to FILE in the Chrome Trace Event format (chrome://tracing, Perfetto).\n");
+    fprintf(stderr, "  -O0            Generate straightforward code, one stack slot per temporary (default).\n");
+    fprintf(stderr, "  -O1            Allocate temporaries to registers.\n");
+    fprintf(stderr, "  --no-peephole  Skip the peephole pass over the generated instructions (with -O1).\n");
+    fprintf(stderr, "  --no-omit-frame-pointer\n");
+    fprintf(stderr, "                 Keep the %%rbp frame in functions that use no stack (with -O1), for profilers.\n");
+    fprintf(stderr, "  --lex-thread   Lex on a separate thread, overlapping with parsing (for large sources).\n");
+    fprintf(stderr, "  --flat-ast     Validate and lower a flat, index-based copy of the AST.\n");
+    fprintf(stderr, "  --fuse-validation\n");
+    fprintf(stderr, "                 Validate the AST while generating TAC, in a single walk.\n");
+    fprintf(stderr, "  --pipe         Preprocess and assemble through pipes, without .i or .s files on disk.\n");
+    fprintf(stderr, "  --stream       Implies --pipe: read the preprocessed input as it comes and compile it one top-level\n");
+    fprintf(stderr, "                 function at a time, in memory bounded by the largest function. The input\n");
+    fprintf(stderr, "                 file may be - for stdin (the executable is then a.out).\n");
+    fprintf(stderr, "  --emit-obj     Encode machine code into an ELF object and link it, without running the assembler.\n");
+    fprintf(stderr, "  --emit-tac     Write the program as TAC to <input>.ctac; giving .ctac files as the inputs\n");
+    fprintf(stderr, "                 then links them into one program and generates its code once.\n");
+    fprintf(stderr, "  --run          Compile into memory and run main, exiting with its result; nothing is written.\n");
+    fprintf(stderr, "  --interpret    Generate TAC and run main in the TAC interpreter, exiting with its result.\n");
+    fprintf(stderr, "  -j N           Compile up to N input files at once (each through pipes, as with --pipe).\n");
+    fprintf(stderr, "  --function-jobs=N\n");
+    fprintf(stderr, "                 Optimize and generate code for up to N functions of a file at once.\n");
+    fprintf(stderr, "  --quiet        Print no progress messages, only errors and the requested listings.\n");
+    fprintf(stderr, "  --server=PATH  Serve compile requests on the Unix socket PATH until stopped; takes no input file.\n");
+    fprintf(stderr, "  --connect=PATH Have the compile server on PATH compile the input files, then link them here.\n");
+    fprintf(stderr, "  --cache-dir=DIR\n");
+    fprintf(stderr, "                 Reuse the output cached in DIR for an unchanged preprocessed source.\n");
+    fprintf(stderr, "  --cache-max-mb=N\n");
+    fprintf(stderr, "                 Keep the cache directory under N megabytes (default 256).\n");
+    fprintf(stderr, "  --arena-reserve-mb=N\n");
+    fprintf(stderr, "                 Reserve N megabytes of address space for the compilation arena and commit it as it fills.\n");
+    fprintf(stderr, "  --huge-pages   With --arena-reserve-mb, ask for transparent huge pages for the arena.\n");
     fprintf(stderr, "  (No options)   Run the full pipeline to create an executable.\n");
 }
 
-const char *parse_args(const int argc, char *argv[], bool *lex_only, bool *parse_only, bool *validate_only, bool *tac_only, bool *codegen_only) {
-    *lex_only = false;
-    *parse_only = false;
-    *validate_only = false;
-    *tac_only = false;
-    *codegen_only = false;
-
-    // Case 1: Standard usage (cleric <file>)
-    if (argc == 2) {
-        // Ensure the single argument isn't accidentally an option
-        if (strcmp(argv[1], "--lex") != 0 && 
-            strcmp(argv[1], "--parse") != 0 && 
-            strcmp(argv[1], "--validate") != 0 && 
-            strcmp(argv[1], "--tac") != 0 && 
-            strcmp(argv[1], "--tacky") != 0 && 
-            strcmp(argv[1], "--codegen") != 0) {
-            return argv[1]; // Valid filename
-        }
-        // If argv[1] is an option, fall through to error
-    }
-    // Case 2: Mode-specific usage (cleric --option <file>)
-    else if (argc == 3) {
-        if (strcmp(argv[1], "--lex") == 0) {
-            *lex_only = true;
-            fprintf(stdout, "Lex-only mode enabled\n");
-            return argv[2];
-        }
-        if (strcmp(argv[1], "--parse") == 0) {
-            *parse_only = true;
-            fprintf(stdout, "Parse-only mode enabled\n");
-            return argv[2];
+// Applies a stage option (--lex, ...). Returns false if argument is not one.
+static bool parse_stage_option(const char *arg, CompileOptions *options, int *stage_count) {
+    if (strcmp(arg, "--lex") == 0) {
+        options->lex_only = true;
+    } else if (strcmp(arg, "--parse") == 0) {
+        options->parse_only = true;
+    } else if (strcmp(arg, "--validate") == 0) {
+        options->validate_only = true;
+    } else if (strcmp(arg, "--tac") == 0 || strcmp(arg, "--tacky") == 0) {
+        options->tac_only = true;
+    } else if (strcmp(arg, "--codegen") == 0) {
+        options->codegen_only = true;
+    } else {
+        return false;
+    }
+    (*stage_count)++;
+    return true;
+}
+
+// Announces the stage mode once every argument is known, so a later --quiet silences it too
+static void print_stage_banner(const CompileOptions *options) {
+    if (options->quiet) {
+        return;
+    }
+    if (options->lex_only) {
+        fprintf(stdout, "Lex-only mode enabled\n");
+    } else if (options->parse_only) {
+        fprintf(stdout, "Parse-only mode enabled\n");
+    } else if (options->validate_only) {
+        fprintf(stdout, "Validate-only mode enabled\n");
+    } else if (options->tac_only) {
+        fprintf(stdout, "TAC-only mode enabled (Three-Address Code)\n");
+    } else if (options->codegen_only) {
+        fprintf(stdout, "Codegen-only mode enabled (Assembly)\n");
+    }
+}
+
+// Applies --time-report[=text|json] / --trace=FILE. Returns false if argument is not a valid report option.
+static bool parse_report_option(const char *arg, CompileOptions *options) {
+    if (strncmp(arg, "--trace=", 8) == 0 && arg[8] != '\0') {
+        options->trace_path = arg + 8;
+        return true;
+    }
+    if (strcmp(arg, "--time-report") == 0 || strcmp(arg, "--time-report=text") == 0) {
+        options->time_report = TIME_REPORT_TEXT;
+        return true;
+    }
+    if (strcmp(arg, "--time-report=json") == 0) {
+        options->time_report = TIME_REPORT_JSON;
+        return true;
+    }
+    return false;
+}
+
+// Applies -O0 / -O1. Returns false if argument is not a supported optimization level.
+static bool parse_optimization_option(const char *arg, CompileOptions *options) {
+    if (strcmp(arg, "-O0") == 0) {
+        options->optimization_level = 0;
+        return true;
+    }
+    if (strcmp(arg, "-O1") == 0) {
+        options->optimization_level = 1;
+        return true;
+    }
+    return false;
+}
+
+// Applies a code generation or driver switch (--no-peephole, --no-omit-frame-pointer, --flat-ast,
+// --lex-thread, --fuse-validation, --pipe, --stream, --emit-obj, --emit-tac, --run, --interpret, --quiet).
+// Returns false if argument is not one.
+static bool parse_codegen_option(const char *arg, CompileOptions *options) {
+    if (strcmp(arg, "--no-peephole") == 0) {
+        options->no_peephole = true;
+        return true;
+    }
+    if (strcmp(arg, "--no-omit-frame-pointer") == 0) {
+        options->no_omit_frame_pointer = true;
+        return true;
+    }
+    if (strcmp(arg, "--lex-thread") == 0) {
+        options->lex_thread = true;
+        return true;
+    }
+    if (strcmp(arg, "--flat-ast") == 0) {
+        options->flat_ast = true;
+        return true;
+    }
+    if (strcmp(arg, "--fuse-validation") == 0) {
+        options->fuse_validation = true;
+        return true;
+    }
+    if (strcmp(arg, "--pipe") == 0) {
+        options->pipe = true;
+        return true;
+    }
+    if (strcmp(arg, "--stream") == 0) {
+        options->stream = true;
+        options->pipe = true; // Streaming is a mode of the pipe driver
+        return true;
+    }
+    if (strcmp(arg, "--emit-obj") == 0) {
+        options->emit_obj = true;
+        return true;
+    }
+    if (strcmp(arg, "--emit-tac") == 0) {
+        options->emit_tac = true;
+        return true;
+    }
+    if (strcmp(arg, "--run") == 0) {
+        options->run = true;
+        return true;
+    }
+    if (strcmp(arg, "--interpret") == 0) {
+        options->interpret = true;
+        return true;
+    }
+    if (strcmp(arg, "--quiet") == 0) {
+        options->quiet = true;
+        return true;
+    }
+    return false;
+}
+
+// Applies --server=PATH / --connect=PATH. Returns false if argument is not one or the path is empty.
+static bool parse_server_option(const char *arg, CompileOptions *options) {
+    if (strncmp(arg, "--server=", 9) == 0 && arg[9] != '\0') {
+        options->server_socket = arg + 9;
+        return true;
+    }
+    if (strncmp(arg, "--connect=", 10) == 0 && arg[10] != '\0') {
+        options->connect_socket = arg + 10;
+        return true;
+    }
+    return false;
+}
+
+// Applies --cache-dir=DIR / --cache-max-mb=N. Returns false if argument is not one or its value is invalid.
+static bool parse_cache_option(const char *arg, CompileOptions *options) {
+    if (strncmp(arg, "--cache-dir=", 12) == 0 && arg[12] != '\0') {
+        options->cache_dir = arg + 12;
+        return true;
+    }
+    if (strncmp(arg, "--cache-max-mb=", 15) == 0) {
+        char *end;
+        const long megabytes = strtol(arg + 15, &end, 10);
+        if (*end != '\0' || end == arg + 15 || megabytes < 1 || (unsigned long) megabytes > SIZE_MAX / (1024 * 1024)) {
+            return false;
         }
-        if (strcmp(argv[1], "--validate") == 0) {
-            *validate_only = true;
-            fprintf(stdout, "Validate-only mode enabled\n");
-            return argv[2];
+        options->cache_max_bytes = (size_t) megabytes * 1024 * 1024;
+        return true;
+    }
+    return false;
+}
+
+// Applies --arena-reserve-mb=N / --huge-pages. Returns false if argument is not one or N is invalid.
+static bool parse_arena_option(const char *arg, CompileOptions *options) {
+    if (strncmp(arg, "--arena-reserve-mb=", 19) == 0) {
+        char *end;
+        const long megabytes = strtol(arg + 19, &end, 10);
+        if (*end != '\0' || end == arg + 19 || megabytes < 1 || (unsigned long) megabytes > SIZE_MAX / (1024 * 1024)) {
+            return false;
         }
-        if (strcmp(argv[1], "--tac") == 0 || strcmp(argv[1], "--tacky") == 0) {
-            *tac_only = true;
-            fprintf(stdout, "TAC-only mode enabled (Three-Address Code)\n");
-            return argv[2];
+        options->arena_reserve_bytes = (size_t) megabytes * 1024 * 1024;
+        return true;
+    }
+    if (strcmp(arg, "--huge-pages") == 0) {
+        options->huge_pages = true;
+        return true;
+    }
+    return false;
+}
+
+// Reads a job count in 1..COMPILE_OPTIONS_MAX_JOBS. Returns false if it is not one.
+static bool parse_job_count(const char *count, int *out_jobs) {
+    char *end;
+    const long jobs = strtol(count, &end, 10);
+    if (*end != '\0' || end == count || jobs < 1 || jobs > COMPILE_OPTIONS_MAX_JOBS) {
+        return false;
+    }
+    *out_jobs = (int) jobs;
+    return true;
+}
+
+// Applies -j N or -jN, taking the count from the next argument when it is separate.
+// Returns false if the count is missing or not in 1..COMPILE_OPTIONS_MAX_JOBS.
+static bool parse_jobs_option(const int argc, char *argv[], int *i, CompileOptions *options) {
+    const char *count = argv[*i] + 2;
+    if (*count == '\0') {
+        if (*i + 1 >= argc) {
+            return false;
         }
-        if (strcmp(argv[1], "--codegen") == 0) {
-            *codegen_only = true;
-            fprintf(stdout, "Codegen-only mode enabled (Assembly)\n");
-            return argv[2];
+        count = argv[++*i];
+    }
+    return parse_job_count(count, &options->jobs);
+}
+
+// Applies --function-jobs=N. Returns false if argument is not one or N is not a valid count.
+static bool parse_function_jobs_option(const char *arg, CompileOptions *options) {
+    return strncmp(arg, "--function-jobs=", 16) == 0 && parse_job_count(arg + 16, &options->function_jobs);
+}
+
+// Shared by both entry points: collects the input files into `inputs` (room for argc entries)
+// and returns how many there are, or 0 after printing usage
+static size_t parse_arguments(const int argc, char *argv[], CompileOptions *options, const char **inputs,
+                              const size_t max_inputs) {
+    compile_options_init(options);
+
+    size_t input_count = 0;
+    int stage_count = 0;
+    bool valid = argc >= 2;
+    for (int i = 1; valid && i < argc; ++i) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--", 2) == 0) {
+            valid = parse_stage_option(arg, options, &stage_count) || parse_report_option(arg, options) ||
+                    parse_codegen_option(arg, options) || parse_server_option(arg, options) ||
+                    parse_cache_option(arg, options) || parse_arena_option(arg, options) ||
+                    parse_function_jobs_option(arg, options);
+        } else if (strncmp(arg, "-O", 2) == 0) {
+            valid = parse_optimization_option(arg, options);
+        } else if (strncmp(arg, "-j", 2) == 0) {
+            valid = parse_jobs_option(argc, argv, &i, options);
+        } else if (input_count < max_inputs) {
+            inputs[input_count++] = arg;
+        } else {
+            valid = false; // More input files than the caller takes
         }
     }
 
-    // If none of the valid cases matched, print usage and return NULL
-    print_usage(argv[0]);
-    return NULL;
+    // At least one input file and at most one stage option; a server takes no input file and serves
+    // no other role
+    const bool serving = options->server_socket != NULL;
+    if (serving) {
+        valid = valid && input_count == 0 && !options->connect_socket && stage_count == 0;
+    } else if (input_count == 0) {
+        valid = false;
+    }
+    if (!valid || stage_count > 1) {
+        compile_options_init(options);
+        print_usage(argv[0]);
+        return 0;
+    }
+    print_stage_banner(options);
+    return input_count;
+}
+
+const char *parse_args_with_options(const int argc, char *argv[], CompileOptions *options) {
+    const char *input_file = NULL;
+    return parse_arguments(argc, argv, options, &input_file, 1) == 1 ? input_file : NULL;
+}
+
+size_t parse_args_with_inputs(const int argc, char *argv[], CompileOptions *options, const char **inputs) {
+    return parse_arguments(argc, argv, options, inputs, argc > 1 ? (size_t) argc - 1 : 0);
+}
+
+const char *parse_args(const int argc, char *argv[], bool *lex_only, bool *parse_only, bool *validate_only, bool *tac_only, bool *codegen_only) {
+    CompileOptions options;
+    const char *input_file = parse_args_with_options(argc, argv, &options);
+    *lex_only = options.lex_only;
+    *parse_only = options.parse_only;
+    *validate_only = options.validate_only;
+    *tac_only = options.tac_only;
+    *codegen_only = options.codegen_only;
+    return input_file;
 }
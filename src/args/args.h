@@ -2,6 +2,8 @@
 #define ARGS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "../compiler/options.h"
 
 /**
  * @brief Parses command-line arguments.
@@ -21,4 +23,27 @@ const char *parse_args(int argc, char *argv[],
                          bool *tac_only,
                          bool *codegen_only);
 
+/**
+ * @brief Parses command-line arguments into a CompileOptions struct.
+ *        Accepts at most one stage option (--lex, --parse, --validate, --tac/--tacky, --codegen),
+ *        any number of reporting options (--time-report[=text|json]) and exactly one input file,
+ *        in any order.
+ * @param argc The argument count.
+ * @param argv The argument vector.
+ * @param options Receives the parsed options; reset to defaults when parsing fails.
+ * @return The input filename if arguments are valid, otherwise NULL (after printing usage).
+ */
+const char *parse_args_with_options(int argc, char *argv[], CompileOptions *options);
+
+/**
+ * @brief Same as parse_args_with_options(), accepting any number of input files (e.g. with -j N).
+ * @param argc The argument count.
+ * @param argv The argument vector.
+ * @param options Receives the parsed options; reset to defaults when parsing fails.
+ * @param inputs Receives the input filenames in command-line order; needs room for argc - 1 entries.
+ * @return The number of input files, or 0 if arguments are invalid (after printing usage) or name a
+ *         server to run (--server=PATH takes no input file; options->server_socket is then set).
+ */
+size_t parse_args_with_inputs(int argc, char *argv[], CompileOptions *options, const char **inputs);
+
 #endif // ARGS_H
@@ -17,11 +17,34 @@
  *                       no --lex, --parse, --tac, or --codegen options are used).
  *
  * Usage:
- *   cleric [<options>] <input_file.c>
+ *   cleric [<options>] <input_file.c>...
  *     --lex      : Lex the input, print tokens to stdout, and exit.
  *     --parse    : Lex and parse the input, print the AST to stdout, and exit.
  *     --tac      : Lex, parse, and generate Three-Address Code; print TAC to stdout, and exit.
  *     --codegen  : Lex, parse, generate TAC, and then assembly; print assembly to stdout, and exit.
+ *     --time-report[=text|json] : Print per-phase wall time and arena usage to stderr.
+ *     --trace=FILE : Write phase, pass, function and child process events to FILE (Chrome trace format).
+ *     -O0 / -O1  : Keep every temporary on the stack (default), or allocate registers.
+ *     --no-peephole : With -O1, skip the peephole pass over the generated instructions.
+ *     --no-omit-frame-pointer : With -O1, keep the %rbp frame even in functions that use no stack.
+ *     --lex-thread : Lex on a separate thread, feeding the parser through a token ring.
+ *     --flat-ast : Validate and lower a flat, index-based copy of the AST.
+ *     --fuse-validation : Validate the AST while generating TAC, in a single walk.
+ *     --pipe     : Preprocess and assemble through pipes, without .i or .s files on disk.
+ *     --stream   : As --pipe, compiling one top-level function at a time as the input arrives ('-' is stdin).
+ *     --emit-obj : Encode machine code into <input>.o (ELF) and link that; no assembler runs.
+ *     --emit-tac : Write the TAC program into <input>.ctac; .ctac inputs are linked and compiled as one program.
+ *     --run      : Compile into memory, run main in-process, and exit with its result.
+ *     --interpret : Generate TAC and run main in the TAC interpreter; no machine code is generated.
+ *     -j N       : With several input files, build up to N of them at once (through pipes, as --pipe).
+ *     --function-jobs=N : Optimize and generate code for up to N functions of a file at once.
+ *     --quiet    : Print no progress messages.
+ *     --server=PATH  : Serve compile requests on a Unix socket, keeping the arena warm between them.
+ *     --connect=PATH : Have the server on PATH compile the inputs; preprocess and link here.
+ *     --cache-dir=DIR : Reuse the output stored in DIR for an unchanged preprocessed source.
+ *     --cache-max-mb=N : Evict least recently used cache entries beyond N megabytes (default 256).
+ *     --arena-reserve-mb=N : Reserve N megabytes of address space for the arena, committed as it fills.
+ *     --huge-pages : With --arena-reserve-mb, back the arena with transparent huge pages.
  *     (No options): Run the full pipeline to create an executable.
  *
  * This main file delegates file manipulation to src/files/files.c, argument parsing to src/args/args.c,
@@ -30,38 +53,102 @@
  * Test suites are provided in tests/ for each module.
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include "compiler/driver.h"
 #include "files/files.h"
 #include "args/args.h"
+#include "compiler/trace.h"
 
 
+// Runs whatever the options ask for on the inputs; returns the exit status
+static int build(const char **inputs, const size_t input_count, const CompileOptions *options);
+
 int main(int argc, char *argv[]) {
-    bool lex_only = false;
-    bool parse_only = false;
-    bool validate_only = false;
-    bool tac_only = false;
-    bool codegen_only = false;
-    const char *input_file = parse_args(argc, argv, &lex_only, &parse_only, &validate_only, &tac_only, &codegen_only);
+    CompileOptions options;
+    const char **inputs = malloc((size_t) argc * sizeof(*inputs));
+    if (!inputs) return 1;
+    const size_t input_count = parse_args_with_inputs(argc, argv, &options, inputs);
+    if (options.trace_path && !trace_start(options.trace_path)) {
+        free(inputs);
+        return 1;
+    }
+    int result = build(inputs, input_count, &options);
+    free(inputs); // The inputs point into argv
+    if (!trace_stop()) {
+        result = 1;
+    }
+    return result;
+}
+
+// Whether the inputs are all TAC modules written by --emit-tac
+static bool all_tac_modules(const char **inputs, const size_t input_count) {
+    for (size_t i = 0; i < input_count; ++i) {
+        if (!filename_has_ext(inputs[i], ".ctac")) {
+            return false;
+        }
+    }
+    return input_count > 0;
+}
+
+static int build(const char **inputs, const size_t input_count, const CompileOptions *options) {
+    const char *input_file = input_count > 0 ? inputs[0] : NULL;
+    if (input_count == 0 && options->server_socket) {
+        return run_server(options);
+    }
+    if (options->emit_tac) {
+        if (options->run || options->interpret || options->connect_socket || options->stream || options->emit_obj) {
+            fprintf(stderr, "Error: --emit-tac only writes TAC modules; it takes none of --run, --interpret, "
+                            "--connect, --stream or --emit-obj.\n");
+            return 1;
+        }
+        // Each file becomes a module on its own; nothing is assembled or linked
+        for (size_t i = 0; i < input_count; ++i) {
+            if (run_tac_emitter(inputs[i], options) != 0) return 1;
+        }
+        return input_count > 0 ? 0 : 1;
+    }
+    if (all_tac_modules(inputs, input_count)) return run_tac_linker(inputs, input_count, options);
+    if (input_count > 1) {
+        // Several files are built side by side, each through pipes (see run_parallel)
+        if (options->run || options->interpret) {
+            fprintf(stderr, "Error: --run and --interpret take a single input file.\n");
+            return 1;
+        }
+        return run_parallel(inputs, input_count, options);
+    }
     if (!input_file) return 1;
-    if (run_preprocessor(input_file) != 0) return 1;
+    if (options->stream && (options->run || options->interpret || options->connect_socket)) {
+        fprintf(stderr, "Error: --stream builds an executable; it takes none of --run, --interpret or --connect.\n");
+        return 1;
+    }
+    // Running in memory needs no file but the source, whatever --pipe or --emit-obj asked for
+    if (options->run && !compile_options_stops_early(options)) return run_jit(input_file, options);
+    if (options->interpret && !compile_options_stops_early(options)) return run_interpreter(input_file, options);
+    // The server compiles; only preprocessing and linking happen in this process
+    if (options->connect_socket) return run_client(input_file, options);
+    // Pipeline mode runs every step itself, with nothing written to disk but the executable
+    if (options->pipe) return run_pipeline(input_file, options);
+    if (run_preprocessor_with_options(input_file, options) != 0) return 1;
     char i_file[1024];
     if (!filename_replace_ext(input_file, ".i", i_file, sizeof(i_file))) {
         fprintf(stderr, "Failed to construct .i filename\n");
         return 1;
     }
-    // Pass all flags to the compiler driver
-    if (run_compiler(i_file, lex_only, parse_only, validate_only, tac_only, codegen_only) != 0) return 1;
+    // Pass all options to the compiler driver
+    if (run_compiler_with_options(i_file, options) != 0) return 1;
 
     // Skip assembly/linking if any "only" mode is active
-    if (!lex_only && !parse_only && !validate_only && !tac_only && !codegen_only) {
-        char s_file[1024];
-        if (!filename_replace_ext(input_file, ".s", s_file, sizeof(s_file))) {
-            fprintf(stderr, "Failed to construct .s filename\n");
+    if (!compile_options_stops_early(options)) {
+        // With --emit-obj the compiler already wrote the object: only the link is left
+        const char *ext = options->emit_obj ? ".o" : ".s";
+        char output_file[1024];
+        if (!filename_replace_ext(input_file, ext, output_file, sizeof(output_file))) {
+            fprintf(stderr, "Failed to construct %s filename\n", ext);
             return 1;
         }
-        return run_assembler_linker(s_file);
+        return run_assembler_linker_with_options(output_file, options);
     }
     return 0;
 }
@@ -1,6 +1,16 @@
 #include "codegen.h"
 #include "../ir/tac.h" // Include TAC definitions for TacInstructionNode, TacFunction, etc.
 #include "../src/strings/strings.h" // Use the new string buffer
+#include "machine.h"
+#include "regalloc.h"
+#include "strength_reduction.h"
+#include "value_cache.h"
+#include "object_writer.h"
+#include "x86_encoder.h"
+#include "../ir/liveness.h"
+#include "../compiler/trace.h"
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdbool.h> // Needed for bool
 #include <string.h>
@@ -15,46 +25,38 @@ int calculate_max_temp_id(const TacFunction *func) {
     // Correct loop:
     for (size_t i = 0; i < func->instruction_count; ++i) {
         const TacInstruction *instr = &func->instructions[i];
-        // Array to hold operands of the current instruction that might be temporaries
-        const TacOperand *operands_to_inspect[3]; // Max 3 for binary ops (dst, src1, src2)
-        int num_ops_to_inspect = 0;
+        // Slots of the current instruction that might hold temporaries
+        int first_slot = TAC_SLOT_DST;
+        int num_slots_to_inspect = 0;
 
         switch (instr->type) {
-            case TAC_INS_COPY:
-                operands_to_inspect[0] = &instr->operands.copy.dst;
-                operands_to_inspect[1] = &instr->operands.copy.src;
-                num_ops_to_inspect = 2;
-                break;
             case TAC_INS_RETURN:
-                operands_to_inspect[0] = &instr->operands.ret.src;
-                num_ops_to_inspect = 1;
+                first_slot = TAC_SLOT_SRC1; // src
+                num_slots_to_inspect = 2;
                 break;
+            case TAC_INS_COPY:
             case TAC_INS_NEGATE:
             case TAC_INS_COMPLEMENT:
             case TAC_INS_LOGICAL_NOT:
-                operands_to_inspect[0] = &instr->operands.unary_op.dst;
-                operands_to_inspect[1] = &instr->operands.unary_op.src;
-                num_ops_to_inspect = 2;
+                num_slots_to_inspect = 2; // dst, src
                 break;
             case TAC_INS_ADD:
             case TAC_INS_SUB:
             case TAC_INS_MUL:
             case TAC_INS_DIV:
             case TAC_INS_MOD:
-                operands_to_inspect[0] = &instr->operands.binary_op.dst;
-                operands_to_inspect[1] = &instr->operands.binary_op.src1;
-                operands_to_inspect[2] = &instr->operands.binary_op.src2;
-                num_ops_to_inspect = 3;
+                num_slots_to_inspect = 3; // dst, src1, src2
                 break;
             default:
                 // Instructions like LABEL, JUMP, CALL might need different handling or no temp inspection here.
                 break;
         }
 
-        for (int j = 0; j < num_ops_to_inspect; ++j) {
-            if (operands_to_inspect[j] && operands_to_inspect[j]->type == TAC_OPERAND_TEMP) {
-                if (operands_to_inspect[j]->value.temp_id > max_id) {
-                    max_id = operands_to_inspect[j]->value.temp_id;
+        for (int slot = first_slot; slot < num_slots_to_inspect; ++slot) {
+            if (tac_slot_is_temp(instr, (TacOperandSlot) slot)) {
+                const int id = tac_get_operand(instr, (TacOperandSlot) slot).value.temp_id;
+                if (id > max_id) {
+                    max_id = id;
                 }
             }
         }
@@ -62,77 +64,616 @@ int calculate_max_temp_id(const TacFunction *func) {
     return max_id;
 }
 
+// --- Machine operand helpers ---
+
+// Shorthands for the fixed registers the TAC lowering uses
+#define EAX machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_LONG)
+#define ECX machine_reg(MACHINE_REG_CX, MACHINE_WIDTH_LONG)
+#define EDX machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_LONG)
+#define R10D machine_reg(MACHINE_REG_R10, MACHINE_WIDTH_LONG)
+#define AL machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE)
+#define DL machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_BYTE)
+#define RBP machine_reg(MACHINE_REG_BP, MACHINE_WIDTH_QUAD)
+#define RSP machine_reg(MACHINE_REG_SP, MACHINE_WIDTH_QUAD)
+#define NONE machine_none()
+
+// Stack offset of frame slot n: 8 bytes per slot, 0 -> -8(%rbp), 1 -> -16(%rbp), etc.
+// Without register allocation, temp tN uses slot N.
+static int temp_stack_offset(const int slot) {
+    return -(slot + 1) * 8;
+}
+
+/**
+ * @brief Maps a TAC operand to a machine operand (constant -> immediate, temp -> virtual temp, label -> label).
+ *        Temps are given their register or stack slot once the whole function has been emitted.
+ * @return false for an unhandled operand type (an error has been printed).
+ */
+static bool machine_operand_from_tac(const TacOperand op, MachineOperand *out, const char *current_func_name) {
+    switch (op.type) {
+        case TAC_OPERAND_CONST:
+            *out = machine_imm(op.value.constant_value);
+            return true;
+        case TAC_OPERAND_TEMP:
+            *out = machine_temp(op.value.temp_id);
+            return true;
+        case TAC_OPERAND_LABEL:
+            *out = machine_local_label(op.value.label_id);
+            return true;
+    }
+    fprintf(stderr, "Codegen Error: Unhandled operand type %d in function %s.\n", op.type, current_func_name);
+    return false;
+}
+
+// Where the temps of the function being generated live
+typedef struct {
+    const RegisterAllocation *allocation; // NULL: every temp gets the stack slot matching its id
+} TempAssignment;
+
+// How the function being generated leaves: the one epilogue after the body, which a RETURN in the
+// middle of the body either jumps to or, when it is as short as the jump, repeats
+typedef struct {
+    int spill_slots;                // Callee-saved registers are saved right below these
+    bool needs_frame;
+    size_t stack_allocation_size;
+    bool repeat_epilogue;           // Nothing to restore but the frame: `leave; retq` is no longer than a jmp
+    uint32_t label;                 // Local label of the shared epilogue, past every TAC label of the function
+    bool label_used;                // Some RETURN jumps to it
+} FunctionExit;
+
+// Per-program state, reused across functions
+typedef struct {
+    const CodegenOptions *options;
+    MachineFunction body;   // Function body with virtual temps, before lowering
+    Arena scratch;          // Liveness and allocation data, released after every function
+} CodegenContext;
+
 // --- Forward declarations for static helper functions (TAC processors) ---
-static bool generate_tac_function(const TacFunction *func, StringBuffer *sb);
+static bool generate_tac_function(const TacFunction *func, MachineFunction *mf, CodegenContext *ctx);
+static bool generate_traced_function(const TacFunction *func, MachineFunction *mf, CodegenContext *ctx);
 
 static bool generate_tac_instruction(const TacInstruction *instr, const TacFunction *current_function,
-                                     StringBuffer *sb);
-
-static bool emit_return_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+                                     MachineFunction *mf);
 
-static bool emit_copy_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_return_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_unary_op_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_copy_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_logical_not_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_unary_op_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_logical_and_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_logical_not_instruction(const TacInstruction *instr, MachineFunction *mf,
+                                         const char *current_func_name);
 
-static bool emit_logical_or_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_logical_binary_instruction(const TacInstruction *instr, MachineFunction *mf,
+                                            const char *current_func_name);
 
-static bool emit_binary_arith_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_binary_arith_instruction(const TacInstruction *instr, MachineFunction *mf,
+                                          const char *current_func_name);
 
-static bool emit_division_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_division_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_label_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_label_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_goto_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name);
+static bool emit_goto_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name);
 
-static bool emit_relational_op_instruction(const TacInstruction *instr, StringBuffer *sb,
+static bool emit_relational_op_instruction(const TacInstruction *instr, MachineFunction *mf,
                                            const char *current_func_name);
 
-static bool emit_conditional_jump_instruction(const TacInstruction *instr, StringBuffer *sb,
+static bool emit_conditional_jump_instruction(const TacInstruction *instr, MachineFunction *mf,
                                               const char *current_func_name);
 
+static bool emit_strength_reduced(const TacInstruction *instr, MachineFunction *mf);
+
+static bool emit_selected_in_place(const TacInstruction *instr, MachineFunction *mf);
+
+static bool emit_direct_compare(MachineOperand src1, MachineOperand src2, MachineCondition *condition,
+                                MachineFunction *mf);
+
+static int *count_temp_uses(const TacFunction *func, Arena *arena);
+
+static bool can_fuse_compare_branch(const TacInstruction *compare, const TacInstruction *jump,
+                                    const int *use_counts);
+
+static bool emit_fused_compare_branch(const TacInstruction *compare, const TacInstruction *jump,
+                                      MachineFunction *mf, bool in_place, const char *current_func_name);
+
 // --- Main function ---
 
+void codegen_options_init(CodegenOptions *options) {
+    *options = (CodegenOptions){0};
+    options->allocate_registers = false;
+    options->pack_stack_slots = false;
+    options->fuse_compare_branches = false;
+    options->reduce_strength = false;
+    options->select_in_place = false;
+    options->peephole = false;
+    options->trim_frame = false;
+    options->omit_frame_pointer = false;
+    options->emit_object = false;
+    options->qualify_labels = false;
+    options->peephole_stats = NULL;
+    options->jobs = 1;
+}
+
 bool codegen_generate_program(TacProgram *tac_program, StringBuffer *sb) {
-    if (!tac_program) {
-        fprintf(stderr, "Codegen Error: Cannot generate assembly from NULL TAC program\n");
+    OutputSink sink;
+    output_sink_init_buffer(&sink, sb);
+    return codegen_generate_program_to_sink(tac_program, &sink, NULL);
+}
+
+// Initial size of the liveness scratch arena; it grows for large functions
+#define CODEGEN_SCRATCH_ARENA_SIZE (16 * 1024)
+
+// Initial size of each parallel worker's arena (instruction lists and the listings it prints)
+#define CODEGEN_WORKER_ARENA_SIZE (64 * 1024)
+
+// Parallel generation: workers take functions in order and print each into its own listing; the
+// listings are written out in function order afterwards, so the output matches the serial path
+typedef struct {
+    TacProgram *program;
+    const CodegenOptions *options;
+    StringBuffer *listings;       // One per function
+    size_t next_function;         // First function no worker has taken yet
+    bool failed;
+    pthread_mutex_t lock;         // Guards next_function and failed
+} ParallelCodegen;
+
+// What each worker owns; kept until the listings allocated from its arena have been written out
+typedef struct {
+    ParallelCodegen *shared;
+    Arena arena;
+    PeepholeStats peephole;       // Merged into the caller's statistics at the end
+} CodegenWorker;
+
+static void *parallel_codegen_worker(void *data) {
+    CodegenWorker *worker = data;
+    ParallelCodegen *shared = worker->shared;
+    CodegenOptions options = *shared->options;
+    options.peephole_stats = options.peephole_stats ? &worker->peephole : NULL;
+
+    CodegenContext ctx;
+    ctx.options = &options;
+    machine_function_init(&ctx.body, &worker->arena);
+    ctx.scratch = arena_create(CODEGEN_SCRATCH_ARENA_SIZE);
+    MachineFunction mf;
+    machine_function_init(&mf, &worker->arena);
+    for (;;) {
+        pthread_mutex_lock(&shared->lock);
+        const size_t index = shared->next_function++;
+        const bool stop = shared->failed || !ctx.scratch.start;
+        pthread_mutex_unlock(&shared->lock);
+        if (stop || index >= shared->program->function_count) {
+            break;
+        }
+        const TacFunction *func = shared->program->functions[index];
+        StringBuffer *listing = &shared->listings[index];
+        string_buffer_init_chunked(listing, &worker->arena, 0);
+        if (!generate_traced_function(func, &mf, &ctx)) {
+            fprintf(stderr, "Codegen Error: Failed to generate function %s\n", func->name);
+            pthread_mutex_lock(&shared->lock);
+            shared->failed = true;
+            pthread_mutex_unlock(&shared->lock);
+            break;
+        }
+        machine_print_function(listing, &mf);
+    }
+    if (!ctx.scratch.start) {
+        fprintf(stderr, "Codegen Error: Failed to create a worker's register allocation arena\n");
+        pthread_mutex_lock(&shared->lock);
+        shared->failed = true;
+        pthread_mutex_unlock(&shared->lock);
+    } else {
+        arena_destroy(&ctx.scratch);
+    }
+    return NULL;
+}
+
+// Generates assembly text for every function on up to options->jobs threads (this one included)
+static bool generate_program_in_parallel(TacProgram *tac_program, Arena *arena, OutputSink *sink,
+                                         const CodegenOptions *options) {
+    size_t worker_count = (size_t) options->jobs;
+    if (worker_count > tac_program->function_count) {
+        worker_count = tac_program->function_count;
+    }
+    ParallelCodegen shared = {.program = tac_program, .options = options};
+    shared.listings = arena_alloc_zeroed(arena, tac_program->function_count * sizeof(StringBuffer));
+    CodegenWorker *workers = arena_alloc_zeroed(arena, worker_count * sizeof(CodegenWorker));
+    pthread_t *threads = arena_alloc(arena, worker_count * sizeof(pthread_t));
+    if (!shared.listings || !workers || !threads || pthread_mutex_init(&shared.lock, NULL) != 0) {
+        fprintf(stderr, "Codegen Error: Failed to set up parallel code generation\n");
+        return false;
+    }
+
+    size_t ready = 0; // Workers with an arena; the first one runs on this thread
+    while (ready < worker_count) {
+        workers[ready].shared = &shared;
+        workers[ready].arena = arena_create(CODEGEN_WORKER_ARENA_SIZE);
+        if (!workers[ready].arena.start) {
+            break;
+        }
+        ready++;
+    }
+    size_t started = 1;
+    while (started < ready && pthread_create(&threads[started], NULL, parallel_codegen_worker, &workers[started]) == 0) {
+        started++;
+    }
+    bool success = ready > 0;
+    if (success) {
+        parallel_codegen_worker(&workers[0]);
+    } else {
+        fprintf(stderr, "Codegen Error: Failed to create a worker arena\n");
+    }
+    for (size_t i = 1; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&shared.lock);
+    success = success && !shared.failed;
+
+    // Deterministic concatenation: function order, whichever worker generated what
+    for (size_t i = 0; success && i < tac_program->function_count; ++i) {
+        string_buffer_append_buffer(output_sink_buffer(sink), &shared.listings[i]);
+        if (!output_sink_flush(sink)) {
+            fprintf(stderr, "Codegen Error: Failed to write assembly for function %s\n",
+                    tac_program->functions[i]->name);
+            success = false;
+        }
+    }
+    for (size_t i = 0; i < ready; ++i) {
+        if (options->peephole_stats) {
+            options->peephole_stats->ran |= workers[i].peephole.ran;
+            for (int r = 0; r < PEEPHOLE_RULE_COUNT; ++r) {
+                options->peephole_stats->hits[r] += workers[i].peephole.hits[r];
+            }
+        }
+        arena_destroy(&workers[i].arena);
+    }
+    return success;
+}
+
+// Generates every function either into the sink (text, or with emit_object an ELF image written at
+// the end) or, when `target` is given, encoded into that object and nothing else
+static bool generate_program(TacProgram *tac_program, Arena *arena, OutputSink *sink, ObjectWriter *target,
+                             const CodegenOptions *options) {
+    const bool encode = target || options->emit_object;
+    // Only text is generated in parallel: an object's functions are encoded one after the other
+    if (!encode && options->jobs > 1 && tac_program->function_count > 1) {
+        return generate_program_in_parallel(tac_program, arena, sink, options);
+    }
+
+    // Both instruction lists are reused for every function: they grow to the largest function only
+    CodegenContext ctx;
+    ctx.options = options;
+    machine_function_init(&ctx.body, arena);
+    // The encoder keeps its label and layout tables in the scratch arena too
+    const bool needs_scratch = options->allocate_registers || options->pack_stack_slots ||
+                               options->fuse_compare_branches || encode;
+    ctx.scratch = arena_create(needs_scratch ? CODEGEN_SCRATCH_ARENA_SIZE : 0);
+    if (needs_scratch && !ctx.scratch.start) {
+        fprintf(stderr, "Codegen Error: Failed to create the register allocation arena\n");
         return false;
     }
-    // string_buffer_clear(sb); // Ensure buffer is empty if needed, or manage externally
+    MachineFunction mf;
+    machine_function_init(&mf, arena);
+    // An object is only complete once its symbol table follows the code, so it is written at the end
+    ObjectWriter object;
+    if (!target) {
+        object_writer_init(&object, arena);
+        target = &object;
+    }
 
+    bool success = true;
     // Iterate through each function in the TAC program
-    for (size_t i = 0; i < tac_program->function_count; ++i) {
-        if (!generate_tac_function(tac_program->functions[i], sb)) {
+    for (size_t i = 0; success && i < tac_program->function_count; ++i) {
+        if (!generate_traced_function(tac_program->functions[i], &mf, &ctx)) {
             fprintf(stderr, "Codegen Error: Failed to generate function %s\n", tac_program->functions[i]->name);
-            return false; // Propagate error
+            success = false; // Propagate error
+            break;
+        }
+        if (encode) {
+            if (!x86_encode_function(&mf, target, &ctx.scratch)) {
+                fprintf(stderr, "Codegen Error: Failed to encode function %s\n", tac_program->functions[i]->name);
+                success = false;
+            }
+            continue;
+        }
+        machine_print_function(output_sink_buffer(sink), &mf);
+        // Hand the finished function to the sink while the next one is generated
+        if (!output_sink_flush(sink)) {
+            fprintf(stderr, "Codegen Error: Failed to write assembly for function %s\n",
+                    tac_program->functions[i]->name);
+            success = false;
+        }
+    }
+    if (success && sink && options->emit_object) {
+        if (!object_writer_write_elf(target, output_sink_buffer(sink)) || !output_sink_flush(sink)) {
+            fprintf(stderr, "Codegen Error: Failed to write the object file\n");
+            success = false;
+        }
+    }
+
+    if (ctx.scratch.start) {
+        arena_destroy(&ctx.scratch);
+    }
+    return success;
+}
+
+bool codegen_generate_program_to_sink(TacProgram *tac_program, OutputSink *sink, const CodegenOptions *options) {
+    if (!tac_program) {
+        fprintf(stderr, "Codegen Error: Cannot generate assembly from NULL TAC program\n");
+        return false;
+    }
+    CodegenOptions default_options;
+    if (!options) {
+        codegen_options_init(&default_options);
+        options = &default_options;
+    }
+    return generate_program(tac_program, output_sink_buffer(sink)->arena, sink, NULL, options);
+}
+
+bool codegen_generate_program_to_object(TacProgram *tac_program, ObjectWriter *object,
+                                        const CodegenOptions *options) {
+    if (!tac_program) {
+        fprintf(stderr, "Codegen Error: Cannot generate code from NULL TAC program\n");
+        return false;
+    }
+    CodegenOptions default_options;
+    if (!options) {
+        codegen_options_init(&default_options);
+        options = &default_options;
+    }
+    return generate_program(tac_program, object->arena, NULL, object, options) && !object->failed;
+}
+
+// --- Static helper function implementations ---
+
+// Stack slots in use before the callee-saved register save area
+static int spill_area_slots(const TacFunction *func, const TempAssignment *temps) {
+    if (temps->allocation) {
+        return temps->allocation->spill_slot_count;
+    }
+    return calculate_max_temp_id(func) + 1; // One slot per temp id
+}
+
+// Final location of a virtual temp: its register, its spill slot, or (without allocation) its own slot
+static MachineOperand temp_location(const int temp_id, const TempAssignment *temps) {
+    if (!temps->allocation) {
+        return machine_stack(temp_stack_offset(temp_id));
+    }
+    const TempLocation *location = &temps->allocation->locations[temp_id];
+    if (location->kind == TEMP_LOCATION_REGISTER) {
+        return machine_reg(location->reg, MACHINE_WIDTH_LONG);
+    }
+    return machine_stack(temp_stack_offset(location->spill_slot));
+}
+
+// Whether body[i] and body[i + 1] are `movl a, t; addl $k, t` (or subl/incl/decl on t), as in-place
+// selection emits them; *displacement receives the constant the pair adds
+static bool is_copy_then_add_immediate(const MachineFunction *body, const size_t i, int *displacement) {
+    if (i + 1 >= body->count) {
+        return false;
+    }
+    const MachineInstruction *copy = &body->instructions[i];
+    const MachineInstruction *add = &body->instructions[i + 1];
+    if (copy->opcode != MACHINE_OP_MOVL || copy->operands[0].kind != MACHINE_OPERAND_TEMP ||
+        copy->operands[1].kind != MACHINE_OPERAND_TEMP) {
+        return false;
+    }
+    const MachineOperand *target = &copy->operands[1];
+    if ((add->opcode == MACHINE_OP_INCL || add->opcode == MACHINE_OP_DECL) &&
+        machine_operands_equal(&add->operands[0], target)) {
+        *displacement = add->opcode == MACHINE_OP_INCL ? 1 : -1;
+        return true;
+    }
+    if ((add->opcode == MACHINE_OP_ADDL || add->opcode == MACHINE_OP_SUBL) &&
+        add->operands[0].kind == MACHINE_OPERAND_IMMEDIATE && machine_operands_equal(&add->operands[1], target)) {
+        const int value = add->operands[0].value.immediate;
+        if (add->opcode == MACHINE_OP_SUBL && value == INT_MIN) {
+            return false; // -INT_MIN is not a displacement
+        }
+        *displacement = add->opcode == MACHINE_OP_ADDL ? value : -value;
+        return true;
+    }
+    return false;
+}
+
+// One past the highest label id the function defines or jumps to
+static uint32_t label_bound(const TacFunction *func) {
+    uint32_t bound = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if ((instr->type == TAC_INS_LABEL || instr->type == TAC_INS_GOTO || instr->type == TAC_INS_IF_FALSE_GOTO ||
+             instr->type == TAC_INS_IF_TRUE_GOTO) && tac_label(instr).value.label_id >= bound) {
+            bound = tac_label(instr).value.label_id + 1;
         }
     }
+    return bound;
+}
 
+// Restores the callee-saved registers, tears down the frame and returns
+static void emit_epilogue(MachineFunction *mf, const TempAssignment *temps, const FunctionExit *function_exit) {
+    int save_slot = function_exit->spill_slots;
+    for (int r = 0; temps->allocation && r < MACHINE_REG_COUNT; ++r) {
+        if (temps->allocation->callee_saved_used[r]) {
+            machine_emit(mf, MACHINE_OP_MOVQ, machine_stack(temp_stack_offset(save_slot++)),
+                         machine_reg((MachineRegister) r, MACHINE_WIDTH_QUAD));
+        }
+    }
+
+    // The 'leave' instruction is equivalent to 'movq %rbp, %rsp; popq %rbp'
+    // Using leave is more concise if stack_space was allocated with subq.
+    if (!function_exit->needs_frame) {
+        // Nothing was pushed or allocated: %rsp already points at the return address
+    } else if (function_exit->stack_allocation_size > 0) {
+        // If we modified rsp, restore it properly.
+        machine_emit(mf, MACHINE_OP_LEAVE, NONE, NONE);
+    } else {
+        // If no stack space was allocated, rbp is still rsp, so just pop rbp.
+        machine_emit(mf, MACHINE_OP_POPQ, RBP, NONE); // This balances the initial pushq %rbp
+    }
+    machine_emit(mf, MACHINE_OP_RETQ, NONE, NONE);
+}
+
+// Whether only labels follow instruction i of the body, so control falls into the epilogue from there
+static bool falls_into_epilogue(const MachineFunction *body, size_t i) {
+    while (++i < body->count) {
+        if (body->instructions[i].opcode != MACHINE_OP_LABEL) {
+            return false;
+        }
+    }
     return true;
 }
 
-// --- Static helper function implementations (stubs for now) ---
+/**
+ * @brief Copies the body into the output list, replacing virtual temps with their locations.
+ *        A movl whose operands both ended up in memory is split through %r10d, and a movl
+ *        from a location to itself (two temps sharing a register or slot) is dropped.
+ *        The in-place forms are finished here, where locations are known: addl/subl/cmpl
+ *        between two memory operands load the source into %r10d, `cmpl $0, t` becomes testl
+ *        when t got a register, and a copy plus an immediate add between two registers
+ *        becomes one leal. A retq (what a RETURN selected, after loading %eax) is dropped at the end of
+ *        the body, repeats a short epilogue, and otherwise jumps to the shared one.
+ */
+static void lower_function_body(const MachineFunction *body, MachineFunction *mf, const TempAssignment *temps,
+                                FunctionExit *function_exit) {
+    for (size_t i = 0; i < body->count; ++i) {
+        MachineInstruction instr = body->instructions[i];
+        if (instr.opcode == MACHINE_OP_RETQ) {
+            if (falls_into_epilogue(body, i)) {
+                continue;
+            }
+            if (function_exit->repeat_epilogue) {
+                emit_epilogue(mf, temps, function_exit);
+            } else {
+                machine_emit(mf, MACHINE_OP_JMP, machine_local_label(function_exit->label), NONE);
+                function_exit->label_used = true;
+            }
+            continue;
+        }
+        for (int k = 0; k < 2; ++k) {
+            if (instr.operands[k].kind == MACHINE_OPERAND_TEMP) {
+                instr.operands[k] = temp_location(instr.operands[k].value.temp_id, temps);
+            }
+        }
+        int displacement;
+        if (is_copy_then_add_immediate(body, i, &displacement) &&
+            instr.operands[0].kind == MACHINE_OPERAND_REGISTER && instr.operands[1].kind == MACHINE_OPERAND_REGISTER &&
+            !machine_operands_equal(&instr.operands[0], &instr.operands[1])) {
+            machine_emit(mf, MACHINE_OP_LEAL, machine_address(instr.operands[0].value.reg, displacement),
+                         instr.operands[1]);
+            ++i; // The add is folded into the address
+            continue;
+        }
+        if (instr.opcode == MACHINE_OP_MOVL) {
+            if (machine_operands_equal(&instr.operands[0], &instr.operands[1]) &&
+                (instr.operands[0].kind == MACHINE_OPERAND_REGISTER || machine_operand_is_memory(&instr.operands[0]))) {
+                continue;
+            }
+            if (machine_operand_is_memory(&instr.operands[0]) && machine_operand_is_memory(&instr.operands[1])) {
+                // Memory to memory is not encodable
+                machine_emit(mf, MACHINE_OP_MOVL, instr.operands[0], R10D);
+                machine_emit(mf, MACHINE_OP_MOVL, R10D, instr.operands[1]);
+                continue;
+            }
+        } else if (instr.opcode == MACHINE_OP_ADDL || instr.opcode == MACHINE_OP_SUBL ||
+                   instr.opcode == MACHINE_OP_CMPL) {
+            if (machine_operand_is_memory(&instr.operands[0]) && machine_operand_is_memory(&instr.operands[1])) {
+                machine_emit(mf, MACHINE_OP_MOVL, instr.operands[0], R10D);
+                machine_emit(mf, instr.opcode, R10D, instr.operands[1]);
+                continue;
+            }
+            if (instr.opcode == MACHINE_OP_CMPL && instr.operands[0].kind == MACHINE_OPERAND_IMMEDIATE &&
+                instr.operands[0].value.immediate == 0 && instr.operands[1].kind == MACHINE_OPERAND_REGISTER &&
+                body->instructions[i].operands[1].kind == MACHINE_OPERAND_TEMP) {
+                instr.opcode = MACHINE_OP_TESTL; // Same flags, shorter encoding
+                instr.operands[0] = instr.operands[1];
+            }
+        }
+        machine_append(mf, &instr);
+    }
+}
+
+// generate_tac_function as one event per function when tracing
+static bool generate_traced_function(const TacFunction *func, MachineFunction *mf, CodegenContext *ctx) {
+    const char *name = func ? func->name : NULL;
+    trace_begin("codegen", name);
+    const bool generated = generate_tac_function(func, mf, ctx);
+    trace_end("codegen", name);
+    return generated;
+}
 
-static bool generate_tac_function(const TacFunction *func, StringBuffer *sb) {
+static bool generate_tac_function(const TacFunction *func, MachineFunction *mf, CodegenContext *ctx) {
     if (!func) {
         fprintf(stderr, "Codegen Error: Cannot generate code for NULL TacFunction.\n");
         return false;
     }
+    machine_function_reset(mf, func->name);
+    machine_function_reset(&ctx->body, func->name);
+    mf->qualify_labels = ctx->options->qualify_labels;
+    const ArenaMark scratch_mark = arena_mark(&ctx->scratch);
 
-    // 1. Emit function label and global directive
-    string_buffer_append(sb, ".globl _%s\n", func->name);
-    string_buffer_append(sb, "_%s:\n", func->name);
+    // 1. Select instructions for the body, with temps left virtual
+    const int *use_counts = ctx->options->fuse_compare_branches ? count_temp_uses(func, &ctx->scratch) : NULL;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        bool generated;
+        if (use_counts && i + 1 < func->instruction_count &&
+            can_fuse_compare_branch(instr, &func->instructions[i + 1], use_counts)) {
+            generated = emit_fused_compare_branch(instr, &func->instructions[i + 1], &ctx->body,
+                                                  ctx->options->select_in_place, func->name);
+            ++i; // The jump was emitted along with the comparison
+        } else if (ctx->options->reduce_strength && emit_strength_reduced(instr, &ctx->body)) {
+            generated = true;
+        } else if (ctx->options->select_in_place && emit_selected_in_place(instr, &ctx->body)) {
+            generated = true;
+        } else {
+            generated = generate_tac_instruction(instr, func, &ctx->body);
+        }
+        if (!generated) {
+            fprintf(stderr, "Codegen Error: Failed to generate instruction in function %s\n", func->name);
+            arena_release(&ctx->scratch, scratch_mark);
+            return false; // Propagate error
+        }
+    }
+    if (ctx->body.failed) {
+        arena_release(&ctx->scratch, scratch_mark);
+        return false;
+    }
 
-    // 2. Function Prologue
-    string_buffer_append(sb, "    pushq %%rbp\n");
-    string_buffer_append(sb, "    movq %%rsp, %%rbp\n");
+    // 2. Decide where temps live
+    TempAssignment temps = {NULL};
+    RegisterAllocation allocation;
+    if (ctx->options->allocate_registers || ctx->options->pack_stack_slots) {
+        const bool allocated = ctx->options->allocate_registers
+                                   ? allocate_registers(func, &ctx->scratch, &allocation)
+                                   : pack_stack_slots(func, &ctx->scratch, &allocation);
+        if (!allocated) {
+            arena_release(&ctx->scratch, scratch_mark);
+            return false;
+        }
+        temps.allocation = &allocation;
+    }
 
-    // Calculate stack space needed for temporaries
-    const int max_temp_id = calculate_max_temp_id(func);
-    const size_t bytes_for_temps = max_temp_id == -1 ? 0 : (size_t) (max_temp_id + 1) * 8; // 8 bytes per temp
+    // 3. Emit function label and global directive
+    machine_emit(mf, MACHINE_OP_GLOBL, machine_label(func->name), NONE);
+    machine_emit(mf, MACHINE_OP_FUNCTION_LABEL, machine_label(func->name), NONE);
+
+    // 4. Function Prologue
+    // Stack space: temp slots (packed when liveness is known), then the callee-saved save area
+    const int spill_slots = spill_area_slots(func, &temps);
+    int saved_register_count = 0;
+    if (temps.allocation) {
+        for (int r = 0; r < MACHINE_REG_COUNT; ++r) {
+            saved_register_count += temps.allocation->callee_saved_used[r];
+        }
+    }
+    const size_t bytes_for_temps = (size_t) (spill_slots + saved_register_count) * 8; // 8 bytes per slot
+
+    // Functions never call anything, so one that needs no stack slot needs no frame either:
+    // %rsp stays where the caller left it and nothing addresses memory through %rbp
+    const bool needs_frame = !ctx->options->omit_frame_pointer || bytes_for_temps > 0;
+    if (needs_frame) {
+        machine_emit(mf, MACHINE_OP_PUSHQ, RBP, NONE);
+        machine_emit(mf, MACHINE_OP_MOVQ, RSP, RBP);
+    }
 
     // Round up to nearest multiple of 16 for stack alignment.
     // Example: if bytes_for_temps = 0,  (0 + 15) & ~15UL = 15 & 0xFF..F0 = 0
@@ -143,197 +684,228 @@ static bool generate_tac_function(const TacFunction *func, StringBuffer *sb) {
     // ~15UL is a mask like ...1111111111110000, effectively clearing the last 4 bits.
     size_t stack_allocation_size = bytes_for_temps + 15 & ~15UL;
 
-    // Enforce a minimum stack frame size (e.g., 32 bytes for general ABI compliance/simplicity)
-    if (stack_allocation_size < 32) {
+    // Without trim_frame, keep a minimum stack frame size (32 bytes, as the unoptimized output always had);
+    // no call is ever made from the frame, so the ABI itself asks for nothing beyond the slots
+    if (!ctx->options->trim_frame && stack_allocation_size < 32) {
         stack_allocation_size = 32;
     }
 
-    // Allocate stack space if needed (it will always be at least 32 now)
-    string_buffer_append(sb, "    subq $%zu, %%rsp\n", stack_allocation_size);
-
-    // Save callee-saved registers if any (TODO: Implement this later)
+    if (stack_allocation_size > 0) {
+        machine_emit(mf, MACHINE_OP_SUBQ, machine_imm((int) stack_allocation_size), RSP);
+    }
 
-    // 4. Iterate through instructions and call generate_tac_instruction
-    for (size_t i = 0; i < func->instruction_count; ++i) {
-        if (!generate_tac_instruction(&func->instructions[i], func, sb)) {
-            fprintf(stderr, "Codegen Error: Failed to generate instruction in function %s\n", func->name);
-            return false; // Propagate error
+    // Save the callee-saved registers the allocator handed out, right below the spill slots
+    int save_slot = spill_slots;
+    for (int r = 0; temps.allocation && r < MACHINE_REG_COUNT; ++r) {
+        if (temps.allocation->callee_saved_used[r]) {
+            machine_emit(mf, MACHINE_OP_MOVQ, machine_reg((MachineRegister) r, MACHINE_WIDTH_QUAD),
+                         machine_stack(temp_stack_offset(save_slot++)));
         }
     }
 
-    // 5. Function Epilogue
-    // The 'leave' instruction is equivalent to 'movq %rbp, %rsp; popq %rbp'
-    // string_buffer_append(sb, "    movq %%rbp, %%rsp\n");
-    // string_buffer_append(sb, "    popq %%rbp\n");
-    // Using leave is more concise if stack_space was allocated with subq.
-    if (stack_allocation_size > 0) {
-        // If we modified rsp, restore it properly.
-        string_buffer_append(sb, "    leave\n");
-    } else {
-        // If no stack space was allocated, rbp is still rsp, so just pop rbp.
-        // This case might be rare or indicate an empty function that doesn't need full prologue/epilogue.
-        // However, for a standard function call structure, even empty ones might have the push/mov/pop/ret.
-        // Let's assume for now that if we pushed rbp, we pop it.
-        string_buffer_append(sb, "    popq %%rbp\n"); // This should balance the initial pushq %rbp
+    // 5. Body, with every temp in its final location
+    FunctionExit function_exit = {.spill_slots = spill_slots, .needs_frame = needs_frame,
+                                  .stack_allocation_size = stack_allocation_size,
+                                  .repeat_epilogue = saved_register_count == 0, .label = label_bound(func)};
+    lower_function_body(&ctx->body, mf, &temps, &function_exit);
+
+    // 6. Function Epilogue, shared by every RETURN that jumps here
+    if (function_exit.label_used) {
+        machine_emit(mf, MACHINE_OP_LABEL, machine_local_label(function_exit.label), NONE);
     }
-    string_buffer_append(sb, "    retq\n");
+    emit_epilogue(mf, &temps, &function_exit);
+    arena_release(&ctx->scratch, scratch_mark);
 
-    // fprintf(stdout, "Placeholder: generate_tac_function for %s (not fully implemented)\n", func->name);
-    return true;
+    // 7. Drop reloads of values still in a register, then clean up between neighbouring instructions
+    if (ctx->options->cache_register_values && !mf->failed) {
+        cache_register_values(mf, &ctx->scratch);
+    }
+    if (ctx->options->peephole && !mf->failed) {
+        peephole_optimize(mf, ctx->options->peephole_stats);
+    }
+
+    return !mf->failed;
 }
 
 // --- Static helper function implementations (TAC instruction handlers) ---
 
-static bool emit_return_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char op1_str[64];
-    if (!operand_to_assembly_string(&instr->operands.ret.src, op1_str, sizeof(op1_str))) {
+static bool emit_return_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    MachineOperand src;
+    if (!machine_operand_from_tac(tac_src(instr), &src, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operand for RETURN in function %s.\n", current_func_name);
         return false;
     }
-    string_buffer_append(sb, "    movl %s, %%eax\n", op1_str); // Result in %eax for return
+    machine_emit(mf, MACHINE_OP_MOVL, src, EAX); // Result in %eax for return
+    // Leaves the function: lower_function_body turns this into the epilogue or a jump to it
+    machine_emit(mf, MACHINE_OP_RETQ, NONE, NONE);
     return true;
 }
 
-static bool emit_copy_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char op1_str[64];
-    char dest_str[64];
-    if (!operand_to_assembly_string(&instr->operands.copy.src, op1_str, sizeof(op1_str)) ||
-        !operand_to_assembly_string(&instr->operands.copy.dst, dest_str, sizeof(dest_str))) {
+static bool emit_copy_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    MachineOperand src, dst;
+    if (!machine_operand_from_tac(tac_src(instr), &src, current_func_name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operands for COPY in function %s.\n", current_func_name);
         return false;
     }
-    // If both are stack temporaries (memory operands), use an intermediate register.
-    if (op1_str[0] == '-' && dest_str[0] == '-') {
-        // Temp-to-Temp
-        string_buffer_append(sb, "    movl %s, %%r10d\n", op1_str); // mov src_temp to r10d
-        string_buffer_append(sb, "    movl %%r10d, %s\n", dest_str); // mov r10d to dst_temp
-    } else if (op1_str[0] == '$' && dest_str[0] == '-') {
-        // Const-to-Temp
-        string_buffer_append(sb, "    movl %s, %s\n", op1_str, dest_str); // movl $const, temp_mem
-    } else {
-        // Other cases (e.g., Temp-to-Register (if we had them), or more complex scenarios)
-        // For now, use intermediate register as a general approach.
-        string_buffer_append(sb, "    movl %s, %%r10d\n", op1_str);
-        string_buffer_append(sb, "    movl %%r10d, %s\n", dest_str);
-    }
+    // Temp-to-temp copies that end up memory to memory are routed through %r10d when temps are lowered
+    machine_emit(mf, MACHINE_OP_MOVL, src, dst);
     return true;
 }
 
-static bool emit_unary_op_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char op1_str[64];
-    char dest_str[64];
+static bool emit_unary_op_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    const TacOperand src_op = tac_src(instr);
+    const TacOperand dst_op = tac_dst(instr);
 
-    const TacOperand *src_op = &instr->operands.unary_op.src;
-    const TacOperand *dst_op = &instr->operands.unary_op.dst;
-
-    if (!operand_to_assembly_string(src_op, op1_str, sizeof(op1_str)) ||
-        !operand_to_assembly_string(dst_op, dest_str, sizeof(dest_str))) {
+    MachineOperand src, dst;
+    if (!machine_operand_from_tac(src_op, &src, current_func_name) ||
+        !machine_operand_from_tac(dst_op, &dst, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operands for %s in function %s.\n",
                 (instr->type == TAC_INS_NEGATE ? "NEGATE" : "COMPLEMENT"), current_func_name);
         return false;
     }
 
-    const char *op_mnemonic = (instr->type == TAC_INS_NEGATE ? "negl" : "notl");
+    const MachineOpcode opcode = instr->type == TAC_INS_NEGATE ? MACHINE_OP_NEGL : MACHINE_OP_NOTL;
 
-    if (src_op->type == TAC_OPERAND_TEMP &&
-        dst_op->type == TAC_OPERAND_TEMP &&
-        src_op->value.temp_id == dst_op->value.temp_id) {
-        // Operate in place: op_mnemonic memory_operand
-        string_buffer_append(sb, "    %s %s\n", op_mnemonic, dest_str);
+    if (src_op.type == TAC_OPERAND_TEMP &&
+        dst_op.type == TAC_OPERAND_TEMP &&
+        src_op.value.temp_id == dst_op.value.temp_id) {
+        // Operate in place: op memory_operand
+        machine_emit(mf, opcode, dst, NONE);
     } else {
         // Use %eax as intermediary
-        string_buffer_append(sb, "    movl %s, %%eax\n", op1_str);
-        string_buffer_append(sb, "    %s %%eax\n", op_mnemonic);
-        string_buffer_append(sb, "    movl %%eax, %s\n", dest_str);
+        machine_emit(mf, MACHINE_OP_MOVL, src, EAX);
+        machine_emit(mf, opcode, EAX, NONE);
+        machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
     }
     return true;
 }
 
-static bool emit_binary_arith_instruction(const TacInstruction *instr, StringBuffer *sb,
+static bool emit_binary_arith_instruction(const TacInstruction *instr, MachineFunction *mf,
                                           const char *current_func_name) {
-    char op1_str[64];
-    char op2_str[64];
-    char dest_str[64];
-
-    if (!operand_to_assembly_string(&instr->operands.binary_op.src1, op1_str, sizeof(op1_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.src2, op2_str, sizeof(op2_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.dst, dest_str, sizeof(dest_str))) {
+    MachineOperand src1, src2, dst;
+    if (!machine_operand_from_tac(tac_src1(instr), &src1, current_func_name) ||
+        !machine_operand_from_tac(tac_src2(instr), &src2, current_func_name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operands for ADD/SUB/MUL in function %s.\n",
                 current_func_name);
         return false;
     }
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", op1_str); // mov src1 to eax
+    MachineOpcode opcode = MACHINE_OP_IMULL; // TAC_INS_MUL
     if (instr->type == TAC_INS_ADD) {
-        string_buffer_append(sb, "    addl %s, %%eax\n", op2_str); // add src2 to eax
+        opcode = MACHINE_OP_ADDL;
     } else if (instr->type == TAC_INS_SUB) {
-        string_buffer_append(sb, "    subl %s, %%eax\n", op2_str); // sub src2 from eax
-    } else {
-        // TAC_INS_MUL
-        string_buffer_append(sb, "    imull %s, %%eax\n", op2_str); // mul eax by src2
+        opcode = MACHINE_OP_SUBL;
     }
-    string_buffer_append(sb, "    movl %%eax, %s\n", dest_str); // mov result from eax to dst
+    machine_emit(mf, MACHINE_OP_MOVL, src1, EAX); // mov src1 to eax
+    machine_emit(mf, opcode, src2, EAX); // eax = eax op src2
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst); // mov result from eax to dst
     return true;
 }
 
-static bool emit_division_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char op1_str[64];
-    char op2_str[64];
-    char dest_str[64];
-
-    if (!operand_to_assembly_string(&instr->operands.binary_op.src1, op1_str, sizeof(op1_str)) || // Dividend
-        !operand_to_assembly_string(&instr->operands.binary_op.src2, op2_str, sizeof(op2_str)) || // Divisor
-        !operand_to_assembly_string(&instr->operands.binary_op.dst, dest_str, sizeof(dest_str))) {
-        // Destination
+static bool emit_division_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    MachineOperand src1, src2, dst;
+    if (!machine_operand_from_tac(tac_src1(instr), &src1, current_func_name) || // Dividend
+        !machine_operand_from_tac(tac_src2(instr), &src2, current_func_name) || // Divisor
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) { // Destination
         fprintf(stderr, "Codegen Error: Could not convert operands for DIV/MOD in function %s.\n", current_func_name);
         return false;
     }
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", op1_str); // Move dividend (src1) into eax
-    string_buffer_append(sb, "    cltd\n"); // Sign-extend eax into edx:eax (cdq for 32-bit)
+    machine_emit(mf, MACHINE_OP_MOVL, src1, EAX); // Move dividend (src1) into eax
+    machine_emit(mf, MACHINE_OP_CLTD, NONE, NONE); // Sign-extend eax into edx:eax (cdq for 32-bit)
 
-    if (instr->operands.binary_op.src2.type == TAC_OPERAND_CONST) {
-        string_buffer_append(sb, "    movl %s, %%ecx\n", op2_str); // movl $const_val, %ecx
-        string_buffer_append(sb, "    idivl %%ecx\n"); // idivl %ecx
+    if (src2.kind == MACHINE_OPERAND_IMMEDIATE) {
+        // idiv has no immediate form
+        machine_emit(mf, MACHINE_OP_MOVL, src2, ECX); // movl $const_val, %ecx
+        machine_emit(mf, MACHINE_OP_IDIVL, ECX, NONE); // idivl %ecx
     } else {
-        string_buffer_append(sb, "    idivl %s\n", op2_str); // idivl temp_var_on_stack
+        machine_emit(mf, MACHINE_OP_IDIVL, src2, NONE); // idivl temp_var_on_stack
     }
 
-    if (instr->type == TAC_INS_DIV) {
-        string_buffer_append(sb, "    movl %%eax, %s\n", dest_str); // Store quotient (eax) into dst
-    } else {
-        // TAC_INS_MOD
-        string_buffer_append(sb, "    movl %%edx, %s\n", dest_str); // Store remainder (edx) into dst
-    }
+    // Quotient is in eax, remainder in edx
+    machine_emit(mf, MACHINE_OP_MOVL, instr->type == TAC_INS_DIV ? EAX : EDX, dst);
     return true;
 }
 
-static bool emit_label_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char label_str[64];
-    if (!operand_to_assembly_string(&instr->operands.label_def.label, label_str, sizeof(label_str))) {
+/**
+ * @brief Emits MUL, DIV or MOD with a constant operand as shifts or a magic-number multiply.
+ * @return false if the instruction has no cheaper form; nothing was emitted and the
+ *         regular emitter (which also reports operand errors) handles it.
+ */
+static bool emit_strength_reduced(const TacInstruction *instr, MachineFunction *mf) {
+    if (instr->type != TAC_INS_MUL && instr->type != TAC_INS_DIV && instr->type != TAC_INS_MOD) {
+        return false;
+    }
+    MachineOperand src1, src2, dst;
+    if (!machine_operand_from_tac(tac_src1(instr), &src1, mf->name) ||
+        !machine_operand_from_tac(tac_src2(instr), &src2, mf->name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, mf->name)) {
+        return false;
+    }
+    if (instr->type == TAC_INS_MUL) {
+        if (src2.kind == MACHINE_OPERAND_IMMEDIATE) {
+            return emit_multiply_by_constant(mf, src1, src2.value.immediate, dst);
+        }
+        return src1.kind == MACHINE_OPERAND_IMMEDIATE && emit_multiply_by_constant(mf, src2, src1.value.immediate, dst);
+    }
+    return src2.kind == MACHINE_OPERAND_IMMEDIATE &&
+           emit_divide_by_constant(mf, src1, src2.value.immediate, instr->type == TAC_INS_MOD, dst);
+}
+
+static bool emit_label_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    MachineOperand label;
+    if (!machine_operand_from_tac(tac_label(instr), &label, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operand for LABEL in function %s.\n", current_func_name);
         return false;
     }
-    string_buffer_append(sb, "%s:\n", label_str);
+    machine_emit(mf, MACHINE_OP_LABEL, label, NONE);
     return true;
 }
 
-static bool emit_goto_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char target_label_str[64];
-    if (!operand_to_assembly_string(&instr->operands.go_to.target_label, target_label_str, sizeof(target_label_str))) {
+static bool emit_goto_instruction(const TacInstruction *instr, MachineFunction *mf, const char *current_func_name) {
+    MachineOperand target;
+    if (!machine_operand_from_tac(tac_label(instr), &target, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert target label for GOTO in function %s.\n", current_func_name);
         return false;
     }
-    string_buffer_append(sb, "    jmp %s\n", target_label_str);
+    machine_emit(mf, MACHINE_OP_JMP, target, NONE);
     return true;
 }
 
+// The flags condition under which a relational operator yields 1
+static bool relational_condition(const TacInstructionType type, MachineCondition *out) {
+    switch (type) {
+        case TAC_INS_EQUAL:
+            *out = MACHINE_COND_E;
+            return true;
+        case TAC_INS_NOT_EQUAL:
+            *out = MACHINE_COND_NE;
+            return true;
+        case TAC_INS_LESS:
+            *out = MACHINE_COND_L;
+            return true;
+        case TAC_INS_LESS_EQUAL:
+            *out = MACHINE_COND_LE;
+            return true;
+        case TAC_INS_GREATER:
+            *out = MACHINE_COND_G;
+            return true;
+        case TAC_INS_GREATER_EQUAL:
+            *out = MACHINE_COND_GE;
+            return true;
+        default:
+            return false;
+    }
+}
+
 /**
- * @brief Emits assembly code for a TAC relational operation instruction.
+ * @brief Emits machine code for a TAC relational operation instruction.
  *
  * Handles instructions like 'dst = src1 op src2', where 'op' is a relational
  * operator (e.g., ==, <, >=).
- * The generated assembly typically involves:
+ * The generated code typically involves:
  *   1. Loading src1 into %eax.
  *   2. Comparing %eax with src2.
  *   3. Using a 'setX' instruction (e.g., sete, setl) to set %al based on the comparison.
@@ -341,68 +913,45 @@ static bool emit_goto_instruction(const TacInstruction *instr, StringBuffer *sb,
  *   5. Storing the result (0 or 1) from %eax into the destination operand.
  *
  * @param instr The TAC instruction to process.
- * @param sb The string buffer to append assembly code to.
+ * @param mf The machine instruction list to append to.
  * @param current_func_name The name of the current function being processed (for error reporting).
  * @return true if code generation was successful, false otherwise.
  */
-static bool emit_relational_op_instruction(const TacInstruction *instr, StringBuffer *sb,
+static bool emit_relational_op_instruction(const TacInstruction *instr, MachineFunction *mf,
                                            const char *current_func_name) {
-    char op1_str[64];
-    char op2_str[64];
-    char dest_str[64];
-
-    if (!operand_to_assembly_string(&instr->operands.relational_op.src1, op1_str, sizeof(op1_str)) ||
-        !operand_to_assembly_string(&instr->operands.relational_op.src2, op2_str, sizeof(op2_str)) ||
-        !operand_to_assembly_string(&instr->operands.relational_op.dst, dest_str, sizeof(dest_str))) {
+    MachineOperand src1, src2, dst;
+    if (!machine_operand_from_tac(tac_src1(instr), &src1, current_func_name) ||
+        !machine_operand_from_tac(tac_src2(instr), &src2, current_func_name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) {
         fprintf(
             stderr, "Codegen Error: Could not convert operands for relational operation (type %d) in function %s.\n",
             instr->type, current_func_name);
         return false;
     }
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", op1_str);
-    string_buffer_append(sb, "    cmpl %s, %%eax\n", op2_str);
-
-    const char *set_instruction = NULL;
-    switch (instr->type) {
-        case TAC_INS_EQUAL:
-            set_instruction = "sete";
-            break;
-        case TAC_INS_NOT_EQUAL:
-            set_instruction = "setne";
-            break;
-        case TAC_INS_LESS:
-            set_instruction = "setl";
-            break;
-        case TAC_INS_LESS_EQUAL:
-            set_instruction = "setle";
-            break;
-        case TAC_INS_GREATER:
-            set_instruction = "setg";
-            break;
-        case TAC_INS_GREATER_EQUAL:
-            set_instruction = "setge";
-            break;
-        default:
-            fprintf(
-                stderr,
-                "Codegen Error: Unhandled relational operator type %d in emit_relational_op_instruction for function %s.\n",
-                instr->type, current_func_name);
-            return false;
+    MachineCondition condition;
+    if (!relational_condition(instr->type, &condition)) {
+        fprintf(
+            stderr,
+            "Codegen Error: Unhandled relational operator type %d in emit_relational_op_instruction for function %s.\n",
+            instr->type, current_func_name);
+        return false;
     }
 
-    string_buffer_append(sb, "    %s %%al\n", set_instruction);
-    string_buffer_append(sb, "    movzbl %%al, %%eax\n");
-    string_buffer_append(sb, "    movl %%eax, %s\n", dest_str);
+    machine_emit(mf, MACHINE_OP_MOVL, src1, EAX);
+    machine_emit(mf, MACHINE_OP_CMPL, src2, EAX);
+    machine_emit_cond(mf, MACHINE_OP_SETCC, condition, AL);
+    machine_emit(mf, MACHINE_OP_MOVZBL, AL, EAX);
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
 
     return true;
 }
 
 /**
- * @brief Emits assembly code for a TAC conditional jump instruction.
+ * @brief Emits machine code for a TAC conditional jump instruction.
  *
  * Handles TAC_INS_IF_FALSE_GOTO and TAC_INS_IF_TRUE_GOTO.
- * The generated assembly typically involves:
+ * The generated code typically involves:
  *   1. Loading the boolean condition_src operand into %eax.
  *   2. Testing %eax with itself (testl %eax, %eax) to set CPU flags (specifically ZF).
  *   3. For IF_FALSE_GOTO: Emitting 'jz target_label' (jump if zero/ZF=1).
@@ -410,31 +959,26 @@ static bool emit_relational_op_instruction(const TacInstruction *instr, StringBu
  * The target_label operand is expected to be a string identifier (e.g., "_L0").
  *
  * @param instr The TAC instruction to process.
- * @param sb The string buffer to append assembly code to.
+ * @param mf The machine instruction list to append to.
  * @param current_func_name The name of the current function being processed (for error reporting).
  * @return true if code generation was successful, false otherwise.
  */
-static bool emit_conditional_jump_instruction(const TacInstruction *instr, StringBuffer *sb,
+static bool emit_conditional_jump_instruction(const TacInstruction *instr, MachineFunction *mf,
                                               const char *current_func_name) {
-    char cond_str[64];
-    char target_label_str[64];
-
-    if (!operand_to_assembly_string(&instr->operands.conditional_goto.condition_src, cond_str, sizeof(cond_str)) ||
-        !operand_to_assembly_string(&instr->operands.conditional_goto.target_label, target_label_str,
-                                    sizeof(target_label_str))) {
+    MachineOperand condition_src, target;
+    if (!machine_operand_from_tac(tac_src(instr), &condition_src,
+                                  current_func_name) ||
+        !machine_operand_from_tac(tac_label(instr), &target, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operands for conditional jump (type %d) in function %s.\n",
                 instr->type, current_func_name);
         return false;
     }
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", cond_str); // Move condition (0 or 1) into eax
-    string_buffer_append(sb, "    testl %%eax, %%eax\n"); // Test eax with itself. Sets ZF if eax is 0.
-
+    MachineCondition condition;
     if (instr->type == TAC_INS_IF_FALSE_GOTO) {
-        string_buffer_append(sb, "    jz %s\n", target_label_str); // Jump if Zero (ZF=1), i.e., if condition was false
+        condition = MACHINE_COND_Z; // Jump if Zero (ZF=1), i.e., if condition was false
     } else if (instr->type == TAC_INS_IF_TRUE_GOTO) {
-        string_buffer_append(sb, "    jnz %s\n", target_label_str);
-        // Jump if Not Zero (ZF=0), i.e., if condition was true
+        condition = MACHINE_COND_NZ; // Jump if Not Zero (ZF=0), i.e., if condition was true
     } else {
         fprintf(
             stderr,
@@ -443,83 +987,235 @@ static bool emit_conditional_jump_instruction(const TacInstruction *instr, Strin
         return false;
     }
 
+    machine_emit(mf, MACHINE_OP_MOVL, condition_src, EAX); // Move condition (0 or 1) into eax
+    machine_emit(mf, MACHINE_OP_TESTL, EAX, EAX); // Test eax with itself. Sets ZF if eax is 0.
+    machine_emit_cond(mf, MACHINE_OP_JCC, condition, target);
     return true;
 }
 
-static bool emit_logical_and_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char src1_str[64], src2_str[64], dest_str[64];
-    if (!operand_to_assembly_string(&instr->operands.binary_op.src1, src1_str, sizeof(src1_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.src2, src2_str, sizeof(src2_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.dst, dest_str, sizeof(dest_str))) {
-        fprintf(stderr, "Codegen Error: Could not convert operands for LOGICAL_AND in function %s.\n",
-                current_func_name);
-        return false;
+// Number of times each temp is read in the function (NULL if memory ran out: no fusion then)
+static int *count_temp_uses(const TacFunction *func, Arena *arena) {
+    const int temp_count = tac_function_temp_count(func);
+    int *use_counts = arena_alloc_zeroed(arena, (size_t) temp_count * sizeof(int) + 1);
+    if (!use_counts) {
+        return NULL;
     }
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+            if (tac_slot_is_temp(instr, slot)) {
+                use_counts[tac_get_operand(instr, slot).value.temp_id]++;
+            }
+        }
+    }
+    return use_counts;
+}
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", src1_str); // Load src1
-    string_buffer_append(sb, "    testl %%eax, %%eax\n"); // Is src1 zero?
-    string_buffer_append(sb, "    setne %%dl\n"); // dl = (src1 != 0)
-    string_buffer_append(sb, "    movl %s, %%eax\n", src2_str); // Load src2
-    string_buffer_append(sb, "    testl %%eax, %%eax\n"); // Is src2 zero?
-    string_buffer_append(sb, "    setne %%al\n"); // al = (src2 != 0)
-    string_buffer_append(sb, "    andb %%dl, %%al\n"); // al = (src1 != 0) && (src2 != 0)
-    string_buffer_append(sb, "    movzbl %%al, %%eax\n"); // Zero-extend al to eax
-    string_buffer_append(sb, "    movl %%eax, %s\n", dest_str); // Store result in dst
-    return true;
+// `t = a op b` followed by `if_false/if_true t goto L`, where the jump is the only reader of t
+static bool can_fuse_compare_branch(const TacInstruction *compare, const TacInstruction *jump,
+                                    const int *use_counts) {
+    MachineCondition condition;
+    if (!relational_condition(compare->type, &condition) ||
+        (jump->type != TAC_INS_IF_FALSE_GOTO && jump->type != TAC_INS_IF_TRUE_GOTO)) {
+        return false;
+    }
+    const TacOperand result = tac_dst(compare);
+    const TacOperand tested = tac_src(jump);
+    return result.type == TAC_OPERAND_TEMP && tested.type == TAC_OPERAND_TEMP &&
+           result.value.temp_id == tested.value.temp_id && use_counts[result.value.temp_id] == 1;
 }
 
-static bool emit_logical_or_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char src1_str[64], src2_str[64], dest_str[64];
-    if (!operand_to_assembly_string(&instr->operands.binary_op.src1, src1_str, sizeof(src1_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.src2, src2_str, sizeof(src2_str)) ||
-        !operand_to_assembly_string(&instr->operands.binary_op.dst, dest_str, sizeof(dest_str))) {
-        fprintf(stderr, "Codegen Error: Could not convert operands for LOGICAL_OR in function %s.\n",
+/**
+ * @brief Emits a comparison and the conditional jump reading it as cmpl + jcc.
+ *
+ * The 0/1 result is never materialized: if_true jumps on the comparison's own
+ * condition and if_false on its negation (e.g. `t = a < b; if_false t goto L`
+ * becomes `cmpl b, a; jge L`).
+ */
+static bool emit_fused_compare_branch(const TacInstruction *compare, const TacInstruction *jump,
+                                      MachineFunction *mf, const bool in_place, const char *current_func_name) {
+    MachineOperand src1, src2, target;
+    MachineCondition condition;
+    if (!machine_operand_from_tac(tac_src1(compare), &src1, current_func_name) ||
+        !machine_operand_from_tac(tac_src2(compare), &src2, current_func_name) ||
+        !machine_operand_from_tac(tac_label(jump), &target, current_func_name) ||
+        !relational_condition(compare->type, &condition)) {
+        fprintf(stderr, "Codegen Error: Could not convert operands for fused compare and branch in function %s.\n",
                 current_func_name);
         return false;
     }
+    if (jump->type == TAC_INS_IF_FALSE_GOTO) {
+        condition = machine_condition_negate(condition);
+    }
 
-    string_buffer_append(sb, "    movl %s, %%eax\n", src1_str); // Load src1
-    string_buffer_append(sb, "    testl %%eax, %%eax\n"); // Is src1 zero?
-    string_buffer_append(sb, "    setne %%dl\n"); // dl = (src1 != 0)
-    string_buffer_append(sb, "    movl %s, %%eax\n", src2_str); // Load src2
-    string_buffer_append(sb, "    testl %%eax, %%eax\n"); // Is src2 zero?
-    string_buffer_append(sb, "    setne %%al\n"); // al = (src2 != 0)
-    string_buffer_append(sb, "    orb %%dl, %%al\n"); // al = (src1 != 0) || (src2 != 0)
-    string_buffer_append(sb, "    movzbl %%al, %%eax\n"); // Zero-extend al to eax
-    string_buffer_append(sb, "    movl %%eax, %s\n", dest_str); // Store result in dst
+    if (!in_place || !emit_direct_compare(src1, src2, &condition, mf)) {
+        machine_emit(mf, MACHINE_OP_MOVL, src1, EAX);
+        machine_emit(mf, MACHINE_OP_CMPL, src2, EAX);
+    }
+    machine_emit_cond(mf, MACHINE_OP_JCC, condition, target);
     return true;
 }
 
-static bool emit_logical_not_instruction(const TacInstruction *instr, StringBuffer *sb, const char *current_func_name) {
-    char src_str[64];
-    char dest_str[64];
+/**
+ * @brief Emits `cmpl src2, src1` without the %eax copy, trading the operands (and the
+ *        condition) when only src2 is a temp, since cmpl cannot compare into an immediate.
+ * @return false if both sides are constants; nothing was emitted.
+ */
+static bool emit_direct_compare(const MachineOperand src1, const MachineOperand src2, MachineCondition *condition,
+                                MachineFunction *mf) {
+    if (src1.kind == MACHINE_OPERAND_TEMP) {
+        machine_emit(mf, MACHINE_OP_CMPL, src2, src1);
+        return true;
+    }
+    if (src2.kind == MACHINE_OPERAND_TEMP) {
+        machine_emit(mf, MACHINE_OP_CMPL, src1, src2);
+        *condition = machine_condition_swap(*condition);
+        return true;
+    }
+    return false;
+}
+
+// dst += addend (or -=), as incl/decl when the addend is 1 or -1
+static void emit_accumulate(MachineFunction *mf, const MachineOpcode opcode, const MachineOperand addend,
+                            const MachineOperand dst) {
+    if (addend.kind == MACHINE_OPERAND_IMMEDIATE && (addend.value.immediate == 1 || addend.value.immediate == -1)) {
+        const bool increments = (addend.value.immediate == 1) == (opcode == MACHINE_OP_ADDL);
+        machine_emit(mf, increments ? MACHINE_OP_INCL : MACHINE_OP_DECL, dst, NONE);
+        return;
+    }
+    machine_emit(mf, opcode, addend, dst);
+}
 
-    const TacOperand *src_op = &instr->operands.unary_op.src;
-    const TacOperand *dst_op = &instr->operands.unary_op.dst;
+/**
+ * @brief Emits ADD/SUB, relational operators and conditional jumps on their operands'
+ *        own locations, the way NEGATE/COMPLEMENT already work in place:
+ *          t = t + x      ->  addl x, t       (incl/decl for 1 and -1)
+ *          t = a + 5      ->  movl a, t; addl $5, t   (one leal when both end up in registers)
+ *          t = a < b      ->  cmpl b, a; setl %al; ...
+ *          if_false t     ->  cmpl $0, t (testl once t is a register)
+ *        A copy into dst is only emitted when the other source is a constant: the
+ *        allocator may give dst the register of a source whose last use is this instruction.
+ * @return false if no operand shape allows it; nothing was emitted and the regular
+ *         emitter (which also reports operand errors) handles the instruction.
+ */
+static bool emit_selected_in_place(const TacInstruction *instr, MachineFunction *mf) {
+    MachineOperand src1, src2, dst;
+    switch (instr->type) {
+        case TAC_INS_ADD:
+        case TAC_INS_SUB: {
+            if (!machine_operand_from_tac(tac_src1(instr), &src1, mf->name) ||
+                !machine_operand_from_tac(tac_src2(instr), &src2, mf->name) ||
+                !machine_operand_from_tac(tac_dst(instr), &dst, mf->name) ||
+                dst.kind != MACHINE_OPERAND_TEMP) {
+                return false;
+            }
+            const bool commutes = instr->type == TAC_INS_ADD;
+            const MachineOpcode opcode = commutes ? MACHINE_OP_ADDL : MACHINE_OP_SUBL;
+            if (machine_operands_equal(&src1, &dst)) {
+                emit_accumulate(mf, opcode, src2, dst);
+            } else if (commutes && machine_operands_equal(&src2, &dst)) {
+                emit_accumulate(mf, opcode, src1, dst);
+            } else if (src1.kind == MACHINE_OPERAND_TEMP && src2.kind == MACHINE_OPERAND_IMMEDIATE) {
+                machine_emit(mf, MACHINE_OP_MOVL, src1, dst);
+                emit_accumulate(mf, opcode, src2, dst);
+            } else if (commutes && src1.kind == MACHINE_OPERAND_IMMEDIATE && src2.kind == MACHINE_OPERAND_TEMP) {
+                machine_emit(mf, MACHINE_OP_MOVL, src2, dst);
+                emit_accumulate(mf, opcode, src1, dst);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        case TAC_INS_EQUAL:
+        case TAC_INS_NOT_EQUAL:
+        case TAC_INS_LESS:
+        case TAC_INS_LESS_EQUAL:
+        case TAC_INS_GREATER:
+        case TAC_INS_GREATER_EQUAL: {
+            MachineCondition condition;
+            if (!machine_operand_from_tac(tac_src1(instr), &src1, mf->name) ||
+                !machine_operand_from_tac(tac_src2(instr), &src2, mf->name) ||
+                !machine_operand_from_tac(tac_dst(instr), &dst, mf->name) ||
+                !relational_condition(instr->type, &condition) ||
+                !emit_direct_compare(src1, src2, &condition, mf)) {
+                return false;
+            }
+            machine_emit_cond(mf, MACHINE_OP_SETCC, condition, AL);
+            machine_emit(mf, MACHINE_OP_MOVZBL, AL, EAX);
+            machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
+            return true;
+        }
+        case TAC_INS_IF_FALSE_GOTO:
+        case TAC_INS_IF_TRUE_GOTO: {
+            MachineOperand target;
+            if (!machine_operand_from_tac(tac_src(instr), &src1, mf->name) ||
+                !machine_operand_from_tac(tac_label(instr), &target, mf->name) ||
+                src1.kind != MACHINE_OPERAND_TEMP) {
+                return false;
+            }
+            machine_emit(mf, MACHINE_OP_CMPL, machine_imm(0), src1);
+            machine_emit_cond(mf, MACHINE_OP_JCC,
+                              instr->type == TAC_INS_IF_FALSE_GOTO ? MACHINE_COND_Z : MACHINE_COND_NZ, target);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// LOGICAL_AND / LOGICAL_OR: normalize both sources to 0/1 in %dl and %al, then combine the bytes
+static bool emit_logical_binary_instruction(const TacInstruction *instr, MachineFunction *mf,
+                                            const char *current_func_name) {
+    MachineOperand src1, src2, dst;
+    if (!machine_operand_from_tac(tac_src1(instr), &src1, current_func_name) ||
+        !machine_operand_from_tac(tac_src2(instr), &src2, current_func_name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) {
+        fprintf(stderr, "Codegen Error: Could not convert operands for %s in function %s.\n",
+                instr->type == TAC_INS_LOGICAL_AND ? "LOGICAL_AND" : "LOGICAL_OR", current_func_name);
+        return false;
+    }
+
+    machine_emit(mf, MACHINE_OP_MOVL, src1, EAX); // Load src1
+    machine_emit(mf, MACHINE_OP_TESTL, EAX, EAX); // Is src1 zero?
+    machine_emit_cond(mf, MACHINE_OP_SETCC, MACHINE_COND_NE, DL); // dl = (src1 != 0)
+    machine_emit(mf, MACHINE_OP_MOVL, src2, EAX); // Load src2
+    machine_emit(mf, MACHINE_OP_TESTL, EAX, EAX); // Is src2 zero?
+    machine_emit_cond(mf, MACHINE_OP_SETCC, MACHINE_COND_NE, AL); // al = (src2 != 0)
+    // al = (src1 != 0) && (src2 != 0), or || for LOGICAL_OR
+    machine_emit(mf, instr->type == TAC_INS_LOGICAL_AND ? MACHINE_OP_ANDB : MACHINE_OP_ORB, DL, AL);
+    machine_emit(mf, MACHINE_OP_MOVZBL, AL, EAX); // Zero-extend al to eax
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst); // Store result in dst
+    return true;
+}
 
-    if (!operand_to_assembly_string(src_op, src_str, sizeof(src_str)) ||
-        !operand_to_assembly_string(dst_op, dest_str, sizeof(dest_str))) {
+static bool emit_logical_not_instruction(const TacInstruction *instr, MachineFunction *mf,
+                                         const char *current_func_name) {
+    MachineOperand src, dst;
+    if (!machine_operand_from_tac(tac_src(instr), &src, current_func_name) ||
+        !machine_operand_from_tac(tac_dst(instr), &dst, current_func_name)) {
         fprintf(stderr, "Codegen Error: Could not convert operands for LOGICAL_NOT in function %s.\n",
                 current_func_name);
         return false;
     }
 
     // Load source into eax
-    string_buffer_append(sb, "    movl %s, %%eax\n", src_str);
+    machine_emit(mf, MACHINE_OP_MOVL, src, EAX);
     // Compare eax with 0
-    string_buffer_append(sb, "    cmpl $0, %%eax\n");
+    machine_emit(mf, MACHINE_OP_CMPL, machine_imm(0), EAX);
     // Set al to 1 if eax was 0 (ZF=1), else 0
-    string_buffer_append(sb, "    sete %%al\n");
+    machine_emit_cond(mf, MACHINE_OP_SETCC, MACHINE_COND_E, AL);
     // Zero-extend al to eax (eax = al)
-    string_buffer_append(sb, "    movzbl %%al, %%eax\n");
+    machine_emit(mf, MACHINE_OP_MOVZBL, AL, EAX);
     // Store the result from eax into the destination
-    string_buffer_append(sb, "    movl %%eax, %s\n", dest_str);
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
 
     return true;
 }
 
 static bool generate_tac_instruction(const TacInstruction *instr, const TacFunction *current_function,
-                                     StringBuffer *sb) {
+                                     MachineFunction *mf) {
     if (!instr) {
         fprintf(stderr, "Codegen Error: Cannot generate code for NULL TacInstruction.\n");
         return false;
@@ -529,40 +1225,39 @@ static bool generate_tac_instruction(const TacInstruction *instr, const TacFunct
 
     switch (instr->type) {
         case TAC_INS_RETURN:
-            return emit_return_instruction(instr, sb, func_name_for_errors);
+            return emit_return_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_COPY:
-            return emit_copy_instruction(instr, sb, func_name_for_errors);
+            return emit_copy_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_NEGATE:
         case TAC_INS_COMPLEMENT:
             // Note: These are arithmetic/bitwise, not logical not.
-            return emit_unary_op_instruction(instr, sb, func_name_for_errors);
+            return emit_unary_op_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_LOGICAL_NOT:
-            return emit_logical_not_instruction(instr, sb, func_name_for_errors);
+            return emit_logical_not_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_LOGICAL_AND:
-            return emit_logical_and_instruction(instr, sb, func_name_for_errors);
         case TAC_INS_LOGICAL_OR:
-            return emit_logical_or_instruction(instr, sb, func_name_for_errors);
+            return emit_logical_binary_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_ADD:
         case TAC_INS_SUB:
         case TAC_INS_MUL:
-            return emit_binary_arith_instruction(instr, sb, func_name_for_errors);
+            return emit_binary_arith_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_DIV:
         case TAC_INS_MOD:
-            return emit_division_instruction(instr, sb, func_name_for_errors);
+            return emit_division_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_LABEL:
-            return emit_label_instruction(instr, sb, func_name_for_errors);
+            return emit_label_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_GOTO:
-            return emit_goto_instruction(instr, sb, func_name_for_errors);
+            return emit_goto_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_EQUAL:
         case TAC_INS_NOT_EQUAL:
         case TAC_INS_LESS:
         case TAC_INS_LESS_EQUAL:
         case TAC_INS_GREATER:
         case TAC_INS_GREATER_EQUAL:
-            return emit_relational_op_instruction(instr, sb, func_name_for_errors);
+            return emit_relational_op_instruction(instr, mf, func_name_for_errors);
         case TAC_INS_IF_FALSE_GOTO:
         case TAC_INS_IF_TRUE_GOTO:
-            return emit_conditional_jump_instruction(instr, sb, func_name_for_errors);
+            return emit_conditional_jump_instruction(instr, mf, func_name_for_errors);
         default:
             fprintf(stderr, "Codegen Warning: Unhandled TAC instruction type %d in function %s. No code generated.\n",
                     instr->type, func_name_for_errors);
@@ -584,20 +1279,26 @@ bool operand_to_assembly_string(const TacOperand *op, char *out_buffer, size_t b
         return false;
     }
 
-    int written = 0;
+    // Build the text in a scratch buffer with the hand-rolled formatter, then copy if it fits
+    char scratch[DECIMAL_INT_BUFFER_SIZE + 8];
+    const char *text = scratch;
+    size_t length = 0;
     switch (op->type) {
         case TAC_OPERAND_CONST:
-            written = snprintf(out_buffer, buffer_size, "$%d", op->value.constant_value);
+            scratch[0] = '$';
+            length = 1 + format_decimal_int(scratch + 1, op->value.constant_value);
             break;
         case TAC_OPERAND_TEMP:
             // Assuming 8-byte alignment for each temporary on the stack.
             // temp_id 0 -> -8(%rbp), temp_id 1 -> -16(%rbp), etc.
-            written = snprintf(out_buffer, buffer_size, "-%d(%%rbp)", (op->value.temp_id + 1) * 8);
+            scratch[0] = '-';
+            length = 1 + format_decimal_int(scratch + 1, ((long long) op->value.temp_id + 1) * 8);
+            memcpy(scratch + length, "(%rbp)", sizeof("(%rbp)"));
+            length += sizeof("(%rbp)") - 1;
             break;
         case TAC_OPERAND_LABEL:
-            // For TAC_OPERAND_LABEL, op->value.label_name is expected to be a string
-            // identifier (e.g., "_L0"). This case outputs that string directly.
-            written = snprintf(out_buffer, buffer_size, "%s", op->value.label_name);
+            scratch[0] = 'L';
+            length = 1 + format_decimal_int(scratch + 1, op->value.label_id);
             break;
         default:
             fprintf(stderr, "operand_to_assembly_string: Unhandled operand type %d\n", op->type);
@@ -605,12 +1306,13 @@ bool operand_to_assembly_string(const TacOperand *op, char *out_buffer, size_t b
             return false; // Indicate failure for unhandled types
     }
 
-    if (written < 0 || (size_t) written >= buffer_size) {
-        fprintf(stderr, "operand_to_assembly_string: snprintf error or buffer too small (type: %d).\n", op->type);
-        // Ensure buffer is null-terminated even on error if possible
-        if (buffer_size > 0) out_buffer[buffer_size - 1] = '\0';
-        return false; // Error or truncation
+    if (length >= buffer_size) {
+        fprintf(stderr, "operand_to_assembly_string: buffer too small (type: %d).\n", op->type);
+        // Ensure buffer is null-terminated even on error
+        out_buffer[0] = '\0';
+        return false; // Truncation
     }
+    memcpy(out_buffer, text, length + 1);
 
     return true;
 }
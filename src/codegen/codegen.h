@@ -3,9 +3,42 @@
 
 #include "../ir/tac.h"          // Include TAC definitions (TacProgram)
 #include "../strings/strings.h" // Include StringBuffer definition
+#include "../strings/output_sink.h" // For streaming output
+#include "peephole.h"      // For PeepholeStats
+#include "object_writer.h" // For ObjectWriter
 #include <stdbool.h>      // For bool return type
 #include <stddef.h>       // For size_t type
 
+// Code generation choices; the defaults reproduce the unoptimized output exactly.
+typedef struct {
+    bool allocate_registers; // Keep temps in registers (linear scan) instead of one stack slot each (-O1)
+    bool pack_stack_slots;   // Share stack slots between temps whose live ranges do not overlap (-O1);
+                             // spill slots are always shared when allocate_registers is set
+    bool fuse_compare_branches; // Branch on the cmpl flags when a comparison only feeds the next jump (-O1)
+    bool reduce_strength;    // Shifts and magic-number multiplies for * / % by constants instead of imull/idivl (-O1)
+    bool select_in_place;    // Two-operand, immediate, incl/decl and leal forms for add/sub and compares
+                             // instead of the %eax round trip (-O1)
+    bool cache_register_values; // Drop moves of values a register or slot already holds, per basic block (-O1)
+    bool peephole;           // Clean up the lowered instruction list with the peephole rules (-O1)
+    bool trim_frame;         // Size the frame to the slots in use, without the 32-byte minimum (-O1)
+    bool omit_frame_pointer; // No pushq %rbp / movq %rsp, %rbp / leave in functions that use no stack
+                             // slot (-O1, unless --no-omit-frame-pointer keeps frames for profilers)
+    bool emit_object;        // Encode machine code and write an ELF relocatable object to the sink instead
+                             // of assembly text (--emit-obj)
+    bool qualify_labels;     // Print local labels as L<id>_<function>, so listings of functions generated
+                             // in separate compilations can be concatenated (--stream)
+    PeepholeStats *peephole_stats; // Optional: receives the per-rule hit counts when peephole is set
+    int jobs;                // Generate the assembly of up to this many functions at once (--function-jobs);
+                             // the listing is the same as with 1, and objects are always encoded serially
+} CodegenOptions;
+
+/**
+ * Sets every code generation option to its default (no register allocation, one slot per temp).
+ *
+ * @param options Pointer to the options to initialize.
+ */
+void codegen_options_init(CodegenOptions *options);
+
 /**
  * Generates assembly code (x86-64 macOS AT&T syntax) from TAC.
  *
@@ -15,6 +48,29 @@
  */
 bool codegen_generate_program(TacProgram *tac_program, StringBuffer *sb);
 
+/**
+ * Generates assembly code into an output sink, flushing it after every function,
+ * so a file sink only ever holds one function's assembly in memory.
+ *
+ * @param tac_program The Three-Address Code program.
+ * @param sink The sink receiving the assembly code.
+ * @param options Code generation options, or NULL for the defaults.
+ * @return true if code generation (and every flush) was successful, false otherwise.
+ */
+bool codegen_generate_program_to_sink(TacProgram *tac_program, OutputSink *sink, const CodegenOptions *options);
+
+/**
+ * Encodes every function into an object's .text and symbol table instead of printing
+ * assembly (options->emit_object is implied); no ELF image is written, so the caller can
+ * load the code straight into memory (see jit.h) or write it out itself.
+ *
+ * @param tac_program The Three-Address Code program.
+ * @param object The object receiving the code; the instruction lists are allocated from its arena.
+ * @param options Code generation options, or NULL for the defaults.
+ * @return true if every function was encoded, false otherwise.
+ */
+bool codegen_generate_program_to_object(TacProgram *tac_program, ObjectWriter *object, const CodegenOptions *options);
+
 /**
  * Converts a TAC operand to its assembly string representation.
  *
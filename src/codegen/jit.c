@@ -0,0 +1,70 @@
+#include "jit.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define JIT_HAVE_EXECUTABLE_MAPPING 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define JIT_HAVE_EXECUTABLE_MAPPING 0
+#endif
+
+bool jit_supported(void) {
+    return JIT_HAVE_EXECUTABLE_MAPPING;
+}
+
+static const ObjectSymbol *find_function(const ObjectWriter *object, const char *name) {
+    for (size_t i = 0; i < object->symbol_count; ++i) {
+        if (strcmp(object->symbols[i].name, name) == 0) {
+            return &object->symbols[i];
+        }
+    }
+    return NULL;
+}
+
+bool jit_load(const ObjectWriter *object, const char *entry_name, JitCode *out_code) {
+    *out_code = (JitCode){0};
+    if (object->failed) {
+        return false;
+    }
+    const ObjectSymbol *entry = find_function(object, entry_name);
+    if (!entry) {
+        fprintf(stderr, "JIT Error: No function named '%s' to run.\n", entry_name);
+        return false;
+    }
+#if JIT_HAVE_EXECUTABLE_MAPPING
+    const size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t size = (object->text_size + page_size - 1) / page_size * page_size;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("JIT Error: mmap");
+        return false;
+    }
+    memcpy(memory, object->text, object->text_size);
+    // W^X: the copy is finished before the pages become executable, and they stay read-only
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        perror("JIT Error: mprotect");
+        munmap(memory, size);
+        return false;
+    }
+    // Object and function pointers are the same size on every supported host
+    const uintptr_t address = (uintptr_t) memory + entry->offset;
+    *out_code = (JitCode){.memory = memory, .size = size, .entry = (JitFunction) address};
+    return true;
+#else
+    fprintf(stderr, "JIT Error: Running generated code needs an x86-64 POSIX host.\n");
+    return false;
+#endif
+}
+
+void jit_release(JitCode *code) {
+    if (!code) return;
+#if JIT_HAVE_EXECUTABLE_MAPPING
+    if (code->memory) {
+        munmap(code->memory, code->size);
+    }
+#endif
+    *code = (JitCode){0};
+}
@@ -0,0 +1,47 @@
+#ifndef CLERIC_JIT_H
+#define CLERIC_JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "object_writer.h"
+
+//------------------------------------------------------------------------------
+// In-memory execution of encoded code
+//
+// The object's .text is copied into an anonymous mapping that is writable while
+// the bytes are copied and then made read-only and executable (never both at
+// once). The generated code refers to nothing outside .text, so no relocation or
+// linking is needed: a function is called through a pointer to its symbol.
+// Only x86-64 POSIX hosts can run the code; elsewhere jit_load fails.
+//------------------------------------------------------------------------------
+
+// A generated `int f(void)`
+typedef int (*JitFunction)(void);
+
+typedef struct {
+    void *memory;       // Start of the executable mapping, NULL when nothing is loaded
+    size_t size;        // Bytes mapped (the text rounded up to whole pages)
+    JitFunction entry;  // The function named at load time
+} JitCode;
+
+/**
+ * @brief Whether this host can execute the encoded x86-64 code.
+ */
+bool jit_supported(void);
+
+/**
+ * @brief Maps a copy of the object's .text executable and finds a function in it.
+ * @param object The encoded program; it may be discarded once this returns.
+ * @param entry_name The function to call, as named in the TAC (e.g. "main").
+ * @param out_code Receives the mapping; release it with jit_release.
+ * @return false (with an error printed) if the host is unsupported, the function is missing, or the
+ *         mapping failed.
+ */
+bool jit_load(const ObjectWriter *object, const char *entry_name, JitCode *out_code);
+
+/**
+ * @brief Unmaps loaded code and clears the struct (a cleared struct is ignored).
+ */
+void jit_release(JitCode *code);
+
+#endif // CLERIC_JIT_H
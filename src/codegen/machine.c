@@ -0,0 +1,203 @@
+#include "machine.h"
+#include <stdio.h>
+#include <string.h>
+
+// Register names indexed by [width][register]
+static const char *const register_names[3][MACHINE_REG_COUNT] = {
+    {"%al", "%cl", "%dl", "%bl", "%spl", "%bpl", "%sil", "%dil",
+     "%r8b", "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b"},
+    {"%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+     "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"},
+    {"%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+     "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"},
+};
+
+// Mnemonics (with indentation and trailing space where operands follow), indexed by opcode
+static const char *const opcode_mnemonics[MACHINE_OP_COUNT] = {
+    [MACHINE_OP_GLOBL] = ".globl _",
+    [MACHINE_OP_FUNCTION_LABEL] = "_",
+    [MACHINE_OP_LABEL] = "",
+    [MACHINE_OP_PUSHQ] = "    pushq ",
+    [MACHINE_OP_POPQ] = "    popq ",
+    [MACHINE_OP_MOVQ] = "    movq ",
+    [MACHINE_OP_SUBQ] = "    subq ",
+    [MACHINE_OP_LEAVE] = "    leave",
+    [MACHINE_OP_RETQ] = "    retq",
+    [MACHINE_OP_MOVL] = "    movl ",
+    [MACHINE_OP_MOVZBL] = "    movzbl ",
+    [MACHINE_OP_ADDL] = "    addl ",
+    [MACHINE_OP_SUBL] = "    subl ",
+    [MACHINE_OP_IMULL] = "    imull ",
+    [MACHINE_OP_NEGL] = "    negl ",
+    [MACHINE_OP_NOTL] = "    notl ",
+    [MACHINE_OP_CMPL] = "    cmpl ",
+    [MACHINE_OP_TESTL] = "    testl ",
+    [MACHINE_OP_CLTD] = "    cltd",
+    [MACHINE_OP_IDIVL] = "    idivl ",
+    [MACHINE_OP_IMULL_WIDE] = "    imull ",
+    [MACHINE_OP_SHLL] = "    shll ",
+    [MACHINE_OP_SARL] = "    sarl ",
+    [MACHINE_OP_SHRL] = "    shrl ",
+    [MACHINE_OP_ANDL] = "    andl ",
+    [MACHINE_OP_XORL] = "    xorl ",
+    [MACHINE_OP_INCL] = "    incl ",
+    [MACHINE_OP_DECL] = "    decl ",
+    [MACHINE_OP_LEAL] = "    leal ",
+    [MACHINE_OP_ANDB] = "    andb ",
+    [MACHINE_OP_ORB] = "    orb ",
+    [MACHINE_OP_SETCC] = "    set",
+    [MACHINE_OP_JMP] = "    jmp ",
+    [MACHINE_OP_JCC] = "    j",
+};
+
+// Condition suffixes, indexed by MachineCondition
+static const char *const condition_suffixes[] = {"e", "ne", "l", "le", "g", "ge", "z", "nz"};
+
+#define MACHINE_FUNCTION_INITIAL_CAPACITY 64
+
+void machine_function_init(MachineFunction *mf, Arena *arena) {
+    mf->name = NULL;
+    mf->instructions = NULL;
+    mf->count = 0;
+    mf->capacity = 0;
+    mf->arena = arena;
+    mf->failed = false;
+    mf->qualify_labels = false;
+}
+
+void machine_function_reset(MachineFunction *mf, const char *name) {
+    mf->name = name;
+    mf->count = 0;
+    mf->failed = false;
+}
+
+static MachineInstruction *append_instruction(MachineFunction *mf) {
+    if (mf->count == mf->capacity) {
+        const size_t new_capacity = mf->capacity ? mf->capacity * 2 : MACHINE_FUNCTION_INITIAL_CAPACITY;
+        MachineInstruction *grown = arena_alloc_tagged(mf->arena, new_capacity * sizeof(MachineInstruction),
+                                                       ARENA_TAG_MACHINE);
+        if (!grown) {
+            fprintf(stderr, "Codegen Error: Out of memory growing the machine instruction list.\n");
+            mf->failed = true;
+            return NULL;
+        }
+        if (mf->count > 0) {
+            memcpy(grown, mf->instructions, mf->count * sizeof(MachineInstruction));
+        }
+        arena_note_superseded(mf->arena, mf->capacity * sizeof(MachineInstruction), ARENA_TAG_MACHINE);
+        mf->instructions = grown;
+        mf->capacity = new_capacity;
+    }
+    return &mf->instructions[mf->count++];
+}
+
+void machine_emit(MachineFunction *mf, const MachineOpcode opcode, const MachineOperand first,
+                  const MachineOperand second) {
+    MachineInstruction *instr = append_instruction(mf);
+    if (!instr) {
+        return;
+    }
+    instr->opcode = opcode;
+    instr->condition = MACHINE_COND_E;
+    instr->operands[0] = first;
+    instr->operands[1] = second;
+}
+
+void machine_append(MachineFunction *mf, const MachineInstruction *instr) {
+    MachineInstruction *slot = append_instruction(mf);
+    if (slot) {
+        *slot = *instr;
+    }
+}
+
+void machine_emit_cond(MachineFunction *mf, const MachineOpcode opcode, const MachineCondition condition,
+                       const MachineOperand operand) {
+    MachineInstruction *instr = append_instruction(mf);
+    if (!instr) {
+        return;
+    }
+    instr->opcode = opcode;
+    instr->condition = condition;
+    instr->operands[0] = operand;
+    instr->operands[1] = machine_none();
+}
+
+// label_scope: NULL, or the function name appended to local labels
+static void print_operand(StringBuffer *sb, const MachineOperand *op, const char *label_scope) {
+    switch (op->kind) {
+        case MACHINE_OPERAND_REGISTER:
+            string_buffer_append_str(sb, register_names[op->width][op->value.reg]);
+            break;
+        case MACHINE_OPERAND_IMMEDIATE:
+            string_buffer_append_char(sb, '$');
+            string_buffer_append_int(sb, op->value.immediate);
+            break;
+        case MACHINE_OPERAND_STACK:
+            string_buffer_append_int(sb, op->value.stack_offset);
+            string_buffer_append_str(sb, "(%rbp)");
+            break;
+        case MACHINE_OPERAND_LABEL:
+            string_buffer_append_str(sb, op->value.label);
+            break;
+        case MACHINE_OPERAND_LOCAL_LABEL:
+            string_buffer_append_char(sb, 'L');
+            string_buffer_append_int(sb, op->value.label_id);
+            if (label_scope) {
+                string_buffer_append_char(sb, '_');
+                string_buffer_append_str(sb, label_scope);
+            }
+            break;
+        case MACHINE_OPERAND_ADDRESS:
+            if (op->value.address.displacement != 0) {
+                string_buffer_append_int(sb, op->value.address.displacement);
+            }
+            string_buffer_append_char(sb, '(');
+            string_buffer_append_str(sb, register_names[MACHINE_WIDTH_QUAD][op->value.address.base]);
+            string_buffer_append_char(sb, ')');
+            break;
+        case MACHINE_OPERAND_TEMP:
+            // Only seen when printing before temps are lowered (debugging)
+            string_buffer_append_char(sb, 't');
+            string_buffer_append_int(sb, op->value.temp_id);
+            break;
+        case MACHINE_OPERAND_NONE:
+            break;
+    }
+}
+
+static void print_instruction(StringBuffer *sb, const MachineInstruction *instr, const char *label_scope) {
+    string_buffer_append_str(sb, opcode_mnemonics[instr->opcode]);
+    switch (instr->opcode) {
+        case MACHINE_OP_FUNCTION_LABEL:
+        case MACHINE_OP_LABEL:
+            print_operand(sb, &instr->operands[0], label_scope);
+            string_buffer_append_str(sb, ":\n");
+            return;
+        case MACHINE_OP_SETCC:
+        case MACHINE_OP_JCC:
+            string_buffer_append_str(sb, condition_suffixes[instr->condition]);
+            string_buffer_append_char(sb, ' ');
+            break;
+        default:
+            break;
+    }
+    if (instr->operands[0].kind != MACHINE_OPERAND_NONE) {
+        print_operand(sb, &instr->operands[0], label_scope);
+        if (instr->operands[1].kind != MACHINE_OPERAND_NONE) {
+            string_buffer_append_str(sb, ", ");
+            print_operand(sb, &instr->operands[1], label_scope);
+        }
+    }
+    string_buffer_append_char(sb, '\n');
+}
+
+void machine_print_instruction(StringBuffer *sb, const MachineInstruction *instr) {
+    print_instruction(sb, instr, NULL);
+}
+
+void machine_print_function(StringBuffer *sb, const MachineFunction *mf) {
+    const char *label_scope = mf->qualify_labels ? mf->name : NULL;
+    for (size_t i = 0; i < mf->count; ++i) {
+        print_instruction(sb, &mf->instructions[i], label_scope);
+    }
+}
@@ -0,0 +1,296 @@
+#ifndef CLERIC_MACHINE_H
+#define CLERIC_MACHINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../memory/arena.h"
+#include "../strings/strings.h"
+
+//------------------------------------------------------------------------------
+// Typed x86-64 machine instructions
+//
+// Codegen lowers each TAC function into a MachineFunction (opcode + typed operands)
+// and a printer serializes it to AT&T syntax in a single pass. Passes that work on
+// machine code (peephole, register allocation) inspect the operand kinds directly
+// instead of re-parsing assembly text.
+//------------------------------------------------------------------------------
+
+// General-purpose registers, in hardware encoding order
+typedef enum {
+    MACHINE_REG_AX,
+    MACHINE_REG_CX,
+    MACHINE_REG_DX,
+    MACHINE_REG_BX,
+    MACHINE_REG_SP,
+    MACHINE_REG_BP,
+    MACHINE_REG_SI,
+    MACHINE_REG_DI,
+    MACHINE_REG_R8,
+    MACHINE_REG_R9,
+    MACHINE_REG_R10,
+    MACHINE_REG_R11,
+    MACHINE_REG_R12,
+    MACHINE_REG_R13,
+    MACHINE_REG_R14,
+    MACHINE_REG_R15,
+    MACHINE_REG_COUNT
+} MachineRegister;
+
+// Width a register operand is accessed with (selects %al / %eax / %rax)
+typedef enum {
+    MACHINE_WIDTH_BYTE,
+    MACHINE_WIDTH_LONG,
+    MACHINE_WIDTH_QUAD
+} MachineWidth;
+
+typedef enum {
+    MACHINE_OPERAND_NONE,
+    MACHINE_OPERAND_REGISTER,  // %reg at the given width
+    MACHINE_OPERAND_IMMEDIATE, // $value
+    MACHINE_OPERAND_STACK,     // offset(%rbp)
+    MACHINE_OPERAND_LABEL,     // Symbol name
+    MACHINE_OPERAND_LOCAL_LABEL, // Jump target: a TAC label id, printed as L<id>
+    MACHINE_OPERAND_ADDRESS,   // displacement(%reg), only as the leal source
+    MACHINE_OPERAND_TEMP       // TAC temporary not yet mapped to a register or stack slot
+} MachineOperandKind;
+
+typedef struct {
+    MachineOperandKind kind;
+    MachineWidth width; // For MACHINE_OPERAND_REGISTER
+    union {
+        MachineRegister reg;
+        int immediate;
+        int stack_offset; // Relative to %rbp (negative for locals)
+        const char *label;
+        uint32_t label_id;
+        int temp_id;
+        struct {
+            MachineRegister base;
+            int displacement;
+        } address;
+    } value;
+} MachineOperand;
+
+// Condition codes for setcc/jcc; Z/NZ print as such to match the test-and-branch idiom
+typedef enum {
+    MACHINE_COND_E,
+    MACHINE_COND_NE,
+    MACHINE_COND_L,
+    MACHINE_COND_LE,
+    MACHINE_COND_G,
+    MACHINE_COND_GE,
+    MACHINE_COND_Z,
+    MACHINE_COND_NZ
+} MachineCondition;
+
+typedef enum {
+    // Directives and labels (operand 0 is a label)
+    MACHINE_OP_GLOBL,          // .globl _symbol
+    MACHINE_OP_FUNCTION_LABEL, // _symbol:
+    MACHINE_OP_LABEL,          // label:
+
+    // 64-bit frame management
+    MACHINE_OP_PUSHQ,
+    MACHINE_OP_POPQ,
+    MACHINE_OP_MOVQ,
+    MACHINE_OP_SUBQ,
+    MACHINE_OP_LEAVE,
+    MACHINE_OP_RETQ,
+
+    // 32-bit integer operations
+    MACHINE_OP_MOVL,
+    MACHINE_OP_MOVZBL,
+    MACHINE_OP_ADDL,
+    MACHINE_OP_SUBL,
+    MACHINE_OP_IMULL,
+    MACHINE_OP_NEGL,
+    MACHINE_OP_NOTL,
+    MACHINE_OP_CMPL,
+    MACHINE_OP_TESTL,
+    MACHINE_OP_CLTD,
+    MACHINE_OP_IDIVL,
+    MACHINE_OP_IMULL_WIDE, // imull src: %edx:%eax = %eax * src (signed)
+    MACHINE_OP_SHLL,
+    MACHINE_OP_SARL,
+    MACHINE_OP_SHRL,
+    MACHINE_OP_ANDL,
+    MACHINE_OP_XORL, // Only as the zero idiom (xorl %reg, %reg), from the peephole pass
+    MACHINE_OP_INCL,
+    MACHINE_OP_DECL,
+    MACHINE_OP_LEAL, // leal disp(%base), %reg: an add that leaves the flags alone
+
+    // Byte operations on boolean results
+    MACHINE_OP_ANDB,
+    MACHINE_OP_ORB,
+
+    // Flag consumers (use MachineInstruction.condition)
+    MACHINE_OP_SETCC,
+    MACHINE_OP_JMP,
+    MACHINE_OP_JCC,
+
+    MACHINE_OP_COUNT
+} MachineOpcode;
+
+// One instruction; operands are in AT&T order (source first, destination last)
+typedef struct {
+    MachineOpcode opcode;
+    MachineCondition condition; // For MACHINE_OP_SETCC / MACHINE_OP_JCC
+    MachineOperand operands[2];
+} MachineInstruction;
+
+// Instruction list for one function; reused across functions by resetting it
+typedef struct {
+    const char *name;
+    MachineInstruction *instructions;
+    size_t count;
+    size_t capacity;
+    Arena *arena;
+    bool failed; // Set when an append could not allocate; the list is then incomplete
+    bool qualify_labels; // machine_print_function prints local labels as L<id>_<name>, unique across listings
+} MachineFunction;
+
+// --- Operand constructors ---
+
+static inline MachineOperand machine_none(void) {
+    MachineOperand op = {MACHINE_OPERAND_NONE, MACHINE_WIDTH_LONG, {0}};
+    return op;
+}
+
+static inline MachineOperand machine_reg(const MachineRegister reg, const MachineWidth width) {
+    MachineOperand op = {MACHINE_OPERAND_REGISTER, width, {0}};
+    op.value.reg = reg;
+    return op;
+}
+
+static inline MachineOperand machine_imm(const int value) {
+    MachineOperand op = {MACHINE_OPERAND_IMMEDIATE, MACHINE_WIDTH_LONG, {0}};
+    op.value.immediate = value;
+    return op;
+}
+
+static inline MachineOperand machine_stack(const int offset) {
+    MachineOperand op = {MACHINE_OPERAND_STACK, MACHINE_WIDTH_LONG, {0}};
+    op.value.stack_offset = offset;
+    return op;
+}
+
+static inline MachineOperand machine_label(const char *label) {
+    MachineOperand op = {MACHINE_OPERAND_LABEL, MACHINE_WIDTH_LONG, {0}};
+    op.value.label = label;
+    return op;
+}
+
+static inline MachineOperand machine_local_label(const uint32_t label_id) {
+    MachineOperand op = {MACHINE_OPERAND_LOCAL_LABEL, MACHINE_WIDTH_LONG, {0}};
+    op.value.label_id = label_id;
+    return op;
+}
+
+static inline MachineOperand machine_address(const MachineRegister base, const int displacement) {
+    MachineOperand op = {MACHINE_OPERAND_ADDRESS, MACHINE_WIDTH_QUAD, {0}};
+    op.value.address.base = base;
+    op.value.address.displacement = displacement;
+    return op;
+}
+
+static inline MachineOperand machine_temp(const int temp_id) {
+    MachineOperand op = {MACHINE_OPERAND_TEMP, MACHINE_WIDTH_LONG, {0}};
+    op.value.temp_id = temp_id;
+    return op;
+}
+
+// The condition that holds exactly when the given one does not
+static inline MachineCondition machine_condition_negate(const MachineCondition condition) {
+    switch (condition) {
+        case MACHINE_COND_E: return MACHINE_COND_NE;
+        case MACHINE_COND_NE: return MACHINE_COND_E;
+        case MACHINE_COND_L: return MACHINE_COND_GE;
+        case MACHINE_COND_LE: return MACHINE_COND_G;
+        case MACHINE_COND_G: return MACHINE_COND_LE;
+        case MACHINE_COND_GE: return MACHINE_COND_L;
+        case MACHINE_COND_Z: return MACHINE_COND_NZ;
+        case MACHINE_COND_NZ: return MACHINE_COND_Z;
+    }
+    return condition;
+}
+
+// The condition to test once the two cmpl operands trade places (a < b is b > a)
+static inline MachineCondition machine_condition_swap(const MachineCondition condition) {
+    switch (condition) {
+        case MACHINE_COND_L: return MACHINE_COND_G;
+        case MACHINE_COND_LE: return MACHINE_COND_GE;
+        case MACHINE_COND_G: return MACHINE_COND_L;
+        case MACHINE_COND_GE: return MACHINE_COND_LE;
+        default: return condition; // Equality tests are symmetric
+    }
+}
+
+static inline bool machine_operand_is_memory(const MachineOperand *op) {
+    return op->kind == MACHINE_OPERAND_STACK;
+}
+
+static inline bool machine_operands_equal(const MachineOperand *a, const MachineOperand *b) {
+    if (a->kind != b->kind) {
+        return false;
+    }
+    switch (a->kind) {
+        case MACHINE_OPERAND_REGISTER:
+            return a->value.reg == b->value.reg && a->width == b->width;
+        case MACHINE_OPERAND_IMMEDIATE:
+            return a->value.immediate == b->value.immediate;
+        case MACHINE_OPERAND_STACK:
+            return a->value.stack_offset == b->value.stack_offset;
+        case MACHINE_OPERAND_LABEL:
+            return a->value.label == b->value.label;
+        case MACHINE_OPERAND_LOCAL_LABEL:
+            return a->value.label_id == b->value.label_id;
+        case MACHINE_OPERAND_ADDRESS:
+            return a->value.address.base == b->value.address.base &&
+                   a->value.address.displacement == b->value.address.displacement;
+        case MACHINE_OPERAND_TEMP:
+            return a->value.temp_id == b->value.temp_id;
+        case MACHINE_OPERAND_NONE:
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Initializes an empty instruction list allocating from the given arena.
+ */
+void machine_function_init(MachineFunction *mf, Arena *arena);
+
+/**
+ * @brief Empties the list (keeping its capacity) and names it for the next function.
+ */
+void machine_function_reset(MachineFunction *mf, const char *name);
+
+/**
+ * @brief Appends an instruction with up to two operands (pass machine_none() for unused ones).
+ *        On allocation failure the instruction is dropped and mf->failed is set.
+ */
+void machine_emit(MachineFunction *mf, MachineOpcode opcode, MachineOperand first, MachineOperand second);
+
+/**
+ * @brief Appends a copy of an already built instruction.
+ */
+void machine_append(MachineFunction *mf, const MachineInstruction *instr);
+
+/**
+ * @brief Appends a setcc/jcc instruction with the given condition and operand.
+ */
+void machine_emit_cond(MachineFunction *mf, MachineOpcode opcode, MachineCondition condition, MachineOperand operand);
+
+/**
+ * @brief Serializes one instruction in AT&T syntax (with indentation and newline).
+ */
+void machine_print_instruction(StringBuffer *sb, const MachineInstruction *instr);
+
+/**
+ * @brief Serializes every instruction of the function, in order (local labels qualified with the
+ *        function's name when mf->qualify_labels is set).
+ */
+void machine_print_function(StringBuffer *sb, const MachineFunction *mf);
+
+#endif // CLERIC_MACHINE_H
@@ -0,0 +1,214 @@
+#include "object_writer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define OBJECT_TEXT_INITIAL_CAPACITY 4096
+#define OBJECT_SYMBOLS_INITIAL_CAPACITY 16
+
+// ELF64 constants (spelled out here so the writer does not depend on <elf.h>)
+#define ELF_HEADER_SIZE 64
+#define ELF_SECTION_HEADER_SIZE 64
+#define ELF_SYMBOL_SIZE 24
+#define ELF_TYPE_REL 1
+#define ELF_MACHINE_X86_64 62
+#define ELF_SECTION_PROGBITS 1
+#define ELF_SECTION_SYMTAB 2
+#define ELF_SECTION_STRTAB 3
+#define ELF_FLAG_ALLOC 0x2
+#define ELF_FLAG_EXECINSTR 0x4
+#define ELF_SYMBOL_GLOBAL_FUNC ((1 << 4) | 2) // STB_GLOBAL, STT_FUNC
+
+// Section indices, in the order the headers are written
+enum {
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    SECTION_NOTE_GNU_STACK,
+    SECTION_COUNT
+};
+
+// Section names, each followed by its NUL; the offsets below index into it
+static const char section_names[] = "\0.text\0.symtab\0.strtab\0.shstrtab\0.note.GNU-stack";
+static const uint32_t section_name_offsets[SECTION_COUNT] = {0, 1, 7, 15, 23, 33};
+
+void object_writer_init(ObjectWriter *object, Arena *arena) {
+    object->text = NULL;
+    object->text_size = 0;
+    object->text_capacity = 0;
+    object->symbols = NULL;
+    object->symbol_count = 0;
+    object->symbol_capacity = 0;
+    object->arena = arena;
+    object->failed = false;
+}
+
+uint8_t *object_writer_reserve_text(ObjectWriter *object, const size_t size) {
+    if (object->text_size + size > object->text_capacity) {
+        size_t new_capacity = object->text_capacity ? object->text_capacity : OBJECT_TEXT_INITIAL_CAPACITY;
+        while (new_capacity < object->text_size + size) {
+            new_capacity *= 2;
+        }
+        uint8_t *grown = arena_alloc(object->arena, new_capacity);
+        if (!grown) {
+            fprintf(stderr, "Codegen Error: Out of memory growing the object's .text section.\n");
+            object->failed = true;
+            return NULL;
+        }
+        if (object->text_size > 0) {
+            memcpy(grown, object->text, object->text_size);
+        }
+        object->text = grown;
+        object->text_capacity = new_capacity;
+    }
+    uint8_t *reserved = object->text + object->text_size;
+    object->text_size += size;
+    return reserved;
+}
+
+bool object_writer_add_function(ObjectWriter *object, const char *name, const size_t offset, const size_t size) {
+    if (object->symbol_count == object->symbol_capacity) {
+        const size_t new_capacity = object->symbol_capacity ? object->symbol_capacity * 2
+                                                            : OBJECT_SYMBOLS_INITIAL_CAPACITY;
+        ObjectSymbol *grown = arena_alloc(object->arena, new_capacity * sizeof(ObjectSymbol));
+        if (!grown) {
+            fprintf(stderr, "Codegen Error: Out of memory growing the object's symbol table.\n");
+            object->failed = true;
+            return false;
+        }
+        if (object->symbol_count > 0) {
+            memcpy(grown, object->symbols, object->symbol_count * sizeof(ObjectSymbol));
+        }
+        object->symbols = grown;
+        object->symbol_capacity = new_capacity;
+    }
+    object->symbols[object->symbol_count++] = (ObjectSymbol){name, offset, size};
+    return true;
+}
+
+// --- Little-endian field writers ---
+
+static void put_u16(uint8_t *out, const uint16_t value) {
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+}
+
+static void put_u32(uint8_t *out, const uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static void put_u64(uint8_t *out, const uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static size_t align_up(const size_t value, const size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void append_padding(StringBuffer *out, const size_t count) {
+    static const char zeros[16] = {0};
+    string_buffer_append_n(out, zeros, count);
+}
+
+static void append_section_header(StringBuffer *out, const int section, const uint32_t type, const uint64_t flags,
+                                  const size_t offset, const size_t size, const uint32_t link, const uint32_t info,
+                                  const uint64_t alignment, const uint64_t entry_size) {
+    uint8_t header[ELF_SECTION_HEADER_SIZE] = {0};
+    put_u32(header + 0, section_name_offsets[section]);
+    put_u32(header + 4, type);
+    put_u64(header + 8, flags);
+    put_u64(header + 16, 0); // sh_addr: not loaded at a fixed address
+    put_u64(header + 24, offset);
+    put_u64(header + 32, size);
+    put_u32(header + 40, link);
+    put_u32(header + 44, info);
+    put_u64(header + 48, alignment);
+    put_u64(header + 56, entry_size);
+    string_buffer_append_n(out, (const char *) header, sizeof(header));
+}
+
+bool object_writer_write_elf(const ObjectWriter *object, StringBuffer *out) {
+    if (object->failed) {
+        return false;
+    }
+
+    // Layout: header, .text, .symtab, .strtab, .shstrtab, section headers
+    size_t strtab_size = 1; // Leading empty name
+    for (size_t i = 0; i < object->symbol_count; ++i) {
+        strtab_size += 1 + strlen(object->symbols[i].name) + 1; // '_', the name, NUL
+    }
+    const size_t text_offset = ELF_HEADER_SIZE;
+    const size_t symtab_offset = align_up(text_offset + object->text_size, 8);
+    const size_t symtab_size = (object->symbol_count + 1) * ELF_SYMBOL_SIZE; // Plus the null symbol
+    const size_t strtab_offset = symtab_offset + symtab_size;
+    const size_t shstrtab_offset = strtab_offset + strtab_size;
+    const size_t section_headers_offset = align_up(shstrtab_offset + sizeof(section_names), 8);
+
+    uint8_t header[ELF_HEADER_SIZE] = {0x7f, 'E', 'L', 'F',
+                                       2, // ELFCLASS64
+                                       1, // ELFDATA2LSB
+                                       1, // EV_CURRENT
+                                       0}; // ELFOSABI_SYSV
+    put_u16(header + 16, ELF_TYPE_REL);
+    put_u16(header + 18, ELF_MACHINE_X86_64);
+    put_u32(header + 20, 1); // e_version
+    put_u64(header + 40, section_headers_offset);
+    put_u16(header + 52, ELF_HEADER_SIZE);
+    put_u16(header + 58, ELF_SECTION_HEADER_SIZE);
+    put_u16(header + 60, SECTION_COUNT);
+    put_u16(header + 62, SECTION_SHSTRTAB);
+    const size_t start = out->length;
+    string_buffer_append_n(out, (const char *) header, sizeof(header));
+
+    if (object->text_size > 0) {
+        string_buffer_append_n(out, (const char *) object->text, object->text_size);
+    }
+    append_padding(out, symtab_offset - (text_offset + object->text_size));
+
+    // .symtab: the null symbol, then one global function symbol per function
+    uint8_t symbol[ELF_SYMBOL_SIZE] = {0};
+    string_buffer_append_n(out, (const char *) symbol, sizeof(symbol));
+    uint32_t name_offset = 1;
+    for (size_t i = 0; i < object->symbol_count; ++i) {
+        const ObjectSymbol *function = &object->symbols[i];
+        put_u32(symbol + 0, name_offset);
+        symbol[4] = ELF_SYMBOL_GLOBAL_FUNC;
+        symbol[5] = 0; // Default visibility
+        put_u16(symbol + 6, SECTION_TEXT);
+        put_u64(symbol + 8, function->offset);
+        put_u64(symbol + 16, function->size);
+        string_buffer_append_n(out, (const char *) symbol, sizeof(symbol));
+        name_offset += (uint32_t) (1 + strlen(function->name) + 1);
+    }
+
+    // .strtab
+    string_buffer_append_char(out, '\0');
+    for (size_t i = 0; i < object->symbol_count; ++i) {
+        string_buffer_append_char(out, '_');
+        string_buffer_append_n(out, object->symbols[i].name, strlen(object->symbols[i].name) + 1);
+    }
+
+    // .shstrtab
+    string_buffer_append_n(out, section_names, sizeof(section_names));
+    append_padding(out, section_headers_offset - (shstrtab_offset + sizeof(section_names)));
+
+    append_section_header(out, SECTION_NULL, 0, 0, 0, 0, 0, 0, 0, 0);
+    append_section_header(out, SECTION_TEXT, ELF_SECTION_PROGBITS, ELF_FLAG_ALLOC | ELF_FLAG_EXECINSTR, text_offset,
+                          object->text_size, 0, 0, 16, 0);
+    // sh_link names the string table; sh_info is the index of the first global symbol
+    append_section_header(out, SECTION_SYMTAB, ELF_SECTION_SYMTAB, 0, symtab_offset, symtab_size, SECTION_STRTAB, 1,
+                          8, ELF_SYMBOL_SIZE);
+    append_section_header(out, SECTION_STRTAB, ELF_SECTION_STRTAB, 0, strtab_offset, strtab_size, 0, 0, 1, 0);
+    append_section_header(out, SECTION_SHSTRTAB, ELF_SECTION_STRTAB, 0, shstrtab_offset, sizeof(section_names), 0, 0,
+                          1, 0);
+    append_section_header(out, SECTION_NOTE_GNU_STACK, ELF_SECTION_PROGBITS, 0, section_headers_offset, 0, 0, 0, 1,
+                          0);
+
+    // A failed append leaves the buffer short; the image is only usable when complete
+    return out->length - start == section_headers_offset + SECTION_COUNT * ELF_SECTION_HEADER_SIZE;
+}
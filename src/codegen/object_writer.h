@@ -0,0 +1,62 @@
+#ifndef CLERIC_OBJECT_WRITER_H
+#define CLERIC_OBJECT_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../memory/arena.h"
+#include "../strings/strings.h"
+
+//------------------------------------------------------------------------------
+// Relocatable ELF64 object for x86-64
+//
+// The encoder appends every function's machine code to one .text section and
+// records a global symbol for it. Nothing the code generator emits refers to
+// another symbol, so the object needs no relocations: jumps are resolved by the
+// encoder within their function. The finished object holds .text, .symtab,
+// .strtab, .shstrtab and an empty .note.GNU-stack (no executable stack).
+//------------------------------------------------------------------------------
+
+// A function defined in .text
+typedef struct {
+    const char *name; // As in the TAC; written with the leading underscore the assembly gives it
+    size_t offset;    // Start within .text
+    size_t size;      // Bytes of machine code
+} ObjectSymbol;
+
+typedef struct {
+    uint8_t *text;
+    size_t text_size;
+    size_t text_capacity;
+    ObjectSymbol *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+    Arena *arena;
+    bool failed; // Set when an allocation failed; the object is then incomplete
+} ObjectWriter;
+
+/**
+ * @brief Initializes an empty object allocating from the given arena.
+ */
+void object_writer_init(ObjectWriter *object, Arena *arena);
+
+/**
+ * @brief Appends `size` bytes to .text and returns where to write them.
+ * @return The reserved bytes, or NULL if memory ran out (object->failed is then set).
+ */
+uint8_t *object_writer_reserve_text(ObjectWriter *object, size_t size);
+
+/**
+ * @brief Records a global function symbol covering text[offset, offset + size).
+ * @return false if memory ran out (object->failed is then set).
+ */
+bool object_writer_add_function(ObjectWriter *object, const char *name, size_t offset, size_t size);
+
+/**
+ * @brief Appends the complete ELF image to a buffer (it contains NUL bytes; use the buffer's
+ *        length, not its terminator).
+ * @return false if the object is incomplete or the image could not be built.
+ */
+bool object_writer_write_elf(const ObjectWriter *object, StringBuffer *out);
+
+#endif // CLERIC_OBJECT_WRITER_H
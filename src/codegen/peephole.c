@@ -0,0 +1,171 @@
+#include "peephole.h"
+
+// What a rule did to the window
+typedef enum {
+    PEEPHOLE_NO_MATCH,
+    PEEPHOLE_REWRITTEN,    // One of the two instructions was changed in place
+    PEEPHOLE_DROP_CURRENT, // The current instruction is redundant
+    PEEPHOLE_DROP_PREVIOUS // The previous instruction is redundant; the rules rerun on the new pair
+} PeepholeAction;
+
+// A rule sees the previous output instruction (NULL at the start), the current one,
+// and the instructions after it (read-only, for lookahead)
+typedef PeepholeAction (*PeepholeRuleFn)(MachineInstruction *prev, MachineInstruction *cur,
+                                         const MachineInstruction *rest, size_t rest_count);
+
+typedef struct {
+    const char *name;
+    PeepholeRuleFn apply;
+} PeepholeRuleEntry;
+
+static bool is_movl(const MachineInstruction *instr) {
+    return instr && instr->opcode == MACHINE_OP_MOVL;
+}
+
+static bool is_register(const MachineOperand *op) {
+    return op->kind == MACHINE_OPERAND_REGISTER;
+}
+
+static bool is_scratch_relay_register(const MachineOperand *op) {
+    return is_register(op) && op->value.reg == MACHINE_REG_R10 && op->width == MACHINE_WIDTH_LONG;
+}
+
+static bool writes_flags(const MachineOpcode opcode) {
+    switch (opcode) {
+        case MACHINE_OP_ADDL:
+        case MACHINE_OP_SUBL:
+        case MACHINE_OP_IMULL:
+        case MACHINE_OP_NEGL:
+        case MACHINE_OP_CMPL:
+        case MACHINE_OP_TESTL:
+        case MACHINE_OP_IDIVL:
+        case MACHINE_OP_IMULL_WIDE:
+        case MACHINE_OP_SHLL:
+        case MACHINE_OP_SARL:
+        case MACHINE_OP_SHRL:
+        case MACHINE_OP_ANDL:
+        case MACHINE_OP_ANDB:
+        case MACHINE_OP_ORB:
+        case MACHINE_OP_XORL:
+        case MACHINE_OP_INCL:
+        case MACHINE_OP_DECL:
+        case MACHINE_OP_SUBQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// The emitters consume flags right after setting them and never across a label or jump
+static bool flags_live_after(const MachineInstruction *rest, const size_t rest_count) {
+    for (size_t i = 0; i < rest_count; ++i) {
+        const MachineOpcode opcode = rest[i].opcode;
+        if (opcode == MACHINE_OP_SETCC || opcode == MACHINE_OP_JCC) {
+            return true;
+        }
+        if (writes_flags(opcode) || opcode == MACHINE_OP_LABEL || opcode == MACHINE_OP_JMP ||
+            opcode == MACHINE_OP_RETQ) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// --- Rules ---
+
+static PeepholeAction rule_store_load(MachineInstruction *prev, MachineInstruction *cur,
+                                      const MachineInstruction *rest, const size_t rest_count) {
+    (void) rest;
+    (void) rest_count;
+    if (!is_movl(prev) || !is_movl(cur) || !is_register(&prev->operands[0]) ||
+        !machine_operand_is_memory(&prev->operands[1]) ||
+        !machine_operands_equal(&prev->operands[1], &cur->operands[0]) || !is_register(&cur->operands[1])) {
+        return PEEPHOLE_NO_MATCH;
+    }
+    if (machine_operands_equal(&prev->operands[0], &cur->operands[1])) {
+        return PEEPHOLE_DROP_CURRENT; // The register still holds what was just stored
+    }
+    cur->operands[0] = prev->operands[0]; // Read the register instead of the slot
+    return PEEPHOLE_REWRITTEN;
+}
+
+// %r10d only ever carries a value from one movl to the next, so it is dead after the pair
+static PeepholeAction rule_scratch_relay(MachineInstruction *prev, MachineInstruction *cur,
+                                         const MachineInstruction *rest, const size_t rest_count) {
+    (void) rest;
+    (void) rest_count;
+    if (!is_movl(prev) || !is_movl(cur) || !is_scratch_relay_register(&prev->operands[1]) ||
+        !is_scratch_relay_register(&cur->operands[0]) ||
+        (machine_operand_is_memory(&prev->operands[0]) && machine_operand_is_memory(&cur->operands[1]))) {
+        return PEEPHOLE_NO_MATCH;
+    }
+    prev->operands[1] = cur->operands[1];
+    return PEEPHOLE_DROP_CURRENT;
+}
+
+static PeepholeAction rule_zero_idiom(MachineInstruction *prev, MachineInstruction *cur,
+                                      const MachineInstruction *rest, const size_t rest_count) {
+    (void) prev;
+    if (!is_movl(cur) || cur->operands[0].kind != MACHINE_OPERAND_IMMEDIATE || cur->operands[0].value.immediate != 0 ||
+        !is_register(&cur->operands[1]) || flags_live_after(rest, rest_count)) {
+        return PEEPHOLE_NO_MATCH;
+    }
+    cur->opcode = MACHINE_OP_XORL; // Shorter encoding, and a dependency-breaking idiom
+    cur->operands[0] = cur->operands[1];
+    return PEEPHOLE_REWRITTEN;
+}
+
+static PeepholeAction rule_jump_to_next(MachineInstruction *prev, MachineInstruction *cur,
+                                        const MachineInstruction *rest, const size_t rest_count) {
+    (void) rest;
+    (void) rest_count;
+    if (!prev || (prev->opcode != MACHINE_OP_JMP && prev->opcode != MACHINE_OP_JCC) ||
+        cur->opcode != MACHINE_OP_LABEL || !machine_operands_equal(&prev->operands[0], &cur->operands[0])) {
+        return PEEPHOLE_NO_MATCH;
+    }
+    return PEEPHOLE_DROP_PREVIOUS;
+}
+
+static const PeepholeRuleEntry peephole_rules[PEEPHOLE_RULE_COUNT] = {
+    [PEEPHOLE_RULE_STORE_LOAD] = {"store-load", rule_store_load},
+    [PEEPHOLE_RULE_SCRATCH_RELAY] = {"scratch-relay", rule_scratch_relay},
+    [PEEPHOLE_RULE_ZERO_IDIOM] = {"zero-idiom", rule_zero_idiom},
+    [PEEPHOLE_RULE_JUMP_TO_NEXT] = {"jump-to-next", rule_jump_to_next},
+};
+
+const char *peephole_rule_name(const PeepholeRule rule) {
+    return rule < PEEPHOLE_RULE_COUNT ? peephole_rules[rule].name : "unknown";
+}
+
+void peephole_optimize(MachineFunction *mf, PeepholeStats *stats) {
+    if (stats) {
+        stats->ran = true;
+    }
+    MachineInstruction *list = mf->instructions;
+    const size_t n = mf->count;
+    size_t out = 0; // list[0 .. out) is the output so far; it never overtakes the input index
+    for (size_t in = 0; in < n; ++in) {
+        MachineInstruction cur = list[in];
+        bool keep = true;
+        for (int r = 0; keep && r < PEEPHOLE_RULE_COUNT; ++r) {
+            MachineInstruction *prev = out > 0 ? &list[out - 1] : NULL;
+            const PeepholeAction action = peephole_rules[r].apply(prev, &cur, &list[in + 1], n - in - 1);
+            if (action == PEEPHOLE_NO_MATCH) {
+                continue;
+            }
+            if (stats) {
+                stats->hits[r]++;
+            }
+            if (action == PEEPHOLE_DROP_CURRENT) {
+                keep = false;
+            } else if (action == PEEPHOLE_DROP_PREVIOUS) {
+                out--;
+                r = -1; // Start over against the new previous instruction
+            }
+        }
+        if (keep) {
+            list[out++] = cur;
+        }
+    }
+    mf->count = out;
+}
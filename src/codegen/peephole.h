@@ -0,0 +1,46 @@
+#ifndef CLERIC_PEEPHOLE_H
+#define CLERIC_PEEPHOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "machine.h"
+
+//------------------------------------------------------------------------------
+// Peephole optimizer over the lowered machine instruction list
+//
+// A single forward pass keeps the instructions emitted so far as a stack; each
+// rule looks at the top of that stack (the previous instruction) and the
+// current one, and may rewrite either, drop the current one, or drop the
+// previous one, after which the rules run again on the new pair. Operands are
+// final locations (registers and stack slots), so the rules see what will
+// actually be printed.
+//------------------------------------------------------------------------------
+
+// Rule table order; also the order of the hit counters
+typedef enum {
+    PEEPHOLE_RULE_STORE_LOAD,   // movl R, M; movl M, R  -> movl R, M (and M -> R2 becomes R -> R2)
+    PEEPHOLE_RULE_SCRATCH_RELAY, // movl X, %r10d; movl %r10d, Y -> movl X, Y when one side is not memory
+    PEEPHOLE_RULE_ZERO_IDIOM,   // movl $0, %reg -> xorl %reg, %reg when the flags are dead
+    PEEPHOLE_RULE_JUMP_TO_NEXT, // jmp L / jcc L directly before L: is dropped
+    PEEPHOLE_RULE_COUNT
+} PeepholeRule;
+
+// Per-rule hit counters, accumulated over every function passed through the optimizer
+typedef struct {
+    bool ran; // Whether the pass ran at all (counters of zero are then meaningful)
+    size_t hits[PEEPHOLE_RULE_COUNT];
+} PeepholeStats;
+
+/**
+ * @brief Returns the display name of a rule ("store-load", ...).
+ */
+const char *peephole_rule_name(PeepholeRule rule);
+
+/**
+ * @brief Rewrites one function's instruction list in place with the rule table.
+ * @param mf The lowered instruction list (no virtual temps left).
+ * @param stats Receives the hit counts (may be NULL).
+ */
+void peephole_optimize(MachineFunction *mf, PeepholeStats *stats);
+
+#endif // CLERIC_PEEPHOLE_H
@@ -0,0 +1,282 @@
+#include "regalloc.h"
+#include "../ir/cfg.h"
+#include "../ir/liveness.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Allocation order: caller-saved registers first (free to use, nothing is called yet),
+// then callee-saved ones, which cost a save/restore pair in the prologue/epilogue
+static const MachineRegister allocatable_registers[REGALLOC_REGISTER_COUNT] = {
+    MACHINE_REG_SI, MACHINE_REG_DI, MACHINE_REG_R8, MACHINE_REG_R9, MACHINE_REG_R11,
+    MACHINE_REG_BX, MACHINE_REG_R12, MACHINE_REG_R13, MACHINE_REG_R14, MACHINE_REG_R15,
+};
+
+bool machine_register_is_callee_saved(const MachineRegister reg) {
+    switch (reg) {
+        case MACHINE_REG_BX:
+        case MACHINE_REG_SP:
+        case MACHINE_REG_BP:
+        case MACHINE_REG_R12:
+        case MACHINE_REG_R13:
+        case MACHINE_REG_R14:
+        case MACHINE_REG_R15:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// --- Live intervals ---
+
+// The temp in a slot, or -1 if the slot holds a constant or nothing
+static int temp_id_of(const TacInstruction *instr, const TacOperandSlot slot) {
+    return tac_slot_is_temp(instr, slot) ? tac_get_operand(instr, slot).value.temp_id : -1;
+}
+
+static void extend_interval(LiveInterval *interval, const int point) {
+    if (point < interval->start) {
+        interval->start = point;
+    }
+    if (point > interval->end) {
+        interval->end = point;
+    }
+}
+
+bool compute_live_intervals(const TacFunction *func, Arena *arena, LiveInterval **out_intervals, size_t *out_count,
+                            int *out_temp_count) {
+    *out_intervals = NULL;
+    *out_count = 0;
+    *out_temp_count = 0;
+    const size_t n = func->instruction_count;
+    if (n == 0) {
+        return true;
+    }
+    // The operand accessors hand out mutable pointers; nothing is written through them here
+    TacInstruction *instructions = func->instructions;
+
+    Cfg cfg;
+    Liveness liveness;
+    if (!cfg_build(func, arena, &cfg) || !liveness_compute(&cfg, arena, &liveness)) {
+        return false;
+    }
+    const int temp_count = liveness.temp_count;
+    if (temp_count == 0) {
+        return true;
+    }
+    LiveInterval *by_temp = arena_alloc(arena, (size_t) temp_count * sizeof(LiveInterval));
+    if (!by_temp) {
+        fprintf(stderr, "Codegen Error: Out of memory computing liveness for function %s.\n", func->name);
+        return false;
+    }
+
+    // Fold every occurrence and every block boundary a temp is live across into its interval
+    for (int t = 0; t < temp_count; ++t) {
+        by_temp[t].temp_id = t;
+        by_temp[t].start = INT_MAX;
+        by_temp[t].end = -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const TacInstruction *instr = &instructions[i];
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            const int id = temp_id_of(instr, (TacOperandSlot) (TAC_SLOT_SRC1 + u));
+            if (id >= 0) {
+                extend_interval(&by_temp[id], (int) (2 * i));
+            }
+        }
+        const int id = tac_instruction_has_def(instr) ? temp_id_of(instr, TAC_SLOT_DST) : -1;
+        if (id >= 0) {
+            extend_interval(&by_temp[id], (int) (2 * i + 1));
+        }
+    }
+    for (int b = 0; b < cfg.block_count; ++b) {
+        const uint64_t *live_in = liveness_in_of(&liveness, b);
+        const uint64_t *live_out = liveness_out_of(&liveness, b);
+        for (int t = 0; t < temp_count; ++t) {
+            if (liveness_set_contains(live_in, t)) {
+                extend_interval(&by_temp[t], (int) (2 * cfg.blocks[b].first));
+            }
+            if (liveness_set_contains(live_out, t)) {
+                extend_interval(&by_temp[t], (int) (2 * cfg.blocks[b].last + 1));
+            }
+        }
+    }
+
+    // Compact away the ids that never occur
+    size_t count = 0;
+    for (int t = 0; t < temp_count; ++t) {
+        if (by_temp[t].end >= 0) {
+            by_temp[count++] = by_temp[t];
+        }
+    }
+
+    *out_intervals = by_temp;
+    *out_count = count;
+    *out_temp_count = temp_count;
+    return true;
+}
+
+// --- Linear scan ---
+
+static int compare_interval_start(const void *a, const void *b) {
+    const LiveInterval *x = a;
+    const LiveInterval *y = b;
+    if (x->start != y->start) {
+        return x->start < y->start ? -1 : 1;
+    }
+    return x->temp_id < y->temp_id ? -1 : x->temp_id > y->temp_id;
+}
+
+// Inserts into `active`, which stays sorted by increasing end point
+static void insert_active(const LiveInterval **active, int *active_count, const LiveInterval *interval) {
+    int i = *active_count;
+    while (i > 0 && active[i - 1]->end > interval->end) {
+        active[i] = active[i - 1];
+        i--;
+    }
+    active[i] = interval;
+    (*active_count)++;
+}
+
+// Computes the intervals sorted by start and an empty location per temp
+static bool prepare_allocation(const TacFunction *func, Arena *arena, RegisterAllocation *out,
+                               LiveInterval **intervals, size_t *interval_count) {
+    memset(out, 0, sizeof(*out));
+    int temp_count;
+    if (!compute_live_intervals(func, arena, intervals, interval_count, &temp_count)) {
+        return false;
+    }
+    out->temp_count = temp_count;
+    if (temp_count == 0) {
+        return true;
+    }
+    out->locations = arena_alloc_zeroed(arena, (size_t) temp_count * sizeof(TempLocation));
+    if (!out->locations) {
+        fprintf(stderr, "Codegen Error: Out of memory allocating registers for function %s.\n", func->name);
+        return false;
+    }
+    qsort(*intervals, *interval_count, sizeof(LiveInterval), compare_interval_start);
+    return true;
+}
+
+// --- Stack-slot coloring ---
+
+/**
+ * Gives every interval already marked TEMP_LOCATION_STACK a slot, sharing slots between
+ * intervals that do not overlap. Scanning by start and reusing the lowest free slot is
+ * optimal for interval graphs: the slot count equals the peak number of live stack temps.
+ */
+static bool color_stack_slots(const LiveInterval *intervals, const size_t interval_count, Arena *arena,
+                              RegisterAllocation *out) {
+    out->spill_slot_count = 0;
+    int *slot_end = NULL; // Last point of the interval occupying each slot
+    for (size_t i = 0; i < interval_count; ++i) {
+        const LiveInterval *current = &intervals[i];
+        TempLocation *location = &out->locations[current->temp_id];
+        if (location->kind != TEMP_LOCATION_STACK) {
+            continue;
+        }
+        if (!slot_end) {
+            // At most one slot per interval
+            slot_end = arena_alloc(arena, interval_count * sizeof(int));
+            if (!slot_end) {
+                fprintf(stderr, "Codegen Error: Out of memory assigning stack slots.\n");
+                return false;
+            }
+        }
+        int slot = 0;
+        while (slot < out->spill_slot_count && slot_end[slot] >= current->start) {
+            slot++;
+        }
+        if (slot == out->spill_slot_count) {
+            out->spill_slot_count++;
+        }
+        slot_end[slot] = current->end;
+        location->spill_slot = slot;
+    }
+    return true;
+}
+
+bool pack_stack_slots(const TacFunction *func, Arena *arena, RegisterAllocation *out) {
+    LiveInterval *intervals;
+    size_t interval_count;
+    if (!prepare_allocation(func, arena, out, &intervals, &interval_count)) {
+        return false;
+    }
+    for (size_t i = 0; i < interval_count; ++i) {
+        out->locations[intervals[i].temp_id].kind = TEMP_LOCATION_STACK;
+    }
+    return color_stack_slots(intervals, interval_count, arena, out);
+}
+
+bool allocate_registers(const TacFunction *func, Arena *arena, RegisterAllocation *out) {
+    LiveInterval *intervals;
+    size_t interval_count;
+    if (!prepare_allocation(func, arena, out, &intervals, &interval_count)) {
+        return false;
+    }
+    if (out->temp_count == 0) {
+        return true;
+    }
+
+    const LiveInterval *active[REGALLOC_REGISTER_COUNT];
+    int active_count = 0;
+    bool register_free[MACHINE_REG_COUNT] = {false};
+    for (int r = 0; r < REGALLOC_REGISTER_COUNT; ++r) {
+        register_free[allocatable_registers[r]] = true;
+    }
+
+    for (size_t i = 0; i < interval_count; ++i) {
+        const LiveInterval *current = &intervals[i];
+        TempLocation *location = &out->locations[current->temp_id];
+
+        // Expire intervals that ended before this one starts, handing their registers back
+        int kept = 0;
+        for (int a = 0; a < active_count; ++a) {
+            if (active[a]->end < current->start) {
+                register_free[out->locations[active[a]->temp_id].reg] = true;
+            } else {
+                active[kept++] = active[a];
+            }
+        }
+        active_count = kept;
+
+        if (active_count == REGALLOC_REGISTER_COUNT) {
+            // Under pressure: spill whichever interval reaches furthest
+            const LiveInterval *furthest = active[active_count - 1];
+            if (furthest->end > current->end) {
+                TempLocation *evicted = &out->locations[furthest->temp_id];
+                location->kind = TEMP_LOCATION_REGISTER;
+                location->reg = evicted->reg;
+                evicted->kind = TEMP_LOCATION_STACK;
+                active_count--;
+                insert_active(active, &active_count, current);
+            } else {
+                location->kind = TEMP_LOCATION_STACK;
+            }
+            continue;
+        }
+
+        for (int r = 0; r < REGALLOC_REGISTER_COUNT; ++r) {
+            if (register_free[allocatable_registers[r]]) {
+                location->kind = TEMP_LOCATION_REGISTER;
+                location->reg = allocatable_registers[r];
+                register_free[location->reg] = false;
+                break;
+            }
+        }
+        insert_active(active, &active_count, current);
+    }
+
+    for (int t = 0; t < out->temp_count; ++t) {
+        if (out->locations[t].kind == TEMP_LOCATION_REGISTER &&
+            machine_register_is_callee_saved(out->locations[t].reg)) {
+            out->callee_saved_used[out->locations[t].reg] = true;
+        }
+    }
+    // Spilled temps whose intervals do not overlap share a slot
+    return color_stack_slots(intervals, interval_count, arena, out);
+}
@@ -0,0 +1,88 @@
+#ifndef CLERIC_REGALLOC_H
+#define CLERIC_REGALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+#include "machine.h"
+
+//------------------------------------------------------------------------------
+// Linear-scan register allocation (Poletto & Sarkar) over TAC temporaries
+//
+// Liveness is computed per basic block of the function's CFG (ir/cfg.h), then
+// each temp gets one interval [first point live, last point live]. Program points are doubled so that the
+// uses of instruction i (point 2i) come before its definition (point 2i + 1):
+// a temp whose last use is in i can hand its register to the temp i defines.
+//
+// %eax, %ecx, %edx and %r10d are never handed out: the instruction emitters
+// use them as fixed scratch registers.
+//------------------------------------------------------------------------------
+
+typedef enum {
+    TEMP_LOCATION_NONE,     // Temp does not occur in the function
+    TEMP_LOCATION_REGISTER, // Lives in `reg` for its whole interval
+    TEMP_LOCATION_STACK     // Spilled to `spill_slot`, shared with temps whose intervals do not overlap
+} TempLocationKind;
+
+typedef struct {
+    TempLocationKind kind;
+    MachineRegister reg;
+    int spill_slot; // 0-based index; codegen turns it into an %rbp offset
+} TempLocation;
+
+// Live interval of one temp, in doubled program points
+typedef struct {
+    int temp_id;
+    int start;
+    int end;
+} LiveInterval;
+
+typedef struct {
+    TempLocation *locations; // Indexed by temp id, `temp_count` entries
+    int temp_count;
+    int spill_slot_count;    // Frame slots used by stack temps after coloring
+    bool callee_saved_used[MACHINE_REG_COUNT]; // Callee-saved registers the function must save and restore
+} RegisterAllocation;
+
+// Number of registers available to temps
+#define REGALLOC_REGISTER_COUNT 10
+
+/**
+ * @brief Tells whether the System V ABI requires a function to preserve the register.
+ */
+bool machine_register_is_callee_saved(MachineRegister reg);
+
+/**
+ * @brief Computes one live interval per temp that occurs in the function.
+ * @param func The function to analyze.
+ * @param arena Arena for the result and scratch data (callers typically release it per function).
+ * @param out_intervals Receives an array ordered by temp id (temps that do not occur are omitted).
+ * @param out_count Receives the number of intervals.
+ * @param out_temp_count Receives one more than the highest temp id (0 if there are none).
+ * @return false if memory ran out.
+ */
+bool compute_live_intervals(const TacFunction *func, Arena *arena, LiveInterval **out_intervals, size_t *out_count,
+                            int *out_temp_count);
+
+/**
+ * @brief Keeps every temp on the stack, packing temps with disjoint live intervals into shared slots.
+ *        The frame then follows the peak number of live temps instead of the highest temp id.
+ * @param func The function to lay out.
+ * @param arena Arena for the result and scratch data.
+ * @param out Receives the layout (every location is TEMP_LOCATION_STACK).
+ * @return false if memory ran out (an error has been printed).
+ */
+bool pack_stack_slots(const TacFunction *func, Arena *arena, RegisterAllocation *out);
+
+/**
+ * @brief Assigns every temp a register, spilling the interval that ends last when none is free.
+ *        Spilled temps are packed into shared slots like pack_stack_slots does.
+ * @param func The function to allocate.
+ * @param arena Arena for the result and scratch data.
+ * @param out Receives the allocation.
+ * @return false if memory ran out (an error has been printed).
+ */
+bool allocate_registers(const TacFunction *func, Arena *arena, RegisterAllocation *out);
+
+#endif // CLERIC_REGALLOC_H
@@ -0,0 +1,145 @@
+#include "strength_reduction.h"
+#include <stdint.h>
+
+#define EAX machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_LONG)
+#define ECX machine_reg(MACHINE_REG_CX, MACHINE_WIDTH_LONG)
+#define EDX machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_LONG)
+#define NONE machine_none()
+
+static uint32_t magnitude(const int value) {
+    return value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+}
+
+// log2 of value if it is a power of two, else -1
+static int power_of_two_exponent(const uint32_t value) {
+    if (value == 0 || (value & (value - 1)) != 0) {
+        return -1;
+    }
+    int exponent = 0;
+    while ((value >> exponent) != 1) {
+        exponent++;
+    }
+    return exponent;
+}
+
+bool signed_division_magic(const int divisor, DivisionMagic *out) {
+    const uint32_t two31 = 0x80000000u;
+    const uint32_t ad = magnitude(divisor);
+    if (ad < 2) {
+        return false;
+    }
+    const uint32_t t = two31 + ((uint32_t) divisor >> 31);
+    const uint32_t anc = t - 1 - t % ad; // Absolute value of nc
+    int p = 31;
+    uint32_t q1 = two31 / anc; // 2^p / |nc|
+    uint32_t r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad; // 2^p / |d|
+    uint32_t r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    const uint32_t multiplier = q2 + 1;
+    out->multiplier = (int) (divisor < 0 ? 0u - multiplier : multiplier);
+    out->shift = p - 32;
+    return true;
+}
+
+bool emit_multiply_by_constant(MachineFunction *mf, const MachineOperand src, const int factor,
+                               const MachineOperand dst) {
+    const int exponent = power_of_two_exponent(magnitude(factor));
+    if (exponent < 1) {
+        return false;
+    }
+    machine_emit(mf, MACHINE_OP_MOVL, src, EAX);
+    machine_emit(mf, MACHINE_OP_SHLL, machine_imm(exponent), EAX);
+    if (factor < 0) {
+        machine_emit(mf, MACHINE_OP_NEGL, EAX, NONE); // Also right for INT_MIN, where x << 31 is its own negation
+    }
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
+    return true;
+}
+
+// %eax = x, %edx = 2^k - 1 if x is negative else 0
+static void emit_rounding_bias(MachineFunction *mf, const MachineOperand dividend, const int exponent) {
+    machine_emit(mf, MACHINE_OP_MOVL, dividend, EAX);
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, EDX);
+    if (exponent > 1) {
+        machine_emit(mf, MACHINE_OP_SARL, machine_imm(31), EDX); // All ones if negative
+    }
+    machine_emit(mf, MACHINE_OP_SHRL, machine_imm(32 - exponent), EDX);
+}
+
+static void emit_power_of_two_division(MachineFunction *mf, const MachineOperand dividend, const int divisor,
+                                       const int exponent, const bool remainder, const MachineOperand dst) {
+    emit_rounding_bias(mf, dividend, exponent);
+    machine_emit(mf, MACHINE_OP_ADDL, EDX, EAX);
+    if (remainder) {
+        // ((x + bias) & (2^k - 1)) - bias; the sign of the divisor does not matter
+        machine_emit(mf, MACHINE_OP_ANDL, machine_imm((int) ((1u << exponent) - 1)), EAX);
+        machine_emit(mf, MACHINE_OP_SUBL, EDX, EAX);
+    } else {
+        machine_emit(mf, MACHINE_OP_SARL, machine_imm(exponent), EAX);
+        if (divisor < 0) {
+            machine_emit(mf, MACHINE_OP_NEGL, EAX, NONE);
+        }
+    }
+    machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
+}
+
+static void emit_magic_division(MachineFunction *mf, const MachineOperand dividend, const int divisor,
+                                const bool remainder, const MachineOperand dst) {
+    DivisionMagic magic;
+    signed_division_magic(divisor, &magic);
+    machine_emit(mf, MACHINE_OP_MOVL, dividend, ECX);
+    machine_emit(mf, MACHINE_OP_MOVL, machine_imm(magic.multiplier), EAX);
+    machine_emit(mf, MACHINE_OP_IMULL_WIDE, ECX, NONE); // %edx = high half of multiplier * x
+    if (divisor > 0 && magic.multiplier < 0) {
+        machine_emit(mf, MACHINE_OP_ADDL, ECX, EDX);
+    } else if (divisor < 0 && magic.multiplier > 0) {
+        machine_emit(mf, MACHINE_OP_SUBL, ECX, EDX);
+    }
+    if (magic.shift > 0) {
+        machine_emit(mf, MACHINE_OP_SARL, machine_imm(magic.shift), EDX);
+    }
+    // Round toward zero: add 1 to a negative quotient
+    machine_emit(mf, MACHINE_OP_MOVL, EDX, EAX);
+    machine_emit(mf, MACHINE_OP_SHRL, machine_imm(31), EAX);
+    machine_emit(mf, MACHINE_OP_ADDL, EAX, EDX);
+    if (remainder) {
+        machine_emit(mf, MACHINE_OP_IMULL, machine_imm(divisor), EDX); // q * d
+        machine_emit(mf, MACHINE_OP_MOVL, ECX, EAX);
+        machine_emit(mf, MACHINE_OP_SUBL, EDX, EAX); // x - q * d
+        machine_emit(mf, MACHINE_OP_MOVL, EAX, dst);
+    } else {
+        machine_emit(mf, MACHINE_OP_MOVL, EDX, dst);
+    }
+}
+
+bool emit_divide_by_constant(MachineFunction *mf, const MachineOperand dividend, const int divisor,
+                             const bool remainder, const MachineOperand dst) {
+    if (divisor == 0 || divisor == 1 || divisor == -1) {
+        return false; // Trapping cases stay with idivl; x / 1 is left to constant folding
+    }
+    const int exponent = power_of_two_exponent(magnitude(divisor));
+    if (exponent > 0) {
+        emit_power_of_two_division(mf, dividend, divisor, exponent, remainder, dst);
+    } else {
+        emit_magic_division(mf, dividend, divisor, remainder, dst);
+    }
+    return true;
+}
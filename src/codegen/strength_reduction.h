@@ -0,0 +1,48 @@
+#ifndef CLERIC_STRENGTH_REDUCTION_H
+#define CLERIC_STRENGTH_REDUCTION_H
+
+#include <stdbool.h>
+#include "machine.h"
+
+//------------------------------------------------------------------------------
+// Strength reduction of multiplication, division and remainder by constants
+//
+// x * 2^k becomes a shift. x / d and x % d round toward zero like idivl:
+// powers of two add a bias of 2^k - 1 to negative dividends before shifting,
+// and any other divisor multiplies by a "magic" reciprocal, keeps the high
+// half and corrects the sign (Hacker's Delight, chapter 10). The sequences
+// only use %eax, %ecx and %edx, which register allocation leaves free.
+//------------------------------------------------------------------------------
+
+// Multiplier and post-shift for signed division by a constant:
+// q = hi32(multiplier * x) (+/- x, see below) >> shift, plus 1 if that is negative
+typedef struct {
+    int multiplier;
+    int shift;
+} DivisionMagic;
+
+/**
+ * @brief Computes the magic number for signed 32-bit division by a constant.
+ *        When the divisor is positive and the multiplier negative, x is added to the high half;
+ *        when the divisor is negative and the multiplier positive, x is subtracted.
+ * @param divisor Any divisor with |divisor| >= 2.
+ * @param out Receives the multiplier and shift.
+ * @return false for 0, 1 and -1.
+ */
+bool signed_division_magic(int divisor, DivisionMagic *out);
+
+/**
+ * @brief Emits dst = src * factor with shifts, if the factor allows it (+/- a power of two).
+ * @return false if nothing was emitted: the caller should use imull.
+ */
+bool emit_multiply_by_constant(MachineFunction *mf, MachineOperand src, int factor, MachineOperand dst);
+
+/**
+ * @brief Emits dst = dividend / divisor (or % when remainder is set) without idivl.
+ *        Divisors 0 and -1 are refused so the program traps exactly where idivl would.
+ * @return false if nothing was emitted: the caller should use idivl.
+ */
+bool emit_divide_by_constant(MachineFunction *mf, MachineOperand dividend, int divisor, bool remainder,
+                             MachineOperand dst);
+
+#endif // CLERIC_STRENGTH_REDUCTION_H
@@ -0,0 +1,192 @@
+#include "value_cache.h"
+#include <string.h>
+
+// Value held by a location: 0 when unknown, a counter for computed values,
+// and the immediate itself above bit 32 for constants
+typedef uint64_t CachedValue;
+
+#define VALUE_UNKNOWN 0u
+#define VALUE_IMMEDIATE_TAG ((CachedValue) 1 << 32)
+
+// Stack slots are 4-byte aligned below %rbp; a slot's entry counts only if it was
+// written during the current block, so starting a block clears nothing
+typedef struct {
+    CachedValue registers[MACHINE_REG_COUNT];
+    CachedValue *slots;
+    uint32_t *slot_blocks;
+    size_t slot_count;
+    uint32_t block;
+    CachedValue next_value;
+} ValueCache;
+
+static void start_block(ValueCache *cache) {
+    memset(cache->registers, 0, sizeof(cache->registers));
+    cache->block++;
+}
+
+// Index of a tracked stack slot, or -1 for memory the cache does not follow
+static long slot_index(const ValueCache *cache, const MachineOperand *op) {
+    const int offset = op->value.stack_offset;
+    if (offset >= 0 || offset % 4 != 0 || (size_t) (-offset / 4) >= cache->slot_count) {
+        return -1;
+    }
+    return -offset / 4;
+}
+
+// Registers and slots count as holding a value only when accessed as 32 bits
+static CachedValue value_of(const ValueCache *cache, const MachineOperand *op) {
+    if (op->kind == MACHINE_OPERAND_IMMEDIATE) {
+        return VALUE_IMMEDIATE_TAG | (uint32_t) op->value.immediate;
+    }
+    if (op->kind == MACHINE_OPERAND_REGISTER) {
+        return op->width == MACHINE_WIDTH_LONG ? cache->registers[op->value.reg] : VALUE_UNKNOWN;
+    }
+    if (op->kind == MACHINE_OPERAND_STACK) {
+        const long slot = slot_index(cache, op);
+        return slot >= 0 && cache->slot_blocks[slot] == cache->block ? cache->slots[slot] : VALUE_UNKNOWN;
+    }
+    return VALUE_UNKNOWN;
+}
+
+static void set_value(ValueCache *cache, const MachineOperand *op, const CachedValue value) {
+    if (op->kind == MACHINE_OPERAND_REGISTER) {
+        cache->registers[op->value.reg] = op->width == MACHINE_WIDTH_LONG ? value : VALUE_UNKNOWN;
+    } else if (op->kind == MACHINE_OPERAND_STACK) {
+        const long slot = slot_index(cache, op);
+        if (slot >= 0) {
+            cache->slots[slot] = value;
+            cache->slot_blocks[slot] = cache->block;
+        }
+        if (op->width == MACHINE_WIDTH_QUAD && slot >= 1) {
+            cache->slots[slot - 1] = VALUE_UNKNOWN; // movq also overwrites the slot above
+        }
+    }
+}
+
+// The value of a location, numbered now if nothing was known about it, so a copy can share it
+static CachedValue number_value(ValueCache *cache, const MachineOperand *op) {
+    CachedValue value = value_of(cache, op);
+    if (value == VALUE_UNKNOWN && (op->kind == MACHINE_OPERAND_REGISTER || op->kind == MACHINE_OPERAND_STACK)) {
+        value = cache->next_value++;
+        set_value(cache, op, value);
+        value = value_of(cache, op); // Still unknown for a byte register or an untracked slot
+    }
+    return value;
+}
+
+static void clobber(ValueCache *cache, const MachineOperand *op) {
+    set_value(cache, op, VALUE_UNKNOWN);
+}
+
+// A register other than the frame registers holding a value, or -1
+static int register_holding(const ValueCache *cache, const CachedValue value) {
+    for (int r = 0; r < MACHINE_REG_COUNT; ++r) {
+        if (r != MACHINE_REG_SP && r != MACHINE_REG_BP && cache->registers[r] == value) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+// Applies a movl to the cache; false if it moves nothing new and can be dropped
+static bool cache_move(ValueCache *cache, MachineInstruction *instr, size_t *rewritten) {
+    MachineOperand *src = &instr->operands[0];
+    const MachineOperand *dst = &instr->operands[1];
+    const CachedValue value = number_value(cache, src);
+    if (value != VALUE_UNKNOWN && value_of(cache, dst) == value) {
+        return false;
+    }
+    if (value != VALUE_UNKNOWN && src->kind == MACHINE_OPERAND_STACK && dst->kind == MACHINE_OPERAND_REGISTER) {
+        const int holder = register_holding(cache, value);
+        if (holder >= 0) {
+            *src = machine_reg((MachineRegister) holder, MACHINE_WIDTH_LONG);
+            (*rewritten)++;
+        }
+    }
+    if (value == VALUE_UNKNOWN) {
+        clobber(cache, dst);
+    } else {
+        set_value(cache, dst, value);
+    }
+    return true;
+}
+
+// Forgets what every instruction other than movl writes, implicit operands included
+static void cache_other(ValueCache *cache, const MachineInstruction *instr) {
+    switch (instr->opcode) {
+        case MACHINE_OP_GLOBL:
+        case MACHINE_OP_FUNCTION_LABEL:
+        case MACHINE_OP_LABEL:
+        case MACHINE_OP_JMP:
+        case MACHINE_OP_LEAVE:
+        case MACHINE_OP_RETQ:
+            start_block(cache);
+            break;
+        case MACHINE_OP_CLTD:
+            cache->registers[MACHINE_REG_DX] = VALUE_UNKNOWN;
+            break;
+        case MACHINE_OP_IDIVL:
+        case MACHINE_OP_IMULL_WIDE:
+            cache->registers[MACHINE_REG_AX] = VALUE_UNKNOWN;
+            cache->registers[MACHINE_REG_DX] = VALUE_UNKNOWN;
+            break;
+        case MACHINE_OP_NEGL:
+        case MACHINE_OP_NOTL:
+        case MACHINE_OP_INCL:
+        case MACHINE_OP_DECL:
+        case MACHINE_OP_SETCC:
+        case MACHINE_OP_POPQ:
+            clobber(cache, &instr->operands[0]);
+            break;
+        case MACHINE_OP_CMPL:
+        case MACHINE_OP_TESTL:
+        case MACHINE_OP_JCC:
+        case MACHINE_OP_PUSHQ:
+            break;
+        default:
+            clobber(cache, &instr->operands[1]); // Two-operand forms write their destination
+            break;
+    }
+}
+
+size_t cache_register_values(MachineFunction *mf, Arena *scratch) {
+    // Size the slot table to the deepest slot the function addresses
+    size_t slot_count = 1;
+    for (size_t i = 0; i < mf->count; ++i) {
+        for (int o = 0; o < 2; ++o) {
+            const MachineOperand *op = &mf->instructions[i].operands[o];
+            if (op->kind == MACHINE_OPERAND_STACK && op->value.stack_offset < 0 &&
+                (size_t) (-op->value.stack_offset / 4) >= slot_count) {
+                slot_count = (size_t) (-op->value.stack_offset / 4) + 1;
+            }
+        }
+    }
+    const ArenaMark mark = arena_mark(scratch);
+    ValueCache cache = {.slot_count = slot_count, .next_value = 1};
+    cache.slots = arena_alloc(scratch, slot_count * sizeof(CachedValue));
+    cache.slot_blocks = arena_alloc(scratch, slot_count * sizeof(uint32_t));
+    if (!cache.slots || !cache.slot_blocks) {
+        arena_release(scratch, mark);
+        return 0; // Only an optimization: the list stays as it is
+    }
+    memset(cache.slot_blocks, 0, slot_count * sizeof(uint32_t));
+    start_block(&cache);
+
+    size_t changes = 0;
+    size_t out = 0;
+    for (size_t in = 0; in < mf->count; ++in) {
+        MachineInstruction instr = mf->instructions[in];
+        if (instr.opcode == MACHINE_OP_MOVL) {
+            if (!cache_move(&cache, &instr, &changes)) {
+                changes++;
+                continue;
+            }
+        } else {
+            cache_other(&cache, &instr);
+        }
+        mf->instructions[out++] = instr;
+    }
+    mf->count = out;
+    arena_release(scratch, mark);
+    return changes;
+}
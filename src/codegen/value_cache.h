@@ -0,0 +1,30 @@
+#ifndef CLERIC_VALUE_CACHE_H
+#define CLERIC_VALUE_CACHE_H
+
+#include <stddef.h>
+#include "machine.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Register value cache over the lowered machine instruction list
+//
+// Walks each basic block remembering which value every register and stack slot
+// holds: a movl copies the value of its source into its destination, and any
+// other write gives the destination a value of its own. A movl whose
+// destination already holds its source's value is dropped, and a load from a
+// slot whose value is still in some register becomes a register copy. So
+// `movl %eax, -8(%rbp) ... movl -8(%rbp), %eax` loses the reload, and the
+// relay `movl %eax, %esi; movl %esi, %eax` loses its second half. Everything
+// is forgotten at labels and unconditional jumps; the fall-through of a jcc
+// keeps what was known before it.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Drops and rewrites redundant moves of one function in place.
+ * @param mf The lowered instruction list (no virtual temps left).
+ * @param scratch Arena for the slot table (released before returning).
+ * @return How many moves were dropped or turned into register copies.
+ */
+size_t cache_register_values(MachineFunction *mf, Arena *scratch);
+
+#endif // CLERIC_VALUE_CACHE_H
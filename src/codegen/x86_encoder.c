@@ -0,0 +1,473 @@
+#include "x86_encoder.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Bytes of one instruction while it is being encoded
+typedef struct {
+    uint8_t bytes[X86_MAX_INSTRUCTION_LENGTH];
+    size_t length;
+} Encoding;
+
+// Where an instruction ends up in .text
+typedef struct {
+    uint32_t offset;
+    uint8_t size;
+    bool long_branch; // JMP/JCC: the rel32 form (jumps start out as rel8 and only ever grow)
+} InstructionLayout;
+
+// Condition codes in the tttn encoding of setcc/jcc, indexed by MachineCondition
+static const uint8_t condition_codes[] = {
+    [MACHINE_COND_E] = 0x4, [MACHINE_COND_NE] = 0x5, [MACHINE_COND_L] = 0xC,  [MACHINE_COND_LE] = 0xE,
+    [MACHINE_COND_G] = 0xF, [MACHINE_COND_GE] = 0xD, [MACHINE_COND_Z] = 0x4, [MACHINE_COND_NZ] = 0x5,
+};
+
+// Register field values, also the opcode extensions (/digit) of the group opcodes
+enum { ALU_ADD = 0, ALU_OR = 1, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 };
+enum { SHIFT_SHL = 4, SHIFT_SHR = 5, SHIFT_SAR = 7 };
+enum { UNARY_NOT = 2, UNARY_NEG = 3, UNARY_IMUL = 5, UNARY_IDIV = 7 };
+
+static void put_byte(Encoding *e, const uint8_t byte) {
+    e->bytes[e->length++] = byte;
+}
+
+static void put_imm32(Encoding *e, const int32_t value) {
+    const uint32_t bits = (uint32_t) value;
+    for (int i = 0; i < 4; ++i) {
+        put_byte(e, (uint8_t) (bits >> (8 * i)));
+    }
+}
+
+static bool fits_int8(const long value) {
+    return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+static bool is_register(const MachineOperand *op, const MachineRegister reg) {
+    return op->kind == MACHINE_OPERAND_REGISTER && op->value.reg == reg;
+}
+
+// %spl, %bpl, %sil and %dil only exist with a REX prefix (without one the encodings mean %ah..%bh)
+static bool needs_rex_for_byte(const MachineOperand *op) {
+    return op && op->kind == MACHINE_OPERAND_REGISTER && op->width == MACHINE_WIDTH_BYTE &&
+           op->value.reg >= MACHINE_REG_SP && op->value.reg <= MACHINE_REG_DI;
+}
+
+/**
+ * @brief Encodes [REX] opcode ModRM [SIB] [displacement].
+ * @param wide Sets REX.W (64-bit operand size).
+ * @param reg_operand Register in the ModRM reg field, or NULL to put `digit` (an opcode extension) there.
+ * @param rm Register or memory operand of the r/m field.
+ * @return false if `rm` is not a register or memory operand.
+ */
+static bool encode_modrm(Encoding *e, const bool wide, const uint8_t *opcode, const size_t opcode_length,
+                         const MachineOperand *reg_operand, const int digit, const MachineOperand *rm) {
+    const int reg = reg_operand ? (int) reg_operand->value.reg : digit;
+    MachineRegister base;
+    int displacement = 0;
+    bool memory = true;
+    switch (rm->kind) {
+        case MACHINE_OPERAND_REGISTER:
+            base = rm->value.reg;
+            memory = false;
+            break;
+        case MACHINE_OPERAND_STACK:
+            base = MACHINE_REG_BP;
+            displacement = rm->value.stack_offset;
+            break;
+        case MACHINE_OPERAND_ADDRESS:
+            base = rm->value.address.base;
+            displacement = rm->value.address.displacement;
+            break;
+        default:
+            return false;
+    }
+
+    uint8_t rex = 0;
+    if (wide) rex |= 0x08;
+    if (reg & 8) rex |= 0x04;
+    if (base & 8) rex |= 0x01;
+    if (rex || needs_rex_for_byte(reg_operand) || needs_rex_for_byte(rm)) {
+        put_byte(e, (uint8_t) (0x40 | rex));
+    }
+    for (size_t i = 0; i < opcode_length; ++i) {
+        put_byte(e, opcode[i]);
+    }
+    if (!memory) {
+        put_byte(e, (uint8_t) (0xC0 | (reg & 7) << 3 | (base & 7)));
+        return true;
+    }
+
+    // %rbp and %r13 have no displacement-free form (that encoding means RIP-relative)
+    const int mod = displacement == 0 && (base & 7) != 5 ? 0 : fits_int8(displacement) ? 1 : 2;
+    put_byte(e, (uint8_t) (mod << 6 | (reg & 7) << 3 | (base & 7)));
+    if ((base & 7) == 4) {
+        put_byte(e, 0x24); // %rsp and %r12 need a SIB byte: no index, that base
+    }
+    if (mod == 1) {
+        put_byte(e, (uint8_t) displacement);
+    } else if (mod == 2) {
+        put_imm32(e, displacement);
+    }
+    return true;
+}
+
+static bool encode_modrm1(Encoding *e, const bool wide, const uint8_t opcode, const MachineOperand *reg_operand,
+                          const int digit, const MachineOperand *rm) {
+    return encode_modrm(e, wide, &opcode, 1, reg_operand, digit, rm);
+}
+
+// add/or/and/sub/xor/cmp, in 8-, 32- or 64-bit form
+static bool encode_alu(Encoding *e, const int op, const bool wide, const bool byte, const MachineOperand *src,
+                       const MachineOperand *dst) {
+    if (src->kind == MACHINE_OPERAND_IMMEDIATE) {
+        const int value = src->value.immediate;
+        if (byte) {
+            if (is_register(dst, MACHINE_REG_AX)) {
+                put_byte(e, (uint8_t) (op << 3 | 4)); // op $imm8, %al
+            } else if (!encode_modrm1(e, false, 0x80, NULL, op, dst)) {
+                return false;
+            }
+            put_byte(e, (uint8_t) value);
+            return true;
+        }
+        if (fits_int8(value)) {
+            if (!encode_modrm1(e, wide, 0x83, NULL, op, dst)) return false;
+            put_byte(e, (uint8_t) value);
+            return true;
+        }
+        if (is_register(dst, MACHINE_REG_AX)) {
+            if (wide) put_byte(e, 0x48);
+            put_byte(e, (uint8_t) (op << 3 | 5)); // op $imm32, %eax
+        } else if (!encode_modrm1(e, wide, 0x81, NULL, op, dst)) {
+            return false;
+        }
+        put_imm32(e, value);
+        return true;
+    }
+    if (src->kind == MACHINE_OPERAND_REGISTER) {
+        return encode_modrm1(e, wide, (uint8_t) (op << 3 | (byte ? 0 : 1)), src, 0, dst);
+    }
+    if (machine_operand_is_memory(src) && dst->kind == MACHINE_OPERAND_REGISTER) {
+        return encode_modrm1(e, wide, (uint8_t) (op << 3 | (byte ? 2 : 3)), dst, 0, src);
+    }
+    return false;
+}
+
+static bool encode_mov(Encoding *e, const bool wide, const MachineOperand *src, const MachineOperand *dst) {
+    if (src->kind == MACHINE_OPERAND_IMMEDIATE) {
+        if (!wide && dst->kind == MACHINE_OPERAND_REGISTER) {
+            if (dst->value.reg & 8) put_byte(e, 0x41);
+            put_byte(e, (uint8_t) (0xB8 + (dst->value.reg & 7))); // movl $imm32, %reg
+        } else if (!encode_modrm1(e, wide, 0xC7, NULL, 0, dst)) {
+            return false;
+        }
+        put_imm32(e, src->value.immediate);
+        return true;
+    }
+    if (src->kind == MACHINE_OPERAND_REGISTER) {
+        return encode_modrm1(e, wide, 0x89, src, 0, dst);
+    }
+    if (machine_operand_is_memory(src) && dst->kind == MACHINE_OPERAND_REGISTER) {
+        return encode_modrm1(e, wide, 0x8B, dst, 0, src);
+    }
+    return false;
+}
+
+// shl/shr/sar by an immediate (the one-bit form for 1, as the assembler picks) or by %cl
+static bool encode_shift(Encoding *e, const int op, const MachineOperand *count, const MachineOperand *dst) {
+    if (count->kind == MACHINE_OPERAND_IMMEDIATE) {
+        if (count->value.immediate == 1) {
+            return encode_modrm1(e, false, 0xD1, NULL, op, dst);
+        }
+        if (!encode_modrm1(e, false, 0xC1, NULL, op, dst)) return false;
+        put_byte(e, (uint8_t) count->value.immediate);
+        return true;
+    }
+    if (is_register(count, MACHINE_REG_CX) && count->width == MACHINE_WIDTH_BYTE) {
+        return encode_modrm1(e, false, 0xD3, NULL, op, dst);
+    }
+    return false;
+}
+
+static bool encode_imul(Encoding *e, const MachineOperand *src, const MachineOperand *dst) {
+    if (dst->kind != MACHINE_OPERAND_REGISTER) {
+        return false; // The product always goes to a register
+    }
+    if (src->kind == MACHINE_OPERAND_IMMEDIATE) {
+        const int value = src->value.immediate;
+        if (!encode_modrm1(e, false, fits_int8(value) ? 0x6B : 0x69, dst, 0, dst)) return false;
+        if (fits_int8(value)) {
+            put_byte(e, (uint8_t) value);
+        } else {
+            put_imm32(e, value);
+        }
+        return true;
+    }
+    static const uint8_t opcode[] = {0x0F, 0xAF};
+    return encode_modrm(e, false, opcode, sizeof(opcode), dst, 0, src);
+}
+
+static bool encode_test(Encoding *e, const MachineOperand *src, const MachineOperand *dst) {
+    if (src->kind == MACHINE_OPERAND_IMMEDIATE) {
+        if (is_register(dst, MACHINE_REG_AX)) {
+            put_byte(e, 0xA9);
+        } else if (!encode_modrm1(e, false, 0xF7, NULL, 0, dst)) {
+            return false;
+        }
+        put_imm32(e, src->value.immediate);
+        return true;
+    }
+    return src->kind == MACHINE_OPERAND_REGISTER && encode_modrm1(e, false, 0x85, src, 0, dst);
+}
+
+static bool encode_push_pop(Encoding *e, const uint8_t base_opcode, const MachineOperand *op) {
+    if (op->kind != MACHINE_OPERAND_REGISTER) {
+        return false;
+    }
+    if (op->value.reg & 8) put_byte(e, 0x41);
+    put_byte(e, (uint8_t) (base_opcode + (op->value.reg & 7)));
+    return true;
+}
+
+/**
+ * @brief Encodes every instruction but the jumps (see encode_branch) and the labels (no bytes).
+ * @return false if the opcode/operand combination has no encoding.
+ */
+static bool encode_instruction(const MachineInstruction *instr, Encoding *e) {
+    const MachineOperand *first = &instr->operands[0];
+    const MachineOperand *second = &instr->operands[1];
+    e->length = 0;
+    switch (instr->opcode) {
+        case MACHINE_OP_GLOBL:
+        case MACHINE_OP_FUNCTION_LABEL:
+        case MACHINE_OP_LABEL:
+            return true;
+        case MACHINE_OP_PUSHQ: return encode_push_pop(e, 0x50, first);
+        case MACHINE_OP_POPQ: return encode_push_pop(e, 0x58, first);
+        case MACHINE_OP_MOVQ: return encode_mov(e, true, first, second);
+        case MACHINE_OP_SUBQ: return encode_alu(e, ALU_SUB, true, false, first, second);
+        case MACHINE_OP_LEAVE: put_byte(e, 0xC9); return true;
+        case MACHINE_OP_RETQ: put_byte(e, 0xC3); return true;
+        case MACHINE_OP_MOVL: return encode_mov(e, false, first, second);
+        case MACHINE_OP_MOVZBL: {
+            static const uint8_t opcode[] = {0x0F, 0xB6};
+            return second->kind == MACHINE_OPERAND_REGISTER &&
+                   encode_modrm(e, false, opcode, sizeof(opcode), second, 0, first);
+        }
+        case MACHINE_OP_ADDL: return encode_alu(e, ALU_ADD, false, false, first, second);
+        case MACHINE_OP_SUBL: return encode_alu(e, ALU_SUB, false, false, first, second);
+        case MACHINE_OP_ANDL: return encode_alu(e, ALU_AND, false, false, first, second);
+        case MACHINE_OP_XORL: return encode_alu(e, ALU_XOR, false, false, first, second);
+        case MACHINE_OP_CMPL: return encode_alu(e, ALU_CMP, false, false, first, second);
+        case MACHINE_OP_ANDB: return encode_alu(e, ALU_AND, false, true, first, second);
+        case MACHINE_OP_ORB: return encode_alu(e, ALU_OR, false, true, first, second);
+        case MACHINE_OP_IMULL: return encode_imul(e, first, second);
+        case MACHINE_OP_TESTL: return encode_test(e, first, second);
+        case MACHINE_OP_NEGL: return encode_modrm1(e, false, 0xF7, NULL, UNARY_NEG, first);
+        case MACHINE_OP_NOTL: return encode_modrm1(e, false, 0xF7, NULL, UNARY_NOT, first);
+        case MACHINE_OP_IMULL_WIDE: return encode_modrm1(e, false, 0xF7, NULL, UNARY_IMUL, first);
+        case MACHINE_OP_IDIVL: return encode_modrm1(e, false, 0xF7, NULL, UNARY_IDIV, first);
+        case MACHINE_OP_CLTD: put_byte(e, 0x99); return true;
+        case MACHINE_OP_SHLL: return encode_shift(e, SHIFT_SHL, first, second);
+        case MACHINE_OP_SHRL: return encode_shift(e, SHIFT_SHR, first, second);
+        case MACHINE_OP_SARL: return encode_shift(e, SHIFT_SAR, first, second);
+        case MACHINE_OP_INCL: return encode_modrm1(e, false, 0xFF, NULL, 0, first);
+        case MACHINE_OP_DECL: return encode_modrm1(e, false, 0xFF, NULL, 1, first);
+        case MACHINE_OP_LEAL:
+            return first->kind == MACHINE_OPERAND_ADDRESS && second->kind == MACHINE_OPERAND_REGISTER &&
+                   encode_modrm1(e, false, 0x8D, second, 0, first);
+        case MACHINE_OP_SETCC: {
+            const uint8_t opcode[] = {0x0F, (uint8_t) (0x90 | condition_codes[instr->condition])};
+            return encode_modrm(e, false, opcode, sizeof(opcode), NULL, 0, first);
+        }
+        case MACHINE_OP_JMP:
+        case MACHINE_OP_JCC:
+        case MACHINE_OP_COUNT:
+            break;
+    }
+    return false;
+}
+
+static bool is_branch(const MachineInstruction *instr) {
+    return instr->opcode == MACHINE_OP_JMP || instr->opcode == MACHINE_OP_JCC;
+}
+
+static uint8_t branch_size(const MachineInstruction *instr, const bool long_branch) {
+    if (!long_branch) {
+        return 2; // EB/7x rel8
+    }
+    return instr->opcode == MACHINE_OP_JMP ? 5 : 6; // E9 rel32, 0F 8x rel32
+}
+
+// jmp/jcc with the displacement counted from the end of the instruction
+static void encode_branch(const MachineInstruction *instr, const bool long_branch, const int32_t displacement,
+                          Encoding *e) {
+    e->length = 0;
+    const bool jump = instr->opcode == MACHINE_OP_JMP;
+    if (!long_branch) {
+        put_byte(e, jump ? 0xEB : (uint8_t) (0x70 | condition_codes[instr->condition]));
+        put_byte(e, (uint8_t) displacement);
+        return;
+    }
+    if (jump) {
+        put_byte(e, 0xE9);
+    } else {
+        put_byte(e, 0x0F);
+        put_byte(e, (uint8_t) (0x80 | condition_codes[instr->condition]));
+    }
+    put_imm32(e, displacement);
+}
+
+static void report_unencodable(const MachineFunction *mf, const MachineInstruction *instr, Arena *scratch) {
+    StringBuffer sb;
+    string_buffer_init(&sb, scratch, 64);
+    machine_print_instruction(&sb, instr);
+    fprintf(stderr, "Codegen Error: No x86-64 encoding for `%s` in function %s.\n", string_buffer_content_str(&sb),
+            mf->name);
+}
+
+// Index of the LABEL instruction for every local label id in [min_label, max_label], or -1
+typedef struct {
+    long *instruction;
+    uint32_t min_label;
+    uint32_t max_label;
+} LabelTable;
+
+static bool build_label_table(const MachineFunction *mf, LabelTable *labels, Arena *scratch) {
+    labels->instruction = NULL;
+    labels->min_label = UINT32_MAX;
+    labels->max_label = 0;
+    for (size_t i = 0; i < mf->count; ++i) {
+        if (mf->instructions[i].opcode == MACHINE_OP_LABEL) {
+            const uint32_t id = mf->instructions[i].operands[0].value.label_id;
+            if (id < labels->min_label) labels->min_label = id;
+            if (id > labels->max_label) labels->max_label = id;
+        }
+    }
+    if (labels->min_label > labels->max_label) {
+        return true; // No labels
+    }
+    const size_t range = (size_t) (labels->max_label - labels->min_label) + 1;
+    labels->instruction = arena_alloc(scratch, range * sizeof(long));
+    if (!labels->instruction) {
+        fprintf(stderr, "Codegen Error: Out of memory encoding function %s.\n", mf->name);
+        return false;
+    }
+    for (size_t k = 0; k < range; ++k) {
+        labels->instruction[k] = -1;
+    }
+    for (size_t i = 0; i < mf->count; ++i) {
+        if (mf->instructions[i].opcode == MACHINE_OP_LABEL) {
+            labels->instruction[mf->instructions[i].operands[0].value.label_id - labels->min_label] = (long) i;
+        }
+    }
+    return true;
+}
+
+// Index of the LABEL instruction a jump targets, or -1 if the function does not define it
+static long branch_target(const MachineInstruction *instr, const LabelTable *labels) {
+    if (instr->operands[0].kind != MACHINE_OPERAND_LOCAL_LABEL || !labels->instruction) {
+        return -1;
+    }
+    const uint32_t id = instr->operands[0].value.label_id;
+    if (id < labels->min_label || id > labels->max_label) {
+        return -1;
+    }
+    return labels->instruction[id - labels->min_label];
+}
+
+static bool encode_function(const MachineFunction *mf, ObjectWriter *object, Arena *scratch) {
+    const size_t n = mf->count;
+    LabelTable labels;
+    if (!build_label_table(mf, &labels, scratch)) {
+        return false;
+    }
+    InstructionLayout *layout = arena_alloc(scratch, (n + 1) * sizeof(InstructionLayout));
+    if (!layout) {
+        fprintf(stderr, "Codegen Error: Out of memory encoding function %s.\n", mf->name);
+        return false;
+    }
+
+    // 1. Sizes: fixed for everything but the jumps, which start short
+    Encoding e;
+    for (size_t i = 0; i < n; ++i) {
+        const MachineInstruction *instr = &mf->instructions[i];
+        layout[i].long_branch = false;
+        if (is_branch(instr)) {
+            if (branch_target(instr, &labels) < 0) {
+                report_unencodable(mf, instr, scratch);
+                fprintf(stderr, "Codegen Error: The jump target is not defined in function %s.\n", mf->name);
+                return false;
+            }
+            layout[i].size = branch_size(instr, false);
+        } else {
+            if (!encode_instruction(instr, &e)) {
+                report_unencodable(mf, instr, scratch);
+                return false;
+            }
+            layout[i].size = (uint8_t) e.length;
+        }
+    }
+
+    // 2. Relaxation: lengthen every jump whose target is out of rel8 reach until none is.
+    //    Jumps only grow, so this terminates, and it keeps the short form wherever it fits.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        uint32_t offset = 0;
+        for (size_t i = 0; i < n; ++i) {
+            layout[i].offset = offset;
+            offset += layout[i].size;
+        }
+        layout[n].offset = offset;
+        for (size_t i = 0; i < n; ++i) {
+            const MachineInstruction *instr = &mf->instructions[i];
+            if (!is_branch(instr) || layout[i].long_branch) {
+                continue;
+            }
+            const long target = (long) layout[branch_target(instr, &labels)].offset;
+            if (!fits_int8(target - (long) (layout[i].offset + layout[i].size))) {
+                layout[i].long_branch = true;
+                layout[i].size = branch_size(instr, true);
+                changed = true;
+            }
+        }
+    }
+
+    // 3. Bytes
+    const size_t start = object->text_size;
+    uint8_t *text = object_writer_reserve_text(object, layout[n].offset);
+    if (!text && layout[n].offset > 0) {
+        return false;
+    }
+    size_t symbol_offset = start;
+    const char *symbol_name = NULL;
+    for (size_t i = 0; i < n; ++i) {
+        const MachineInstruction *instr = &mf->instructions[i];
+        if (instr->opcode == MACHINE_OP_FUNCTION_LABEL) {
+            symbol_name = instr->operands[0].value.label;
+            symbol_offset = start + layout[i].offset;
+        }
+        if (is_branch(instr)) {
+            const long target = (long) layout[branch_target(instr, &labels)].offset;
+            encode_branch(instr, layout[i].long_branch,
+                          (int32_t) (target - (long) (layout[i].offset + layout[i].size)), &e);
+        } else {
+            encode_instruction(instr, &e);
+        }
+        if (e.length > 0) {
+            memcpy(text + layout[i].offset, e.bytes, e.length);
+        }
+    }
+    if (symbol_name) {
+        return object_writer_add_function(object, symbol_name, symbol_offset, start + layout[n].offset - symbol_offset);
+    }
+    return true;
+}
+
+bool x86_encode_function(const MachineFunction *mf, ObjectWriter *object, Arena *scratch) {
+    const ArenaMark mark = arena_mark(scratch);
+    const bool encoded = encode_function(mf, object, scratch);
+    arena_release(scratch, mark);
+    return encoded;
+}
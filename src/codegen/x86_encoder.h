@@ -0,0 +1,34 @@
+#ifndef CLERIC_X86_ENCODER_H
+#define CLERIC_X86_ENCODER_H
+
+#include <stdbool.h>
+#include "../memory/arena.h"
+#include "machine.h"
+#include "object_writer.h"
+
+//------------------------------------------------------------------------------
+// x86-64 machine code encoder
+//
+// Encodes a lowered MachineFunction (every temp already in a register or stack
+// slot) straight into an object's .text, picking the encodings the GNU assembler
+// picks for the same AT&T listing: the short immediate forms, the %eax forms of
+// the ALU instructions, and jumps relaxed from rel8 to rel32 only when the target
+// is out of reach. Assembling the --codegen output therefore gives the same bytes,
+// which is what tests/codegen/test_x86_encoder.c checks.
+//------------------------------------------------------------------------------
+
+// Longest encoding the encoder produces (the architectural limit)
+#define X86_MAX_INSTRUCTION_LENGTH 15
+
+/**
+ * @brief Appends the machine code of one function to the object and defines its symbol.
+ * @param mf The lowered function (no MACHINE_OPERAND_TEMP operands left).
+ * @param object Object receiving the code and the symbol.
+ * @param scratch Arena for the label and layout tables; everything allocated is released again, so
+ *                it must not be the arena the object grows in.
+ * @return false if an instruction has no encoding or a jump target is missing (an error has been
+ *         printed), or memory ran out.
+ */
+bool x86_encode_function(const MachineFunction *mf, ObjectWriter *object, Arena *scratch);
+
+#endif // CLERIC_X86_ENCODER_H
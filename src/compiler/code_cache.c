@@ -0,0 +1,135 @@
+#include "code_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_CACHE_INITIAL_CAPACITY 64
+#define CODE_CACHE_STORAGE_SIZE (64 * 1024)
+#define CODE_CACHE_COMPILE_ARENA_SIZE (64 * 1024)
+
+// Only these options change the code a source compiles to
+static uint32_t options_key(const CompileOptions *options) {
+    return (uint32_t) options->optimization_level << 4 | (uint32_t) options->no_omit_frame_pointer << 3 |
+           (uint32_t) options->no_peephole << 2 | (uint32_t) options->flat_ast << 1 |
+           (uint32_t) options->fuse_validation;
+}
+
+static uint64_t hash_source(const char *source, const size_t length, const uint32_t key) {
+    uint64_t hash = 14695981039346656037u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char) source[i];
+        hash *= 1099511628211u;
+    }
+    for (int i = 0; i < 4; ++i) {
+        hash ^= (key >> (8 * i)) & 0xff;
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+// The slot holding the key, or the empty slot where it would go
+static CodeCacheEntry *find_slot(const CodeCache *cache, const char *source, const size_t length,
+                                 const uint32_t key, const uint64_t hash) {
+    const size_t mask = cache->capacity - 1;
+    size_t index = (size_t) hash & mask;
+    for (;;) {
+        CodeCacheEntry *entry = &cache->entries[index];
+        if (!entry->source || (entry->hash == hash && entry->options_key == key &&
+                               entry->source_length == length && memcmp(entry->source, source, length) == 0)) {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static bool allocate_table(CodeCache *cache, const size_t capacity) {
+    CodeCacheEntry *entries = arena_alloc_zeroed(&cache->storage, capacity * sizeof(CodeCacheEntry));
+    if (!entries) {
+        return false;
+    }
+    cache->entries = entries;
+    cache->capacity = capacity;
+    return true;
+}
+
+bool code_cache_init(CodeCache *cache) {
+    *cache = (CodeCache){0};
+    cache->storage = arena_create(CODE_CACHE_STORAGE_SIZE);
+    cache->compile_arena = arena_create(CODE_CACHE_COMPILE_ARENA_SIZE);
+    if (!cache->storage.start || !cache->compile_arena.start ||
+        !allocate_table(cache, CODE_CACHE_INITIAL_CAPACITY)) {
+        fprintf(stderr, "Compiler Error: Failed to create the code cache.\n");
+        code_cache_destroy(cache);
+        return false;
+    }
+    return true;
+}
+
+void code_cache_destroy(CodeCache *cache) {
+    for (size_t i = 0; i < cache->capacity; ++i) {
+        if (cache->entries[i].source) {
+            jit_release(&cache->entries[i].code);
+        }
+    }
+    if (cache->storage.start) {
+        arena_destroy(&cache->storage);
+    }
+    if (cache->compile_arena.start) {
+        arena_destroy(&cache->compile_arena);
+    }
+    *cache = (CodeCache){0};
+}
+
+const JitCode *code_cache_lookup(CodeCache *cache, const char *source, const size_t source_length,
+                                 const CompileOptions *options) {
+    const uint32_t key = options_key(options);
+    const CodeCacheEntry *entry = find_slot(cache, source, source_length, key,
+                                            hash_source(source, source_length, key));
+    if (!entry->source) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    return &entry->code;
+}
+
+// Doubles the table; the old one stays behind in the storage arena
+static bool grow(CodeCache *cache) {
+    const CodeCacheEntry *old_entries = cache->entries;
+    const size_t old_capacity = cache->capacity;
+    if (!allocate_table(cache, old_capacity * 2)) {
+        return false;
+    }
+    for (size_t i = 0; i < old_capacity; ++i) {
+        const CodeCacheEntry *entry = &old_entries[i];
+        if (entry->source) {
+            *find_slot(cache, entry->source, entry->source_length, entry->options_key, entry->hash) = *entry;
+        }
+    }
+    return true;
+}
+
+const JitCode *code_cache_insert(CodeCache *cache, const char *source, const size_t source_length,
+                                 const CompileOptions *options, JitCode *code) {
+    // Keep the load factor at or below 3/4 so probe sequences stay short
+    if ((cache->count + 1) * 4 > cache->capacity * 3 && !grow(cache)) {
+        return NULL;
+    }
+    const uint32_t key = options_key(options);
+    const uint64_t hash = hash_source(source, source_length, key);
+    CodeCacheEntry *entry = find_slot(cache, source, source_length, key, hash);
+    if (entry->source) {
+        // Already cached: keep the existing code and drop the new copy
+        jit_release(code);
+        return &entry->code;
+    }
+    char *copy = arena_alloc(&cache->storage, source_length + 1);
+    if (!copy) {
+        return NULL;
+    }
+    memcpy(copy, source, source_length);
+    copy[source_length] = '\0';
+    *entry = (CodeCacheEntry){hash, key, copy, source_length, *code};
+    cache->count++;
+    *code = (JitCode){0};
+    return &entry->code;
+}
@@ -0,0 +1,66 @@
+#ifndef CLERIC_CODE_CACHE_H
+#define CLERIC_CODE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../codegen/jit.h"
+#include "../memory/arena.h"
+#include "options.h"
+
+//------------------------------------------------------------------------------
+// Loaded code keyed by source
+//
+// compile_and_run() looks a program up here before compiling it, so a service
+// that evaluates the same expressions over and over compiles each one once. The
+// key is the source text together with the options that change the generated
+// code (-O level, --no-peephole, --flat-ast, --fuse-validation): the table is
+// hashed with FNV-1a and keeps a copy of every source, so colliding hashes are
+// told apart by comparing the bytes. Entries are never evicted; their code
+// stays mapped until code_cache_destroy.
+//------------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t hash;         // FNV-1a of the source, mixed with options_key
+    uint32_t options_key;  // The code-affecting options, packed
+    const char *source;    // Copy of the source (NULL marks an empty slot)
+    size_t source_length;
+    JitCode code;
+} CodeCacheEntry;
+
+typedef struct {
+    CodeCacheEntry *entries; // Open addressing, linear probing; capacity is a power of two
+    size_t capacity;
+    size_t count;
+    Arena storage;           // The table and the source copies
+    Arena compile_arena;     // Used by every compilation on a miss and reset afterwards
+    size_t hits;
+    size_t misses;
+} CodeCache;
+
+/**
+ * @brief Creates an empty cache.
+ * @return false if memory ran out (the cache is then left empty and need not be destroyed).
+ */
+bool code_cache_init(CodeCache *cache);
+
+/**
+ * @brief Releases every entry's code and the cache's memory.
+ */
+void code_cache_destroy(CodeCache *cache);
+
+/**
+ * @brief Finds the code compiled earlier for this source and these options.
+ * @return The loaded code, or NULL on a miss. Counts the hit or miss.
+ */
+const JitCode *code_cache_lookup(CodeCache *cache, const char *source, size_t source_length,
+                                 const CompileOptions *options);
+
+/**
+ * @brief Adds freshly loaded code; the cache takes ownership of it and clears *code.
+ * @return The cached copy of the code, or NULL if memory ran out (*code then stays the caller's).
+ */
+const JitCode *code_cache_insert(CodeCache *cache, const char *source, size_t source_length,
+                                 const CompileOptions *options, JitCode *code);
+
+#endif // CLERIC_CODE_CACHE_H
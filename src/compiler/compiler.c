@@ -2,12 +2,19 @@
 #include "../lexer/lexer.h"
 #include "../parser/parser.h"
 #include "../parser/ast.h" // Needed for AstNode, FuncDefNode etc.
+#include "../parser/flat_ast.h"
 #include "../codegen/codegen.h"
+#include "../codegen/jit.h"
 #include "../strings/strings.h"
 #include "../ir/tac.h"           // For TacProgram and tac_print_program
+#include "../ir/tac_interpreter.h"
 #include "../validator/validator.h" // Added validator include
+#include "../optimizer/optimizer.h"
+#include "function_cache.h"
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h> // For strlen
 
 #include "ir/ast_to_tac.h"
 #include "ir/tac.h"
@@ -16,18 +23,50 @@
 // Core Compilation Logic (Source String -> Assembly String Buffer)
 // -----------------------------------------------------------------------------
 
+// The parser's output, in the form the later phases walk
+typedef struct {
+    ProgramNode *program; // Pointer tree, as parsed
+    FlatAst *flat;        // Flat form of `program` with --flat-ast, NULL otherwise
+} ParsedProgram;
+
+// Progress messages go to stdout unless the options ask for quiet; listings and errors are unaffected
+static void progress(bool quiet, const char *format, ...);
+
+// Errors go to the diagnostics when there are some (cleric_compile), to stderr otherwise
+static void compile_error(Diagnostics *diagnostics, const char *format, ...);
+
 // Forward declarations for static helper functions
-static bool run_lexer(Lexer *lexer, bool print_tokens);
+static bool run_lexer(Lexer *lexer, bool print_tokens, bool quiet, Diagnostics *diagnostics,
+                      TokenArray *out_tokens);
+
+// Takes an initialized lexer; the tokens are lexed once and handed to the parser
+
+// With a lexer thread, the thread is finished once parsing stops, and a token it could not
+// recognize is reported as run_lexer reports it
+static bool run_parser(Parser *parser, LexerThread *lexer_thread, bool print_ast, bool flatten, bool quiet,
+                       Diagnostics *diagnostics, ParsedProgram *out_parsed);
 
-// Takes an initialized lexer
+static void report_unknown_token(Diagnostics *diagnostics, Token token);
 
-static bool run_parser(Parser *parser, bool print_ast, ProgramNode **out_program);
+static bool run_validator(const ParsedProgram *parsed, Arena *arena, bool quiet, Diagnostics *diagnostics);
 
-static bool run_validator(ProgramNode *program, Arena *arena);
+static bool run_irgen(const ParsedProgram *parsed, bool fused, bool branchless_logical, Arena *arena,
+                      TacProgram **out_tac_program, bool print_tac, bool quiet, Diagnostics *diagnostics);
 
-static bool run_irgen(ProgramNode *ast_root, Arena *arena, TacProgram **out_tac_program, bool print_tac);
+static void print_tac_listing(const char *title, const TacProgram *tac_program, Arena *arena);
 
-static bool run_codegen(TacProgram *tac_program, StringBuffer *output_assembly_sb, bool print_assembly);
+static bool run_optimizer(TacProgram *tac_program, int optimization_level, int function_jobs, Arena *arena,
+                          bool print_tac, bool quiet, Diagnostics *diagnostics);
+
+static bool run_codegen(TacProgram *tac_program, OutputSink *sink, const CodegenOptions *codegen_options,
+                        bool print_assembly, bool quiet, Diagnostics *diagnostics);
+
+static bool run_codegen_to_object(TacProgram *tac_program, ObjectWriter *object,
+                                  const CodegenOptions *codegen_options, bool quiet, Diagnostics *diagnostics);
+
+static bool compile_source(const char *source_code, size_t source_length, const CompileOptions *options,
+                           OutputSink *sink, ObjectWriter *object, TacProgram **out_tac, Arena *arena,
+                           CompileStats *stats, Diagnostics *diagnostics);
 
 // Add IRGen step
 
@@ -39,34 +78,328 @@ bool compile(const char *source_code,
              const bool codegen_only,
              StringBuffer *output_assembly_sb,
              Arena *arena) {
-    Lexer lexer;
-    // Initialize lexer with the arena
-    lexer_init(&lexer, source_code, arena);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.lex_only = lex_only;
+    options.parse_only = parse_only;
+    options.validate_only = validate_only;
+    options.tac_only = tac_only;
+    options.codegen_only = codegen_only;
+    return compile_with_options(source_code, &options, output_assembly_sb, arena, NULL);
+}
 
-    // --- Lexing Phase ---
-    // Pass the arena, even if just lexing, as lexemes are allocated into it.
-    bool const lex_success = run_lexer(&lexer, (lex_only || parse_only || codegen_only));
-    if (!lex_success) {
-        return false; // Lexical error
+bool compile_with_options(const char *source_code,
+                          const CompileOptions *options,
+                          StringBuffer *output_assembly_sb,
+                          Arena *arena,
+                          CompileStats *stats) {
+    OutputSink sink;
+    if (output_assembly_sb) {
+        output_sink_init_buffer(&sink, output_assembly_sb);
     }
+    return compile_with_sink(source_code, options, output_assembly_sb ? &sink : NULL, arena, stats);
+}
+
+bool compile_with_sink(const char *source_code,
+                       const CompileOptions *options,
+                       OutputSink *sink,
+                       Arena *arena,
+                       CompileStats *stats) {
+    return compile_source_with_sink(source_code, strlen(source_code), options, sink, arena, stats);
+}
+
+bool compile_source_with_sink(const char *source_code,
+                              const size_t source_length,
+                              const CompileOptions *options,
+                              OutputSink *sink,
+                              Arena *arena,
+                              CompileStats *stats) {
+    return compile_source(source_code, source_length, options, sink, NULL, NULL, arena, stats, NULL);
+}
+
+bool compile_source_with_diagnostics(const char *source_code,
+                                     const size_t source_length,
+                                     const CompileOptions *options,
+                                     OutputSink *sink,
+                                     Arena *arena,
+                                     Diagnostics *diagnostics) {
+    return compile_source(source_code, source_length, options, sink, NULL, NULL, arena, NULL, diagnostics);
+}
+
+// Initial size of the arena every cleric_compile call creates for itself
+#define COMPILER_LIBRARY_ARENA_SIZE (64 * 1024)
 
-    if (lex_only) {
-        return true; // Lexing succeeded, stop here
+bool cleric_compile(const CompileOptions *options,
+                    const char *source_code,
+                    const size_t source_length,
+                    OutputSink *sink,
+                    Diagnostics *diagnostics) {
+    if (compile_options_stops_early(options)) {
+        compile_error(diagnostics, "Compiler Error: cleric_compile runs the full pipeline, not a stop-early mode.");
+        return false;
+    }
+    if (!sink) {
+        compile_error(diagnostics, "Compiler Error: cleric_compile needs an output sink.");
+        return false;
     }
+    // The caller's options are never written to; progress messages would go to stdout
+    CompileOptions library_options = *options;
+    library_options.quiet = true;
 
-    // --- Reset Lexer for Parsing ---
-    lexer_reset(&lexer); // Reset the same lexer instance
+    Arena arena = arena_create(COMPILER_LIBRARY_ARENA_SIZE);
+    if (!arena.start) {
+        compile_error(diagnostics, "Compiler Error: Failed to create the compilation arena.");
+        return false;
+    }
+    const bool success = compile_source(source_code, source_length, &library_options, sink, NULL, NULL, &arena,
+                                        NULL, diagnostics);
+    arena_destroy(&arena);
+    return success;
+}
 
-    Parser parser;
-    parser_init(&parser, &lexer, arena); // Pass arena to parser_init
+// Initial size of the arena compile_and_run uses when it has no cache to borrow one from
+#define COMPILER_RUN_ARENA_SIZE (64 * 1024)
+
+bool compile_and_run(const char *source_code,
+                     const size_t source_length,
+                     const CompileOptions *options,
+                     CodeCache *cache,
+                     int *out_result) {
+    if (compile_options_stops_early(options)) {
+        fprintf(stderr, "Compiler Error: Running a program needs the full pipeline, not a stop-early mode.\n");
+        return false;
+    }
+    if (cache) {
+        const JitCode *cached = code_cache_lookup(cache, source_code, source_length, options);
+        if (cached) {
+            *out_result = cached->entry();
+            return true;
+        }
+    }
 
-    // --- Parsing Phase ---
-    ProgramNode *program;
-    const bool parse_success = run_parser(&parser, parse_only || codegen_only || tac_only || validate_only, &program);
-    if (!parse_success) {
+    // A cache lends its arena to every miss, so repeated compilations reuse the same memory
+    Arena local_arena;
+    Arena *arena = &local_arena;
+    if (cache) {
+        arena = &cache->compile_arena;
+    } else {
+        local_arena = arena_create(COMPILER_RUN_ARENA_SIZE);
+        if (!local_arena.start) {
+            fprintf(stderr, "Compiler Error: Failed to create the compilation arena.\n");
+            return false;
+        }
+    }
+    ObjectWriter object;
+    object_writer_init(&object, arena);
+    JitCode code;
+    // The loaded code is a copy, so the object can go with the arena right after loading
+    const bool loaded = compile_source(source_code, source_length, options, NULL, &object, NULL, arena, NULL, NULL) &&
+                        jit_load(&object, "main", &code);
+    if (cache) {
+        arena_reset_with_mode(arena, ARENA_RESET_DIRTY);
+    } else {
+        arena_destroy(&local_arena);
+    }
+    if (!loaded) {
         return false;
     }
 
+    const JitCode *cached = cache ? code_cache_insert(cache, source_code, source_length, options, &code) : NULL;
+    *out_result = cached ? cached->entry() : code.entry();
+    jit_release(&code); // Cleared when the cache took it
+    return true;
+}
+
+// Initial size of the arena compile_and_interpret works in
+#define COMPILER_INTERPRET_ARENA_SIZE (64 * 1024)
+
+bool compile_and_interpret(const char *source_code,
+                           const size_t source_length,
+                           const CompileOptions *options,
+                           int *out_result) {
+    if (compile_options_stops_early(options)) {
+        fprintf(stderr, "Compiler Error: Interpreting a program needs the full pipeline, not a stop-early mode.\n");
+        return false;
+    }
+    Arena arena = arena_create(COMPILER_INTERPRET_ARENA_SIZE);
+    if (!arena.start) {
+        fprintf(stderr, "Compiler Error: Failed to create the compilation arena.\n");
+        return false;
+    }
+    TacProgram *tac_program = NULL;
+    const bool success = compile_source(source_code, source_length, options, NULL, NULL, &tac_program, &arena, NULL,
+                                        NULL) &&
+                         tac_interpret_program(tac_program, "main", &arena, out_result);
+    arena_destroy(&arena);
+    return success;
+}
+
+// The code generation options the compile options ask for
+static void set_codegen_options(const CompileOptions *options, CompileStats *stats, CodegenOptions *codegen_options) {
+    codegen_options_init(codegen_options);
+    codegen_options->allocate_registers = options->optimization_level >= 1;
+    codegen_options->pack_stack_slots = options->optimization_level >= 1;
+    codegen_options->fuse_compare_branches = options->optimization_level >= 1;
+    codegen_options->reduce_strength = options->optimization_level >= 1;
+    codegen_options->select_in_place = options->optimization_level >= 1;
+    codegen_options->cache_register_values = options->optimization_level >= 1;
+    codegen_options->peephole = options->optimization_level >= 1 && !options->no_peephole;
+    codegen_options->trim_frame = options->optimization_level >= 1;
+    codegen_options->omit_frame_pointer = options->optimization_level >= 1 && !options->no_omit_frame_pointer;
+    codegen_options->peephole_stats = stats ? &stats->peephole : NULL;
+    codegen_options->jobs = options->function_jobs;
+    // Streamed functions are compiled one by one, each numbering its labels from 0
+    codegen_options->qualify_labels = options->stream;
+    // --codegen always prints the assembly text, which is also what the encoder is checked against
+    codegen_options->emit_object = options->emit_obj && !options->codegen_only;
+}
+
+bool compile_source_to_tac(const char *source_code,
+                           const size_t source_length,
+                           const CompileOptions *options,
+                           Arena *arena,
+                           TacProgram **out_tac) {
+    if (compile_options_stops_early(options)) {
+        fprintf(stderr, "Compiler Error: Writing TAC needs the pipeline up to IR generation, not a stop-early mode.\n");
+        return false;
+    }
+    return compile_source(source_code, source_length, options, NULL, NULL, out_tac, arena, NULL, NULL);
+}
+
+bool compile_tac_with_sink(TacProgram *tac_program,
+                           const CompileOptions *options,
+                           OutputSink *sink,
+                           Arena *arena,
+                           CompileStats *stats) {
+    if (options->lex_only || options->parse_only || options->validate_only) {
+        fprintf(stderr, "Compiler Error: A TAC program is past lexing, parsing and validation.\n");
+        return false;
+    }
+    const bool print = options->tac_only || options->codegen_only;
+    const bool quiet = options->quiet;
+    if (stats) {
+        *stats = (CompileStats){0};
+        for (size_t i = 0; i < tac_program->function_count; ++i) {
+            stats->tac_instruction_count += tac_program->functions[i]->instruction_count;
+        }
+        stats->optimized_tac_instruction_count = stats->tac_instruction_count;
+    }
+    if (print) {
+        print_tac_listing("TAC:", tac_program, arena);
+    }
+    if (options->optimization_level >= 1) {
+        compile_stats_begin_phase(stats, COMPILE_PHASE_OPTIMIZE, arena);
+        const bool optimized =
+            run_optimizer(tac_program, options->optimization_level, options->function_jobs, arena, print, quiet, NULL);
+        compile_stats_end_phase(stats, COMPILE_PHASE_OPTIMIZE, arena);
+        if (!optimized) {
+            return false;
+        }
+        if (stats) {
+            stats->optimized_tac_instruction_count = 0;
+            for (size_t i = 0; i < tac_program->function_count; ++i) {
+                stats->optimized_tac_instruction_count += tac_program->functions[i]->instruction_count;
+            }
+        }
+    }
+    if (options->tac_only) {
+        return true;
+    }
+
+    CodegenOptions codegen_options;
+    set_codegen_options(options, stats, &codegen_options);
+    compile_stats_begin_phase(stats, COMPILE_PHASE_CODEGEN, arena);
+    const bool success = run_codegen(tac_program, sink, &codegen_options, options->codegen_only, quiet, NULL);
+    compile_stats_end_phase(stats, COMPILE_PHASE_CODEGEN, arena);
+    if (stats) {
+        stats->assembly_bytes = output_sink_total_bytes(sink);
+    }
+    return success;
+}
+
+// Runs the pipeline; codegen writes to the sink, or encodes into the object when one is given.
+// With out_tac the pipeline stops after optimization and hands the program out instead.
+static bool compile_source(const char *source_code,
+                           const size_t source_length,
+                           const CompileOptions *options,
+                           OutputSink *sink,
+                           ObjectWriter *object,
+                           TacProgram **out_tac,
+                           Arena *arena,
+                           CompileStats *stats,
+                           Diagnostics *diagnostics) {
+    const bool lex_only = options->lex_only;
+    const bool parse_only = options->parse_only;
+    const bool validate_only = options->validate_only;
+    const bool tac_only = options->tac_only;
+    const bool codegen_only = options->codegen_only;
+    const bool quiet = options->quiet;
+    if (stats) {
+        *stats = (CompileStats){0};
+    }
+
+    Lexer lexer;
+    // Initialize lexer with the arena
+    lexer_init_with_length(&lexer, source_code, source_length, arena);
+    if (stats) {
+        stats->source_bytes = lexer.len;
+    }
+
+    // --- Lexing and Parsing Phases ---
+    // With --lex-thread, lexing overlaps with parsing and its time is part of the parse phase;
+    // the modes that print the tokens keep a lexing phase of their own
+    Parser parser;
+    ParsedProgram parsed;
+    const bool print_ast = parse_only || codegen_only || tac_only || validate_only;
+    if (options->lex_thread && !(lex_only || parse_only || codegen_only)) {
+        progress(quiet, "Lexing on a separate thread...\n");
+        compile_stats_begin_phase(stats, COMPILE_PHASE_PARSE, arena);
+        LexerThread lexer_thread;
+        bool parse_success = lexer_thread_start(&lexer_thread, &lexer, arena);
+        if (parse_success) {
+            parser_init_ring(&parser, lexer_thread.ring, arena);
+            parse_success = run_parser(&parser, &lexer_thread, print_ast, options->flat_ast, quiet, diagnostics,
+                                       &parsed);
+        }
+        compile_stats_end_phase(stats, COMPILE_PHASE_PARSE, arena);
+        if (!parse_success) {
+            return false;
+        }
+        if (stats) {
+            stats->token_count = lexer_thread.token_count;
+        }
+    } else {
+        // Pass the arena, even if just lexing, as the token array and lexemes are allocated into it.
+        TokenArray tokens;
+        compile_stats_begin_phase(stats, COMPILE_PHASE_LEX, arena);
+        bool const lex_success = run_lexer(&lexer, (lex_only || parse_only || codegen_only), quiet,
+                                           diagnostics, &tokens);
+        compile_stats_end_phase(stats, COMPILE_PHASE_LEX, arena);
+        if (!lex_success) {
+            return false; // Lexical error
+        }
+        if (stats) {
+            stats->token_count = tokens.count;
+        }
+
+        if (lex_only) {
+            return true; // Lexing succeeded, stop here
+        }
+
+        // The parser reads the token array by index; nothing is lexed a second time
+        compile_stats_begin_phase(stats, COMPILE_PHASE_PARSE, arena);
+        parser_init_tokens(&parser, &tokens, arena);
+        const bool parse_success = run_parser(&parser, NULL, print_ast, options->flat_ast, quiet, diagnostics,
+                                              &parsed);
+        compile_stats_end_phase(stats, COMPILE_PHASE_PARSE, arena);
+        if (!parse_success) {
+            return false;
+        }
+    }
+    if (stats) {
+        stats->ast_node_count = parser.node_count; // Counted while parsing, no second walk
+    }
+
     // If only parsing, we're done.
     if (parse_only) {
         return true;
@@ -75,9 +408,16 @@ bool compile(const char *source_code,
     // --- Semantic Validation Phase ---
     // This phase always runs unless parse_only was true (handled above) or lex_only was true (handled earlier).
     // The validate_only flag determines if we stop *after* this phase.
-    const bool validation_succeeded = run_validator(program, arena);
-    if (!validation_succeeded) {
-        return false; // Validation failed, stop.
+    // With fuse_validation, IR generation performs the checks itself and this phase is skipped
+    // (its time is then part of the IR generation phase).
+    const bool fused = options->fuse_validation && !validate_only;
+    if (!fused) {
+        compile_stats_begin_phase(stats, COMPILE_PHASE_VALIDATE, arena);
+        const bool validation_succeeded = run_validator(&parsed, arena, quiet, diagnostics);
+        compile_stats_end_phase(stats, COMPILE_PHASE_VALIDATE, arena);
+        if (!validation_succeeded) {
+            return false; // Validation failed, stop.
+        }
     }
 
     // If validate_only is true, and validation succeeded, stop here.
@@ -85,27 +425,110 @@ bool compile(const char *source_code,
         return true;
     }
 
+    // --- Function Cache ---
+    // A function compiled before (same fingerprint, same options) reuses its assembly and skips IR
+    // generation, optimization and code generation. A program holds a single function for now, so
+    // the whole listing is either that function's cached chunk or generated and then cached.
+    FunctionCache *function_cache = options->function_cache;
+    if (!sink || object || options->emit_obj || tac_only || codegen_only || fused) {
+        function_cache = NULL;
+    }
+    AstFingerprint fingerprint = {{0, 0}};
+    if (function_cache) {
+        fingerprint = ast_fingerprint((const AstNode *) parsed.program->function);
+        const FunctionCacheEntry *cached = function_cache_lookup(function_cache, fingerprint, options);
+        if (stats) {
+            stats->function_cache_used = true;
+            stats->function_cache_hits = cached ? 1 : 0;
+            stats->function_cache_misses = cached ? 0 : 1;
+        }
+        if (cached) {
+            progress(quiet, "Reusing the cached assembly of %s.\n", parsed.program->function->name);
+            string_buffer_append_n(output_sink_buffer(sink), cached->assembly, cached->assembly_length);
+            if (stats) {
+                stats->assembly_bytes = output_sink_total_bytes(sink);
+            }
+            return output_sink_flush(sink);
+        }
+    }
+
     // --- IR Generation Phase (AST -> TAC) ---
     TacProgram *tac_program; // Declare variable to hold the result
-    const bool irgen_success = run_irgen(program, arena, &tac_program, codegen_only || tac_only);
+    compile_stats_begin_phase(stats, COMPILE_PHASE_IRGEN, arena);
+    const bool irgen_success = run_irgen(&parsed, fused, options->optimization_level >= 1, arena, &tac_program,
+                                         codegen_only || tac_only, quiet, diagnostics);
+    compile_stats_end_phase(stats, COMPILE_PHASE_IRGEN, arena);
     if (!irgen_success) {
         // Error message printed by run_irgen
         return false; // IR generation failed
     }
+    if (stats) {
+        for (size_t i = 0; i < tac_program->function_count; ++i) {
+            const TacFunction *func = tac_program->functions[i];
+            stats->tac_instruction_count += func->instruction_count;
+            stats->tac_instruction_capacity += func->instruction_capacity;
+            stats->tac_regrowth_count += func->instruction_regrowths;
+        }
+        stats->optimized_tac_instruction_count = stats->tac_instruction_count;
+    }
+
+    // --- TAC Optimization Phase (-O1 and above) ---
+    if (options->optimization_level >= 1) {
+        compile_stats_begin_phase(stats, COMPILE_PHASE_OPTIMIZE, arena);
+        const bool optimized = run_optimizer(tac_program, options->optimization_level, options->function_jobs,
+                                             arena, codegen_only || tac_only, quiet, diagnostics);
+        compile_stats_end_phase(stats, COMPILE_PHASE_OPTIMIZE, arena);
+        if (!optimized) {
+            return false;
+        }
+        if (stats) {
+            stats->optimized_tac_instruction_count = 0;
+            for (size_t i = 0; i < tac_program->function_count; ++i) {
+                stats->optimized_tac_instruction_count += tac_program->functions[i]->instruction_count;
+            }
+        }
+    }
 
     // If tac_only is requested, stop here after successful IR generation
     if (tac_only) {
         return true;
     }
+    if (out_tac) {
+        *out_tac = tac_program;
+        return true;
+    }
 
     // --- Code Generation Phase ---
-    // Ensure output buffer is valid if we reach codegen
-    if (!output_assembly_sb) {
-        fprintf(stderr, "Compiler Error: Output string buffer is NULL during code generation.\n");
+    // Ensure output sink is valid if we reach codegen
+    if (!sink && !object) {
+        compile_error(diagnostics, "Compiler Error: Output string buffer is NULL during code generation.");
         return false;
     }
 
-    const bool codegen_success = run_codegen(tac_program, output_assembly_sb, codegen_only);
+    CodegenOptions codegen_options;
+    set_codegen_options(options, stats, &codegen_options);
+
+    // With the function cache the assembly is collected first, to be stored before it goes to the sink
+    StringBuffer function_assembly;
+    OutputSink function_sink;
+    if (function_cache) {
+        string_buffer_init_chunked(&function_assembly, arena, 0);
+        output_sink_init_buffer(&function_sink, &function_assembly);
+    }
+
+    compile_stats_begin_phase(stats, COMPILE_PHASE_CODEGEN, arena);
+    bool codegen_success = object ? run_codegen_to_object(tac_program, object, &codegen_options, quiet, diagnostics)
+                                  : run_codegen(tac_program, function_cache ? &function_sink : sink,
+                                                &codegen_options, codegen_only, quiet, diagnostics);
+    compile_stats_end_phase(stats, COMPILE_PHASE_CODEGEN, arena);
+    if (codegen_success && function_cache) {
+        function_cache_insert(function_cache, fingerprint, options, &function_assembly);
+        string_buffer_append_buffer(output_sink_buffer(sink), &function_assembly);
+        codegen_success = output_sink_flush(sink);
+    }
+    if (stats) {
+        stats->assembly_bytes = object ? object->text_size : output_sink_total_bytes(sink);
+    }
 
     return codegen_success; // Return success status of the final stage
 }
@@ -114,30 +537,49 @@ bool compile(const char *source_code,
 // Helper Functions for Compilation Stages
 // -----------------------------------------------------------------------------
 
-static bool run_lexer(Lexer *lexer, const bool print_tokens) {
+static void progress(const bool quiet, const char *format, ...) {
+    if (quiet) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+static void compile_error(Diagnostics *diagnostics, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (diagnostics) {
+        diagnostics_error_va(diagnostics, format, args);
+    } else {
+        vfprintf(stderr, format, args);
+        fputc('\n', stderr);
+    }
+    va_end(args);
+}
+
+static bool run_lexer(Lexer *lexer, const bool print_tokens, const bool quiet, Diagnostics *diagnostics,
+                      TokenArray *out_tokens) {
     // Assumes lexer is already initialized
-    Token tok;
-    printf("Lexing...\n");
-    while (true) {
-        const bool success = lexer_next_token(lexer, &tok);
-        if (!success) {
-            // Error message already printed by lexer for allocation failure
-            fprintf(stderr, "Lexical error: Lexer failed (likely allocation error).\n");
-            return false; // Indicate failure
-        }
+    progress(quiet, "Lexing...\n");
+    if (!lexer_tokenize(lexer, out_tokens)) {
+        // Error message already printed by lexer for allocation failure
+        compile_error(diagnostics, "Lexical error: Lexer failed (likely allocation error).");
+        return false; // Indicate failure
+    }
 
+    for (size_t i = 0; i < out_tokens->count; ++i) {
+        const Token tok = token_array_get(out_tokens, i);
         if (tok.type == TOKEN_EOF) {
             break; // End of input reached successfully
         }
 
         if (tok.type == TOKEN_UNKNOWN) {
-            char token_str[128];
-            token_to_string(tok, token_str, sizeof(token_str));
-            fprintf(stderr, "Lexical error: unknown token %s at position %zu\n", token_str, tok.position);
+            report_unknown_token(diagnostics, tok);
             // No token_free needed; lexeme (if any) is in arena
 
-            // Decide whether to continue lexing or stop on first error.
-            // For now, stop on first lexical error.
+            // Lexing stops at the first unknown token, so this is always the last one.
             return false; // Indicate failure
         }
 
@@ -148,105 +590,198 @@ static bool run_lexer(Lexer *lexer, const bool print_tokens) {
         }
     }
 
-    printf("Lexing finished.\n");
+    progress(quiet, "Lexing finished.\n");
     return true; // Lexing completed successfully
 }
 
-static bool run_parser(Parser *parser, const bool print_ast, ProgramNode **out_program) {
+static void report_unknown_token(Diagnostics *diagnostics, const Token token) {
+    char token_str[128];
+    token_to_string(token, token_str, sizeof(token_str));
+    compile_error(diagnostics, "Lexical error: unknown token %s at position %zu", token_str, token.position);
+}
+
+static bool run_parser(Parser *parser, LexerThread *lexer_thread, const bool print_ast, const bool flatten,
+                       const bool quiet, Diagnostics *diagnostics, ParsedProgram *out_parsed) {
     // Assume lexer is already initialized and positioned at the start
-    printf("Parsing...\n");
+    progress(quiet, "Parsing...\n");
     ProgramNode *ast_root_local = parse_program(parser);
+    if (lexer_thread) {
+        lexer_thread_finish(lexer_thread);
+        if (parser->error_flag && lexer_thread->saw_unknown) {
+            report_unknown_token(diagnostics, lexer_thread->unknown);
+            return false;
+        }
+    }
 
     if (parser->error_flag) {
-        fprintf(stderr, "Parsing failed due to errors.\n");
+        if (parser->error_message) {
+            compile_error(diagnostics, "%s", parser->error_message);
+        }
+        compile_error(diagnostics, "Parsing failed due to errors.");
         return false; // Parsing failed
     }
 
-    printf("Parsing successful.\n");
+    // The later phases walk the flat form instead of the pointer tree when it is requested
+    FlatAst *flat = NULL;
+    if (flatten) {
+        flat = flat_ast_from_program(ast_root_local, parser->arena);
+        if (!flat) {
+            compile_error(diagnostics, "Parsing failed: out of memory while flattening the AST.");
+            return false;
+        }
+    }
+
+    progress(quiet, "Parsing successful.\n");
     if (print_ast) {
         printf("AST:\n");
         printf("------------------------------------\n");
-        ast_pretty_print((AstNode *) ast_root_local, 0);
+        if (flat) {
+            flat_ast_pretty_print(flat, flat->root, 0);
+        } else {
+            ast_pretty_print((AstNode *) ast_root_local, 0);
+        }
         printf("------------------------------------\n");
     }
 
-    *out_program = ast_root_local; // Store AST root
+    out_parsed->program = ast_root_local; // Store AST root
+    out_parsed->flat = flat;
 
     return true;
 }
 
 // --- Semantic Validation --- 
-static bool run_validator(ProgramNode *program, Arena *arena) {
-    printf("Validating program...\n");
-    if (!validate_program((AstNode*)program, arena)) {
+static bool run_validator(const ParsedProgram *parsed, Arena *arena, const bool quiet, Diagnostics *diagnostics) {
+    progress(quiet, "Validating program...\n");
+    const bool valid = parsed->flat ? validate_flat_program(parsed->flat, arena)
+                                    : validate_program((AstNode *) parsed->program, arena);
+    if (!valid) {
         // Specific errors are printed by validate_program and its callees.
-        fprintf(stderr, "Semantic validation failed.\n"); 
+        compile_error(diagnostics, "Semantic validation failed.");
         return false;
     }
-    printf("Semantic validation successful.\n");
+    progress(quiet, "Semantic validation successful.\n");
     return true;
 }
 
 // -----------------------------------------------------------------------------
 // IR Generation (AST -> TAC)
 // -----------------------------------------------------------------------------
-static bool run_irgen(ProgramNode *ast_root, Arena *arena, TacProgram **out_tac_program, const bool print_tac) {
-    printf("Generating IR (TAC)...\n");
+// Prints the program under a title; the text is scratch memory, released once it has been written out
+static void print_tac_listing(const char *title, const TacProgram *tac_program, Arena *arena) {
+    printf("%s\n", title);
+    const ArenaMark mark = arena_mark(arena);
+    StringBuffer sb;
+    // Initialize with a reasonable starting capacity, it will grow if needed.
+    string_buffer_init(&sb, arena, 1024);
+    tac_print_program(&sb, tac_program);
+    printf("------------------------------------\n");
+    printf("%s", string_buffer_content_str(&sb));
+    printf("------------------------------------\n");
+    arena_release(arena, mark);
+}
 
-    // The ast_to_tac function uses the same arena provided for the AST
-    TacProgram *tac_program = ast_to_tac(ast_root, arena);
+static bool run_irgen(const ParsedProgram *parsed, const bool fused, const bool branchless_logical, Arena *arena,
+                      TacProgram **out_tac_program, const bool print_tac, const bool quiet,
+                      Diagnostics *diagnostics) {
+    TacProgram *tac_program;
+    const TacLoweringOptions lowering = {.fuse_validation = fused, .branchless_logical = branchless_logical};
+    if (fused) {
+        // Validation and lowering in one walk; any semantic error fails the phase
+        progress(quiet, "Validating program and generating IR (TAC)...\n");
+        tac_program = parsed->flat ? flat_ast_to_tac_with_options(parsed->flat, &lowering, arena)
+                                   : ast_to_tac_with_options(parsed->program, &lowering, arena);
+        if (!tac_program) {
+            compile_error(diagnostics, "Semantic validation or IR generation failed.");
+            return false;
+        }
+    } else {
+        progress(quiet, "Generating IR (TAC)...\n");
 
-    if (!tac_program) {
-        fprintf(stderr, "IR generation (AST to TAC) failed.\n");
-        return false; // Return failure status
+        // The ast_to_tac function uses the same arena provided for the AST
+        tac_program = parsed->flat ? flat_ast_to_tac_with_options(parsed->flat, &lowering, arena)
+                                   : ast_to_tac_with_options(parsed->program, &lowering, arena);
+
+        if (!tac_program) {
+            compile_error(diagnostics, "IR generation (AST to TAC) failed.");
+            return false; // Return failure status
+        }
     }
 
-    printf("IR generation successful.\n");
+    progress(quiet, "IR generation successful.\n");
 
     if (print_tac) {
-        printf("TAC:\n");
-        StringBuffer sb;
-        // Initialize with a reasonable starting capacity, it will grow if needed.
-        // The arena passed to run_irgen (and thus to string_buffer_init)
-        // should be the same one used for tac_program to ensure proper lifecycle.
-        string_buffer_init(&sb, arena, 1024);
-        tac_print_program(&sb, tac_program);
-        printf("------------------------------------\n");
-        printf("%s", string_buffer_content_str(&sb));
-        // No need to explicitly destroy StringBuffer's buffer if arena handles it.
-        // If string_buffer_init allocates outside the arena, a string_buffer_destroy(&sb) would be needed.
-        // Based on string_buffer_init(..., Arena *arena, ...), it uses the arena.
-        printf("------------------------------------\n");
+        print_tac_listing("TAC:", tac_program, arena);
     }
 
     *out_tac_program = tac_program; // Assign to output parameter
     return true; // Return success status
 }
 
-static bool run_codegen(TacProgram *tac_program, StringBuffer *output_assembly_sb, bool print_assembly) {
-    printf("Generating code...\n");
+// -----------------------------------------------------------------------------
+// TAC Optimization
+// -----------------------------------------------------------------------------
+static bool run_optimizer(TacProgram *tac_program, const int optimization_level, const int function_jobs,
+                          Arena *arena, const bool print_tac, const bool quiet, Diagnostics *diagnostics) {
+    progress(quiet, "Optimizing IR (TAC)...\n");
+    OptimizerOptions optimizer_options;
+    optimizer_options_for_level(&optimizer_options, optimization_level);
+    optimizer_options.jobs = function_jobs;
+    bool changed = false;
+    if (!optimize_tac_program(tac_program, &optimizer_options, arena, &changed)) {
+        // A pass that ran out of memory may have left a function half rewritten
+        compile_error(diagnostics, "IR optimization failed.");
+        return false;
+    }
+    progress(quiet, "IR optimization %s.\n", changed ? "simplified the program" : "found nothing to change");
+
+    if (print_tac && changed) {
+        print_tac_listing("Optimized TAC:", tac_program, arena);
+    }
+    return true;
+}
+
+static bool run_codegen(TacProgram *tac_program, OutputSink *sink, const CodegenOptions *codegen_options,
+                        const bool print_assembly, const bool quiet, Diagnostics *diagnostics) {
+    progress(quiet, "Generating code...\n");
 
+    StringBuffer *output_assembly_sb = output_sink_buffer(sink);
     string_buffer_reset(output_assembly_sb);
 
     // Ensure tac_program is not NULL before proceeding
     if (!tac_program) {
-        fprintf(stderr, "Codegen Error: Cannot generate assembly from NULL TAC program input to run_codegen.\n");
+        compile_error(diagnostics, "Codegen Error: Cannot generate assembly from NULL TAC program input to run_codegen.");
         return false;
     }
 
-    if (!codegen_generate_program(tac_program, output_assembly_sb)) {
-        fprintf(stderr, "Code generation failed.\n");
+    if (!codegen_generate_program_to_sink(tac_program, sink, codegen_options)) {
+        compile_error(diagnostics, "Code generation failed.");
         return false; // Codegen failed
     }
 
-    printf("Code generation successful.\n");
-    if (print_assembly) {
+    progress(quiet, "Code generation successful.\n");
+    // Only a buffer sink still holds the whole listing; a file sink has written it out already
+    if (print_assembly && !sink->file) {
         printf("Assembly:\n");
-        const char *assembly_code = string_buffer_content_str(output_assembly_sb);
-        printf("------------------------------------\n");
-        printf("%s\n", assembly_code ? assembly_code : "<EMPTY>");
         printf("------------------------------------\n");
+        if (output_assembly_sb->length == 0) {
+            printf("<EMPTY>");
+        } else {
+            string_buffer_write(output_assembly_sb, stdout); // Works for chunked buffers too
+        }
+        printf("\n------------------------------------\n");
     }
 
     return true;
 }
+
+static bool run_codegen_to_object(TacProgram *tac_program, ObjectWriter *object,
+                                  const CodegenOptions *codegen_options, const bool quiet,
+                                  Diagnostics *diagnostics) {
+    progress(quiet, "Generating code...\n");
+    if (!codegen_generate_program_to_object(tac_program, object, codegen_options)) {
+        compile_error(diagnostics, "Code generation failed.");
+        return false;
+    }
+    progress(quiet, "Code generation successful.\n");
+    return true;
+}
@@ -3,7 +3,13 @@
 
 #include <stdbool.h>
 #include "../strings/strings.h" // For StringBuffer
+#include "../strings/output_sink.h" // For OutputSink
 #include "../memory/arena.h"  // For Arena
+#include "options.h"          // For CompileOptions
+#include "report.h"           // For CompileStats
+#include "code_cache.h"       // For CodeCache
+#include "diagnostics.h"      // For Diagnostics
+#include "../ir/tac.h"          // For TacProgram
 
 /**
  * @brief Core compilation logic: Source String -> Assembly String Buffer.
@@ -31,4 +37,168 @@ bool compile(const char *source_code,
              StringBuffer *output_assembly_sb,
              Arena *arena);
 
+/**
+ * @brief Same as compile(), with the stop-early modes taken from an options struct
+ *        and optional per-phase statistics.
+ *
+ * @param source_code The C source code string to compile.
+ * @param options Which stages to run (see CompileOptions).
+ * @param output_assembly_sb Initialized StringBuffer receiving the assembly (required if codegen runs).
+ * @param arena The arena to use for memory allocation.
+ * @param stats If non-NULL, zeroed and then filled with wall time, arena usage and
+ *              token/AST/TAC counts for every phase that ran.
+ * @return true if the requested compilation stage (or full compilation) succeeded, false otherwise.
+ */
+bool compile_with_options(const char *source_code,
+                          const CompileOptions *options,
+                          StringBuffer *output_assembly_sb,
+                          Arena *arena,
+                          CompileStats *stats);
+
+/**
+ * @brief Same as compile_with_options(), with the assembly delivered to an output sink.
+ *        With a file sink the assembly is written out function by function as it is generated.
+ *
+ * @param source_code The C source code string to compile.
+ * @param options Which stages to run (see CompileOptions).
+ * @param sink Initialized sink receiving the assembly (required if codegen runs).
+ *             The caller finishes the sink; --codegen printing needs a buffer sink.
+ * @param arena The arena to use for memory allocation.
+ * @param stats If non-NULL, filled as for compile_with_options().
+ * @return true if the requested compilation stage (or full compilation) succeeded, false otherwise.
+ */
+bool compile_with_sink(const char *source_code,
+                       const CompileOptions *options,
+                       OutputSink *sink,
+                       Arena *arena,
+                       CompileStats *stats);
+
+/**
+ * @brief Same as compile_with_sink(), for a source of known length (e.g. a mapped file),
+ *        which is then never scanned for its terminator.
+ *
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param options Which stages to run (see CompileOptions).
+ * @param sink Initialized sink receiving the assembly (required if codegen runs).
+ * @param arena The arena to use for memory allocation.
+ * @param stats If non-NULL, filled as for compile_with_options().
+ * @return true if the requested compilation stage (or full compilation) succeeded, false otherwise.
+ */
+bool compile_source_with_sink(const char *source_code,
+                              size_t source_length,
+                              const CompileOptions *options,
+                              OutputSink *sink,
+                              Arena *arena,
+                              CompileStats *stats);
+
+/**
+ * @brief Same as compile_source_with_sink(), with the errors of a failed phase recorded in
+ *        diagnostics instead of stderr (as for cleric_compile()), e.g. to send them elsewhere.
+ *
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param options Which stages to run (see CompileOptions).
+ * @param sink Initialized sink receiving the assembly (required if codegen runs).
+ * @param arena The arena to use for memory allocation.
+ * @param diagnostics Receives the errors; NULL prints them to stderr.
+ * @return true if the requested compilation stage (or full compilation) succeeded, false otherwise.
+ */
+bool compile_source_with_diagnostics(const char *source_code,
+                                     size_t source_length,
+                                     const CompileOptions *options,
+                                     OutputSink *sink,
+                                     Arena *arena,
+                                     Diagnostics *diagnostics);
+
+/**
+ * @brief Library entry point (libcleric): compiles a source to assembly (or, with emit_obj, an ELF
+ *        object) without touching stdout or process-wide state, so any number of threads may compile
+ *        at once. Each call works in an arena of its own, freed before returning.
+ *
+ * @param options Code-affecting options; never written to. Stop-early modes are rejected and progress
+ *                messages are never printed. A function_cache, if set, must not be shared by
+ *                concurrent calls.
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param sink Initialized sink receiving the output. The caller finishes the sink.
+ * @param diagnostics If non-NULL, receives the errors of each failed phase instead of stderr (the
+ *                    validator's per-name messages still go to stderr).
+ * @return true if the source compiled, false otherwise.
+ */
+bool cleric_compile(const CompileOptions *options,
+                    const char *source_code,
+                    size_t source_length,
+                    OutputSink *sink,
+                    Diagnostics *diagnostics);
+
+/**
+ * @brief Compiles a program and runs its `main` in this process, without assembler or linker:
+ *        the code is encoded into memory mapped executable (see jit.h) and called directly.
+ *
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param options Compilation options; stop-early modes are rejected.
+ * @param cache If non-NULL, consulted first and given the code on a miss, so the same source
+ *              (with the same code-affecting options) is compiled only once; NULL compiles,
+ *              runs and releases the code every time.
+ * @param out_result Receives what `main` returned.
+ * @return true if the program was compiled (or found) and run, false otherwise.
+ */
+bool compile_and_run(const char *source_code,
+                     size_t source_length,
+                     const CompileOptions *options,
+                     CodeCache *cache,
+                     int *out_result);
+
+/**
+ * @brief Compiles a program down to (optimized) TAC and runs its `main` in the TAC interpreter
+ *        (see tac_interpreter.h): no machine code is generated, so it works on any host.
+ *
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param options Compilation options; stop-early modes are rejected, and -O selects the TAC passes.
+ * @param out_result Receives what `main` returned.
+ * @return true if the program was compiled and ran to its return, false otherwise.
+ */
+bool compile_and_interpret(const char *source_code,
+                           size_t source_length,
+                           const CompileOptions *options,
+                           int *out_result);
+
+/**
+ * @brief Compiles a source down to TAC (optimized at -O1) and hands the program out instead of
+ *        generating code, e.g. to be written as a .ctac module (tac_file.h).
+ *
+ * @param source_code The C source code to compile (need not be null-terminated).
+ * @param source_length Number of bytes of source_code to compile.
+ * @param options Compilation options; stop-early modes are rejected.
+ * @param arena The arena the program is allocated in.
+ * @param out_tac Receives the program.
+ * @return true if the source compiled, false otherwise.
+ */
+bool compile_source_to_tac(const char *source_code,
+                           size_t source_length,
+                           const CompileOptions *options,
+                           Arena *arena,
+                           TacProgram **out_tac);
+
+/**
+ * @brief Finishes a TAC program built elsewhere (e.g. loaded from .ctac modules): runs the TAC
+ *        optimizer at -O1 and generates code into the sink, as the rest of the pipeline would.
+ *        --tac prints the program (and the optimized one) and stops, --codegen prints the assembly.
+ *
+ * @param tac_program The program; optimized in place.
+ * @param options Compilation options; --lex, --parse and --validate are rejected.
+ * @param sink Initialized sink receiving the assembly (or, with emit_obj, the object).
+ * @param arena The arena for the optimizer's and code generator's memory.
+ * @param stats If non-NULL, zeroed and then filled for the phases that ran (optimize, codegen).
+ * @return true if code generation (or the requested listing) succeeded, false otherwise.
+ */
+bool compile_tac_with_sink(TacProgram *tac_program,
+                           const CompileOptions *options,
+                           OutputSink *sink,
+                           Arena *arena,
+                           CompileStats *stats);
+
 #endif // COMPILER_H
@@ -0,0 +1,30 @@
+#include "diagnostics.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+void diagnostics_init(Diagnostics *diagnostics, StringBuffer *messages) {
+    diagnostics->messages = messages;
+    diagnostics->error_count = 0;
+}
+
+void diagnostics_error_va(Diagnostics *diagnostics, const char *format, va_list args) {
+    diagnostics->error_count++;
+    if (!diagnostics->messages) {
+        return;
+    }
+    char message[DIAGNOSTICS_MAX_MESSAGE];
+    const int length = vsnprintf(message, sizeof(message), format, args);
+    if (length < 0) {
+        return;
+    }
+    const size_t kept = (size_t) length < sizeof(message) ? (size_t) length : sizeof(message) - 1;
+    string_buffer_append_n(diagnostics->messages, message, kept);
+    string_buffer_append_char(diagnostics->messages, '\n');
+}
+
+void diagnostics_error(Diagnostics *diagnostics, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    diagnostics_error_va(diagnostics, format, args);
+    va_end(args);
+}
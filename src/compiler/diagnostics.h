@@ -0,0 +1,42 @@
+#ifndef CLERIC_DIAGNOSTICS_H
+#define CLERIC_DIAGNOSTICS_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../strings/strings.h"
+
+//------------------------------------------------------------------------------
+// Diagnostics
+//
+// Where cleric_compile() reports why a compilation failed, instead of stderr.
+// Every message is appended to a caller-owned buffer as one line, so a service
+// compiling many sources keeps each request's errors apart.
+//------------------------------------------------------------------------------
+
+// Longest message kept; a longer one is cut off
+#define DIAGNOSTICS_MAX_MESSAGE 1024
+
+typedef struct Diagnostics {
+    StringBuffer *messages; // Receives one line per error; NULL only counts them
+    size_t error_count;
+} Diagnostics;
+
+/**
+ * @brief Initializes diagnostics with no errors.
+ * @param diagnostics The diagnostics to initialize.
+ * @param messages Initialized StringBuffer receiving the messages, or NULL to only count them.
+ */
+void diagnostics_init(Diagnostics *diagnostics, StringBuffer *messages);
+
+/**
+ * @brief Records an error; the message (printf-style, without a trailing newline) becomes one line.
+ */
+void diagnostics_error(Diagnostics *diagnostics, const char *format, ...);
+
+/**
+ * @brief Same as diagnostics_error(), with the arguments as a va_list.
+ */
+void diagnostics_error_va(Diagnostics *diagnostics, const char *format, va_list args);
+
+#endif // CLERIC_DIAGNOSTICS_H
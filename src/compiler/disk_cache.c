@@ -0,0 +1,170 @@
+#include "disk_cache.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include "../files/files.h"
+
+// Temporary files start with this prefix; eviction leaves them (and anything else hidden) alone
+#define DISK_CACHE_TEMP_PREFIX ".tmp-"
+
+// Entry names are the key's two hashes: 32 lowercase hex digits
+#define DISK_CACHE_NAME_LENGTH 32
+
+// Only these options change the output a source compiles to
+static uint32_t options_key(const CompileOptions *options) {
+    return (uint32_t) options->optimization_level << 8 | (uint32_t) options->no_omit_frame_pointer << 4 |
+           (uint32_t) options->emit_obj << 3 | (uint32_t) options->no_peephole << 2 |
+           (uint32_t) options->flat_ast << 1 | (uint32_t) options->fuse_validation;
+}
+
+// The two hashes are updated byte by byte together: FNV-1a, and a rotate-multiply hash
+// whose collisions are unrelated to FNV's
+static void hash_bytes(uint64_t hash[2], const char *bytes, const size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char byte = (unsigned char) bytes[i];
+        hash[0] ^= byte;
+        hash[0] *= 1099511628211u;
+        hash[1] = ((hash[1] ^ byte) << 5 | (hash[1] ^ byte) >> 59) * 0x9e3779b97f4a7c15u;
+    }
+}
+
+bool disk_cache_key(const char *directory, const char *source, const size_t source_length,
+                    const CompileOptions *options, DiskCacheKey *out_key) {
+    out_key->hash[0] = 14695981039346656037u;
+    out_key->hash[1] = 0x243f6a8885a308d3u;
+    const char version[] = CLERIC_VERSION;
+    hash_bytes(out_key->hash, version, sizeof(version)); // With the terminator, to end the version
+    const uint32_t key = options_key(options);
+    char key_bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        key_bytes[i] = (char) (key >> (8 * i));
+    }
+    hash_bytes(out_key->hash, key_bytes, sizeof(key_bytes));
+    hash_bytes(out_key->hash, source, source_length);
+
+    const int written = snprintf(out_key->path, sizeof(out_key->path), "%s/%016llx%016llx", directory,
+                                 (unsigned long long) out_key->hash[0], (unsigned long long) out_key->hash[1]);
+    return written > 0 && written < (int) sizeof(out_key->path);
+}
+
+char *disk_cache_load(const DiskCacheKey *key, size_t *out_size) {
+    long size = 0;
+    char *output = read_entire_file(key->path, &size);
+    if (!output) {
+        return NULL;
+    }
+    utime(key->path, NULL); // Most recently used now; an entry evicted meanwhile just stays evicted
+    *out_size = (size_t) size;
+    return output;
+}
+
+typedef struct {
+    time_t used; // Modification time, refreshed on every hit
+    size_t size;
+    char name[DISK_CACHE_NAME_LENGTH + 1];
+} CachedFile;
+
+// Only files named like a key are entries: the directory may be shared with anything else
+static bool is_entry_name(const char *name) {
+    size_t length = 0;
+    for (; name[length] != '\0'; ++length) {
+        const char c = name[length];
+        if (length == DISK_CACHE_NAME_LENGTH || !((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return length == DISK_CACHE_NAME_LENGTH;
+}
+
+static int compare_least_recent_first(const void *a, const void *b) {
+    const time_t used_a = ((const CachedFile *) a)->used;
+    const time_t used_b = ((const CachedFile *) b)->used;
+    return (used_a > used_b) - (used_a < used_b);
+}
+
+// Removes the least recently used entries until the directory holds at most max_bytes
+static void evict(const char *directory, const size_t max_bytes) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return;
+    }
+    CachedFile *files = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t total = 0;
+    char path[1100];
+    const struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        struct stat st;
+        if (!is_entry_name(entry->d_name) ||
+            snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name) >= (int) sizeof(path) ||
+            stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            CachedFile *grown = realloc(files, capacity * sizeof(CachedFile));
+            if (!grown) {
+                break; // Evict from what was seen so far
+            }
+            files = grown;
+        }
+        files[count].used = st.st_mtime;
+        files[count].size = (size_t) st.st_size;
+        strcpy(files[count].name, entry->d_name);
+        total += (size_t) st.st_size;
+        count++;
+    }
+    closedir(dir);
+
+    if (total > max_bytes) {
+        qsort(files, count, sizeof(CachedFile), compare_least_recent_first);
+        // Another process may be evicting too: a file already gone counts as removed
+        for (size_t i = 0; i < count && total > max_bytes; ++i) {
+            snprintf(path, sizeof(path), "%s/%s", directory, files[i].name);
+            if (unlink(path) == 0 || errno == ENOENT) {
+                total -= files[i].size;
+            }
+        }
+    }
+    free(files);
+}
+
+bool disk_cache_store(const char *directory, const DiskCacheKey *key, const char *output, const size_t output_size,
+                      const size_t max_bytes) {
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: could not create cache directory %s: %s\n", directory, strerror(errno));
+        return false;
+    }
+    char temp_path[1100];
+    if (snprintf(temp_path, sizeof(temp_path), "%s/" DISK_CACHE_TEMP_PREFIX "XXXXXX", directory) >=
+        (int) sizeof(temp_path)) {
+        return false;
+    }
+    const int fd = mkstemp(temp_path);
+    if (fd < 0) {
+        fprintf(stderr, "Warning: could not write to cache directory %s: %s\n", directory, strerror(errno));
+        return false;
+    }
+    fchmod(fd, 0644);
+    FILE *out = fdopen(fd, "wb");
+    bool written = out && fwrite(output, 1, output_size, out) == output_size;
+    if (out) {
+        written = fclose(out) == 0 && written;
+    } else {
+        close(fd);
+    }
+    // Readers see the whole entry or none of it
+    if (!written || rename(temp_path, key->path) != 0) {
+        fprintf(stderr, "Warning: could not store %s in the cache\n", key->path);
+        remove(temp_path);
+        return false;
+    }
+    evict(directory, max_bytes);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef CLERIC_DISK_CACHE_H
+#define CLERIC_DISK_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "options.h"
+
+//------------------------------------------------------------------------------
+// On-disk cache of compiled output, keyed by preprocessed source
+//
+// With --cache-dir=DIR the driver looks every preprocessed source up here before
+// compiling it; on a hit the stored assembly (or object, with --emit-obj) is used
+// and compile() never runs. An entry is named after two independent 64-bit
+// hashes of the source, cleric's version and the options that change the output,
+// so unrelated sources sharing a name would need both hashes to collide.
+//
+// Entries are written to a temporary file and renamed into place, so concurrent
+// -j workers (or several cleric processes) sharing a directory never read a
+// partial entry. A hit refreshes the entry's modification time; once the
+// directory holds more than its limit, the entries least recently used go first.
+//------------------------------------------------------------------------------
+
+// Mixed into every key: output cached by another version of cleric is never used
+#ifndef CLERIC_VERSION
+#define CLERIC_VERSION "unknown"
+#endif
+
+// Size limit of the cache directory when --cache-max-mb is not given
+#define DISK_CACHE_DEFAULT_MAX_BYTES ((size_t) 256 * 1024 * 1024)
+
+typedef struct {
+    uint64_t hash[2];
+    char path[1024]; // The entry's file in the cache directory
+} DiskCacheKey;
+
+/**
+ * @brief Computes the key of a preprocessed source compiled with the given options.
+ * @return false if the entry's path does not fit.
+ */
+bool disk_cache_key(const char *directory, const char *source, size_t source_length, const CompileOptions *options,
+                    DiskCacheKey *out_key);
+
+/**
+ * @brief Reads a cached output and marks it as just used.
+ * @param key The entry to read.
+ * @param out_size Receives the number of bytes.
+ * @return The output (malloc'd, null-terminated, to be freed by the caller), or NULL on a miss.
+ */
+char *disk_cache_load(const DiskCacheKey *key, size_t *out_size);
+
+/**
+ * @brief Stores an output atomically, then evicts the least recently used entries while the
+ *        directory holds more than max_bytes. Creates the directory if needed.
+ * @return false if the entry could not be written (the build goes on without it).
+ */
+bool disk_cache_store(const char *directory, const DiskCacheKey *key, const char *output, size_t output_size,
+                      size_t max_bytes);
+
+#endif // CLERIC_DISK_CACHE_H
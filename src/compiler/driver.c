@@ -1,17 +1,94 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "driver.h"
 #include "../strings/strings.h" // Include StringBuffer header
 #include "../files/files.h"
+#include "../files/function_reader.h"
+#include "../ir/tac_file.h"
 #include "../memory/arena.h" // Include Arena header
 #include "compiler.h" // Added: Include new compiler header
+#include "server.h"
+#include "disk_cache.h"
+#include "trace.h"
+
+// Size of the first arena chunk for a compilation run; the arena grows on demand beyond it
+#define DRIVER_ARENA_FIRST_CHUNK_SIZE (64 * 1024)
+
+// Codegen emits Mach-O style symbols (leading underscore); on ELF targets the C runtime
+// expects a plain `main`, so alias it at link time.
+#ifdef __APPLE__
+#define LINKER_EXTRA_FLAGS ""
+#define LINKER_EXTRA_ARG NULL
+#else
+#define LINKER_EXTRA_FLAGS " -Wl,--defsym,main=_main"
+#define LINKER_EXTRA_ARG "-Wl,--defsym,main=_main"
+#endif
+
+extern char **environ; // Passed on to the programs the pipeline starts
+
+// The arena for a compilation: malloc'd chunks, or with --arena-reserve-mb a reserved range committed on demand
+static Arena create_compile_arena(const CompileOptions *options) {
+    const ArenaOptions arena_options = {.reserve_size = options->arena_reserve_bytes,
+                                        .huge_pages = options->huge_pages};
+    return arena_create_with_options(DRIVER_ARENA_FIRST_CHUNK_SIZE, &arena_options);
+}
+
+// --emit-obj writes ELF objects; the Mach-O linker on macOS cannot take them
+static bool object_output_supported(const CompileOptions *options) {
+#ifdef __APPLE__
+    if (options->emit_obj) {
+        fprintf(stderr, "Error: --emit-obj writes ELF objects, which the macOS linker does not take.\n");
+        return false;
+    }
+#else
+    (void) options;
+#endif
+    return true;
+}
+
+// system(), traced as one event lasting until the command returns
+static int run_command(const char *command) {
+    trace_begin("process", command);
+    const int ret = system(command);
+    trace_end("process", command);
+    return ret;
+}
+
+// Opens the trace event of a child started without a shell; wait_for_child closes it
+static void trace_child(char *const argv[]) {
+    if (!trace_recording) {
+        return;
+    }
+    char command[TRACE_NAME_MAX];
+    size_t length = 0;
+    command[0] = '\0';
+    for (int i = 0; argv[i] && length < sizeof(command); ++i) {
+        const int written = snprintf(command + length, sizeof(command) - length, "%s%s", i ? " " : "", argv[i]);
+        length += written > 0 ? (size_t) written : 0;
+    }
+    trace_begin("process", command);
+}
 
 /**
  * Runs the gcc preprocessor on the input file and writes output to .i file.
  * Returns 0 on success, 1 on failure.
  */
 int run_preprocessor(const char *input_file) {
+    CompileOptions options;
+    compile_options_init(&options);
+    return run_preprocessor_with_options(input_file, &options);
+}
+
+int run_preprocessor_with_options(const char *input_file, const CompileOptions *options) {
     // Use utility to check extension
     if (!filename_has_ext(input_file, ".c")) {
         fprintf(stderr, "Input file should have a .c extension\n");
@@ -26,92 +103,216 @@ int run_preprocessor(const char *input_file) {
 
     char command[2048];
     snprintf(command, sizeof(command), "gcc -E -P %s -o %s", input_file, output_file);
-    const int ret = system(command);
+    const int ret = run_command(command);
     if (ret != 0) {
         fprintf(stderr, "Failed to preprocess %s\n", input_file);
         return 1;
     }
-    printf("Preprocessed output written to %s\n", output_file);
+    if (!options->quiet) {
+        printf("Preprocessed output written to %s\n", output_file);
+    }
     return 0;
 }
 
+// Compiles for a stop-early mode. Output (if any) goes to stdout, so the listing is kept in memory.
+static bool compile_in_memory(const char *source, const size_t source_size, const CompileOptions *options,
+                              Arena *arena, CompileStats *stats) {
+    // Chunked: a large listing grows segment by segment instead of being copied on every doubling
+    StringBuffer sb;
+    string_buffer_init_chunked(&sb, arena, 0);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    return compile_source_with_sink(source, source_size, options, &sink, arena, stats);
+}
+
+// With --cache-dir (and a full compilation), computes the source's key and returns the output stored
+// for it, or NULL on a miss; *out_key is left empty when the cache is not used
+static char *cache_lookup(const char *source, const size_t source_size, const CompileOptions *options,
+                          DiskCacheKey *out_key, size_t *out_size) {
+    out_key->path[0] = '\0';
+    if (!options->cache_dir || compile_options_stops_early(options)) {
+        return NULL;
+    }
+    if (!disk_cache_key(options->cache_dir, source, source_size, options, out_key)) {
+        fprintf(stderr, "Warning: cache directory path too long, not caching\n");
+        out_key->path[0] = '\0';
+        return NULL;
+    }
+    return disk_cache_load(out_key, out_size);
+}
+
+// Stores a freshly compiled output under a key from cache_lookup (nothing if the cache is not used)
+static void cache_store(const CompileOptions *options, const DiskCacheKey *key, const char *output,
+                        const size_t output_size) {
+    if (key->path[0] != '\0') {
+        disk_cache_store(options->cache_dir, key, output, output_size, options->cache_max_bytes);
+    }
+}
+
+// Records the outcome of cache_lookup for --time-report. A hit leaves nothing else to report.
+static void count_cache_lookup(CompileStats *stats, const DiskCacheKey *key, const bool hit) {
+    if (!stats || key->path[0] == '\0') {
+        return;
+    }
+    if (hit) {
+        *stats = (CompileStats){0};
+    }
+    stats->cache_used = true;
+    stats->cache_hits = hit ? 1 : 0;
+    stats->cache_misses = hit ? 0 : 1;
+}
+
+// Writes an output (assembly or object) to a file
+static bool write_output_file(const char *output_file, const char *output, const size_t output_size) {
+    FILE *out = fopen(output_file, "wb");
+    bool written = out && fwrite(output, 1, output_size, out) == output_size;
+    if (out && fclose(out) != 0) {
+        written = false;
+    }
+    if (!written) {
+        fprintf(stderr, "Failed to write %s\n", output_file);
+    }
+    return written;
+}
+
 // Function: compilation from .i file to .s file (using the core compiler logic)
 int run_compiler(const char *input_file, const bool lex_only, const bool parse_only, const bool validate_only, const bool tac_only,
                  const bool codegen_only) {
+    CompileOptions options;
+    compile_options_init(&options);
+    options.lex_only = lex_only;
+    options.parse_only = parse_only;
+    options.validate_only = validate_only;
+    options.tac_only = tac_only;
+    options.codegen_only = codegen_only;
+    return run_compiler_with_options(input_file, &options);
+}
+
+int run_compiler_with_options(const char *input_file, const CompileOptions *options) {
     // Use utility to check extension
     if (!filename_has_ext(input_file, ".i")) {
         fprintf(stderr, "Error: Input file '%s' does not have '.i' extension.\n", input_file);
         return 1;
     }
 
+    if (!object_output_supported(options)) {
+        return 1;
+    }
+    // --emit-obj replaces the assembly file with the object the assembler would have made from it
+    const char *output_ext = options->emit_obj ? ".o" : ".s";
+    const char *output_kind = options->emit_obj ? "Object code" : "Assembly code";
     char output_file[1024];
-    if (!filename_replace_ext(input_file, ".s", output_file, sizeof(output_file))) {
-        fprintf(stderr, "Failed to construct .s filename for %s\n", input_file);
+    if (!filename_replace_ext(input_file, output_ext, output_file, sizeof(output_file))) {
+        fprintf(stderr, "Failed to construct %s filename for %s\n", output_ext, input_file);
         return 1;
     }
 
-    long f_size = 0;
-    char *src = read_entire_file(input_file, &f_size);
-    if (!src) {
+    // Mapped rather than read: the lexer walks the pages in place, without a copy
+    MappedFile source;
+    if (!map_entire_file(input_file, &source)) {
         fprintf(stderr, "Error reading input file '%s'.\n", input_file);
-        free(src); // Free the buffer from read_file (though it should be NULL)
         return 1;
     }
 
     // Create the main arena for this compilation run
-    Arena main_arena = arena_create(1024 * 1024); // Example size: 1MB
+    Arena main_arena = create_compile_arena(options);
     if (!main_arena.start) {
         fprintf(stderr, "Driver Error: Failed to create main arena.\n");
+        unmap_file(&source);
         return 1; // Indicate failure
     }
 
-    StringBuffer sb;
-    string_buffer_init(&sb, &main_arena, 1024); // Initialize buffer for core function output
     // ReSharper disable once CppDFAUnusedValue
     int result = 1; // Default to error
 
-    const bool core_success = compile(src, lex_only, parse_only, validate_only, tac_only, codegen_only, &sb, &main_arena);
+    CompileStats stats;
+    const bool want_report = options->time_report != TIME_REPORT_NONE;
+    bool core_success;
+    DiskCacheKey cache_key;
+    size_t cached_size = 0;
+    char *cached = cache_lookup(source.data, source.size, options, &cache_key, &cached_size);
+    if (cached) {
+        // compile() never runs: the stored output becomes the .s/.o file
+        if (!options->quiet) {
+            printf("Reusing cached %s for %s\n", options->emit_obj ? "object code" : "assembly code", output_file);
+        }
+        core_success = write_output_file(output_file, cached, cached_size);
+        free(cached);
+    } else if (compile_options_stops_early(options)) {
+        core_success = compile_in_memory(source.data, source.size, options, &main_arena, want_report ? &stats : NULL);
+    } else {
+        // Full compilation: stream the assembly to the .s file one function at a time
+        // (an object is written once complete)
+        if (!options->quiet) {
+            printf("Writing %s to %s...\n", options->emit_obj ? "object code" : "assembly code", output_file);
+        }
+        FILE *out = fopen(output_file, "wb");
+        if (!out) {
+            perror("Failed to open file for writing");
+            fprintf(stderr, "Filename: %s\n", output_file);
+            unmap_file(&source);
+            arena_destroy(&main_arena);
+            return 1;
+        }
+        OutputSink sink;
+        output_sink_init_file(&sink, out, &main_arena);
+        core_success = compile_source_with_sink(source.data, source.size, options, &sink, &main_arena,
+                                                want_report ? &stats : NULL);
+        if (core_success && !output_sink_finish(&sink)) {
+            fprintf(stderr, "Failed to write %s\n", output_file);
+            core_success = false;
+        }
+        if (fclose(out) != 0 && core_success) {
+            fprintf(stderr, "Failed to write %s\n", output_file);
+            core_success = false;
+        }
+        if (core_success && cache_key.path[0] != '\0') {
+            // The output went straight to disk; read it back to store it
+            MappedFile output;
+            if (map_entire_file(output_file, &output)) {
+                cache_store(options, &cache_key, output.data, output.size);
+                unmap_file(&output);
+            }
+        }
+    }
+    count_cache_lookup(want_report ? &stats : NULL, &cache_key, cached != NULL);
+    if (want_report) {
+        // stderr keeps the report apart from --lex/--parse/... output on stdout
+        compile_stats_print(&stats, options->time_report, stderr);
+    }
 
     if (core_success) {
         // If only lexing, parsing, irgen or codegen-to-stdout was requested, we are done successfully.
-        if (lex_only || parse_only || validate_only || tac_only || codegen_only) {
-            result = 0;
-        } else {
-            // Full compilation succeeded, write assembly to file
-            printf("Writing assembly code to %s...\n", output_file);
-            const char *assembly_code = string_buffer_content_str(&sb); // Use read-only access
-            if (!write_string_to_file(output_file, assembly_code)) {
-                fprintf(stderr, "Failed to write assembly to %s\n", output_file);
-                remove(output_file); // Attempt removal
-                result = 1; // Mark as failure
-            } else {
-                printf("Assembly code written to %s\n", output_file);
-                // Remove intermediate .i file only on full success
-                if (remove(input_file) != 0) {
-                    fprintf(stderr, "Warning: could not remove intermediate file %s\n", input_file);
-                }
-                result = 0; // Mark as success
+        if (!compile_options_stops_early(options)) {
+            if (!options->quiet) {
+                printf("%s written to %s\n", output_kind, output_file);
+            }
+            // Remove intermediate .i file only on full success
+            if (remove(input_file) != 0) {
+                fprintf(stderr, "Warning: could not remove intermediate file %s\n", input_file);
             }
         }
+        result = 0; // Mark as success
     } else {
         // Core compilation failed, error messages already printed by core function
-        // Make sure output file is removed if it exists from a previous run
+        // Make sure a partial (or stale) output file does not survive
         remove(output_file);
         result = 1;
     }
 
     // --- Cleanup ---
-    free(src); // Free source code buffer
+    unmap_file(&source); // Unmap (or free) the source code
     arena_destroy(&main_arena); // Destroy the arena
 
     return result;
 }
 
-// Final step: assemble and link .s to executable, then remove .s if successful
-int run_assembler_linker(const char *input_file) {
+// Runs gcc on a .s or .o file to produce the executable, then removes the input if successful
+static int build_executable(const char *input_file, const char *extension, const char *done_message,
+                            const bool quiet) {
     // Use utility to check extension
-    if (!filename_has_ext(input_file, ".s")) {
-        fprintf(stderr, "Input file should have a .s extension\n");
+    if (!filename_has_ext(input_file, extension)) {
+        fprintf(stderr, "Input file should have a %s extension\n", extension);
         return 1;
     }
 
@@ -123,22 +324,856 @@ int run_assembler_linker(const char *input_file) {
     }
 
     char command[2048];
-    snprintf(command, sizeof(command), "gcc %s -o %s", input_file, output_file);
-    const int ret = system(command);
+    snprintf(command, sizeof(command), "gcc %s -o %s" LINKER_EXTRA_FLAGS, input_file, output_file);
+    const int ret = run_command(command);
     if (ret != 0) {
-        fprintf(stderr, "Failed to assemble/link %s\n", input_file);
+        fprintf(stderr, "Failed to %s %s\n", extension[1] == 's' ? "assemble/link" : "link", input_file);
         return 1;
     }
-    // Remove the .s file if all is fine
+    // Remove the .s/.o file if all is fine
     if (remove(input_file) != 0) {
         fprintf(stderr, "Warning: could not remove %s\n", input_file);
     }
-    printf("Assembled and linked output: %s\n", output_file);
+    if (!quiet) {
+        printf("%s: %s\n", done_message, output_file);
+    }
     return 0;
 }
 
+// Final step: assemble and link .s to executable, then remove .s if successful
+int run_assembler_linker(const char *input_file) {
+    return build_executable(input_file, ".s", "Assembled and linked output", false);
+}
+
+// Final step with --emit-obj: link .o to executable, then remove .o if successful
+int run_linker(const char *input_file) {
+    return build_executable(input_file, ".o", "Linked output", false);
+}
+
+int run_assembler_linker_with_options(const char *input_file, const CompileOptions *options) {
+    return options->emit_obj ? build_executable(input_file, ".o", "Linked output", options->quiet)
+                             : build_executable(input_file, ".s", "Assembled and linked output", options->quiet);
+}
+
 // -----------------------------------------------------------------------------
 // Core Compilation Logic (Source String -> Assembly String Buffer)
 // -----------------------------------------------------------------------------
 // The run_compiler_core function has been moved to src/driver/compiler.c
 // and renamed to compile().
+
+// -----------------------------------------------------------------------------
+// Pipeline Mode (.c -> executable with no intermediate files)
+// -----------------------------------------------------------------------------
+
+// Which standard stream of the child a pipe replaces
+typedef enum {
+    PIPE_FROM_CHILD_STDOUT, // The parent reads what the child writes
+    PIPE_TO_CHILD_STDIN     // The parent writes what the child reads
+} PipeDirection;
+
+// Starts argv[0] (searched in PATH, without a shell) with one standard stream on a new pipe.
+// Returns the child's pid, or -1 on failure; *out_fd receives the parent's end of the pipe.
+static pid_t spawn_piped(char *const argv[], const PipeDirection direction, int *out_fd) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("Failed to create pipe");
+        return -1;
+    }
+    // With -j, other threads spawn children too: none of them may inherit this pipe, or the reader
+    // would not see end-of-file until that unrelated child exits (the dup2 below clears the flag
+    // on the child's own copy)
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    const bool child_writes = direction == PIPE_FROM_CHILD_STDOUT;
+    const int child_end = child_writes ? fds[1] : fds[0];
+    const int parent_end = child_writes ? fds[0] : fds[1];
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, child_end, child_writes ? STDOUT_FILENO : STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, child_end);
+    posix_spawn_file_actions_addclose(&actions, parent_end);
+
+    fflush(stdout); // Keep our progress messages ahead of the child's output
+    pid_t pid;
+    const int spawn_error = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(child_end);
+    if (spawn_error != 0) {
+        fprintf(stderr, "Failed to start %s: %s\n", argv[0], strerror(spawn_error));
+        close(parent_end);
+        return -1;
+    }
+    trace_child(argv);
+    *out_fd = parent_end;
+    return pid;
+}
+
+// Waits for a child started by spawn_piped. Returns true if it exited with status 0.
+static bool wait_for_child(const pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("Failed to wait for child process");
+            trace_end("process", NULL);
+            return false;
+        }
+    }
+    trace_end("process", NULL);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Runs `gcc -E -P` on the .c file and collects its output. Returns the null-terminated
+// source (to be freed by the caller), or NULL on failure.
+static char *preprocess_to_memory(const char *input_file, size_t *out_size) {
+    char *argv[] = {"gcc", "-E", "-P", (char *) input_file, NULL};
+    int from_preprocessor;
+    const pid_t preprocessor = spawn_piped(argv, PIPE_FROM_CHILD_STDOUT, &from_preprocessor);
+    if (preprocessor < 0) {
+        return NULL;
+    }
+
+    FILE *stream = fdopen(from_preprocessor, "r");
+    char *source = read_entire_stream(stream, out_size);
+    if (stream) {
+        fclose(stream);
+    } else {
+        close(from_preprocessor);
+    }
+    if (!wait_for_child(preprocessor) || !source) {
+        free(source);
+        return NULL;
+    }
+    return source;
+}
+
+// Writes a whole program's assembly into the sink (without finishing it)
+typedef bool (*AssemblyProducer)(void *context, OutputSink *sink, const CompileOptions *options, Arena *arena,
+                                 CompileStats *stats);
+
+// A source compiled by compile_into_assembler
+typedef struct {
+    const char *source;
+    size_t source_size;
+} SourceInput;
+
+static bool produce_from_source(void *context, OutputSink *sink, const CompileOptions *options, Arena *arena,
+                                CompileStats *stats) {
+    const SourceInput *input = context;
+    return compile_source_with_sink(input->source, input->source_size, options, sink, arena, stats);
+}
+
+// Streams what `produce` generates into `gcc -x assembler -`, which assembles and links it into output_file
+static bool assemble_output(const AssemblyProducer produce, void *context, const char *output_file,
+                            const CompileOptions *options, Arena *arena, CompileStats *stats) {
+    char *argv[] = {"gcc", "-x", "assembler", "-", "-o", (char *) output_file, LINKER_EXTRA_ARG, NULL};
+    int to_assembler;
+    const pid_t assembler = spawn_piped(argv, PIPE_TO_CHILD_STDIN, &to_assembler);
+    if (assembler < 0) {
+        return false;
+    }
+    FILE *out = fdopen(to_assembler, "w");
+    if (!out) {
+        perror("Failed to open the assembler's input");
+        close(to_assembler);
+        kill(assembler, SIGTERM);
+        wait_for_child(assembler);
+        return false;
+    }
+
+    // An assembler that exits early must make our writes fail, not kill us with SIGPIPE
+    void (*previous_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+    OutputSink sink;
+    output_sink_init_file(&sink, out, arena);
+    bool success = produce(context, &sink, options, arena, stats);
+    if (success && !output_sink_finish(&sink)) {
+        fprintf(stderr, "Failed to write assembly to the assembler\n");
+        success = false;
+    }
+    if (!success) {
+        // The assembler must not turn the partial listing into an executable
+        kill(assembler, SIGTERM);
+    }
+    if (fclose(out) != 0 && success) {
+        fprintf(stderr, "Failed to write assembly to the assembler\n");
+        success = false;
+    }
+    signal(SIGPIPE, previous_sigpipe);
+
+    const bool assembled = wait_for_child(assembler);
+    if (success && !assembled) {
+        fprintf(stderr, "Failed to assemble/link %s\n", output_file);
+    }
+    return success && assembled;
+}
+
+// Full compilation with the assembly streamed into `gcc -x assembler -`, which assembles and
+// links it into output_file
+static bool compile_into_assembler(const char *source, const size_t source_size, const char *output_file,
+                                   const CompileOptions *options, Arena *arena, CompileStats *stats) {
+    SourceInput input = {source, source_size};
+    return assemble_output(produce_from_source, &input, output_file, options, arena, stats);
+}
+
+// Links an object into an executable
+static bool link_object(const char *object_file, const char *output_file) {
+    char *argv[] = {"gcc", (char *) object_file, "-o", (char *) output_file, LINKER_EXTRA_ARG, NULL};
+    fflush(stdout);
+    pid_t linker;
+    const int spawn_error = posix_spawnp(&linker, argv[0], NULL, NULL, argv, environ);
+    if (spawn_error != 0) {
+        fprintf(stderr, "Failed to start %s: %s\n", argv[0], strerror(spawn_error));
+        return false;
+    }
+    trace_child(argv);
+    if (!wait_for_child(linker)) {
+        fprintf(stderr, "Failed to link %s\n", object_file);
+        return false;
+    }
+    return true;
+}
+
+// Full compilation with --emit-obj: no assembler runs, but a linker cannot read an object from a
+// pipe, so the object is written next to the executable, linked, and removed again
+static bool compile_and_link_object(const char *source, const size_t source_size, const char *output_file,
+                                    const CompileOptions *options, Arena *arena, CompileStats *stats) {
+    char object_file[1024];
+    if (snprintf(object_file, sizeof(object_file), "%s.o", output_file) >= (int) sizeof(object_file)) {
+        fprintf(stderr, "Failed to construct .o filename for %s\n", output_file);
+        return false;
+    }
+    FILE *out = fopen(object_file, "wb");
+    if (!out) {
+        perror("Failed to open file for writing");
+        fprintf(stderr, "Filename: %s\n", object_file);
+        return false;
+    }
+    OutputSink sink;
+    output_sink_init_file(&sink, out, arena);
+    bool success = compile_source_with_sink(source, source_size, options, &sink, arena, stats);
+    if (success && !output_sink_finish(&sink)) {
+        fprintf(stderr, "Failed to write %s\n", object_file);
+        success = false;
+    }
+    if (fclose(out) != 0 && success) {
+        fprintf(stderr, "Failed to write %s\n", object_file);
+        success = false;
+    }
+
+    success = success && link_object(object_file, output_file);
+    remove(object_file);
+    return success;
+}
+
+// A full compilation's output, from the cache or compiled into memory, made into output_file:
+// assembly is streamed into the assembler, an object is written next to the executable and linked
+static bool build_from_output(const char *output, const size_t output_size, const char *output_file,
+                              const CompileOptions *options) {
+    if (options->emit_obj) {
+        char object_file[1024];
+        if (snprintf(object_file, sizeof(object_file), "%s.o", output_file) >= (int) sizeof(object_file)) {
+            fprintf(stderr, "Failed to construct .o filename for %s\n", output_file);
+            return false;
+        }
+        const bool success = write_output_file(object_file, output, output_size) &&
+                             link_object(object_file, output_file);
+        remove(object_file);
+        return success;
+    }
+
+    char *argv[] = {"gcc", "-x", "assembler", "-", "-o", (char *) output_file, LINKER_EXTRA_ARG, NULL};
+    int to_assembler;
+    const pid_t assembler = spawn_piped(argv, PIPE_TO_CHILD_STDIN, &to_assembler);
+    if (assembler < 0) {
+        return false;
+    }
+    void (*previous_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+    FILE *out = fdopen(to_assembler, "w");
+    bool success = out && fwrite(output, 1, output_size, out) == output_size;
+    if (out) {
+        success = fclose(out) == 0 && success;
+    } else {
+        close(to_assembler);
+    }
+    if (!success) {
+        fprintf(stderr, "Failed to write assembly to the assembler\n");
+        kill(assembler, SIGTERM);
+    }
+    signal(SIGPIPE, previous_sigpipe);
+    const bool assembled = wait_for_child(assembler);
+    if (success && !assembled) {
+        fprintf(stderr, "Failed to assemble/link %s\n", output_file);
+    }
+    return success && assembled;
+}
+
+// Full compilation with --cache-dir: a hit skips the compiler; on a miss the output is kept in memory
+// (not streamed into the assembler) so it can be stored once it is complete
+static bool build_with_cache(const char *source, const size_t source_size, const char *output_file,
+                             const CompileOptions *options, Arena *arena, CompileStats *stats) {
+    DiskCacheKey key;
+    size_t output_size = 0;
+    char *cached = cache_lookup(source, source_size, options, &key, &output_size);
+    const bool hit = cached != NULL;
+    bool success;
+    if (hit) {
+        success = build_from_output(cached, output_size, output_file, options);
+        free(cached);
+    } else {
+        StringBuffer sb;
+        string_buffer_init_chunked(&sb, arena, 0);
+        OutputSink sink;
+        output_sink_init_buffer(&sink, &sb);
+        success = compile_source_with_sink(source, source_size, options, &sink, arena, stats);
+        const char *output = success ? string_buffer_flatten(&sb) : NULL;
+        success = output && build_from_output(output, sb.length, output_file, options);
+        if (success) {
+            cache_store(options, &key, output, sb.length);
+        }
+    }
+    count_cache_lookup(stats, &key, hit);
+    return success;
+}
+
+// Compiles each top-level definition the reader cuts from the stream into `out`, in an arena mark
+// released before the next one, so the arena never holds more than the largest definition
+static bool compile_definitions(FunctionReader *reader, FILE *out, const CompileOptions *options, Arena *arena,
+                                CompileStats *stats) {
+    CompileOptions definition_options = *options;
+    definition_options.quiet = true; // One progress line for the file, not a set per definition
+    const char *text;
+    size_t length;
+    size_t line;
+    size_t count = 0;
+    while (function_reader_next(reader, &text, &length, &line)) {
+        const ArenaMark mark = arena_mark(arena);
+        OutputSink sink;
+        output_sink_init_file(&sink, out, arena);
+        CompileStats piece;
+        bool success = compile_source_with_sink(text, length, &definition_options, &sink, arena,
+                                                stats ? &piece : NULL);
+        if (success && !output_sink_finish(&sink)) {
+            fprintf(stderr, "Failed to write assembly to the assembler\n");
+            success = false;
+        }
+        if (success && stats) {
+            compile_stats_accumulate(stats, &piece);
+        }
+        arena_release(arena, mark);
+        if (!success) {
+            // Line numbers in the error count from the definition's first line
+            fprintf(stderr, "Failed to compile the definition at line %zu of the preprocessed input\n", line);
+            return false;
+        }
+        count++;
+    }
+    if (reader->failed) {
+        return false;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Error: The input defines no function\n");
+        return false;
+    }
+    if (!options->quiet) {
+        printf("Compiled %zu definitions one at a time (largest %zu bytes)\n", count, reader->largest);
+    }
+    return true;
+}
+
+// --stream: the preprocessor's output is compiled one top-level definition at a time as it arrives,
+// straight into the assembler, so neither the source nor its assembly is ever held whole
+static int stream_file(const char *input_file, const CompileOptions *options, Arena *arena) {
+    if (compile_options_stops_early(options) || options->emit_obj || options->cache_dir) {
+        fprintf(stderr, "Error: --stream only builds executables through the assembler; it takes no "
+                        "stop-early mode, --emit-obj or --cache-dir.\n");
+        return 1;
+    }
+    const bool from_stdin = strcmp(input_file, "-") == 0;
+    if (!from_stdin && !filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension (or be - for stdin)\n");
+        return 1;
+    }
+    char output_file[1024];
+    if (from_stdin) {
+        strcpy(output_file, "a.out");
+    } else if (!filename_replace_ext(input_file, "", output_file, sizeof(output_file))) {
+        fprintf(stderr, "Failed to construct output executable filename for %s\n", input_file);
+        return 1;
+    }
+
+    // For "-" the preprocessor reads our stdin, which it inherits
+    char *preprocessor_argv[] = {"gcc", "-E", "-P", "-x", "c", (char *) input_file, NULL};
+    int from_preprocessor;
+    const pid_t preprocessor = spawn_piped(preprocessor_argv, PIPE_FROM_CHILD_STDOUT, &from_preprocessor);
+    if (preprocessor < 0) {
+        return 1;
+    }
+    char *assembler_argv[] = {"gcc", "-x", "assembler", "-", "-o", output_file, LINKER_EXTRA_ARG, NULL};
+    int to_assembler;
+    const pid_t assembler = spawn_piped(assembler_argv, PIPE_TO_CHILD_STDIN, &to_assembler);
+    if (assembler < 0) {
+        close(from_preprocessor);
+        wait_for_child(preprocessor);
+        return 1;
+    }
+    FILE *in = fdopen(from_preprocessor, "r");
+    FILE *out = fdopen(to_assembler, "w");
+    if (!in || !out) {
+        perror("Failed to open the pipes to the preprocessor and assembler");
+    }
+
+    CompileStats stats = {0};
+    const bool want_report = options->time_report != TIME_REPORT_NONE;
+    void (*previous_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+    bool success = false;
+    if (in && out) {
+        FunctionReader reader;
+        function_reader_init(&reader, in);
+        success = compile_definitions(&reader, out, options, arena, want_report ? &stats : NULL);
+        function_reader_destroy(&reader);
+    }
+    if (!success) {
+        // Neither the rest of the input nor a partial executable is wanted
+        kill(preprocessor, SIGTERM);
+        kill(assembler, SIGTERM);
+    }
+    if (in) {
+        fclose(in);
+    } else {
+        close(from_preprocessor);
+    }
+    if (out) {
+        if (fclose(out) != 0 && success) {
+            fprintf(stderr, "Failed to write assembly to the assembler\n");
+            success = false;
+        }
+    } else {
+        close(to_assembler);
+    }
+    signal(SIGPIPE, previous_sigpipe);
+
+    const bool preprocessed = wait_for_child(preprocessor);
+    const bool assembled = wait_for_child(assembler);
+    if (success && !preprocessed) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        success = false;
+    } else if (success && !assembled) {
+        fprintf(stderr, "Failed to assemble/link %s\n", output_file);
+        success = false;
+    }
+    if (success && !options->quiet) {
+        printf("Assembled and linked output: %s\n", output_file);
+    } else if (!success) {
+        remove(output_file);
+    }
+    if (want_report) {
+        compile_stats_print(&stats, options->time_report, stderr);
+    }
+    return success ? 0 : 1;
+}
+
+// One file through the pipeline, compiled in the given arena
+static int pipeline_file(const char *input_file, const CompileOptions *options, Arena *arena) {
+    if (options->stream) {
+        return stream_file(input_file, options, arena);
+    }
+    if (!filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension\n");
+        return 1;
+    }
+    if (!object_output_supported(options)) {
+        return 1;
+    }
+    char output_file[1024];
+    // Use empty string to remove the extension
+    if (!filename_replace_ext(input_file, "", output_file, sizeof(output_file))) {
+        fprintf(stderr, "Failed to construct output executable filename for %s\n", input_file);
+        return 1;
+    }
+
+    size_t source_size = 0;
+    char *source = preprocess_to_memory(input_file, &source_size);
+    if (!source) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        return 1;
+    }
+    if (!options->quiet) {
+        printf("Preprocessed %s in memory (%zu bytes)\n", input_file, source_size);
+    }
+
+    CompileStats stats;
+    const bool want_report = options->time_report != TIME_REPORT_NONE;
+    bool success;
+    if (compile_options_stops_early(options)) {
+        success = compile_in_memory(source, source_size, options, arena, want_report ? &stats : NULL);
+    } else {
+        success = options->cache_dir
+                      ? build_with_cache(source, source_size, output_file, options, arena, want_report ? &stats : NULL)
+                      : options->emit_obj
+                      ? compile_and_link_object(source, source_size, output_file, options, arena,
+                                                want_report ? &stats : NULL)
+                      : compile_into_assembler(source, source_size, output_file, options, arena,
+                                               want_report ? &stats : NULL);
+        if (success && !options->quiet) {
+            printf("%s output: %s\n", options->emit_obj ? "Linked" : "Assembled and linked", output_file);
+        } else if (!success) {
+            remove(output_file); // Make sure a partial executable does not survive
+        }
+    }
+    if (want_report) {
+        compile_stats_print(&stats, options->time_report, stderr);
+    }
+
+    free(source);
+    return success ? 0 : 1;
+}
+
+int run_pipeline(const char *input_file, const CompileOptions *options) {
+    Arena main_arena = create_compile_arena(options);
+    if (!main_arena.start) {
+        fprintf(stderr, "Driver Error: Failed to create main arena.\n");
+        return 1;
+    }
+    const int result = pipeline_file(input_file, options, &main_arena);
+    arena_destroy(&main_arena);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Compile Server (--server=PATH / --connect=PATH)
+// -----------------------------------------------------------------------------
+
+// Sent to a client's file: the server's output is written next to the source and linked from there
+static int client_file(const char *input_file, const CompileOptions *options) {
+    if (!filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension\n");
+        return 1;
+    }
+    if (!object_output_supported(options)) {
+        return 1;
+    }
+    const char *output_ext = options->emit_obj ? ".o" : ".s";
+    char output_file[1024];
+    if (!filename_replace_ext(input_file, output_ext, output_file, sizeof(output_file))) {
+        fprintf(stderr, "Failed to construct %s filename for %s\n", output_ext, input_file);
+        return 1;
+    }
+
+    size_t source_size = 0;
+    char *source = preprocess_to_memory(input_file, &source_size);
+    if (!source) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        return 1;
+    }
+    // A cached output saves the round trip to the server
+    DiskCacheKey cache_key;
+    size_t output_size = 0;
+    char *output = cache_lookup(source, source_size, options, &cache_key, &output_size);
+    if (!output) {
+        if (!compile_server_request(options->connect_socket, source, source_size, options, &output, &output_size,
+                                    NULL)) {
+            free(source);
+            fprintf(stderr, "The compile server failed to compile %s\n", input_file);
+            return 1;
+        }
+        cache_store(options, &cache_key, output, output_size);
+    }
+    free(source);
+
+    const bool written = write_output_file(output_file, output, output_size);
+    free(output);
+    if (!written) {
+        remove(output_file);
+        return 1;
+    }
+    return run_assembler_linker_with_options(output_file, options);
+}
+
+int run_client(const char *input_file, const CompileOptions *options) {
+    return client_file(input_file, options);
+}
+
+// Interrupts the blocking accept, so the server removes its socket on the way out
+static void stop_serving(const int signal_number) {
+    (void) signal_number;
+}
+
+int run_server(const CompileOptions *options) {
+    CompileServer server;
+    if (!compile_server_open(&server, options->server_socket)) {
+        return 1;
+    }
+    // No SA_RESTART: SIGINT and SIGTERM must make accept fail with EINTR
+    struct sigaction stop = {0};
+    stop.sa_handler = stop_serving;
+    sigemptyset(&stop.sa_mask);
+    struct sigaction previous_int, previous_term;
+    sigaction(SIGINT, &stop, &previous_int);
+    sigaction(SIGTERM, &stop, &previous_term);
+    if (!options->quiet) {
+        printf("Serving compile requests on %s\n", options->server_socket);
+        fflush(stdout);
+    }
+
+    while (compile_server_serve_one(&server)) {
+    }
+
+    sigaction(SIGINT, &previous_int, NULL);
+    sigaction(SIGTERM, &previous_term, NULL);
+    if (!options->quiet) {
+        printf("Served %zu compile requests\n", server.requests_served);
+    }
+    compile_server_close(&server);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Parallel Builds (-j N)
+// -----------------------------------------------------------------------------
+
+// The queue the workers take files from, in command-line order
+typedef struct {
+    const char *const *inputs;
+    size_t input_count;
+    size_t next_input;     // First file no worker has taken yet
+    size_t failure_count;
+    CompileOptions worker_options; // The caller's options, quiet unless one worker does all files
+    bool report_done;      // Print one line per finished file (unless the caller asked for --quiet)
+    pthread_mutex_t lock;  // Guards next_input and failure_count
+} ParallelBuild;
+
+static void *parallel_worker(void *data) {
+    ParallelBuild *build = data;
+    // One arena per worker, reused for every file it takes instead of created and destroyed per file
+    Arena arena = create_compile_arena(&build->worker_options);
+    if (!arena.start) {
+        fprintf(stderr, "Driver Error: Failed to create a worker arena.\n");
+    }
+    for (;;) {
+        pthread_mutex_lock(&build->lock);
+        const size_t index = build->next_input++;
+        pthread_mutex_unlock(&build->lock);
+        if (index >= build->input_count) {
+            break;
+        }
+        const char *input_file = build->inputs[index];
+        // With --connect the server compiles and the arena goes unused
+        const bool success = build->worker_options.connect_socket
+                                 ? client_file(input_file, &build->worker_options) == 0
+                                 : arena.start && pipeline_file(input_file, &build->worker_options, &arena) == 0;
+        if (arena.start) {
+            arena_reset_with_mode(&arena, ARENA_RESET_DIRTY); // Nothing relies on zeroed arena memory
+        }
+        if (!success) {
+            fprintf(stderr, "Failed to build %s\n", input_file);
+            pthread_mutex_lock(&build->lock);
+            build->failure_count++;
+            pthread_mutex_unlock(&build->lock);
+        } else if (build->report_done) {
+            printf("Built %s\n", input_file);
+        }
+    }
+    if (arena.start) {
+        arena_destroy(&arena);
+    }
+    return NULL;
+}
+
+int run_parallel(const char *const *input_files, const size_t input_count, const CompileOptions *options) {
+    ParallelBuild build = {.inputs = input_files, .input_count = input_count, .worker_options = *options};
+    // Listings of the stop-early modes stay in order: one worker, in this thread
+    size_t worker_count = compile_options_stops_early(options) ? 1 : (size_t) options->jobs;
+    if (worker_count > input_count) {
+        worker_count = input_count;
+    }
+    build.worker_options.quiet = options->quiet || worker_count > 1;
+    build.report_done = !options->quiet && worker_count > 1;
+    if (pthread_mutex_init(&build.lock, NULL) != 0) {
+        fprintf(stderr, "Driver Error: Failed to create the work queue lock.\n");
+        return 1;
+    }
+
+    // Set once for all workers: the per-file save and restore in compile_into_assembler then only
+    // ever swaps SIG_IGN for SIG_IGN, whatever order the threads run in
+    void (*previous_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+    pthread_t threads[COMPILE_OPTIONS_MAX_JOBS];
+    size_t started = 0;
+    for (size_t i = 1; i < worker_count; ++i) {
+        if (pthread_create(&threads[started], NULL, parallel_worker, &build) != 0) {
+            fprintf(stderr, "Warning: started only %zu of %zu workers\n", started + 1, worker_count);
+            break;
+        }
+        started++;
+    }
+    parallel_worker(&build); // This thread is a worker too
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    signal(SIGPIPE, previous_sigpipe);
+    pthread_mutex_destroy(&build.lock);
+
+    if (build.failure_count > 0) {
+        fprintf(stderr, "%zu of %zu files failed to build\n", build.failure_count, input_count);
+        return 1;
+    }
+    return 0;
+}
+
+int run_jit(const char *input_file, const CompileOptions *options) {
+    if (!filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension\n");
+        return 1;
+    }
+    if (!jit_supported()) {
+        fprintf(stderr, "Error: --run executes x86-64 code and needs an x86-64 POSIX host.\n");
+        return 1;
+    }
+    size_t source_size = 0;
+    char *source = preprocess_to_memory(input_file, &source_size);
+    if (!source) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        return 1;
+    }
+
+    int result = 0;
+    const bool success = compile_and_run(source, source_size, options, NULL, &result);
+    free(source);
+    if (!success) {
+        fprintf(stderr, "Failed to run %s\n", input_file);
+        return 1;
+    }
+    if (!options->quiet) {
+        printf("Ran %s in memory: main returned %d\n", input_file, result);
+    }
+    return result;
+}
+
+int run_interpreter(const char *input_file, const CompileOptions *options) {
+    if (!filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension\n");
+        return 1;
+    }
+    size_t source_size = 0;
+    char *source = preprocess_to_memory(input_file, &source_size);
+    if (!source) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        return 1;
+    }
+
+    int result = 0;
+    const bool success = compile_and_interpret(source, source_size, options, &result);
+    free(source);
+    if (!success) {
+        fprintf(stderr, "Failed to interpret %s\n", input_file);
+        return 1;
+    }
+    if (!options->quiet) {
+        printf("Interpreted %s: main returned %d\n", input_file, result);
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// TAC Modules (--emit-tac / .ctac inputs)
+// -----------------------------------------------------------------------------
+
+int run_tac_emitter(const char *input_file, const CompileOptions *options) {
+    if (!filename_has_ext(input_file, ".c")) {
+        fprintf(stderr, "Input file should have a .c extension\n");
+        return 1;
+    }
+    char module_file[1024];
+    if (!filename_replace_ext(input_file, ".ctac", module_file, sizeof(module_file))) {
+        fprintf(stderr, "Failed to construct .ctac filename for %s\n", input_file);
+        return 1;
+    }
+    size_t source_size = 0;
+    char *source = preprocess_to_memory(input_file, &source_size);
+    if (!source) {
+        fprintf(stderr, "Failed to preprocess %s\n", input_file);
+        return 1;
+    }
+    Arena arena = create_compile_arena(options);
+    if (!arena.start) {
+        fprintf(stderr, "Driver Error: Failed to create main arena.\n");
+        free(source);
+        return 1;
+    }
+    TacProgram *program = NULL;
+    const bool success = compile_source_to_tac(source, source_size, options, &arena, &program) &&
+                         tac_file_write(program, module_file);
+    if (success && !options->quiet) {
+        printf("TAC module written to %s\n", module_file);
+    }
+    arena_destroy(&arena);
+    free(source);
+    return success ? 0 : 1;
+}
+
+// A program of loaded modules, finished by assemble_output
+static bool produce_from_tac(void *context, OutputSink *sink, const CompileOptions *options, Arena *arena,
+                             CompileStats *stats) {
+    return compile_tac_with_sink(context, options, sink, arena, stats);
+}
+
+int run_tac_linker(const char *const *module_files, const size_t module_count, const CompileOptions *options) {
+    if (options->emit_obj || options->stream || options->cache_dir || options->run || options->interpret ||
+        options->connect_socket) {
+        fprintf(stderr, "Error: Linking TAC modules only generates assembly for the assembler (or --tac/--codegen "
+                        "listings); it takes no --emit-obj, --stream, --cache-dir, --run, --interpret or --connect.\n");
+        return 1;
+    }
+    char output_file[1024];
+    if (!filename_replace_ext(module_files[0], "", output_file, sizeof(output_file))) {
+        fprintf(stderr, "Failed to construct output executable filename for %s\n", module_files[0]);
+        return 1;
+    }
+    Arena arena = create_compile_arena(options);
+    TacModule *modules = calloc(module_count, sizeof(TacModule));
+    if (!arena.start || !modules) {
+        fprintf(stderr, "Driver Error: Failed to set up linking the TAC modules.\n");
+        arena_destroy(&arena);
+        free(modules);
+        return 1;
+    }
+
+    TacProgram *program = create_tac_program(&arena);
+    bool success = true;
+    size_t loaded = 0;
+    while (success && loaded < module_count) {
+        success = tac_file_load(module_files[loaded], program, modules, loaded, &arena, &modules[loaded]);
+        loaded += success;
+    }
+    if (success && !options->quiet) {
+        printf("Loaded %zu TAC modules (%zu functions)\n", module_count, program->function_count);
+    }
+
+    CompileStats stats;
+    const bool want_report = options->time_report != TIME_REPORT_NONE;
+    if (success && compile_options_stops_early(options)) {
+        StringBuffer sb;
+        string_buffer_init_chunked(&sb, &arena, 0);
+        OutputSink sink;
+        output_sink_init_buffer(&sink, &sb);
+        success = compile_tac_with_sink(program, options, &sink, &arena, want_report ? &stats : NULL);
+    } else if (success) {
+        success = assemble_output(produce_from_tac, program, output_file, options, &arena,
+                                  want_report ? &stats : NULL);
+        if (success && !options->quiet) {
+            printf("Assembled and linked output: %s\n", output_file);
+        } else if (!success) {
+            remove(output_file);
+        }
+    }
+    if (success && want_report) {
+        compile_stats_print(&stats, options->time_report, stderr);
+    }
+
+    // The loaded functions point into the mappings: release them only once the program is done with
+    for (size_t i = 0; i < loaded; ++i) {
+        tac_file_unload(&modules[i]);
+    }
+    free(modules);
+    arena_destroy(&arena);
+    return success ? 0 : 1;
+}
@@ -2,6 +2,8 @@
 #define DRIVER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "options.h"
 
 /**
  * Runs the gcc preprocessor on the input file and writes output to .i file.
@@ -9,10 +11,86 @@
  */
 int run_preprocessor(const char *input_file);
 
+// Same as run_preprocessor; prints nothing but errors with --quiet
+int run_preprocessor_with_options(const char *input_file, const CompileOptions *options);
+
 // Compiles a .i file to a .s file (or performs lex/parse only)
 int run_compiler(const char *input_file, bool lex_only, bool parse_only, bool validate_only, bool tac_only, bool codegen_only);
 
+// Same as run_compiler, driven by an options struct; prints the time report if one was requested
+int run_compiler_with_options(const char *input_file, const CompileOptions *options);
+
 // Assembles and links a .s file to an executable, removes .s on success
 int run_assembler_linker(const char *input_file);
 
+// Links a .o file (from --emit-obj) to an executable, removes .o on success
+int run_linker(const char *input_file);
+
+// run_linker with --emit-obj, run_assembler_linker otherwise; prints nothing but errors with --quiet
+int run_assembler_linker_with_options(const char *input_file, const CompileOptions *options);
+
+/**
+ * Compiles a .c file to an executable without intermediate files: the preprocessor's output is
+ * read from a pipe and the assembly is streamed into the assembler's stdin (`gcc -x assembler -`).
+ * Both tools are started with posix_spawn, not through a shell. Stop-early modes print to
+ * stdout as run_compiler_with_options does. With options->stream the source is compiled one
+ * top-level definition at a time as the preprocessor delivers it, and "-" reads stdin into a.out.
+ * Returns 0 on success, 1 on failure.
+ */
+int run_pipeline(const char *input_file, const CompileOptions *options);
+
+/**
+ * Builds every .c file as run_pipeline does, on options->jobs threads. Each worker owns one arena
+ * and reuses it for every file it takes, and the preprocessors and assemblers of different files
+ * run at the same time. Workers print no progress messages (errors still go to stderr), only one
+ * line per finished file. Stop-early modes run one file after the other, to keep their listings
+ * in order. With options->connect_socket every file goes through run_client instead.
+ * Returns 0 if every file was built, 1 otherwise.
+ */
+int run_parallel(const char *const *input_files, size_t input_count, const CompileOptions *options);
+
+/**
+ * Compiles a .c file into memory and runs its main in this process (see compile_and_run): the
+ * preprocessor's output is read from a pipe and no assembler, linker or file is involved.
+ * Returns main's result, or 1 if the program could not be compiled or loaded.
+ */
+int run_jit(const char *input_file, const CompileOptions *options);
+
+/**
+ * Compiles a .c file to TAC and runs its main in the TAC interpreter (see compile_and_interpret),
+ * with the preprocessor's output read from a pipe; nothing is written.
+ * Returns main's result, or 1 if the program could not be compiled or trapped.
+ */
+int run_interpreter(const char *input_file, const CompileOptions *options);
+
+/**
+ * Runs a compile server on options->server_socket (see server.h) until a client stops it or the
+ * process gets SIGINT or SIGTERM; the socket file is removed on the way out.
+ * Returns 0 after a clean stop, 1 if the socket could not be opened.
+ */
+int run_server(const CompileOptions *options);
+
+/**
+ * Builds a .c file with the help of the compile server on options->connect_socket: the file is
+ * preprocessed here, compiled by the server, and the assembly (or object, with --emit-obj) it sends
+ * back is written next to the source and linked into an executable as run_assembler_linker does.
+ * Returns 0 on success, 1 on failure.
+ */
+int run_client(const char *input_file, const CompileOptions *options);
+
+/**
+ * Compiles a .c file (preprocessed through a pipe) down to TAC and writes it to <input>.ctac as a
+ * TAC module (see tac_file.h) instead of generating code.
+ * Returns 0 on success, 1 on failure.
+ */
+int run_tac_emitter(const char *input_file, const CompileOptions *options);
+
+/**
+ * Loads TAC modules written by --emit-tac into one program, optimizes it and generates its code
+ * once, streamed into the assembler to build an executable named after the first module. With
+ * --tac or --codegen the listings are printed instead.
+ * Returns 0 on success, 1 on failure.
+ */
+int run_tac_linker(const char *const *module_files, size_t module_count, const CompileOptions *options);
+
 #endif // DRIVER_H
@@ -0,0 +1,133 @@
+#include "function_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FUNCTION_CACHE_INITIAL_CAPACITY 64
+
+// Only these options change the assembly a function compiles to
+static uint32_t options_key(const CompileOptions *options) {
+    return (uint32_t) options->optimization_level << 4 | (uint32_t) options->no_omit_frame_pointer << 3 |
+           (uint32_t) options->no_peephole << 2 | (uint32_t) options->flat_ast << 1;
+}
+
+// The slot holding the key, or the empty slot where it would go
+static FunctionCacheEntry *find_slot(const FunctionCache *cache, const AstFingerprint fingerprint,
+                                     const uint32_t key) {
+    const size_t mask = cache->capacity - 1;
+    size_t index = (size_t) (fingerprint.lanes[0] ^ key) & mask;
+    for (;;) {
+        FunctionCacheEntry *entry = &cache->entries[index];
+        if (!entry->assembly ||
+            (entry->options_key == key && ast_fingerprint_equal(entry->fingerprint, fingerprint))) {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static bool allocate_table(FunctionCache *cache, const size_t capacity) {
+    FunctionCacheEntry *entries = slab_alloc_zeroed(&cache->storage, capacity * sizeof(FunctionCacheEntry));
+    if (!entries) {
+        return false;
+    }
+    cache->entries = entries;
+    cache->capacity = capacity;
+    return true;
+}
+
+bool function_cache_init(FunctionCache *cache) {
+    *cache = (FunctionCache){0};
+    if (!slab_init(&cache->storage)) {
+        return false;
+    }
+    if (!allocate_table(cache, FUNCTION_CACHE_INITIAL_CAPACITY)) {
+        fprintf(stderr, "Compiler Error: Failed to create the function cache.\n");
+        slab_destroy(&cache->storage);
+        *cache = (FunctionCache){0};
+        return false;
+    }
+    return true;
+}
+
+void function_cache_destroy(FunctionCache *cache) {
+    if (cache->entries) {
+        slab_destroy(&cache->storage);
+    }
+    *cache = (FunctionCache){0};
+}
+
+const FunctionCacheEntry *function_cache_lookup(FunctionCache *cache, const AstFingerprint fingerprint,
+                                                const CompileOptions *options) {
+    const FunctionCacheEntry *entry = find_slot(cache, fingerprint, options_key(options));
+    if (!entry->assembly) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    return entry;
+}
+
+// Doubles the table and frees the old one
+static bool grow(FunctionCache *cache) {
+    FunctionCacheEntry *old_entries = cache->entries;
+    const size_t old_capacity = cache->capacity;
+    if (!allocate_table(cache, old_capacity * 2)) {
+        return false;
+    }
+    for (size_t i = 0; i < old_capacity; ++i) {
+        const FunctionCacheEntry *entry = &old_entries[i];
+        if (entry->assembly) {
+            *find_slot(cache, entry->fingerprint, entry->options_key) = *entry;
+        }
+    }
+    slab_free(&cache->storage, old_entries, old_capacity * sizeof(FunctionCacheEntry));
+    return true;
+}
+
+// Frees every copy and empties the table, which keeps its size for the entries to come
+static void start_over(FunctionCache *cache) {
+    for (size_t i = 0; i < cache->capacity; ++i) {
+        FunctionCacheEntry *entry = &cache->entries[i];
+        if (entry->assembly) {
+            slab_free(&cache->storage, (char *) entry->assembly, entry->assembly_length + 1);
+        }
+    }
+    memset(cache->entries, 0, cache->capacity * sizeof(FunctionCacheEntry));
+    cache->count = 0;
+    cache->stored_bytes = 0;
+}
+
+// Segment visitor copying a chunked buffer into one contiguous block
+static bool copy_segment(const char *data, const size_t length, void *context) {
+    char **cursor = context;
+    memcpy(*cursor, data, length);
+    *cursor += length;
+    return true;
+}
+
+bool function_cache_insert(FunctionCache *cache, const AstFingerprint fingerprint, const CompileOptions *options,
+                           const StringBuffer *assembly) {
+    if (cache->stored_bytes + assembly->length > FUNCTION_CACHE_MAX_BYTES) {
+        start_over(cache);
+    }
+    // Keep the load factor at or below 3/4 so probe sequences stay short
+    if ((cache->count + 1) * 4 > cache->capacity * 3 && !grow(cache)) {
+        return false;
+    }
+    const uint32_t key = options_key(options);
+    FunctionCacheEntry *entry = find_slot(cache, fingerprint, key);
+    if (entry->assembly) {
+        return true; // Already cached
+    }
+    char *copy = slab_alloc(&cache->storage, assembly->length + 1);
+    if (!copy) {
+        return false;
+    }
+    char *cursor = copy;
+    string_buffer_for_each_segment(assembly, copy_segment, &cursor);
+    *cursor = '\0';
+    *entry = (FunctionCacheEntry){fingerprint, key, copy, assembly->length};
+    cache->count++;
+    cache->stored_bytes += assembly->length + 1;
+    return true;
+}
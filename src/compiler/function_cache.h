@@ -0,0 +1,73 @@
+#ifndef CLERIC_FUNCTION_CACHE_H
+#define CLERIC_FUNCTION_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../memory/slab.h"
+#include "../parser/ast.h"
+#include "../strings/strings.h"
+#include "options.h"
+
+//------------------------------------------------------------------------------
+// Assembly of functions keyed by their AST
+//
+// When CompileOptions::function_cache is set, compile() fingerprints every
+// validated function (ast_fingerprint) and looks it up here. A function seen
+// before with the same code-affecting options gets its assembly from the cache
+// and never goes through IR generation, the optimizer or code generation, so
+// a recompilation costs lexing, parsing and validation plus the functions that
+// changed. The compile server keeps one cache for its whole life.
+//
+// Only assembly text is cached (not --emit-obj objects), and never with
+// --fuse-validation, whose checks run during IR generation. Once the stored
+// copies exceed FUNCTION_CACHE_MAX_BYTES the cache starts over empty. The table
+// and the copies live in a slab (slab.h), so starting over and growing the
+// table give their memory back for the entries that follow.
+//------------------------------------------------------------------------------
+
+#define FUNCTION_CACHE_MAX_BYTES ((size_t) 64 * 1024 * 1024)
+
+typedef struct {
+    AstFingerprint fingerprint;
+    uint32_t options_key;  // The code-affecting options, packed
+    const char *assembly;  // Copy of the function's assembly (NULL marks an empty slot)
+    size_t assembly_length;
+} FunctionCacheEntry;
+
+typedef struct FunctionCache {
+    FunctionCacheEntry *entries; // Open addressing, linear probing; capacity is a power of two
+    size_t capacity;
+    size_t count;
+    Slab storage;                // The table and the assembly copies
+    size_t stored_bytes;         // Bytes of the assembly copies
+    size_t hits;
+    size_t misses;
+} FunctionCache;
+
+/**
+ * @brief Creates an empty cache.
+ * @return false if memory ran out (the cache is then left empty and need not be destroyed).
+ */
+bool function_cache_init(FunctionCache *cache);
+
+/**
+ * @brief Releases the cache's memory.
+ */
+void function_cache_destroy(FunctionCache *cache);
+
+/**
+ * @brief Finds the assembly generated earlier for a function with this fingerprint and these options.
+ * @return The entry, or NULL on a miss. Counts the hit or miss.
+ */
+const FunctionCacheEntry *function_cache_lookup(FunctionCache *cache, AstFingerprint fingerprint,
+                                                const CompileOptions *options);
+
+/**
+ * @brief Stores a copy of a function's freshly generated assembly.
+ * @return false if memory ran out (the function is then simply not cached).
+ */
+bool function_cache_insert(FunctionCache *cache, AstFingerprint fingerprint, const CompileOptions *options,
+                           const StringBuffer *assembly);
+
+#endif // CLERIC_FUNCTION_CACHE_H
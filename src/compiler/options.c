@@ -0,0 +1,36 @@
+#include "options.h"
+#include <stddef.h>
+#include "disk_cache.h"
+
+void compile_options_init(CompileOptions *options) {
+    *options = (CompileOptions){0};
+    options->time_report = TIME_REPORT_NONE;
+    options->trace_path = NULL;
+    options->optimization_level = 0;
+    options->no_peephole = false;
+    options->no_omit_frame_pointer = false;
+    options->lex_thread = false;
+    options->flat_ast = false;
+    options->fuse_validation = false;
+    options->pipe = false;
+    options->stream = false;
+    options->emit_obj = false;
+    options->emit_tac = false;
+    options->run = false;
+    options->interpret = false;
+    options->jobs = 1;
+    options->function_jobs = 1;
+    options->quiet = false;
+    options->server_socket = NULL;
+    options->connect_socket = NULL;
+    options->cache_dir = NULL;
+    options->cache_max_bytes = DISK_CACHE_DEFAULT_MAX_BYTES;
+    options->arena_reserve_bytes = 0;
+    options->huge_pages = false;
+    options->function_cache = NULL;
+}
+
+bool compile_options_stops_early(const CompileOptions *options) {
+    return options->lex_only || options->parse_only || options->validate_only || options->tac_only ||
+           options->codegen_only;
+}
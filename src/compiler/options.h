@@ -0,0 +1,66 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Format of the per-phase report printed after compilation
+typedef enum {
+    TIME_REPORT_NONE, // No report (default)
+    TIME_REPORT_TEXT, // Human-readable table (--time-report)
+    TIME_REPORT_JSON  // One JSON object, for tracking throughput over time (--time-report=json)
+} TimeReportFormat;
+
+struct FunctionCache; // function_cache.h
+
+// Largest N accepted by -j N
+#define COMPILE_OPTIONS_MAX_JOBS 256
+
+// Everything the command line can ask of one compilation.
+// New flags are added here rather than as extra parameters to parse_args/compile/run_compiler.
+typedef struct {
+    bool lex_only;      // --lex: stop after lexing and print tokens
+    bool parse_only;    // --parse: stop after parsing and print the AST
+    bool validate_only; // --validate: stop after semantic validation
+    bool tac_only;      // --tac / --tacky: stop after IR generation and print TAC
+    bool codegen_only;  // --codegen: stop after code generation and print assembly
+    TimeReportFormat time_report; // --time-report[=text|json]
+    const char *trace_path;       // --trace=FILE: write a Chrome trace of the compilation to FILE (trace.h)
+    int optimization_level;       // -O0 (default) / -O1: register allocation
+    bool no_peephole;             // --no-peephole: skip the peephole pass that -O1 otherwise runs
+    bool no_omit_frame_pointer;   // --no-omit-frame-pointer: keep the %rbp frame that -O1 otherwise drops when unused
+    bool lex_thread;              // --lex-thread: lex on a thread of its own while the parser consumes the tokens
+    bool flat_ast;                // --flat-ast: validate and lower the flat form of the AST (flat_ast.h)
+    bool fuse_validation;         // --fuse-validation: validate while generating TAC, in one walk of the AST
+    bool pipe;                    // --pipe: preprocess and assemble through pipes, no .i or .s files
+    bool stream;                  // --stream: with --pipe, compile one top-level function at a time (function_reader.h)
+    bool emit_obj;                // --emit-obj: encode machine code into an ELF .o instead of writing a .s
+    bool emit_tac;                // --emit-tac: write the TAC program to <input>.ctac (tac_file.h), no code generated
+    bool run;                     // --run: run main in memory and exit with its result, no executable built
+    bool interpret;               // --interpret: run main's TAC in the interpreter and exit with its result
+    int jobs;                     // -j N: compile up to N input files at once (default 1)
+    int function_jobs;            // --function-jobs=N: optimize and generate up to N functions of a file at once
+    bool quiet;                   // --quiet (and every -j worker): no progress messages on stdout
+    const char *server_socket;    // --server=PATH: compile sources sent over this Unix socket (see server.h)
+    const char *connect_socket;   // --connect=PATH: have the server on this socket compile the input files
+    const char *cache_dir;        // --cache-dir=DIR: reuse output stored for the same preprocessed source (disk_cache.h)
+    size_t cache_max_bytes;       // --cache-max-mb=N: evict least recently used entries beyond this size
+    size_t arena_reserve_bytes;   // --arena-reserve-mb=N: reserve this much address space per arena chunk (0: malloc)
+    bool huge_pages;              // --huge-pages: with --arena-reserve-mb, back the arena with transparent huge pages
+    struct FunctionCache *function_cache; // Not a flag: reuse assembly of unchanged functions (function_cache.h)
+} CompileOptions;
+
+/**
+ * @brief Sets every option to its default (full pipeline, no report).
+ * @param options Pointer to the options to initialize.
+ */
+void compile_options_init(CompileOptions *options);
+
+/**
+ * @brief Tells whether any of the stop-early modes is set.
+ * @param options Pointer to the options.
+ * @return true if the pipeline stops before writing an assembly file.
+ */
+bool compile_options_stops_early(const CompileOptions *options);
+
+#endif // OPTIONS_H
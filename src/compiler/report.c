@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 199309L // For clock_gettime
+#include "report.h"
+#include "trace.h"
+#include <time.h>
+
+static const char *const PHASE_NAMES[COMPILE_PHASE_COUNT] = {"lex", "parse", "validate", "irgen", "optimize",
+                                                               "codegen"};
+
+uint64_t report_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+const char *compile_phase_name(const CompilePhase phase) {
+    return phase < COMPILE_PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+// While a phase runs, its PhaseStats hold the starting samples; end_phase turns them into differences
+void compile_stats_begin_phase(CompileStats *stats, const CompilePhase phase, const Arena *arena) {
+    trace_begin("phase", compile_phase_name(phase));
+    if (!stats || phase >= COMPILE_PHASE_COUNT) {
+        return;
+    }
+    const ArenaStats arena_now = arena_stats(arena);
+    PhaseStats *p = &stats->phases[phase];
+    p->ran = true;
+    p->alloc_count = arena_now.alloc_count;
+    p->alloc_bytes = arena_now.alloc_bytes;
+    p->wall_ns = report_now_ns();
+}
+
+void compile_stats_end_phase(CompileStats *stats, const CompilePhase phase, const Arena *arena) {
+    trace_end("phase", compile_phase_name(phase));
+    if (!stats || phase >= COMPILE_PHASE_COUNT) {
+        return;
+    }
+    const uint64_t now = report_now_ns();
+    const ArenaStats arena_now = arena_stats(arena);
+    PhaseStats *p = &stats->phases[phase];
+    p->wall_ns = now - p->wall_ns;
+    p->alloc_count = arena_now.alloc_count - p->alloc_count;
+    p->alloc_bytes = arena_now.alloc_bytes - p->alloc_bytes;
+    p->retained_bytes = arena_now.used_bytes;
+    stats->arena_peak_bytes = arena_now.peak_bytes;
+    stats->arena_reserved_bytes = arena_now.reserved_bytes;
+    stats->arena_tags_counted = arena_tag_stats(arena, stats->arena_tags);
+    stats->arena_untagged = (ArenaTagStats){arena_now.alloc_count, arena_now.alloc_bytes, 0};
+    for (int t = 0; t < ARENA_TAG_COUNT; ++t) {
+        stats->arena_untagged.alloc_count -= stats->arena_tags[t].alloc_count;
+        stats->arena_untagged.alloc_bytes -= stats->arena_tags[t].alloc_bytes;
+    }
+}
+
+// Arena figures are sampled from the one arena every piece was compiled in, so the latest are kept
+void compile_stats_accumulate(CompileStats *total, const CompileStats *piece) {
+    for (int i = 0; i < COMPILE_PHASE_COUNT; ++i) {
+        PhaseStats *t = &total->phases[i];
+        const PhaseStats *p = &piece->phases[i];
+        if (!p->ran) {
+            continue;
+        }
+        t->ran = true;
+        t->wall_ns += p->wall_ns;
+        t->alloc_count += p->alloc_count;
+        t->alloc_bytes += p->alloc_bytes;
+        if (p->retained_bytes > t->retained_bytes) {
+            t->retained_bytes = p->retained_bytes;
+        }
+    }
+    total->source_bytes += piece->source_bytes;
+    total->token_count += piece->token_count;
+    total->ast_node_count += piece->ast_node_count;
+    total->tac_instruction_count += piece->tac_instruction_count;
+    total->tac_instruction_capacity += piece->tac_instruction_capacity;
+    total->tac_regrowth_count += piece->tac_regrowth_count;
+    total->optimized_tac_instruction_count += piece->optimized_tac_instruction_count;
+    total->assembly_bytes += piece->assembly_bytes;
+    total->arena_peak_bytes = piece->arena_peak_bytes;
+    total->arena_reserved_bytes = piece->arena_reserved_bytes;
+    total->arena_tags_counted = piece->arena_tags_counted;
+    for (int t = 0; t < ARENA_TAG_COUNT; ++t) {
+        total->arena_tags[t] = piece->arena_tags[t];
+    }
+    total->arena_untagged = piece->arena_untagged;
+    total->peephole.ran |= piece->peephole.ran;
+    for (int r = 0; r < PEEPHOLE_RULE_COUNT; ++r) {
+        total->peephole.hits[r] += piece->peephole.hits[r];
+    }
+}
+
+static uint64_t total_wall_ns(const CompileStats *stats) {
+    uint64_t total = 0;
+    for (int i = 0; i < COMPILE_PHASE_COUNT; ++i) {
+        total += stats->phases[i].wall_ns;
+    }
+    return total;
+}
+
+// Per-tag arena usage, the untagged rest last
+static void print_arena_tags_text(const CompileStats *stats, FILE *out) {
+    fprintf(out, "  %-10s %12s %12s %12s\n", "arena tag", "allocs", "bytes", "superseded");
+    for (int t = 0; t <= ARENA_TAG_COUNT; ++t) {
+        const ArenaTagStats *s = t < ARENA_TAG_COUNT ? &stats->arena_tags[t] : &stats->arena_untagged;
+        fprintf(out, "  %-10s %12zu %12zu %12zu\n", arena_tag_name((ArenaTag) t), s->alloc_count, s->alloc_bytes,
+                s->superseded_bytes);
+    }
+}
+
+static void print_text(const CompileStats *stats, FILE *out) {
+    const uint64_t total = total_wall_ns(stats);
+    fprintf(out, "===-------------------------------------------------------------===\n");
+    fprintf(out, "                      cleric time report\n");
+    fprintf(out, "===-------------------------------------------------------------===\n");
+    fprintf(out, "  %-10s %12s %7s %12s %12s %12s\n", "phase", "wall (us)", "%", "allocs", "alloc bytes",
+            "retained");
+    for (int i = 0; i < COMPILE_PHASE_COUNT; ++i) {
+        const PhaseStats *p = &stats->phases[i];
+        if (!p->ran) {
+            continue;
+        }
+        const double percent = total ? 100.0 * (double) p->wall_ns / (double) total : 0.0;
+        fprintf(out, "  %-10s %12.1f %6.1f%% %12zu %12zu %12zu\n", PHASE_NAMES[i], (double) p->wall_ns / 1000.0,
+                percent, p->alloc_count, p->alloc_bytes, p->retained_bytes);
+    }
+    fprintf(out, "  %-10s %12.1f\n", "total", (double) total / 1000.0);
+    fprintf(out, "  source bytes: %zu, tokens: %zu, AST nodes: %zu, TAC instructions: %zu, assembly bytes: %zu\n",
+            stats->source_bytes, stats->token_count, stats->ast_node_count, stats->tac_instruction_count,
+            stats->assembly_bytes);
+    fprintf(out, "  TAC instruction slots: %zu reserved, %zu regrowths\n", stats->tac_instruction_capacity,
+            stats->tac_regrowth_count);
+    if (stats->phases[COMPILE_PHASE_OPTIMIZE].ran) {
+        const size_t removed = stats->tac_instruction_count - stats->optimized_tac_instruction_count;
+        const double percent = stats->tac_instruction_count
+                                   ? 100.0 * (double) removed / (double) stats->tac_instruction_count
+                                   : 0.0;
+        fprintf(out, "  TAC instructions after optimization: %zu (%zu removed, %.1f%%)\n",
+                stats->optimized_tac_instruction_count, removed, percent);
+    }
+    fprintf(out, "  arena peak: %zu bytes, reserved: %zu bytes\n", stats->arena_peak_bytes,
+            stats->arena_reserved_bytes);
+    if (stats->arena_tags_counted) {
+        print_arena_tags_text(stats, out);
+    }
+    if (stats->peephole.ran) {
+        fprintf(out, "  peephole hits:");
+        for (int r = 0; r < PEEPHOLE_RULE_COUNT; ++r) {
+            fprintf(out, "%s %s %zu", r ? "," : "", peephole_rule_name((PeepholeRule) r), stats->peephole.hits[r]);
+        }
+        fprintf(out, "\n");
+    }
+    if (stats->cache_used) {
+        fprintf(out, "  compilation cache: %zu hits, %zu misses\n", stats->cache_hits, stats->cache_misses);
+    }
+    if (stats->function_cache_used) {
+        fprintf(out, "  function cache: %zu hits, %zu misses\n", stats->function_cache_hits,
+                stats->function_cache_misses);
+    }
+}
+
+static void print_json(const CompileStats *stats, FILE *out) {
+    fprintf(out, "{\"phases\":[");
+    bool first = true;
+    for (int i = 0; i < COMPILE_PHASE_COUNT; ++i) {
+        const PhaseStats *p = &stats->phases[i];
+        if (!p->ran) {
+            continue;
+        }
+        fprintf(out, "%s{\"name\":\"%s\",\"wall_ns\":%llu,\"alloc_count\":%zu,\"alloc_bytes\":%zu,"
+                "\"retained_bytes\":%zu}", first ? "" : ",", PHASE_NAMES[i], (unsigned long long) p->wall_ns,
+                p->alloc_count, p->alloc_bytes, p->retained_bytes);
+        first = false;
+    }
+    fprintf(out, "],\"total_wall_ns\":%llu,\"source_bytes\":%zu,\"tokens\":%zu,\"ast_nodes\":%zu,"
+            "\"tac_instructions\":%zu,\"tac_instruction_capacity\":%zu,\"tac_regrowths\":%zu,"
+            "\"optimized_tac_instructions\":%zu,\"assembly_bytes\":%zu,"
+            "\"arena_peak_bytes\":%zu,\"arena_reserved_bytes\":%zu",
+            (unsigned long long) total_wall_ns(stats), stats->source_bytes, stats->token_count,
+            stats->ast_node_count, stats->tac_instruction_count, stats->tac_instruction_capacity,
+            stats->tac_regrowth_count, stats->optimized_tac_instruction_count,
+            stats->assembly_bytes, stats->arena_peak_bytes,
+            stats->arena_reserved_bytes);
+    if (stats->arena_tags_counted) {
+        fprintf(out, ",\"arena_tags\":{");
+        for (int t = 0; t <= ARENA_TAG_COUNT; ++t) {
+            const ArenaTagStats *s = t < ARENA_TAG_COUNT ? &stats->arena_tags[t] : &stats->arena_untagged;
+            fprintf(out, "%s\"%s\":{\"allocs\":%zu,\"bytes\":%zu,\"superseded_bytes\":%zu}", t ? "," : "",
+                    arena_tag_name((ArenaTag) t), s->alloc_count, s->alloc_bytes, s->superseded_bytes);
+        }
+        fprintf(out, "}");
+    }
+    if (stats->peephole.ran) {
+        fprintf(out, ",\"peephole\":{");
+        for (int r = 0; r < PEEPHOLE_RULE_COUNT; ++r) {
+            fprintf(out, "%s\"%s\":%zu", r ? "," : "", peephole_rule_name((PeepholeRule) r), stats->peephole.hits[r]);
+        }
+        fprintf(out, "}");
+    }
+    if (stats->cache_used) {
+        fprintf(out, ",\"cache\":{\"hits\":%zu,\"misses\":%zu}", stats->cache_hits, stats->cache_misses);
+    }
+    if (stats->function_cache_used) {
+        fprintf(out, ",\"function_cache\":{\"hits\":%zu,\"misses\":%zu}", stats->function_cache_hits,
+                stats->function_cache_misses);
+    }
+    fprintf(out, "}\n");
+}
+
+void compile_stats_print(const CompileStats *stats, const TimeReportFormat format, FILE *out) {
+    switch (format) {
+        case TIME_REPORT_TEXT: print_text(stats, out);
+            break;
+        case TIME_REPORT_JSON: print_json(stats, out);
+            break;
+        case TIME_REPORT_NONE:
+        default: break;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../memory/arena.h"
+#include "options.h"
+#include "../codegen/peephole.h"
+
+// Phases measured by compile_with_options, in pipeline order
+typedef enum {
+    COMPILE_PHASE_LEX,
+    COMPILE_PHASE_PARSE,
+    COMPILE_PHASE_VALIDATE,
+    COMPILE_PHASE_IRGEN,
+    COMPILE_PHASE_OPTIMIZE, // Only at -O1 and above
+    COMPILE_PHASE_CODEGEN,
+    COMPILE_PHASE_COUNT
+} CompilePhase;
+
+// Measurements for one phase
+typedef struct {
+    bool ran;              // Whether the phase was reached
+    uint64_t wall_ns;      // Wall-clock time spent in the phase
+    size_t alloc_count;    // Arena allocations made during the phase
+    size_t alloc_bytes;    // Bytes requested from the arena during the phase
+    size_t retained_bytes; // Arena bytes still in use when the phase ended (after scratch was released)
+} PhaseStats;
+
+// Statistics for one compilation, filled in by compile_with_options
+typedef struct {
+    PhaseStats phases[COMPILE_PHASE_COUNT];
+    size_t source_bytes;                    // Length of the source text
+    size_t token_count;                     // Tokens produced by the lexer (including EOF)
+    size_t ast_node_count;                  // Nodes in the AST
+    size_t tac_instruction_count;           // TAC instructions over all functions
+    size_t tac_instruction_capacity;        // Instruction slots reserved for them (sized from the AST)
+    size_t tac_regrowth_count;              // Times an instruction array still had to be copied to grow
+    size_t optimized_tac_instruction_count; // TAC instructions left after the optimizer (the same below -O1)
+    size_t assembly_bytes;                  // Length of the generated assembly
+    size_t arena_peak_bytes;                // Peak arena usage over the whole compilation
+    size_t arena_reserved_bytes;            // Arena capacity at the end of the compilation
+    bool arena_tags_counted;                // Whether this build counts arena allocations per tag (CLERIC_ARENA_TAGS)
+    ArenaTagStats arena_tags[ARENA_TAG_COUNT]; // Arena allocations per subsystem
+    ArenaTagStats arena_untagged;           // Arena allocations made without a tag
+    PeepholeStats peephole;                 // Peephole rule hits (ran is false unless the pass ran)
+    bool cache_used;                        // Whether --cache-dir was consulted (set by the driver)
+    size_t cache_hits;                      // Outputs taken from the cache instead of compiled
+    size_t cache_misses;                    // Sources compiled because the cache had no output for them
+    bool function_cache_used;               // Whether CompileOptions::function_cache was consulted
+    size_t function_cache_hits;             // Functions whose assembly came from the function cache
+    size_t function_cache_misses;           // Functions lowered and generated because the cache lacked them
+} CompileStats;
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+uint64_t report_now_ns(void);
+
+/**
+ * @brief Returns the display name of a phase ("lex", "parse", ...).
+ */
+const char *compile_phase_name(CompilePhase phase);
+
+/**
+ * @brief Marks the start of a phase. Pair with compile_stats_end_phase.
+ * @param stats Statistics being filled in (may be NULL, in which case nothing is recorded).
+ * @param phase The phase being started.
+ * @param arena The compilation arena, whose counters are sampled.
+ */
+void compile_stats_begin_phase(CompileStats *stats, CompilePhase phase, const Arena *arena);
+
+/**
+ * @brief Marks the end of a phase started with compile_stats_begin_phase.
+ * @param stats Statistics being filled in (may be NULL).
+ * @param phase The phase being ended.
+ * @param arena The compilation arena, whose counters are sampled.
+ */
+void compile_stats_end_phase(CompileStats *stats, CompilePhase phase, const Arena *arena);
+
+/**
+ * @brief Adds the statistics of one piece of a source compiled piece by piece (--stream) to the total:
+ *        times, allocations and counts are summed, and the arena's figures are taken from the piece.
+ * @param total Statistics of the pieces so far (zeroed before the first).
+ * @param piece Statistics of the piece just compiled in the same arena.
+ */
+void compile_stats_accumulate(CompileStats *total, const CompileStats *piece);
+
+/**
+ * @brief Prints the statistics in the requested format.
+ * @param stats The statistics to print.
+ * @param format TIME_REPORT_TEXT or TIME_REPORT_JSON (TIME_REPORT_NONE prints nothing).
+ * @param out Stream to print to.
+ */
+void compile_stats_print(const CompileStats *stats, TimeReportFormat format, FILE *out);
+
+#endif // REPORT_H
@@ -0,0 +1,304 @@
+#include "server.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "compiler.h"
+
+// Size of the server arena's first chunk; it grows to fit the largest request and stays that size
+#define SERVER_ARENA_FIRST_CHUNK_SIZE (64 * 1024)
+
+// Requests waiting to be accepted while the server is busy with one
+#define SERVER_LISTEN_BACKLOG 64
+
+// A client that goes away mid-answer must make send fail, not kill the server with SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define SERVER_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SERVER_SEND_FLAGS 0
+#endif
+
+// Flag bits of a request; the -O level takes the low byte
+#define SERVER_FLAG_NO_PEEPHOLE (1u << 8)
+#define SERVER_FLAG_FLAT_AST (1u << 9)
+#define SERVER_FLAG_FUSE_VALIDATION (1u << 10)
+#define SERVER_FLAG_EMIT_OBJ (1u << 11)
+#define SERVER_FLAG_NO_OMIT_FRAME_POINTER (1u << 12)
+
+uint32_t compile_server_pack_options(const CompileOptions *options) {
+    uint32_t flags = (uint32_t) options->optimization_level & 0xffu;
+    if (options->no_peephole) flags |= SERVER_FLAG_NO_PEEPHOLE;
+    if (options->flat_ast) flags |= SERVER_FLAG_FLAT_AST;
+    if (options->fuse_validation) flags |= SERVER_FLAG_FUSE_VALIDATION;
+    if (options->emit_obj) flags |= SERVER_FLAG_EMIT_OBJ;
+    if (options->no_omit_frame_pointer) flags |= SERVER_FLAG_NO_OMIT_FRAME_POINTER;
+    return flags;
+}
+
+static void unpack_options(const uint32_t flags, CompileOptions *options) {
+    compile_options_init(options);
+    options->optimization_level = (int) (flags & 0xffu);
+    options->no_peephole = (flags & SERVER_FLAG_NO_PEEPHOLE) != 0;
+    options->flat_ast = (flags & SERVER_FLAG_FLAT_AST) != 0;
+    options->fuse_validation = (flags & SERVER_FLAG_FUSE_VALIDATION) != 0;
+    options->emit_obj = (flags & SERVER_FLAG_EMIT_OBJ) != 0;
+    options->no_omit_frame_pointer = (flags & SERVER_FLAG_NO_OMIT_FRAME_POINTER) != 0;
+    options->quiet = true; // The server's stdout is nobody's terminal
+}
+
+static bool read_exact(const int fd, void *data, size_t size) {
+    char *bytes = data;
+    while (size > 0) {
+        const ssize_t got = read(fd, bytes, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        size -= (size_t) got;
+    }
+    return true;
+}
+
+static bool send_exact(const int fd, const void *data, size_t size) {
+    const char *bytes = data;
+    while (size > 0) {
+        const ssize_t sent = send(fd, bytes, size, SERVER_SEND_FLAGS);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= (size_t) sent;
+    }
+    return true;
+}
+
+// Segment visitor sending a chunked output buffer without flattening it
+static bool send_segment(const char *data, const size_t length, void *context) {
+    return send_exact(*(const int *) context, data, length);
+}
+
+// Fills a sockaddr_un; false if the path does not fit
+static bool socket_address(const char *socket_path, struct sockaddr_un *address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Error: socket path '%s' is too long.\n", socket_path);
+        return false;
+    }
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+bool compile_server_open(CompileServer *server, const char *socket_path) {
+    *server = (CompileServer){.listen_fd = -1};
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        return false;
+    }
+
+    server->arena = arena_create(SERVER_ARENA_FIRST_CHUNK_SIZE);
+    if (!server->arena.start || !function_cache_init(&server->functions)) {
+        fprintf(stderr, "Server Error: Failed to create the server arena.\n");
+        compile_server_close(server);
+        return false;
+    }
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        perror("Failed to create socket");
+        compile_server_close(server);
+        return false;
+    }
+    // Replace a socket left behind by a server that was killed, never a file that happens to be there
+    struct stat existing;
+    if (lstat(socket_path, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            fprintf(stderr, "Server Error: %s exists and is not a socket; not replacing it.\n", socket_path);
+            compile_server_close(server);
+            return false;
+        }
+        unlink(socket_path);
+    }
+    if (bind(server->listen_fd, (const struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(server->listen_fd, SERVER_LISTEN_BACKLOG) != 0) {
+        perror("Failed to listen on socket");
+        fprintf(stderr, "Socket: %s\n", socket_path);
+        compile_server_close(server); // The path is not recorded yet: bind may have failed on someone else's file
+        return false;
+    }
+    strcpy(server->socket_path, socket_path); // Ours now, removed by compile_server_close
+    return true;
+}
+
+// Reads the source of a request into the server arena and compiles it into a chunked buffer
+static bool answer_request(CompileServer *server, const int connection, const CompileServerRequest *request) {
+    CompileServerResponse response = {COMPILE_SERVER_MAGIC, 1, 0};
+    char *source = request->source_length < SIZE_MAX ? arena_alloc(&server->arena, (size_t) request->source_length + 1)
+                                                     : NULL;
+    if (!source || !read_exact(connection, source, (size_t) request->source_length)) {
+        fprintf(stderr, "Server Error: Failed to receive a source of %llu bytes.\n",
+                (unsigned long long) request->source_length);
+        return send_exact(connection, &response, sizeof(response));
+    }
+    source[request->source_length] = '\0';
+
+    CompileOptions options;
+    unpack_options(request->flags, &options);
+    options.function_cache = &server->functions;
+    StringBuffer output;
+    string_buffer_init_chunked(&output, &server->arena, 0);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &output);
+    // The errors go back to the client, which reports them; the server's stderr is nobody's terminal either
+    StringBuffer messages;
+    string_buffer_init(&messages, &server->arena, 256);
+    Diagnostics diagnostics;
+    diagnostics_init(&diagnostics, &messages);
+    if (compile_source_with_diagnostics(source, (size_t) request->source_length, &options, &sink, &server->arena,
+                                        &diagnostics)) {
+        response.status = 0;
+    }
+    const StringBuffer *answer = response.status == 0 ? &output : &messages;
+    response.output_length = answer->length;
+    int fd = connection;
+    return send_exact(connection, &response, sizeof(response)) &&
+           string_buffer_for_each_segment(answer, send_segment, &fd);
+}
+
+bool compile_server_serve_one(CompileServer *server) {
+    const int connection = accept(server->listen_fd, NULL, NULL);
+    if (connection < 0) {
+        if (errno != EINTR) {
+            perror("Failed to accept a connection");
+        }
+        return false;
+    }
+    bool keep_going = true;
+    CompileServerRequest request;
+    if (!read_exact(connection, &request, sizeof(request)) || request.magic != COMPILE_SERVER_MAGIC) {
+        fprintf(stderr, "Server Error: Ignoring a malformed request.\n");
+    } else if (request.flags & COMPILE_SERVER_STOP) {
+        const CompileServerResponse response = {COMPILE_SERVER_MAGIC, 0, 0};
+        send_exact(connection, &response, sizeof(response));
+        keep_going = false;
+    } else {
+        if (!answer_request(server, connection, &request)) {
+            fprintf(stderr, "Server Error: Failed to send the answer to a client.\n");
+        }
+        server->requests_served++;
+        // Keeps the largest chunk, so the next request allocates nothing from the system
+        arena_reset_with_mode(&server->arena, ARENA_RESET_DIRTY);
+    }
+    close(connection);
+    return keep_going;
+}
+
+void compile_server_close(CompileServer *server) {
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+    }
+    if (server->socket_path[0] != '\0') {
+        unlink(server->socket_path);
+    }
+    if (server->arena.start) {
+        arena_destroy(&server->arena);
+    }
+    function_cache_destroy(&server->functions); // Nothing to do if it was never created
+    *server = (CompileServer){.listen_fd = -1};
+}
+
+// Connects to the server and sends a request header and its payload; returns the socket or -1
+static int send_request(const char *socket_path, const uint32_t flags, const char *source,
+                        const size_t source_length) {
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        return -1;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Failed to create socket");
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *) &address, sizeof(address)) != 0) {
+        fprintf(stderr, "Failed to connect to the compile server at %s: %s\n", socket_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    const CompileServerRequest request = {COMPILE_SERVER_MAGIC, flags, source_length};
+    if (!send_exact(fd, &request, sizeof(request)) || !send_exact(fd, source, source_length)) {
+        fprintf(stderr, "Failed to send the request to the compile server\n");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reports the error lines a server answered with, as if they were the client's own
+static void report_server_errors(const char *messages, const size_t length, Diagnostics *diagnostics) {
+    size_t start = 0;
+    while (start < length) {
+        const char *newline = memchr(messages + start, '\n', length - start);
+        const size_t end = newline ? (size_t) (newline - messages) : length;
+        if (diagnostics) {
+            diagnostics_error(diagnostics, "%.*s", (int) (end - start), messages + start);
+        } else {
+            fprintf(stderr, "%.*s\n", (int) (end - start), messages + start);
+        }
+        start = end + 1;
+    }
+}
+
+bool compile_server_request(const char *socket_path, const char *source, const size_t source_length,
+                            const CompileOptions *options, char **out_output, size_t *out_size,
+                            Diagnostics *diagnostics) {
+    if (compile_options_stops_early(options)) {
+        fprintf(stderr, "Error: the compile server only runs the full pipeline, not a stop-early mode.\n");
+        return false;
+    }
+    const int fd = send_request(socket_path, compile_server_pack_options(options), source, source_length);
+    if (fd < 0) {
+        return false;
+    }
+    CompileServerResponse response;
+    bool success = read_exact(fd, &response, sizeof(response)) && response.magic == COMPILE_SERVER_MAGIC;
+    if (!success) {
+        fprintf(stderr, "Failed to read the compile server's answer\n");
+    } else {
+        char *output = response.output_length < SIZE_MAX ? malloc((size_t) response.output_length + 1) : NULL;
+        if (!output || !read_exact(fd, output, (size_t) response.output_length)) {
+            fprintf(stderr, "Failed to read the compile server's output\n");
+            free(output);
+            success = false;
+        } else if (response.status != 0) {
+            report_server_errors(output, (size_t) response.output_length, diagnostics);
+            free(output);
+            success = false;
+        } else {
+            output[response.output_length] = '\0';
+            *out_output = output;
+            *out_size = (size_t) response.output_length;
+        }
+    }
+    close(fd);
+    return success;
+}
+
+bool compile_server_stop(const char *socket_path) {
+    const int fd = send_request(socket_path, COMPILE_SERVER_STOP, NULL, 0);
+    if (fd < 0) {
+        return false;
+    }
+    CompileServerResponse response;
+    const bool acknowledged = read_exact(fd, &response, sizeof(response)) && response.magic == COMPILE_SERVER_MAGIC;
+    close(fd);
+    return acknowledged;
+}
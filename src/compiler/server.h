@@ -0,0 +1,103 @@
+#ifndef CLERIC_SERVER_H
+#define CLERIC_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../memory/arena.h"
+#include "options.h"
+#include "function_cache.h"
+#include "diagnostics.h"
+
+//------------------------------------------------------------------------------
+// Compile server
+//
+// `cleric --server=PATH` listens on a Unix socket and compiles preprocessed
+// sources sent by `cleric --connect=PATH` clients, so a build of many small
+// files pays for process creation and the first arena chunk once instead of
+// once per file. The server answers one connection at a time and keeps its
+// arena between requests (reset, never freed), so after the first request the
+// chunks a compilation needs are already there. It also keeps a function cache
+// (function_cache.h): a function sent again unchanged is not compiled again.
+//
+// Each connection carries one request: a CompileServerRequest followed by
+// source_length bytes of preprocessed source. The answer is a
+// CompileServerResponse followed by output_length bytes of assembly (or, with
+// --emit-obj, an ELF object). A failed compilation answers with the errors
+// instead, one per line, which the client reports as its own. Both sides run on
+// the same host, so the headers are sent in native byte order.
+//------------------------------------------------------------------------------
+
+#define COMPILE_SERVER_MAGIC 0x434c5253u // "CLRS"
+
+// Request flag asking the server to stop after answering (no source follows)
+#define COMPILE_SERVER_STOP (1u << 31)
+
+typedef struct {
+    uint32_t magic;         // COMPILE_SERVER_MAGIC
+    uint32_t flags;         // compile_server_pack_options(), or COMPILE_SERVER_STOP
+    uint64_t source_length; // Bytes of source following the header
+} CompileServerRequest;
+
+typedef struct {
+    uint32_t magic;         // COMPILE_SERVER_MAGIC
+    uint32_t status;        // 0 if the source compiled, 1 otherwise
+    uint64_t output_length; // Bytes of output (on failure: of error messages) following the header
+} CompileServerResponse;
+
+typedef struct {
+    int listen_fd;
+    char socket_path[108]; // Removed again by compile_server_close
+    Arena arena;           // Shared by every request, reset after each one
+    FunctionCache functions; // Assembly of every function compiled so far, reused when it comes back
+    size_t requests_served;
+} CompileServer;
+
+/**
+ * @brief Packs the options a request carries (-O level, --no-peephole, --no-omit-frame-pointer,
+ *        --flat-ast, --fuse-validation, --emit-obj) into request flags.
+ */
+uint32_t compile_server_pack_options(const CompileOptions *options);
+
+/**
+ * @brief Starts listening on a Unix socket. A socket left at the path (by a server that was killed)
+ *        is replaced; any other file there is left alone and the server does not start.
+ * @return false (with an error printed) if the path is taken or the socket could not be created or bound.
+ */
+bool compile_server_open(CompileServer *server, const char *socket_path);
+
+/**
+ * @brief Accepts one connection and answers its request.
+ * @return false once a client asked the server to stop or accepting failed (e.g. on a signal),
+ *         true if the server should keep going.
+ */
+bool compile_server_serve_one(CompileServer *server);
+
+/**
+ * @brief Stops listening, removes the socket file and frees the arena.
+ */
+void compile_server_close(CompileServer *server);
+
+/**
+ * @brief Sends a preprocessed source to a server and waits for the compiled output.
+ * @param socket_path The path the server listens on.
+ * @param source The preprocessed source (need not be null-terminated).
+ * @param source_length Number of bytes of source.
+ * @param options Only the code-affecting options and --emit-obj are sent; stop-early modes are rejected.
+ * @param out_output Receives the output (malloc'd, to be freed by the caller) on success.
+ * @param out_size Receives the number of bytes of output.
+ * @param diagnostics If non-NULL, receives the server's errors for a source that failed to compile;
+ *                    NULL prints them to stderr.
+ * @return true if the server compiled the source.
+ */
+bool compile_server_request(const char *socket_path, const char *source, size_t source_length,
+                            const CompileOptions *options, char **out_output, size_t *out_size,
+                            Diagnostics *diagnostics);
+
+/**
+ * @brief Asks the server on socket_path to stop once it has answered.
+ * @return true if the server acknowledged.
+ */
+bool compile_server_stop(const char *socket_path);
+
+#endif // CLERIC_SERVER_H
@@ -0,0 +1,140 @@
+#include "trace.h"
+#include "report.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Events reserved by trace_start; the array doubles when it fills
+#define TRACE_INITIAL_CAPACITY 4096
+
+typedef struct {
+    uint64_t timestamp_ns;
+    const char *category;
+    int thread_id;
+    char phase; // 'B' or 'E'
+    char name[TRACE_NAME_MAX];
+} TraceEvent;
+
+bool trace_recording = false;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER; // Guards everything below
+static TraceEvent *events;
+static size_t event_count;
+static size_t event_capacity;
+static bool out_of_memory;
+static const char *trace_path;
+static uint64_t trace_origin_ns; // Timestamps are written relative to trace_start
+static int next_thread_id;
+
+static __thread int thread_id; // 0 until the thread's first event
+
+bool trace_start(const char *path) {
+    pthread_mutex_lock(&trace_lock);
+    free(events);
+    events = malloc(TRACE_INITIAL_CAPACITY * sizeof(TraceEvent));
+    event_count = 0;
+    event_capacity = events ? TRACE_INITIAL_CAPACITY : 0;
+    out_of_memory = false;
+    trace_path = path;
+    trace_origin_ns = report_now_ns();
+    pthread_mutex_unlock(&trace_lock);
+    if (!events) {
+        fprintf(stderr, "Trace Error: Out of memory for trace events.\n");
+        return false;
+    }
+    trace_recording = true;
+    return true;
+}
+
+size_t trace_event_count(void) {
+    pthread_mutex_lock(&trace_lock);
+    const size_t count = event_count;
+    pthread_mutex_unlock(&trace_lock);
+    return count;
+}
+
+void trace_record(const char phase, const char *category, const char *name) {
+    const uint64_t now = report_now_ns();
+    pthread_mutex_lock(&trace_lock);
+    if (thread_id == 0) {
+        thread_id = ++next_thread_id;
+    }
+    if (event_count == event_capacity && !out_of_memory) {
+        TraceEvent *grown = realloc(events, 2 * event_capacity * sizeof(TraceEvent));
+        if (grown) {
+            events = grown;
+            event_capacity *= 2;
+        } else {
+            out_of_memory = true; // Later events are dropped; trace_stop says so
+        }
+    }
+    if (event_count < event_capacity) {
+        TraceEvent *event = &events[event_count++];
+        event->timestamp_ns = now;
+        event->category = category;
+        event->thread_id = thread_id;
+        event->phase = phase;
+        snprintf(event->name, sizeof(event->name), "%s", name ? name : "");
+    }
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// Writes a JSON string literal; names are command lines and identifiers, but a path may hold anything
+static void write_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *c = (const unsigned char *) text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+bool trace_stop(void) {
+    if (!trace_recording) {
+        return true;
+    }
+    trace_recording = false;
+    pthread_mutex_lock(&trace_lock);
+    bool success = true;
+    FILE *out = fopen(trace_path, "w");
+    if (!out) {
+        perror("Failed to open the trace file");
+        success = false;
+    } else {
+        const long pid = (long) getpid();
+        fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        for (size_t i = 0; i < event_count; ++i) {
+            const TraceEvent *event = &events[i];
+            const uint64_t elapsed_ns = event->timestamp_ns - trace_origin_ns;
+            fprintf(out, "{\"name\":");
+            write_json_string(out, event->name);
+            // Trace timestamps are in microseconds; the fraction keeps the nanoseconds
+            fprintf(out, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%ld,\"tid\":%d}%s\n",
+                    event->category, event->phase, (unsigned long long) (elapsed_ns / 1000),
+                    (unsigned) (elapsed_ns % 1000), pid, event->thread_id, i + 1 < event_count ? "," : "");
+        }
+        fprintf(out, "]}\n");
+        if (fclose(out) != 0) {
+            perror("Failed to write the trace file");
+            success = false;
+        }
+    }
+    if (out_of_memory) {
+        fprintf(stderr, "Warning: the trace ran out of memory after %zu events; later ones are missing.\n",
+                event_count);
+    }
+    free(events);
+    events = NULL;
+    event_count = 0;
+    event_capacity = 0;
+    pthread_mutex_unlock(&trace_lock);
+    return success;
+}
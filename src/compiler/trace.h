@@ -0,0 +1,69 @@
+#ifndef CLERIC_TRACE_H
+#define CLERIC_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// Event trace of the compiler's internals (--trace=FILE)
+//
+// While a trace is recording, trace_begin and trace_end append begin ("B") and
+// end ("E") events, stamped with the monotonic clock and a small per-thread id.
+// trace_stop writes them in the Chrome Trace Event format, which
+// chrome://tracing and ui.perfetto.dev open directly. Each thread's events must
+// nest: every trace_begin is closed by a trace_end on the same thread before
+// the enclosing one is.
+//
+// When no trace is recording, the two calls test one flag and return. The flag
+// is only changed by trace_start and trace_stop. They must run while no other
+// thread is emitting events: before the -j workers start and after they have
+// been joined.
+//------------------------------------------------------------------------------
+
+// Longest event name kept; longer names (child command lines) are cut short
+#define TRACE_NAME_MAX 96
+
+extern bool trace_recording; // Set between trace_start and trace_stop
+
+/**
+ * @brief Starts recording events, discarding any left from an earlier trace.
+ * @param path File trace_stop writes the events to.
+ * @return false (with an error printed) if memory for the first events ran out.
+ */
+bool trace_start(const char *path);
+
+/**
+ * @brief Stops recording and writes the events to the file given to trace_start.
+ * @return false (with an error printed) if the file could not be written. true if no trace was recording.
+ */
+bool trace_stop(void);
+
+/**
+ * @brief Number of events recorded since trace_start.
+ */
+size_t trace_event_count(void);
+
+// Appends one event; called through trace_begin and trace_end
+void trace_record(char phase, const char *category, const char *name);
+
+/**
+ * @brief Opens a scope on the calling thread.
+ * @param category Group of the event ("phase", "pass", "codegen", "process"); must be a string literal.
+ * @param name What is running; copied, so it may be freed before the trace is written.
+ */
+static inline void trace_begin(const char *category, const char *name) {
+    if (trace_recording) {
+        trace_record('B', category, name);
+    }
+}
+
+/**
+ * @brief Closes the innermost scope opened by trace_begin on the calling thread.
+ */
+static inline void trace_end(const char *category, const char *name) {
+    if (trace_recording) {
+        trace_record('E', category, name);
+    }
+}
+
+#endif // CLERIC_TRACE_H
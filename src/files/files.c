@@ -4,6 +4,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define FILES_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define FILES_HAVE_MMAP 0
+#endif
+
 char *filename_replace_ext(const char *input_file, const char *new_ext, char *dest, size_t dest_size) {
     // Calculate the length of the input filename
     const size_t len = strlen(input_file);
@@ -80,6 +90,121 @@ char *read_entire_file(const char *filename, long *out_file_size) {
     return data;
 }
 
+// Size of the first buffer of read_entire_stream; it doubles while the stream has more
+#define STREAM_FIRST_BUFFER_SIZE (64 * 1024)
+
+char *read_entire_stream(FILE *stream, size_t *out_size) {
+    if (!stream) return NULL;
+    size_t capacity = STREAM_FIRST_BUFFER_SIZE;
+    size_t size = 0;
+    char *data = malloc(capacity);
+    if (!data) return NULL;
+
+    for (;;) {
+        // Keep one byte for the terminator
+        size += fread(data + size, 1, capacity - 1 - size, stream);
+        if (size < capacity - 1) {
+            if (ferror(stream)) {
+                free(data);
+                return NULL;
+            }
+            break; // EOF
+        }
+        char *grown = realloc(data, capacity * 2);
+        if (!grown) {
+            free(data);
+            return NULL;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+
+    data[size] = '\0';
+    if (out_size) *out_size = size;
+    return data;
+}
+
+// Copies the file into a malloc buffer, as read_entire_file does
+static bool copy_entire_file(const char *filename, MappedFile *out_file) {
+    long size = 0;
+    char *data = read_entire_file(filename, &size);
+    if (!data) return false;
+    *out_file = (MappedFile){.data = data, .size = (size_t) size};
+    return true;
+}
+
+#if FILES_HAVE_MMAP
+// Maps `size` bytes of fd followed by at least one zero byte. The kernel zero-fills the tail of
+// a file's last page, so only a page-aligned size needs an anonymous page reserved after it.
+// The mapping is private, so with PROT_WRITE the pages written to are copied and the file never changes.
+static bool map_with_terminator(const int fd, const size_t size, const int protection, MappedFile *out_file) {
+    const size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size_t mapping_size = size;
+    void *mapping;
+    if (size % page_size != 0) {
+        mapping = mmap(NULL, size, protection, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) return false;
+    } else {
+        mapping_size = size + page_size;
+        mapping = mmap(NULL, mapping_size, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) return false;
+        // The file replaces the start of the reservation; the page after it stays zero
+        if (mmap(mapping, size, protection, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(mapping, mapping_size);
+            return false;
+        }
+    }
+
+    // The lexer reads the source once, front to back: let the kernel read ahead
+    madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+    *out_file = (MappedFile){.data = mapping, .size = size, .mapping = mapping, .mapping_size = mapping_size};
+    return true;
+}
+#endif
+
+static bool map_file(const char *filename, const bool writable, MappedFile *out_file) {
+    *out_file = (MappedFile){0};
+    if (!filename) return false;
+#if FILES_HAVE_MMAP
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    // Only non-empty regular files can be mapped (a zero-length mapping is an error)
+    const bool mapped = S_ISREG(st.st_mode) && st.st_size > 0 &&
+                        map_with_terminator(fd, (size_t) st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                            out_file);
+    close(fd); // The mapping keeps its own reference to the file
+    if (mapped) return true;
+#else
+    (void) writable;
+#endif
+    return copy_entire_file(filename, out_file);
+}
+
+bool map_entire_file(const char *filename, MappedFile *out_file) {
+    return map_file(filename, false, out_file);
+}
+
+bool map_entire_file_writable(const char *filename, MappedFile *out_file) {
+    return map_file(filename, true, out_file);
+}
+
+void unmap_file(MappedFile *file) {
+    if (!file) return;
+#if FILES_HAVE_MMAP
+    if (file->mapping) {
+        munmap(file->mapping, file->mapping_size);
+        *file = (MappedFile){0};
+        return;
+    }
+#endif
+    free((char *) file->data);
+    *file = (MappedFile){0};
+}
 
 bool filename_has_ext(const char *filename, const char *ext) {
     // Guard against NULL pointers
@@ -130,3 +255,34 @@ bool write_string_to_file(const char *filename, const char *content) {
 
     return true;
 }
+
+bool write_string_buffer_to_file(const char *filename, const StringBuffer *sb) {
+    // Must provide valid filename and buffer
+    if (!filename || !sb) {
+        return false;
+    }
+
+    // Open the file in write mode ("w"), which truncates or creates
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        perror("Failed to open file for writing");
+        fprintf(stderr, "Filename: %s\n", filename);
+        return false;
+    }
+
+    // Write each segment in place; the content is never joined into one string
+    if (!string_buffer_write(sb, file)) {
+        perror("Failed to write content to file");
+        fprintf(stderr, "Filename: %s\n", filename);
+        fclose(file);
+        return false;
+    }
+
+    if (fclose(file) != 0) {
+        perror("Failed to close file");
+        fprintf(stderr, "Filename: %s\n", filename);
+        return false;
+    }
+
+    return true;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "../strings/strings.h"
 
 // Replaces the extension of a filename.
 // Returns dest if successful, NULL otherwise.
@@ -13,6 +14,31 @@ char *filename_replace_ext(const char *input_file, const char *new_ext, char *de
 // Returns the buffer or NULL on error. Sets out_file_size if not NULL.
 char *read_entire_file(const char *filename, long *out_file_size);
 
+// Reads a stream (e.g. the read end of a pipe) until EOF into a dynamically allocated,
+// null-terminated buffer. Returns the buffer or NULL on error. Sets out_size if not NULL.
+char *read_entire_stream(FILE *stream, size_t *out_size);
+
+// A whole file in memory: mapped where the platform allows it, copied otherwise.
+// data[size] is always '\0', so the contents can also be used as a C string.
+typedef struct {
+    const char *data;
+    size_t size;
+    void *mapping;       // Start of the mapping, NULL when the contents were copied into a malloc buffer
+    size_t mapping_size; // Bytes mapped, including the zero page added after page-aligned files
+} MappedFile;
+
+// Maps a file read-only for one sequential pass (on POSIX; elsewhere, and for empty or
+// unmappable files, falls back to read_entire_file). The file must not shrink while mapped.
+// Returns true on success; release the contents with unmap_file.
+bool map_entire_file(const char *filename, MappedFile *out_file);
+
+// Same as map_entire_file, with the contents writable: pages written to become private copies,
+// and the file itself never changes. Release with unmap_file.
+bool map_entire_file_writable(const char *filename, MappedFile *out_file);
+
+// Releases what map_entire_file or map_entire_file_writable returned and clears the struct.
+void unmap_file(MappedFile *file);
+
 // Checks if a filename ends with the specified extension (case-sensitive).
 // The extension should include the dot (e.g., ".c").
 bool filename_has_ext(const char *filename, const char *ext);
@@ -21,4 +47,8 @@ bool filename_has_ext(const char *filename, const char *ext);
 // Returns true on success, false on error.
 bool write_string_to_file(const char *filename, const char *content);
 
+// Writes the content of a StringBuffer (contiguous or chunked) to a file, segment by segment,
+// overwriting it if it exists. Returns true on success, false on error.
+bool write_string_buffer_to_file(const char *filename, const StringBuffer *sb);
+
 #endif // FILES_H
@@ -0,0 +1,116 @@
+#include "function_reader.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+void function_reader_init(FunctionReader *reader, FILE *stream) {
+    *reader = (FunctionReader){0};
+    reader->stream = stream;
+    reader->line = 1;
+}
+
+void function_reader_destroy(FunctionReader *reader) {
+    free(reader->buffer);
+    reader->buffer = NULL;
+    reader->capacity = 0;
+    reader->length = 0;
+}
+
+// Moves the text not yet returned to the front of the buffer and reads more after it
+static bool fill(FunctionReader *reader) {
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->length - reader->start);
+        reader->length -= reader->start;
+        reader->start = 0;
+    }
+    // One byte past the text stays free for the terminator
+    if (reader->capacity - reader->length < FUNCTION_READER_READ_SIZE + 1) {
+        size_t capacity = reader->capacity ? reader->capacity : 2 * FUNCTION_READER_READ_SIZE;
+        while (capacity - reader->length < FUNCTION_READER_READ_SIZE + 1) {
+            capacity *= 2;
+        }
+        char *grown = realloc(reader->buffer, capacity);
+        if (!grown) {
+            fprintf(stderr, "Failed to grow the input buffer to %zu bytes\n", capacity);
+            reader->failed = true;
+            return false;
+        }
+        reader->buffer = grown;
+        reader->capacity = capacity;
+    }
+    const size_t got = fread(reader->buffer + reader->length, 1, FUNCTION_READER_READ_SIZE, reader->stream);
+    reader->length += got;
+    if (got < FUNCTION_READER_READ_SIZE) {
+        if (ferror(reader->stream)) {
+            perror("Failed to read the input");
+            reader->failed = true;
+            return false;
+        }
+        reader->at_end = true;
+    }
+    return true;
+}
+
+bool function_reader_next(FunctionReader *reader, const char **out_text, size_t *out_length, size_t *out_line) {
+    if (reader->failed) {
+        return false;
+    }
+    if (reader->holding) {
+        reader->buffer[reader->start] = reader->held;
+        reader->holding = false;
+    }
+    // Skip the whitespace between definitions (the previous definition was consumed by the last call)
+    for (;;) {
+        while (reader->start < reader->length && isspace((unsigned char) reader->buffer[reader->start])) {
+            if (reader->buffer[reader->start] == '\n') {
+                reader->line++;
+            }
+            reader->start++;
+        }
+        if (reader->start < reader->length) {
+            break;
+        }
+        if (reader->at_end || !fill(reader)) {
+            return false;
+        }
+    }
+
+    // Count braces until the outermost one closes; a stray '}' ends the piece as well
+    reader->scanned = 0;
+    reader->depth = 0;
+    for (;;) {
+        bool closed = false;
+        while (!closed && reader->start + reader->scanned < reader->length) {
+            const char c = reader->buffer[reader->start + reader->scanned++];
+            if (c == '{') {
+                reader->depth++;
+            } else if (c == '}') {
+                closed = --reader->depth <= 0;
+            }
+        }
+        if (closed || reader->at_end) {
+            break;
+        }
+        if (!fill(reader)) {
+            return false;
+        }
+    }
+
+    char *text = reader->buffer + reader->start;
+    const size_t length = reader->scanned;
+    *out_text = text;
+    *out_length = length;
+    *out_line = reader->line;
+    for (size_t i = 0; i < length; ++i) {
+        reader->line += text[i] == '\n';
+    }
+    if (length > reader->largest) {
+        reader->largest = length;
+    }
+    reader->start += length;
+    // The terminator takes the place of the byte after the definition until the next call
+    reader->held = text[length];
+    text[length] = '\0';
+    reader->holding = true;
+    return true;
+}
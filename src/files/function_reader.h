@@ -0,0 +1,44 @@
+#ifndef FUNCTION_READER_H
+#define FUNCTION_READER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bytes asked of the stream at a time
+#define FUNCTION_READER_READ_SIZE ((size_t) 64 * 1024)
+
+// Cuts preprocessed source into its top-level definitions as the stream delivers it (--stream).
+// A definition ends at the '}' that closes its outermost brace; the language has no string or
+// character literals and the preprocessor removed the comments, so counting braces is enough.
+// Only the definition being returned and the bytes read past it are held, so the buffer grows to
+// the largest definition plus one read, whatever the length of the stream.
+typedef struct {
+    FILE *stream;
+    char *buffer;       // malloc'd; [start, length) is text not yet returned
+    size_t capacity;
+    size_t length;
+    size_t start;       // Beginning of the next definition
+    size_t scanned;     // Bytes from start whose braces are already counted into depth
+    int depth;          // Braces open at `scanned`
+    size_t line;        // Line of the stream where the next definition begins (from 1)
+    bool at_end;        // The stream has nothing more to give
+    bool failed;        // Reading or growing the buffer failed (an error was printed)
+    char held;          // The byte the last definition's terminator replaced, at `start`
+    bool holding;
+    size_t largest;     // Longest definition returned so far, in bytes
+} FunctionReader;
+
+// Starts reading definitions from the stream, which the reader does not close.
+void function_reader_init(FunctionReader *reader, FILE *stream);
+
+// Returns the next top-level definition, null-terminated, in *out_text (valid until the next call)
+// with its length in *out_length and the line it starts on in *out_line. Text left after the last
+// complete definition is returned as one more piece, so the compiler can report what is wrong with it.
+// Returns false at the end of the stream, or when reader->failed is set.
+bool function_reader_next(FunctionReader *reader, const char **out_text, size_t *out_length, size_t *out_line);
+
+// Frees the buffer.
+void function_reader_destroy(FunctionReader *reader);
+
+#endif // FUNCTION_READER_H
@@ -1,29 +1,78 @@
 #include "ast_to_tac.h"
 
+#include "../memory/arena_stack.h"
+#include "../parser/flat_ast.h"
+#include "../validator/symbol_table.h"
+
 #include <stdio.h>  // For error reporting (potentially)
 #include <stdlib.h> // For NULL
 #include <stdbool.h>// For bool type
-#include <string.h> // For strcpy and strlen for label generation
+#include <string.h> // For strlen
+
+// Per-function translation state
+typedef struct {
+    const FlatAst *flat;          // Tree being lowered when it is in flat form, NULL for the pointer tree
+    TacFunction *function;        // Function receiving the instructions
+    Arena *arena;                 // Arena for instructions and the frame stack
+    int next_temp_id;             // Next temporary to hand out
+    int label_counter;            // Next label to hand out
+    ArenaStack expression_frames; // Work list of visit_expression (ExpressionFrame items)
+    SymbolTable *symbols;         // Fused pass: variables in scope, each mapped to its temp; NULL otherwise
+    bool failed;                  // Fused pass: a semantic error was reported, the TAC is discarded
+    bool branchless_logical;      // TacLoweringOptions.branchless_logical
+    bool returned;                // A RETURN was emitted; statements have no branches, so nothing after it runs
+} TacGenContext;
+
+// Where an expression node is in its translation. Each frame stands for one activation
+// of what used to be a recursive visitor.
+typedef enum {
+    EXPRESSION_STATE_START,       // Nothing visited yet
+    EXPRESSION_STATE_AFTER_FIRST, // The operand (unary) or the left operand (binary) is in `result`
+    EXPRESSION_STATE_AFTER_SECOND // The right operand is in `result`
+} ExpressionState;
+
+// An expression node in either form: a pointer (TacGenContext.flat == NULL) or a flat handle
+typedef union {
+    const AstNode *node;
+    AstHandle handle;
+} ExpressionRef;
+
+// The node is decoded when its frame is pushed, so the steps below work the same on both forms
+typedef struct {
+    bool present;         // false for a missing (NULL) node
+    NodeType type;
+    int op;               // UnaryOperatorType or BinaryOperatorType
+    int value;            // NODE_INT_LITERAL
+    const char *name;     // NODE_IDENTIFIER
+    ExpressionRef first;  // Operand (unary) or left operand (binary)
+    ExpressionRef second; // Right operand (binary)
+    ExpressionState state;
+    TacOperand lhs;       // Left operand of an arithmetic or relational operator
+    TacOperand dest;      // Result temp of && and ||, allocated before the right operand is visited
+    TacOperand labels[3]; // Labels of && (false exit, end) and || (eval rhs, true exit, end)
+    bool branchless;      // && or || lowered to LOGICAL_AND / LOGICAL_OR: `lhs` holds the left operand
+} ExpressionFrame;
 
 // --- Static Helper Function Declarations ---
 
 // Forward declaration for visiting statements (like ReturnStmt)
-static void visit_statement(AstNode *node, TacFunction *current_function, Arena *arena, int *next_temp_id_ptr,
-                            int *label_counter_ptr);
+static void visit_statement(AstNode *node, TacGenContext *ctx);
+
+// Forward declaration for visiting the statements of a flat tree
+static void visit_flat_statement(AstHandle handle, TacGenContext *ctx);
 
 // Forward declaration for visiting expressions (which produce a value)
-static TacOperand visit_expression(AstNode *node, TacFunction *current_function, Arena *arena, int *next_temp_id_ptr,
-                                   int *label_counter_ptr);
+static TacOperand visit_expression(ExpressionRef node, TacGenContext *ctx);
 
-// Helper to generate unique label names
-static const char *generate_label_name(Arena *arena, int *label_counter_ptr) {
-    char buffer[32]; // Sufficient for "L" + number
-    sprintf(buffer, "L%d", (*label_counter_ptr)++);
-    char *label_str = arena_alloc(arena, strlen(buffer) + 1);
-    if (label_str) {
-        strcpy(label_str, buffer);
-    }
-    return label_str;
+// Appends an instruction to the function being generated
+static void emit(TacGenContext *ctx, const TacInstruction *instr);
+
+// Fills the node fields of a frame from either form of node
+static void decode_expression(const TacGenContext *ctx, ExpressionRef node, ExpressionFrame *frame);
+
+// Helper to hand out the next label of the function (printed as L0, L1, ...)
+static TacOperand create_next_label(int *label_counter_ptr) {
+    return create_tac_operand_label((uint32_t) (*label_counter_ptr)++);
 }
 
 // Helper to create an invalid operand (useful for nodes that don't return a value)
@@ -36,9 +85,40 @@ static bool is_valid_operand(TacOperand op) {
     return op.type != -1;
 }
 
-// --- Main Translation Function ---
+// --- Main Translation Functions ---
 
-TacProgram *ast_to_tac(ProgramNode *ast_root, Arena *arena) {
+// Adds the TacFunction for a function definition and sets up the context that fills it.
+// The instruction array is sized once from the node count of the function's body.
+static bool begin_function(TacProgram *tac_program, const char *name, const size_t node_count, const FlatAst *flat,
+                           TacGenContext *ctx, Arena *arena) {
+    // Create the TacFunction corresponding to the FuncDefNode
+    TacFunction *tac_function = create_tac_function(name, arena);
+    if (!tac_function) {
+        fprintf(stderr, "Error: Failed to create TAC function for '%s'.\n", name);
+        return false;
+    }
+
+    // Add the function to the program
+    add_function_to_program(tac_program, tac_function, arena);
+    tac_function_reserve(tac_function, node_count, arena);
+
+    // Initialize the temporary ID counter and label counter for this function
+    ctx->flat = flat;
+    ctx->function = tac_function;
+    ctx->arena = arena;
+    ctx->next_temp_id = 0;
+    ctx->label_counter = 0;
+    arena_stack_init(&ctx->expression_frames, arena, sizeof(ExpressionFrame));
+    ctx->symbols = NULL;
+    ctx->failed = false;
+    ctx->branchless_logical = false;
+    ctx->returned = false;
+    return true;
+}
+
+// Lowers a pointer tree; with `symbols`, also resolves and checks its variables (fused pass)
+static TacProgram *lower_program(ProgramNode *ast_root, SymbolTable *symbols, const TacLoweringOptions *options,
+                                 Arena *arena) {
     if (!ast_root || ast_root->base.type != NODE_PROGRAM) {
         fprintf(stderr, "Error: Invalid AST root node for TAC generation.\n");
         return NULL;
@@ -59,37 +139,225 @@ TacProgram *ast_to_tac(ProgramNode *ast_root, Arena *arena) {
 
     const FuncDefNode *func_def = ast_root->function;
 
-    // Create the TacFunction corresponding to the FuncDefNode
-    TacFunction *tac_function = create_tac_function(func_def->name, arena);
-    if (!tac_function) {
-        fprintf(stderr, "Error: Failed to create TAC function for '%s'.\n", func_def->name);
+    // Size the instruction array once. Literals and names emit nothing and most operators
+    // one instruction, so the body's node count rarely falls short (&& and || emit six).
+    const size_t node_count = func_def->body_node_count ? func_def->body_node_count
+                                                        : ast_count_nodes((const AstNode *) func_def->body);
+    TacGenContext ctx;
+    if (!begin_function(tac_program, func_def->name, node_count, NULL, &ctx, arena)) {
         return NULL;
     }
+    ctx.symbols = symbols;
+    ctx.branchless_logical = options->branchless_logical;
 
-    // Add the function to the program
-    add_function_to_program(tac_program, tac_function, arena);
-
-    // Visit the function body (statements)
-    // Initialize the temporary ID counter and label counter for this function
-    int next_temp_id = 0;
-    int label_counter = 0;
     // For now, assume the body is a single statement (like the ReturnStmt)
     // A real implementation would handle blocks/sequences of statements.
     if (func_def->body) {
-        visit_statement(func_def->body, tac_function, arena, &next_temp_id, &label_counter);
+        visit_statement(func_def->body, &ctx);
     } else {
         // Handle functions with empty bodies if necessary
         fprintf(stderr, "Warning: Function '%s' has an empty body.\n", func_def->name);
     }
 
+    return ctx.failed ? NULL : tac_program;
+}
+
+// Lowers a flat tree; with `symbols`, also resolves and checks its variables (fused pass)
+static TacProgram *lower_flat_program(const FlatAst *ast, SymbolTable *symbols, const TacLoweringOptions *options,
+                                      Arena *arena) {
+    if (!ast || ast->root == AST_HANDLE_NONE || flat_ast_node(ast, ast->root)->type != NODE_PROGRAM) {
+        fprintf(stderr, "Error: Invalid AST root node for TAC generation.\n");
+        return NULL;
+    }
+
+    TacProgram *tac_program = create_tac_program(arena);
+    if (!tac_program) {
+        fprintf(stderr, "Error: Failed to create TAC program.\n");
+        return NULL;
+    }
+
+    const AstHandle function = flat_ast_node(ast, ast->root)->first;
+    if (function == AST_HANDLE_NONE || flat_ast_node(ast, function)->type != NODE_FUNC_DEF) {
+        fprintf(stderr, "Error: AST ProgramNode does not contain a valid FuncDefNode.\n");
+        return NULL;
+    }
+
+    const FlatAstNode *func_def = flat_ast_node(ast, function);
+    const char *name = flat_ast_name(ast, func_def->first);
+    // The whole tree is the function and its body here (post-order keeps the body first)
+    TacGenContext ctx;
+    if (!begin_function(tac_program, name, ast->node_count, ast, &ctx, arena)) {
+        return NULL;
+    }
+    ctx.symbols = symbols;
+    ctx.branchless_logical = options->branchless_logical;
+
+    if (func_def->second != AST_HANDLE_NONE) {
+        visit_flat_statement(func_def->second, &ctx);
+    } else {
+        fprintf(stderr, "Warning: Function '%s' has an empty body.\n", name);
+    }
+
+    return ctx.failed ? NULL : tac_program;
+}
+
+// The symbol table gives its memory back on every scope exit, which would take the TAC
+// allocated inside the block with it, so it gets an arena of its own
+#define FUSED_SYMBOL_ARENA_SIZE 4096
+
+TacProgram *ast_to_tac_with_options(ProgramNode *ast_root, const TacLoweringOptions *options, Arena *arena) {
+    if (!options->fuse_validation) {
+        return lower_program(ast_root, NULL, options, arena);
+    }
+    if (!ast_root || ast_root->base.type != NODE_PROGRAM) {
+        fprintf(stderr, "Error: Invalid AST root node for TAC generation.\n");
+        return NULL;
+    }
+    Arena symbol_arena = arena_create(FUSED_SYMBOL_ARENA_SIZE);
+    SymbolTable symbols;
+    symbol_table_init_interned(&symbols, &symbol_arena, ast_root->interner);
+    TacProgram *tac_program = lower_program(ast_root, &symbols, options, arena);
+    symbol_table_free(&symbols);
+    arena_destroy(&symbol_arena);
+    return tac_program;
+}
+
+TacProgram *flat_ast_to_tac_with_options(const FlatAst *ast, const TacLoweringOptions *options, Arena *arena) {
+    if (!options->fuse_validation) {
+        return lower_flat_program(ast, NULL, options, arena);
+    }
+    if (!ast) {
+        fprintf(stderr, "Error: Invalid AST root node for TAC generation.\n");
+        return NULL;
+    }
+    Arena symbol_arena = arena_create(FUSED_SYMBOL_ARENA_SIZE);
+    SymbolTable symbols;
+    symbol_table_init_interned(&symbols, &symbol_arena, ast->interner);
+    TacProgram *tac_program = lower_flat_program(ast, &symbols, options, arena);
+    symbol_table_free(&symbols);
+    arena_destroy(&symbol_arena);
     return tac_program;
 }
 
+TacProgram *ast_to_tac(ProgramNode *ast_root, Arena *arena) {
+    const TacLoweringOptions options = {0};
+    return ast_to_tac_with_options(ast_root, &options, arena);
+}
+
+TacProgram *flat_ast_to_tac(const FlatAst *ast, Arena *arena) {
+    const TacLoweringOptions options = {0};
+    return flat_ast_to_tac_with_options(ast, &options, arena);
+}
+
+TacProgram *ast_to_tac_fused(ProgramNode *ast_root, Arena *arena) {
+    const TacLoweringOptions options = {.fuse_validation = true};
+    return ast_to_tac_with_options(ast_root, &options, arena);
+}
+
+TacProgram *flat_ast_to_tac_fused(const FlatAst *ast, Arena *arena) {
+    const TacLoweringOptions options = {.fuse_validation = true};
+    return flat_ast_to_tac_with_options(ast, &options, arena);
+}
+
 // --- Static Helper Function Implementations ---
 
+// RETURN of the value of an expression
+static void lower_return(const ExpressionRef expression, TacGenContext *ctx) {
+    // Visit the expression to generate its TAC and get the result operand
+    const TacOperand result_operand = visit_expression(expression, ctx);
+    if (ctx->failed) {
+        return; // Already reported
+    }
+
+    // Check if the expression produced a valid result
+    if (!is_valid_operand(result_operand)) {
+        fprintf(stderr, "Error: Return statement's expression did not yield a valid result operand.\n");
+        // Potentially set an error flag in the context?
+        return;
+    }
+
+    // Create and add the RETURN instruction
+    const TacInstruction *ret_instr = create_tac_instruction_return(result_operand, ctx->arena);
+    if (ret_instr) {
+        emit(ctx, ret_instr);
+        ctx->returned = true;
+    } else {
+        fprintf(stderr, "Error: Failed to create TAC RETURN instruction.\n");
+    }
+}
+
+// --- Fused pass: variables ---
+// Each variable lives in a temp of its own, handed out at its declaration and recorded in
+// its symbol; uses and assignments of the name resolve to that temp.
+
+static void report_semantic_error(TacGenContext *ctx) {
+    ctx->failed = true;
+}
+
+// Enters the scope of a block. Returns false (reported) if that fails.
+static bool enter_block_scope(TacGenContext *ctx) {
+    if (ctx->symbols && !symbol_table_enter_scope(ctx->symbols)) {
+        fprintf(stderr, "Error: Failed to enter new scope.\n");
+        report_semantic_error(ctx);
+        return false;
+    }
+    return true;
+}
+
+static void exit_block_scope(const TacGenContext *ctx) {
+    if (ctx->symbols) {
+        symbol_table_exit_scope(ctx->symbols);
+    }
+}
+
+// The temp holding the variable `name`, or NULL (reported) if it is not declared
+static const Symbol *resolve_variable(TacGenContext *ctx, const char *name) {
+    const Symbol *symbol = symbol_table_lookup_symbol(ctx->symbols, name);
+    if (!symbol) {
+        fprintf(stderr, "Error: Undeclared variable '%s'.\n", name);
+        report_semantic_error(ctx);
+    }
+    return symbol;
+}
+
+// `int name = initializer;`: declares name with a new temp, then copies the initializer into it
+// (the variable is in scope in its own initializer, as the validator has it)
+static void lower_declaration(const char *name, const ExpressionRef initializer, const bool has_initializer,
+                              TacGenContext *ctx) {
+    Token decl_token; // Synthesized, as the validator does: the AST keeps no tokens
+    decl_token.type = TOKEN_IDENTIFIER;
+    decl_token.lexeme = name;
+    decl_token.length = (uint32_t) strlen(name);
+    decl_token.position = 0;
+    const int temp_id = ctx->next_temp_id;
+    if (!symbol_table_add_symbol_with_temp(ctx->symbols, name, decl_token, temp_id)) {
+        fprintf(stderr, "Error: Redeclaration of variable '%s'.\n", name);
+        report_semantic_error(ctx);
+        return;
+    }
+    ctx->next_temp_id++;
+    if (!has_initializer) {
+        return;
+    }
+
+    const TacOperand value = visit_expression(initializer, ctx);
+    if (ctx->failed || !is_valid_operand(value)) {
+        return;
+    }
+    emit(ctx, create_tac_instruction_copy(create_tac_operand_temp(temp_id), value, ctx->arena));
+}
+
+// An expression used as a statement, for its side effects (`a = 1;`)
+static void lower_expression_statement(const ExpressionRef expression, TacGenContext *ctx) {
+    visit_expression(expression, ctx);
+}
+
+static bool is_expression_type(const NodeType type) {
+    return type == NODE_INT_LITERAL || type == NODE_IDENTIFIER || type == NODE_UNARY_OP || type == NODE_BINARY_OP;
+}
+
 // Visitor for statement nodes
-static void visit_statement(AstNode *node, TacFunction *current_function, Arena *arena, int *next_temp_id_ptr,
-                            int *label_counter_ptr) {
+static void visit_statement(AstNode *node, TacGenContext *ctx) {
     // ReSharper disable once CppDFAConstantConditions
     // ReSharper disable once CppDFAUnreachableCode
     if (!node) return;
@@ -97,90 +365,213 @@ static void visit_statement(AstNode *node, TacFunction *current_function, Arena
     switch (node->type) {
         case NODE_RETURN_STMT: {
             const ReturnStmtNode *ret_node = (ReturnStmtNode *) node;
-            // Visit the expression to generate its TAC and get the result operand
-            const TacOperand result_operand = visit_expression(ret_node->expression, current_function, arena,
-                                                               next_temp_id_ptr, label_counter_ptr);
-
-            // Check if the expression produced a valid result
-            if (!is_valid_operand(result_operand)) {
-                fprintf(stderr, "Error: Return statement's expression did not yield a valid result operand.\n");
-                // Potentially set an error flag in the context?
-                return;
-            }
-
-            // Create and add the RETURN instruction
-            const TacInstruction *ret_instr = create_tac_instruction_return(result_operand, arena);
-            if (ret_instr) {
-                add_instruction_to_function(current_function, ret_instr, arena);
-            } else {
-                fprintf(stderr, "Error: Failed to create TAC RETURN instruction.\n");
-            }
+            lower_return((ExpressionRef){.node = ret_node->expression}, ctx);
             break;
         }
         case NODE_BLOCK: {
+            // Statements only nest as deep as the source's braces; expressions, which can nest
+            // arbitrarily deep, are walked without recursion by visit_expression
             const BlockNode *block_node = (BlockNode *)node;
-            for (size_t i = 0; i < block_node->num_items; ++i) {
-                visit_statement(block_node->items[i], current_function, arena, next_temp_id_ptr, label_counter_ptr);
+            if (!enter_block_scope(ctx)) {
+                break;
+            }
+            for (size_t i = 0; i < block_node->num_items && !ctx->failed; ++i) {
+                visit_statement(block_node->items[i], ctx);
                 // If an error occurs in a sub-statement, we might need a way to propagate it.
                 // For now, assuming sub-calls will print errors and we continue or bail if they return a specific error code/flag.
             }
+            exit_block_scope(ctx);
             break;
         }
+        case NODE_VAR_DECL:
+            if (ctx->symbols) {
+                const VarDeclNode *decl = (VarDeclNode *) node;
+                lower_declaration(decl->var_name, (ExpressionRef){.node = decl->initializer},
+                                  decl->initializer != NULL, ctx);
+                break;
+            }
+            fprintf(stderr, "Error: Unexpected AST node type %d in visit_statement.\n", node->type);
+            break;
         // Add cases for other statements here
         default:
+            if (ctx->symbols && is_expression_type(node->type)) {
+                lower_expression_statement((ExpressionRef){.node = node}, ctx);
+                break;
+            }
             fprintf(stderr, "Error: Unexpected AST node type %d in visit_statement.\n", node->type);
             break;
     }
 }
 
-// Helper function to handle unary operations
-static TacOperand visit_unary_op_expression(const UnaryOpNode *unary_node, TacFunction *current_function, Arena *arena,
-                                            int *next_temp_id_ptr, int *label_counter_ptr) {
-    // 1. Visit the operand expression first
-    const TacOperand operand_result = visit_expression(unary_node->operand, current_function, arena,
-                                                       next_temp_id_ptr, label_counter_ptr);
+// Visitor for statement nodes of a flat tree
+static void visit_flat_statement(const AstHandle handle, TacGenContext *ctx) { // NOLINT(*-no-recursion)
+    if (handle == AST_HANDLE_NONE) return;
+
+    const FlatAstNode *node = flat_ast_node(ctx->flat, handle);
+    switch ((NodeType) node->type) {
+        case NODE_RETURN_STMT:
+            lower_return((ExpressionRef){.handle = node->first}, ctx);
+            break;
+        case NODE_BLOCK:
+            if (!enter_block_scope(ctx)) {
+                break;
+            }
+            for (uint32_t i = 0; i < node->second && !ctx->failed; ++i) {
+                visit_flat_statement(flat_ast_block_item(ctx->flat, node, i), ctx);
+            }
+            exit_block_scope(ctx);
+            break;
+        case NODE_VAR_DECL:
+            if (ctx->symbols) {
+                lower_declaration(flat_ast_name(ctx->flat, node->first), (ExpressionRef){.handle = node->second},
+                                  node->second != AST_HANDLE_NONE, ctx);
+                break;
+            }
+            fprintf(stderr, "Error: Unexpected AST node type %d in visit_statement.\n", node->type);
+            break;
+        default:
+            if (ctx->symbols && is_expression_type((NodeType) node->type)) {
+                lower_expression_statement((ExpressionRef){.handle = handle}, ctx);
+                break;
+            }
+            fprintf(stderr, "Error: Unexpected AST node type %d in visit_statement.\n", node->type);
+            break;
+    }
+}
+
+static void emit(TacGenContext *ctx, const TacInstruction *instr) {
+    // Statements after a return are still visited, so the fused pass reports their errors, but
+    // their code could never run
+    if (!ctx->returned) {
+        add_instruction_to_function(ctx->function, instr, ctx->arena);
+    }
+}
+
+// Each step_* function below advances the frame of one node kind. It either stores the next
+// child to visit in *child and returns true, or finishes the node: stores its value (an invalid
+// operand on error) in *result and returns false. On entry *result holds the value of the
+// child visited last.
+
+// Unary operations: the operand, then `t_dest = op operand`
+static bool step_unary_op(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
+    const UnaryOperatorType op = (UnaryOperatorType) frame->op;
+    if (frame->state == EXPRESSION_STATE_START) {
+        // 1. Visit the operand expression first
+        frame->state = EXPRESSION_STATE_AFTER_FIRST;
+        *child = frame->first;
+        return true;
+    }
+
+    const TacOperand operand_result = *result;
+    *result = create_invalid_operand();
     if (!is_valid_operand(operand_result)) {
         fprintf(stderr, "Error: Unary operator's operand did not yield a valid result.\n");
-        return create_invalid_operand();
+        return false;
     }
 
     // 2. Create a new temporary to store the result of the unary operation
-    //    Use the counter passed via pointer.
-    const TacOperand dest_temp = create_tac_operand_temp((*next_temp_id_ptr)++);
+    const TacOperand dest_temp = create_tac_operand_temp(ctx->next_temp_id++);
 
     // 3. Create the specific TAC instruction based on the operator
     const TacInstruction *unary_instr = NULL;
-    switch (unary_node->op) {
+    switch (op) {
         case OPERATOR_NEGATE:
-            unary_instr = create_tac_instruction_negate(dest_temp, operand_result, arena);
+            unary_instr = create_tac_instruction_negate(dest_temp, operand_result, ctx->arena);
             break;
         case OPERATOR_COMPLEMENT:
-            unary_instr = create_tac_instruction_complement(dest_temp, operand_result, arena);
+            unary_instr = create_tac_instruction_complement(dest_temp, operand_result, ctx->arena);
             break;
         case OPERATOR_LOGICAL_NOT:
-            unary_instr = create_tac_instruction_logical_not(dest_temp, operand_result, arena);
+            unary_instr = create_tac_instruction_logical_not(dest_temp, operand_result, ctx->arena);
             break;
         default:
-            fprintf(stderr, "Error: Unsupported unary operator type %d.\n", unary_node->op);
-            return create_invalid_operand();
+            fprintf(stderr, "Error: Unsupported unary operator type %d.\n", op);
+            return false;
     }
 
     // 4. Add the instruction to the function
-    if (unary_instr) {
-        add_instruction_to_function(current_function, unary_instr, arena);
-    } else {
-        fprintf(stderr, "Error: Failed to create TAC instruction for unary operator %d.\n", unary_node->op);
-        return create_invalid_operand(); // Failed to create instruction
+    if (!unary_instr) {
+        fprintf(stderr, "Error: Failed to create TAC instruction for unary operator %d.\n", op);
+        return false; // Failed to create instruction
     }
+    emit(ctx, unary_instr);
 
     // 5. The result of this expression is the destination temporary
-    return dest_temp;
+    *result = dest_temp;
+    return false;
+}
+
+// Largest right operand of && / || that is evaluated unconditionally instead of branched around
+#define BRANCHLESS_MAX_OPERAND_NODES 8
+
+// Whether an operand can be evaluated even when short-circuiting would skip it: it cannot trap
+// (no division) or change anything (no assignment), and is small enough that computing it costs
+// less than a mispredicted branch. Walks at most *budget nodes, so the recursion is bounded.
+static bool is_speculatable_operand(const TacGenContext *ctx, const ExpressionRef node, int *budget) { // NOLINT(*-no-recursion)
+    if (--*budget < 0) {
+        return false;
+    }
+    ExpressionFrame frame;
+    decode_expression(ctx, node, &frame);
+    if (!frame.present) {
+        return false;
+    }
+    switch (frame.type) {
+        case NODE_INT_LITERAL:
+        case NODE_IDENTIFIER:
+            return true;
+        case NODE_UNARY_OP:
+            return is_speculatable_operand(ctx, frame.first, budget);
+        case NODE_BINARY_OP:
+            if (frame.op == OPERATOR_DIVIDE || frame.op == OPERATOR_MODULO || frame.op == OPERATOR_ASSIGN ||
+                frame.op == OPERATOR_COMMA) {
+                return false;
+            }
+            return is_speculatable_operand(ctx, frame.first, budget) &&
+                   is_speculatable_operand(ctx, frame.second, budget);
+        default:
+            return false;
+    }
+}
+
+// Whether the && / || of a frame is lowered to a single LOGICAL_AND / LOGICAL_OR
+static bool lower_branchless(const TacGenContext *ctx, const ExpressionFrame *frame) {
+    int budget = BRANCHLESS_MAX_OPERAND_NODES;
+    return ctx->branchless_logical && is_speculatable_operand(ctx, frame->second, &budget);
+}
+
+// Both operands of a branchless && / || are visited like those of any binary operator, then
+// `t_dest = lhs && rhs` (or ||) normalizes and combines them without a jump
+static bool step_branchless_logical(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child,
+                                    TacGenContext *ctx) {
+    if (frame->state == EXPRESSION_STATE_AFTER_FIRST) {
+        if (!is_valid_operand(*result)) {
+            fprintf(stderr, "Error: Logical operator's left operand did not yield a valid result.\n");
+            return false;
+        }
+        frame->lhs = *result;
+        frame->state = EXPRESSION_STATE_AFTER_SECOND;
+        *child = frame->second;
+        return true;
+    }
+    const TacOperand rhs_result = *result;
+    *result = create_invalid_operand();
+    if (!is_valid_operand(rhs_result)) {
+        fprintf(stderr, "Error: Logical operator's right operand did not yield a valid result.\n");
+        return false;
+    }
+    const TacOperand dest_temp = create_tac_operand_temp(ctx->next_temp_id++);
+    emit(ctx, frame->op == OPERATOR_LOGICAL_AND
+                  ? create_tac_instruction_logical_and(dest_temp, frame->lhs, rhs_result, ctx->arena)
+                  : create_tac_instruction_logical_or(dest_temp, frame->lhs, rhs_result, ctx->arena));
+    *result = dest_temp;
+    return false;
 }
 
-// Helper function to handle LOGICAL_AND operations (short-circuiting)
+// LOGICAL_AND operations (short-circuiting)
 // Generates TAC for an expression like `t_dest = t_lhs && t_rhs`.
 // The exact temporary variable names (e.g., t0, t1) and label names (e.g., L0, L1)
-// will be determined by the current state of `next_temp_id_ptr` and `label_counter_ptr`.
+// will be determined by the current state of the context's counters.
 //
 // Example TAC sequence:
 //   ; ... Instructions to evaluate LHS into t_lhs ...
@@ -192,76 +583,77 @@ static TacOperand visit_unary_op_expression(const UnaryOpNode *unary_node, TacFu
 //   t_dest = const 0
 // L1:
 //   ; t_dest now holds the boolean result (0 or 1) of the AND operation
-static TacOperand visit_logical_and_expression(const BinaryOpNode *binary_node, TacFunction *current_function,
-                                               Arena *arena, int *next_temp_id_ptr, int *label_counter_ptr) {
-    // LHS && RHS
-    // 1. Evaluate LHS
-    const TacOperand lhs_result = visit_expression(binary_node->left, current_function, arena, next_temp_id_ptr,
-                                                   label_counter_ptr);
-    if (!is_valid_operand(lhs_result)) {
-        fprintf(stderr, "Error: LOGICAL_AND's left operand did not yield a valid result.\n");
-        return create_invalid_operand();
-    }
+static bool step_logical_and(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
+    Arena *arena = ctx->arena;
+    switch (frame->state) {
+        case EXPRESSION_STATE_START:
+            // 1. Evaluate LHS
+            frame->state = EXPRESSION_STATE_AFTER_FIRST;
+            *child = frame->first;
+            return true;
+        case EXPRESSION_STATE_AFTER_FIRST: {
+            const TacOperand lhs_result = *result;
+            if (!is_valid_operand(lhs_result)) {
+                fprintf(stderr, "Error: LOGICAL_AND's left operand did not yield a valid result.\n");
+                return false; // *result is already invalid
+            }
 
-    // 2. Create a temporary for the final result of the AND expression
-    const TacOperand dest_temp = create_tac_operand_temp((*next_temp_id_ptr)++);
+            // 2. Create a temporary for the final result of the AND expression
+            frame->dest = create_tac_operand_temp(ctx->next_temp_id++);
 
-    // 3. Create labels for short-circuiting
-    const char *false_exit_label_name = generate_label_name(arena, label_counter_ptr);
-    const TacOperand false_exit_label = create_tac_operand_label(false_exit_label_name);
-    const char *end_label_name = generate_label_name(arena, label_counter_ptr);
-    const TacOperand end_label = create_tac_operand_label(end_label_name);
+            // 3. Create labels for short-circuiting (false exit, end)
+            frame->labels[0] = create_next_label(&ctx->label_counter);
+            frame->labels[1] = create_next_label(&ctx->label_counter);
 
-    // 4. if_false lhs_result goto L_false_exit
-    const TacInstruction *if_false_instr = create_tac_instruction_if_false_goto(lhs_result, false_exit_label, arena);
-    add_instruction_to_function(current_function, if_false_instr, arena);
+            // 4. if_false lhs_result goto L_false_exit
+            emit(ctx, create_tac_instruction_if_false_goto(lhs_result, frame->labels[0], arena));
 
-    // 5. Evaluate RHS (only if LHS was true)
-    const TacOperand rhs_result = visit_expression(binary_node->right, current_function, arena, next_temp_id_ptr,
-                                                   label_counter_ptr);
+            // 5. Evaluate RHS (only if LHS was true)
+            frame->state = EXPRESSION_STATE_AFTER_SECOND;
+            *child = frame->second;
+            return true;
+        }
+        default:
+            break;
+    }
+
+    const TacOperand dest_temp = frame->dest;
+    const TacOperand false_exit_label = frame->labels[0];
+    const TacOperand end_label = frame->labels[1];
+    const TacOperand rhs_result = *result;
     if (!is_valid_operand(rhs_result)) {
         fprintf(stderr, "Error: LOGICAL_AND's right operand did not yield a valid result.\n");
         // Still need to emit the labels for correct control flow even on error
-        const TacInstruction *define_false_label_instr = create_tac_instruction_label(false_exit_label, arena);
-        add_instruction_to_function(current_function, define_false_label_instr, arena);
-        const TacInstruction *assign_false_instr = create_tac_instruction_copy(
-            dest_temp, create_tac_operand_const(0), arena);
-        add_instruction_to_function(current_function, assign_false_instr, arena);
-        const TacInstruction *define_end_label_instr = create_tac_instruction_label(end_label, arena);
-        add_instruction_to_function(current_function, define_end_label_instr, arena);
-        return create_invalid_operand();
+        emit(ctx, create_tac_instruction_label(false_exit_label, arena));
+        emit(ctx, create_tac_instruction_copy(dest_temp, create_tac_operand_const(0), arena));
+        emit(ctx, create_tac_instruction_label(end_label, arena));
+        return false;
     }
     // 6. dest_temp = rhs_result (if RHS is evaluated, its result is the result of the AND)
     //    However, logical AND should result in 0 or 1. So if rhs_result is non-zero, dest_temp is 1, else 0.
-    const TacInstruction *assign_rhs_bool_instr = create_tac_instruction_not_equal(
-        dest_temp, rhs_result, create_tac_operand_const(0), arena);
-    add_instruction_to_function(current_function, assign_rhs_bool_instr, arena);
+    emit(ctx, create_tac_instruction_not_equal(dest_temp, rhs_result, create_tac_operand_const(0), arena));
 
     // 7. goto L_end
-    const TacInstruction *goto_end_instr = create_tac_instruction_goto(end_label, arena);
-    add_instruction_to_function(current_function, goto_end_instr, arena);
+    emit(ctx, create_tac_instruction_goto(end_label, arena));
 
     // 8. L_false_exit:
-    const TacInstruction *false_label_def_instr = create_tac_instruction_label(false_exit_label, arena);
-    add_instruction_to_function(current_function, false_label_def_instr, arena);
+    emit(ctx, create_tac_instruction_label(false_exit_label, arena));
 
     // 9. dest_temp = 0 (false)
-    const TacInstruction *assign_false_val_instr = create_tac_instruction_copy(
-        dest_temp, create_tac_operand_const(0), arena);
-    add_instruction_to_function(current_function, assign_false_val_instr, arena);
+    emit(ctx, create_tac_instruction_copy(dest_temp, create_tac_operand_const(0), arena));
 
     // 10. L_end:
-    const TacInstruction *end_label_def_instr = create_tac_instruction_label(end_label, arena);
-    add_instruction_to_function(current_function, end_label_def_instr, arena);
+    emit(ctx, create_tac_instruction_label(end_label, arena));
 
     // 11. The result of this expression is dest_temp
-    return dest_temp;
+    *result = dest_temp;
+    return false;
 }
 
-// Helper function to handle LOGICAL_OR operations (short-circuiting)
+// LOGICAL_OR operations (short-circuiting)
 // Generates TAC for an expression like `t_dest = t_lhs || t_rhs`.
 // The exact temporary variable names (e.g., t0, t1) and label names (e.g., L0, L1, L2)
-// will be determined by the current state of `next_temp_id_ptr` and `label_counter_ptr`.
+// will be determined by the current state of the context's counters.
 // Assumes `true_exit_label` is L_i+1 and `end_label` is L_i+2 (if an implicit `eval_rhs_label` was L_i).
 //
 // Example TAC sequence:
@@ -274,112 +666,135 @@ static TacOperand visit_logical_and_expression(const BinaryOpNode *binary_node,
 //   t_dest = const 1             ; result is 1
 // L_i+2:                          ; end_label: common exit point
 //   ; t_dest now holds the boolean result (0 or 1) of the OR operation
-static TacOperand visit_logical_or_expression(const BinaryOpNode *binary_node, TacFunction *current_function,
-                                              Arena *arena, int *next_temp_id_ptr, int *label_counter_ptr) {
-    // LHS || RHS
-    // 1. Allocate a temporary for the result of the OR expression.
-    const TacOperand dest_temp = create_tac_operand_temp((*next_temp_id_ptr)++);
-
-    // 2. Create labels
-    const char *eval_rhs_label_name = generate_label_name(arena, label_counter_ptr);
-    const TacOperand eval_rhs_label = create_tac_operand_label(eval_rhs_label_name);
-    const char *true_exit_label_name = generate_label_name(arena, label_counter_ptr);
-    const TacOperand true_exit_label = create_tac_operand_label(true_exit_label_name);
-    const char *end_label_name = generate_label_name(arena, label_counter_ptr);
-    const TacOperand end_label = create_tac_operand_label(end_label_name);
-
-    // 3. if_true lhs_result goto L_true_exit (If LHS is true, jump to assign true and exit)
-    const TacOperand lhs_result = visit_expression(binary_node->left, current_function, arena, next_temp_id_ptr,
-                                                   label_counter_ptr);
-    if (!is_valid_operand(lhs_result)) {
-        fprintf(stderr, "Error: LOGICAL_OR's left operand did not yield a valid result.\n");
-        return create_invalid_operand();
+//
+// The eval_rhs label is only defined on the error path; on the regular path the RHS is simply
+// the fall-through of the IF_TRUE, which is equivalent for short-circuiting.
+static bool step_logical_or(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
+    Arena *arena = ctx->arena;
+    switch (frame->state) {
+        case EXPRESSION_STATE_START:
+            // 1. Allocate a temporary for the result of the OR expression.
+            frame->dest = create_tac_operand_temp(ctx->next_temp_id++);
+
+            // 2. Create labels (eval rhs, true exit, end)
+            frame->labels[0] = create_next_label(&ctx->label_counter);
+            frame->labels[1] = create_next_label(&ctx->label_counter);
+            frame->labels[2] = create_next_label(&ctx->label_counter);
+
+            frame->state = EXPRESSION_STATE_AFTER_FIRST;
+            *child = frame->first;
+            return true;
+        case EXPRESSION_STATE_AFTER_FIRST: {
+            // 3. if_true lhs_result goto L_true_exit (If LHS is true, jump to assign true and exit)
+            const TacOperand lhs_result = *result;
+            if (!is_valid_operand(lhs_result)) {
+                fprintf(stderr, "Error: LOGICAL_OR's left operand did not yield a valid result.\n");
+                return false; // *result is already invalid
+            }
+            emit(ctx, create_tac_instruction_if_true_goto(lhs_result, frame->labels[1], arena));
+
+            // 4. LHS was false. Evaluate RHS. (This is the path if not short-circuited by LHS being true)
+            frame->state = EXPRESSION_STATE_AFTER_SECOND;
+            *child = frame->second;
+            return true;
+        }
+        default:
+            break;
     }
-    const TacInstruction *if_true_instr = create_tac_instruction_if_true_goto(lhs_result, true_exit_label, arena);
-    add_instruction_to_function(current_function, if_true_instr, arena);
 
-    // 4. LHS was false. Evaluate RHS. (This is the path if not short-circuited by LHS being true)
-    const TacOperand rhs_result = visit_expression(binary_node->right, current_function, arena, next_temp_id_ptr,
-                                                   label_counter_ptr);
+    const TacOperand dest_temp = frame->dest;
+    const TacOperand eval_rhs_label = frame->labels[0];
+    const TacOperand true_exit_label = frame->labels[1];
+    const TacOperand end_label = frame->labels[2];
+    const TacOperand rhs_result = *result;
     if (!is_valid_operand(rhs_result)) {
         fprintf(stderr, "Error: LOGICAL_OR's right operand did not yield a valid result.\n");
         // Still need to emit labels for correct control flow even on error
-        const TacInstruction *define_true_label_instr = create_tac_instruction_label(true_exit_label, arena);
-        add_instruction_to_function(current_function, define_true_label_instr, arena);
-        const TacInstruction *assign_true_instr_on_err = create_tac_instruction_copy(
-            dest_temp, create_tac_operand_const(1), arena);
-        add_instruction_to_function(current_function, assign_true_instr_on_err, arena);
+        emit(ctx, create_tac_instruction_label(true_exit_label, arena));
+        emit(ctx, create_tac_instruction_copy(dest_temp, create_tac_operand_const(1), arena));
         // We also need the eval_rhs label and end_label for consistent paths.
-        const TacInstruction *define_eval_rhs_label_instr = create_tac_instruction_label(eval_rhs_label, arena);
-        add_instruction_to_function(current_function, define_eval_rhs_label_instr, arena);
-        const TacInstruction *define_end_label_instr = create_tac_instruction_label(end_label, arena);
-        add_instruction_to_function(current_function, define_end_label_instr, arena);
-        return create_invalid_operand();
+        emit(ctx, create_tac_instruction_label(eval_rhs_label, arena));
+        emit(ctx, create_tac_instruction_label(end_label, arena));
+        return false;
     }
     // 5. dest_temp = (rhs_result != 0) (Result is true if RHS is non-zero, false otherwise)
-    const TacInstruction *assign_rhs_bool_instr = create_tac_instruction_not_equal(
-        dest_temp, rhs_result, create_tac_operand_const(0), arena);
-    add_instruction_to_function(current_function, assign_rhs_bool_instr, arena);
+    emit(ctx, create_tac_instruction_not_equal(dest_temp, rhs_result, create_tac_operand_const(0), arena));
     //    goto L_end
-    TacInstruction *goto_end_instr_from_rhs = create_tac_instruction_goto(end_label, arena);
-    add_instruction_to_function(current_function, goto_end_instr_from_rhs, arena);
+    emit(ctx, create_tac_instruction_goto(end_label, arena));
 
-    // 6. L_true_exit: (LHS was true, or preparing path for it)
-    const TacInstruction *true_label_def_instr = create_tac_instruction_label(true_exit_label, arena);
-    add_instruction_to_function(current_function, true_label_def_instr, arena);
+    // 6. L_true_exit: (LHS was true)
+    emit(ctx, create_tac_instruction_label(true_exit_label, arena));
 
     // 7. dest_temp = 1 (true)
-    const TacInstruction *assign_true_val_instr = create_tac_instruction_copy(
-        dest_temp, create_tac_operand_const(1), arena);
-    add_instruction_to_function(current_function, assign_true_val_instr, arena);
-    // No need for goto L_end here, as L_end will follow or this path is taken via goto.
+    emit(ctx, create_tac_instruction_copy(dest_temp, create_tac_operand_const(1), arena));
+    // No need for goto L_end here, as L_end follows.
 
     // 8. L_end: (Path from RHS evaluation also jumps here)
-    const TacInstruction *end_label_def_instr = create_tac_instruction_label(end_label, arena);
-    add_instruction_to_function(current_function, end_label_def_instr, arena);
-
-    // Note: The eval_rhs_label is implicitly handled by the control flow where RHS is evaluated if LHS is false.
-    // The explicit definition and jump to eval_rhs_label_name from original code might be slightly different. Reviewing that. 
-    // The original OR was: if_false LSH goto eval_RHS; LHS_true_path: assign 1, goto end; eval_RHS_label: evaluate RHS, assign bool(RHS), end_label.
-    // Current is: if_true LHS goto true_exit; evaluate RHS, assign bool(RHS), goto end; true_exit_label: assign 1; end_label.
-    // These are logically equivalent for correct short-circuiting. The key is that RHS is skipped if LHS meets OR's condition.
+    emit(ctx, create_tac_instruction_label(end_label, arena));
 
     // 9. The result of this expression is dest_temp
-    return dest_temp;
+    *result = dest_temp;
+    return false;
 }
 
-// Helper function to handle binary operations
-static TacOperand visit_binary_op_expression(const BinaryOpNode *binary_node, TacFunction *current_function,
-                                             Arena *arena, int *next_temp_id_ptr, int *label_counter_ptr) {
+// Binary operations: && and || short-circuit, everything else visits both operands and
+// emits `t_dest = lhs op rhs`
+static bool step_binary_op(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
     // Handle LOGICAL_AND and LOGICAL_OR separately due to short-circuiting
-    if (binary_node->op == OPERATOR_LOGICAL_AND) {
-        return visit_logical_and_expression(binary_node, current_function, arena, next_temp_id_ptr, label_counter_ptr);
+    if (frame->op == OPERATOR_LOGICAL_AND || frame->op == OPERATOR_LOGICAL_OR) {
+        if (frame->state == EXPRESSION_STATE_START) {
+            frame->branchless = lower_branchless(ctx, frame);
+        }
+        if (frame->branchless) {
+            if (frame->state == EXPRESSION_STATE_START) {
+                frame->state = EXPRESSION_STATE_AFTER_FIRST;
+                *child = frame->first;
+                return true;
+            }
+            return step_branchless_logical(frame, result, child, ctx);
+        }
+    }
+    if (frame->op == OPERATOR_LOGICAL_AND) {
+        return step_logical_and(frame, result, child, ctx);
     }
-    if (binary_node->op == OPERATOR_LOGICAL_OR) {
-        return visit_logical_or_expression(binary_node, current_function, arena, next_temp_id_ptr, label_counter_ptr);
+    if (frame->op == OPERATOR_LOGICAL_OR) {
+        return step_logical_or(frame, result, child, ctx);
     }
     // Standard binary operations (non-short-circuiting)
     // 1. Visit left and right operands
-    const TacOperand left_operand = visit_expression(binary_node->left, current_function, arena, next_temp_id_ptr,
-                                                     label_counter_ptr);
-    if (!is_valid_operand(left_operand)) {
-        fprintf(stderr, "Error: Binary operator's left operand did not yield a valid result.\n");
-        return create_invalid_operand();
+    switch (frame->state) {
+        case EXPRESSION_STATE_START:
+            frame->state = EXPRESSION_STATE_AFTER_FIRST;
+            *child = frame->first;
+            return true;
+        case EXPRESSION_STATE_AFTER_FIRST:
+            if (!is_valid_operand(*result)) {
+                fprintf(stderr, "Error: Binary operator's left operand did not yield a valid result.\n");
+                return false; // *result is already invalid
+            }
+            frame->lhs = *result;
+            frame->state = EXPRESSION_STATE_AFTER_SECOND;
+            *child = frame->second;
+            return true;
+        default:
+            break;
     }
 
-    const TacOperand right_operand = visit_expression(binary_node->right, current_function, arena, next_temp_id_ptr,
-                                                      label_counter_ptr);
+    const TacOperand left_operand = frame->lhs;
+    const TacOperand right_operand = *result;
+    *result = create_invalid_operand();
     if (!is_valid_operand(right_operand)) {
         fprintf(stderr, "Error: Binary operator's right operand did not yield a valid result.\n");
-        return create_invalid_operand();
+        return false;
     }
 
     // 2. Create a new temporary to store the result
-    const TacOperand dest_temp = create_tac_operand_temp((*next_temp_id_ptr)++);
+    const TacOperand dest_temp = create_tac_operand_temp(ctx->next_temp_id++);
 
     // 3. Create the specific TAC instruction based on the operator
+    Arena *arena = ctx->arena;
     const TacInstruction *binary_instr = NULL;
-    switch (binary_node->op) {
+    switch ((BinaryOperatorType) frame->op) {
         case OPERATOR_ADD:
             binary_instr = create_tac_instruction_add(dest_temp, left_operand, right_operand, arena);
             break;
@@ -413,50 +828,190 @@ static TacOperand visit_binary_op_expression(const BinaryOpNode *binary_node, Ta
         case OPERATOR_NOT_EQUAL:
             binary_instr = create_tac_instruction_not_equal(dest_temp, left_operand, right_operand, arena);
             break;
-        // Logical Operators (to be implemented with short-circuiting)
-        // case OPERATOR_LOGICAL_AND: // Handled above
-        // case OPERATOR_LOGICAL_OR: // Handled above
         default:
-            fprintf(stderr, "Error: Unsupported binary operator type %d (or not yet handled).\n", binary_node->op);
-            return create_invalid_operand();
+            fprintf(stderr, "Error: Unsupported binary operator type %d (or not yet handled).\n", frame->op);
+            return false;
     }
 
     // 4. Add the instruction to the function
-    if (binary_instr) {
-        add_instruction_to_function(current_function, binary_instr, arena);
-    } else {
+    if (!binary_instr) {
         // This case might not be reached if create_tac_instruction_* functions exit on failure
-        fprintf(stderr, "Error: Failed to create TAC instruction for binary operator %d.\n", binary_node->op);
-        return create_invalid_operand();
+        fprintf(stderr, "Error: Failed to create TAC instruction for binary operator %d.\n", frame->op);
+        return false;
     }
+    emit(ctx, binary_instr);
 
     // 5. The result of this expression is the destination temporary
-    return dest_temp;
+    *result = dest_temp;
+    return false;
 }
 
-// Visitor for expression nodes (returns the operand holding the result)
-static TacOperand visit_expression(AstNode *node, TacFunction *current_function, Arena *arena, int *next_temp_id_ptr,
-                                   int *label_counter_ptr) {
-    if (!node) return create_invalid_operand();
+// Name of the variable an assignment stores to, NULL if its left-hand side is not one
+static const char *assignment_target(const TacGenContext *ctx, const ExpressionRef target) {
+    if (ctx->flat) {
+        if (target.handle == AST_HANDLE_NONE) {
+            return NULL;
+        }
+        const FlatAstNode *node = flat_ast_node(ctx->flat, target.handle);
+        return node->type == NODE_IDENTIFIER ? flat_ast_name(ctx->flat, node->first) : NULL;
+    }
+    return target.node && target.node->type == NODE_IDENTIFIER ? ((const IdentifierNode *) target.node)->name
+                                                               : NULL;
+}
 
-    switch (node->type) {
-        case NODE_INT_LITERAL: {
-            const IntLiteralNode *int_node = (IntLiteralNode *) node;
-            // Integer literals directly translate to constant operands
-            return create_tac_operand_const(int_node->value);
+// Assignments (fused pass): the right operand, then `t_var = rhs`. The variable's temp is also
+// the value of the whole expression.
+static bool step_assignment(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
+    if (frame->state == EXPRESSION_STATE_START) {
+        *result = create_invalid_operand();
+        const char *name = assignment_target(ctx, frame->first);
+        if (!name) {
+            fprintf(stderr, "Error: Left-hand side of assignment must be an l-value (e.g., a variable name).\n");
+            report_semantic_error(ctx);
+            return false;
+        }
+        const Symbol *symbol = resolve_variable(ctx, name);
+        if (!symbol) {
+            return false;
         }
+        frame->dest = create_tac_operand_temp(symbol->temp_id);
+        frame->state = EXPRESSION_STATE_AFTER_SECOND;
+        *child = frame->second;
+        return true;
+    }
+
+    if (!is_valid_operand(*result)) {
+        return false; // Reported by the right operand
+    }
+    emit(ctx, create_tac_instruction_copy(frame->dest, *result, ctx->arena));
+    *result = frame->dest;
+    return false;
+}
+
+// Advances the frame on top of the stack, following the step_* contract
+static bool step_expression(ExpressionFrame *frame, TacOperand *result, ExpressionRef *child, TacGenContext *ctx) {
+    if (!frame->present) {
+        *result = create_invalid_operand();
+        return false;
+    }
+
+    switch (frame->type) {
+        case NODE_INT_LITERAL:
+            // Integer literals directly translate to constant operands
+            *result = create_tac_operand_const(frame->value);
+            return false;
+        case NODE_IDENTIFIER:
+            if (ctx->symbols) {
+                const Symbol *symbol = resolve_variable(ctx, frame->name);
+                *result = symbol ? create_tac_operand_temp(symbol->temp_id) : create_invalid_operand();
+                return false;
+            }
+            break; // Only the fused pass knows where variables live
+        case NODE_UNARY_OP:
+            return step_unary_op(frame, result, child, ctx);
+        case NODE_BINARY_OP:
+            if (ctx->symbols && frame->op == OPERATOR_ASSIGN) {
+                return step_assignment(frame, result, child, ctx);
+            }
+            return step_binary_op(frame, result, child, ctx);
+        // Add cases for other expressions (FunctionCall, etc.)
+        default:
+            break;
+    }
+    fprintf(stderr, "Error: Unexpected AST node type %d in visit_expression.\n", frame->type);
+    *result = create_invalid_operand();
+    return false;
+}
+
+// Fills the node fields of a frame from a pointer-tree node
+static void decode_node(const AstNode *node, ExpressionFrame *frame) {
+    frame->present = node != NULL;
+    if (!node) {
+        return;
+    }
+    frame->type = node->type;
+    switch (node->type) {
+        case NODE_INT_LITERAL:
+            frame->value = ((const IntLiteralNode *) node)->value;
+            break;
+        case NODE_IDENTIFIER:
+            frame->name = ((const IdentifierNode *) node)->name;
+            break;
         case NODE_UNARY_OP: {
-            const UnaryOpNode *unary_node = (UnaryOpNode *) node;
-            return visit_unary_op_expression(unary_node, current_function, arena, next_temp_id_ptr, label_counter_ptr);
+            const UnaryOpNode *unary_node = (const UnaryOpNode *) node;
+            frame->op = unary_node->op;
+            frame->first.node = unary_node->operand;
+            break;
         }
         case NODE_BINARY_OP: {
-            const BinaryOpNode *binary_node = (BinaryOpNode *) node;
-            return visit_binary_op_expression(binary_node, current_function, arena, next_temp_id_ptr,
-                                              label_counter_ptr);
+            const BinaryOpNode *binary_node = (const BinaryOpNode *) node;
+            frame->op = binary_node->op;
+            frame->first.node = binary_node->left;
+            frame->second.node = binary_node->right;
+            break;
         }
-        // Add cases for other expressions (FunctionCall, etc.)
         default:
-            fprintf(stderr, "Error: Unexpected AST node type %d in visit_expression.\n", node->type);
+            break;
+    }
+}
+
+// Fills the node fields of a frame from a flat-tree node
+static void decode_flat_node(const FlatAst *ast, const AstHandle handle, ExpressionFrame *frame) {
+    frame->present = handle != AST_HANDLE_NONE;
+    if (handle == AST_HANDLE_NONE) {
+        return;
+    }
+    const FlatAstNode *node = flat_ast_node(ast, handle);
+    frame->type = (NodeType) node->type;
+    frame->op = node->op;
+    frame->value = flat_ast_int_value(node);
+    frame->name = node->type == NODE_IDENTIFIER ? flat_ast_name(ast, node->first) : NULL;
+    frame->first.handle = node->first;
+    frame->second.handle = node->second;
+}
+
+static void decode_expression(const TacGenContext *ctx, const ExpressionRef node, ExpressionFrame *frame) {
+    if (ctx->flat) {
+        decode_flat_node(ctx->flat, node.handle, frame);
+    } else {
+        decode_node(node.node, frame);
+    }
+}
+
+static bool push_expression_frame(TacGenContext *ctx, const ExpressionRef node) {
+    ExpressionFrame *frame = arena_stack_push(&ctx->expression_frames);
+    if (!frame) {
+        fprintf(stderr, "Error: Failed to allocate a frame for a nested expression.\n");
+        return false;
+    }
+    decode_expression(ctx, node, frame);
+    frame->state = EXPRESSION_STATE_START;
+    return true;
+}
+
+// Visitor for expression nodes (returns the operand holding the result). Nodes are walked
+// depth-first on the context's explicit stack, so the depth of nesting is not limited by the
+// C stack; instructions, temps and labels come out in the same order as a recursive walk.
+static TacOperand visit_expression(const ExpressionRef node, TacGenContext *ctx) {
+    ArenaStack *frames = &ctx->expression_frames;
+    const size_t base_depth = frames->depth;
+    if (!push_expression_frame(ctx, node)) {
+        return create_invalid_operand();
+    }
+
+    TacOperand result = create_invalid_operand();
+    while (frames->depth > base_depth) {
+        ExpressionRef child;
+        if (!step_expression(arena_stack_top(frames), &result, &child, ctx)) {
+            if (ctx->failed) {
+                arena_stack_truncate(frames, base_depth); // Semantic error: abandon the expression
+                return create_invalid_operand();
+            }
+            arena_stack_pop(frames); // Node finished; result goes to the frame below
+        } else if (!push_expression_frame(ctx, child)) {
+            arena_stack_truncate(frames, base_depth);
             return create_invalid_operand();
+        }
     }
+    return result;
 }
@@ -2,9 +2,17 @@
 #define CLERIC_AST_TO_TAC_H
 
 #include "../parser/ast.h" // For AST node types (ProgramNode)
+#include "../parser/flat_ast.h" // For the flat form of the AST
 #include "tac.h"           // For TAC types (TacProgram)
 #include "../memory/arena.h" // For Arena allocator
 
+// Choices in how the AST is lowered; zero-initialized gives plain ast_to_tac
+typedef struct {
+    bool fuse_validation;    // Validate while lowering and map variables to temps (see ast_to_tac_fused)
+    bool branchless_logical; // Lower && and || whose right operand is small, cannot trap and has no side
+                             // effects to one LOGICAL_AND / LOGICAL_OR instead of jumps around it (-O1)
+} TacLoweringOptions;
+
 /**
  * @brief Translates the abstract syntax tree (AST) into three-address code (TAC).
  *
@@ -18,4 +26,55 @@
  */
 TacProgram* ast_to_tac(ProgramNode* ast_root, Arena* arena);
 
+/**
+ * @brief Translates a flat AST (see flat_ast.h) into TAC. The instructions, temps and labels
+ *        are exactly those ast_to_tac produces for the pointer tree it was flattened from.
+ *
+ * @param ast The flat tree, rooted at a NODE_PROGRAM node.
+ * @param arena A pointer to the arena allocator to use for TAC generation.
+ * @return A pointer to the generated TacProgram, or NULL if translation fails.
+ */
+TacProgram* flat_ast_to_tac(const FlatAst* ast, Arena* arena);
+
+/**
+ * @brief Validates the program and translates it into TAC in a single walk of the AST.
+ *
+ * Performs the checks of validate_program (undeclared and redeclared variables, assignment
+ * l-values) with the same messages while the TAC is generated. Beyond what ast_to_tac can
+ * lower, it also handles variables: each declaration gets a temp, recorded in its symbol,
+ * and uses and assignments of the name resolve to that temp.
+ *
+ * @param ast_root A pointer to the root node of the AST (ProgramNode).
+ * @param arena A pointer to the arena allocator to use for TAC generation.
+ * @return A pointer to the generated TacProgram, or NULL if the program is invalid or
+ *         translation fails.
+ */
+TacProgram* ast_to_tac_fused(ProgramNode* ast_root, Arena* arena);
+
+/**
+ * @brief ast_to_tac_fused for a flat AST (see flat_ast.h).
+ *
+ * @param ast The flat tree, rooted at a NODE_PROGRAM node.
+ * @param arena A pointer to the arena allocator to use for TAC generation.
+ * @return A pointer to the generated TacProgram, or NULL if the program is invalid or
+ *         translation fails.
+ */
+TacProgram* flat_ast_to_tac_fused(const FlatAst* ast, Arena* arena);
+
+/**
+ * @brief Translates the AST into TAC with the given lowering choices.
+ *
+ * @param ast_root A pointer to the root node of the AST (ProgramNode).
+ * @param options How to lower (fused validation, branchless logical operators).
+ * @param arena A pointer to the arena allocator to use for TAC generation.
+ * @return A pointer to the generated TacProgram, or NULL if translation fails (or, fused, if the
+ *         program is invalid).
+ */
+TacProgram* ast_to_tac_with_options(ProgramNode* ast_root, const TacLoweringOptions* options, Arena* arena);
+
+/**
+ * @brief ast_to_tac_with_options for a flat AST (see flat_ast.h).
+ */
+TacProgram* flat_ast_to_tac_with_options(const FlatAst* ast, const TacLoweringOptions* options, Arena* arena);
+
 #endif // CLERIC_AST_TO_TAC_H
@@ -0,0 +1,159 @@
+#include "cfg.h"
+#include <stdio.h>
+#include <string.h>
+
+int cfg_block_for_label(const Cfg *cfg, const uint32_t label) {
+    return label < cfg->label_bound ? cfg->label_blocks[label] : -1;
+}
+
+// --- Block construction ---
+
+static bool ends_block(const TacInstructionType type) {
+    return type == TAC_INS_GOTO || type == TAC_INS_IF_FALSE_GOTO || type == TAC_INS_IF_TRUE_GOTO ||
+           type == TAC_INS_RETURN;
+}
+
+uint32_t cfg_jump_target(const TacInstruction *instr) {
+    switch (instr->type) {
+        case TAC_INS_GOTO:
+            return tac_label(instr).value.label_id;
+        case TAC_INS_IF_FALSE_GOTO:
+        case TAC_INS_IF_TRUE_GOTO:
+            return tac_label(instr).value.label_id;
+        default:
+            return TAC_NO_LABEL;
+    }
+}
+
+static void add_successor(CfgBlock *block, const int successor) {
+    for (int s = 0; s < block->successor_count; ++s) {
+        if (block->successors[s] == successor) {
+            return; // A conditional jump to the next block is still one edge
+        }
+    }
+    block->successors[block->successor_count++] = successor;
+}
+
+bool cfg_build(const TacFunction *func, Arena *arena, Cfg *out) {
+    memset(out, 0, sizeof(*out));
+    out->function = func;
+    const size_t n = func->instruction_count;
+    if (n == 0) {
+        return true;
+    }
+
+    out->blocks = arena_alloc(arena, n * sizeof(CfgBlock));
+    out->block_of = arena_alloc(arena, n * sizeof(int));
+    if (!out->blocks || !out->block_of) {
+        fprintf(stderr, "IR Error: Out of memory building the CFG of function %s.\n", func->name);
+        return false;
+    }
+
+    // 1. Leaders
+    int block_count = 0;
+    uint32_t label_bound = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (i == 0 || instr->type == TAC_INS_LABEL || ends_block(func->instructions[i - 1].type)) {
+            if (block_count > 0) {
+                out->blocks[block_count - 1].last = i - 1;
+            }
+            CfgBlock *block = &out->blocks[block_count++];
+            block->first = i;
+            block->label = instr->type == TAC_INS_LABEL ? tac_label(instr).value.label_id
+                                                        : TAC_NO_LABEL;
+            block->successor_count = 0;
+            block->predecessors = NULL;
+            block->predecessor_count = 0;
+        }
+        if (instr->type == TAC_INS_LABEL && tac_label(instr).value.label_id >= label_bound) {
+            label_bound = tac_label(instr).value.label_id + 1;
+        }
+        out->block_of[i] = block_count - 1;
+    }
+    out->blocks[block_count - 1].last = n - 1;
+    out->block_count = block_count;
+
+    // 2. Label -> block
+    if (label_bound > 0) {
+        out->label_blocks = arena_alloc(arena, label_bound * sizeof(int));
+        if (!out->label_blocks) {
+            fprintf(stderr, "IR Error: Out of memory building the CFG of function %s.\n", func->name);
+            return false;
+        }
+        memset(out->label_blocks, -1, label_bound * sizeof(int)); // All bytes 0xFF: every entry is -1
+        out->label_bound = label_bound;
+    }
+    for (int b = 0; b < block_count; ++b) {
+        if (out->blocks[b].label != TAC_NO_LABEL) {
+            out->label_blocks[out->blocks[b].label] = b;
+        }
+    }
+
+    // 3. Successors: the jump target, then the fall-through (GOTO and RETURN never fall through)
+    int edge_count = 0;
+    for (int b = 0; b < block_count; ++b) {
+        CfgBlock *block = &out->blocks[b];
+        const TacInstruction *last = &func->instructions[block->last];
+        const int target = cfg_block_for_label(out, cfg_jump_target(last));
+        if (target >= 0) {
+            add_successor(block, target);
+        }
+        if (last->type != TAC_INS_GOTO && last->type != TAC_INS_RETURN && b + 1 < block_count) {
+            add_successor(block, b + 1);
+        }
+        edge_count += block->successor_count;
+    }
+
+    // 4. Predecessors, as slices of one array
+    out->edge_storage = arena_alloc(arena, (size_t) (edge_count > 0 ? edge_count : 1) * sizeof(int));
+    if (!out->edge_storage) {
+        fprintf(stderr, "IR Error: Out of memory building the CFG of function %s.\n", func->name);
+        return false;
+    }
+    for (int b = 0; b < block_count; ++b) {
+        for (int s = 0; s < out->blocks[b].successor_count; ++s) {
+            out->blocks[out->blocks[b].successors[s]].predecessor_count++;
+        }
+    }
+    int offset = 0;
+    for (int b = 0; b < block_count; ++b) {
+        out->blocks[b].predecessors = out->edge_storage + offset;
+        offset += out->blocks[b].predecessor_count;
+        out->blocks[b].predecessor_count = 0; // Refilled below
+    }
+    for (int b = 0; b < block_count; ++b) {
+        for (int s = 0; s < out->blocks[b].successor_count; ++s) {
+            CfgBlock *successor = &out->blocks[out->blocks[b].successors[s]];
+            successor->predecessors[successor->predecessor_count++] = b;
+        }
+    }
+    return true;
+}
+
+bool cfg_mark_reachable(const Cfg *cfg, bool *reachable, Arena *arena) {
+    if (cfg->block_count == 0) {
+        return true;
+    }
+    memset(reachable, 0, (size_t) cfg->block_count * sizeof(bool));
+    const ArenaMark mark = arena_mark(arena);
+    int *worklist = arena_alloc(arena, (size_t) cfg->block_count * sizeof(int));
+    if (!worklist) {
+        return false;
+    }
+    int pending = 0;
+    worklist[pending++] = 0;
+    reachable[0] = true;
+    while (pending > 0) {
+        const CfgBlock *block = &cfg->blocks[worklist[--pending]];
+        for (int s = 0; s < block->successor_count; ++s) {
+            const int successor = block->successors[s];
+            if (!reachable[successor]) {
+                reachable[successor] = true;
+                worklist[pending++] = successor;
+            }
+        }
+    }
+    arena_release(arena, mark);
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef CLERIC_CFG_H
+#define CLERIC_CFG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Control-flow graph over a TacFunction
+//
+// A block starts at the first instruction, at every LABEL and after every jump
+// or RETURN, and runs to the instruction before the next leader. Label ids are
+// dense per function, so they resolve to block indices through one array built
+// up front and passes never rescan the function to find a jump target.
+// The CFG indexes into the function's instruction array: rebuild it after a
+// pass adds or removes instructions.
+//------------------------------------------------------------------------------
+
+#define CFG_MAX_SUCCESSORS 2 // Conditional jump target + fall-through
+
+typedef struct {
+    size_t first;       // Index of the first instruction
+    size_t last;        // Index of the last instruction (inclusive)
+    uint32_t label;     // Label id the block starts with, or TAC_NO_LABEL
+    int successors[CFG_MAX_SUCCESSORS];
+    int successor_count;
+    int *predecessors;  // Slice of Cfg.edge_storage
+    int predecessor_count;
+} CfgBlock;
+
+typedef struct {
+    const TacFunction *function;
+    CfgBlock *blocks;
+    int block_count;
+    int *block_of;      // Block index of every instruction
+    int *label_blocks;  // Block each label id starts, or -1 (label_bound entries)
+    uint32_t label_bound; // One past the highest label id in the function
+    int *edge_storage;  // Backing array for all predecessor lists
+} Cfg;
+
+/**
+ * @brief Splits the function into basic blocks and links them with successor and predecessor edges.
+ *        An empty function yields zero blocks. Jumps to labels that do not exist get no edge.
+ * @param func The function to analyze.
+ * @param arena Arena for the graph (released by the caller along with other per-function data).
+ * @param out Receives the graph.
+ * @return false if memory ran out (an error has been printed).
+ */
+bool cfg_build(const TacFunction *func, Arena *arena, Cfg *out);
+
+/**
+ * @brief Looks up the block a label starts.
+ * @return The block index, or -1 if no block starts with that label.
+ */
+int cfg_block_for_label(const Cfg *cfg, uint32_t label);
+
+/**
+ * @brief Returns the label a jump or conditional jump targets, or TAC_NO_LABEL for any other instruction.
+ */
+uint32_t cfg_jump_target(const TacInstruction *instr);
+
+/**
+ * @brief Flags every block reachable from the entry block.
+ * @param cfg The graph.
+ * @param reachable Receives one flag per block (cfg->block_count entries).
+ * @param arena Arena for the traversal worklist.
+ * @return false if memory ran out.
+ */
+bool cfg_mark_reachable(const Cfg *cfg, bool *reachable, Arena *arena);
+
+#endif // CLERIC_CFG_H
@@ -0,0 +1,106 @@
+#include "liveness.h"
+#include <stdio.h>
+
+// The temp in a slot, or -1 if the slot holds a constant or nothing
+static int temp_id_of(const TacInstruction *instr, const TacOperandSlot slot) {
+    return tac_slot_is_temp(instr, slot) ? tac_get_operand(instr, slot).value.temp_id : -1;
+}
+
+// The temp the instruction writes, or -1
+static int def_temp_id(const TacInstruction *instr) {
+    return tac_instruction_has_def(instr) ? temp_id_of(instr, TAC_SLOT_DST) : -1;
+}
+
+int tac_function_temp_count(const TacFunction *func) {
+    int temp_count = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            const int id = temp_id_of(instr, (TacOperandSlot) (TAC_SLOT_SRC1 + u));
+            if (id >= temp_count) {
+                temp_count = id + 1;
+            }
+        }
+        if (def_temp_id(instr) >= temp_count) {
+            temp_count = def_temp_id(instr) + 1;
+        }
+    }
+    return temp_count;
+}
+
+bool liveness_compute(const Cfg *cfg, Arena *arena, Liveness *out) {
+    *out = (Liveness){0};
+    const TacFunction *func = cfg->function;
+    const int temp_count = func ? tac_function_temp_count(func) : 0;
+    if (temp_count == 0 || cfg->block_count == 0) {
+        return true;
+    }
+    const CfgBlock *blocks = cfg->blocks;
+    const int block_count = cfg->block_count;
+    const size_t words = (size_t) (temp_count - 1) / 64 + 1;
+    const size_t set_bytes = (size_t) block_count * words * sizeof(uint64_t);
+    uint64_t *use = arena_alloc_zeroed(arena, set_bytes);
+    uint64_t *def = arena_alloc_zeroed(arena, set_bytes);
+    if (!use || !def) {
+        fprintf(stderr, "IR Error: Out of memory computing liveness of function %s.\n", func->name);
+        return false;
+    }
+
+    // Upward-exposed uses and definitions of each block
+    for (int b = 0; b < block_count; ++b) {
+        uint64_t *block_use = &use[(size_t) b * words];
+        uint64_t *block_def = &def[(size_t) b * words];
+        for (size_t i = blocks[b].first; i <= blocks[b].last; ++i) {
+            const TacInstruction *instr = &func->instructions[i];
+            const int use_count = tac_instruction_use_count(instr);
+            for (int u = 0; u < use_count; ++u) {
+                const int id = temp_id_of(instr, (TacOperandSlot) (TAC_SLOT_SRC1 + u));
+                if (id >= 0 && !liveness_set_contains(block_def, id)) {
+                    liveness_set_add(block_use, id);
+                }
+            }
+            const int id = def_temp_id(instr);
+            if (id >= 0) {
+                liveness_set_add(block_def, id);
+            }
+        }
+    }
+
+    uint64_t *live_in = arena_alloc_zeroed(arena, set_bytes);
+    uint64_t *live_out = arena_alloc_zeroed(arena, set_bytes);
+    if (!live_in || !live_out) {
+        fprintf(stderr, "IR Error: Out of memory computing liveness of function %s.\n", func->name);
+        return false;
+    }
+
+    // Backward dataflow to a fixpoint; control flow only goes forward, so the
+    // reverse block order converges in one pass plus one to confirm
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = block_count - 1; b >= 0; --b) {
+            uint64_t *block_out = &live_out[(size_t) b * words];
+            uint64_t *block_in = &live_in[(size_t) b * words];
+            for (int s = 0; s < blocks[b].successor_count; ++s) {
+                const uint64_t *succ_in = &live_in[(size_t) blocks[b].successors[s] * words];
+                for (size_t w = 0; w < words; ++w) {
+                    block_out[w] |= succ_in[w];
+                }
+            }
+            for (size_t w = 0; w < words; ++w) {
+                const uint64_t new_in = use[(size_t) b * words + w] | (block_out[w] & ~def[(size_t) b * words + w]);
+                if (new_in != block_in[w]) {
+                    block_in[w] = new_in;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    out->temp_count = temp_count;
+    out->words = words;
+    out->live_in = live_in;
+    out->live_out = live_out;
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef CLERIC_LIVENESS_H
+#define CLERIC_LIVENESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cfg.h"
+
+//------------------------------------------------------------------------------
+// Temp liveness over a CFG
+//
+// Classic backward dataflow on bitsets, one set per block and direction:
+// out[b] = U in[succ], in[b] = use[b] | (out[b] & ~def[b]). Used by register
+// allocation for live intervals and by dead-temp elimination.
+//------------------------------------------------------------------------------
+
+typedef struct {
+    int temp_count;     // Temps 0 .. temp_count - 1 are tracked
+    size_t words;       // 64-bit words per set
+    uint64_t *live_in;  // block_count sets of `words` words each
+    uint64_t *live_out;
+} Liveness;
+
+static inline bool liveness_set_contains(const uint64_t *set, const int temp_id) {
+    return (set[(size_t) temp_id / 64] >> ((size_t) temp_id % 64)) & 1u;
+}
+
+static inline void liveness_set_add(uint64_t *set, const int temp_id) {
+    set[(size_t) temp_id / 64] |= (uint64_t) 1 << ((size_t) temp_id % 64);
+}
+
+static inline void liveness_set_remove(uint64_t *set, const int temp_id) {
+    set[(size_t) temp_id / 64] &= ~((uint64_t) 1 << ((size_t) temp_id % 64));
+}
+
+/**
+ * @brief Returns one more than the highest temp id the function uses or defines (0 if it has no temps).
+ */
+int tac_function_temp_count(const TacFunction *func);
+
+/**
+ * @brief Computes the temps live on entry to and exit from every block of the graph.
+ * @param cfg Graph of the function, as built by cfg_build.
+ * @param arena Arena for the sets (released by the caller along with the CFG).
+ * @param out Receives the sets; both are NULL when the function has no temps.
+ * @return false if memory ran out (an error has been printed).
+ */
+bool liveness_compute(const Cfg *cfg, Arena *arena, Liveness *out);
+
+/**
+ * @brief Returns the set of temps live on exit from a block.
+ */
+static inline const uint64_t *liveness_out_of(const Liveness *liveness, const int block) {
+    return &liveness->live_out[(size_t) block * liveness->words];
+}
+
+/**
+ * @brief Returns the set of temps live on entry to a block.
+ */
+static inline const uint64_t *liveness_in_of(const Liveness *liveness, const int block) {
+    return &liveness->live_in[(size_t) block * liveness->words];
+}
+
+#endif // CLERIC_LIVENESS_H
@@ -0,0 +1,414 @@
+#include "ssa.h"
+#include "liveness.h"
+#include <stdio.h>
+#include <string.h>
+
+// The temp in a slot, or -1 if the slot holds a constant or nothing
+static int temp_id_of(const TacInstruction *instr, const TacOperandSlot slot) {
+    return tac_slot_is_temp(instr, slot) ? tac_get_operand(instr, slot).value.temp_id : -1;
+}
+
+// The temp the instruction writes, or -1
+static int def_temp_id(const TacInstruction *instr) {
+    return tac_instruction_has_def(instr) ? temp_id_of(instr, TAC_SLOT_DST) : -1;
+}
+
+static void out_of_memory(const TacFunction *func) {
+    fprintf(stderr, "IR Error: Out of memory building the SSA form of function %s.\n", func->name);
+}
+
+// --- Dominators ---
+
+// Jumps only go forward, so block order is a topological order of the graph and
+// every predecessor of a block is final by the time the block is reached
+static int intersect(const int *idom, int a, int b) {
+    while (a != b) {
+        while (a > b) {
+            a = idom[a];
+        }
+        while (b > a) {
+            b = idom[b];
+        }
+    }
+    return a;
+}
+
+static bool compute_dominators(SsaFunction *ssa, const bool *reachable, Arena *arena) {
+    const Cfg *cfg = &ssa->cfg;
+    const int n = cfg->block_count;
+    int *idom = arena_alloc(arena, (size_t) n * sizeof(int));
+    int *subtree_size = arena_alloc(arena, (size_t) n * sizeof(int));
+    int *next_child_position = arena_alloc(arena, (size_t) n * sizeof(int));
+    ssa->preorder = arena_alloc(arena, (size_t) n * sizeof(int));
+    ssa->subtree_end = arena_alloc(arena, (size_t) n * sizeof(int));
+    if (!idom || !subtree_size || !next_child_position || !ssa->preorder || !ssa->subtree_end) {
+        return false;
+    }
+
+    idom[0] = 0;
+    for (int b = 1; b < n; ++b) {
+        idom[b] = -1;
+        if (!reachable[b]) {
+            continue;
+        }
+        const CfgBlock *block = &cfg->blocks[b];
+        for (int p = 0; p < block->predecessor_count; ++p) {
+            const int pred = block->predecessors[p];
+            if (reachable[pred]) {
+                idom[b] = idom[b] < 0 ? pred : intersect(idom, pred, idom[b]);
+            }
+        }
+    }
+
+    // Children always come after their parent, so sizes accumulate backwards
+    // and the tree is laid out forwards, each subtree right after its root
+    for (int b = 0; b < n; ++b) {
+        subtree_size[b] = 1;
+    }
+    for (int b = n - 1; b > 0; --b) {
+        if (idom[b] >= 0) {
+            subtree_size[idom[b]] += subtree_size[b];
+        }
+    }
+    ssa->preorder[0] = 0;
+    ssa->subtree_end[0] = subtree_size[0];
+    next_child_position[0] = 1;
+    for (int b = 1; b < n; ++b) {
+        if (idom[b] < 0) {
+            continue;
+        }
+        const int position = next_child_position[idom[b]];
+        next_child_position[idom[b]] += subtree_size[b];
+        ssa->preorder[position] = b;
+        ssa->subtree_end[b] = position + subtree_size[b];
+        next_child_position[b] = position + 1;
+    }
+    ssa->order_count = subtree_size[0];
+    idom[0] = -1;
+    ssa->idom = idom;
+    return true;
+}
+
+bool ssa_dominates(const SsaFunction *ssa, const int a, int b) {
+    while (b >= 0 && b != a) {
+        b = ssa->idom[b];
+    }
+    return b == a;
+}
+
+// Dominance frontiers in one flat array: those of block b are blocks[start[b] .. start[b + 1])
+typedef struct {
+    int *start;
+    int *blocks;
+} Frontiers;
+
+static bool compute_frontiers(const SsaFunction *ssa, const bool *reachable, Arena *arena, Frontiers *out) {
+    const Cfg *cfg = &ssa->cfg;
+    const int n = cfg->block_count;
+    out->start = arena_alloc_zeroed(arena, ((size_t) n + 1) * sizeof(int));
+    int *last_added = arena_alloc(arena, (size_t) n * sizeof(int));
+    if (!out->start || !last_added) {
+        return false;
+    }
+    // Two rounds over the join points: count, then fill
+    for (int round = 0; round < 2; ++round) {
+        for (int b = 0; b < n; ++b) {
+            last_added[b] = -1;
+        }
+        for (int b = 0; b < n; ++b) {
+            const CfgBlock *block = &cfg->blocks[b];
+            if (!reachable[b] || block->predecessor_count < 2) {
+                continue;
+            }
+            for (int p = 0; p < block->predecessor_count; ++p) {
+                for (int runner = block->predecessors[p]; reachable[runner] && runner != ssa->idom[b];
+                     runner = ssa->idom[runner]) {
+                    if (last_added[runner] == b) {
+                        continue;
+                    }
+                    last_added[runner] = b;
+                    if (round == 0) {
+                        out->start[runner + 1]++;
+                    } else {
+                        out->blocks[out->start[runner]++] = b;
+                    }
+                }
+            }
+        }
+        if (round == 0) {
+            for (int b = 0; b < n; ++b) {
+                out->start[b + 1] += out->start[b];
+            }
+            out->blocks = arena_alloc(arena, (size_t) out->start[n] * sizeof(int) + sizeof(int));
+            if (!out->blocks) {
+                return false;
+            }
+        }
+    }
+    // Filling advanced every start to the next block's start
+    for (int b = n; b > 0; --b) {
+        out->start[b] = out->start[b - 1];
+    }
+    out->start[0] = 0;
+    return true;
+}
+
+// --- Phi placement ---
+
+// Blocks defining each temp, in one flat array like the frontiers
+static bool collect_definitions(const SsaFunction *ssa, const bool *reachable, Arena *arena, int **out_start,
+                                int **out_blocks, int *out_definition_count) {
+    const Cfg *cfg = &ssa->cfg;
+    const TacFunction *func = ssa->function;
+    int *start = arena_alloc_zeroed(arena, ((size_t) ssa->temp_count + 1) * sizeof(int));
+    if (!start) {
+        return false;
+    }
+    int definition_count = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const int id = def_temp_id(&func->instructions[i]);
+        if (id >= 0 && reachable[cfg->block_of[i]]) {
+            start[id + 1]++;
+            definition_count++;
+        }
+    }
+    for (int t = 0; t < ssa->temp_count; ++t) {
+        start[t + 1] += start[t];
+    }
+    int *blocks = arena_alloc(arena, (size_t) definition_count * sizeof(int) + sizeof(int));
+    if (!blocks) {
+        return false;
+    }
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const int id = def_temp_id(&func->instructions[i]);
+        if (id >= 0 && reachable[cfg->block_of[i]]) {
+            blocks[start[id]++] = cfg->block_of[i];
+        }
+    }
+    for (int t = ssa->temp_count; t > 0; --t) {
+        start[t] = start[t - 1];
+    }
+    start[0] = 0;
+    *out_start = start;
+    *out_blocks = blocks;
+    *out_definition_count = definition_count;
+    return true;
+}
+
+// Places a phi for every temp at the iterated frontier of its definitions, where it is live
+static bool place_phis(SsaFunction *ssa, const bool *reachable, Arena *arena, int *out_phi_count,
+                       int *out_definition_count) {
+    const Cfg *cfg = &ssa->cfg;
+    const int n = cfg->block_count;
+    Frontiers frontiers;
+    Liveness liveness;
+    int *def_start = NULL;
+    int *def_blocks = NULL;
+    ssa->phis = arena_alloc_zeroed(arena, (size_t) n * sizeof(SsaPhi *));
+    int *worklist = arena_alloc(arena, (size_t) n * sizeof(int));
+    int *queued = arena_alloc(arena, (size_t) n * sizeof(int));
+    int *has_phi = arena_alloc(arena, (size_t) n * sizeof(int));
+    if (!ssa->phis || !worklist || !queued || !has_phi || !compute_frontiers(ssa, reachable, arena, &frontiers) ||
+        !liveness_compute(cfg, arena, &liveness) ||
+        !collect_definitions(ssa, reachable, arena, &def_start, &def_blocks, out_definition_count)) {
+        return false;
+    }
+    for (int b = 0; b < n; ++b) {
+        queued[b] = -1;
+        has_phi[b] = -1;
+    }
+
+    int phi_count = 0;
+    for (int temp = 0; temp < ssa->temp_count; ++temp) {
+        int worklist_count = 0;
+        for (int d = def_start[temp]; d < def_start[temp + 1]; ++d) {
+            if (queued[def_blocks[d]] != temp) {
+                queued[def_blocks[d]] = temp;
+                worklist[worklist_count++] = def_blocks[d];
+            }
+        }
+        while (worklist_count > 0) {
+            const int x = worklist[--worklist_count];
+            for (int f = frontiers.start[x]; f < frontiers.start[x + 1]; ++f) {
+                const int y = frontiers.blocks[f];
+                if (has_phi[y] == temp) {
+                    continue;
+                }
+                has_phi[y] = temp;
+                if (liveness_set_contains(liveness_in_of(&liveness, y), temp)) {
+                    const int predecessor_count = cfg->blocks[y].predecessor_count;
+                    SsaPhi *phi = arena_alloc(arena, sizeof(SsaPhi));
+                    int *args = arena_alloc(arena, (size_t) predecessor_count * sizeof(int));
+                    if (!phi || !args) {
+                        return false;
+                    }
+                    for (int p = 0; p < predecessor_count; ++p) {
+                        args[p] = temp; // Until renaming, and for good from unreachable predecessors
+                    }
+                    *phi = (SsaPhi){.temp = temp, .name = temp, .args = args, .next = ssa->phis[y]};
+                    ssa->phis[y] = phi;
+                    phi_count++;
+                }
+                if (queued[y] != temp) {
+                    queued[y] = temp;
+                    worklist[worklist_count++] = y;
+                }
+            }
+        }
+    }
+    *out_phi_count = phi_count;
+    return true;
+}
+
+// --- Current names ---
+
+bool ssa_versions_init(SsaVersions *versions, const SsaFunction *ssa, Arena *arena) {
+    *versions = (SsaVersions){0};
+    const size_t block_count = (size_t) ssa->cfg.block_count;
+    versions->current = arena_alloc(arena, (size_t) ssa->temp_count * sizeof(int) + sizeof(int));
+    versions->log = arena_alloc(arena, 2 * (size_t) (ssa->name_bound - ssa->temp_count) * sizeof(int) + sizeof(int));
+    versions->marks = arena_alloc(arena, block_count * sizeof(size_t) + sizeof(size_t));
+    versions->open = arena_alloc(arena, block_count * sizeof(int) + sizeof(int));
+    if (!versions->current || !versions->log || !versions->marks || !versions->open) {
+        out_of_memory(ssa->function);
+        return false;
+    }
+    for (int t = 0; t < ssa->temp_count; ++t) {
+        versions->current[t] = -1;
+    }
+    return true;
+}
+
+int ssa_versions_enter(SsaVersions *versions, const SsaFunction *ssa, const int position) {
+    int left = 0;
+    while (versions->open_count > 0 &&
+           ssa->subtree_end[versions->open[versions->open_count - 1]] <= position) {
+        const size_t mark = versions->marks[--versions->open_count];
+        while (versions->log_count > mark) {
+            versions->log_count -= 2;
+            versions->current[versions->log[versions->log_count]] = versions->log[versions->log_count + 1];
+        }
+        left++;
+    }
+    versions->marks[versions->open_count] = versions->log_count;
+    versions->open[versions->open_count++] = ssa->preorder[position];
+    return left;
+}
+
+void ssa_versions_define(SsaVersions *versions, const SsaFunction *ssa, const int name) {
+    const int temp = ssa->original_of[name];
+    versions->log[versions->log_count++] = temp;
+    versions->log[versions->log_count++] = versions->current[temp];
+    versions->current[temp] = name;
+}
+
+// --- Renaming ---
+
+// The name a use of temp reads at this point: a use no definition reaches keeps its id
+static int current_name(const SsaVersions *versions, const int temp) {
+    return versions->current[temp] >= 0 ? versions->current[temp] : temp;
+}
+
+static void rename_block(SsaFunction *ssa, SsaVersions *versions, const int b, int *next_name) {
+    const Cfg *cfg = &ssa->cfg;
+    TacFunction *func = ssa->function;
+    for (SsaPhi *phi = ssa->phis[b]; phi; phi = phi->next) {
+        phi->name = (*next_name)++;
+        ssa->original_of[phi->name] = phi->temp;
+        ssa_versions_define(versions, ssa, phi->name);
+    }
+    for (size_t i = cfg->blocks[b].first; i <= cfg->blocks[b].last; ++i) {
+        TacInstruction *instr = &func->instructions[i];
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+            const int id = temp_id_of(instr, slot);
+            if (id >= 0) {
+                tac_set_operand(instr, slot, create_tac_operand_temp(current_name(versions, id)));
+            }
+        }
+        const int id = def_temp_id(instr);
+        if (id >= 0) {
+            const int name = (*next_name)++;
+            ssa->original_of[name] = id;
+            tac_set_operand(instr, TAC_SLOT_DST, create_tac_operand_temp(name));
+            ssa_versions_define(versions, ssa, name);
+        }
+    }
+    for (int s = 0; s < cfg->blocks[b].successor_count; ++s) {
+        const CfgBlock *successor = &cfg->blocks[cfg->blocks[b].successors[s]];
+        int p = 0;
+        while (successor->predecessors[p] != b) {
+            p++;
+        }
+        for (SsaPhi *phi = ssa->phis[cfg->blocks[b].successors[s]]; phi; phi = phi->next) {
+            phi->args[p] = current_name(versions, phi->temp);
+        }
+    }
+}
+
+bool ssa_construct(TacFunction *func, Arena *arena, SsaFunction *out) {
+    *out = (SsaFunction){.function = func};
+    if (!cfg_build(func, arena, &out->cfg)) {
+        return false;
+    }
+    out->temp_count = tac_function_temp_count(func);
+    out->name_bound = out->temp_count;
+    const int n = out->cfg.block_count;
+    if (n == 0) {
+        return true;
+    }
+
+    bool *reachable = arena_alloc_zeroed(arena, (size_t) n * sizeof(bool));
+    int phi_count = 0;
+    int definition_count = 0;
+    if (!reachable || !cfg_mark_reachable(&out->cfg, reachable, arena) ||
+        !compute_dominators(out, reachable, arena) ||
+        !place_phis(out, reachable, arena, &phi_count, &definition_count)) {
+        out_of_memory(func);
+        return false;
+    }
+    out->name_bound = out->temp_count + definition_count + phi_count;
+    out->original_of = arena_alloc(arena, (size_t) out->name_bound * sizeof(int) + sizeof(int));
+    if (!out->original_of) {
+        out_of_memory(func);
+        return false;
+    }
+    for (int t = 0; t < out->temp_count; ++t) {
+        out->original_of[t] = t;
+    }
+    SsaVersions versions;
+    if (!ssa_versions_init(&versions, out, arena)) {
+        return false;
+    }
+
+    // Blocks no path reaches keep their original temps, which destruction maps to themselves
+    int next_name = out->temp_count;
+    for (int position = 0; position < out->order_count; ++position) {
+        ssa_versions_enter(&versions, out, position);
+        rename_block(out, &versions, out->preorder[position], &next_name);
+    }
+    return true;
+}
+
+void ssa_destruct(SsaFunction *ssa) {
+    TacFunction *func = ssa->function;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        TacInstruction *instr = &func->instructions[i];
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+            const int id = temp_id_of(instr, slot);
+            if (id >= 0) {
+                tac_set_operand(instr, slot, create_tac_operand_temp(ssa->original_of[id]));
+            }
+        }
+        const int id = def_temp_id(instr);
+        if (id >= 0) {
+            tac_set_operand(instr, TAC_SLOT_DST, create_tac_operand_temp(ssa->original_of[id]));
+        }
+    }
+    if (ssa->phis) {
+        memset(ssa->phis, 0, (size_t) ssa->cfg.block_count * sizeof(SsaPhi *));
+    }
+}
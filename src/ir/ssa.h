@@ -0,0 +1,109 @@
+#ifndef CLERIC_SSA_H
+#define CLERIC_SSA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "cfg.h"
+
+//------------------------------------------------------------------------------
+// Static single assignment form over a TacFunction
+//
+// ssa_construct computes the dominator tree of the function's CFG (Cooper,
+// Harvey and Kennedy's iterative algorithm), places phi nodes at the iterated
+// dominance frontier of every temp's definitions where the temp is live, and
+// renames every definition to a fresh temp id in place. Phi nodes live beside
+// the instructions, one list per block, since a TAC instruction has no room
+// for one argument per predecessor.
+//
+// ssa_destruct maps every name back to the temp it was split from and drops
+// the phis, which inserts no copies: it is exact as long as no two names of
+// the same original temp are live at once. Renaming keeps that true, and a
+// pass working on SSA form keeps it true if it only reads a name where that
+// name is still the current one of its temp (ssa_is_current tracks this along
+// a dominator tree walk).
+//------------------------------------------------------------------------------
+
+typedef struct SsaPhi {
+    int temp;            // Original temp id
+    int name;            // The fresh id it defines
+    int *args;           // Name flowing in from each predecessor, in CfgBlock.predecessors order
+    struct SsaPhi *next; // Next phi of the same block
+} SsaPhi;
+
+typedef struct {
+    TacFunction *function;
+    Cfg cfg;
+    int temp_count;       // Ids below this are original temps (a use no definition reaches keeps its id)
+    int name_bound;       // One past the highest name
+    int *original_of;     // Original temp of every name (name_bound entries)
+    SsaPhi **phis;        // Phi list of every block
+    int *idom;            // Immediate dominator of every block; -1 for the entry and unreachable blocks
+    int *preorder;        // Reachable blocks in dominator tree preorder (order_count entries)
+    int *subtree_end;     // Per block: position in preorder just past its dominator subtree
+    int order_count;
+} SsaFunction;
+
+/**
+ * @brief Converts a function to SSA form, renaming its temps in place.
+ * @param func The function to convert; jumps must only go forward, as lowering emits them.
+ * @param arena Arena for the graph, the phis and the tables (released by the caller).
+ * @param out Receives the SSA view of the function.
+ * @return false if memory ran out (an error has been printed); the function is then unchanged.
+ */
+bool ssa_construct(TacFunction *func, Arena *arena, SsaFunction *out);
+
+/**
+ * @brief Maps every name back to its original temp and forgets the phis.
+ */
+void ssa_destruct(SsaFunction *ssa);
+
+/**
+ * @brief Whether block a dominates block b (every block dominates itself).
+ */
+bool ssa_dominates(const SsaFunction *ssa, int a, int b);
+
+//------------------------------------------------------------------------------
+// Current names along a dominator tree walk
+//
+// Visit ssa->preorder in order: ssa_versions_enter at each position first
+// leaves the blocks whose dominator subtree ended there, undoing their
+// definitions; then call ssa_versions_define for every phi and definition of
+// the block as it is reached.
+//------------------------------------------------------------------------------
+
+typedef struct {
+    int *current;  // Current name of every original temp, -1 before its first definition
+    int *log;      // Pairs (temp, previous name) to undo on leaving a block
+    size_t log_count;
+    size_t *marks; // log_count on entering each open block
+    int *open;     // Open blocks, innermost last
+    int open_count;
+} SsaVersions;
+
+/**
+ * @brief Prepares an empty walk; false if memory ran out (an error has been printed).
+ */
+bool ssa_versions_init(SsaVersions *versions, const SsaFunction *ssa, Arena *arena);
+
+/**
+ * @brief Enters the block at a position of ssa->preorder.
+ * @return How many open blocks were left first, so a caller keeping scoped state of its own
+ *         can undo as many levels.
+ */
+int ssa_versions_enter(SsaVersions *versions, const SsaFunction *ssa, int position);
+
+/**
+ * @brief Makes a name the current one of its original temp until its block is left.
+ */
+void ssa_versions_define(SsaVersions *versions, const SsaFunction *ssa, int name);
+
+/**
+ * @brief Whether a name still holds the current value of its original temp, so that reading it
+ *        at this point survives ssa_destruct.
+ */
+static inline bool ssa_is_current(const SsaVersions *versions, const SsaFunction *ssa, const int name) {
+    const int temp = ssa->original_of[name];
+    return versions->current[temp] == name || (versions->current[temp] < 0 && name == temp);
+}
+
+#endif // CLERIC_SSA_H
@@ -29,10 +29,10 @@ TacOperand create_tac_operand_temp(const int temp_id) {
     return op;
 }
 
-TacOperand create_tac_operand_label(const char *name) {
+TacOperand create_tac_operand_label(const uint32_t label_id) {
     TacOperand op;
     op.type = TAC_OPERAND_LABEL;
-    op.value.label_name = name; // Assuming name is persistent
+    op.value.label_id = label_id;
     return op;
 }
 
@@ -40,196 +40,210 @@ TacOperand create_tac_operand_label(const char *name) {
 // Instruction Creation
 //------------------------------------------------------------------------------
 
-// Helper to create a generic instruction structure
+// Helper to create a generic instruction structure (unused slots stay zero)
 static TacInstruction *create_base_instruction(const TacInstructionType type, Arena *arena) {
-    TacInstruction *instr = arena_alloc(arena, sizeof(TacInstruction));
+    TacInstruction *instr = arena_alloc_tagged(arena, sizeof(TacInstruction), ARENA_TAG_TAC);
     if (!instr) {
         // Handle allocation failure (e.g., return NULL, exit, depends on strategy)
         perror("Failed to allocate TAC instruction");
         exit(EXIT_FAILURE); // Simple strategy for now
     }
-    instr->type = type;
+    memset(instr, 0, sizeof(TacInstruction));
+    instr->type = (uint8_t) type;
     return instr;
 }
 
-TacInstruction *create_tac_instruction_copy(const TacOperand dst, const TacOperand src, Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_COPY, arena);
-    instr->operands.copy.dst = dst;
-    instr->operands.copy.src = src;
+// dst = op src
+static TacInstruction *create_unary_shape(const TacInstructionType type, const TacOperand dst, const TacOperand src,
+                                          Arena *arena) {
+    TacInstruction *instr = create_base_instruction(type, arena);
+    tac_set_operand(instr, TAC_SLOT_DST, dst);
+    tac_set_operand(instr, TAC_SLOT_SRC1, src);
     return instr;
 }
 
-TacInstruction *create_tac_instruction_negate(const TacOperand dst, const TacOperand src, Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_NEGATE, arena);
-    instr->operands.unary_op.dst = dst;
-    instr->operands.unary_op.src = src;
+// dst = src1 op src2
+static TacInstruction *create_binary_shape(const TacInstructionType type, const TacOperand dst, const TacOperand src1,
+                                           const TacOperand src2, Arena *arena) {
+    TacInstruction *instr = create_base_instruction(type, arena);
+    tac_set_operand(instr, TAC_SLOT_DST, dst);
+    tac_set_operand(instr, TAC_SLOT_SRC1, src1);
+    tac_set_operand(instr, TAC_SLOT_SRC2, src2);
     return instr;
 }
 
+TacInstruction *create_tac_instruction_copy(const TacOperand dst, const TacOperand src, Arena *arena) {
+    return create_unary_shape(TAC_INS_COPY, dst, src, arena);
+}
+
+TacInstruction *create_tac_instruction_negate(const TacOperand dst, const TacOperand src, Arena *arena) {
+    return create_unary_shape(TAC_INS_NEGATE, dst, src, arena);
+}
+
 TacInstruction *create_tac_instruction_complement(const TacOperand dst, const TacOperand src, Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_COMPLEMENT, arena);
-    instr->operands.unary_op.dst = dst;
-    instr->operands.unary_op.src = src;
-    return instr;
+    return create_unary_shape(TAC_INS_COMPLEMENT, dst, src, arena);
 }
 
 TacInstruction *create_tac_instruction_logical_not(const TacOperand dst, const TacOperand src, Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_LOGICAL_NOT, arena);
-    instr->operands.unary_op.dst = dst;
-    instr->operands.unary_op.src = src;
-    return instr;
+    return create_unary_shape(TAC_INS_LOGICAL_NOT, dst, src, arena);
 }
 
 TacInstruction *create_tac_instruction_return(const TacOperand src, Arena *arena) {
     TacInstruction *instr = create_base_instruction(TAC_INS_RETURN, arena);
-    instr->operands.ret.src = src;
+    tac_set_operand(instr, TAC_SLOT_SRC1, src);
     return instr;
 }
 
 // --- Binary Instruction Creation ---
 TacInstruction *create_tac_instruction_add(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                            Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_ADD, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_ADD, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_sub(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                            Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_SUB, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_SUB, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_mul(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                            Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_MUL, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_MUL, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_div(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                            Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_DIV, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_DIV, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_mod(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                            Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_MOD, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_MOD, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_less(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                             Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_LESS, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_LESS, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_greater(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                                Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_GREATER, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_GREATER, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_less_equal(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                                   Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_LESS_EQUAL, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_LESS_EQUAL, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_greater_equal(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                                      Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_GREATER_EQUAL, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_GREATER_EQUAL, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_equal(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                              Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_EQUAL, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_EQUAL, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_not_equal(const TacOperand dst, const TacOperand src1, const TacOperand src2,
                                                  Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_NOT_EQUAL, arena);
-    instr->operands.relational_op.dst = dst;
-    instr->operands.relational_op.src1 = src1;
-    instr->operands.relational_op.src2 = src2;
-    return instr;
+    return create_binary_shape(TAC_INS_NOT_EQUAL, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_label(const TacOperand label, Arena *arena) {
     TacInstruction *instr = create_base_instruction(TAC_INS_LABEL, arena);
-    instr->operands.label_def.label = label;
+    tac_set_operand(instr, TAC_SLOT_LABEL, label);
     return instr;
 }
 
 TacInstruction *create_tac_instruction_goto(const TacOperand target_label, Arena *arena) {
     TacInstruction *instr = create_base_instruction(TAC_INS_GOTO, arena);
-    instr->operands.go_to.target_label = target_label;
+    tac_set_operand(instr, TAC_SLOT_LABEL, target_label);
     return instr;
 }
 
 TacInstruction *create_tac_instruction_if_false_goto(const TacOperand condition_src, const TacOperand target_label,
                                                      Arena *arena) {
     TacInstruction *instr = create_base_instruction(TAC_INS_IF_FALSE_GOTO, arena);
-    instr->operands.conditional_goto.condition_src = condition_src;
-    instr->operands.conditional_goto.target_label = target_label;
+    tac_set_operand(instr, TAC_SLOT_SRC1, condition_src);
+    tac_set_operand(instr, TAC_SLOT_LABEL, target_label);
     return instr;
 }
 
 TacInstruction *create_tac_instruction_if_true_goto(const TacOperand condition_src, const TacOperand target_label,
                                                     Arena *arena) {
     TacInstruction *instr = create_base_instruction(TAC_INS_IF_TRUE_GOTO, arena);
-    instr->operands.conditional_goto.condition_src = condition_src;
-    instr->operands.conditional_goto.target_label = target_label;
+    tac_set_operand(instr, TAC_SLOT_SRC1, condition_src);
+    tac_set_operand(instr, TAC_SLOT_LABEL, target_label);
     return instr;
 }
 
 TacInstruction *create_tac_instruction_logical_and(const TacOperand dst, const TacOperand src1, const TacOperand src2,
-                                                 Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_LOGICAL_AND, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+                                                   Arena *arena) {
+    return create_binary_shape(TAC_INS_LOGICAL_AND, dst, src1, src2, arena);
 }
 
 TacInstruction *create_tac_instruction_logical_or(const TacOperand dst, const TacOperand src1, const TacOperand src2,
-                                                Arena *arena) {
-    TacInstruction *instr = create_base_instruction(TAC_INS_LOGICAL_OR, arena);
-    instr->operands.binary_op.dst = dst;
-    instr->operands.binary_op.src1 = src1;
-    instr->operands.binary_op.src2 = src2;
-    return instr;
+                                                  Arena *arena) {
+    return create_binary_shape(TAC_INS_LOGICAL_OR, dst, src1, src2, arena);
+}
+
+//------------------------------------------------------------------------------
+// Operand Access
+//------------------------------------------------------------------------------
+
+bool tac_instruction_has_def(const TacInstruction *instr) {
+    switch (instr->type) {
+        case TAC_INS_COPY:
+        case TAC_INS_NEGATE:
+        case TAC_INS_COMPLEMENT:
+        case TAC_INS_LOGICAL_NOT:
+        case TAC_INS_ADD:
+        case TAC_INS_SUB:
+        case TAC_INS_MUL:
+        case TAC_INS_DIV:
+        case TAC_INS_MOD:
+        case TAC_INS_LOGICAL_AND:
+        case TAC_INS_LOGICAL_OR:
+        case TAC_INS_LESS:
+        case TAC_INS_GREATER:
+        case TAC_INS_LESS_EQUAL:
+        case TAC_INS_GREATER_EQUAL:
+        case TAC_INS_EQUAL:
+        case TAC_INS_NOT_EQUAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int tac_instruction_use_count(const TacInstruction *instr) {
+    switch (instr->type) {
+        case TAC_INS_COPY:
+        case TAC_INS_NEGATE:
+        case TAC_INS_COMPLEMENT:
+        case TAC_INS_LOGICAL_NOT:
+        case TAC_INS_RETURN:
+        case TAC_INS_IF_FALSE_GOTO:
+        case TAC_INS_IF_TRUE_GOTO:
+            return 1;
+        case TAC_INS_ADD:
+        case TAC_INS_SUB:
+        case TAC_INS_MUL:
+        case TAC_INS_DIV:
+        case TAC_INS_MOD:
+        case TAC_INS_LOGICAL_AND:
+        case TAC_INS_LOGICAL_OR:
+        case TAC_INS_LESS:
+        case TAC_INS_GREATER:
+        case TAC_INS_LESS_EQUAL:
+        case TAC_INS_GREATER_EQUAL:
+        case TAC_INS_EQUAL:
+        case TAC_INS_NOT_EQUAL:
+            return 2;
+        default:
+            return 0; // LABEL, GOTO
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -237,7 +251,7 @@ TacInstruction *create_tac_instruction_logical_or(const TacOperand dst, const Ta
 //------------------------------------------------------------------------------
 
 TacFunction *create_tac_function(const char *name, Arena *arena) {
-    TacFunction *func = arena_alloc(arena, sizeof(TacFunction));
+    TacFunction *func = arena_alloc_tagged(arena, sizeof(TacFunction), ARENA_TAG_TAC);
     if (!func) {
         perror("Failed to allocate TAC function");
         exit(EXIT_FAILURE);
@@ -245,7 +259,7 @@ TacFunction *create_tac_function(const char *name, Arena *arena) {
 
     // Allocate space for the name string in the arena and copy it
     size_t name_len = strlen(name) + 1;
-    char *name_copy = arena_alloc(arena, name_len);
+    char *name_copy = arena_alloc_tagged(arena, name_len, ARENA_TAG_TAC);
     if (!name_copy) {
         perror("Failed to allocate TAC function name");
         exit(EXIT_FAILURE);
@@ -254,8 +268,10 @@ TacFunction *create_tac_function(const char *name, Arena *arena) {
     func->name = name_copy;
 
     func->instruction_count = 0;
+    func->instruction_regrowths = 0;
     func->instruction_capacity = INITIAL_CAPACITY;
-    func->instructions = (TacInstruction *) arena_alloc(arena, func->instruction_capacity * sizeof(TacInstruction));
+    func->instructions = (TacInstruction *) arena_alloc_tagged(arena, func->instruction_capacity * sizeof(TacInstruction),
+                                                               ARENA_TAG_TAC);
     if (!func->instructions) {
         perror("Failed to allocate initial TAC instructions array");
         exit(EXIT_FAILURE);
@@ -264,30 +280,42 @@ TacFunction *create_tac_function(const char *name, Arena *arena) {
     return func;
 }
 
+// Moves the instructions into a new array of the given capacity.
+// Note: Arena allocators typically don't support 'realloc'.
+// The old block remains allocated in the arena but is unused.
+static void resize_instructions(TacFunction *func, const size_t new_capacity, Arena *arena) {
+    TacInstruction *new_instructions = arena_alloc_tagged(arena, new_capacity * sizeof(TacInstruction),
+                                                          ARENA_TAG_TAC);
+    if (!new_instructions) {
+        perror("Failed to grow TAC instructions array");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(new_instructions, func->instructions, func->instruction_count * sizeof(TacInstruction));
+    arena_note_superseded(arena, func->instruction_capacity * sizeof(TacInstruction), ARENA_TAG_TAC);
+
+    func->instructions = new_instructions;
+    func->instruction_capacity = new_capacity;
+}
+
+void tac_function_reserve(TacFunction *func, const size_t capacity, Arena *arena) {
+    if (capacity > func->instruction_capacity) {
+        resize_instructions(func, capacity, arena);
+    }
+}
+
 void add_instruction_to_function(TacFunction *func, const TacInstruction *instr, Arena *arena) {
     if (func->instruction_count >= func->instruction_capacity) {
-        // Grow the array using the arena.
-        // Note: Arena allocators typically don't support 'realloc'.
-        // We allocate a new, larger block and copy the old data.
-        // The old block remains allocated in the arena but is unused.
-        const size_t new_capacity = func->instruction_capacity * 2;
-        TacInstruction *new_instructions = arena_alloc(arena, new_capacity * sizeof(TacInstruction));
-        if (!new_instructions) {
-            perror("Failed to grow TAC instructions array");
-            exit(EXIT_FAILURE);
-        }
-        // Copy existing instructions - *instr is a pointer, copy the struct itself*
-        memcpy(new_instructions, func->instructions, func->instruction_count * sizeof(TacInstruction));
-
-        func->instructions = new_instructions;
-        func->instruction_capacity = new_capacity;
+        // A function loaded from a module (tac_file.h) may have no room at all
+        resize_instructions(func, func->instruction_capacity ? func->instruction_capacity * 2 : INITIAL_CAPACITY,
+                            arena);
+        func->instruction_regrowths++;
     }
     // Copy the *content* of the instruction pointed to by instr into the array
     func->instructions[func->instruction_count++] = *instr;
 }
 
 TacProgram *create_tac_program(Arena *arena) {
-    TacProgram *prog = arena_alloc(arena, sizeof(TacProgram));
+    TacProgram *prog = arena_alloc_tagged(arena, sizeof(TacProgram), ARENA_TAG_TAC);
     if (!prog) {
         perror("Failed to allocate TAC program");
         exit(EXIT_FAILURE);
@@ -296,7 +324,8 @@ TacProgram *create_tac_program(Arena *arena) {
     prog->function_count = 0;
     prog->function_capacity = INITIAL_CAPACITY;
     // Allocate an array of *pointers* to TacFunction
-    prog->functions = (TacFunction **) arena_alloc(arena, prog->function_capacity * sizeof(TacFunction *));
+    prog->functions = (TacFunction **) arena_alloc_tagged(arena, prog->function_capacity * sizeof(TacFunction *),
+                                                          ARENA_TAG_TAC);
     if (!prog->functions) {
         perror("Failed to allocate initial TAC functions array");
         exit(EXIT_FAILURE);
@@ -308,13 +337,15 @@ void add_function_to_program(TacProgram *prog, TacFunction *func, Arena *arena)
     if (prog->function_count >= prog->function_capacity) {
         // Grow the array of function pointers
         size_t new_capacity = prog->function_capacity * 2;
-        TacFunction **new_functions = arena_alloc(arena, new_capacity * sizeof(TacFunction *));
+        TacFunction **new_functions = arena_alloc_tagged(arena, new_capacity * sizeof(TacFunction *),
+                                                         ARENA_TAG_TAC);
         if (!new_functions) {
             perror("Failed to grow TAC functions array");
             exit(EXIT_FAILURE);
         }
         // Copy existing function pointers
         memcpy(new_functions, prog->functions, prog->function_count * sizeof(TacFunction*));
+        arena_note_superseded(arena, prog->function_capacity * sizeof(TacFunction *), ARENA_TAG_TAC);
 
         prog->functions = new_functions;
         prog->function_capacity = new_capacity;
@@ -346,7 +377,7 @@ void tac_print_operand(StringBuffer *sb, const TacOperand *operand) {
             string_buffer_append(sb, "t%d", operand->value.temp_id);
             break;
         case TAC_OPERAND_LABEL:
-            string_buffer_append(sb, "%s", operand->value.label_name ? operand->value.label_name : "<null_label_name>");
+            string_buffer_append(sb, "L%u", (unsigned) operand->value.label_id);
             break;
         default:
             string_buffer_append(sb, "<unk_op_type:%d>", operand->type);
@@ -354,6 +385,11 @@ void tac_print_operand(StringBuffer *sb, const TacOperand *operand) {
     }
 }
 
+static void print_slot(StringBuffer *sb, const TacInstruction *instruction, const TacOperandSlot slot) {
+    const TacOperand operand = tac_get_operand(instruction, slot);
+    tac_print_operand(sb, &operand);
+}
+
 void tac_print_instruction(StringBuffer *sb, const TacInstruction *instruction) {
     if (!instruction) {
         string_buffer_append(sb, "<null_instr>\n");
@@ -362,164 +398,164 @@ void tac_print_instruction(StringBuffer *sb, const TacInstruction *instruction)
 
     switch (instruction->type) {
         case TAC_INS_COPY:
-            tac_print_operand(sb, &instruction->operands.copy.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.copy.src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_NEGATE:
-            tac_print_operand(sb, &instruction->operands.unary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = - ");
-            tac_print_operand(sb, &instruction->operands.unary_op.src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_COMPLEMENT:
-            tac_print_operand(sb, &instruction->operands.unary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ~ ");
-            tac_print_operand(sb, &instruction->operands.unary_op.src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_RETURN:
             string_buffer_append(sb, "return ");
-            tac_print_operand(sb, &instruction->operands.ret.src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, "\n");
             break;
         // Binary Operations
         case TAC_INS_ADD:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " + ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_SUB:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " - ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_MUL:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " * ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_DIV:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " / ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_MOD:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " %% "); // Use %% for literal %
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         // New Unary Op
         case TAC_INS_LOGICAL_NOT:
-            tac_print_operand(sb, &instruction->operands.unary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ! ");
-            tac_print_operand(sb, &instruction->operands.unary_op.src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, "\n");
             break;
         // New Relational Ops
         case TAC_INS_LESS:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " < ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_GREATER:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " > ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_LESS_EQUAL:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " <= ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_GREATER_EQUAL:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " >= ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_EQUAL:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " == ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_NOT_EQUAL:
-            tac_print_operand(sb, &instruction->operands.relational_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " != ");
-            tac_print_operand(sb, &instruction->operands.relational_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         // New Control Flow Instructions
         case TAC_INS_LABEL:
-            tac_print_operand(sb, &instruction->operands.label_def.label);
+            print_slot(sb, instruction, TAC_SLOT_LABEL);
             string_buffer_append(sb, ":");
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_GOTO:
             string_buffer_append(sb, "goto ");
-            tac_print_operand(sb, &instruction->operands.go_to.target_label);
+            print_slot(sb, instruction, TAC_SLOT_LABEL);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_IF_FALSE_GOTO:
             string_buffer_append(sb, "if_false ");
-            tac_print_operand(sb, &instruction->operands.conditional_goto.condition_src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " goto ");
-            tac_print_operand(sb, &instruction->operands.conditional_goto.target_label);
+            print_slot(sb, instruction, TAC_SLOT_LABEL);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_IF_TRUE_GOTO:
             string_buffer_append(sb, "if_not_zero ");
-            tac_print_operand(sb, &instruction->operands.conditional_goto.condition_src);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " goto ");
-            tac_print_operand(sb, &instruction->operands.conditional_goto.target_label);
+            print_slot(sb, instruction, TAC_SLOT_LABEL);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_LOGICAL_AND:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " && ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         case TAC_INS_LOGICAL_OR:
-            tac_print_operand(sb, &instruction->operands.binary_op.dst);
+            print_slot(sb, instruction, TAC_SLOT_DST);
             string_buffer_append(sb, " = ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src1);
+            print_slot(sb, instruction, TAC_SLOT_SRC1);
             string_buffer_append(sb, " || ");
-            tac_print_operand(sb, &instruction->operands.binary_op.src2);
+            print_slot(sb, instruction, TAC_SLOT_SRC2);
             string_buffer_append(sb, "\n");
             break;
         default:
@@ -1,8 +1,9 @@
 #ifndef CLERIC_TAC_H
 #define CLERIC_TAC_H
 
+#include <stdbool.h>
 #include <stddef.h> // For size_t
-#include <stdint.h> // For int values (though standard int might suffice)
+#include <stdint.h> // For the fixed-width fields of packed instructions and label ids
 
 #include "../memory/arena.h" // For arena allocation
 #include "../strings/strings.h" // For StringBuffer
@@ -14,7 +15,7 @@
 typedef enum {
     TAC_OPERAND_CONST, // Integer Constant
     TAC_OPERAND_TEMP,  // Temporary variable (register/stack slot) identified by ID
-    TAC_OPERAND_LABEL // New: Label identifier for jumps
+    TAC_OPERAND_LABEL // New: Label identifier for jumps (dense per function, printed as L<id>)
     // TAC_OPERAND_VAR // Future: Source variable identifier
 } TacOperandType;
 
@@ -23,11 +24,14 @@ typedef struct {
     union {
         int constant_value; // For TAC_OPERAND_CONST
         int temp_id;        // For TAC_OPERAND_TEMP
-        const char* label_name; // New: For TAC_OPERAND_LABEL
+        uint32_t label_id;  // For TAC_OPERAND_LABEL
         // const char* var_name; // Future: For TAC_OPERAND_VAR
     } value;
 } TacOperand;
 
+// Stands for "no label" where a label id is expected (e.g. the target of a non-jump)
+#define TAC_NO_LABEL UINT32_MAX
+
 //------------------------------------------------------------------------------
 // Instructions
 //------------------------------------------------------------------------------
@@ -61,44 +65,78 @@ typedef enum {
     TAC_INS_NOT_EQUAL,  // dst = src1 != src2
 
     // New Control Flow Instructions
-    TAC_INS_LABEL,          // Defines a code label. Operand is a string identifier (e.g., "_L0").
-    TAC_INS_GOTO,           // Unconditional jump. Operand is a string label identifier.
-    TAC_INS_IF_FALSE_GOTO,  // Conditional jump if 'condition_src' is 0 (false). Target is a string label identifier.
-    TAC_INS_IF_TRUE_GOTO    // Conditional jump if 'condition_src' is non-0 (true). Target is a string label identifier.
+    TAC_INS_LABEL,          // Defines a code label. Operand is a label id (printed as L0, L1, ...).
+    TAC_INS_GOTO,           // Unconditional jump. Operand is a label id.
+    TAC_INS_IF_FALSE_GOTO,  // Conditional jump if 'condition_src' is 0 (false). Target is a label id.
+    TAC_INS_IF_TRUE_GOTO    // Conditional jump if 'condition_src' is non-0 (true). Target is a label id.
 
     // Future instructions: CALL, PARAM, etc.
 } TacInstructionType;
 
-// Forward declare TacInstruction for use in struct definitions if needed (not strictly necessary here)
-// struct TacInstruction;
+// Operand slots of an instruction. Every instruction keeps the operand it writes in
+// TAC_SLOT_DST, its first (or only) read operand in TAC_SLOT_SRC1, and its second read
+// operand or its label in TAC_SLOT_SRC2 / TAC_SLOT_LABEL:
+//   dst = src            COPY, NEGATE, COMPLEMENT, LOGICAL_NOT     dst, src1
+//   dst = src1 op src2   arithmetic, logical and relational ops    dst, src1, src2
+//   return src                                                     src1
+//   L<id>: / goto L<id>                                            label
+//   if_false src goto L<id> / if_not_zero src goto L<id>           src1, label
+typedef enum {
+    TAC_SLOT_DST,
+    TAC_SLOT_SRC1,
+    TAC_SLOT_SRC2,
+    TAC_SLOT_COUNT
+} TacOperandSlot;
+
+#define TAC_SLOT_LABEL TAC_SLOT_SRC2
 
+// Bits of TacInstruction.operand_kinds holding the TacOperandType of one slot
+#define TAC_OPERAND_KIND_BITS 2
+#define TAC_OPERAND_KIND_MASK 3u
+
+/**
+ * Packed instruction: a 1-byte opcode, the three operand kinds in one byte and a 32-bit
+ * payload per slot (constant value, temp id or label id, as the kind says), 16 bytes in
+ * all. Every operand payload fits in 32 bits, so no side tables are needed. Read and
+ * write operands through the accessors below, which rebuild TacOperand values.
+ */
 typedef struct {
-    TacInstructionType type;
-    union {
-        // dst = src
-        struct { TacOperand dst; TacOperand src; } copy;
-        // dst = op src
-        struct { TacOperand dst; TacOperand src; } unary_op; // Used for NEGATE, COMPLEMENT, LOGICAL_NOT
-        // return src
-        struct { TacOperand src; } ret;
-        // dst = src1 op src2
-        struct { TacOperand dst; TacOperand src1; TacOperand src2; } binary_op; // For ADD, SUB, MUL, DIV, MOD
-        // dst = src1 op src2 (relational)
-        struct { TacOperand dst; TacOperand src1; TacOperand src2; } relational_op; // For LESS, GREATER, etc.
-
-        // label_name:
-        struct { TacOperand label; } label_def; // For TAC_INS_LABEL
-        // goto label_name
-        struct { TacOperand target_label; } go_to; // For TAC_INS_GOTO
-        // if_false condition_src goto label_name
-        // if_not_zero condition_src goto label_name
-        struct { TacOperand condition_src; TacOperand target_label; } conditional_goto; // For TAC_INS_IF_FALSE_GOTO and TAC_INS_IF_NOT_ZERO_GOTO
-
-        // Future: struct { const char* func_name; TacOperand result; } call;
-        // Future: struct { TacOperand param; } param;
-    } operands;
+    uint8_t type;          // TacInstructionType
+    uint8_t operand_kinds; // TacOperandType of slot s in bits [2s, 2s + 1]
+    uint16_t reserved;     // Zero
+    uint32_t payloads[TAC_SLOT_COUNT];
 } TacInstruction;
 
+static inline TacOperandType tac_operand_kind(const TacInstruction *instr, const TacOperandSlot slot) {
+    return (TacOperandType) (instr->operand_kinds >> (slot * TAC_OPERAND_KIND_BITS) & TAC_OPERAND_KIND_MASK);
+}
+
+static inline TacOperand tac_get_operand(const TacInstruction *instr, const TacOperandSlot slot) {
+    TacOperand op;
+    op.type = tac_operand_kind(instr, slot);
+    op.value.label_id = instr->payloads[slot]; // Every union member is 32 bits wide
+    return op;
+}
+
+static inline void tac_set_operand(TacInstruction *instr, const TacOperandSlot slot, const TacOperand op) {
+    const unsigned shift = slot * TAC_OPERAND_KIND_BITS;
+    instr->operand_kinds = (uint8_t) ((instr->operand_kinds & ~(TAC_OPERAND_KIND_MASK << shift)) |
+                                      ((unsigned) op.type & TAC_OPERAND_KIND_MASK) << shift);
+    instr->payloads[slot] = op.value.label_id;
+}
+
+// Whether the operand in a slot is a temp (the test every pass makes before reading its id)
+static inline bool tac_slot_is_temp(const TacInstruction *instr, const TacOperandSlot slot) {
+    return tac_operand_kind(instr, slot) == TAC_OPERAND_TEMP;
+}
+
+// Named views of the slots
+static inline TacOperand tac_dst(const TacInstruction *instr) { return tac_get_operand(instr, TAC_SLOT_DST); }
+static inline TacOperand tac_src(const TacInstruction *instr) { return tac_get_operand(instr, TAC_SLOT_SRC1); }
+static inline TacOperand tac_src1(const TacInstruction *instr) { return tac_get_operand(instr, TAC_SLOT_SRC1); }
+static inline TacOperand tac_src2(const TacInstruction *instr) { return tac_get_operand(instr, TAC_SLOT_SRC2); }
+static inline TacOperand tac_label(const TacInstruction *instr) { return tac_get_operand(instr, TAC_SLOT_LABEL); }
+
 //------------------------------------------------------------------------------
 // Function & Program Structure
 //------------------------------------------------------------------------------
@@ -109,6 +147,7 @@ typedef struct {
     TacInstruction* instructions;    // Dynamic array of instructions
     size_t instruction_count;        // Number of instructions currently in the array
     size_t instruction_capacity;     // Allocated capacity of the array
+    size_t instruction_regrowths;    // Times a full array was copied into a larger one (the old one stays in the arena)
     // Future: Could add info about parameters, local variables, etc.
 } TacFunction;
 
@@ -126,7 +165,7 @@ typedef struct {
 // Operand creation
 TacOperand create_tac_operand_const(int value);
 TacOperand create_tac_operand_temp(int temp_id);
-TacOperand create_tac_operand_label(const char* name);
+TacOperand create_tac_operand_label(uint32_t label_id);
 
 // Instruction creation (simplified examples)
 TacInstruction* create_tac_instruction_copy(TacOperand dst, TacOperand src, Arena* arena);
@@ -162,10 +201,32 @@ TacInstruction* create_tac_instruction_goto(TacOperand target_label, Arena* aren
 TacInstruction* create_tac_instruction_if_false_goto(TacOperand condition_src, TacOperand target_label, Arena* arena);
 TacInstruction* create_tac_instruction_if_true_goto(TacOperand condition_src, TacOperand target_label, Arena* arena);
 
+// Operand access: what an instruction writes and reads (labels are neither)
+/**
+ * @brief Whether the instruction writes the operand in TAC_SLOT_DST (false for RETURN, jumps, labels).
+ */
+bool tac_instruction_has_def(const TacInstruction *instr);
+
+/**
+ * @brief Counts the value operands an instruction reads (constants included). They are in
+ *        the slots TAC_SLOT_SRC1 and, for a count of two, TAC_SLOT_SRC2.
+ */
+int tac_instruction_use_count(const TacInstruction *instr);
+
 // Function and Program manipulation
 TacFunction* create_tac_function(const char* name, Arena* arena);
 void add_instruction_to_function(TacFunction* func, const TacInstruction* instr, Arena* arena);
 
+/**
+ * @brief Makes room for at least `capacity` instructions, so that appending up to that many
+ *        copies nothing. Call it before the first instructions are added, when the size is
+ *        known or estimated: a later resize leaves the old array behind in the arena.
+ * @param func The function whose instruction array is sized.
+ * @param capacity The number of instructions to make room for (nothing happens if it already fits).
+ * @param arena The arena the function was created in.
+ */
+void tac_function_reserve(TacFunction* func, size_t capacity, Arena* arena);
+
 TacProgram* create_tac_program(Arena* arena);
 void add_function_to_program(TacProgram* prog, TacFunction* func, Arena* arena);
 
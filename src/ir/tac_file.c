@@ -0,0 +1,421 @@
+#include "tac_file.h"
+#include "../strings/interner.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// What an opcode keeps in a slot
+typedef enum {
+    SLOT_UNUSED, // Nothing: kind and payload are zero
+    SLOT_TEMP,   // The temp a definition writes
+    SLOT_VALUE,  // A constant or a temp that is read
+    SLOT_LABEL   // A label the instruction defines or jumps to
+} SlotShape;
+
+static SlotShape slot_shape(const TacInstruction *instr, const TacOperandSlot slot) {
+    if (slot == TAC_SLOT_DST) {
+        return tac_instruction_has_def(instr) ? SLOT_TEMP : SLOT_UNUSED;
+    }
+    const int use_count = tac_instruction_use_count(instr);
+    if (slot == TAC_SLOT_SRC1) {
+        return use_count >= 1 ? SLOT_VALUE : SLOT_UNUSED;
+    }
+    if (use_count == 2) {
+        return SLOT_VALUE;
+    }
+    switch (instr->type) {
+        case TAC_INS_LABEL:
+        case TAC_INS_GOTO:
+        case TAC_INS_IF_FALSE_GOTO:
+        case TAC_INS_IF_TRUE_GOTO:
+            return SLOT_LABEL;
+        default:
+            return SLOT_UNUSED;
+    }
+}
+
+// Writes `size` bytes, remembering a failure for the caller to report once
+static void write_bytes(FILE *out, const void *data, const size_t size, bool *ok) {
+    if (*ok && size > 0 && fwrite(data, 1, size, out) != size) {
+        *ok = false;
+    }
+}
+
+// Maps each id marked in `ranks` (nonzero) to its rank among the marked ids, in place
+static void rank_ids(uint32_t *ranks, const size_t count) {
+    uint32_t next = 0;
+    for (size_t id = 0; id < count; ++id) {
+        ranks[id] = ranks[id] ? next++ : 0;
+    }
+}
+
+// The bounds the loader puts on a function's temp and label ids: every temp is in one of the slots and
+// every label is defined by a LABEL instruction
+static size_t temp_id_limit(const size_t instruction_count) {
+    return instruction_count * TAC_SLOT_COUNT < INT32_MAX ? instruction_count * TAC_SLOT_COUNT : INT32_MAX;
+}
+
+// Writes a function's instructions with the slots their opcodes leave unused cleared. The optimizer
+// leaves gaps in the temp and label ids; if those push the ids past the loader's bounds, both are
+// renumbered densely, keeping their order. Returns false only if the renumbering tables could not be
+// allocated.
+static bool write_instructions(FILE *out, const TacFunction *func, bool *ok) {
+    size_t temp_limit = 0;
+    size_t label_limit = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        for (int slot = 0; slot < TAC_SLOT_COUNT; ++slot) {
+            const SlotShape shape = slot_shape(instr, (TacOperandSlot) slot);
+            const TacOperandType kind = tac_operand_kind(instr, (TacOperandSlot) slot);
+            const size_t id = instr->payloads[slot];
+            if (shape != SLOT_UNUSED && kind == TAC_OPERAND_TEMP && id >= temp_limit) {
+                temp_limit = id + 1;
+            } else if (shape == SLOT_LABEL && kind == TAC_OPERAND_LABEL && id >= label_limit) {
+                label_limit = id + 1;
+            }
+        }
+    }
+    const bool renumber = temp_limit > temp_id_limit(func->instruction_count) ||
+                          label_limit > func->instruction_count;
+    uint32_t *temp_ranks = renumber ? calloc(temp_limit + 1, sizeof(uint32_t)) : NULL;
+    uint32_t *label_ranks = renumber ? calloc(label_limit + 1, sizeof(uint32_t)) : NULL;
+    if (renumber && (!temp_ranks || !label_ranks)) {
+        free(temp_ranks);
+        free(label_ranks);
+        return false;
+    }
+    for (size_t i = 0; renumber && i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        for (int slot = 0; slot < TAC_SLOT_COUNT; ++slot) {
+            const SlotShape shape = slot_shape(instr, (TacOperandSlot) slot);
+            const TacOperandType kind = tac_operand_kind(instr, (TacOperandSlot) slot);
+            if (shape != SLOT_UNUSED && kind == TAC_OPERAND_TEMP) {
+                temp_ranks[instr->payloads[slot]] = 1;
+            } else if (shape == SLOT_LABEL && kind == TAC_OPERAND_LABEL) {
+                label_ranks[instr->payloads[slot]] = 1;
+            }
+        }
+    }
+    if (renumber) {
+        rank_ids(temp_ranks, temp_limit);
+        rank_ids(label_ranks, label_limit);
+    }
+
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        TacInstruction written = {.type = instr->type};
+        for (int slot = 0; slot < TAC_SLOT_COUNT; ++slot) {
+            const SlotShape shape = slot_shape(instr, (TacOperandSlot) slot);
+            if (shape == SLOT_UNUSED) {
+                continue;
+            }
+            TacOperand op = tac_get_operand(instr, (TacOperandSlot) slot);
+            if (renumber && op.type == TAC_OPERAND_TEMP) {
+                op.value.temp_id = (int) temp_ranks[op.value.temp_id];
+            } else if (renumber && op.type == TAC_OPERAND_LABEL) {
+                op.value.label_id = label_ranks[op.value.label_id];
+            }
+            tac_set_operand(&written, (TacOperandSlot) slot, op);
+        }
+        write_bytes(out, &written, sizeof(written), ok);
+    }
+    free(temp_ranks);
+    free(label_ranks);
+    return true;
+}
+
+bool tac_file_write(const TacProgram *program, const char *filename) {
+    if (program->function_count > UINT32_MAX) {
+        fprintf(stderr, "TAC File Error: Too many functions for one module\n");
+        return false;
+    }
+    TacFileHeader header = {.version = TAC_FILE_VERSION, .byte_order = TAC_FILE_BYTE_ORDER,
+                            .function_count = (uint32_t) program->function_count};
+    memcpy(header.magic, TAC_FILE_MAGIC, sizeof(header.magic));
+    header.strings_offset = sizeof(TacFileHeader) + program->function_count * sizeof(TacFileFunction);
+    for (size_t i = 0; i < program->function_count; ++i) {
+        header.strings_size += strlen(program->functions[i]->name) + 1;
+        header.instruction_count += program->functions[i]->instruction_count;
+    }
+    if (header.strings_size > UINT32_MAX) {
+        fprintf(stderr, "TAC File Error: The function names do not fit in one module\n");
+        return false;
+    }
+    const uint64_t strings_end = header.strings_offset + header.strings_size;
+    header.instructions_offset = (strings_end + TAC_FILE_ALIGNMENT - 1) & ~(uint64_t) (TAC_FILE_ALIGNMENT - 1);
+
+    FILE *out = fopen(filename, "wb");
+    if (!out) {
+        perror("Failed to open file for writing");
+        fprintf(stderr, "Filename: %s\n", filename);
+        return false;
+    }
+    bool ok = true;
+    write_bytes(out, &header, sizeof(header), &ok);
+    uint64_t first_instruction = 0;
+    uint32_t name_offset = 0;
+    for (size_t i = 0; i < program->function_count; ++i) {
+        const TacFunction *func = program->functions[i];
+        const TacFileFunction record = {.first_instruction = first_instruction,
+                                        .instruction_count = func->instruction_count,
+                                        .name_offset = name_offset};
+        write_bytes(out, &record, sizeof(record), &ok);
+        first_instruction += func->instruction_count;
+        name_offset += (uint32_t) strlen(func->name) + 1;
+    }
+    for (size_t i = 0; i < program->function_count; ++i) {
+        const char *name = program->functions[i]->name;
+        write_bytes(out, name, strlen(name) + 1, &ok);
+    }
+    static const char padding[TAC_FILE_ALIGNMENT] = {0};
+    write_bytes(out, padding, (size_t) (header.instructions_offset - strings_end), &ok);
+    bool renumbered = true;
+    for (size_t i = 0; renumbered && i < program->function_count; ++i) {
+        renumbered = write_instructions(out, program->functions[i], &ok);
+    }
+    if (fclose(out) != 0) {
+        ok = false;
+    }
+    if (!renumbered) {
+        fprintf(stderr, "TAC File Error: Out of memory writing %s\n", filename);
+    } else if (!ok) {
+        fprintf(stderr, "TAC File Error: Failed to write %s\n", filename);
+    }
+    if (!renumbered || !ok) {
+        remove(filename);
+    }
+    return renumbered && ok;
+}
+
+// Whether an operand fits the slot's shape; temps are below temp_limit and labels below label_limit
+static bool operand_valid(const TacInstruction *instr, const TacOperandSlot slot, const size_t temp_limit,
+                          const size_t label_limit) {
+    const TacOperandType kind = tac_operand_kind(instr, slot);
+    const uint32_t payload = instr->payloads[slot];
+    switch (slot_shape(instr, slot)) {
+        case SLOT_UNUSED:
+            return kind == TAC_OPERAND_CONST && payload == 0;
+        case SLOT_VALUE:
+            if (kind == TAC_OPERAND_CONST) {
+                return true;
+            }
+            // Fall through: any other value is a temp
+        case SLOT_TEMP:
+            return kind == TAC_OPERAND_TEMP && payload < temp_limit;
+        case SLOT_LABEL:
+            return kind == TAC_OPERAND_LABEL && payload < label_limit;
+    }
+    return false;
+}
+
+// Checks one function's instructions: known opcodes, operands of the kinds each opcode takes, temps
+// and labels numbered below what the instruction count allows (as tac_file_write numbers them), each
+// label defined once and every jump aimed at one of them. Returns false if anything is off, or if the
+// table of defined labels could not be allocated (*out_of_memory is then set).
+static bool function_valid(const TacInstruction *instructions, const size_t count, Arena *arena,
+                           bool *out_of_memory) {
+    const size_t temp_limit = temp_id_limit(count);
+    const size_t label_limit = count;
+    for (size_t i = 0; i < count; ++i) {
+        const TacInstruction *instr = &instructions[i];
+        if (instr->type > TAC_INS_IF_TRUE_GOTO || instr->reserved != 0 ||
+            instr->operand_kinds >> (TAC_SLOT_COUNT * TAC_OPERAND_KIND_BITS) != 0) {
+            return false;
+        }
+        for (int slot = 0; slot < TAC_SLOT_COUNT; ++slot) {
+            if (!operand_valid(instr, (TacOperandSlot) slot, temp_limit, label_limit)) {
+                return false;
+            }
+        }
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    const ArenaMark mark = arena_mark(arena);
+    bool *defined = arena_alloc_zeroed(arena, count * sizeof(bool));
+    if (!defined) {
+        *out_of_memory = true;
+        return false;
+    }
+    bool valid = true;
+    for (size_t i = 0; valid && i < count; ++i) {
+        if (instructions[i].type == TAC_INS_LABEL) {
+            const uint32_t label = instructions[i].payloads[TAC_SLOT_LABEL];
+            valid = !defined[label];
+            defined[label] = true;
+        }
+    }
+    for (size_t i = 0; valid && i < count; ++i) {
+        if (instructions[i].type != TAC_INS_LABEL && slot_shape(&instructions[i], TAC_SLOT_LABEL) == SLOT_LABEL) {
+            valid = defined[instructions[i].payloads[TAC_SLOT_LABEL]];
+        }
+    }
+    arena_release(arena, mark);
+    return valid;
+}
+
+// Checks the layout of a mapped module; returns its instruction array, or NULL if anything is out of place
+static const TacInstruction *check_module(const char *data, const size_t size) {
+    if (size < sizeof(TacFileHeader)) {
+        return NULL;
+    }
+    TacFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, TAC_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != TAC_FILE_VERSION ||
+        header.byte_order != TAC_FILE_BYTE_ORDER) {
+        return NULL;
+    }
+    const uint64_t table_end = sizeof(TacFileHeader) + (uint64_t) header.function_count * sizeof(TacFileFunction);
+    if (table_end > size || header.strings_offset < table_end || header.strings_offset > size ||
+        header.strings_size > size - header.strings_offset) {
+        return NULL;
+    }
+    // A terminated table makes every name offset inside it a terminated string
+    if (header.function_count > 0 &&
+        (header.strings_size == 0 || data[header.strings_offset + header.strings_size - 1] != '\0')) {
+        return NULL;
+    }
+    if (header.instructions_offset % TAC_FILE_ALIGNMENT != 0 ||
+        header.instructions_offset < header.strings_offset + header.strings_size ||
+        header.instructions_offset > size ||
+        header.instruction_count > (size - header.instructions_offset) / sizeof(TacInstruction)) {
+        return NULL;
+    }
+    // The functions' instructions follow each other, as tac_file_write lays them out: no two share any
+    const TacFileFunction *records = (const TacFileFunction *) (data + sizeof(TacFileHeader));
+    uint64_t next_instruction = 0;
+    for (uint32_t i = 0; i < header.function_count; ++i) {
+        const TacFileFunction *record = &records[i];
+        if (record->name_offset >= header.strings_size || record->reserved != 0 ||
+            record->first_instruction != next_instruction ||
+            record->instruction_count > header.instruction_count - record->first_instruction) {
+            return NULL;
+        }
+        next_instruction += record->instruction_count;
+    }
+    if (next_instruction != header.instruction_count) {
+        return NULL;
+    }
+    return (const TacInstruction *) (data + header.instructions_offset);
+}
+
+// The file that defined function `index` of the program
+static const char *function_origin(const size_t index, const TacModule *loaded, const size_t loaded_count) {
+    for (size_t m = 0; m < loaded_count; ++m) {
+        if (index >= loaded[m].first_function && index - loaded[m].first_function < loaded[m].function_count) {
+            return loaded[m].filename;
+        }
+    }
+    return "the program";
+}
+
+// Reports the first name of the module that the program, or an earlier function of the module, defines already
+static bool names_are_new(const char *filename, const TacProgram *program, const char *data,
+                          const TacFileHeader *header, const TacModule *loaded, const size_t loaded_count,
+                          Arena *arena) {
+    const TacFileFunction *records = (const TacFileFunction *) (data + sizeof(TacFileHeader));
+    const ArenaMark mark = arena_mark(arena);
+    StringInterner names;
+    bool ok = interner_init(&names, arena, program->function_count + header->function_count);
+    for (size_t i = 0; ok && i < program->function_count; ++i) {
+        ok = interner_intern(&names, program->functions[i]->name) != NULL;
+    }
+    if (!ok) {
+        fprintf(stderr, "TAC File Error: Out of memory loading %s\n", filename);
+        arena_release(arena, mark);
+        return false;
+    }
+    for (uint32_t i = 0; i < header->function_count; ++i) {
+        const char *name = data + header->strings_offset + records[i].name_offset;
+        const size_t length = strlen(name);
+        if (interner_find_n(&names, name, length)) {
+            const char *other = filename; // Unless an earlier module has it
+            for (size_t f = 0; f < program->function_count; ++f) {
+                if (strcmp(program->functions[f]->name, name) == 0) {
+                    other = function_origin(f, loaded, loaded_count);
+                    break;
+                }
+            }
+            fprintf(stderr, "TAC File Error: %s defined in both %s and %s\n", name, other, filename);
+            arena_release(arena, mark);
+            return false;
+        }
+        if (!interner_intern_n(&names, name, length)) {
+            fprintf(stderr, "TAC File Error: Out of memory loading %s\n", filename);
+            arena_release(arena, mark);
+            return false;
+        }
+    }
+    arena_release(arena, mark);
+    return true;
+}
+
+bool tac_file_load(const char *filename, TacProgram *program, const TacModule *loaded, const size_t loaded_count,
+                   Arena *arena, TacModule *out_module) {
+    *out_module = (TacModule){0};
+    MappedFile file;
+    if (!map_entire_file_writable(filename, &file)) {
+        fprintf(stderr, "TAC File Error: Failed to read %s\n", filename);
+        return false;
+    }
+    // Mappings are page aligned and malloc's blocks suit any type, so the records and instructions are aligned
+    char *data = (char *) file.data;
+    TacInstruction *instructions = (TacInstruction *) check_module(data, file.size);
+    if (!instructions) {
+        fprintf(stderr, "TAC File Error: %s is not a TAC module of this version of cleric\n", filename);
+        unmap_file(&file);
+        return false;
+    }
+    TacFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    const TacFileFunction *records = (const TacFileFunction *) (data + sizeof(TacFileHeader));
+    for (uint32_t i = 0; i < header.function_count; ++i) {
+        bool out_of_memory = false;
+        if (!function_valid(instructions + records[i].first_instruction, (size_t) records[i].instruction_count,
+                            arena, &out_of_memory)) {
+            if (out_of_memory) {
+                fprintf(stderr, "TAC File Error: Out of memory loading %s\n", filename);
+            } else {
+                fprintf(stderr, "TAC File Error: Function %s in %s has malformed instructions\n",
+                        data + header.strings_offset + records[i].name_offset, filename);
+            }
+            unmap_file(&file);
+            return false;
+        }
+    }
+    if (!names_are_new(filename, program, data, &header, loaded, loaded_count, arena)) {
+        unmap_file(&file);
+        return false;
+    }
+    const size_t first_function = program->function_count;
+    TacFunction *functions = header.function_count > 0
+                                 ? arena_alloc_tagged(arena, header.function_count * sizeof(TacFunction),
+                                                      ARENA_TAG_TAC)
+                                 : NULL;
+    if (header.function_count > 0 && !functions) {
+        fprintf(stderr, "TAC File Error: Out of memory loading %s\n", filename);
+        unmap_file(&file);
+        return false;
+    }
+    for (uint32_t i = 0; i < header.function_count; ++i) {
+        TacFunction *func = &functions[i];
+        func->name = data + header.strings_offset + records[i].name_offset;
+        func->instructions = instructions + records[i].first_instruction;
+        func->instruction_count = (size_t) records[i].instruction_count;
+        func->instruction_capacity = func->instruction_count; // Appending moves the array into the arena
+        func->instruction_regrowths = 0;
+        add_function_to_program(program, func, arena);
+    }
+    out_module->file = file;
+    out_module->filename = filename;
+    out_module->first_function = first_function;
+    out_module->function_count = header.function_count;
+    out_module->instruction_count = (size_t) header.instruction_count;
+    return true;
+}
+
+void tac_file_unload(TacModule *module) {
+    unmap_file(&module->file);
+    *module = (TacModule){0};
+}
@@ -0,0 +1,102 @@
+#ifndef CLERIC_TAC_FILE_H
+#define CLERIC_TAC_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "tac.h"
+#include "../files/files.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Binary TAC modules (.ctac)
+//
+// `cleric --emit-tac prog.c` stops after IR generation (and the TAC optimizer
+// at -O1) and writes the program to prog.ctac; `cleric a.ctac b.ctac ...`
+// loads the modules into one TacProgram, optimizes it and generates code for it
+// once. Reloading a module skips lexing, parsing, validation and lowering.
+// A function name defined by two modules is reported when the second is loaded.
+//
+// The file is laid out so a load needs no decoding: the 16-byte TacInstruction
+// is stored as is, and function names are null-terminated strings, so a
+// loaded TacFunction points straight into the copy-on-write mapping of the file
+// (map_entire_file_writable). Passes that rewrite instructions in place only
+// copy the pages they touch.
+//
+// A damaged or forged file is rejected, never run. Loading checks the header
+// and every offset, and then each function's instructions:
+// - every opcode is known;
+// - every operand is of a kind its opcode takes, and unused slots are zero;
+// - temps and labels are numbered below the bounds the instruction count
+//   allows (the writer renumbers both densely when they do not fit);
+// - every label is defined once, and every jump goes to one of them.
+//
+//   TacFileHeader
+//   TacFileFunction[function_count]
+//   string table (names, each null-terminated)
+//   padding to TAC_FILE_ALIGNMENT
+//   TacInstruction[instruction_count] (every function's, one after the other)
+//
+// Numbers are in the byte order of the machine that wrote the file; a module
+// from a machine of the other order is rejected (byte_order reads differently).
+//------------------------------------------------------------------------------
+
+#define TAC_FILE_MAGIC "CTAC"
+#define TAC_FILE_VERSION 1u             // Bumped whenever TacInstruction or the opcodes change
+#define TAC_FILE_BYTE_ORDER 0x01020304u
+#define TAC_FILE_ALIGNMENT 16           // Of the instruction array within the file
+
+typedef struct {
+    char magic[4];                // TAC_FILE_MAGIC, not terminated
+    uint32_t version;             // TAC_FILE_VERSION
+    uint32_t byte_order;          // TAC_FILE_BYTE_ORDER as the writer stored it
+    uint32_t function_count;
+    uint64_t strings_offset;      // From the start of the file
+    uint64_t strings_size;
+    uint64_t instructions_offset; // A multiple of TAC_FILE_ALIGNMENT
+    uint64_t instruction_count;   // Over all functions
+} TacFileHeader;
+
+typedef struct {
+    uint64_t first_instruction;   // Index into the instruction array
+    uint64_t instruction_count;
+    uint32_t name_offset;         // Into the string table
+    uint32_t reserved;            // Zero
+} TacFileFunction;
+
+// A loaded module: its functions point into the mapping, which must outlive them
+typedef struct {
+    MappedFile file;
+    const char *filename;         // As passed to tac_file_load (not copied)
+    size_t first_function;        // Index of the module's first function in the program it was loaded into
+    size_t function_count;
+    size_t instruction_count;
+} TacModule;
+
+/**
+ * @brief Writes a program as a .ctac module.
+ * @return false (with an error printed) if the file could not be written.
+ */
+bool tac_file_write(const TacProgram *program, const char *filename);
+
+/**
+ * @brief Maps a .ctac module and appends its functions to a program.
+ * @param filename The module.
+ * @param program Receives the functions, after those already in it.
+ * @param loaded The modules already loaded into program, to name the file of a duplicate (may be NULL).
+ * @param loaded_count Number of entries in loaded.
+ * @param arena Arena for the TacFunction structs (the instructions and names stay in the mapping).
+ * @param out_module Receives the mapping; release it with tac_file_unload once the program is done with.
+ * @return false (with an error printed) if the file is not a valid module or defines a function the
+ *         program already has; nothing is then appended.
+ */
+bool tac_file_load(const char *filename, TacProgram *program, const TacModule *loaded, size_t loaded_count,
+                   Arena *arena, TacModule *out_module);
+
+/**
+ * @brief Releases the mapping of a module loaded with tac_file_load.
+ */
+void tac_file_unload(TacModule *module);
+
+#endif // CLERIC_TAC_FILE_H
@@ -0,0 +1,282 @@
+#include "tac_interpreter.h"
+#include "liveness.h"
+#include <stdio.h>
+#include <string.h>
+
+// Handlers are threaded through label addresses where the compiler supports them
+#if defined(__GNUC__)
+#define TAC_INTERPRETER_COMPUTED_GOTO 1
+#endif
+
+// Decoded opcodes; GREATER and GREATER_EQUAL become LESS and LESS_EQUAL with swapped operands
+typedef enum {
+    INTERP_COPY,
+    INTERP_NEGATE,
+    INTERP_COMPLEMENT,
+    INTERP_LOGICAL_NOT,
+    INTERP_ADD,
+    INTERP_SUB,
+    INTERP_MUL,
+    INTERP_DIV,
+    INTERP_MOD,
+    INTERP_LOGICAL_AND,
+    INTERP_LOGICAL_OR,
+    INTERP_LESS,
+    INTERP_LESS_EQUAL,
+    INTERP_EQUAL,
+    INTERP_NOT_EQUAL,
+    INTERP_GOTO,
+    INTERP_IF_FALSE_GOTO,
+    INTERP_IF_TRUE_GOTO,
+    INTERP_RETURN,
+    INTERP_OPCODE_COUNT
+} InterpreterOpcode;
+
+static bool decode_opcode(const TacInstructionType type, InterpreterOpcode *out, bool *swap) {
+    *swap = false;
+    switch (type) {
+        case TAC_INS_COPY: *out = INTERP_COPY; return true;
+        case TAC_INS_NEGATE: *out = INTERP_NEGATE; return true;
+        case TAC_INS_COMPLEMENT: *out = INTERP_COMPLEMENT; return true;
+        case TAC_INS_LOGICAL_NOT: *out = INTERP_LOGICAL_NOT; return true;
+        case TAC_INS_ADD: *out = INTERP_ADD; return true;
+        case TAC_INS_SUB: *out = INTERP_SUB; return true;
+        case TAC_INS_MUL: *out = INTERP_MUL; return true;
+        case TAC_INS_DIV: *out = INTERP_DIV; return true;
+        case TAC_INS_MOD: *out = INTERP_MOD; return true;
+        case TAC_INS_LOGICAL_AND: *out = INTERP_LOGICAL_AND; return true;
+        case TAC_INS_LOGICAL_OR: *out = INTERP_LOGICAL_OR; return true;
+        case TAC_INS_LESS: *out = INTERP_LESS; return true;
+        case TAC_INS_LESS_EQUAL: *out = INTERP_LESS_EQUAL; return true;
+        case TAC_INS_GREATER: *out = INTERP_LESS; *swap = true; return true;
+        case TAC_INS_GREATER_EQUAL: *out = INTERP_LESS_EQUAL; *swap = true; return true;
+        case TAC_INS_EQUAL: *out = INTERP_EQUAL; return true;
+        case TAC_INS_NOT_EQUAL: *out = INTERP_NOT_EQUAL; return true;
+        case TAC_INS_GOTO: *out = INTERP_GOTO; return true;
+        case TAC_INS_IF_FALSE_GOTO: *out = INTERP_IF_FALSE_GOTO; return true;
+        case TAC_INS_IF_TRUE_GOTO: *out = INTERP_IF_TRUE_GOTO; return true;
+        case TAC_INS_RETURN: *out = INTERP_RETURN; return true;
+        default: return false;
+    }
+}
+
+// Register of a value operand: the temp's own slot, or a fresh constant slot past the temps
+static uint32_t operand_register(const TacInstruction *instr, const TacOperandSlot slot,
+                                 TacInterpretedFunction *out, uint32_t *next_constant) {
+    const TacOperand op = tac_get_operand(instr, slot);
+    if (op.type == TAC_OPERAND_TEMP) {
+        return (uint32_t) op.value.temp_id;
+    }
+    out->initial_registers[*next_constant] = op.value.constant_value;
+    return (*next_constant)++;
+}
+
+bool tac_interpreter_decode(const TacFunction *func, Arena *arena, TacInterpretedFunction *out) {
+    *out = (TacInterpretedFunction){.name = func->name};
+
+    // First pass: size the stream, the constant slots and the label table
+    size_t count = 0;
+    size_t constant_count = 1; // The 0 returned by the end sentinel
+    uint32_t label_bound = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (instr->type == TAC_INS_LABEL) {
+            const uint32_t label = tac_label(instr).value.label_id;
+            if (label != TAC_NO_LABEL && label >= label_bound) {
+                label_bound = label + 1;
+            }
+            continue;
+        }
+        count++;
+        const int use_count = tac_instruction_use_count(instr);
+        for (int u = 0; u < use_count; ++u) {
+            constant_count += tac_operand_kind(instr, (TacOperandSlot) (TAC_SLOT_SRC1 + u)) == TAC_OPERAND_CONST;
+        }
+    }
+    const uint32_t temp_count = (uint32_t) tac_function_temp_count(func);
+    out->register_count = temp_count + constant_count;
+    out->count = count;
+    out->code = arena_alloc(arena, (count + 1) * sizeof(TacInterpretedInstruction));
+    out->initial_registers = arena_alloc(arena, out->register_count * sizeof(int32_t));
+    out->registers = arena_alloc(arena, out->register_count * sizeof(int32_t));
+    uint32_t *label_targets = arena_alloc(arena, ((size_t) label_bound + 1) * sizeof(uint32_t));
+    if (!out->code || !out->initial_registers || !out->registers || !label_targets) {
+        fprintf(stderr, "Interpreter Error: Out of memory decoding function %s.\n", func->name);
+        return false;
+    }
+    memset(out->initial_registers, 0, out->register_count * sizeof(int32_t));
+    for (uint32_t label = 0; label < label_bound; ++label) {
+        label_targets[label] = UINT32_MAX;
+    }
+    size_t position = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        if (func->instructions[i].type == TAC_INS_LABEL) {
+            const uint32_t label = tac_label(&func->instructions[i]).value.label_id;
+            if (label != TAC_NO_LABEL) {
+                label_targets[label] = (uint32_t) position;
+            }
+        } else {
+            position++;
+        }
+    }
+
+    // Second pass: emit the stream with operands resolved to registers and labels to positions
+    uint32_t next_constant = temp_count + 1; // Slot temp_count holds the sentinel's 0
+    position = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (instr->type == TAC_INS_LABEL) {
+            continue;
+        }
+        TacInterpretedInstruction *decoded = &out->code[position++];
+        InterpreterOpcode opcode;
+        bool swap;
+        if (!decode_opcode((TacInstructionType) instr->type, &opcode, &swap)) {
+            fprintf(stderr, "Interpreter Error: Unknown TAC instruction type %d in function %s.\n", instr->type,
+                    func->name);
+            return false;
+        }
+        *decoded = (TacInterpretedInstruction){.opcode = opcode};
+        if (tac_instruction_has_def(instr)) {
+            decoded->dst = (uint32_t) tac_dst(instr).value.temp_id;
+        }
+        const int use_count = tac_instruction_use_count(instr);
+        if (use_count >= 1) {
+            decoded->a = operand_register(instr, TAC_SLOT_SRC1, out, &next_constant);
+        }
+        if (use_count == 2) {
+            decoded->b = operand_register(instr, TAC_SLOT_SRC2, out, &next_constant);
+        }
+        if (swap) {
+            const uint32_t a = decoded->a;
+            decoded->a = decoded->b;
+            decoded->b = a;
+        }
+        if (opcode == INTERP_GOTO || opcode == INTERP_IF_FALSE_GOTO || opcode == INTERP_IF_TRUE_GOTO) {
+            const uint32_t label = tac_label(instr).value.label_id;
+            if (label >= label_bound || label_targets[label] == UINT32_MAX) {
+                fprintf(stderr, "Interpreter Error: Jump to undefined label L%u in function %s.\n", label,
+                        func->name);
+                return false;
+            }
+            decoded->b = label_targets[label];
+        }
+    }
+    out->code[count] = (TacInterpretedInstruction){.opcode = INTERP_RETURN, .a = temp_count};
+    return true;
+}
+
+bool tac_interpreter_run(TacInterpretedFunction *function, int *out_result) {
+    int32_t *const r = function->registers;
+    memcpy(r, function->initial_registers, function->register_count * sizeof(int32_t));
+    const TacInterpretedInstruction *const code = function->code;
+    const TacInterpretedInstruction *ip = code;
+
+#ifdef TAC_INTERPRETER_COMPUTED_GOTO
+    static const void *const handlers[INTERP_OPCODE_COUNT] = {
+            [INTERP_COPY] = &&op_INTERP_COPY,
+            [INTERP_NEGATE] = &&op_INTERP_NEGATE,
+            [INTERP_COMPLEMENT] = &&op_INTERP_COMPLEMENT,
+            [INTERP_LOGICAL_NOT] = &&op_INTERP_LOGICAL_NOT,
+            [INTERP_ADD] = &&op_INTERP_ADD,
+            [INTERP_SUB] = &&op_INTERP_SUB,
+            [INTERP_MUL] = &&op_INTERP_MUL,
+            [INTERP_DIV] = &&op_INTERP_DIV,
+            [INTERP_MOD] = &&op_INTERP_MOD,
+            [INTERP_LOGICAL_AND] = &&op_INTERP_LOGICAL_AND,
+            [INTERP_LOGICAL_OR] = &&op_INTERP_LOGICAL_OR,
+            [INTERP_LESS] = &&op_INTERP_LESS,
+            [INTERP_LESS_EQUAL] = &&op_INTERP_LESS_EQUAL,
+            [INTERP_EQUAL] = &&op_INTERP_EQUAL,
+            [INTERP_NOT_EQUAL] = &&op_INTERP_NOT_EQUAL,
+            [INTERP_GOTO] = &&op_INTERP_GOTO,
+            [INTERP_IF_FALSE_GOTO] = &&op_INTERP_IF_FALSE_GOTO,
+            [INTERP_IF_TRUE_GOTO] = &&op_INTERP_IF_TRUE_GOTO,
+            [INTERP_RETURN] = &&op_INTERP_RETURN,
+    };
+    if (!function->threaded) {
+        for (size_t i = 0; i <= function->count; ++i) {
+            function->code[i].handler = handlers[function->code[i].opcode];
+        }
+        function->threaded = true;
+    }
+#define HANDLER(opcode) op_##opcode:
+#define DISPATCH() goto *ip->handler
+#else
+#define HANDLER(opcode) case opcode:
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT() do { ++ip; DISPATCH(); } while (0)
+#define JUMP(target) do { ip = code + (target); DISPATCH(); } while (0)
+// Wrapping arithmetic, as the 32-bit machine instructions do
+#define WRAP(expression) ((int32_t) (uint32_t) (expression))
+
+#ifdef TAC_INTERPRETER_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch ((InterpreterOpcode) ip->opcode) {
+#endif
+    HANDLER(INTERP_COPY) r[ip->dst] = r[ip->a]; NEXT();
+    HANDLER(INTERP_NEGATE) r[ip->dst] = WRAP(0u - (uint32_t) r[ip->a]); NEXT();
+    HANDLER(INTERP_COMPLEMENT) r[ip->dst] = ~r[ip->a]; NEXT();
+    HANDLER(INTERP_LOGICAL_NOT) r[ip->dst] = r[ip->a] == 0; NEXT();
+    HANDLER(INTERP_ADD) r[ip->dst] = WRAP((uint32_t) r[ip->a] + (uint32_t) r[ip->b]); NEXT();
+    HANDLER(INTERP_SUB) r[ip->dst] = WRAP((uint32_t) r[ip->a] - (uint32_t) r[ip->b]); NEXT();
+    HANDLER(INTERP_MUL) r[ip->dst] = WRAP((uint32_t) r[ip->a] * (uint32_t) r[ip->b]); NEXT();
+    HANDLER(INTERP_DIV)
+        if (r[ip->b] == 0 || (r[ip->a] == INT32_MIN && r[ip->b] == -1)) goto trap;
+        r[ip->dst] = r[ip->a] / r[ip->b];
+        NEXT();
+    HANDLER(INTERP_MOD)
+        if (r[ip->b] == 0 || (r[ip->a] == INT32_MIN && r[ip->b] == -1)) goto trap;
+        r[ip->dst] = r[ip->a] % r[ip->b];
+        NEXT();
+    HANDLER(INTERP_LOGICAL_AND) r[ip->dst] = r[ip->a] != 0 && r[ip->b] != 0; NEXT();
+    HANDLER(INTERP_LOGICAL_OR) r[ip->dst] = r[ip->a] != 0 || r[ip->b] != 0; NEXT();
+    HANDLER(INTERP_LESS) r[ip->dst] = r[ip->a] < r[ip->b]; NEXT();
+    HANDLER(INTERP_LESS_EQUAL) r[ip->dst] = r[ip->a] <= r[ip->b]; NEXT();
+    HANDLER(INTERP_EQUAL) r[ip->dst] = r[ip->a] == r[ip->b]; NEXT();
+    HANDLER(INTERP_NOT_EQUAL) r[ip->dst] = r[ip->a] != r[ip->b]; NEXT();
+    HANDLER(INTERP_GOTO) JUMP(ip->b);
+    HANDLER(INTERP_IF_FALSE_GOTO) if (r[ip->a] == 0) JUMP(ip->b); NEXT();
+    HANDLER(INTERP_IF_TRUE_GOTO) if (r[ip->a] != 0) JUMP(ip->b); NEXT();
+    HANDLER(INTERP_RETURN)
+        *out_result = r[ip->a];
+        return true;
+#ifndef TAC_INTERPRETER_COMPUTED_GOTO
+        case INTERP_OPCODE_COUNT:
+            break;
+    }
+    fprintf(stderr, "Interpreter Error: Corrupt instruction stream in function %s.\n", function->name);
+    return false;
+#endif
+
+trap:
+    fprintf(stderr, "Interpreter Error: Division by zero or overflow in function %s.\n", function->name);
+    return false;
+
+#undef WRAP
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
+#undef HANDLER
+}
+
+bool tac_interpret_program(const TacProgram *program, const char *entry_name, Arena *scratch, int *out_result) {
+    const TacFunction *entry = NULL;
+    for (size_t i = 0; program && i < program->function_count && !entry; ++i) {
+        if (program->functions[i]->name && strcmp(program->functions[i]->name, entry_name) == 0) {
+            entry = program->functions[i];
+        }
+    }
+    if (!entry) {
+        fprintf(stderr, "Interpreter Error: No function named %s to run.\n", entry_name);
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+    TacInterpretedFunction decoded;
+    const bool success = tac_interpreter_decode(entry, scratch, &decoded) && tac_interpreter_run(&decoded, out_result);
+    arena_release(scratch, mark);
+    return success;
+}
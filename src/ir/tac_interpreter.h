@@ -0,0 +1,72 @@
+#ifndef CLERIC_TAC_INTERPRETER_H
+#define CLERIC_TAC_INTERPRETER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Direct-threaded interpreter for TAC
+//
+// tac_interpreter_decode turns a function into a flat stream of three-index
+// instructions: every temp and every constant becomes a slot of one int32
+// register file (constants are preloaded into the slots past the temps), labels
+// disappear and jumps hold the index of the instruction they reach. `a > b` and
+// `a >= b` are decoded as `b < a` and `b <= a`. The first run replaces every
+// opcode by the address of its handler (computed goto with GCC and Clang, a
+// switch elsewhere), so dispatch is one indirect jump per instruction.
+// Arithmetic wraps around in 32 bits as the generated code does; a division by
+// zero (or of INT_MIN by -1) stops the run with an error where the native code
+// would trap. No assembler, linker or x86-64 host is involved.
+//------------------------------------------------------------------------------
+
+// One decoded instruction: register file indices, or the target index for a jump
+typedef struct {
+    const void *handler; // Threaded handler, or NULL before the first run
+    uint32_t opcode;     // Decoded opcode (private to tac_interpreter.c)
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
+} TacInterpretedInstruction;
+
+typedef struct {
+    const char *name;
+    TacInterpretedInstruction *code; // Ends with an instruction returning 0, for running off the end
+    size_t count;
+    int32_t *initial_registers;      // Temps zeroed, then the constants
+    int32_t *registers;              // Working copy, reset by every run
+    size_t register_count;
+    bool threaded;
+} TacInterpretedFunction;
+
+/**
+ * @brief Decodes a function for running it any number of times.
+ * @param func The function; its labels must all be defined.
+ * @param arena Arena for the instruction stream and the register file.
+ * @param out Receives the decoded function.
+ * @return false (with an error printed) on an undefined label or if memory ran out.
+ */
+bool tac_interpreter_decode(const TacFunction *func, Arena *arena, TacInterpretedFunction *out);
+
+/**
+ * @brief Runs a decoded function from its first instruction. Not reentrant: a function has one
+ *        register file.
+ * @param function The decoded function.
+ * @param out_result Receives the returned value (0 when the end is reached without a return).
+ * @return false (with an error printed) if the run stopped on a division trap.
+ */
+bool tac_interpreter_run(TacInterpretedFunction *function, int *out_result);
+
+/**
+ * @brief Decodes and runs a function of a program by name.
+ * @param program The program.
+ * @param entry_name The function to run (e.g. "main").
+ * @param scratch Arena for the decoded function (released before returning).
+ * @param out_result Receives the returned value.
+ * @return false (with an error printed) if the function is missing, could not be decoded, or trapped.
+ */
+bool tac_interpret_program(const TacProgram *program, const char *entry_name, Arena *scratch, int *out_result);
+
+#endif // CLERIC_TAC_INTERPRETER_H
@@ -0,0 +1,121 @@
+#include "char_class.h"
+
+// Define CLERIC_NO_SIMD to force the scalar table-driven loops (e.g. to compare performance).
+#if !defined(CLERIC_NO_SIMD) && defined(__SSE2__)
+#define CHAR_SCAN_SSE2 1
+#include <emmintrin.h>
+#elif !defined(CLERIC_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define CHAR_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define SP CHAR_CLASS_SPACE
+#define DG (CHAR_CLASS_DIGIT | CHAR_CLASS_IDENT)
+#define ID (CHAR_CLASS_IDENT_START | CHAR_CLASS_IDENT)
+
+const uint8_t char_class_table[256] = {
+    ['\t'] = SP, ['\n'] = SP, ['\v'] = SP, ['\f'] = SP, ['\r'] = SP, [' '] = SP,
+    ['0'] = DG, ['1'] = DG, ['2'] = DG, ['3'] = DG, ['4'] = DG,
+    ['5'] = DG, ['6'] = DG, ['7'] = DG, ['8'] = DG, ['9'] = DG,
+    ['A'] = ID, ['B'] = ID, ['C'] = ID, ['D'] = ID, ['E'] = ID, ['F'] = ID, ['G'] = ID,
+    ['H'] = ID, ['I'] = ID, ['J'] = ID, ['K'] = ID, ['L'] = ID, ['M'] = ID, ['N'] = ID,
+    ['O'] = ID, ['P'] = ID, ['Q'] = ID, ['R'] = ID, ['S'] = ID, ['T'] = ID, ['U'] = ID,
+    ['V'] = ID, ['W'] = ID, ['X'] = ID, ['Y'] = ID, ['Z'] = ID,
+    ['a'] = ID, ['b'] = ID, ['c'] = ID, ['d'] = ID, ['e'] = ID, ['f'] = ID, ['g'] = ID,
+    ['h'] = ID, ['i'] = ID, ['j'] = ID, ['k'] = ID, ['l'] = ID, ['m'] = ID, ['n'] = ID,
+    ['o'] = ID, ['p'] = ID, ['q'] = ID, ['r'] = ID, ['s'] = ID, ['t'] = ID, ['u'] = ID,
+    ['v'] = ID, ['w'] = ID, ['x'] = ID, ['y'] = ID, ['z'] = ID,
+    ['_'] = ID,
+};
+
+#undef SP
+#undef DG
+#undef ID
+
+#if defined(CHAR_SCAN_SSE2)
+
+// A set bit in the returned mask means the byte at that index is whitespace.
+static inline unsigned whitespace_mask(const __m128i block) {
+    // '\t'..'\r' is the contiguous range 9..13; bytes >= 0x80 compare as negative and never match
+    const __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(8)),
+                                           _mm_cmplt_epi8(block, _mm_set1_epi8(14)));
+    const __m128i is_space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    return (unsigned) _mm_movemask_epi8(_mm_or_si128(in_range, is_space));
+}
+
+static inline __m128i byte_in_range(const __m128i block, const char lo, const char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8((char) (lo - 1))),
+                         _mm_cmplt_epi8(block, _mm_set1_epi8((char) (hi + 1))));
+}
+
+// A set bit in the returned mask means the byte at that index can continue an identifier.
+static inline unsigned identifier_mask(const __m128i block) {
+    __m128i ident = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+    ident = _mm_or_si128(ident, byte_in_range(block, 'a', 'z'));
+    ident = _mm_or_si128(ident, byte_in_range(block, 'A', 'Z'));
+    ident = _mm_or_si128(ident, byte_in_range(block, '0', '9'));
+    return (unsigned) _mm_movemask_epi8(ident);
+}
+
+// Skips whole 16-byte blocks of matching bytes, then stops exactly at the first mismatch in a block
+#define SCAN_BLOCKS(src, pos, len, mask_fn)                                           \
+    while ((pos) + 16 <= (len)) {                                                     \
+        const unsigned mask = mask_fn(_mm_loadu_si128((const __m128i *) ((src) + (pos)))); \
+        if (mask != 0xFFFFu) {                                                        \
+            return (pos) + (size_t) __builtin_ctz(~mask);                             \
+        }                                                                             \
+        (pos) += 16;                                                                  \
+    }
+
+#elif defined(CHAR_SCAN_NEON)
+
+static inline uint8x16_t byte_in_range(const uint8x16_t block, const uint8_t lo, const uint8_t hi) {
+    return vandq_u8(vcgeq_u8(block, vdupq_n_u8(lo)), vcleq_u8(block, vdupq_n_u8(hi)));
+}
+
+static inline uint8x16_t whitespace_lanes(const uint8x16_t block) {
+    return vorrq_u8(byte_in_range(block, '\t', '\r'), vceqq_u8(block, vdupq_n_u8(' ')));
+}
+
+static inline uint8x16_t identifier_lanes(const uint8x16_t block) {
+    uint8x16_t ident = vceqq_u8(block, vdupq_n_u8('_'));
+    ident = vorrq_u8(ident, byte_in_range(block, 'a', 'z'));
+    ident = vorrq_u8(ident, byte_in_range(block, 'A', 'Z'));
+    ident = vorrq_u8(ident, byte_in_range(block, '0', '9'));
+    return ident;
+}
+
+// Skips whole 16-byte blocks of matching bytes; the scalar loop finds the mismatch within a block
+#define SCAN_BLOCKS(src, pos, len, lanes_fn)                                         \
+    while ((pos) + 16 <= (len)) {                                                    \
+        if (vminvq_u8(lanes_fn(vld1q_u8((const uint8_t *) ((src) + (pos))))) == 0) { \
+            break;                                                                   \
+        }                                                                            \
+        (pos) += 16;                                                                 \
+    }
+
+#endif
+
+size_t char_scan_whitespace(const char *src, size_t pos, const size_t len) {
+#if defined(CHAR_SCAN_SSE2)
+    SCAN_BLOCKS(src, pos, len, whitespace_mask)
+#elif defined(CHAR_SCAN_NEON)
+    SCAN_BLOCKS(src, pos, len, whitespace_lanes)
+#endif
+    while (pos < len && char_has_class(src[pos], CHAR_CLASS_SPACE)) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t char_scan_identifier(const char *src, size_t pos, const size_t len) {
+#if defined(CHAR_SCAN_SSE2)
+    SCAN_BLOCKS(src, pos, len, identifier_mask)
+#elif defined(CHAR_SCAN_NEON)
+    SCAN_BLOCKS(src, pos, len, identifier_lanes)
+#endif
+    while (pos < len && char_has_class(src[pos], CHAR_CLASS_IDENT)) {
+        pos++;
+    }
+    return pos;
+}
@@ -0,0 +1,46 @@
+#ifndef CLERIC_CHAR_CLASS_H
+#define CLERIC_CHAR_CLASS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Character class bits used by the lexer's scan loops.
+// The classes follow the "C" locale, independent of the process locale.
+#define CHAR_CLASS_SPACE       0x01u // ' ', '\t', '\n', '\v', '\f', '\r'
+#define CHAR_CLASS_DIGIT       0x02u // '0'-'9'
+#define CHAR_CLASS_IDENT_START 0x04u // 'a'-'z', 'A'-'Z', '_'
+#define CHAR_CLASS_IDENT       0x08u // IDENT_START or DIGIT
+
+/**
+ * 256-entry class table, indexed by the byte value.
+ */
+extern const uint8_t char_class_table[256];
+
+/**
+ * Tests a byte against one or more class bits.
+ */
+static inline int char_has_class(const char c, const uint8_t class_bits) {
+    return (char_class_table[(unsigned char) c] & class_bits) != 0;
+}
+
+/**
+ * Advances past a run of whitespace.
+ * Uses a 16-bytes-at-a-time SIMD path (SSE2 or NEON) when available; never reads past `len`.
+ * @param src Source buffer.
+ * @param pos Position to start scanning from.
+ * @param len Length of the source buffer.
+ * @return Position of the first non-whitespace byte, or len.
+ */
+size_t char_scan_whitespace(const char *src, size_t pos, size_t len);
+
+/**
+ * Advances past a run of identifier characters ([a-zA-Z0-9_]).
+ * Uses the same SIMD path as char_scan_whitespace when available.
+ * @param src Source buffer.
+ * @param pos Position to start scanning from.
+ * @param len Length of the source buffer.
+ * @return Position of the first byte that cannot continue an identifier, or len.
+ */
+size_t char_scan_identifier(const char *src, size_t pos, size_t len);
+
+#endif // CLERIC_CHAR_CLASS_H
@@ -0,0 +1,26 @@
+#include "keywords.h"
+#include <string.h>
+
+#define KEYWORD_SLOT(text, first, last, type) \
+    [KEYWORD_HASH(sizeof(text) - 1, first, last)] = {text, (uint8_t) (sizeof(text) - 1), type},
+
+const KeywordTable cleric_keyword_table = {
+    .slots = {
+        CLERIC_KEYWORDS(KEYWORD_SLOT)
+    }
+};
+
+#undef KEYWORD_SLOT
+
+bool keyword_table_add(KeywordTable *table, const char *text, const TokenType type) {
+    const size_t len = strlen(text);
+    if (len == 0 || len > UINT8_MAX) {
+        return false;
+    }
+    KeywordSlot *slot = &table->slots[KEYWORD_HASH(len, text[0], text[len - 1])];
+    if (slot->text != NULL) {
+        return false; // Collision: the hash would need new multipliers
+    }
+    *slot = (KeywordSlot){text, (uint8_t) len, type};
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef CLERIC_KEYWORDS_H
+#define CLERIC_KEYWORDS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h> // For memcmp
+#include "lexer.h" // For TokenType
+
+/**
+ * The single keyword table. Each entry lists the keyword, its first and last
+ * characters (used by the hash, spelled out so slot indices are integer
+ * constant expressions) and the token type it lexes to.
+ * To add a keyword, add a row here and a TokenType value in lexer.h.
+ */
+#define CLERIC_KEYWORDS(X) \
+    X("int",    'i', 't', TOKEN_KEYWORD_INT) \
+    X("void",   'v', 'd', TOKEN_KEYWORD_VOID) \
+    X("return", 'r', 'n', TOKEN_KEYWORD_RETURN)
+
+// Number of slots in a keyword table (power of two)
+#define KEYWORD_TABLE_SIZE 128
+
+/**
+ * Perfect hash over (length, first char, last char).
+ * The multipliers were chosen so that all C99 keywords land in distinct slots,
+ * so growing CLERIC_KEYWORDS towards full C keeps lookups at one comparison.
+ */
+#define KEYWORD_HASH(len, first, last) \
+    ((((size_t) (len)) * 3u + ((size_t) (unsigned char) (first)) * 35u + (size_t) (unsigned char) (last)) \
+     & (KEYWORD_TABLE_SIZE - 1))
+
+typedef struct {
+    const char *text;  // Keyword spelling (NULL for an empty slot)
+    uint8_t length;    // strlen(text)
+    TokenType type;    // Token produced for the keyword
+} KeywordSlot;
+
+typedef struct {
+    KeywordSlot slots[KEYWORD_TABLE_SIZE];
+} KeywordTable;
+
+/**
+ * The keyword table built at compile time from CLERIC_KEYWORDS.
+ */
+extern const KeywordTable cleric_keyword_table;
+
+/**
+ * Looks up an identifier-shaped slice in a keyword table.
+ * Costs one hash and at most one memcmp, independent of the number of keywords.
+ * @param table The table to search.
+ * @param str Start of the candidate (need not be NUL-terminated).
+ * @param len Length of the candidate.
+ * @param out_type Set to the keyword's token type on a match.
+ * @return true if the slice is a keyword, false otherwise.
+ */
+static inline bool keyword_table_lookup(const KeywordTable *table, const char *str, const size_t len,
+                                        TokenType *out_type) {
+    if (len == 0 || len > UINT8_MAX) {
+        return false;
+    }
+    const KeywordSlot *slot = &table->slots[KEYWORD_HASH(len, str[0], str[len - 1])];
+    if (slot->length != len || memcmp(slot->text, str, len) != 0) {
+        return false;
+    }
+    *out_type = slot->type;
+    return true;
+}
+
+/**
+ * Adds a keyword to a runtime-built table (used by tests and benchmarks).
+ * @return false if the keyword's slot is already taken (hash collision) or the keyword is too long.
+ */
+bool keyword_table_add(KeywordTable *table, const char *text, TokenType type);
+
+#endif // CLERIC_KEYWORDS_H
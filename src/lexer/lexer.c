@@ -1,42 +1,40 @@
 #include "lexer.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include "memory/arena.h" // Include Arena for allocation
+#include "keywords.h"
+#include "char_class.h"
 
 /**
  * Checks if the given string matches a reserved keyword.
  * If matched, sets out_type to the corresponding keyword token.
+ * Uses the perfect-hash table generated from CLERIC_KEYWORDS (see keywords.h),
+ * so the cost does not grow with the number of keywords.
  * @param str    Pointer to start of candidate keyword
  * @param len    Length of the candidate
  * @param out_type Pointer to TokenType to set if matched
  * @return 1 if keyword, 0 otherwise
  */
 static int is_keyword(const char *str, const size_t len, TokenType *out_type) {
-    if (len == 3 && strncmp(str, "int", 3) == 0) {
-        *out_type = TOKEN_KEYWORD_INT;
-        return 1;
-    }
-    if (len == 4 && strncmp(str, "void", 4) == 0) {
-        *out_type = TOKEN_KEYWORD_VOID;
-        return 1;
-    }
-    if (len == 6 && strncmp(str, "return", 6) == 0) {
-        *out_type = TOKEN_KEYWORD_RETURN;
-        return 1;
-    }
-    return 0;
+    return keyword_table_lookup(&cleric_keyword_table, str, len, out_type) ? 1 : 0;
 }
 
 /**
  * Initializes the lexer state for a given input string.
  */
 void lexer_init(Lexer *lexer, const char *src, Arena *arena) {
+    lexer_init_with_length(lexer, src, strlen(src), arena);
+}
+
+/**
+ * Initializes the lexer state for the first len bytes of src.
+ */
+void lexer_init_with_length(Lexer *lexer, const char *src, const size_t len, Arena *arena) {
     lexer->src = src;
     lexer->pos = 0;
-    lexer->len = strlen(src);
+    lexer->len = len;
     lexer->arena = arena; // Store the arena pointer
 }
 
@@ -49,93 +47,59 @@ void lexer_reset(Lexer *lexer) {
 
 /**
  * Advances the lexer position past any whitespace characters.
+ * Long runs are skipped 16 bytes at a time where SIMD is available (see char_class.h).
  * @param lexer Pointer to Lexer
  */
 static void skip_whitespace(Lexer *lexer) {
-    while (lexer->pos < lexer->len && isspace(lexer->src[lexer->pos])) {
-        lexer->pos++;
-    }
+    lexer->pos = char_scan_whitespace(lexer->src, lexer->pos, lexer->len);
 }
 
 /**
  * Scans and returns the next token from the input.
- * The returned token's lexeme (if applicable, e.g., identifiers, constants)
- * will be allocated within the lexer's arena.
+ * The returned token's lexeme is a slice of the source buffer; no memory is allocated.
  * If the end of input is reached, returns TOKEN_EOF.
  */
 bool lexer_next_token(Lexer *lexer, Token *out_token) {
-    // Initialize out_token to a safe default (e.g., UNKNOWN, NULL lexeme)
-    // Although if false is returned, its state is undefined per the header comment.
-    *out_token = (Token){TOKEN_UNKNOWN, NULL, lexer->pos};
-
     skip_whitespace(lexer);
-    size_t start = lexer->pos;
+    const size_t start = lexer->pos;
+    const char *text = lexer->src + start;
     if (lexer->pos >= lexer->len) {
-        *out_token = (Token){TOKEN_EOF, NULL, lexer->pos};
+        *out_token = (Token){TOKEN_EOF, text, 0, start};
         return true; // Successfully found EOF
     }
     const char c = lexer->src[lexer->pos];
     // Identifiers and keywords: [a-zA-Z_][a-zA-Z0-9_]*
-    if (isalpha(c) || c == '_') {
-        const size_t id_start = lexer->pos;
-        lexer->pos++;
-        while (lexer->pos < lexer->len && (isalnum(lexer->src[lexer->pos]) || lexer->src[lexer->pos] == '_'))
-            lexer->pos++;
-        const size_t id_len = lexer->pos - id_start;
+    if (char_has_class(c, CHAR_CLASS_IDENT_START)) {
+        lexer->pos = char_scan_identifier(lexer->src, lexer->pos + 1, lexer->len);
+        const size_t id_len = lexer->pos - start;
         TokenType type;
-        if (is_keyword(lexer->src + id_start, id_len, &type)) {
-            // For keywords, do not allocate a lexeme (set to NULL)
-            *out_token = (Token){type, NULL, id_start};
-            return true;
+        if (!is_keyword(text, id_len, &type)) {
+            type = TOKEN_IDENTIFIER;
         }
-        // Allocate lexeme in the arena
-        char *lexeme = arena_alloc(lexer->arena, id_len + 1);
-        if (!lexeme) {
-            fprintf(stderr, "Lexer Error: Arena allocation failed for identifier lexeme.\n");
-            return false; // Allocation failure
-        }
-        memcpy(lexeme, lexer->src + id_start, id_len);
-        lexeme[id_len] = '\0'; // Null-terminate
-        *out_token = (Token){TOKEN_IDENTIFIER, lexeme, id_start};
+        *out_token = (Token){type, text, (uint32_t) id_len, start};
         return true;
     }
     // Integer constants: [0-9]+
-    if (isdigit(c)) {
-        const size_t const_start = lexer->pos;
+    if (char_has_class(c, CHAR_CLASS_DIGIT)) {
         lexer->pos++; // Consume the first digit
-        while (lexer->pos < lexer->len && isdigit(lexer->src[lexer->pos])) {
+        while (lexer->pos < lexer->len && char_has_class(lexer->src[lexer->pos], CHAR_CLASS_DIGIT)) {
             lexer->pos++; // Consume subsequent digits
         }
         // Check for invalid trailing identifier part (e.g., 1foo)
-        if (lexer->pos < lexer->len && (isalpha(lexer->src[lexer->pos]) || lexer->src[lexer->pos] == '_')) {
-            // Invalid character found after digits. Consume it.
-            char bad_char = lexer->src[lexer->pos];
+        if (lexer->pos < lexer->len && char_has_class(lexer->src[lexer->pos], CHAR_CLASS_IDENT_START)) {
+            // Invalid character found after digits: report just that character.
+            const size_t bad_pos = lexer->pos;
             lexer->pos++; // Advance past the bad character
-            // Allocate space for the single bad character in the arena
-            char *lexeme = arena_alloc(lexer->arena, 2); // 1 char + null terminator
-            if (!lexeme) {
-                fprintf(stderr, "Lexer Error: Arena allocation failed for unknown token lexeme (suffix).\n");
-                return false; // Allocation failure
-            }
-            lexeme[0] = bad_char;
-            lexeme[1] = '\0';
-            *out_token = (Token){TOKEN_UNKNOWN, lexeme, lexer->pos - 1}; // Position is where the bad char was
+            *out_token = (Token){TOKEN_UNKNOWN, lexer->src + bad_pos, 1, bad_pos};
             return true;
         }
         // If no invalid char followed, it's a valid constant.
-        const size_t const_len = lexer->pos - const_start;
-        char *lexeme = arena_alloc(lexer->arena, const_len + 1);
-        if (!lexeme) {
-            fprintf(stderr, "Lexer Error: Arena allocation failed for constant lexeme.\n");
-            return false; // Allocation failure
-        }
-        memcpy(lexeme, lexer->src + const_start, const_len);
-        lexeme[const_len] = '\0';
-        *out_token = (Token){TOKEN_CONSTANT, lexeme, const_start};
+        *out_token = (Token){TOKEN_CONSTANT, text, (uint32_t) (lexer->pos - start), start};
         return true;
     }
     // Single-character symbols and potential multi-character symbols
     TokenType sym_type = TOKEN_UNKNOWN;
+    size_t sym_len = 1;
     switch (c) {
         case '(': sym_type = TOKEN_SYMBOL_LPAREN;
             break;
@@ -152,9 +116,9 @@ bool lexer_next_token(Lexer *lexer, Token *out_token) {
         case '-':
             // Check for '--' (decrement)
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '-') {
-                lexer->pos += 2; // Consume both '-'
-                *out_token = (Token){TOKEN_SYMBOL_DECREMENT, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_DECREMENT;
+                sym_len = 2;
+                break;
             }
         // Otherwise, it's just '-' (minus)
             sym_type = TOKEN_SYMBOL_MINUS;
@@ -169,74 +133,119 @@ bool lexer_next_token(Lexer *lexer, Token *out_token) {
             break;
         case '<':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '=') {
-                lexer->pos += 2; // Consume both '<='
-                *out_token = (Token){TOKEN_SYMBOL_LESS_EQUAL, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_LESS_EQUAL;
+                sym_len = 2;
+                break;
             }
             sym_type = TOKEN_SYMBOL_LESS;
             break;
         case '>':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '=') {
-                lexer->pos += 2; // Consume both '>='
-                *out_token = (Token){TOKEN_SYMBOL_GREATER_EQUAL, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_GREATER_EQUAL;
+                sym_len = 2;
+                break;
             }
             sym_type = TOKEN_SYMBOL_GREATER;
             break;
         case '=':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '=') {
-                lexer->pos += 2; // Consume both '=='
-                *out_token = (Token){TOKEN_SYMBOL_EQUAL_EQUAL, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_EQUAL_EQUAL;
+                sym_len = 2;
+                break;
             }
             sym_type = TOKEN_SYMBOL_ASSIGN;
             break;
         case '!':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '=') {
-                lexer->pos += 2; // Consume both '!='
-                *out_token = (Token){TOKEN_SYMBOL_NOT_EQUAL, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_NOT_EQUAL;
+                sym_len = 2;
+                break;
             }
             sym_type = TOKEN_SYMBOL_BANG;
             break;
         case '&':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '&') {
-                lexer->pos += 2; // Consume both '&&'
-                *out_token = (Token){TOKEN_SYMBOL_LOGICAL_AND, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_LOGICAL_AND;
+                sym_len = 2;
             }
             // Single '&' will fall through to TOKEN_UNKNOWN
             break;
         case '|':
             if (lexer->pos + 1 < lexer->len && lexer->src[lexer->pos + 1] == '|') {
-                lexer->pos += 2; // Consume both '||'
-                *out_token = (Token){TOKEN_SYMBOL_LOGICAL_OR, NULL, start};
-                return true;
+                sym_type = TOKEN_SYMBOL_LOGICAL_OR;
+                sym_len = 2;
             }
             // Single '|' will fall through to TOKEN_UNKNOWN
             break;
         default: break;
     }
-    if (sym_type != TOKEN_UNKNOWN) {
-        lexer->pos++;
-        // No need to allocate lexeme for symbols; type is sufficient
-        *out_token = (Token){sym_type, NULL, start};
-        return true;
+    // Symbols need no lexeme beyond the slice; unknown characters are reported as a 1-byte slice
+    lexer->pos += sym_len;
+    *out_token = (Token){sym_type, text, (uint32_t) sym_len, start};
+    return true;
+}
+
+// Grows the three parallel arrays of a token array to the given capacity
+static bool token_array_grow(TokenArray *tokens, const size_t new_capacity, Arena *arena) {
+    TokenType *types = arena_alloc_tagged(arena, new_capacity * sizeof(TokenType), ARENA_TAG_TOKENS);
+    uint32_t *offsets = arena_alloc_tagged(arena, new_capacity * sizeof(uint32_t), ARENA_TAG_TOKENS);
+    uint32_t *lengths = arena_alloc_tagged(arena, new_capacity * sizeof(uint32_t), ARENA_TAG_TOKENS);
+    if (!types || !offsets || !lengths) {
+        fprintf(stderr, "Lexer Error: Arena allocation failed for token array.\n");
+        return false;
     }
-    // Unknown/unrecognized character: return as TOKEN_UNKNOWN
-    lexer->pos++;
-    // Allocate space for the single unknown character in the arena
-    char *lexeme = arena_alloc(lexer->arena, 2); // 1 char + null terminator
-    if (!lexeme) {
-        fprintf(stderr, "Lexer Error: Arena allocation failed for unknown token lexeme (char).\n");
-        return false; // Allocation failure
+    if (tokens->count > 0) {
+        memcpy(types, tokens->types, tokens->count * sizeof(TokenType));
+        memcpy(offsets, tokens->offsets, tokens->count * sizeof(uint32_t));
+        memcpy(lengths, tokens->lengths, tokens->count * sizeof(uint32_t));
     }
-    lexeme[0] = c;
-    lexeme[1] = '\0';
-    *out_token = (Token){TOKEN_UNKNOWN, lexeme, start};
+    arena_note_superseded(arena, tokens->capacity * (sizeof(TokenType) + 2 * sizeof(uint32_t)), ARENA_TAG_TOKENS);
+    tokens->types = types;
+    tokens->offsets = offsets;
+    tokens->lengths = lengths;
+    tokens->capacity = new_capacity;
     return true;
 }
 
+bool lexer_tokenize(Lexer *lexer, TokenArray *out_tokens) {
+    *out_tokens = (TokenArray){0};
+    out_tokens->src = lexer->src;
+    if (lexer->len > UINT32_MAX) {
+        fprintf(stderr, "Lexer Error: Source too large (%zu bytes) for 32-bit token offsets.\n", lexer->len);
+        return false;
+    }
+
+    // Typical C averages several bytes per token; start from that guess and double as needed
+    if (!token_array_grow(out_tokens, lexer->len / 4 + 16, lexer->arena)) {
+        return false;
+    }
+
+    Token tok;
+    do {
+        if (!lexer_next_token(lexer, &tok)) {
+            return false;
+        }
+        if (out_tokens->count == out_tokens->capacity &&
+            !token_array_grow(out_tokens, out_tokens->capacity * 2, lexer->arena)) {
+            return false;
+        }
+        const size_t i = out_tokens->count++;
+        out_tokens->types[i] = tok.type;
+        out_tokens->offsets[i] = (uint32_t) tok.position;
+        out_tokens->lengths[i] = tok.length;
+    } while (tok.type != TOKEN_EOF && tok.type != TOKEN_UNKNOWN);
+
+    return true;
+}
+
+Token token_array_get(const TokenArray *tokens, size_t index) {
+    if (index >= tokens->count) {
+        index = tokens->count - 1;
+    }
+    return (Token){tokens->types[index], tokens->src + tokens->offsets[index], tokens->lengths[index],
+                   tokens->offsets[index]};
+}
+
 // Function to create a string representation of a token
 void token_to_string(Token token, char *buffer, size_t buffer_size) {
     if (!buffer || buffer_size == 0) return; // Safety check
@@ -319,7 +328,7 @@ void token_to_string(Token token, char *buffer, size_t buffer_size) {
     }
 
     if (has_lexeme && token.lexeme) {
-        snprintf(buffer, buffer_size, "%s('%s')", type_str, token.lexeme);
+        snprintf(buffer, buffer_size, "%s('%.*s')", type_str, (int) token.length, token.lexeme);
     } else {
         snprintf(buffer, buffer_size, "%s", type_str);
     }
@@ -1,6 +1,7 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stdint.h>
 #include "memory/arena.h" // Include Arena for allocation
 
 /**
@@ -43,12 +44,15 @@ typedef enum {
 /**
  * Represents a single token.
  * - type: the kind of token (see TokenType)
- * - lexeme: dynamically allocated string holding the matched text
+ * - lexeme: view of the matched text inside the source buffer (NOT NUL-terminated;
+ *           use `length`, or copy it with arena_strndup when a C string is needed)
+ * - length: number of bytes in the lexeme
  * - position: byte offset in the source string where the token starts
  */
 typedef struct {
     TokenType type;
-    char *lexeme;
+    const char *lexeme;
+    uint32_t length;
     size_t position;
 } Token;
 
@@ -66,6 +70,21 @@ typedef struct {
     Arena *arena; // Pointer to the arena used for allocations
 } Lexer;
 
+/**
+ * The whole token stream of a source, stored as a struct of arrays.
+ * - src: the source buffer the offsets refer to (lexemes are slices of it)
+ * - types/offsets/lengths: token kind, byte offset and byte length in the source
+ * - count: number of tokens, including the final TOKEN_EOF (or the TOKEN_UNKNOWN that stopped lexing)
+ */
+typedef struct {
+    const char *src;
+    TokenType *types;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    size_t count;
+    size_t capacity;
+} TokenArray;
+
 /**
  * Initializes the lexer state for a given input string.
  * @param lexer Pointer to a Lexer struct
@@ -74,11 +93,20 @@ typedef struct {
  */
 void lexer_init(Lexer *lexer, const char *src, Arena *arena);
 
+/**
+ * Initializes the lexer state for a source of known length, without scanning it for a terminator.
+ * @param lexer Pointer to a Lexer struct
+ * @param src   Source text to tokenize (need not be null-terminated)
+ * @param len   Number of bytes of src to tokenize
+ * @param arena Pointer to the Arena to use for allocations
+ */
+void lexer_init_with_length(Lexer *lexer, const char *src, size_t len, Arena *arena);
+
 /**
  * Retrieves the next token from the lexer's source string.
  * Advances the lexer's position.
- * The lexeme (if any) is allocated within the lexer's internal arena.
- * Do not free the lexeme; it will be freed when the arena is destroyed.
+ * The lexeme points into the source buffer, which must outlive the token;
+ * nothing is allocated.
  *
  * @param lexer Pointer to the initialized Lexer.
  * @param out_token Pointer to a Token struct where the result will be stored.
@@ -90,6 +118,25 @@ void lexer_init(Lexer *lexer, const char *src, Arena *arena);
  */
 bool lexer_next_token(Lexer *lexer, Token *out_token);
 
+/**
+ * Tokenizes the rest of the source in a single pass, filling a token array
+ * allocated from the lexer's arena (the only allocation the lexer makes).
+ * Lexing stops after TOKEN_EOF, or after the first TOKEN_UNKNOWN (which is kept
+ * as the last element so callers can report it).
+ *
+ * @param lexer Pointer to the initialized Lexer.
+ * @param out_tokens Pointer to the TokenArray to fill.
+ * @return true on success, false on allocation failure or if the source is
+ *         too large for 32-bit token offsets.
+ */
+bool lexer_tokenize(Lexer *lexer, TokenArray *out_tokens);
+
+/**
+ * Rebuilds the Token at the given index of a token array.
+ * Indices past the end yield the last token (TOKEN_EOF for a complete stream).
+ */
+Token token_array_get(const TokenArray *tokens, size_t index);
+
 /**
  * Resets the lexer's position to the beginning of the source string.
  * @param lexer Pointer to initialized Lexer
@@ -0,0 +1,115 @@
+#include "token_ring.h"
+#include "../compiler/trace.h"
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Polls of the other side's index before a waiting thread yields its time slice
+#define TOKEN_RING_SPINS 64
+
+#define LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static void wait_a_little(unsigned *spins) {
+    if (++*spins >= TOKEN_RING_SPINS) {
+        *spins = 0;
+        sched_yield();
+    }
+}
+
+// Waits for a free slot; false if the consumer closed the ring meanwhile
+static bool token_ring_push(TokenRing *ring, const Token *token) {
+    unsigned spins = 0;
+    while (ring->tail - ring->cached_head == TOKEN_RING_CAPACITY) {
+        ring->cached_head = LOAD_ACQUIRE(&ring->head);
+        if (ring->tail - ring->cached_head < TOKEN_RING_CAPACITY) {
+            break;
+        }
+        if (LOAD_ACQUIRE(&ring->closed)) {
+            return false;
+        }
+        wait_a_little(&spins);
+    }
+    ring->slots[ring->tail & (TOKEN_RING_CAPACITY - 1)] = *token;
+    STORE_RELEASE(&ring->tail, ring->tail + 1);
+    return true;
+}
+
+bool token_ring_pop(TokenRing *ring, Token *out_token) {
+    if (ring->finished) {
+        *out_token = ring->last;
+        return !(ring->last.type == TOKEN_EOF && LOAD_ACQUIRE(&ring->failed));
+    }
+    unsigned spins = 0;
+    while (ring->head == ring->cached_tail) {
+        ring->cached_tail = LOAD_ACQUIRE(&ring->tail);
+        if (ring->head != ring->cached_tail) {
+            break;
+        }
+        wait_a_little(&spins);
+    }
+    *out_token = ring->slots[ring->head & (TOKEN_RING_CAPACITY - 1)];
+    STORE_RELEASE(&ring->head, ring->head + 1);
+    if (out_token->type == TOKEN_EOF || out_token->type == TOKEN_UNKNOWN) {
+        ring->finished = true;
+        ring->last = *out_token;
+    }
+    // The failure flag is stored before the TOKEN_EOF that follows it is published
+    return !(out_token->type == TOKEN_EOF && LOAD_ACQUIRE(&ring->failed));
+}
+
+static void *lexer_thread_main(void *data) {
+    LexerThread *thread = data;
+    trace_begin("phase", "lex");
+    for (;;) {
+        Token token;
+        if (!lexer_next_token(thread->lexer, &token)) {
+            STORE_RELEASE(&thread->ring->failed, true);
+            token = (Token){.type = TOKEN_EOF, .lexeme = "", .length = 0, .position = thread->lexer->pos};
+        }
+        if (!token_ring_push(thread->ring, &token)) {
+            break; // The parser stopped reading
+        }
+        thread->token_count++;
+        if (token.type == TOKEN_UNKNOWN) {
+            thread->saw_unknown = true;
+            thread->unknown = token;
+        }
+        if (token.type == TOKEN_EOF || token.type == TOKEN_UNKNOWN) {
+            break;
+        }
+    }
+    trace_end("phase", "lex");
+    return NULL;
+}
+
+bool lexer_thread_start(LexerThread *thread, Lexer *lexer, Arena *arena) {
+    *thread = (LexerThread){.lexer = lexer};
+    // The ring is aligned by hand so its two halves really sit on separate cache lines
+    char *memory = arena_alloc_tagged(arena, sizeof(TokenRing) + TOKEN_RING_CACHE_LINE, ARENA_TAG_TOKENS);
+    Token *slots = arena_alloc_tagged(arena, TOKEN_RING_CAPACITY * sizeof(Token), ARENA_TAG_TOKENS);
+    if (!memory || !slots) {
+        fprintf(stderr, "Lexer Error: Out of memory for the token ring.\n");
+        return false;
+    }
+    const uintptr_t misalignment = (uintptr_t) memory % TOKEN_RING_CACHE_LINE;
+    thread->ring = (TokenRing *) (memory + (misalignment ? TOKEN_RING_CACHE_LINE - misalignment : 0));
+    memset(thread->ring, 0, sizeof(TokenRing));
+    thread->ring->slots = slots;
+    if (pthread_create(&thread->thread, NULL, lexer_thread_main, thread) != 0) {
+        fprintf(stderr, "Lexer Error: Failed to start the lexer thread.\n");
+        return false;
+    }
+    thread->started = true;
+    return true;
+}
+
+void lexer_thread_finish(LexerThread *thread) {
+    if (!thread->started) {
+        return;
+    }
+    STORE_RELEASE(&thread->ring->closed, true);
+    pthread_join(thread->thread, NULL);
+    thread->started = false;
+}
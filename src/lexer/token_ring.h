@@ -0,0 +1,82 @@
+#ifndef CLERIC_TOKEN_RING_H
+#define CLERIC_TOKEN_RING_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lexer.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Lexing on a thread of its own
+//
+// A LexerThread runs lexer_next_token on its own thread and hands the tokens
+// to the parser through a single-producer/single-consumer ring. No lock is
+// taken: the producer publishes its tail and the consumer its head with
+// release stores. Each side keeps its index and its cached copy of the other
+// side's index on its own cache line, so the two threads only share a line
+// when one of them has caught up with the other. A full ring holds the lexer
+// back and an empty one holds the parser back. Both spin briefly and then
+// yield.
+//
+// The stream always ends with a final token: TOKEN_EOF, or the TOKEN_UNKNOWN
+// that stopped lexing, which the thread also records for the error message.
+// Past that token the ring keeps returning it, as token_array_get does past
+// the end of an array. If lexer_next_token fails, the ring ends with a
+// TOKEN_EOF and token_ring_pop returns false for it. A parser that stops early
+// closes the ring, which releases a lexer blocked on a full ring.
+//------------------------------------------------------------------------------
+
+// Tokens in flight between the threads (a power of two)
+#define TOKEN_RING_CAPACITY 1024
+
+#define TOKEN_RING_CACHE_LINE 64
+
+typedef struct {
+    // Producer's line
+    size_t tail;        // Tokens pushed so far
+    size_t cached_head; // The producer's last look at head
+    char producer_pad[TOKEN_RING_CACHE_LINE - 2 * sizeof(size_t)];
+    // Consumer's line
+    size_t head;        // Tokens popped so far
+    size_t cached_tail; // The consumer's last look at tail
+    Token last;         // The final token, once it was popped
+    bool finished;      // The final token was popped
+    char consumer_pad[TOKEN_RING_CACHE_LINE - 2 * sizeof(size_t) - sizeof(Token) - sizeof(bool)];
+    // Shared flags, each written once
+    bool closed; // The consumer stopped reading
+    bool failed; // The lexer failed; the TOKEN_EOF that follows is not a real end
+    Token *slots;
+} TokenRing;
+
+typedef struct {
+    TokenRing *ring;
+    Lexer *lexer;
+    pthread_t thread;
+    bool started;
+    size_t token_count; // Tokens lexed, the final one included (read after lexer_thread_finish)
+    bool saw_unknown;   // Lexing stopped at an unrecognized token...
+    Token unknown;      // ...which is this one
+} LexerThread;
+
+/**
+ * @brief Starts lexing on a new thread.
+ * @param thread Receives the running thread.
+ * @param lexer An initialized lexer; only the new thread touches it until lexer_thread_finish.
+ * @param arena Arena for the ring, allocated from this thread before the lexer starts.
+ * @return false (with an error printed) if memory ran out or the thread could not be created.
+ */
+bool lexer_thread_start(LexerThread *thread, Lexer *lexer, Arena *arena);
+
+/**
+ * @brief Closes the ring and waits for the lexer thread to stop.
+ */
+void lexer_thread_finish(LexerThread *thread);
+
+/**
+ * @brief Takes the next token, waiting for the lexer if the ring is empty.
+ * @return false if the lexer failed; out_token is then a TOKEN_EOF.
+ */
+bool token_ring_pop(TokenRing *ring, Token *out_token);
+
+#endif // CLERIC_TOKEN_RING_H
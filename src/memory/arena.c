@@ -3,6 +3,9 @@
 #include <string.h> // For NULL
 #include <stdio.h> // For fprintf, stderr, printf, fflush
 #include <stddef.h> // For size_t
+#include <stdint.h> // For uintptr_t
+#include <sys/mman.h> // For the reserved chunks
+#include <unistd.h> // For sysconf
 
 // Define alignment using compiler extension __alignof__ for C99 compatibility
 // Assuming long double has the strictest alignment requirement
@@ -14,21 +17,222 @@ static size_t align_up(size_t size, const size_t alignment) {
     return (size + alignment - 1) & ~(alignment - 1);
 }
 
-static void arena_memset(void *ptr, int c, size_t n);
+// The chunk header is padded so the usable memory that follows it stays MAX_ALIGNMENT aligned.
+#define CHUNK_HEADER_SIZE align_up(sizeof(ArenaChunk), MAX_ALIGNMENT)
+
+// A reserved chunk commits at least this much more at a time; commits also double the committed size
+#define ARENA_COMMIT_STEP ((size_t) 256 * 1024)
+
+// Transparent huge page size on x86-64
+#define ARENA_HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+// Allocates a chunk with `size` usable bytes, chained after `prev`.
+static ArenaChunk *chunk_create(const size_t size, ArenaChunk *prev) {
+    ArenaChunk *chunk = (ArenaChunk *) malloc(CHUNK_HEADER_SIZE + size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->prev = prev;
+    chunk->size = size;
+    chunk->high_water = 0;
+    chunk->reserved = 0;
+    return chunk;
+}
+
+static size_t page_size(void) {
+    return (size_t) sysconf(_SC_PAGESIZE);
+}
+
+// Granularity of commits in a reserved chunk: whole huge pages when they were asked for
+static size_t commit_granule(const bool huge_pages) {
+    return huge_pages ? ARENA_HUGE_PAGE_SIZE : page_size();
+}
+
+// Makes the first `usable` bytes of a reserved chunk accessible (more, rounded up to the granule).
+// Returns false if the reservation is too small or the kernel refuses to commit.
+static bool chunk_commit(ArenaChunk *chunk, size_t usable, const bool huge_pages) {
+    if (usable > chunk->reserved) {
+        return false;
+    }
+    if (usable < 2 * chunk->size) {
+        usable = 2 * chunk->size; // Geometric, so a large arena needs few mprotect calls
+    }
+    const size_t granule = commit_granule(huge_pages);
+    const size_t mapping_end = CHUNK_HEADER_SIZE + chunk->reserved;
+    size_t end = align_up(CHUNK_HEADER_SIZE + usable, granule > ARENA_COMMIT_STEP ? granule : ARENA_COMMIT_STEP);
+    if (end > mapping_end) {
+        end = mapping_end;
+    }
+    // The committed part always ends on a page boundary (the header shares the first page)
+    const size_t committed_end = chunk->size ? CHUNK_HEADER_SIZE + chunk->size : 0;
+    if (end > committed_end &&
+        mprotect((char *) chunk + committed_end, end - committed_end, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    chunk->size = end - CHUNK_HEADER_SIZE;
+    return true;
+}
+
+// Reserves `reserve` usable bytes of address space and commits at least `commit` of them, chained after `prev`.
+// With huge pages the range is aligned to the huge page size, which transparent huge pages need.
+static ArenaChunk *chunk_reserve(const size_t reserve, const size_t commit, const bool huge_pages,
+                                 ArenaChunk *prev) {
+    const size_t granule = commit_granule(huge_pages);
+    const size_t mapping = align_up(CHUNK_HEADER_SIZE + reserve, granule);
+    const size_t slack = huge_pages ? granule : 0;
+    char *base = mmap(NULL, mapping + slack, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    if (slack) {
+        // Trim the range to an aligned one
+        const size_t head = align_up((uintptr_t) base, granule) - (uintptr_t) base;
+        if (head) {
+            munmap(base, head);
+        }
+        munmap(base + head + mapping, slack - head);
+        base += head;
+#ifdef MADV_HUGEPAGE
+        madvise(base, mapping, MADV_HUGEPAGE); // Only a hint: where it is refused, normal pages are used
+#endif
+    }
+    ArenaChunk *chunk = (ArenaChunk *) base;
+    ArenaChunk header = {.prev = prev, .reserved = mapping - CHUNK_HEADER_SIZE};
+    const size_t page = page_size();
+    if (mprotect(base, page, PROT_READ | PROT_WRITE) != 0) {
+        munmap(base, mapping);
+        return NULL;
+    }
+    *chunk = header;
+    chunk->size = page - CHUNK_HEADER_SIZE; // The header's page is committed first
+    if (!chunk_commit(chunk, commit, huge_pages)) {
+        munmap(base, mapping);
+        return NULL;
+    }
+    return chunk;
+}
+
+static void chunk_destroy(ArenaChunk *chunk) {
+    if (chunk->reserved) {
+        munmap(chunk, CHUNK_HEADER_SIZE + chunk->reserved);
+    } else {
+        free(chunk);
+    }
+}
+
+// Zeroes the used part of a reserved chunk: the header's page is cleared by hand, and the pages after
+// it are dropped, to be mapped as fresh zero pages when touched again
+static void chunk_discard_used(ArenaChunk *chunk) {
+    const size_t page = page_size();
+    const size_t used_end = CHUNK_HEADER_SIZE + chunk->high_water;
+    const size_t first_page_end = used_end < page ? used_end : page;
+    memset((char *) chunk + CHUNK_HEADER_SIZE, 0, first_page_end - CHUNK_HEADER_SIZE);
+    if (used_end > page) {
+        const size_t length = align_up(used_end, page) - page;
+        if (madvise((char *) chunk + page, length, MADV_DONTNEED) != 0) {
+            memset((char *) chunk + page, 0, used_end - page);
+        }
+    }
+}
+
+static char *chunk_data(ArenaChunk *chunk) {
+    return (char *) chunk + CHUNK_HEADER_SIZE;
+}
+
+// Folds the bytes handed out so far into the peak counter and the current chunk's high-water mark.
+// Called before the offset moves back or the current chunk changes; the fast path never updates them.
+static void update_peak(Arena *arena) {
+    const size_t used = arena->retired_used + arena->offset;
+    if (used > arena->peak_used) {
+        arena->peak_used = used;
+    }
+    if (arena->offset > arena->current->high_water) {
+        arena->current->high_water = arena->offset;
+    }
+}
+
+Arena arena_create_with_options(const size_t initial_size, const ArenaOptions *options) {
+    if (!options || options->reserve_size == 0) {
+        return arena_create(initial_size);
+    }
+    Arena arena = {0};
+    if (initial_size == 0) {
+        return arena;
+    }
+    const size_t reserve = options->reserve_size > initial_size ? options->reserve_size : initial_size;
+    arena.current = chunk_reserve(reserve, initial_size, options->huge_pages, NULL);
+    if (arena.current == NULL) {
+        fprintf(stderr, "Error: Failed to reserve %zu bytes of address space for arena\n", reserve);
+        return arena;
+    }
+    arena.start = chunk_data(arena.current);
+    arena.total_size = arena.current->size;
+    arena.chunk_count = 1;
+    arena.reserve_size = reserve;
+    arena.huge_pages = options->huge_pages;
+    return arena;
+}
 
 Arena arena_create(const size_t initial_size) {
     Arena arena = {0}; // Initialize all fields to zero/NULL
-    arena.start = (char *) malloc(initial_size);
-    if (arena.start == NULL) {
+    if (initial_size == 0) {
+        return arena;
+    }
+    arena.current = chunk_create(initial_size, NULL);
+    if (arena.current == NULL) {
         fprintf(stderr, "Error: Failed to allocate memory for arena (size %zu)\n", initial_size);
-        arena.total_size = 0;
-    } else {
-        arena.total_size = initial_size;
+        return arena;
     }
+    arena.start = chunk_data(arena.current);
+    arena.total_size = initial_size;
     arena.offset = 0;
+    arena.chunk_count = 1;
     return arena;
 }
 
+// Slow path of arena_alloc: commits more of a reserved chunk, or else retires the current chunk and
+// chains in a bigger one.
+static void *arena_alloc_new_chunk(Arena *arena, const size_t size) {
+    const size_t aligned_offset = align_up(arena->offset, MAX_ALIGNMENT);
+    if (arena->current->reserved && chunk_commit(arena->current, aligned_offset + size, arena->huge_pages)) {
+        arena->total_size = arena->current->size;
+        arena->offset = aligned_offset + size;
+        arena->alloc_count++;
+        arena->alloc_bytes += size;
+        return arena->start + aligned_offset;
+    }
+
+    size_t next_size = arena->total_size < ARENA_MAX_CHUNK_SIZE / 2 ? arena->total_size * 2 : ARENA_MAX_CHUNK_SIZE;
+    if (next_size < size) {
+        next_size = align_up(size, MAX_ALIGNMENT);
+    }
+
+    // A reserved arena that filled its range reserves another one as large (or as large as the request)
+    ArenaChunk *chunk = arena->reserve_size
+                            ? chunk_reserve(arena->reserve_size > size ? arena->reserve_size : size, size,
+                                            arena->huge_pages, arena->current)
+                            : chunk_create(next_size, arena->current);
+    if (chunk == NULL) {
+        fprintf(stderr, "Error: Arena out of memory (requested %zu, failed to allocate chunk of %zu)\n",
+                size, next_size);
+        arena->failed_allocs++;
+        return NULL;
+    }
+
+    update_peak(arena);
+    arena->retired_used += arena->offset;
+    arena->wasted_tail += arena->total_size - arena->offset;
+
+    arena->current = chunk;
+    arena->start = chunk_data(chunk);
+    arena->total_size = chunk->size;
+    arena->offset = size;
+    arena->chunk_count++;
+    arena->alloc_count++;
+    arena->alloc_bytes += size;
+    return arena->start;
+}
+
 void *arena_alloc(Arena *arena, const size_t size) {
     if (arena == NULL || arena->start == NULL) {
         fprintf(stderr, "Error: Attempt to allocate from uninitialized or failed arena.\n");
@@ -38,46 +242,169 @@ void *arena_alloc(Arena *arena, const size_t size) {
     // Calculate the next aligned offset
     const size_t current_aligned_offset = align_up(arena->offset, MAX_ALIGNMENT);
 
-    // Check if there's enough space
+    // Not enough space left in the current chunk: grow
     if (current_aligned_offset + size > arena->total_size) {
-        // For now, we fail. Could implement resizing later.
-        fprintf(stderr, "Error: Arena out of memory (requested %zu, available %zu)\n",
-                size, arena->total_size - current_aligned_offset);
-        return NULL;
+        return arena_alloc_new_chunk(arena, size);
     }
 
     // Allocation succeeds: return pointer and update offset
     void *ptr = arena->start + current_aligned_offset;
     arena->offset = current_aligned_offset + size;
+    arena->alloc_count++;
+    arena->alloc_bytes += size;
+    return ptr;
+}
+
+void *arena_alloc_zeroed(Arena *arena, const size_t size) {
+    void *ptr = arena_alloc(arena, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+#ifdef CLERIC_ARENA_TAGS
+void *arena_alloc_tagged(Arena *arena, const size_t size, const ArenaTag tag) {
+    void *ptr = arena_alloc(arena, size);
+    if (ptr && tag < ARENA_TAG_COUNT) {
+        arena->tags[tag].alloc_count++;
+        arena->tags[tag].alloc_bytes += size;
+    }
     return ptr;
 }
 
+void arena_note_superseded(Arena *arena, const size_t size, const ArenaTag tag) {
+    if (arena && tag < ARENA_TAG_COUNT) {
+        arena->tags[tag].superseded_bytes += size;
+    }
+}
+#endif
+
+bool arena_tag_stats(const Arena *arena, ArenaTagStats out[ARENA_TAG_COUNT]) {
+    memset(out, 0, ARENA_TAG_COUNT * sizeof(ArenaTagStats));
+#ifdef CLERIC_ARENA_TAGS
+    if (arena) {
+        memcpy(out, arena->tags, sizeof(arena->tags));
+    }
+    return true;
+#else
+    (void) arena;
+    return false;
+#endif
+}
+
+const char *arena_tag_name(const ArenaTag tag) {
+    static const char *const names[ARENA_TAG_COUNT] = {"tokens", "ast", "strings", "tac", "machine"};
+    return tag < ARENA_TAG_COUNT ? names[tag] : "untagged";
+}
+
 void arena_destroy(Arena *arena) {
-    if (arena && arena->start) {
-        free(arena->start);
-        arena->start = NULL;
-        arena->total_size = 0;
-        arena->offset = 0;
+    if (arena && arena->current) {
+        ArenaChunk *chunk = arena->current;
+        while (chunk) {
+            ArenaChunk *prev = chunk->prev;
+            chunk_destroy(chunk);
+            chunk = prev;
+        }
+    }
+    if (arena) {
+        *arena = (Arena){0};
     }
 }
 
 void arena_reset(Arena *arena) {
-    if (arena) {
+    arena_reset_with_mode(arena, ARENA_RESET_ZERO_USED);
+}
+
+void arena_reset_with_mode(Arena *arena, const ArenaResetMode mode) {
+    if (arena && arena->current) {
+        update_peak(arena);
+
+        // Keep only the newest chunk: it is the largest one, so it best fits the next workload
+        ArenaChunk *chunk = arena->current->prev;
+        while (chunk) {
+            ArenaChunk *prev = chunk->prev;
+            chunk_destroy(chunk);
+            chunk = prev;
+        }
+        arena->current->prev = NULL;
+        arena->chunk_count = 1;
+        arena->retired_used = 0;
+        arena->wasted_tail = 0;
+
+        // Zero out the memory for security/debugging, but only the part that was ever handed out.
+        // The arena keeps the block reachable, so this memset cannot be optimized away.
+        if (mode == ARENA_RESET_ZERO_USED && arena->current->reserved) {
+            chunk_discard_used(arena->current);
+        } else if (mode == ARENA_RESET_ZERO_USED) {
+            memset(arena->start, 0, arena->current->high_water);
+        }
+        arena->current->high_water = 0;
         arena->offset = 0;
-        // Zero out the memory for security/debugging
-        arena_memset(arena->start, 0, arena->total_size);
+        arena->alloc_count = 0;
+        arena->alloc_bytes = 0;
+        arena->failed_allocs = 0;
+#ifdef CLERIC_ARENA_TAGS
+        memset(arena->tags, 0, sizeof(arena->tags));
+#endif
     }
 }
 
-// Custom memset implementation.
-// Uses a volatile pointer to try and ensure that the memory zeroing operation
-// is not optimized away by the compiler. This is a common technique for
-// attempting to securely clear sensitive data, as standard memset might be
-// removed if the compiler deems the buffer unused afterwards.
-// See SEI CERT C Coding Standard: MSC06-C.
-static void arena_memset(void *ptr, int c, size_t n) {
-    volatile unsigned char *p = ptr;
-    while (n--) {
-        *p++ = c;
+ArenaMark arena_mark(const Arena *arena) {
+    ArenaMark mark = {0};
+    if (arena && arena->current) {
+        mark.chunk = arena->current;
+        mark.offset = arena->offset;
+        mark.chunk_count = arena->chunk_count;
+        mark.retired_used = arena->retired_used;
+        mark.wasted_tail = arena->wasted_tail;
+    }
+    return mark;
+}
+
+void arena_release(Arena *arena, const ArenaMark mark) {
+    if (arena == NULL || arena->current == NULL || mark.chunk == NULL) {
+        return;
+    }
+    // Confirm the mark's chunk is in this arena's chain before freeing anything
+    const ArenaChunk *owner = arena->current;
+    while (owner != NULL && owner != mark.chunk) {
+        owner = owner->prev;
+    }
+    if (owner == NULL) {
+        fprintf(stderr, "Error: arena_release called with a mark that does not belong to this arena.\n");
+        return;
+    }
+    update_peak(arena);
+
+    // Free the chunks chained in after the mark (their high-water marks were folded in when retired)
+    while (arena->current != mark.chunk) {
+        ArenaChunk *prev = arena->current->prev;
+        chunk_destroy(arena->current);
+        arena->current = prev;
+    }
+
+    arena->start = chunk_data(mark.chunk);
+    arena->total_size = mark.chunk->size;
+    arena->offset = mark.offset;
+    arena->chunk_count = mark.chunk_count;
+    arena->retired_used = mark.retired_used;
+    arena->wasted_tail = mark.wasted_tail;
+}
+
+ArenaStats arena_stats(const Arena *arena) {
+    ArenaStats stats = {0};
+    if (arena == NULL || arena->current == NULL) {
+        return stats;
+    }
+    stats.used_bytes = arena->retired_used + arena->offset;
+    stats.peak_bytes = arena->peak_used > stats.used_bytes ? arena->peak_used : stats.used_bytes;
+    stats.chunk_count = arena->chunk_count;
+    stats.wasted_tail_bytes = arena->wasted_tail;
+    stats.alloc_count = arena->alloc_count;
+    stats.alloc_bytes = arena->alloc_bytes;
+    for (const ArenaChunk *chunk = arena->current; chunk; chunk = chunk->prev) {
+        stats.reserved_bytes += chunk->size;
     }
+    return stats;
 }
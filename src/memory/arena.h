@@ -4,44 +4,220 @@
 #include <stddef.h> // For size_t
 #include <stdbool.h>
 
-// Basic Arena Allocator
-// - Allocates a large block of memory initially.
-// - Allocations bump a pointer within the block.
+// Subsystems whose allocations can be told apart with arena_alloc_tagged.
+// Allocations made with plain arena_alloc count as untagged.
+typedef enum {
+    ARENA_TAG_TOKENS,  // Token arrays and the token ring (lexemes are slices of the source)
+    ARENA_TAG_AST,     // AST nodes, block item arrays and name copies
+    ARENA_TAG_STRINGS, // StringBuffer storage and string copies
+    ARENA_TAG_TAC,     // TAC functions, instruction arrays and programs
+    ARENA_TAG_MACHINE, // Machine instruction lists of the code generator
+    ARENA_TAG_COUNT
+} ArenaTag;
+
+// Allocations of one tag. Only counted in builds with CLERIC_ARENA_TAGS defined (cmake -DCLERIC_ARENA_TAGS=ON).
+typedef struct {
+    size_t alloc_count;      // Allocations made with the tag
+    size_t alloc_bytes;      // Bytes they requested
+    size_t superseded_bytes; // Bytes of blocks abandoned for a bigger copy (dead until the arena is reset)
+} ArenaTagStats;
+
+// A single block of memory owned by an arena.
+// Chunks are chained newest-first; the usable bytes follow the header.
+typedef struct ArenaChunk {
+    struct ArenaChunk *prev; // Previously filled chunk (NULL for the first chunk)
+    size_t size;             // Usable bytes in this chunk (for a reserved chunk: the committed part)
+    size_t high_water;       // Highest offset reached in this chunk, folded in whenever the offset moves back
+    size_t reserved;         // Usable bytes of address space reserved with mmap (0 for a malloc'd chunk)
+} ArenaChunk;
+
+// Growable Arena Allocator
+// - Allocates a first chunk up front; when it fills up, a new chunk is chained in.
+// - Chunk sizes grow geometrically (doubling) up to ARENA_MAX_CHUNK_SIZE.
+// - Created with arena_create_with_options and a reserve size, chunks are instead large
+//   ranges of address space reserved with mmap and committed as the offset advances, so a
+//   big compilation stays in one chunk; resetting hands the used pages back to the kernel.
+// - Allocations bump a pointer within the current chunk (O(1) fast path).
 // - No individual free; the entire arena is freed at once.
 typedef struct {
-    char *start;    // Pointer to the beginning of the allocated memory block
-    size_t total_size; // Total size of the block
-    size_t offset;     // Current allocation offset from the start
-    // We could add resizing logic later if needed, but keep it simple for now.
+    char *start;       // Pointer to the beginning of the current chunk's memory
+    size_t total_size; // Usable size of the current chunk
+    size_t offset;     // Current allocation offset from the start of the current chunk
+    ArenaChunk *current;  // Header of the current chunk (NULL if creation failed)
+    size_t chunk_count;   // Number of chunks currently owned by the arena
+    size_t retired_used;  // Bytes handed out from all chunks older than the current one
+    size_t wasted_tail;   // Unused tail bytes left behind in retired chunks
+    size_t peak_used;     // High-water mark of bytes handed out
+    size_t alloc_count;   // Successful allocations since creation or the last reset (never lowered by release)
+    size_t alloc_bytes;   // Bytes requested by those allocations (excluding alignment padding)
+    size_t failed_allocs; // Allocations refused for lack of memory since creation or the last reset
+    size_t reserve_size;  // Address space reserved per chunk (0: chunks come from malloc)
+    bool huge_pages;      // Reserved chunks ask for transparent huge pages
+#ifdef CLERIC_ARENA_TAGS
+    ArenaTagStats tags[ARENA_TAG_COUNT]; // Per-tag share of the two counters above, plus superseded bytes
+#endif
 } Arena;
 
+// Snapshot of arena usage, used to size the first chunk for a workload.
+typedef struct {
+    size_t used_bytes;        // Bytes currently handed out (including alignment padding)
+    size_t peak_bytes;        // Largest value used_bytes has reached since creation
+    size_t reserved_bytes;    // Total usable bytes across all chunks
+    size_t chunk_count;       // Number of chunks currently owned
+    size_t wasted_tail_bytes; // Bytes left unused at the end of retired chunks
+    size_t alloc_count;       // Allocations made since creation or the last reset
+    size_t alloc_bytes;       // Bytes requested by those allocations; differences give per-phase totals
+} ArenaStats;
+
+// Saved allocation position, used to give back scratch memory in LIFO order.
+typedef struct {
+    ArenaChunk *chunk;   // Chunk that was current when the mark was taken
+    size_t offset;       // Offset within that chunk
+    size_t chunk_count;  // Arena counters at the time of the mark
+    size_t retired_used;
+    size_t wasted_tail;
+} ArenaMark;
+
+// How arena_create_with_options backs the arena's chunks.
+typedef struct {
+    size_t reserve_size; // 0 for malloc'd chunks; otherwise the address space reserved per chunk (mmap, PROT_NONE)
+    bool huge_pages;     // With reserve_size: align chunks to 2 MiB and advise MADV_HUGEPAGE, for fewer TLB misses
+} ArenaOptions;
+
+// How arena_reset_with_mode treats the memory that was handed out.
+typedef enum {
+    ARENA_RESET_ZERO_USED, // Zero the bytes up to the high-water mark (never the untouched tail)
+    ARENA_RESET_DIRTY      // Leave memory as is; callers needing cleared memory use arena_alloc_zeroed
+} ArenaResetMode;
+
+// Upper bound for geometric growth; larger requests still get a chunk of their own size.
+#define ARENA_MAX_CHUNK_SIZE ((size_t) 64 * 1024 * 1024)
+
 /**
  * @brief Creates and initializes a new memory arena.
- * @param initial_size The initial capacity of the arena in bytes.
+ * @param initial_size The capacity of the first chunk in bytes.
+ *                     An arena created with size 0 cannot allocate.
  * @return An initialized Arena struct. Check arena.start != NULL for success.
  */
 Arena arena_create(size_t initial_size);
 
+/**
+ * @brief Creates an arena whose chunks are reserved address space, committed on demand.
+ *        Without a reserve size (or without options) this is arena_create.
+ * @param initial_size Bytes committed up front in the first chunk.
+ * @param options Backing of the chunks (may be NULL).
+ * @return An initialized Arena struct. Check arena.start != NULL for success.
+ */
+Arena arena_create_with_options(size_t initial_size, const ArenaOptions *options);
+
 /**
  * @brief Allocates a block of memory within the arena.
- *        Performs basic alignment to MAX_ALIGNMENT.
+ *        Performs basic alignment to MAX_ALIGNMENT. If the current chunk is full,
+ *        a new chunk (at least twice the size of the current one) is chained in.
  * @param arena Pointer to the arena.
  * @param size The number of bytes to allocate.
- * @return Pointer to the allocated memory, or NULL if the arena is full.
+ * @return Pointer to the allocated memory, or NULL if the arena is invalid or the system is out of memory.
  */
 void* arena_alloc(Arena *arena, size_t size);
 
 /**
- * @brief Destroys the arena, freeing all its allocated memory.
+ * @brief Allocates a block of memory within the arena and fills it with zeros.
+ * @param arena Pointer to the arena.
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the zeroed memory, or NULL on failure (see arena_alloc).
+ */
+void* arena_alloc_zeroed(Arena *arena, size_t size);
+
+#ifdef CLERIC_ARENA_TAGS
+/**
+ * @brief Allocates like arena_alloc and counts the allocation under a tag.
+ * @param arena Pointer to the arena.
+ * @param size The number of bytes to allocate.
+ * @param tag The subsystem making the allocation.
+ * @return Pointer to the allocated memory, or NULL on failure (see arena_alloc).
+ */
+void* arena_alloc_tagged(Arena *arena, size_t size, ArenaTag tag);
+
+/**
+ * @brief Records that a block of a tag was replaced by a bigger copy and is no longer used.
+ * @param arena Pointer to the arena the block came from.
+ * @param size Size of the abandoned block in bytes.
+ * @param tag The tag it was allocated with.
+ */
+void arena_note_superseded(Arena *arena, size_t size, ArenaTag tag);
+#else
+// Without CLERIC_ARENA_TAGS the tagged calls are plain allocations: the counting costs nothing
+static inline void* arena_alloc_tagged(Arena *arena, const size_t size, const ArenaTag tag) {
+    (void) tag;
+    return arena_alloc(arena, size);
+}
+
+static inline void arena_note_superseded(Arena *arena, const size_t size, const ArenaTag tag) {
+    (void) arena;
+    (void) size;
+    (void) tag;
+}
+#endif
+
+/**
+ * @brief Reports the per-tag counters.
+ * @param arena Pointer to the arena.
+ * @param out Receives ARENA_TAG_COUNT entries (all zero in builds without CLERIC_ARENA_TAGS).
+ * @return true if this build counts tags (CLERIC_ARENA_TAGS).
+ */
+bool arena_tag_stats(const Arena *arena, ArenaTagStats out[ARENA_TAG_COUNT]);
+
+/**
+ * @brief Returns the display name of a tag ("tokens", "ast", ...).
+ */
+const char *arena_tag_name(ArenaTag tag);
+
+/**
+ * @brief Destroys the arena, freeing all its chunks.
  * @param arena Pointer to the arena to destroy.
  */
 void arena_destroy(Arena *arena);
 
 /**
  * @brief Resets the arena's offset, allowing reuse of its memory without freeing/reallocating.
+ *        Only the most recent (largest) chunk is kept; older chunks are released.
+ *        Equivalent to arena_reset_with_mode(arena, ARENA_RESET_ZERO_USED): the cost
+ *        scales with the bytes actually used, not with the chunk capacity. A reserved
+ *        chunk is not cleared byte by byte: its used pages are dropped (MADV_DONTNEED)
+ *        and come back zeroed when touched again.
  * @param arena Pointer to the arena to reset.
  */
 void arena_reset(Arena *arena);
 
+/**
+ * @brief Resets the arena like arena_reset, choosing whether the used bytes get zeroed.
+ * @param arena Pointer to the arena to reset.
+ * @param mode ARENA_RESET_ZERO_USED to clear [0, high-water mark), ARENA_RESET_DIRTY to skip clearing.
+ */
+void arena_reset_with_mode(Arena *arena, ArenaResetMode mode);
+
+/**
+ * @brief Records the current allocation position of the arena.
+ * @param arena Pointer to the arena.
+ * @return A mark that can later be passed to arena_release.
+ */
+ArenaMark arena_mark(const Arena *arena);
+
+/**
+ * @brief Frees everything allocated since the mark was taken, returning the arena to that position.
+ *        Chunks chained in after the mark are released. Marks must be released in LIFO order,
+ *        and a mark is invalidated by arena_reset or by releasing an older mark.
+ * @param arena Pointer to the arena.
+ * @param mark A mark previously obtained from arena_mark on the same arena.
+ */
+void arena_release(Arena *arena, ArenaMark mark);
+
+/**
+ * @brief Reports usage statistics for the arena.
+ * @param arena Pointer to the arena.
+ * @return A snapshot of the arena's usage counters.
+ */
+ArenaStats arena_stats(const Arena *arena);
+
 
 #endif //CLERIC_ARENA_H
@@ -0,0 +1,64 @@
+#include "arena_stack.h"
+
+// The chunk header is 4 words, a multiple of the arena alignment, so items that follow it stay aligned
+static char *chunk_items(ArenaStackChunk *chunk) {
+    return (char *) (chunk + 1);
+}
+
+void arena_stack_init(ArenaStack *stack, Arena *arena, const size_t item_size) {
+    stack->arena = arena;
+    stack->item_size = item_size;
+    stack->top = NULL;
+    stack->depth = 0;
+}
+
+void *arena_stack_push(ArenaStack *stack) {
+    ArenaStackChunk *chunk = stack->top;
+    if (!chunk || chunk->count == chunk->capacity) {
+        // Move up into a chunk kept from an earlier fill, or chain in a new one twice as large
+        ArenaStackChunk *next = chunk ? chunk->above : NULL;
+        if (!next) {
+            const size_t capacity = chunk ? chunk->capacity * 2 : ARENA_STACK_FIRST_CHUNK_ITEMS;
+            next = arena_alloc(stack->arena, sizeof(ArenaStackChunk) + capacity * stack->item_size);
+            if (!next) {
+                return NULL;
+            }
+            next->below = chunk;
+            next->above = NULL;
+            next->capacity = capacity;
+            next->count = 0;
+            if (chunk) {
+                chunk->above = next;
+            }
+        }
+        stack->top = chunk = next;
+    }
+    stack->depth++;
+    return chunk_items(chunk) + chunk->count++ * stack->item_size;
+}
+
+void *arena_stack_top(const ArenaStack *stack) {
+    if (stack->depth == 0) {
+        return NULL;
+    }
+    return chunk_items(stack->top) + (stack->top->count - 1) * stack->item_size;
+}
+
+void arena_stack_pop(ArenaStack *stack) {
+    ArenaStackChunk *chunk = stack->top;
+    if (stack->depth == 0) {
+        return;
+    }
+    chunk->count--;
+    stack->depth--;
+    // Only the first chunk is ever left empty at the top
+    if (chunk->count == 0 && chunk->below) {
+        stack->top = chunk->below;
+    }
+}
+
+void arena_stack_truncate(ArenaStack *stack, const size_t depth) {
+    while (stack->depth > depth) {
+        arena_stack_pop(stack);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef CLERIC_ARENA_STACK_H
+#define CLERIC_ARENA_STACK_H
+
+#include <stdbool.h>
+#include <stddef.h> // For size_t
+
+#include "arena.h"
+
+// One block of stack items. Items start right after the header.
+typedef struct ArenaStackChunk {
+    struct ArenaStackChunk *below; // Chunk holding the items under this one (NULL for the first chunk)
+    struct ArenaStackChunk *above; // Chunk kept from an earlier, deeper fill (NULL if none yet)
+    size_t capacity;               // Items this chunk can hold
+    size_t count;                  // Items currently in this chunk
+} ArenaStackChunk;
+
+// LIFO stack of fixed-size items in arena chunks, used to walk deep trees without recursion.
+// - Chunks double in capacity as the stack deepens, so pushes never copy items and pointers
+//   to items stay valid until they are popped.
+// - Chunks are never given back; a stack emptied and filled again (one expression after
+//   another) allocates nothing new, so its arena cost is bounded by its deepest fill.
+// - The stack must not be used after the arena memory it came from is released or reset.
+typedef struct {
+    Arena *arena;
+    size_t item_size;
+    ArenaStackChunk *top; // Chunk holding the top item (NULL before the first push)
+    size_t depth;         // Items on the stack
+} ArenaStack;
+
+// Capacity of the first chunk, in items
+#define ARENA_STACK_FIRST_CHUNK_ITEMS 32
+
+/**
+ * @brief Initializes an empty stack. Nothing is allocated until the first push.
+ * @param stack The stack to initialize.
+ * @param arena Arena the chunks are allocated from.
+ * @param item_size Size of one item in bytes (the items must not need more than the
+ *                  arena's alignment).
+ */
+void arena_stack_init(ArenaStack *stack, Arena *arena, size_t item_size);
+
+/**
+ * @brief Pushes an uninitialized item.
+ * @return Pointer to the new top item, or NULL if the arena is out of memory (the stack is unchanged).
+ */
+void *arena_stack_push(ArenaStack *stack);
+
+/**
+ * @brief Returns the top item, or NULL if the stack is empty.
+ */
+void *arena_stack_top(const ArenaStack *stack);
+
+/**
+ * @brief Removes the top item (nothing happens on an empty stack).
+ */
+void arena_stack_pop(ArenaStack *stack);
+
+/**
+ * @brief Pops items until at most `depth` are left.
+ */
+void arena_stack_truncate(ArenaStack *stack, size_t depth);
+
+static inline bool arena_stack_is_empty(const ArenaStack *stack) {
+    return stack->depth == 0;
+}
+
+#endif // CLERIC_ARENA_STACK_H
@@ -0,0 +1,335 @@
+#include "slab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Header at the start of every page; blocks follow at SLAB_PAGE_HEADER_SIZE
+struct SlabPage {
+    SlabPage *next;        // Neighbours in the class's partial list (while listed)
+    SlabPage *prev;
+    SlabPage *all_next;    // Neighbours in the slab's list of every page
+    SlabPage *all_prev;
+    void *free_blocks;     // Freed blocks, linked through their first word
+    char *untouched;       // Blocks from here to the end of the page were never handed out
+    uint32_t live;         // Blocks handed out
+    uint32_t capacity;     // Blocks the page holds
+    uint8_t size_class;
+    bool listed;           // On the class's partial list
+};
+
+// Header in front of a block above SLAB_MAX_SIZE; its size keeps the block aligned to SLAB_MIN_SIZE
+struct SlabLarge {
+    SlabLarge *next;
+    SlabLarge *prev;
+    size_t size;
+    size_t padding;
+};
+
+// Rounded up so the first block of every class is aligned to SLAB_MIN_SIZE
+#define SLAB_PAGE_HEADER_SIZE ((sizeof(SlabPage) + SLAB_MIN_SIZE - 1) & ~(SLAB_MIN_SIZE - 1))
+
+// Index of the smallest class holding `size` bytes (size must be at most SLAB_MAX_SIZE)
+static unsigned size_class_of(const size_t size) {
+    unsigned index = 0;
+    while (((size_t) SLAB_MIN_SIZE << index) < size) {
+        index++;
+    }
+    return index;
+}
+
+static size_t class_size(const unsigned index) {
+    return SLAB_MIN_SIZE << index;
+}
+
+static SlabPage *page_of(const void *block) {
+    return (SlabPage *) ((uintptr_t) block & ~(uintptr_t) (SLAB_PAGE_SIZE - 1));
+}
+
+bool slab_init(Slab *slab) {
+    memset(slab, 0, sizeof(*slab));
+    if (pthread_mutex_init(&slab->lock, NULL) != 0) {
+        fprintf(stderr, "Slab Error: Failed to create the slab's lock.\n");
+        return false;
+    }
+    return true;
+}
+
+void slab_destroy(Slab *slab) {
+    for (SlabPage *page = slab->pages; page;) {
+        SlabPage *next = page->all_next;
+        free(page);
+        page = next;
+    }
+    for (SlabLarge *large = slab->large; large;) {
+        SlabLarge *next = large->next;
+        free(large);
+        large = next;
+    }
+    pthread_mutex_destroy(&slab->lock);
+    memset(slab, 0, sizeof(*slab));
+}
+
+// --- Page lists (the lock is held) ---
+
+static void list_partial(SlabClass *class, SlabPage *page) {
+    page->prev = NULL;
+    page->next = class->partial;
+    if (class->partial) {
+        class->partial->prev = page;
+    }
+    class->partial = page;
+    page->listed = true;
+}
+
+static void unlist_partial(SlabClass *class, SlabPage *page) {
+    if (page->prev) {
+        page->prev->next = page->next;
+    } else {
+        class->partial = page->next;
+    }
+    if (page->next) {
+        page->next->prev = page->prev;
+    }
+    page->listed = false;
+}
+
+static SlabPage *new_page(Slab *slab, const unsigned index) {
+    void *memory;
+    if (posix_memalign(&memory, SLAB_PAGE_SIZE, SLAB_PAGE_SIZE) != 0) {
+        return NULL;
+    }
+    SlabPage *page = memory;
+    memset(page, 0, sizeof(*page));
+    page->untouched = (char *) page + SLAB_PAGE_HEADER_SIZE;
+    page->capacity = (uint32_t) ((SLAB_PAGE_SIZE - SLAB_PAGE_HEADER_SIZE) / class_size(index));
+    page->size_class = (uint8_t) index;
+    page->all_next = slab->pages;
+    if (slab->pages) {
+        slab->pages->all_prev = page;
+    }
+    slab->pages = page;
+    slab->page_count++;
+    return page;
+}
+
+static void release_page(Slab *slab, SlabPage *page) {
+    if (page->all_prev) {
+        page->all_prev->all_next = page->all_next;
+    } else {
+        slab->pages = page->all_next;
+    }
+    if (page->all_next) {
+        page->all_next->all_prev = page->all_prev;
+    }
+    slab->page_count--;
+    free(page);
+}
+
+// --- Blocks (the lock is held) ---
+
+static void *take_block(Slab *slab, const unsigned index) {
+    SlabClass *class = &slab->classes[index];
+    SlabPage *page = class->partial;
+    if (!page) {
+        page = class->spare ? class->spare : new_page(slab, index);
+        if (!page) {
+            return NULL;
+        }
+        class->spare = NULL;
+        list_partial(class, page);
+    }
+    void *block = page->free_blocks;
+    if (block) {
+        page->free_blocks = *(void **) block;
+    } else {
+        block = page->untouched;
+        page->untouched += class_size(index);
+    }
+    if (++page->live == page->capacity) {
+        unlist_partial(class, page);
+    }
+    slab->live_bytes += class_size(index);
+    slab->alloc_count++;
+    return block;
+}
+
+static void put_block(Slab *slab, void *block) {
+    SlabPage *page = page_of(block);
+    SlabClass *class = &slab->classes[page->size_class];
+    *(void **) block = page->free_blocks;
+    page->free_blocks = block;
+    slab->live_bytes -= class_size(page->size_class);
+    slab->free_count++;
+    if (--page->live > 0) {
+        if (!page->listed) {
+            list_partial(class, page); // It was full
+        }
+        return;
+    }
+    if (page->listed) {
+        unlist_partial(class, page);
+    }
+    if (class->spare) {
+        release_page(slab, page);
+    } else {
+        class->spare = page;
+    }
+}
+
+static void *alloc_large(Slab *slab, const size_t size) {
+    if (size > SIZE_MAX - sizeof(SlabLarge)) {
+        return NULL;
+    }
+    SlabLarge *large = malloc(sizeof(SlabLarge) + size);
+    if (!large) {
+        return NULL;
+    }
+    large->size = size;
+    large->prev = NULL;
+    pthread_mutex_lock(&slab->lock);
+    large->next = slab->large;
+    if (slab->large) {
+        slab->large->prev = large;
+    }
+    slab->large = large;
+    slab->large_bytes += size;
+    slab->alloc_count++;
+    pthread_mutex_unlock(&slab->lock);
+    return large + 1;
+}
+
+static void free_large(Slab *slab, void *ptr) {
+    SlabLarge *large = (SlabLarge *) ptr - 1;
+    pthread_mutex_lock(&slab->lock);
+    if (large->prev) {
+        large->prev->next = large->next;
+    } else {
+        slab->large = large->next;
+    }
+    if (large->next) {
+        large->next->prev = large->prev;
+    }
+    slab->large_bytes -= large->size;
+    slab->free_count++;
+    pthread_mutex_unlock(&slab->lock);
+    free(large);
+}
+
+void *slab_alloc(Slab *slab, const size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+    if (size > SLAB_MAX_SIZE) {
+        return alloc_large(slab, size);
+    }
+    pthread_mutex_lock(&slab->lock);
+    void *block = take_block(slab, size_class_of(size));
+    pthread_mutex_unlock(&slab->lock);
+    return block;
+}
+
+void *slab_alloc_zeroed(Slab *slab, const size_t size) {
+    void *block = slab_alloc(slab, size);
+    if (block) {
+        memset(block, 0, size);
+    }
+    return block;
+}
+
+void slab_free(Slab *slab, void *ptr, const size_t size) {
+    if (!ptr) {
+        return;
+    }
+    if (size > SLAB_MAX_SIZE) {
+        free_large(slab, ptr);
+        return;
+    }
+    pthread_mutex_lock(&slab->lock);
+    put_block(slab, ptr);
+    pthread_mutex_unlock(&slab->lock);
+}
+
+SlabStats slab_stats(Slab *slab) {
+    pthread_mutex_lock(&slab->lock);
+    const SlabStats stats = {
+            .live_bytes = slab->live_bytes,
+            .page_bytes = slab->page_count * SLAB_PAGE_SIZE,
+            .page_count = slab->page_count,
+            .large_bytes = slab->large_bytes,
+            .alloc_count = slab->alloc_count,
+            .free_count = slab->free_count,
+    };
+    pthread_mutex_unlock(&slab->lock);
+    return stats;
+}
+
+// --- Per-thread caches ---
+
+void slab_cache_init(SlabCache *cache, Slab *slab) {
+    memset(cache, 0, sizeof(*cache));
+    cache->slab = slab;
+}
+
+void *slab_cache_alloc(SlabCache *cache, const size_t size) {
+    if (size == 0 || size > SLAB_MAX_SIZE) {
+        return slab_alloc(cache->slab, size);
+    }
+    const unsigned index = size_class_of(size);
+    if (!cache->blocks[index]) {
+        pthread_mutex_lock(&cache->slab->lock);
+        while (cache->block_counts[index] < SLAB_CACHE_BATCH) {
+            void *block = take_block(cache->slab, index);
+            if (!block) {
+                break;
+            }
+            *(void **) block = cache->blocks[index];
+            cache->blocks[index] = block;
+            cache->block_counts[index]++;
+        }
+        pthread_mutex_unlock(&cache->slab->lock);
+        if (!cache->blocks[index]) {
+            return NULL;
+        }
+    }
+    void *block = cache->blocks[index];
+    cache->blocks[index] = *(void **) block;
+    cache->block_counts[index]--;
+    return block;
+}
+
+// Gives back blocks of one class until `keep` are left (the lock is held)
+static void drain_class(SlabCache *cache, const unsigned index, const unsigned keep) {
+    while (cache->block_counts[index] > keep) {
+        void *block = cache->blocks[index];
+        cache->blocks[index] = *(void **) block;
+        cache->block_counts[index]--;
+        put_block(cache->slab, block);
+    }
+}
+
+void slab_cache_free(SlabCache *cache, void *ptr, const size_t size) {
+    if (!ptr) {
+        return;
+    }
+    if (size > SLAB_MAX_SIZE) {
+        slab_free(cache->slab, ptr, size);
+        return;
+    }
+    const unsigned index = size_class_of(size);
+    *(void **) ptr = cache->blocks[index];
+    cache->blocks[index] = ptr;
+    // Past two batches, one batch goes back so a thread that only frees does not hoard blocks
+    if (++cache->block_counts[index] >= 2 * SLAB_CACHE_BATCH) {
+        pthread_mutex_lock(&cache->slab->lock);
+        drain_class(cache, index, SLAB_CACHE_BATCH);
+        pthread_mutex_unlock(&cache->slab->lock);
+    }
+}
+
+void slab_cache_flush(SlabCache *cache) {
+    pthread_mutex_lock(&cache->slab->lock);
+    for (unsigned index = 0; index < SLAB_CLASS_COUNT; ++index) {
+        drain_class(cache, index, 0);
+    }
+    pthread_mutex_unlock(&cache->slab->lock);
+}
@@ -0,0 +1,133 @@
+#ifndef CLERIC_SLAB_H
+#define CLERIC_SLAB_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h> // For size_t
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Slab allocator for objects that die one by one
+//
+// An Arena frees everything at once, which suits one compilation. Data kept
+// across compilations by a long-running process is different: the function
+// cache of the compile server, for one, replaces entries while others stay.
+// A Slab hands out blocks in power-of-two size classes from SLAB_MIN_SIZE to
+// SLAB_MAX_SIZE. Each class carves SLAB_PAGE_SIZE pages into equal blocks, and a
+// freed block goes back on its page's free list for the next allocation of the
+// class. A page whose blocks are all free is given back to malloc, except for
+// one spare per class, so the process's memory follows what is live instead of
+// growing. Larger blocks are malloc'd one by one.
+//
+// Blocks are freed with their size, as arena-style callers always know it, so
+// blocks carry no header. Every call takes the slab's lock. A thread that
+// allocates a lot can put a SlabCache in front of it, which keeps a few free
+// blocks of each class for that thread alone and takes the lock once per
+// batch.
+//------------------------------------------------------------------------------
+
+#define SLAB_MIN_SHIFT 4  // Smallest class: 16 bytes, the alignment of every block
+#define SLAB_MAX_SHIFT 12 // Largest class: 4 KB
+#define SLAB_MIN_SIZE ((size_t) 1 << SLAB_MIN_SHIFT)
+#define SLAB_MAX_SIZE ((size_t) 1 << SLAB_MAX_SHIFT)
+#define SLAB_CLASS_COUNT (SLAB_MAX_SHIFT - SLAB_MIN_SHIFT + 1)
+
+// Pages are aligned to their size, so a block's page is found by masking its address
+#define SLAB_PAGE_SIZE ((size_t) 64 * 1024)
+
+// Blocks a SlabCache takes from or gives back to its slab at a time
+#define SLAB_CACHE_BATCH 16
+
+typedef struct SlabPage SlabPage;   // slab.c
+typedef struct SlabLarge SlabLarge; // slab.c
+
+// Pages of one size class
+typedef struct {
+    SlabPage *partial; // Pages with both handed-out and free blocks, most recently freed into first
+    SlabPage *spare;   // One page with no block handed out, kept for the next allocation (or NULL)
+} SlabClass;
+
+typedef struct {
+    pthread_mutex_t lock;    // Guards everything below
+    SlabClass classes[SLAB_CLASS_COUNT];
+    SlabPage *pages;         // Every page, for slab_destroy
+    SlabLarge *large;        // Every block above SLAB_MAX_SIZE, for slab_destroy
+    size_t page_count;
+    size_t live_bytes;       // Bytes of the blocks handed out, rounded up to their class
+    size_t large_bytes;      // Bytes of the blocks above SLAB_MAX_SIZE
+    size_t alloc_count;      // Allocations since slab_init
+    size_t free_count;       // Frees since slab_init
+} Slab;
+
+// Snapshot of a slab's usage
+typedef struct {
+    size_t live_bytes;  // Bytes handed out and not freed, rounded up to their class (blocks held by caches included)
+    size_t page_bytes;  // Bytes of the pages the small blocks are carved from, spares included
+    size_t page_count;
+    size_t large_bytes; // Bytes of the blocks above SLAB_MAX_SIZE
+    size_t alloc_count; // Allocations since slab_init
+    size_t free_count;  // Frees since slab_init
+} SlabStats;
+
+// Free blocks kept for one thread
+typedef struct {
+    Slab *slab;
+    void *blocks[SLAB_CLASS_COUNT];       // Free blocks of each class, linked through their first word
+    unsigned block_counts[SLAB_CLASS_COUNT];
+} SlabCache;
+
+/**
+ * @brief Initializes an empty slab; pages are only allocated by the first allocations.
+ * @return false (with an error printed) if the lock could not be created.
+ */
+bool slab_init(Slab *slab);
+
+/**
+ * @brief Frees every page and large block, whether or not its blocks were freed.
+ */
+void slab_destroy(Slab *slab);
+
+/**
+ * @brief Allocates a block of at least `size` bytes, aligned to SLAB_MIN_SIZE.
+ * @return The block, or NULL if size is 0 or memory ran out.
+ */
+void *slab_alloc(Slab *slab, size_t size);
+
+/**
+ * @brief Same as slab_alloc, with the block zeroed.
+ */
+void *slab_alloc_zeroed(Slab *slab, size_t size);
+
+/**
+ * @brief Gives a block back.
+ * @param ptr A block from slab_alloc on this slab, or NULL (then nothing happens).
+ * @param size The size it was allocated with.
+ */
+void slab_free(Slab *slab, void *ptr, size_t size);
+
+/**
+ * @brief Returns the slab's current usage.
+ */
+SlabStats slab_stats(Slab *slab);
+
+/**
+ * @brief Initializes an empty cache in front of a slab.
+ */
+void slab_cache_init(SlabCache *cache, Slab *slab);
+
+/**
+ * @brief Allocates as slab_alloc does, taking the slab's lock only to refill the cache.
+ */
+void *slab_cache_alloc(SlabCache *cache, size_t size);
+
+/**
+ * @brief Frees as slab_free does; the block is kept for the cache's next allocations of its class.
+ */
+void slab_cache_free(SlabCache *cache, void *ptr, size_t size);
+
+/**
+ * @brief Gives every block the cache holds back to the slab; required before the owning thread ends.
+ */
+void slab_cache_flush(SlabCache *cache);
+
+#endif // CLERIC_SLAB_H
@@ -0,0 +1,149 @@
+#include "block_layout.h"
+#include "../ir/cfg.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool falls_through(const TacInstruction *last) {
+    return last->type != TAC_INS_GOTO && last->type != TAC_INS_RETURN;
+}
+
+static bool is_jump(const TacInstructionType type) {
+    return type == TAC_INS_GOTO || type == TAC_INS_IF_FALSE_GOTO || type == TAC_INS_IF_TRUE_GOTO;
+}
+
+// Last block of the run that starts at block `start` and can move right after the GOTO
+// entering it, or -1: the run is entered only by that GOTO, nothing falls into it, and it
+// ends in a block that does not fall through either
+static int movable_run_end(const Cfg *cfg, const int start) {
+    const TacInstruction *instructions = cfg->function->instructions;
+    const CfgBlock *first = &cfg->blocks[start];
+    if (start == 0 || first->label == TAC_NO_LABEL || first->predecessor_count != 1 ||
+        first->predecessors[0] >= start || falls_through(&instructions[cfg->blocks[start - 1].last]) ||
+        instructions[cfg->blocks[first->predecessors[0]].last].type != TAC_INS_GOTO) {
+        return -1;
+    }
+    for (int b = start; b < cfg->block_count; ++b) {
+        for (int p = 0; b > start && p < cfg->blocks[b].predecessor_count; ++p) {
+            if (cfg->blocks[b].predecessors[p] < start) {
+                return -1; // Entered from outside the run as well
+            }
+        }
+        if (!falls_through(&instructions[cfg->blocks[b].last])) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+// Fills order with the new block order; returns false if memory ran out
+static bool order_blocks(const Cfg *cfg, Arena *scratch, int *order) {
+    const int n = cfg->block_count;
+    int *run_end = arena_alloc(scratch, (size_t) n * sizeof(int));
+    bool *placed = arena_alloc_zeroed(scratch, (size_t) n * sizeof(bool));
+    if (!run_end || !placed) {
+        return false;
+    }
+    for (int b = 0; b < n; ++b) {
+        run_end[b] = movable_run_end(cfg, b);
+    }
+    int count = 0;
+    for (int b = 0; b < n; ++b) {
+        if (placed[b]) {
+            continue;
+        }
+        order[count++] = b;
+        placed[b] = true;
+        // Pull in the runs that only this block's GOTO (and then theirs) enters
+        for (int tail = b;;) {
+            const TacInstruction *last = &cfg->function->instructions[cfg->blocks[tail].last];
+            const int target = last->type == TAC_INS_GOTO ? cfg_block_for_label(cfg, cfg_jump_target(last)) : -1;
+            if (target < 0 || placed[target] || run_end[target] < 0 || cfg->blocks[target].predecessors[0] != tail) {
+                break;
+            }
+            for (int r = target; r <= run_end[target]; ++r) {
+                order[count++] = r;
+                placed[r] = true;
+            }
+            tail = run_end[target];
+        }
+    }
+    return true;
+}
+
+// Whether label is among the labels starting at instruction i
+static bool label_follows(const TacFunction *func, size_t i, const uint32_t label) {
+    for (; i < func->instruction_count && func->instructions[i].type == TAC_INS_LABEL; ++i) {
+        if (tac_label(&func->instructions[i]).value.label_id == label) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Drops jumps to the next instruction and conditional jumps over a GOTO; returns whether any went
+static bool drop_jumps_to_next(TacFunction *func) {
+    bool changed = false;
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        TacInstruction instr = func->instructions[i];
+        if (is_jump((TacInstructionType) instr.type) &&
+            label_follows(func, i + 1, tac_label(&instr).value.label_id)) {
+            // Jumps kept just before it may now reach the labels by falling through as well
+            while (kept > 0 && is_jump((TacInstructionType) func->instructions[kept - 1].type) &&
+                   label_follows(func, i + 1, tac_label(&func->instructions[kept - 1]).value.label_id)) {
+                kept--;
+            }
+            changed = true;
+            continue;
+        }
+        if ((instr.type == TAC_INS_IF_FALSE_GOTO || instr.type == TAC_INS_IF_TRUE_GOTO) &&
+            i + 1 < func->instruction_count && func->instructions[i + 1].type == TAC_INS_GOTO &&
+            label_follows(func, i + 2, tac_label(&instr).value.label_id) &&
+            !label_follows(func, i + 2, tac_label(&func->instructions[i + 1]).value.label_id)) {
+            instr.type = instr.type == TAC_INS_IF_FALSE_GOTO ? TAC_INS_IF_TRUE_GOTO : TAC_INS_IF_FALSE_GOTO;
+            tac_set_operand(&instr, TAC_SLOT_LABEL, tac_label(&func->instructions[i + 1]));
+            i++; // The GOTO is the fall-through of the inverted jump
+            changed = true;
+        }
+        func->instructions[kept++] = instr;
+    }
+    func->instruction_count = kept;
+    return changed;
+}
+
+bool lay_out_blocks(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    Cfg cfg;
+    if (!cfg_build(func, scratch, &cfg)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    int *order = arena_alloc(scratch, (size_t) cfg.block_count * sizeof(int));
+    TacInstruction *reordered = arena_alloc(scratch, func->instruction_count * sizeof(TacInstruction));
+    if (!order || !reordered || !order_blocks(&cfg, scratch, order)) {
+        fprintf(stderr, "Optimizer Error: Out of memory laying out blocks in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+
+    bool changed = false;
+    size_t count = 0;
+    for (int position = 0; position < cfg.block_count; ++position) {
+        const CfgBlock *block = &cfg.blocks[order[position]];
+        changed |= order[position] != position;
+        memcpy(&reordered[count], &func->instructions[block->first],
+               (block->last - block->first + 1) * sizeof(TacInstruction));
+        count += block->last - block->first + 1;
+    }
+    if (changed) {
+        memcpy(func->instructions, reordered, count * sizeof(TacInstruction));
+    }
+    changed |= drop_jumps_to_next(func);
+
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,30 @@
+#ifndef CLERIC_BLOCK_LAYOUT_H
+#define CLERIC_BLOCK_LAYOUT_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Block layout over TAC
+//
+// Orders blocks so that control falls through instead of jumping:
+// - a run of blocks entered only by one GOTO (and left by a GOTO or RETURN of
+//   its own) is moved right after that GOTO, which then jumps to the next
+//   instruction;
+// - a jump to a label among the labels right after it is dropped;
+// - `if_false c goto L1; goto L2; L1:` becomes `if_true c goto L2; L1:`, and
+//   the other way round.
+// A block is only moved ahead of blocks that do not jump into it, so every
+// jump still goes forward, as SSA construction and liveness expect.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Reorders the blocks of one function for fall-through and drops the jumps that saves.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the CFG and the new order (released before returning).
+ * @return true if any block moved or any jump was dropped or inverted.
+ */
+bool lay_out_blocks(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_BLOCK_LAYOUT_H
@@ -0,0 +1,319 @@
+#include "constant_folding.h"
+#include <limits.h>
+#include <stdio.h>
+
+// What simplifying one instruction did to it
+typedef enum {
+    FOLD_UNCHANGED,
+    FOLD_REWRITTEN, // Instruction was replaced in place (e.g. by a COPY or a GOTO)
+    FOLD_REMOVED    // Instruction has no effect and is dropped
+} FoldResult;
+
+// Constants known for temps in the current basic block
+typedef struct {
+    int *values;
+    int *block; // Block in which values[t] was recorded, -1 if unknown
+    int temp_count;
+    int current_block;
+} ConstantTable;
+
+static bool is_const(const TacOperand *op) {
+    return op->type == TAC_OPERAND_CONST;
+}
+
+static bool is_const_value(const TacOperand *op, const int value) {
+    return op->type == TAC_OPERAND_CONST && op->value.constant_value == value;
+}
+
+static bool same_temp(const TacOperand *a, const TacOperand *b) {
+    return a->type == TAC_OPERAND_TEMP && b->type == TAC_OPERAND_TEMP && a->value.temp_id == b->value.temp_id;
+}
+
+// Rewrites the instruction into dst = src, clearing the slots a COPY does not use
+static FoldResult rewrite_as_copy(TacInstruction *instr, const TacOperand dst, const TacOperand src) {
+    const TacInstruction copy = {.type = TAC_INS_COPY};
+    *instr = copy;
+    tac_set_operand(instr, TAC_SLOT_DST, dst);
+    tac_set_operand(instr, TAC_SLOT_SRC1, src);
+    return FOLD_REWRITTEN;
+}
+
+static FoldResult rewrite_as_bool(TacInstruction *instr, const TacOperand dst, const bool value) {
+    return rewrite_as_copy(instr, dst, create_tac_operand_const(value ? 1 : 0));
+}
+
+// Evaluates a binary arithmetic operation the way the generated code would (two's complement wrap).
+// Returns false when the operation would trap at run time, which must be preserved.
+static bool evaluate_arithmetic(const TacInstructionType type, const int a, const int b, int *out) {
+    switch (type) {
+        case TAC_INS_ADD:
+            *out = (int) ((unsigned) a + (unsigned) b);
+            return true;
+        case TAC_INS_SUB:
+            *out = (int) ((unsigned) a - (unsigned) b);
+            return true;
+        case TAC_INS_MUL:
+            *out = (int) ((unsigned) a * (unsigned) b);
+            return true;
+        case TAC_INS_DIV:
+        case TAC_INS_MOD:
+            if (b == 0 || (a == INT_MIN && b == -1)) {
+                return false; // idivl raises #DE
+            }
+            *out = type == TAC_INS_DIV ? a / b : a % b;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool evaluate_relational(const TacInstructionType type, const int a, const int b) {
+    switch (type) {
+        case TAC_INS_EQUAL:
+            return a == b;
+        case TAC_INS_NOT_EQUAL:
+            return a != b;
+        case TAC_INS_LESS:
+            return a < b;
+        case TAC_INS_LESS_EQUAL:
+            return a <= b;
+        case TAC_INS_GREATER:
+            return a > b;
+        default: // TAC_INS_GREATER_EQUAL
+            return a >= b;
+    }
+}
+
+static FoldResult simplify_arithmetic(TacInstruction *instr) {
+    const TacOperand dst = tac_dst(instr);
+    const TacOperand src1 = tac_src1(instr);
+    const TacOperand src2 = tac_src2(instr);
+
+    int result;
+    if (is_const(&src1) && is_const(&src2)) {
+        if (evaluate_arithmetic(instr->type, src1.value.constant_value, src2.value.constant_value, &result)) {
+            return rewrite_as_copy(instr, dst, create_tac_operand_const(result));
+        }
+        return FOLD_UNCHANGED; // Division by zero stays a division
+    }
+
+    switch (instr->type) {
+        case TAC_INS_ADD:
+            if (is_const_value(&src2, 0)) return rewrite_as_copy(instr, dst, src1); // x + 0
+            if (is_const_value(&src1, 0)) return rewrite_as_copy(instr, dst, src2); // 0 + x
+            break;
+        case TAC_INS_SUB:
+            if (is_const_value(&src2, 0)) return rewrite_as_copy(instr, dst, src1); // x - 0
+            if (same_temp(&src1, &src2)) return rewrite_as_copy(instr, dst, create_tac_operand_const(0)); // x - x
+            break;
+        case TAC_INS_MUL:
+            if (is_const_value(&src1, 0) || is_const_value(&src2, 0)) {
+                return rewrite_as_copy(instr, dst, create_tac_operand_const(0)); // x * 0
+            }
+            if (is_const_value(&src2, 1)) return rewrite_as_copy(instr, dst, src1); // x * 1
+            if (is_const_value(&src1, 1)) return rewrite_as_copy(instr, dst, src2); // 1 * x
+            break;
+        case TAC_INS_DIV:
+            if (is_const_value(&src2, 1)) return rewrite_as_copy(instr, dst, src1); // x / 1
+            break;
+        case TAC_INS_MOD:
+            if (is_const_value(&src2, 1)) return rewrite_as_copy(instr, dst, create_tac_operand_const(0)); // x % 1
+            break;
+        default:
+            break;
+    }
+    return FOLD_UNCHANGED;
+}
+
+static FoldResult simplify_relational(TacInstruction *instr) {
+    const TacOperand dst = tac_dst(instr);
+    const TacOperand src1 = tac_src1(instr);
+    const TacOperand src2 = tac_src2(instr);
+
+    if (is_const(&src1) && is_const(&src2)) {
+        return rewrite_as_bool(instr, dst, evaluate_relational(instr->type, src1.value.constant_value,
+                                                               src2.value.constant_value));
+    }
+    if (same_temp(&src1, &src2)) {
+        // x == x, x <= x, x >= x hold; x != x, x < x, x > x do not
+        return rewrite_as_bool(instr, dst, evaluate_relational(instr->type, 0, 0));
+    }
+    return FOLD_UNCHANGED;
+}
+
+static FoldResult simplify_logical(TacInstruction *instr) {
+    const bool is_and = instr->type == TAC_INS_LOGICAL_AND;
+    const TacOperand dst = tac_dst(instr);
+    const TacOperand src1 = tac_src1(instr);
+    const TacOperand src2 = tac_src2(instr);
+
+    // A constant that decides the result on its own: 0 for &&, non-zero for ||
+    if ((is_const(&src1) && (src1.value.constant_value != 0) != is_and) ||
+        (is_const(&src2) && (src2.value.constant_value != 0) != is_and)) {
+        return rewrite_as_bool(instr, dst, !is_and);
+    }
+    if (is_const(&src1) && is_const(&src2)) {
+        return rewrite_as_bool(instr, dst, is_and); // Neither decides: both non-zero for &&, both zero for ||
+    }
+    // One neutral constant: the result is the other operand normalized to 0/1
+    if (is_const(&src1) || is_const(&src2)) {
+        const TacOperand other = is_const(&src1) ? src2 : src1;
+        instr->type = TAC_INS_NOT_EQUAL;
+        tac_set_operand(instr, TAC_SLOT_DST, dst);
+        tac_set_operand(instr, TAC_SLOT_SRC1, other);
+        tac_set_operand(instr, TAC_SLOT_SRC2, create_tac_operand_const(0));
+        return FOLD_REWRITTEN;
+    }
+    return FOLD_UNCHANGED;
+}
+
+static FoldResult simplify_unary(TacInstruction *instr) {
+    const TacOperand dst = tac_dst(instr);
+    const TacOperand src = tac_src(instr);
+    if (!is_const(&src)) {
+        return FOLD_UNCHANGED;
+    }
+    const int value = src.value.constant_value;
+    switch (instr->type) {
+        case TAC_INS_NEGATE:
+            return rewrite_as_copy(instr, dst, create_tac_operand_const((int) (0u - (unsigned) value)));
+        case TAC_INS_COMPLEMENT:
+            return rewrite_as_copy(instr, dst, create_tac_operand_const(~value));
+        default: // TAC_INS_LOGICAL_NOT
+            return rewrite_as_bool(instr, dst, value == 0);
+    }
+}
+
+static FoldResult simplify_conditional_jump(TacInstruction *instr) {
+    const TacOperand condition = tac_src(instr);
+    const TacOperand target = tac_label(instr);
+    if (!is_const(&condition)) {
+        return FOLD_UNCHANGED;
+    }
+    const bool jumps = (condition.value.constant_value != 0) == (instr->type == TAC_INS_IF_TRUE_GOTO);
+    if (!jumps) {
+        return FOLD_REMOVED;
+    }
+    const TacInstruction go_to = {.type = TAC_INS_GOTO};
+    *instr = go_to;
+    tac_set_operand(instr, TAC_SLOT_LABEL, target);
+    return FOLD_REWRITTEN;
+}
+
+static FoldResult simplify_instruction(TacInstruction *instr) {
+    switch (instr->type) {
+        case TAC_INS_ADD:
+        case TAC_INS_SUB:
+        case TAC_INS_MUL:
+        case TAC_INS_DIV:
+        case TAC_INS_MOD:
+            return simplify_arithmetic(instr);
+        case TAC_INS_EQUAL:
+        case TAC_INS_NOT_EQUAL:
+        case TAC_INS_LESS:
+        case TAC_INS_LESS_EQUAL:
+        case TAC_INS_GREATER:
+        case TAC_INS_GREATER_EQUAL:
+            return simplify_relational(instr);
+        case TAC_INS_LOGICAL_AND:
+        case TAC_INS_LOGICAL_OR:
+            return simplify_logical(instr);
+        case TAC_INS_NEGATE:
+        case TAC_INS_COMPLEMENT:
+        case TAC_INS_LOGICAL_NOT:
+            return simplify_unary(instr);
+        case TAC_INS_IF_FALSE_GOTO:
+        case TAC_INS_IF_TRUE_GOTO:
+            return simplify_conditional_jump(instr);
+        default:
+            return FOLD_UNCHANGED;
+    }
+}
+
+// Replaces uses of temps with a constant known in this block; returns true if any was replaced
+static bool substitute_known_constants(TacInstruction *instr, const ConstantTable *table) {
+    const int use_count = tac_instruction_use_count(instr);
+    bool replaced = false;
+    for (int u = 0; u < use_count; ++u) {
+        const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+        if (!tac_slot_is_temp(instr, slot)) {
+            continue;
+        }
+        const int id = tac_get_operand(instr, slot).value.temp_id;
+        if (id < table->temp_count && table->block[id] == table->current_block) {
+            tac_set_operand(instr, slot, create_tac_operand_const(table->values[id]));
+            replaced = true;
+        }
+    }
+    return replaced;
+}
+
+static void record_definition(TacInstruction *instr, ConstantTable *table) {
+    if (!tac_instruction_has_def(instr) || !tac_slot_is_temp(instr, TAC_SLOT_DST) ||
+        tac_dst(instr).value.temp_id >= table->temp_count) {
+        return;
+    }
+    const int id = tac_dst(instr).value.temp_id;
+    const TacOperand src = tac_src(instr);
+    if (instr->type == TAC_INS_COPY && is_const(&src)) {
+        table->values[id] = src.value.constant_value;
+        table->block[id] = table->current_block;
+    } else {
+        table->block[id] = -1; // Redefined with an unknown value
+    }
+}
+
+static int count_temps(const TacFunction *func) {
+    int temp_count = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (tac_instruction_has_def(instr) && tac_slot_is_temp(instr, TAC_SLOT_DST) &&
+            tac_dst(instr).value.temp_id >= temp_count) {
+            temp_count = tac_dst(instr).value.temp_id + 1;
+        }
+    }
+    return temp_count; // Temps that are never defined are never known constants
+}
+
+bool fold_constants(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    ConstantTable table;
+    table.temp_count = count_temps(func);
+    table.current_block = 0;
+    table.values = arena_alloc(scratch, (size_t) table.temp_count * sizeof(int) + 1);
+    table.block = arena_alloc(scratch, (size_t) table.temp_count * sizeof(int) + 1);
+    if (!table.values || !table.block) {
+        fprintf(stderr, "Optimizer Error: Out of memory folding constants in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+    for (int t = 0; t < table.temp_count; ++t) {
+        table.block[t] = -1;
+    }
+
+    bool changed = false;
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        TacInstruction instr = func->instructions[i];
+        if (instr.type == TAC_INS_LABEL) {
+            table.current_block++; // Another path may join here: forget what this block knew
+        }
+        changed |= substitute_known_constants(&instr, &table);
+        const FoldResult result = simplify_instruction(&instr);
+        if (result == FOLD_REMOVED) {
+            changed = true;
+            continue;
+        }
+        changed |= result == FOLD_REWRITTEN;
+        record_definition(&instr, &table);
+        func->instructions[kept++] = instr;
+    }
+    func->instruction_count = kept;
+
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,26 @@
+#ifndef CLERIC_CONSTANT_FOLDING_H
+#define CLERIC_CONSTANT_FOLDING_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Constant folding and algebraic simplification over TAC
+//
+// Within each basic block, temps holding a known constant are substituted into
+// later instructions; operations whose operands are all constant become copies
+// of the result, and identities (x + 0, x * 1, x * 0, ...) become copies too.
+// Conditional jumps on a constant become a GOTO or disappear. Division and
+// remainder by zero (and INT_MIN / -1) are left for the program to trap on.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Folds constants in one function, rewriting its instruction array in place.
+ * @param func The function to simplify.
+ * @param scratch Arena for per-pass bookkeeping (released before returning).
+ * @return true if any instruction changed or was removed.
+ */
+bool fold_constants(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_CONSTANT_FOLDING_H
@@ -0,0 +1,125 @@
+#include "copy_propagation.h"
+#include "../ir/cfg.h"
+#include "../ir/liveness.h"
+#include <stdio.h>
+
+// Copies known along the current straight-line run of blocks. A temp's copy is
+// valid only while its source still holds the value it had at the copy, which
+// is checked by comparing definition counts instead of invalidating eagerly.
+typedef struct {
+    int *source;         // source[a] = b after `a = b`
+    int *source_version; // versions[b] when the copy was made
+    int *region;         // Run in which source[a] was recorded, -1 if none
+    int *versions;       // Number of definitions of each temp seen so far
+    int temp_count;
+    int current_region;
+} CopyTable;
+
+static bool is_temp(const TacOperand op) {
+    return op.type == TAC_OPERAND_TEMP;
+}
+
+// Returns the temp a reads through, or a itself if no copy of it is known
+static int resolve(const CopyTable *table, const int id) {
+    if (id < table->temp_count && table->region[id] == table->current_region &&
+        table->versions[table->source[id]] == table->source_version[id]) {
+        return table->source[id];
+    }
+    return id;
+}
+
+static bool substitute_copies(TacInstruction *instr, const CopyTable *table) {
+    const int use_count = tac_instruction_use_count(instr);
+    bool replaced = false;
+    for (int u = 0; u < use_count; ++u) {
+        const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+        if (!tac_slot_is_temp(instr, slot)) {
+            continue;
+        }
+        const int id = tac_get_operand(instr, slot).value.temp_id;
+        const int source = resolve(table, id);
+        if (source != id) {
+            tac_set_operand(instr, slot, create_tac_operand_temp(source));
+            replaced = true;
+        }
+    }
+    return replaced;
+}
+
+static void record_definition(const TacInstruction *instr, CopyTable *table) {
+    if (!tac_instruction_has_def(instr) || !tac_slot_is_temp(instr, TAC_SLOT_DST) ||
+        tac_dst(instr).value.temp_id >= table->temp_count) {
+        return;
+    }
+    const int id = tac_dst(instr).value.temp_id;
+    table->versions[id]++; // Invalidates every copy that read the old value of id
+    const TacOperand src = tac_src(instr);
+    if (instr->type == TAC_INS_COPY && is_temp(src) && src.value.temp_id != id) {
+        table->source[id] = src.value.temp_id;
+        table->source_version[id] = table->versions[src.value.temp_id];
+        table->region[id] = table->current_region;
+    } else {
+        table->region[id] = -1;
+    }
+}
+
+static bool is_self_copy(const TacInstruction *instr) {
+    return instr->type == TAC_INS_COPY && is_temp(tac_src(instr)) && is_temp(tac_dst(instr)) &&
+           tac_src(instr).value.temp_id == tac_dst(instr).value.temp_id;
+}
+
+// A block continues the previous run when control can only arrive by falling through from it
+static bool continues_previous_block(const Cfg *cfg, const int block) {
+    const CfgBlock *b = &cfg->blocks[block];
+    return block > 0 && b->predecessor_count == 1 && b->predecessors[0] == block - 1;
+}
+
+bool propagate_copies(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    Cfg cfg;
+    if (!cfg_build(func, scratch, &cfg)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    CopyTable table;
+    table.temp_count = tac_function_temp_count(func);
+    table.current_region = -1;
+    const size_t table_bytes = (size_t) table.temp_count * sizeof(int) + 1;
+    table.source = arena_alloc(scratch, table_bytes);
+    table.source_version = arena_alloc(scratch, table_bytes);
+    table.region = arena_alloc(scratch, table_bytes);
+    table.versions = arena_alloc_zeroed(scratch, table_bytes);
+    if (!table.source || !table.source_version || !table.region || !table.versions) {
+        fprintf(stderr, "Optimizer Error: Out of memory propagating copies in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+    for (int t = 0; t < table.temp_count; ++t) {
+        table.region[t] = -1;
+    }
+
+    bool changed = false;
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const int block = cfg.block_of[i];
+        if (cfg.blocks[block].first == i && !continues_previous_block(&cfg, block)) {
+            table.current_region = block; // Another path may join here: forget the copies
+        }
+        TacInstruction instr = func->instructions[i];
+        changed |= substitute_copies(&instr, &table);
+        if (is_self_copy(&instr)) {
+            changed = true;
+            continue;
+        }
+        record_definition(&instr, &table);
+        func->instructions[kept++] = instr;
+    }
+    func->instruction_count = kept;
+
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,27 @@
+#ifndef CLERIC_COPY_PROPAGATION_H
+#define CLERIC_COPY_PROPAGATION_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Copy propagation over TAC
+//
+// After `a = b` (both temps), later uses of a read b directly for as long as
+// neither is redefined. Copies are tracked along straight-line runs of the CFG:
+// a block whose only predecessor is the block right before it keeps what that
+// block knew; any other block starts from nothing. The copies themselves are
+// left for dead-temp elimination to remove once nothing reads them.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Propagates temp-to-temp copies in one function, rewriting uses in place.
+ *        Copies that became `a = a` are removed.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the CFG and per-pass bookkeeping (released before returning).
+ * @return true if any use was rewritten or any instruction removed.
+ */
+bool propagate_copies(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_COPY_PROPAGATION_H
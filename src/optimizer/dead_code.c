@@ -0,0 +1,74 @@
+#include "dead_code.h"
+#include "../ir/cfg.h"
+#include "../ir/liveness.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool may_trap(const TacInstruction *instr) {
+    if (instr->type != TAC_INS_DIV && instr->type != TAC_INS_MOD) {
+        return false;
+    }
+    const TacOperand divisor = tac_src2(instr);
+    return divisor.type != TAC_OPERAND_CONST || divisor.value.constant_value == 0 ||
+           divisor.value.constant_value == -1; // -1 traps for INT_MIN
+}
+
+bool eliminate_dead_temps(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    Cfg cfg;
+    Liveness liveness;
+    if (!cfg_build(func, scratch, &cfg) || !liveness_compute(&cfg, scratch, &liveness)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    if (liveness.temp_count == 0) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    uint64_t *live = arena_alloc(scratch, liveness.words * sizeof(uint64_t));
+    bool *dead = arena_alloc_zeroed(scratch, func->instruction_count * sizeof(bool));
+    if (!live || !dead) {
+        fprintf(stderr, "Optimizer Error: Out of memory eliminating dead temps in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+
+    bool changed = false;
+    for (int b = 0; b < cfg.block_count; ++b) {
+        memcpy(live, liveness_out_of(&liveness, b), liveness.words * sizeof(uint64_t));
+        for (size_t i = cfg.blocks[b].last + 1; i-- > cfg.blocks[b].first;) {
+            const TacInstruction *instr = &func->instructions[i];
+            if (tac_instruction_has_def(instr) && tac_slot_is_temp(instr, TAC_SLOT_DST)) {
+                const int id = tac_dst(instr).value.temp_id;
+                if (!liveness_set_contains(live, id) && !may_trap(instr)) {
+                    dead[i] = true; // Its operands are not read either
+                    changed = true;
+                    continue;
+                }
+                liveness_set_remove(live, id);
+            }
+            const int use_count = tac_instruction_use_count(instr);
+            for (int u = 0; u < use_count; ++u) {
+                const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+                if (tac_slot_is_temp(instr, slot)) {
+                    liveness_set_add(live, tac_get_operand(instr, slot).value.temp_id);
+                }
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        if (!dead[i]) {
+            func->instructions[kept++] = func->instructions[i];
+        }
+    }
+    func->instruction_count = kept;
+
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,25 @@
+#ifndef CLERIC_DEAD_CODE_H
+#define CLERIC_DEAD_CODE_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Dead-temp elimination over TAC
+//
+// An instruction whose result temp is not live afterwards (per CFG liveness)
+// is removed, unless it may trap: division and remainder are only removed when
+// the divisor is a constant other than 0 and -1. Each block is walked
+// backwards, so a chain of dead temps feeding each other goes in one pass.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Removes the instructions of one function whose results are never read.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the CFG and liveness sets (released before returning).
+ * @return true if any instruction was removed.
+ */
+bool eliminate_dead_temps(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_DEAD_CODE_H
@@ -0,0 +1,88 @@
+#include "jump_threading.h"
+#include "../ir/cfg.h"
+#include <stdio.h>
+
+static bool is_jump(const TacInstructionType type) {
+    return type == TAC_INS_GOTO || type == TAC_INS_IF_FALSE_GOTO || type == TAC_INS_IF_TRUE_GOTO;
+}
+
+// Where a jump to label really lands: past blocks made of labels that fall into the next
+// label or end in a GOTO. Each step goes to another block, so block_count steps are enough.
+static uint32_t final_target(const Cfg *cfg, uint32_t label) {
+    const TacInstruction *instructions = cfg->function->instructions;
+    for (int step = 0; step < cfg->block_count; ++step) {
+        const int b = cfg_block_for_label(cfg, label);
+        if (b < 0) {
+            return label;
+        }
+        const CfgBlock *block = &cfg->blocks[b];
+        size_t i = block->first + 1; // Past the label itself
+        while (i <= block->last && instructions[i].type == TAC_INS_LABEL) {
+            i++;
+        }
+        uint32_t next;
+        if (i <= block->last && i == block->last && instructions[i].type == TAC_INS_GOTO) {
+            next = tac_label(&instructions[i]).value.label_id;
+        } else if (i > block->last && b + 1 < cfg->block_count && cfg->blocks[b + 1].label != TAC_NO_LABEL) {
+            next = cfg->blocks[b + 1].label;
+        } else {
+            return label;
+        }
+        if (next == label) {
+            return label; // `L: goto L` never gets anywhere; leave it be
+        }
+        label = next;
+    }
+    return label;
+}
+
+bool thread_jumps(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    Cfg cfg;
+    if (!cfg_build(func, scratch, &cfg)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    int *references = arena_alloc_zeroed(scratch, ((size_t) cfg.label_bound + 1) * sizeof(int));
+    if (!references) {
+        fprintf(stderr, "Optimizer Error: Out of memory threading jumps in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+
+    // Targets are looked up in the CFG of the function as it was, which retargeting does not change
+    bool changed = false;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        TacInstruction *instr = &func->instructions[i];
+        if (!is_jump((TacInstructionType) instr->type)) {
+            continue;
+        }
+        const uint32_t label = tac_label(instr).value.label_id;
+        const uint32_t target = final_target(&cfg, label);
+        if (target != label) {
+            tac_set_operand(instr, TAC_SLOT_LABEL, create_tac_operand_label(target));
+            changed = true;
+        }
+        if (target < cfg.label_bound) {
+            references[target]++;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (instr->type == TAC_INS_LABEL && references[tac_label(instr).value.label_id] == 0) {
+            changed = true;
+            continue;
+        }
+        func->instructions[kept++] = *instr;
+    }
+    func->instruction_count = kept;
+
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,26 @@
+#ifndef CLERIC_JUMP_THREADING_H
+#define CLERIC_JUMP_THREADING_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Jump threading over TAC
+//
+// A jump to a label whose block does nothing but jump again (`L1: goto L2`),
+// or only falls into the next label, is retargeted to where control really
+// goes, following the chain through the CFG. Labels no jump names any more are
+// then removed, so the blocks around them merge for the passes that work on
+// straight-line runs.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Retargets jumps past blocks that only pass control on, then drops unused labels.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the CFG and label counts (released before returning).
+ * @return true if any jump was retargeted or any label removed.
+ */
+bool thread_jumps(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_JUMP_THREADING_H
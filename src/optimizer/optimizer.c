@@ -0,0 +1,192 @@
+#include "optimizer.h"
+#include "constant_folding.h"
+#include "copy_propagation.h"
+#include "dead_code.h"
+#include "value_numbering.h"
+#include "jump_threading.h"
+#include "unreachable_code.h"
+#include "block_layout.h"
+#include "../compiler/trace.h"
+#include <pthread.h>
+#include <stdio.h>
+
+// Initial size of each optimizer thread's scratch arena; it grows for large functions
+#define OPTIMIZER_WORKER_ARENA_SIZE (16 * 1024)
+
+// Passes feed each other (folding exposes more folding after later passes), so the
+// pipeline repeats until nothing changes, bounded to keep compile time predictable.
+#define OPTIMIZER_MAX_ROUNDS 4
+
+void optimizer_options_for_level(OptimizerOptions *options, const int level) {
+    *options = (OptimizerOptions){0};
+    options->fold_constants = level >= 1;
+    options->number_values = level >= 1;
+    options->propagate_copies = level >= 1;
+    options->eliminate_dead_temps = level >= 1;
+    options->thread_jumps = level >= 1;
+    options->eliminate_unreachable_code = level >= 1;
+    options->lay_out_blocks = level >= 1;
+    options->jobs = 1;
+}
+
+// Runs one pass, as an event of its own when tracing
+static bool run_pass(const char *name, bool (*pass)(TacFunction *, Arena *), TacFunction *func, Arena *arena) {
+    trace_begin("pass", name);
+    const bool changed = pass(func, arena);
+    trace_end("pass", name);
+    return changed;
+}
+
+// Returns false if a pass ran out of memory: passes report that as "no change", so the arena's refusals
+// are what tell a failed pass from one that found nothing to do
+static bool optimize_function(TacFunction *func, const OptimizerOptions *options, Arena *arena, bool *out_changed) {
+    trace_begin("optimize", func->name);
+    const size_t failed_allocs = arena->failed_allocs;
+    bool changed = false;
+    for (int round = 0; round < OPTIMIZER_MAX_ROUNDS; ++round) {
+        bool round_changed = false;
+        if (options->fold_constants) {
+            round_changed |= run_pass("fold_constants", fold_constants, func, arena);
+        }
+        if (options->number_values) {
+            // Leaves copies for the two passes below
+            round_changed |= run_pass("number_values", number_values, func, arena);
+        }
+        if (options->propagate_copies) {
+            round_changed |= run_pass("propagate_copies", propagate_copies, func, arena);
+        }
+        if (options->eliminate_dead_temps) {
+            // Cleans up after the two passes above
+            round_changed |= run_pass("eliminate_dead_temps", eliminate_dead_temps, func, arena);
+        }
+        if (options->thread_jumps) {
+            round_changed |= run_pass("thread_jumps", thread_jumps, func, arena);
+        }
+        if (options->eliminate_unreachable_code) {
+            // Blocks the threading and folding stopped jumping to go here
+            round_changed |= run_pass("eliminate_unreachable_code", eliminate_unreachable_code, func, arena);
+        }
+        if (options->lay_out_blocks) {
+            // Jumps the threading made redundant go here
+            round_changed |= run_pass("lay_out_blocks", lay_out_blocks, func, arena);
+        }
+        if (!round_changed || arena->failed_allocs != failed_allocs) {
+            break;
+        }
+        changed = true;
+    }
+    trace_end("optimize", func->name);
+    *out_changed |= changed;
+    if (arena->failed_allocs != failed_allocs) {
+        fprintf(stderr, "Optimizer Error: Ran out of memory optimizing function %s.\n", func->name);
+        return false;
+    }
+    return true;
+}
+
+// Functions handed out to the optimizer threads in order
+typedef struct {
+    TacProgram *program;
+    const OptimizerOptions *options;
+    size_t next_function;
+    bool changed;
+    bool failed;          // A function ran out of memory; the rest are left as they are
+    pthread_mutex_t lock; // Guards next_function, changed and failed
+} ParallelOptimizer;
+
+static void *optimizer_worker(void *data) {
+    ParallelOptimizer *shared = data;
+    Arena scratch = arena_create(OPTIMIZER_WORKER_ARENA_SIZE);
+    if (!scratch.start) {
+        fprintf(stderr, "Optimizer Error: Failed to create a worker arena\n");
+        return NULL; // The other workers take this one's functions
+    }
+    bool changed = false;
+    bool failed = false;
+    for (;;) {
+        pthread_mutex_lock(&shared->lock);
+        const size_t index = shared->failed ? shared->program->function_count : shared->next_function++;
+        pthread_mutex_unlock(&shared->lock);
+        if (index >= shared->program->function_count) {
+            break;
+        }
+        failed = !optimize_function(shared->program->functions[index], shared->options, &scratch, &changed);
+        arena_reset_with_mode(&scratch, ARENA_RESET_DIRTY);
+        if (failed) {
+            break;
+        }
+    }
+    arena_destroy(&scratch);
+    pthread_mutex_lock(&shared->lock);
+    shared->changed |= changed;
+    shared->failed |= failed;
+    pthread_mutex_unlock(&shared->lock);
+    return NULL;
+}
+
+// Largest number of optimizer threads started for one program
+#define OPTIMIZER_MAX_JOBS 256
+
+// Returns false, having changed nothing, if the threads could not be set up; *out_failed is set if a
+// function ran out of memory
+static bool optimize_in_parallel(TacProgram *program, const OptimizerOptions *options, Arena *arena,
+                                 bool *out_changed, bool *out_failed) {
+    ParallelOptimizer shared = {.program = program, .options = options};
+    if (pthread_mutex_init(&shared.lock, NULL) != 0) {
+        return false;
+    }
+    size_t worker_count = (size_t) options->jobs;
+    if (worker_count > program->function_count) {
+        worker_count = program->function_count;
+    }
+    if (worker_count > OPTIMIZER_MAX_JOBS) {
+        worker_count = OPTIMIZER_MAX_JOBS;
+    }
+    pthread_t threads[OPTIMIZER_MAX_JOBS];
+    size_t started = 0;
+    while (started + 1 < worker_count && pthread_create(&threads[started], NULL, optimizer_worker, &shared) == 0) {
+        started++;
+    }
+    // This thread is a worker too, with the caller's arena for scratch
+    bool changed = false;
+    bool failed = false;
+    for (;;) {
+        pthread_mutex_lock(&shared.lock);
+        const size_t index = shared.failed ? program->function_count : shared.next_function++;
+        pthread_mutex_unlock(&shared.lock);
+        if (index >= program->function_count) {
+            break;
+        }
+        if (!optimize_function(program->functions[index], options, arena, &changed)) {
+            pthread_mutex_lock(&shared.lock);
+            shared.failed = true;
+            pthread_mutex_unlock(&shared.lock);
+            failed = true;
+            break;
+        }
+    }
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&shared.lock);
+    *out_changed = changed || shared.changed;
+    *out_failed = failed || shared.failed;
+    return true;
+}
+
+bool optimize_tac_program(TacProgram *program, const OptimizerOptions *options, Arena *arena, bool *out_changed) {
+    bool changed = false;
+    bool failed = false;
+    if (!program) {
+        failed = true;
+    } else if (!(options->jobs > 1 && program->function_count > 1 &&
+                 optimize_in_parallel(program, options, arena, &changed, &failed))) {
+        for (size_t i = 0; !failed && i < program->function_count; ++i) {
+            failed = !optimize_function(program->functions[i], options, arena, &changed);
+        }
+    }
+    if (out_changed) {
+        *out_changed = changed;
+    }
+    return !failed;
+}
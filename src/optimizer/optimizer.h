@@ -0,0 +1,40 @@
+#ifndef CLERIC_OPTIMIZER_H
+#define CLERIC_OPTIMIZER_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+// Which TAC passes run between IR generation and code generation
+typedef struct {
+    bool fold_constants;       // Constant folding and algebraic identities
+    bool number_values;        // Global value numbering over SSA form (repeated expressions become copies)
+    bool propagate_copies;     // Temp-to-temp copy propagation
+    bool eliminate_dead_temps; // Removal of instructions whose result is never read
+    bool thread_jumps;         // Retargeting of jumps to blocks that only jump again
+    bool eliminate_unreachable_code; // Removal of blocks control never reaches, and of unused labels
+    bool lay_out_blocks;       // Block order favoring fall-through, dropping the jumps that saves
+    int jobs;                  // Optimize up to this many functions at once, each with its own scratch arena
+} OptimizerOptions;
+
+/**
+ * @brief Sets the options to the passes enabled at the given -O level (none at 0).
+ * @param options Pointer to the options to initialize.
+ * @param level The optimization level from the command line.
+ */
+void optimizer_options_for_level(OptimizerOptions *options, int level);
+
+/**
+ * @brief Runs the enabled passes over every function of the program. Functions are independent, so with
+ *        options->jobs > 1 they are spread over that many threads; the result is the same either way.
+ * @param program The TAC program, rewritten in place.
+ * @param options Which passes to run.
+ * @param arena Arena for scratch data; everything allocated here is released again (unused by the
+ *              worker threads, which create their own).
+ * @param out_changed If non-NULL, receives whether any pass changed the program.
+ * @return false (with an error printed) if a pass ran out of memory; the program is then only partly
+ *         optimized and must not be compiled further.
+ */
+bool optimize_tac_program(TacProgram *program, const OptimizerOptions *options, Arena *arena, bool *out_changed);
+
+#endif // CLERIC_OPTIMIZER_H
@@ -0,0 +1,46 @@
+#include "unreachable_code.h"
+#include "../ir/cfg.h"
+#include <stdio.h>
+
+bool eliminate_unreachable_code(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    Cfg cfg;
+    if (!cfg_build(func, scratch, &cfg)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    bool *reachable = arena_alloc(scratch, (size_t) cfg.block_count * sizeof(bool));
+    int *references = arena_alloc_zeroed(scratch, ((size_t) cfg.label_bound + 1) * sizeof(int));
+    if (!reachable || !references || !cfg_mark_reachable(&cfg, reachable, scratch)) {
+        fprintf(stderr, "Optimizer Error: Out of memory removing unreachable code in function %s.\n", func->name);
+        arena_release(scratch, mark);
+        return false;
+    }
+
+    // Only jumps that can still run keep their label
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const uint32_t target = cfg_jump_target(&func->instructions[i]);
+        if (target < cfg.label_bound && reachable[cfg.block_of[i]]) {
+            references[target]++;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        const TacInstruction *instr = &func->instructions[i];
+        if (!reachable[cfg.block_of[i]] ||
+            (instr->type == TAC_INS_LABEL && references[tac_label(instr).value.label_id] == 0)) {
+            continue;
+        }
+        func->instructions[kept++] = *instr;
+    }
+    const bool changed = kept != func->instruction_count;
+    func->instruction_count = kept;
+
+    arena_release(scratch, mark);
+    return changed;
+}
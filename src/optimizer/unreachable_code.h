@@ -0,0 +1,26 @@
+#ifndef CLERIC_UNREACHABLE_CODE_H
+#define CLERIC_UNREACHABLE_CODE_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Unreachable-code elimination over TAC
+//
+// Blocks the CFG cannot reach from the entry block are removed: code after a
+// RETURN or GOTO up to the next label, and labelled blocks whose every jump
+// was folded or threaded away. Labels that no remaining jump names are removed
+// too, so the blocks around them merge for the passes that work on
+// straight-line runs.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Removes the blocks of one function that control never reaches, then its unused labels.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the CFG and label counts (released before returning).
+ * @return true if any instruction was removed.
+ */
+bool eliminate_unreachable_code(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_UNREACHABLE_CODE_H
@@ -0,0 +1,223 @@
+#include "value_numbering.h"
+#include "../ir/ssa.h"
+#include <stdio.h>
+
+// An expression computed on the way down the dominator tree
+typedef struct {
+    uint8_t type;          // TacInstructionType, after canonicalization
+    uint8_t operand_kinds; // Kinds of the two operands, as in TacInstruction
+    uint32_t operands[2];  // Value numbers of temps, or constants
+    int holder;            // Name of the temp that holds the result
+    int next;              // Next entry of the same bucket, -1 at the end
+} Expression;
+
+// Buckets and entries form a stack: leaving a block pops what it pushed
+typedef struct {
+    int *buckets;
+    size_t bucket_mask;
+    Expression *entries;
+    int entry_count;
+    int *scope_marks; // entry_count on entering each open block
+    int scope_count;
+} ExpressionTable;
+
+// Operators whose result depends on nothing but their operands. Division and
+// remainder qualify too: the second one is only reached once the first did not trap.
+static bool is_pure(const TacInstructionType type) {
+    switch (type) {
+        case TAC_INS_NEGATE:
+        case TAC_INS_COMPLEMENT:
+        case TAC_INS_LOGICAL_NOT:
+        case TAC_INS_ADD:
+        case TAC_INS_SUB:
+        case TAC_INS_MUL:
+        case TAC_INS_DIV:
+        case TAC_INS_MOD:
+        case TAC_INS_LOGICAL_AND:
+        case TAC_INS_LOGICAL_OR:
+        case TAC_INS_LESS:
+        case TAC_INS_GREATER:
+        case TAC_INS_LESS_EQUAL:
+        case TAC_INS_GREATER_EQUAL:
+        case TAC_INS_EQUAL:
+        case TAC_INS_NOT_EQUAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_commutative(const TacInstructionType type) {
+    return type == TAC_INS_ADD || type == TAC_INS_MUL || type == TAC_INS_EQUAL || type == TAC_INS_NOT_EQUAL ||
+           type == TAC_INS_LOGICAL_AND || type == TAC_INS_LOGICAL_OR;
+}
+
+static bool same_expression(const Expression *a, const Expression *b) {
+    return a->type == b->type && a->operand_kinds == b->operand_kinds && a->operands[0] == b->operands[0] &&
+           a->operands[1] == b->operands[1];
+}
+
+static size_t hash_expression(const Expression *e) {
+    uint64_t h = (uint64_t) e->type << 8 | e->operand_kinds;
+    h = (h ^ e->operands[0]) * 0x9e3779b97f4a7c15u;
+    h = (h ^ e->operands[1]) * 0x9e3779b97f4a7c15u;
+    return (size_t) (h >> 32);
+}
+
+// Builds the key of an instruction: operands by value number, in a canonical order
+static Expression describe(const TacInstruction *instr, const int *value_of) {
+    Expression e = {.type = instr->type, .holder = -1, .next = -1};
+    uint8_t kinds[2] = {0, 0};
+    const int use_count = tac_instruction_use_count(instr);
+    for (int u = 0; u < use_count; ++u) {
+        const TacOperandSlot slot = (TacOperandSlot) (TAC_SLOT_SRC1 + u);
+        const TacOperand op = tac_get_operand(instr, slot);
+        kinds[u] = (uint8_t) op.type;
+        e.operands[u] = op.type == TAC_OPERAND_TEMP ? (uint32_t) value_of[op.value.temp_id]
+                                                    : (uint32_t) op.value.constant_value;
+    }
+    bool swap = false;
+    if (e.type == TAC_INS_GREATER || e.type == TAC_INS_GREATER_EQUAL) {
+        e.type = e.type == TAC_INS_GREATER ? TAC_INS_LESS : TAC_INS_LESS_EQUAL;
+        swap = true;
+    } else if (is_commutative((TacInstructionType) e.type)) {
+        swap = kinds[0] > kinds[1] || (kinds[0] == kinds[1] && e.operands[0] > e.operands[1]);
+    }
+    if (swap) {
+        const uint32_t operand = e.operands[0];
+        e.operands[0] = e.operands[1];
+        e.operands[1] = operand;
+        const uint8_t kind = kinds[0];
+        kinds[0] = kinds[1];
+        kinds[1] = kind;
+    }
+    e.operand_kinds = (uint8_t) (kinds[0] | kinds[1] << TAC_OPERAND_KIND_BITS);
+    return e;
+}
+
+// The newest entry for an expression, or NULL
+static const Expression *lookup(const ExpressionTable *table, const Expression *e) {
+    for (int i = table->buckets[hash_expression(e) & table->bucket_mask]; i >= 0; i = table->entries[i].next) {
+        if (same_expression(&table->entries[i], e)) {
+            return &table->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void push(ExpressionTable *table, Expression e) {
+    int *bucket = &table->buckets[hash_expression(&e) & table->bucket_mask];
+    e.next = *bucket;
+    table->entries[table->entry_count] = e;
+    *bucket = table->entry_count++;
+}
+
+static void leave_scope(ExpressionTable *table) {
+    const int mark = table->scope_marks[--table->scope_count];
+    while (table->entry_count > mark) {
+        const Expression *e = &table->entries[--table->entry_count];
+        table->buckets[hash_expression(e) & table->bucket_mask] = e->next;
+    }
+}
+
+static void rewrite_as_copy(TacInstruction *instr, const int dst, const int src) {
+    const TacInstruction copy = {.type = TAC_INS_COPY};
+    *instr = copy;
+    tac_set_operand(instr, TAC_SLOT_DST, create_tac_operand_temp(dst));
+    tac_set_operand(instr, TAC_SLOT_SRC1, create_tac_operand_temp(src));
+}
+
+// A phi whose arguments all carry the same value carries it too
+static int value_of_phi(const SsaPhi *phi, const int predecessor_count, const int *value_of) {
+    const int value = value_of[phi->args[0]];
+    for (int p = 1; p < predecessor_count; ++p) {
+        if (value_of[phi->args[p]] != value) {
+            return phi->name;
+        }
+    }
+    return value;
+}
+
+static bool number_block(const SsaFunction *ssa, SsaVersions *versions, ExpressionTable *table, int *value_of,
+                         const int b) {
+    const CfgBlock *block = &ssa->cfg.blocks[b];
+    for (const SsaPhi *phi = ssa->phis[b]; phi; phi = phi->next) {
+        value_of[phi->name] = value_of_phi(phi, block->predecessor_count, value_of);
+        ssa_versions_define(versions, ssa, phi->name);
+    }
+    bool changed = false;
+    for (size_t i = block->first; i <= block->last; ++i) {
+        TacInstruction *instr = &ssa->function->instructions[i];
+        if (!tac_instruction_has_def(instr) || !tac_slot_is_temp(instr, TAC_SLOT_DST)) {
+            continue;
+        }
+        const int name = tac_dst(instr).value.temp_id;
+        if (instr->type == TAC_INS_COPY && tac_slot_is_temp(instr, TAC_SLOT_SRC1)) {
+            value_of[name] = value_of[tac_src(instr).value.temp_id];
+        } else if (is_pure((TacInstructionType) instr->type)) {
+            Expression e = describe(instr, value_of);
+            const Expression *known = lookup(table, &e);
+            // The holder must not have been overwritten by then, or leaving SSA would read the new value
+            if (known && ssa_is_current(versions, ssa, known->holder)) {
+                rewrite_as_copy(instr, name, known->holder);
+                value_of[name] = value_of[known->holder];
+                changed = true;
+            } else {
+                e.holder = name;
+                push(table, e);
+            }
+        }
+        ssa_versions_define(versions, ssa, name);
+    }
+    return changed;
+}
+
+bool number_values(TacFunction *func, Arena *scratch) {
+    if (!func || func->instruction_count == 0) {
+        return false;
+    }
+    const ArenaMark mark = arena_mark(scratch);
+
+    SsaFunction ssa;
+    if (!ssa_construct(func, scratch, &ssa)) {
+        arena_release(scratch, mark);
+        return false;
+    }
+    SsaVersions versions;
+    ExpressionTable table = {0};
+    size_t bucket_count = 16;
+    while (bucket_count < 2 * func->instruction_count) {
+        bucket_count *= 2;
+    }
+    table.bucket_mask = bucket_count - 1;
+    table.buckets = arena_alloc(scratch, bucket_count * sizeof(int));
+    table.entries = arena_alloc(scratch, func->instruction_count * sizeof(Expression));
+    table.scope_marks = arena_alloc(scratch, (size_t) ssa.cfg.block_count * sizeof(int) + sizeof(int));
+    int *value_of = arena_alloc(scratch, (size_t) ssa.name_bound * sizeof(int) + sizeof(int));
+    if (!table.buckets || !table.entries || !table.scope_marks || !value_of ||
+        !ssa_versions_init(&versions, &ssa, scratch)) {
+        fprintf(stderr, "Optimizer Error: Out of memory numbering values in function %s.\n", func->name);
+        ssa_destruct(&ssa);
+        arena_release(scratch, mark);
+        return false;
+    }
+    for (size_t i = 0; i < bucket_count; ++i) {
+        table.buckets[i] = -1;
+    }
+    for (int name = 0; name < ssa.name_bound; ++name) {
+        value_of[name] = name;
+    }
+
+    bool changed = false;
+    for (int position = 0; position < ssa.order_count; ++position) {
+        for (int left = ssa_versions_enter(&versions, &ssa, position); left > 0; --left) {
+            leave_scope(&table);
+        }
+        table.scope_marks[table.scope_count++] = table.entry_count;
+        changed |= number_block(&ssa, &versions, &table, value_of, ssa.preorder[position]);
+    }
+
+    ssa_destruct(&ssa);
+    arena_release(scratch, mark);
+    return changed;
+}
@@ -0,0 +1,28 @@
+#ifndef CLERIC_VALUE_NUMBERING_H
+#define CLERIC_VALUE_NUMBERING_H
+
+#include <stdbool.h>
+#include "../ir/tac.h"
+#include "../memory/arena.h"
+
+//------------------------------------------------------------------------------
+// Global value numbering over TAC
+//
+// The function is put in SSA form (ssa.h) and its dominator tree walked with a
+// scoped table of the expressions computed so far, keyed by operator and the
+// value numbers of the operands. Commutative operators sort their operands
+// and `a > b` is looked up as `b < a`, so `(a + b) < c && c > (b + a)` computes
+// the sum and the comparison once. A repeated expression becomes a COPY of the
+// temp that already holds it, left for copy propagation and dead-temp
+// elimination; then the function goes back out of SSA form.
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Replaces expressions already computed on every path to them by copies.
+ * @param func The function to rewrite.
+ * @param scratch Arena for the SSA form and the expression table (released before returning).
+ * @return true if any instruction was replaced.
+ */
+bool number_values(TacFunction *func, Arena *scratch);
+
+#endif // CLERIC_VALUE_NUMBERING_H
@@ -5,7 +5,7 @@
 
 // Function to create an integer literal node
 IntLiteralNode *create_int_literal_node(const int value, Arena* arena) {
-    IntLiteralNode *node = arena_alloc(arena, sizeof(IntLiteralNode));
+    IntLiteralNode *node = arena_alloc_tagged(arena, sizeof(IntLiteralNode), ARENA_TAG_AST);
     if (!node) {
         // arena_alloc already prints errors, just return NULL
         return NULL;
@@ -17,7 +17,7 @@ IntLiteralNode *create_int_literal_node(const int value, Arena* arena) {
 
 // Function to create a return statement node
 ReturnStmtNode *create_return_stmt_node(AstNode *expression, Arena* arena) {
-    ReturnStmtNode *node = arena_alloc(arena, sizeof(ReturnStmtNode));
+    ReturnStmtNode *node = arena_alloc_tagged(arena, sizeof(ReturnStmtNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
@@ -26,28 +26,45 @@ ReturnStmtNode *create_return_stmt_node(AstNode *expression, Arena* arena) {
     return node;
 }
 
+// Copies `len` bytes of a (not necessarily NUL-terminated) name into the arena, adding the terminator.
+// With an interner, returns the canonical copy instead so equal names share one pointer.
+static const char *copy_name(const char *name, const size_t len, StringInterner *interner, Arena *arena) {
+    if (interner) {
+        return interner_intern_n(interner, name, len);
+    }
+    char *copy = arena_alloc_tagged(arena, len + 1, ARENA_TAG_AST);
+    if (copy) {
+        memcpy(copy, name, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
 // Function to create a function definition node
 FuncDefNode *create_func_def_node(const char *name, BlockNode *body, Arena* arena) {
-    FuncDefNode *node = arena_alloc(arena, sizeof(FuncDefNode));
+    return create_func_def_node_n(name, name ? strlen(name) : 0, body, NULL, arena);
+}
+
+FuncDefNode *create_func_def_node_n(const char *name, const size_t name_len, BlockNode *body, StringInterner *interner,
+                                    Arena* arena) {
+    FuncDefNode *node = arena_alloc_tagged(arena, sizeof(FuncDefNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
     node->base.type = NODE_FUNC_DEF;
     node->body = body; // Body node allocated previously (likely in same arena)
+    node->body_node_count = 0;
 
     // Allocate space for name in the arena and copy it
     if (name) {
-        size_t name_len = strlen(name);
-        node->name = arena_alloc(arena, name_len + 1);
+        node->name = copy_name(name, name_len, interner, arena);
         if (!node->name) {
             // Allocation for name failed, even though node allocation succeeded.
-            // This is unlikely but possible if arena is exactly full.
             // The FuncDefNode is allocated but unusable without a name.
             // Return NULL to indicate overall failure.
             // The partially allocated FuncDefNode remains in the arena but won't be used.
             return NULL;
         }
-        strcpy(node->name, name); // strcpy is safe due to allocating name_len + 1 bytes
     } else {
         node->name = NULL;
     }
@@ -57,18 +74,19 @@ FuncDefNode *create_func_def_node(const char *name, BlockNode *body, Arena* aren
 
 // Function to create the program node
 ProgramNode *create_program_node(FuncDefNode *function, Arena* arena) {
-    ProgramNode *node = arena_alloc(arena, sizeof(ProgramNode));
+    ProgramNode *node = arena_alloc_tagged(arena, sizeof(ProgramNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
     node->base.type = NODE_PROGRAM;
     node->function = function; // Function node allocated previously (likely in same arena)
+    node->interner = NULL;
     return node;
 }
 
 // Function to create a unary operation node
 UnaryOpNode *create_unary_op_node(const UnaryOperatorType op, AstNode *operand, Arena *arena) {
-    UnaryOpNode *node = arena_alloc(arena, sizeof(UnaryOpNode));
+    UnaryOpNode *node = arena_alloc_tagged(arena, sizeof(UnaryOpNode), ARENA_TAG_AST);
     if (!node) {
         return NULL; // Allocation failed
     }
@@ -80,7 +98,7 @@ UnaryOpNode *create_unary_op_node(const UnaryOperatorType op, AstNode *operand,
 
 // Function to create a binary operation node
 BinaryOpNode *create_binary_op_node(const BinaryOperatorType op, AstNode *left, AstNode *right, Arena *arena) {
-    BinaryOpNode *node = arena_alloc(arena, sizeof(BinaryOpNode));
+    BinaryOpNode *node = arena_alloc_tagged(arena, sizeof(BinaryOpNode), ARENA_TAG_AST);
     if (!node) {
         return NULL; // Allocation failed
     }
@@ -93,7 +111,12 @@ BinaryOpNode *create_binary_op_node(const BinaryOperatorType op, AstNode *left,
 
 // Function to create a variable declaration node
 VarDeclNode *create_var_decl_node(const char *type_name, const char *var_name, AstNode *initializer, Arena *arena) {
-    VarDeclNode *node = arena_alloc(arena, sizeof(VarDeclNode));
+    return create_var_decl_node_n(type_name, var_name, var_name ? strlen(var_name) : 0, initializer, NULL, arena);
+}
+
+VarDeclNode *create_var_decl_node_n(const char *type_name, const char *var_name, const size_t var_name_len,
+                                    AstNode *initializer, StringInterner *interner, Arena *arena) {
+    VarDeclNode *node = arena_alloc_tagged(arena, sizeof(VarDeclNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
@@ -102,24 +125,20 @@ VarDeclNode *create_var_decl_node(const char *type_name, const char *var_name, A
 
     // Allocate space for type_name in the arena and copy it
     if (type_name) {
-        size_t type_name_len = strlen(type_name);
-        node->type_name = arena_alloc(arena, type_name_len + 1);
+        node->type_name = copy_name(type_name, strlen(type_name), interner, arena);
         if (!node->type_name) {
             return NULL; // Allocation failed
         }
-        strcpy(node->type_name, type_name);
     } else {
         node->type_name = NULL; // Should not happen for valid declarations
     }
 
     // Allocate space for var_name in the arena and copy it
     if (var_name) {
-        size_t var_name_len = strlen(var_name);
-        node->var_name = arena_alloc(arena, var_name_len + 1);
+        node->var_name = copy_name(var_name, var_name_len, interner, arena);
         if (!node->var_name) {
             return NULL; // Allocation failed
         }
-        strcpy(node->var_name, var_name);
     } else {
         node->var_name = NULL; // Should not happen for valid declarations
     }
@@ -129,19 +148,22 @@ VarDeclNode *create_var_decl_node(const char *type_name, const char *var_name, A
 
 // Function to create an identifier node
 IdentifierNode *create_identifier_node(const char *name, Arena *arena) {
-    IdentifierNode *node = arena_alloc(arena, sizeof(IdentifierNode));
+    return create_identifier_node_n(name, name ? strlen(name) : 0, NULL, arena);
+}
+
+IdentifierNode *create_identifier_node_n(const char *name, const size_t name_len, StringInterner *interner,
+                                         Arena *arena) {
+    IdentifierNode *node = arena_alloc_tagged(arena, sizeof(IdentifierNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
     node->base.type = NODE_IDENTIFIER;
 
     if (name) {
-        size_t name_len = strlen(name);
-        node->name = arena_alloc(arena, name_len + 1);
+        node->name = copy_name(name, name_len, interner, arena);
         if (!node->name) {
             return NULL; // Allocation failed
         }
-        strcpy(node->name, name);
     } else {
         node->name = NULL; // Should not happen for valid identifiers
     }
@@ -150,7 +172,7 @@ IdentifierNode *create_identifier_node(const char *name, Arena *arena) {
 
 // Function to create a block node
 BlockNode *create_block_node(Arena *arena) {
-    BlockNode *node = arena_alloc(arena, sizeof(BlockNode));
+    BlockNode *node = arena_alloc_tagged(arena, sizeof(BlockNode), ARENA_TAG_AST);
     if (!node) {
         return NULL;
     }
@@ -171,7 +193,7 @@ bool block_node_add_item(BlockNode *block, AstNode *item, Arena *arena) {
 
     if (block->num_items >= block->capacity) {
         size_t new_capacity = (block->capacity == 0) ? INITIAL_BLOCK_CAPACITY : block->capacity * 2;
-        AstNode **new_items = arena_alloc(arena, new_capacity * sizeof(AstNode *));
+        AstNode **new_items = arena_alloc_tagged(arena, new_capacity * sizeof(AstNode *), ARENA_TAG_AST);
         if (!new_items) {
             return false; // Allocation failed
         }
@@ -183,6 +205,7 @@ bool block_node_add_item(BlockNode *block, AstNode *item, Arena *arena) {
             }
             // The old block->items array was allocated from the arena, so it doesn't need to be freed here.
             // It will be reclaimed when the arena is reset or destroyed.
+            arena_note_superseded(arena, block->capacity * sizeof(AstNode *), ARENA_TAG_AST);
         }
         
         block->items = new_items;
@@ -200,6 +223,36 @@ static void print_indent(int level) {
     }
 }
 
+const char *ast_unary_operator_name(const UnaryOperatorType op) {
+    switch (op) {
+        case OPERATOR_NEGATE: return "Negate";
+        case OPERATOR_COMPLEMENT: return "Complement";
+        case OPERATOR_LOGICAL_NOT: return "LogicalNot";
+        default: return "UnknownUnaryOp";
+    }
+}
+
+const char *ast_binary_operator_name(const BinaryOperatorType op) {
+    switch (op) {
+        case OPERATOR_ADD: return "Add";
+        case OPERATOR_SUBTRACT: return "Subtract";
+        case OPERATOR_MULTIPLY: return "Multiply";
+        case OPERATOR_DIVIDE: return "Divide";
+        case OPERATOR_MODULO: return "Modulo";
+        case OPERATOR_LESS: return "Less";
+        case OPERATOR_GREATER: return "Greater";
+        case OPERATOR_LESS_EQUAL: return "LessEqual";
+        case OPERATOR_GREATER_EQUAL: return "GreaterEqual";
+        case OPERATOR_EQUAL_EQUAL: return "EqualEqual";
+        case OPERATOR_NOT_EQUAL: return "NotEqual";
+        case OPERATOR_LOGICAL_AND: return "LogicalAnd";
+        case OPERATOR_LOGICAL_OR: return "LogicalOr";
+        case OPERATOR_ASSIGN: return "Assign";
+        case OPERATOR_COMMA: return "Comma";
+        default: return "UnknownBinaryOp";
+    }
+}
+
 // Recursive function to pretty-print the AST
 void ast_pretty_print(AstNode *node, const int indent_level) { // NOLINT(*-no-recursion)
     if (!node) {
@@ -240,14 +293,7 @@ void ast_pretty_print(AstNode *node, const int indent_level) { // NOLINT(*-no-re
         }
         case NODE_UNARY_OP: { // Added case for unary operators
             const UnaryOpNode *unary_node = (UnaryOpNode *) node;
-            const char *op_str;
-            switch (unary_node->op) {
-                case OPERATOR_NEGATE: op_str = "Negate"; break;
-                case OPERATOR_COMPLEMENT: op_str = "Complement"; break;
-                case OPERATOR_LOGICAL_NOT: op_str = "LogicalNot"; break;
-                default: op_str = "UnknownUnaryOp"; break;
-            }
-            printf("UnaryOp(op=%s,\n", op_str);
+            printf("UnaryOp(op=%s,\n", ast_unary_operator_name(unary_node->op));
             ast_pretty_print(unary_node->operand, indent_level + 1);
             print_indent(indent_level);
             printf(")\n");
@@ -255,26 +301,7 @@ void ast_pretty_print(AstNode *node, const int indent_level) { // NOLINT(*-no-re
         }
         case NODE_BINARY_OP: {
             const BinaryOpNode *bin_node = (BinaryOpNode *) node;
-            const char *op_str;
-            switch (bin_node->op) {
-                case OPERATOR_ADD: op_str = "Add"; break;
-                case OPERATOR_SUBTRACT: op_str = "Subtract"; break;
-                case OPERATOR_MULTIPLY: op_str = "Multiply"; break;
-                case OPERATOR_DIVIDE: op_str = "Divide"; break;
-                case OPERATOR_MODULO: op_str = "Modulo"; break;
-                case OPERATOR_LESS: op_str = "Less"; break;
-                case OPERATOR_GREATER: op_str = "Greater"; break;
-                case OPERATOR_LESS_EQUAL: op_str = "LessEqual"; break;
-                case OPERATOR_GREATER_EQUAL: op_str = "GreaterEqual"; break;
-                case OPERATOR_EQUAL_EQUAL: op_str = "EqualEqual"; break;
-                case OPERATOR_NOT_EQUAL: op_str = "NotEqual"; break;
-                case OPERATOR_LOGICAL_AND: op_str = "LogicalAnd"; break;
-                case OPERATOR_LOGICAL_OR: op_str = "LogicalOr"; break;
-                case OPERATOR_ASSIGN: op_str = "Assign"; break;
-                case OPERATOR_COMMA: op_str = "Comma"; break;
-                default: op_str = "UnknownBinaryOp"; break;
-            }
-            printf("BinaryOp(op=%s,\n", op_str);
+            printf("BinaryOp(op=%s,\n", ast_binary_operator_name(bin_node->op));
             print_indent(indent_level + 1);
             printf("left=\n");
             ast_pretty_print(bin_node->left, indent_level + 2);
@@ -327,3 +354,129 @@ void ast_pretty_print(AstNode *node, const int indent_level) { // NOLINT(*-no-re
             break;
     }
 }
+
+size_t ast_count_nodes(const AstNode *node) { // NOLINT(*-no-recursion)
+    if (!node) {
+        return 0;
+    }
+    switch (node->type) {
+        case NODE_PROGRAM:
+            return 1 + ast_count_nodes((const AstNode *) ((const ProgramNode *) node)->function);
+        case NODE_FUNC_DEF:
+            return 1 + ast_count_nodes((const AstNode *) ((const FuncDefNode *) node)->body);
+        case NODE_RETURN_STMT:
+            return 1 + ast_count_nodes(((const ReturnStmtNode *) node)->expression);
+        case NODE_UNARY_OP:
+            return 1 + ast_count_nodes(((const UnaryOpNode *) node)->operand);
+        case NODE_BINARY_OP: {
+            const BinaryOpNode *bin_node = (const BinaryOpNode *) node;
+            return 1 + ast_count_nodes(bin_node->left) + ast_count_nodes(bin_node->right);
+        }
+        case NODE_VAR_DECL:
+            return 1 + ast_count_nodes(((const VarDeclNode *) node)->initializer);
+        case NODE_BLOCK: {
+            const BlockNode *block = (const BlockNode *) node;
+            size_t count = 1;
+            for (size_t i = 0; i < block->num_items; ++i) {
+                count += ast_count_nodes(block->items[i]);
+            }
+            return count;
+        }
+        case NODE_INT_LITERAL:
+        case NODE_IDENTIFIER:
+        default:
+            return 1;
+    }
+}
+
+// Feeds bytes to both lanes: FNV-1a, and a rotate-multiply hash whose collisions are unrelated to FNV's
+static void fingerprint_bytes(AstFingerprint *fp, const void *data, const size_t length) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; ++i) {
+        fp->lanes[0] ^= bytes[i];
+        fp->lanes[0] *= 1099511628211u;
+        const uint64_t mixed = fp->lanes[1] ^ bytes[i];
+        fp->lanes[1] = (mixed << 5 | mixed >> 59) * 0x9e3779b97f4a7c15u;
+    }
+}
+
+static void fingerprint_int(AstFingerprint *fp, const long long value) {
+    fingerprint_bytes(fp, &value, sizeof(value));
+}
+
+// Names end with their terminator, so "ab" + "c" and "a" + "bc" differ
+static void fingerprint_name(AstFingerprint *fp, const char *name) {
+    if (name) {
+        fingerprint_bytes(fp, name, strlen(name) + 1);
+    } else {
+        fingerprint_int(fp, -1);
+    }
+}
+
+static void fingerprint_node(AstFingerprint *fp, const AstNode *node) { // NOLINT(*-no-recursion)
+    if (!node) {
+        fingerprint_int(fp, -1);
+        return;
+    }
+    fingerprint_int(fp, node->type);
+    switch (node->type) {
+        case NODE_PROGRAM:
+            fingerprint_node(fp, (const AstNode *) ((const ProgramNode *) node)->function);
+            break;
+        case NODE_FUNC_DEF: {
+            const FuncDefNode *func = (const FuncDefNode *) node;
+            fingerprint_name(fp, func->name);
+            fingerprint_node(fp, (const AstNode *) func->body);
+            break;
+        }
+        case NODE_RETURN_STMT:
+            fingerprint_node(fp, ((const ReturnStmtNode *) node)->expression);
+            break;
+        case NODE_INT_LITERAL:
+            fingerprint_int(fp, ((const IntLiteralNode *) node)->value);
+            break;
+        case NODE_UNARY_OP: {
+            const UnaryOpNode *unary = (const UnaryOpNode *) node;
+            fingerprint_int(fp, unary->op);
+            fingerprint_node(fp, unary->operand);
+            break;
+        }
+        case NODE_BINARY_OP: {
+            const BinaryOpNode *binary = (const BinaryOpNode *) node;
+            fingerprint_int(fp, binary->op);
+            fingerprint_node(fp, binary->left);
+            fingerprint_node(fp, binary->right);
+            break;
+        }
+        case NODE_VAR_DECL: {
+            const VarDeclNode *decl = (const VarDeclNode *) node;
+            fingerprint_name(fp, decl->type_name);
+            fingerprint_name(fp, decl->var_name);
+            fingerprint_node(fp, decl->initializer);
+            break;
+        }
+        case NODE_IDENTIFIER:
+            fingerprint_name(fp, ((const IdentifierNode *) node)->name);
+            break;
+        case NODE_BLOCK: {
+            const BlockNode *block = (const BlockNode *) node;
+            fingerprint_int(fp, (long long) block->num_items);
+            for (size_t i = 0; i < block->num_items; ++i) {
+                fingerprint_node(fp, block->items[i]);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+AstFingerprint ast_fingerprint(const AstNode *node) {
+    AstFingerprint fp = {{14695981039346656037u, 0x243f6a8885a308d3u}};
+    fingerprint_node(&fp, node);
+    return fp;
+}
+
+bool ast_fingerprint_equal(const AstFingerprint a, const AstFingerprint b) {
+    return a.lanes[0] == b.lanes[0] && a.lanes[1] == b.lanes[1];
+}
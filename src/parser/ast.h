@@ -1,7 +1,9 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stdint.h>
 #include "memory/arena.h" // Include arena header
+#include "strings/interner.h" // Canonical names shared across stages
 
 // Define the types of AST nodes we need for "int main(void) { return 2; }"
 typedef enum {
@@ -77,15 +79,15 @@ typedef struct {
 // Structure for a variable declaration node
 typedef struct {
     AstNode base;          // type = NODE_VAR_DECL
-    char *type_name;       // For now, just the string name of the type (e.g., "int")
-    char *var_name;        // Name of the variable
+    const char *type_name; // For now, just the string name of the type (e.g., "int")
+    const char *var_name;  // Name of the variable
     AstNode *initializer;  // Optional expression for initialization (can be NULL)
 } VarDeclNode;
 
 // Structure for an identifier node (usage of a variable)
 typedef struct {
     AstNode base;          // type = NODE_IDENTIFIER
-    char *name;            // Name of the identifier being referenced
+    const char *name;      // Name of the identifier being referenced
 } IdentifierNode;
 
 // Structure for a return statement node
@@ -107,8 +109,9 @@ typedef struct {
 // Simplified for "int main(void) { return 2; }"
 typedef struct {
     AstNode base; // type = NODE_FUNC_DEF
-    char *name; // Name of the function (e.g., "main")
+    const char *name; // Name of the function (e.g., "main")
     BlockNode *body; // The block of code forming the function's body
+    size_t body_node_count; // Nodes in the body, counted by the parser (0 for hand-built trees); sizes the TAC
 } FuncDefNode;
 
 // Structure for the program node (root of the AST)
@@ -116,6 +119,8 @@ typedef struct {
     AstNode base; // type = NODE_PROGRAM
     // For now, we assume only one function definition in the program
     FuncDefNode *function;
+    // Interner holding every name in the tree (NULL for hand-built trees whose names are plain copies)
+    StringInterner *interner;
 } ProgramNode;
 
 // Function to create an integer literal node (convenience constructor)
@@ -129,9 +134,16 @@ BinaryOpNode *create_binary_op_node(BinaryOperatorType op, AstNode *left, AstNod
 
 // Function to create a variable declaration node (convenience constructor)
 VarDeclNode *create_var_decl_node(const char *type_name, const char *var_name, AstNode *initializer, Arena *arena);
+// Same, taking the variable name as a (pointer, length) slice that need not be NUL-terminated.
+// With a non-NULL interner the names are interned instead of copied.
+VarDeclNode *create_var_decl_node_n(const char *type_name, const char *var_name, size_t var_name_len,
+                                    AstNode *initializer, StringInterner *interner, Arena *arena);
 
 // Function to create an identifier node (convenience constructor)
 IdentifierNode *create_identifier_node(const char *name, Arena *arena);
+// Same, taking the name as a (pointer, length) slice that need not be NUL-terminated.
+// With a non-NULL interner the name is interned instead of copied.
+IdentifierNode *create_identifier_node_n(const char *name, size_t name_len, StringInterner *interner, Arena *arena);
 
 // Function to create a return statement node (convenience constructor)
 ReturnStmtNode *create_return_stmt_node(AstNode *expression, Arena* arena);
@@ -145,6 +157,10 @@ bool block_node_add_item(BlockNode *block, AstNode *item, Arena *arena);
 // Function to create a function definition node (convenience constructor)
 // Takes the function name and body statement as input
 FuncDefNode *create_func_def_node(const char *name, BlockNode *body, Arena* arena);
+// Same, taking the name as a (pointer, length) slice that need not be NUL-terminated.
+// With a non-NULL interner the name is interned instead of copied.
+FuncDefNode *create_func_def_node_n(const char *name, size_t name_len, BlockNode *body, StringInterner *interner,
+                                    Arena* arena);
 
 // Function to create the program node (convenience constructor)
 ProgramNode *create_program_node(FuncDefNode *function, Arena* arena);
@@ -156,5 +172,24 @@ void free_ast(AstNode *node);
 // Function to pretty-print the AST starting from a given node
 void ast_pretty_print(AstNode *node, int initial_indent);
 
+// Operator names as the pretty-printer shows them (e.g. "Negate", "LessEqual")
+const char *ast_unary_operator_name(UnaryOperatorType op);
+const char *ast_binary_operator_name(BinaryOperatorType op);
+
+// Counts the nodes in the tree rooted at `node` (0 for NULL); sizes the TAC of trees not built by the parser
+size_t ast_count_nodes(const AstNode *node);
+
+// Structural fingerprint of a subtree: two independent 64-bit hashes over node types, operators, literal
+// values and names. Names are hashed by content, so separately parsed copies of a function fingerprint alike.
+typedef struct {
+    uint64_t lanes[2];
+} AstFingerprint;
+
+// Fingerprints the tree rooted at `node` (NULL has a fingerprint of its own)
+AstFingerprint ast_fingerprint(const AstNode *node);
+
+// Whether two fingerprints are the same
+bool ast_fingerprint_equal(AstFingerprint a, AstFingerprint b);
+
 
 #endif // AST_H
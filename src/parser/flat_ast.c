@@ -0,0 +1,310 @@
+#include "flat_ast.h"
+#include "memory/arena_stack.h"
+#include <stdio.h>
+#include <string.h> // For memcpy
+
+#define FLAT_AST_MIN_CAPACITY 16
+
+// One pointer-tree node whose children are being flattened
+typedef struct {
+    const AstNode *node;
+    uint32_t next_child;   // Children handed out so far
+    AstHandle children[2]; // Handles of the flattened children (blocks use FlatAst.items instead)
+    uint32_t items_start;  // NODE_BLOCK: first of the entries reserved in FlatAst.items
+} FlattenFrame;
+
+// Makes room for `needed` elements, doubling the capacity. Returns false if out of memory.
+static bool reserve_array(void **array, uint32_t *capacity, const uint32_t count, const uint32_t needed,
+                          const size_t element_size, Arena *arena) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    uint32_t new_capacity = *capacity < FLAT_AST_MIN_CAPACITY ? FLAT_AST_MIN_CAPACITY : *capacity;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    void *new_array = arena_alloc_tagged(arena, (size_t) new_capacity * element_size, ARENA_TAG_AST);
+    if (!new_array) {
+        return false;
+    }
+    if (count) {
+        memcpy(new_array, *array, (size_t) count * element_size);
+    }
+    arena_note_superseded(arena, (size_t) *capacity * element_size, ARENA_TAG_AST);
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool add_name(FlatAst *ast, const char *name, uint32_t *index, Arena *arena) {
+    if (!reserve_array((void **) &ast->names, &ast->name_capacity, ast->name_count, ast->name_count + 1,
+                       sizeof(const char *), arena)) {
+        return false;
+    }
+    *index = ast->name_count;
+    ast->names[ast->name_count++] = name;
+    return true;
+}
+
+// Child `index` of `node` in source order (possibly NULL, for a missing optional child).
+// Returns false past the last child.
+static bool child_at(const AstNode *node, const uint32_t index, const AstNode **child) {
+    switch (node->type) {
+        case NODE_PROGRAM:
+            *child = (const AstNode *) ((const ProgramNode *) node)->function;
+            return index == 0;
+        case NODE_FUNC_DEF:
+            *child = (const AstNode *) ((const FuncDefNode *) node)->body;
+            return index == 0;
+        case NODE_RETURN_STMT:
+            *child = ((const ReturnStmtNode *) node)->expression;
+            return index == 0;
+        case NODE_UNARY_OP:
+            *child = ((const UnaryOpNode *) node)->operand;
+            return index == 0;
+        case NODE_BINARY_OP: {
+            const BinaryOpNode *bin_node = (const BinaryOpNode *) node;
+            *child = index == 0 ? bin_node->left : bin_node->right;
+            return index < 2;
+        }
+        case NODE_VAR_DECL:
+            *child = ((const VarDeclNode *) node)->initializer;
+            return index == 0;
+        case NODE_BLOCK: {
+            const BlockNode *block = (const BlockNode *) node;
+            if (index >= block->num_items) {
+                return false;
+            }
+            *child = block->items[index];
+            return true;
+        }
+        default:
+            return false; // Literals and identifiers have no children
+    }
+}
+
+// Stores the handle of the child most recently handed out by `parent`
+static void record_child(FlatAst *ast, FlattenFrame *parent, const AstHandle child) {
+    const uint32_t index = parent->next_child - 1;
+    if (parent->node->type == NODE_BLOCK) {
+        ast->items[parent->items_start + index] = child;
+    } else {
+        parent->children[index] = child;
+    }
+}
+
+static bool push_frame(FlatAst *ast, ArenaStack *frames, const AstNode *node, Arena *arena) {
+    FlattenFrame *frame = arena_stack_push(frames);
+    if (!frame) {
+        return false;
+    }
+    frame->node = node;
+    frame->next_child = 0;
+    frame->children[0] = AST_HANDLE_NONE;
+    frame->children[1] = AST_HANDLE_NONE;
+    frame->items_start = ast->item_count;
+    if (node->type == NODE_BLOCK) {
+        // Reserve the block's run of items now, so it stays contiguous around nested blocks
+        const uint32_t num_items = (uint32_t) ((const BlockNode *) node)->num_items;
+        if (!reserve_array((void **) &ast->items, &ast->item_capacity, ast->item_count, ast->item_count + num_items,
+                           sizeof(AstHandle), arena)) {
+            return false;
+        }
+        ast->item_count += num_items;
+    }
+    return true;
+}
+
+// Appends the node of a frame whose children are all flattened. Returns false if out of memory.
+static bool emit_node(FlatAst *ast, const FlattenFrame *frame, AstHandle *handle, Arena *arena) {
+    if (!reserve_array((void **) &ast->nodes, &ast->node_capacity, ast->node_count, ast->node_count + 1,
+                       sizeof(FlatAstNode), arena)) {
+        return false;
+    }
+    const AstNode *node = frame->node;
+    FlatAstNode flat = {.type = (uint8_t) node->type, .first = frame->children[0], .second = frame->children[1]};
+    switch (node->type) {
+        case NODE_FUNC_DEF:
+            if (!add_name(ast, ((const FuncDefNode *) node)->name, &flat.first, arena)) return false;
+            flat.second = frame->children[0];
+            break;
+        case NODE_BLOCK:
+            flat.first = frame->items_start;
+            flat.second = (uint32_t) ((const BlockNode *) node)->num_items;
+            break;
+        case NODE_VAR_DECL: {
+            const VarDeclNode *decl = (const VarDeclNode *) node;
+            uint32_t type_index;
+            if (!add_name(ast, decl->var_name, &flat.first, arena) ||
+                !add_name(ast, decl->type_name, &type_index, arena)) {
+                return false;
+            }
+            flat.second = frame->children[0];
+            break;
+        }
+        case NODE_IDENTIFIER:
+            if (!add_name(ast, ((const IdentifierNode *) node)->name, &flat.first, arena)) return false;
+            break;
+        case NODE_UNARY_OP:
+            flat.op = (uint8_t) ((const UnaryOpNode *) node)->op;
+            break;
+        case NODE_BINARY_OP:
+            flat.op = (uint8_t) ((const BinaryOpNode *) node)->op;
+            break;
+        case NODE_INT_LITERAL:
+            flat.first = (uint32_t) ((const IntLiteralNode *) node)->value;
+            break;
+        default:
+            break;
+    }
+    *handle = ast->node_count;
+    ast->nodes[ast->node_count++] = flat;
+    return true;
+}
+
+FlatAst *flat_ast_from_program(const ProgramNode *program, Arena *arena) {
+    if (!program) {
+        return NULL;
+    }
+    FlatAst *ast = arena_alloc_zeroed(arena, sizeof(FlatAst));
+    if (!ast) {
+        return NULL;
+    }
+    ast->root = AST_HANDLE_NONE;
+    ast->interner = program->interner;
+
+    // Trees from the parser know their size: the body plus the function and program nodes
+    const uint32_t expected_nodes = program->function ? (uint32_t) program->function->body_node_count + 2 : 0;
+    if (!reserve_array((void **) &ast->nodes, &ast->node_capacity, 0, expected_nodes, sizeof(FlatAstNode), arena)) {
+        return NULL;
+    }
+
+    ArenaStack frames;
+    arena_stack_init(&frames, arena, sizeof(FlattenFrame));
+    if (!push_frame(ast, &frames, (const AstNode *) program, arena)) {
+        return NULL;
+    }
+    while (!arena_stack_is_empty(&frames)) {
+        FlattenFrame *frame = arena_stack_top(&frames);
+        const AstNode *child;
+        if (child_at(frame->node, frame->next_child, &child)) {
+            frame->next_child++;
+            if (!child) {
+                record_child(ast, frame, AST_HANDLE_NONE);
+            } else if (!push_frame(ast, &frames, child, arena)) {
+                return NULL;
+            }
+            continue;
+        }
+
+        // Every child is in place: the node itself follows them
+        AstHandle handle;
+        if (!emit_node(ast, frame, &handle, arena)) {
+            return NULL;
+        }
+        arena_stack_pop(&frames);
+        if (arena_stack_is_empty(&frames)) {
+            ast->root = handle;
+        } else {
+            record_child(ast, arena_stack_top(&frames), handle);
+        }
+    }
+    return ast;
+}
+
+// Helper function to print indentation
+static void print_indent(const int level) {
+    for (int i = 0; i < level; ++i) {
+        printf("  "); // Print two spaces per indentation level
+    }
+}
+
+// Recursive, like ast_pretty_print, whose output it reproduces line for line
+void flat_ast_pretty_print(const FlatAst *ast, const AstHandle handle, const int indent_level) { // NOLINT(*-no-recursion)
+    if (handle == AST_HANDLE_NONE) {
+        print_indent(indent_level);
+        printf("NULL_NODE\n");
+        return;
+    }
+
+    const FlatAstNode *node = flat_ast_node(ast, handle);
+    print_indent(indent_level);
+
+    switch ((NodeType) node->type) {
+        case NODE_PROGRAM:
+            printf("Program(\n");
+            flat_ast_pretty_print(ast, node->first, indent_level + 1);
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        case NODE_FUNC_DEF: {
+            const char *name = flat_ast_name(ast, node->first);
+            printf("Function(name=\"%s\",\n", name ? name : "<null>");
+            print_indent(indent_level + 1);
+            printf("body=\n");
+            flat_ast_pretty_print(ast, node->second, indent_level + 2);
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        }
+        case NODE_RETURN_STMT:
+            printf("Return(\n");
+            flat_ast_pretty_print(ast, node->first, indent_level + 1);
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        case NODE_UNARY_OP:
+            printf("UnaryOp(op=%s,\n", ast_unary_operator_name((UnaryOperatorType) node->op));
+            flat_ast_pretty_print(ast, node->first, indent_level + 1);
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        case NODE_BINARY_OP:
+            printf("BinaryOp(op=%s,\n", ast_binary_operator_name((BinaryOperatorType) node->op));
+            print_indent(indent_level + 1);
+            printf("left=\n");
+            flat_ast_pretty_print(ast, node->first, indent_level + 2);
+            print_indent(indent_level + 1);
+            printf("right=\n");
+            flat_ast_pretty_print(ast, node->second, indent_level + 2);
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        case NODE_INT_LITERAL:
+            printf("Constant(%d)\n", flat_ast_int_value(node));
+            break;
+        case NODE_BLOCK:
+            printf("Block(\n");
+            for (uint32_t i = 0; i < node->second; ++i) {
+                flat_ast_pretty_print(ast, flat_ast_block_item(ast, node, i), indent_level + 1);
+            }
+            print_indent(indent_level);
+            printf(")\n");
+            break;
+        case NODE_VAR_DECL: {
+            const char *var_name = flat_ast_name(ast, node->first);
+            const char *type_name = flat_ast_name(ast, node->first + 1);
+            printf("VarDecl(type=%s, name=%s", type_name ? type_name : "<null_type>",
+                   var_name ? var_name : "<null_name>");
+            if (node->second != AST_HANDLE_NONE) {
+                printf(",\n");
+                print_indent(indent_level + 1);
+                printf("initializer=\n");
+                flat_ast_pretty_print(ast, node->second, indent_level + 2);
+                print_indent(indent_level);
+                printf(")\n");
+            } else {
+                printf(")\n");
+            }
+            break;
+        }
+        case NODE_IDENTIFIER: {
+            const char *name = flat_ast_name(ast, node->first);
+            printf("Identifier(name=%s)\n", name ? name : "<null_id_name>");
+            break;
+        }
+        default:
+            printf("UnknownNode(type=%d)\n", node->type);
+            break;
+    }
+}
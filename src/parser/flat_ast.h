@@ -0,0 +1,86 @@
+#ifndef CLERIC_FLAT_AST_H
+#define CLERIC_FLAT_AST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "memory/arena.h"
+
+// Index of a node in FlatAst.nodes
+typedef uint32_t AstHandle;
+
+// Handle of a missing optional child (e.g. a declaration without initializer)
+#define AST_HANDLE_NONE UINT32_MAX
+
+// One AST node, 12 bytes instead of a separately allocated struct linked by pointers.
+// What `first` and `second` hold depends on the node type:
+//   NODE_PROGRAM      first = function
+//   NODE_FUNC_DEF     first = name index,     second = body
+//   NODE_BLOCK        first = index of the block's first entry in FlatAst.items,  second = item count
+//   NODE_VAR_DECL     first = name index (the type name follows it), second = initializer or AST_HANDLE_NONE
+//   NODE_IDENTIFIER   first = name index
+//   NODE_RETURN_STMT  first = expression
+//   NODE_UNARY_OP     first = operand                        (op = UnaryOperatorType)
+//   NODE_BINARY_OP    first = left,           second = right (op = BinaryOperatorType)
+//   NODE_INT_LITERAL  first = the value, as uint32_t
+typedef struct {
+    uint8_t type;      // NodeType
+    uint8_t op;        // Operator of NODE_UNARY_OP / NODE_BINARY_OP, 0 otherwise
+    uint16_t reserved; // Always 0
+    uint32_t first;
+    uint32_t second;
+} FlatAstNode;
+
+// Flat AST: every node in one contiguous array, stored in post-order, so each child comes before
+// its parent and the root is the last node. A walk from the root moves through memory mostly in
+// one direction, and children are 4-byte handles rather than 8-byte pointers.
+typedef struct {
+    FlatAstNode *nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    AstHandle *items;      // Block items; each block's items are contiguous and in source order
+    uint32_t item_count;
+    uint32_t item_capacity;
+    const char **names;    // Function, variable, type and identifier names, shared with the pointer tree
+    uint32_t name_count;
+    uint32_t name_capacity;
+    AstHandle root;        // The NODE_PROGRAM node (AST_HANDLE_NONE for an empty tree)
+    const StringInterner *interner; // Interner owning the names (NULL for hand-built trees)
+} FlatAst;
+
+/**
+ * @brief Builds the flat form of a pointer tree. The walk uses an explicit stack, so any
+ *        nesting depth the parser accepts can be flattened.
+ * @param program Root of the pointer tree (its nodes are not modified and may be discarded
+ *                afterwards; names are shared, not copied).
+ * @param arena Arena for the arrays and the walk.
+ * @return The flat tree, or NULL if program is NULL or memory ran out.
+ */
+FlatAst *flat_ast_from_program(const ProgramNode *program, Arena *arena);
+
+/**
+ * @brief Pretty-prints the subtree rooted at `node`, with exactly the output ast_pretty_print
+ *        gives for the pointer tree the flat tree was built from.
+ */
+void flat_ast_pretty_print(const FlatAst *ast, AstHandle node, int initial_indent);
+
+static inline const FlatAstNode *flat_ast_node(const FlatAst *ast, const AstHandle handle) {
+    return &ast->nodes[handle];
+}
+
+// Name stored at `index` by a NODE_FUNC_DEF, NODE_VAR_DECL or NODE_IDENTIFIER
+static inline const char *flat_ast_name(const FlatAst *ast, const uint32_t index) {
+    return ast->names[index];
+}
+
+// The i-th item of a NODE_BLOCK
+static inline AstHandle flat_ast_block_item(const FlatAst *ast, const FlatAstNode *block, const uint32_t i) {
+    return ast->items[block->first + i];
+}
+
+static inline int flat_ast_int_value(const FlatAstNode *node) {
+    return (int) node->first;
+}
+
+#endif // CLERIC_FLAT_AST_H
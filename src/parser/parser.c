@@ -1,10 +1,9 @@
 #include "parser.h"
 #include "ast.h"
 #include "memory/arena.h" // Include Arena for allocation
+#include "memory/arena_stack.h"
 #include <stdio.h>
-#include <stdlib.h> // For strtol
 #include <stdarg.h> // For va_list in parser_error
-#include <errno.h>  // For errno and ERANGE
 #include <limits.h>
 #include <string.h> // For strlen, strcpy
 
@@ -12,10 +11,33 @@
 #define LOWEST_BINARY_PRECEDENCE 1
 #define UNARY_OPERATOR_PRECEDENCE 7 // Adjusted: Higher than any binary operator
 
+// --- Precedence Climbing: Explicit Stack Frames ---
+// Each frame stands for one pending activation of the recursive formulation, where each
+// level parsed "operand { op expression-of-higher-precedence }":
+//   EXPRESSION_FRAME_CLIMB   one precedence level (min_precedence): operands joined by
+//                            operators of at least min_precedence; `left` holds the operand so
+//                            far and `pending_op` the operator whose right operand is being parsed
+//   EXPRESSION_FRAME_UNARY   a prefix operator waiting for its operand (climbed at UNARY_OPERATOR_PRECEDENCE)
+//   EXPRESSION_FRAME_PARENS  a '(' waiting for its expression and the closing ')'
+typedef enum {
+    EXPRESSION_FRAME_CLIMB,
+    EXPRESSION_FRAME_UNARY,
+    EXPRESSION_FRAME_PARENS
+} ExpressionFrameKind;
+
+typedef struct {
+    ExpressionFrameKind kind;
+    int min_precedence;            // CLIMB
+    bool has_pending_op;           // CLIMB
+    BinaryOperatorType pending_op; // CLIMB
+    AstNode *left;                 // CLIMB
+    UnaryOperatorType unary_op;    // UNARY
+} ExpressionFrame;
+
 // Returns precedence level (0 if not a relevant binary operator)
 static int get_token_precedence(const TokenType type) {
     switch (type) {
-        case TOKEN_SYMBOL_ASSIGN: return 1; // Lowest precedence, right-associative (handled in recursive step)
+        case TOKEN_SYMBOL_ASSIGN: return 1; // Lowest precedence, right-associative (handled in begin_right_operand)
         case TOKEN_SYMBOL_LOGICAL_OR: // ||
             return 2;
         case TOKEN_SYMBOL_LOGICAL_AND: // &&
@@ -101,10 +123,6 @@ static ReturnStmtNode *parse_return_statement(Parser *parser);
 
 static AstNode *parse_expression(Parser *parser);
 
-static AstNode *parse_primary_expression(Parser *parser);
-
-static AstNode *parse_expression_recursive(Parser *parser, int min_precedence);
-
 static BlockNode *parse_block(Parser *parser);
 
 static AstNode *parse_declaration(Parser *parser); // Full implementation will be in parser.c
@@ -118,12 +136,35 @@ static void parser_error(Parser *parser, const char *format, ...);
 // Helper function to advance the parser state
 static void parser_advance(Parser *parser);
 
+// Counts a node just created by the parser (NULL if its allocation failed) and hands it back
+static void *counted(Parser *parser, void *node) {
+    if (node) {
+        parser->node_count++;
+    }
+    return node;
+}
+
 // --- Public Parser Interface Implementation ---
+// Allocates the AST's string interner from the parser's arena (NULL on allocation failure)
+static StringInterner *parser_create_interner(Arena *arena) {
+    StringInterner *interner = arena_alloc(arena, sizeof(StringInterner));
+    if (!interner || !interner_init(interner, arena, 0)) {
+        return NULL;
+    }
+    return interner;
+}
+
 void parser_init(Parser *parser, Lexer *lexer, Arena *arena) {
     parser->lexer = lexer;
+    parser->tokens = NULL;
+    parser->ring = NULL;
+    parser->token_index = 0;
+    parser->node_count = 0;
+    arena_stack_init(&parser->expression_frames, arena, sizeof(ExpressionFrame));
     parser->error_flag = false;
     parser->error_message = NULL; // Initialize error_message
     parser->arena = arena; // Store the arena pointer
+    parser->interner = parser_create_interner(arena);
     // Prime the parser: Fetch the first two tokens.
     // Use the provided arena for lexeme allocation.
     const bool success1 = lexer_next_token(parser->lexer, &parser->current_token);
@@ -146,6 +187,49 @@ void parser_init(Parser *parser, Lexer *lexer, Arena *arena) {
     // Note: parser_advance already checks peek_token for UNKNOWN
 }
 
+void parser_init_tokens(Parser *parser, const TokenArray *tokens, Arena *arena) {
+    parser->lexer = NULL;
+    parser->tokens = tokens;
+    parser->ring = NULL;
+    parser->token_index = 1;
+    parser->node_count = 0;
+    arena_stack_init(&parser->expression_frames, arena, sizeof(ExpressionFrame));
+    parser->error_flag = false;
+    parser->error_message = NULL;
+    parser->arena = arena;
+    parser->interner = parser_create_interner(arena);
+    parser->current_token = token_array_get(tokens, 0);
+    parser->peek_token = token_array_get(tokens, 1);
+
+    if (parser->current_token.type == TOKEN_UNKNOWN) {
+        parser_error(parser, "Syntax Error: Unrecognized token at start");
+    }
+}
+
+void parser_init_ring(Parser *parser, TokenRing *ring, Arena *arena) {
+    parser->lexer = NULL;
+    parser->tokens = NULL;
+    parser->ring = ring;
+    parser->token_index = 0;
+    parser->node_count = 0;
+    arena_stack_init(&parser->expression_frames, arena, sizeof(ExpressionFrame));
+    parser->error_flag = false;
+    parser->error_message = NULL;
+    parser->arena = arena;
+    parser->interner = parser_create_interner(arena);
+    if (!token_ring_pop(ring, &parser->current_token) || !token_ring_pop(ring, &parser->peek_token)) {
+        // The lexer thread failed and has printed why
+        parser->error_flag = true;
+        parser->current_token.type = TOKEN_EOF;
+        parser->peek_token.type = TOKEN_EOF;
+        return;
+    }
+
+    if (parser->current_token.type == TOKEN_UNKNOWN) {
+        parser_error(parser, "Syntax Error: Unrecognized token at start");
+    }
+}
+
 ProgramNode *parse_program(Parser *parser) {
     // Parse the function definition
     FuncDefNode *func_def_node = parse_function_definition(parser);
@@ -164,7 +248,10 @@ ProgramNode *parse_program(Parser *parser) {
     }
 
     // Create a ProgramNode from the FuncDefNode
-    ProgramNode *program_node = create_program_node(func_def_node, parser->arena);
+    ProgramNode *program_node = counted(parser, create_program_node(func_def_node, parser->arena));
+    if (program_node) {
+        program_node->interner = parser->interner;
+    }
     return program_node;
 }
 
@@ -177,9 +264,11 @@ static void parser_advance(Parser *parser) {
 
     // No need to free current_token's lexeme; it's in the arena.
     parser->current_token = parser->peek_token;
-    // Pass the arena to lexer_next_token
-    const bool success = lexer_next_token(parser->lexer, &parser->peek_token);
-    if (!success) {
+    if (parser->tokens) {
+        // Token array: the next token is already lexed, just index it
+        parser->peek_token = token_array_get(parser->tokens, ++parser->token_index);
+    } else if (parser->ring ? !token_ring_pop(parser->ring, &parser->peek_token)
+                            : !lexer_next_token(parser->lexer, &parser->peek_token)) {
         // Lexer failed (e.g., arena error), set error flag and stop
         parser->error_flag = true;
         parser->peek_token.type = TOKEN_EOF; // Prevent further issues
@@ -205,7 +294,7 @@ static bool parser_consume(Parser *parser, const TokenType expected_type) {
 
     char expected_token_str[128];
     // Create a dummy token just for getting the string representation
-    token_to_string((Token){expected_type, "expected", 0}, expected_token_str, sizeof(expected_token_str));
+    token_to_string((Token){expected_type, "expected", 8, 0}, expected_token_str, sizeof(expected_token_str));
 
     parser_error(parser, "Expected token %s, but got %s", expected_token_str, current_token_str);
     return false; // Indicate failure
@@ -274,14 +363,9 @@ static FuncDefNode *parse_function_definition(Parser *parser) {
         parser_error(parser, "Expected function name (identifier) after 'int', but got %s", current_token_str);
         return NULL;
     }
-    // Copy the lexeme into the arena
-    const size_t name_len = strlen(parser->current_token.lexeme);
-    char *func_name = arena_alloc(parser->arena, name_len + 1);
-    if (!func_name) {
-        parser_error(parser, "Memory allocation failed for function name using arena");
-        return NULL;
-    }
-    strcpy(func_name, parser->current_token.lexeme); // Copy the name
+    // The lexeme is a slice of the source; keep it and let the node make the one NUL-terminated copy
+    const char *func_name = parser->current_token.lexeme;
+    const size_t func_name_len = parser->current_token.length;
 
     parser_advance(parser); // Consume identifier
     // ReSharper disable once CppDFAConstantConditions
@@ -316,6 +400,7 @@ static FuncDefNode *parse_function_definition(Parser *parser) {
 
     // The function body is a block, parse it using parse_block()
     // parse_block() will handle consuming '{' and '}' and parsing declarations/statements.
+    const size_t nodes_before_body = parser->node_count;
     BlockNode *body_block = parse_block(parser);
     if (!body_block) {
         // parse_block should have set an error flag if it failed.
@@ -323,15 +408,19 @@ static FuncDefNode *parse_function_definition(Parser *parser) {
         // ReSharper disable once CppDFAConstantConditions
         if (!parser->error_flag && func_name) {
             // Add a more specific error if parse_block didn't
-            parser_error(parser, "Failed to parse function body for '%s'.", func_name);
+            parser_error(parser, "Failed to parse function body for '%.*s'.", (int) func_name_len, func_name);
         }
         return NULL;
     }
 
-    // Create the function definition node using the name from the arena
-    FuncDefNode *func_node = create_func_def_node(func_name, body_block, parser->arena);
-    // No need to free func_name; it was allocated in the arena and create_func_def_node
-    // now uses the pointer directly (or copies into the arena if it didn't before).
+    // Create the function definition node; it interns the name
+    FuncDefNode *func_node = counted(parser, create_func_def_node_n(func_name, func_name_len, body_block,
+                                                                    parser->interner, parser->arena));
+    if (!func_node) {
+        parser_error(parser, "Memory allocation failed for function definition node");
+        return NULL;
+    }
+    func_node->body_node_count = parser->node_count - nodes_before_body;
     return func_node;
 }
 
@@ -421,7 +510,7 @@ static ReturnStmtNode *parse_return_statement(Parser *parser) {
     }
 
     // Create the return statement node
-    ReturnStmtNode *return_node = create_return_stmt_node(expression, parser->arena);
+    ReturnStmtNode *return_node = counted(parser, create_return_stmt_node(expression, parser->arena));
     if (!return_node) {
         parser_error(parser, "Memory allocation failed for return statement node");
         return NULL;
@@ -429,44 +518,31 @@ static ReturnStmtNode *parse_return_statement(Parser *parser) {
     return return_node;
 }
 
-// Expression parsing: Handles Integers, Unary Ops (- ~), and Parentheses
-// <exp> ::= <int> | <unop> <exp> | "(" <exp> ")"
-// <unop> ::= "-" | "~"
-static AstNode *parse_expression(Parser *parser) {
-    if (parser->error_flag) return NULL;
-    return parse_expression_recursive(parser, LOWEST_BINARY_PRECEDENCE);
+// Expression parsing: precedence climbing over an explicit stack, so that nesting depth is
+// bounded by memory rather than by the C stack.
+// <exp> ::= <operand> { <binop> <exp> } with operators grouped by precedence
+// <operand> ::= <int> | <identifier> | <unop> <exp> | "(" <exp> ")"
+// <unop> ::= "-" | "~" | "!"
+static bool push_expression_frame(Parser *parser, const ExpressionFrameKind kind, const int min_precedence) {
+    ExpressionFrame *frame = arena_stack_push(&parser->expression_frames);
+    if (!frame) {
+        parser_error(parser, "Memory allocation failed for expression nesting.");
+        return false;
+    }
+    frame->kind = kind;
+    frame->min_precedence = min_precedence;
+    frame->has_pending_op = false;
+    frame->left = NULL;
+    return true;
 }
 
-static AstNode *parse_primary_expression(Parser *parser) { // NOLINT(*-no-recursion) // Retaining for now, can remove if linter is fine
-    if (parser->error_flag) return NULL;
-
-    // Handle Unary Operators: '-', '~', '!'
-    UnaryOperatorType un_op_type;
-    if (token_to_unary_operator_type(parser->current_token.type, &un_op_type)) {
-        parser_advance(parser); // Consume the unary operator token
-        if (parser->error_flag) return NULL;
-
-        // Recursively parse the operand with unary precedence
-        AstNode *operand = parse_expression_recursive(parser, UNARY_OPERATOR_PRECEDENCE);
-        if (parser->error_flag || !operand) {
-            // Error already reported by parse_expression_recursive or child call
-            // If operand is NULL but no error flag, it means an unexpected EOF or missing operand after unary op.
-            // So, provide a more specific error message.
-            if (!parser->error_flag) {
-                char current_token_str[128];
-                token_to_string(parser->current_token, current_token_str, sizeof(current_token_str));
-                parser_error(parser, "Syntax Error: Expected expression after unary operator, but got %s",
-                             current_token_str);
-            }
-            return NULL; // Error already set or operand missing
-        }
-        return (AstNode *) create_unary_op_node(un_op_type, operand, parser->arena);
-    }
-
+// Parses an identifier or integer literal, reporting an error for anything else
+static AstNode *parse_operand_token(Parser *parser) {
     // Handle Identifiers as primary expressions
     if (parser->current_token.type == TOKEN_IDENTIFIER) {
-        char *ident_name = parser->current_token.lexeme;
-        IdentifierNode *node = create_identifier_node(ident_name, parser->arena);
+        IdentifierNode *node = counted(parser, create_identifier_node_n(parser->current_token.lexeme,
+                                                                        parser->current_token.length,
+                                                                        parser->interner, parser->arena));
         if (!node) {
             parser_error(parser, "Memory allocation failed for identifier node");
             return NULL;
@@ -477,28 +553,30 @@ static AstNode *parse_primary_expression(Parser *parser) { // NOLINT(*-no-recurs
 
     // Handle Integer Literals
     if (parser->current_token.type == TOKEN_CONSTANT) {
-        char *end_ptr;
-        errno = 0; // Reset errno before call
-        const long val_long = strtol(parser->current_token.lexeme, &end_ptr, 10);
-
-        // Error checking for strtol
-        if (parser->current_token.lexeme == end_ptr) {
+        // Convert the digits of the slice directly; no NUL-terminated copy is needed
+        const char *digits = parser->current_token.lexeme;
+        const int digits_len = (int) parser->current_token.length;
+        if (digits_len == 0) {
             // No digits found
-            parser_error(parser, "Invalid integer literal format: %s", parser->current_token.lexeme);
+            parser_error(parser, "Invalid integer literal format: %.*s", digits_len, digits);
             return NULL;
         }
-        if (*end_ptr != '\0') {
-            // Extra characters after number (should have been caught by lexer, but double-check)
-            parser_error(parser, "Invalid characters after integer literal: %s", parser->current_token.lexeme);
-            return NULL;
-        }
-        if (errno == ERANGE || val_long < INT_MIN || val_long > INT_MAX) {
-            parser_error(parser, "Integer literal out of range: %s", parser->current_token.lexeme);
-            return NULL;
+        long val_long = 0;
+        for (int i = 0; i < digits_len; ++i) {
+            if (digits[i] < '0' || digits[i] > '9') {
+                // Extra characters after number (should have been caught by lexer, but double-check)
+                parser_error(parser, "Invalid characters after integer literal: %.*s", digits_len, digits);
+                return NULL;
+            }
+            val_long = val_long * 10 + (digits[i] - '0');
+            if (val_long > INT_MAX) {
+                parser_error(parser, "Integer literal out of range: %.*s", digits_len, digits);
+                return NULL;
+            }
         }
 
         const int value = (int) val_long;
-        IntLiteralNode *node = create_int_literal_node(value, parser->arena);
+        IntLiteralNode *node = counted(parser, create_int_literal_node(value, parser->arena));
         if (!node) {
             parser_error(parser, "Memory allocation failed for integer literal node");
             return NULL;
@@ -507,25 +585,6 @@ static AstNode *parse_primary_expression(Parser *parser) { // NOLINT(*-no-recurs
         return (AstNode *) node;
     }
 
-    // Handle Parenthesized Expressions
-    if (parser->current_token.type == TOKEN_SYMBOL_LPAREN) {
-        parser_advance(parser); // Consume '('
-        if (parser->error_flag) return NULL;
-
-        AstNode *inner_exp_node = parse_expression(parser); // Recursively parse the inner expression
-        if (!inner_exp_node) {
-            // Error already reported
-            return NULL;
-        }
-
-        // Consume ')'
-        if (!parser_consume(parser, TOKEN_SYMBOL_RPAREN)) {
-            // Error reported by parser_consume
-            return NULL;
-        }
-        return inner_exp_node; // Return the node from inside the parentheses
-    }
-
     // Handle Error Case
     char current_token_str[128];
     token_to_string(parser->current_token, current_token_str, sizeof(current_token_str));
@@ -533,82 +592,129 @@ static AstNode *parse_primary_expression(Parser *parser) { // NOLINT(*-no-recurs
     return NULL;
 }
 
-static AstNode *parse_expression_recursive(Parser *parser, int min_precedence) {
+// Parses one operand: opens a frame for every prefix operator and '(' in front of it, then
+// reads the identifier or literal at its core
+static AstNode *parse_operand(Parser *parser) {
+    while (!parser->error_flag) {
+        UnaryOperatorType un_op_type;
+        if (token_to_unary_operator_type(parser->current_token.type, &un_op_type)) {
+            parser_advance(parser); // Consume the unary operator token
+            if (parser->error_flag || !push_expression_frame(parser, EXPRESSION_FRAME_UNARY, 0)) {
+                return NULL;
+            }
+            ((ExpressionFrame *) arena_stack_top(&parser->expression_frames))->unary_op = un_op_type;
+            // The operand binds as tightly as the highest binary precedence (so -a*b is -(a*b))
+            if (!push_expression_frame(parser, EXPRESSION_FRAME_CLIMB, UNARY_OPERATOR_PRECEDENCE)) {
+                return NULL;
+            }
+        } else if (parser->current_token.type == TOKEN_SYMBOL_LPAREN) {
+            parser_advance(parser); // Consume '('
+            if (parser->error_flag || !push_expression_frame(parser, EXPRESSION_FRAME_PARENS, 0) ||
+                !push_expression_frame(parser, EXPRESSION_FRAME_CLIMB, LOWEST_BINARY_PRECEDENCE)) {
+                return NULL;
+            }
+        } else {
+            return parse_operand_token(parser);
+        }
+    }
+    return NULL;
+}
+
+// Consumes the binary operator at the current token for a frame that takes it, and opens the
+// frame for its right operand. Returns false on error.
+static bool begin_right_operand(Parser *parser, ExpressionFrame *frame, const int op_precedence) {
+    const Token operator_token_details = parser->current_token;
+    const BinaryOperatorType op_type = token_to_binary_operator_type(operator_token_details.type);
+    // ReSharper disable once CppDFAConstantConditions
+    if ((int) op_type == -1) {
+        // ReSharper disable once CppDFAUnreachableCode
+        char current_token_str[128];
+        token_to_string(parser->current_token, current_token_str, sizeof(current_token_str));
+        parser_error(parser, "Internal Error: Unexpected token %s for binary operator in parse_expression",
+                     current_token_str);
+        return false;
+    }
+
+    parser_advance(parser); // Consume the operator. current_token is now the start of the RHS.
+    if (parser->error_flag) return false;
+
+    frame->has_pending_op = true;
+    frame->pending_op = op_type;
+    // Assignment is right-associative: its right operand may contain another '=' at the same level.
+    // Every other operator is left-associative and only takes tighter operators on its right.
+    const int next_min_precedence = op_type == OPERATOR_ASSIGN ? op_precedence : op_precedence + 1;
+    return push_expression_frame(parser, EXPRESSION_FRAME_CLIMB, next_min_precedence);
+}
+
+static AstNode *parse_expression(Parser *parser) {
     if (parser->error_flag) return NULL;
-    AstNode *left_node = parse_primary_expression(parser);
-    if (!left_node || parser->error_flag) {
-        // Check error_flag after parse_primary_expression
-        // Error already reported by parse_primary_expression or child call
+    ArenaStack *frames = &parser->expression_frames;
+    const size_t base_depth = frames->depth;
+    if (!push_expression_frame(parser, EXPRESSION_FRAME_CLIMB, LOWEST_BINARY_PRECEDENCE)) {
         return NULL;
     }
 
     while (true) {
-        // Check the CURRENT token as the operator.
-        int op_precedence = get_token_precedence(parser->current_token.type);
-
-        if (op_precedence < min_precedence) {
-            // Not an operator, or operator of lower precedence than we are looking for.
-            break;
+        AstNode *operand = parse_operand(parser);
+        if (!operand) {
+            break; // Error already reported
         }
 
-        // current_token is our operator.
-        Token operator_token_details = parser->current_token;
-        BinaryOperatorType op_type = token_to_binary_operator_type(operator_token_details.type);
-
-        // ReSharper disable once CppDFAConstantConditions
-        // ReSharper disable once CppDFAUnreachableCode
-        if ((int) op_type == -1 && !parser->error_flag) {
-            // Check if conversion failed
-            // ReSharper disable once CppDFAUnreachableCode
-            char current_token_str[128];
-            token_to_string(parser->current_token, current_token_str, sizeof(current_token_str));
-            parser_error(
-                parser, "Internal Error: Unexpected token %s for binary operator in parse_expression_recursive",
-                current_token_str);
-            return NULL;
-        }
-        if (parser->error_flag) return NULL; // If op_type conversion itself failed and set error
+        // Hand the operand to the enclosing frames until one of them takes the operator after it
+        bool needs_operand = false;
+        while (!needs_operand) {
+            ExpressionFrame *frame = arena_stack_top(frames);
+            if (frame->kind == EXPRESSION_FRAME_UNARY) {
+                operand = (AstNode *) counted(parser, create_unary_op_node(frame->unary_op, operand, parser->arena));
+                if (!operand) {
+                    parser_error(parser, "Memory allocation failed for unary operation node.");
+                    break;
+                }
+                arena_stack_pop(frames);
+                continue;
+            }
+            if (frame->kind == EXPRESSION_FRAME_PARENS) {
+                if (!parser_consume(parser, TOKEN_SYMBOL_RPAREN)) {
+                    break; // Error reported by parser_consume
+                }
+                arena_stack_pop(frames);
+                continue; // The node from inside the parentheses is the operand
+            }
 
-        parser_advance(parser); // Consume the operator. current_token is now the start of the RHS.
-        if (parser->error_flag) return NULL; // Check error after advance
+            if (frame->has_pending_op) {
+                operand = (AstNode *) counted(parser, create_binary_op_node(frame->pending_op, frame->left, operand,
+                                                                            parser->arena));
+                if (!operand) {
+                    parser_error(parser, "Failed to create binary operation node due to allocation failure.");
+                    break;
+                }
+                frame->has_pending_op = false;
+            }
+            frame->left = operand;
 
-        // Determine precedence for the right-hand side based on associativity
-        int next_min_precedence;
-        // Assignment and other future right-associative operators
-        if (op_type == OPERATOR_ASSIGN /* || op_type == OPERATOR_TERNARY_COND etc. */) {
-            next_min_precedence = op_precedence; // For right-associativity
-        } else {
-            // Other operators are left-associative by default in this structure
-            next_min_precedence = op_precedence + 1; // For left-associativity
-        }
-        AstNode *right_node = parse_expression_recursive(parser, next_min_precedence);
-        if (!right_node) {
-            // Error should be set by the recursive call or primary_expression if !right_node
-            // If no specific error was set by a deeper call, provide a generic one here.
-            if (!parser->error_flag) {
-                char op_str[128];
-                token_to_string(operator_token_details, op_str, sizeof(op_str));
-                char next_tok_str[128];
-                token_to_string(parser->current_token, next_tok_str, sizeof(next_tok_str));
-                parser_error(parser, "Syntax Error: Expected expression after operator %s, but got %s", op_str,
-                             next_tok_str);
+            // Check the CURRENT token as the operator
+            const int op_precedence = get_token_precedence(parser->current_token.type);
+            if (op_precedence >= frame->min_precedence) {
+                if (!begin_right_operand(parser, frame, op_precedence)) {
+                    break;
+                }
+                needs_operand = true;
+                continue;
             }
-            return NULL;
-        }
-        // No need to check error_flag again if right_node is valid, as prior calls would return NULL on error.
 
-        left_node = (AstNode *) create_binary_op_node(op_type, left_node, right_node, parser->arena);
-        if (!left_node) {
-            // Allocation failed
-            if (!parser->error_flag) {
-                // Should be rare if arena is robust
-                parser_error(parser, "Failed to create binary operation node due to allocation failure.");
+            // Not an operator, or one this level does not take: the level is complete
+            arena_stack_pop(frames);
+            if (frames->depth == base_depth) {
+                return operand;
             }
-            return NULL;
         }
-        // Loop continues. current_token is now the token AFTER the parsed RHS.
+        if (!needs_operand) {
+            break; // Error inside the hand-over loop
+        }
     }
-    return left_node;
+
+    arena_stack_truncate(frames, base_depth);
+    return NULL;
 }
 
 // --- Implementation of Block and Declaration Parsing ---
@@ -620,7 +726,7 @@ static BlockNode *parse_block(Parser *parser) {
         return NULL;
     }
 
-    BlockNode *block_node = create_block_node(parser->arena);
+    BlockNode *block_node = counted(parser, create_block_node(parser->arena));
     if (!block_node) {
         if (!parser->error_flag) {
             parser_error(parser, "Memory allocation failed for block node.");
@@ -703,8 +809,9 @@ static AstNode *parse_declaration(Parser *parser) {
         return NULL;
     }
 
-    // The lexeme from the token is allocated in the arena, so it's safe to use.
-    char *var_name = parser->current_token.lexeme;
+    // The lexeme is a slice of the source buffer, which outlives parsing.
+    const char *var_name = parser->current_token.lexeme;
+    const int var_name_len = (int) parser->current_token.length;
 
     parser_advance(parser); // Consume the identifier token
     if (parser->error_flag) return NULL;
@@ -722,7 +829,8 @@ static AstNode *parse_declaration(Parser *parser) {
             // Error already reported by parse_expression or its children.
             // If somehow not, ensure a generic message.
             if (!parser->error_flag) {
-                parser_error(parser, "Expected expression after '=' in variable declaration for '%s'.", var_name);
+                parser_error(parser, "Expected expression after '=' in variable declaration for '%.*s'.",
+                             var_name_len, var_name);
             }
             return NULL;
         }
@@ -736,18 +844,21 @@ static AstNode *parse_declaration(Parser *parser) {
         // A more specific message might be desired if parser_consume's default isn't sufficient.
         if (!parser->error_flag) {
             // Fallback, should not be needed
-            parser_error(parser, "Expected ';' after variable declaration of '%s'.", var_name);
+            parser_error(parser, "Expected ';' after variable declaration of '%.*s'.", var_name_len, var_name);
         }
         return NULL;
     }
 
     // 5. Create and return the VarDeclNode
     // type_str is already set (e.g., to "int")
-    VarDeclNode *decl_node = create_var_decl_node(type_str, var_name, initializer_node, parser->arena);
+    VarDeclNode *decl_node = counted(parser, create_var_decl_node_n(type_str, var_name, (size_t) var_name_len,
+                                                                    initializer_node, parser->interner,
+                                                                    parser->arena));
     if (!decl_node) {
         if (!parser->error_flag) {
             // If create_node failed and didn't set an error
-            parser_error(parser, "Memory allocation failed for variable declaration node for '%s'.", var_name);
+            parser_error(parser, "Memory allocation failed for variable declaration node for '%.*s'.",
+                         var_name_len, var_name);
         }
         return NULL;
     }
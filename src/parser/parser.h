@@ -2,16 +2,24 @@
 #define PARSER_H
 
 #include "../lexer/lexer.h" // Need Lexer and Token types
+#include "../lexer/token_ring.h" // For parsing while another thread lexes
 #include "ast.h"           // Need AST node types (specifically ProgramNode)
 #include "memory/arena.h" // Include arena header
+#include "memory/arena_stack.h"
 #include <stdbool.h>       // For bool type
 
 // Parser state structure
 typedef struct {
-    Lexer *lexer;           // Pointer to the lexer providing tokens
+    Lexer *lexer;           // Pointer to the lexer providing tokens (NULL when reading a token array)
+    const TokenArray *tokens; // Pre-lexed token stream (NULL when pulling tokens from the lexer)
+    TokenRing *ring;        // Tokens from a lexer thread (NULL unless initialized with parser_init_ring)
+    size_t token_index;     // Index of peek_token within tokens
     Token current_token;    // The current token being processed
     Token peek_token;       // The next token (lookahead)
     Arena *arena;           // Pointer to the arena for AST allocations
+    StringInterner *interner; // Canonical names for the AST (allocated from the arena at init)
+    size_t node_count;      // AST nodes created so far
+    ArenaStack expression_frames; // Pending operators of parse_expression, in place of C recursion
     bool error_flag;        // Flag to indicate if a syntax error occurred
     char *error_message;    // Buffer to store the first error message encountered
     // Add more fields later if needed (e.g., symbol table, error messages buffer)
@@ -23,7 +31,8 @@ typedef struct {
  * @brief Initializes the parser state.
  *
  * Sets up the parser with the given lexer and arena, and fetches the first two tokens
- * (current and peek) to prime the parsing process.
+ * (current and peek) to prime the parsing process. A string interner is created in the
+ * arena; every name in the resulting AST is canonical in it (see ProgramNode::interner).
  *
  * @param parser Pointer to the Parser struct to initialize.
  * @param lexer Pointer to the Lexer struct to use for tokenization.
@@ -31,6 +40,30 @@ typedef struct {
  */
 void parser_init(Parser *parser, Lexer *lexer, Arena *arena);
 
+/**
+ * @brief Initializes the parser to read a token array produced by lexer_tokenize.
+ *
+ * Tokens are read by index instead of being lexed on demand, so the source is
+ * only tokenized once. Names are interned as in parser_init.
+ *
+ * @param parser Pointer to the Parser struct to initialize.
+ * @param tokens Token array to parse; must end with TOKEN_EOF or TOKEN_UNKNOWN.
+ * @param arena Pointer to the memory arena to use for AST node allocations.
+ */
+void parser_init_tokens(Parser *parser, const TokenArray *tokens, Arena *arena);
+
+/**
+ * @brief Initializes the parser to take its tokens from a lexer thread (see token_ring.h).
+ *
+ * Parsing overlaps with lexing: a token is parsed as soon as the lexer thread has
+ * pushed it. Names are interned as in parser_init.
+ *
+ * @param parser Pointer to the Parser struct to initialize.
+ * @param ring The ring of a started LexerThread.
+ * @param arena Pointer to the memory arena to use for AST node allocations.
+ */
+void parser_init_ring(Parser *parser, TokenRing *ring, Arena *arena);
+
 /**
  * @brief Parses the entire token stream from the lexer.
  *
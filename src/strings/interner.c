@@ -0,0 +1,106 @@
+#include "interner.h"
+#include <stdio.h>
+#include <string.h>
+
+#define INTERNER_DEFAULT_CAPACITY 64
+
+// FNV-1a over the bytes of the slice
+static uint32_t hash_bytes(const char *s, const size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char) s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Returns the slot holding the slice, or the empty slot where it would be inserted
+static InternEntry *find_slot(const StringInterner *interner, const char *s, const size_t len, const uint32_t hash) {
+    const size_t mask = interner->capacity - 1;
+    size_t index = hash & mask;
+    for (;;) {
+        InternEntry *entry = &interner->entries[index];
+        if (!entry->text ||
+            (entry->hash == hash && entry->length == len && memcmp(entry->text, s, len) == 0)) {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+static bool allocate_table(StringInterner *interner, const size_t capacity) {
+    InternEntry *entries = arena_alloc_zeroed(interner->arena, capacity * sizeof(InternEntry));
+    if (!entries) {
+        fprintf(stderr, "Interner Error: Arena allocation failed for %zu slots.\n", capacity);
+        return false;
+    }
+    interner->entries = entries;
+    interner->capacity = capacity;
+    return true;
+}
+
+// Doubles the table; the old one stays in the arena
+static bool grow(StringInterner *interner) {
+    const InternEntry *old_entries = interner->entries;
+    const size_t old_capacity = interner->capacity;
+    if (!allocate_table(interner, old_capacity * 2)) {
+        return false;
+    }
+    for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_entries[i].text) {
+            *find_slot(interner, old_entries[i].text, old_entries[i].length, old_entries[i].hash) = old_entries[i];
+        }
+    }
+    return true;
+}
+
+bool interner_init(StringInterner *interner, Arena *arena, const size_t initial_capacity) {
+    interner->entries = NULL;
+    interner->capacity = 0;
+    interner->count = 0;
+    interner->arena = arena;
+    // Keep the table at most half full for the expected number of names
+    size_t capacity = INTERNER_DEFAULT_CAPACITY;
+    while (capacity < initial_capacity * 2) {
+        capacity *= 2;
+    }
+    return allocate_table(interner, capacity);
+}
+
+const char *interner_intern_n(StringInterner *interner, const char *s, const size_t len) {
+    if (!s || !interner->entries || len > UINT32_MAX) {
+        return NULL;
+    }
+    const uint32_t hash = hash_bytes(s, len);
+    InternEntry *entry = find_slot(interner, s, len, hash);
+    if (entry->text) {
+        return entry->text;
+    }
+
+    if ((interner->count + 1) * 2 > interner->capacity) {
+        if (!grow(interner)) {
+            return NULL;
+        }
+        entry = find_slot(interner, s, len, hash);
+    }
+    char *copy = arena_alloc(interner->arena, len + 1);
+    if (!copy) {
+        return NULL;
+    }
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    *entry = (InternEntry){copy, (uint32_t) len, hash};
+    interner->count++;
+    return copy;
+}
+
+const char *interner_intern(StringInterner *interner, const char *s) {
+    return s ? interner_intern_n(interner, s, strlen(s)) : NULL;
+}
+
+const char *interner_find_n(const StringInterner *interner, const char *s, const size_t len) {
+    if (!s || !interner->entries || len > UINT32_MAX) {
+        return NULL;
+    }
+    return find_slot(interner, s, len, hash_bytes(s, len))->text;
+}
@@ -0,0 +1,63 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../memory/arena.h"
+
+// One slot of the interner's hash table
+typedef struct {
+    const char *text; // Canonical NUL-terminated copy (NULL for an empty slot)
+    uint32_t length;  // Length of text
+    uint32_t hash;    // Cached hash of text
+} InternEntry;
+
+// String interner: maps each distinct byte sequence to one canonical, arena-owned string.
+// Two names interned by the same interner are equal exactly when their pointers are equal.
+// - Open addressing with linear probing; the table doubles when it is half full.
+// - Canonical strings live as long as the arena; the interner never frees them.
+typedef struct {
+    InternEntry *entries; // Hash table (capacity is a power of two)
+    size_t capacity;      // Number of slots
+    size_t count;         // Number of distinct strings interned
+    Arena *arena;         // Arena holding the table and the canonical strings
+} StringInterner;
+
+/**
+ * @brief Initializes an interner.
+ * @param interner Pointer to the interner to initialize.
+ * @param arena Arena for the table and the canonical strings; it must outlive every user of the names.
+ * @param initial_capacity Expected number of distinct names (rounded up; 0 picks a default).
+ * @return true on success, false if the table could not be allocated.
+ */
+bool interner_init(StringInterner *interner, Arena *arena, size_t initial_capacity);
+
+/**
+ * @brief Returns the canonical copy of a byte slice, interning it on first use.
+ * @param interner Pointer to the interner.
+ * @param s Bytes to intern; need not be NUL-terminated.
+ * @param len Number of bytes.
+ * @return The canonical NUL-terminated string, or NULL on allocation failure.
+ */
+const char *interner_intern_n(StringInterner *interner, const char *s, size_t len);
+
+/**
+ * @brief Returns the canonical copy of a NUL-terminated string, interning it on first use.
+ * @param interner Pointer to the interner.
+ * @param s The string to intern.
+ * @return The canonical string, or NULL if s is NULL or allocation fails.
+ */
+const char *interner_intern(StringInterner *interner, const char *s);
+
+/**
+ * @brief Looks up the canonical copy of a byte slice without interning it.
+ *        Never allocates, so it is safe to call while scratch memory of the same arena is marked.
+ * @param interner Pointer to the interner.
+ * @param s Bytes to look up; need not be NUL-terminated.
+ * @param len Number of bytes.
+ * @return The canonical string, or NULL if the slice was never interned.
+ */
+const char *interner_find_n(const StringInterner *interner, const char *s, size_t len);
+
+#endif // INTERNER_H
@@ -0,0 +1,57 @@
+#include "output_sink.h"
+#include <stdio.h>
+
+void output_sink_init_buffer(OutputSink *sink, StringBuffer *sb) {
+    sink->sb = sb;
+    sink->file = NULL;
+    sink->bytes_flushed = 0;
+    sink->failed = false;
+}
+
+void output_sink_init_file(OutputSink *sink, FILE *file, Arena *arena) {
+    // Contiguous staging: reset after each flush, so it only ever grows to the largest piece
+    string_buffer_init(&sink->staging, arena, OUTPUT_SINK_STAGING_CAPACITY);
+    sink->sb = &sink->staging;
+    sink->file = file;
+    sink->bytes_flushed = 0;
+    sink->failed = false;
+}
+
+StringBuffer *output_sink_buffer(OutputSink *sink) {
+    return sink->sb;
+}
+
+bool output_sink_flush(OutputSink *sink) {
+    if (!sink->file) {
+        return true; // Buffer sink: the text stays where it is
+    }
+    if (sink->failed) {
+        return false;
+    }
+    if (sink->sb->length > 0) {
+        if (!string_buffer_write(sink->sb, sink->file)) {
+            perror("Failed to write output");
+            sink->failed = true;
+            return false;
+        }
+        sink->bytes_flushed += sink->sb->length;
+        string_buffer_reset(sink->sb);
+    }
+    return true;
+}
+
+bool output_sink_finish(OutputSink *sink) {
+    if (!output_sink_flush(sink)) {
+        return false;
+    }
+    if (sink->file && fflush(sink->file) != 0) {
+        perror("Failed to flush output");
+        sink->failed = true;
+        return false;
+    }
+    return true;
+}
+
+size_t output_sink_total_bytes(const OutputSink *sink) {
+    return sink->bytes_flushed + sink->sb->length;
+}
@@ -0,0 +1,65 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "strings.h"
+#include "../memory/arena.h"
+
+// Initial capacity of a file sink's staging buffer; it grows to the largest unflushed piece
+#define OUTPUT_SINK_STAGING_CAPACITY ((size_t) 16 * 1024)
+
+// Where generated text ends up.
+// - Buffer sink: everything accumulates in a caller-owned StringBuffer (flushes are no-ops).
+// - File sink: text is staged in a StringBuffer and written to a stream on every flush,
+//   so memory stays bounded by the largest piece written between two flushes.
+// Producers append to output_sink_buffer() and call output_sink_flush() at natural
+// boundaries (codegen flushes after every function).
+// A sink refers to its own staging buffer, so it must not be copied after initialization.
+typedef struct {
+    StringBuffer *sb;      // Buffer receiving appends (the caller's buffer or `staging`)
+    StringBuffer staging;  // File sink only: holds the text since the last flush
+    FILE *file;            // File sink only: destination stream (NULL for a buffer sink)
+    size_t bytes_flushed;  // Bytes already written to `file`
+    bool failed;           // Set once a write has failed; later flushes are skipped
+} OutputSink;
+
+/**
+ * @brief Initializes a sink that keeps all output in an existing StringBuffer.
+ * @param sink The sink to initialize.
+ * @param sb Initialized StringBuffer that receives the output (not reset).
+ */
+void output_sink_init_buffer(OutputSink *sink, StringBuffer *sb);
+
+/**
+ * @brief Initializes a sink that writes its output to a stream on every flush.
+ * @param sink The sink to initialize.
+ * @param file Stream opened for writing; the sink does not close it.
+ * @param arena Arena for the staging buffer.
+ */
+void output_sink_init_file(OutputSink *sink, FILE *file, Arena *arena);
+
+/**
+ * @brief Returns the buffer producers should append to.
+ */
+StringBuffer *output_sink_buffer(OutputSink *sink);
+
+/**
+ * @brief Hands the text appended since the last flush to the destination.
+ *        For a file sink the text is written out and the staging buffer is reset.
+ * @return false if a write failed (now or earlier), true otherwise.
+ */
+bool output_sink_flush(OutputSink *sink);
+
+/**
+ * @brief Flushes the remaining text and, for a file sink, the stream itself.
+ * @return false if any write failed.
+ */
+bool output_sink_finish(OutputSink *sink);
+
+/**
+ * @brief Total number of bytes produced so far, flushed or not.
+ */
+size_t output_sink_total_bytes(const OutputSink *sink);
+
+#endif // OUTPUT_SINK_H
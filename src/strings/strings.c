@@ -6,11 +6,63 @@
 #include <stdarg.h>
 #include <stdbool.h>
 
+// Bytes used in the current buffer (in chunked mode, only the current segment counts)
+static size_t buffer_used(const StringBuffer *sb) {
+    return sb->length - sb->segment_base;
+}
+
+// Write position for the next append
+static char *buffer_cursor(const StringBuffer *sb) {
+    return sb->buffer + buffer_used(sb);
+}
+
+/**
+ * Chunked-mode growth: keeps the current segment in place and starts a new one
+ * large enough for `additional_needed` bytes plus the null terminator.
+ * An empty current segment is simply replaced, so it never shows up as a filled segment.
+ */
+static bool start_new_segment(StringBuffer *sb, const size_t additional_needed) {
+    if (additional_needed == (size_t) -1) {
+        fprintf(stderr, "StringBuffer Error: Size calculation overflow.\n");
+        return false;
+    }
+    const size_t new_capacity = additional_needed + 1 > sb->segment_size ? additional_needed + 1 : sb->segment_size;
+
+    if (buffer_used(sb) > 0) {
+        StringSegment *segment = arena_alloc_tagged(sb->arena, sizeof(StringSegment), ARENA_TAG_STRINGS);
+        if (!segment) {
+            fprintf(stderr, "Arena allocation failed for string buffer segment\n");
+            return false;
+        }
+        segment->next = NULL;
+        segment->data = sb->buffer;
+        segment->length = buffer_used(sb);
+        if (sb->last_segment) {
+            sb->last_segment->next = segment;
+        } else {
+            sb->first_segment = segment;
+        }
+        sb->last_segment = segment;
+        sb->segment_base = sb->length;
+    }
+
+    char *new_buffer = arena_alloc_tagged(sb->arena, new_capacity, ARENA_TAG_STRINGS);
+    if (!new_buffer) {
+        fprintf(stderr, "Arena allocation failed for string buffer segment\n");
+        return false;
+    }
+    sb->buffer = new_buffer;
+    sb->capacity = new_capacity;
+    sb->buffer[0] = '\0';
+    return true;
+}
+
 /**
  * Ensures that the StringBuffer has enough capacity to fit an additional
  * `additional_needed` bytes of content, including the null terminator.
  * If the buffer is too small, it is reallocated to a new capacity that is
- * at least as large as the required capacity.
+ * at least as large as the required capacity; in chunked mode a new segment
+ * is started instead and nothing is copied.
  * If reallocation fails, the function prints an error message and exits.
  * @param sb The StringBuffer to ensure has enough capacity, using its arena.
  * @param additional_needed The number of additional bytes to ensure space for.
@@ -18,8 +70,9 @@
  *         false if the buffer was too small and reallocation failed.
  */
 static bool ensure_capacity(StringBuffer *sb, const size_t additional_needed) {
-    const size_t required_total = sb->length + additional_needed;
-    if (required_total < sb->length) {
+    const size_t used = buffer_used(sb);
+    const size_t required_total = used + additional_needed;
+    if (required_total < used) {
         // Check for overflow
         fprintf(stderr, "StringBuffer Error: Size calculation overflow.\n");
         return false;
@@ -30,6 +83,10 @@ static bool ensure_capacity(StringBuffer *sb, const size_t additional_needed) {
         return true; // Enough space already
     }
 
+    if (sb->segment_size > 0) {
+        return start_new_segment(sb, additional_needed);
+    }
+
     // Calculate new capacity (e.g., double until sufficient)
     size_t new_capacity = sb->capacity > 0 ? sb->capacity : 1; // Start with 1 if capacity is 0
     while (new_capacity < required_capacity) {
@@ -46,7 +103,7 @@ static bool ensure_capacity(StringBuffer *sb, const size_t additional_needed) {
 
     // Reallocate
     // Use arena_alloc; resizing means allocating new block and copying
-    char *new_buffer = arena_alloc(sb->arena, new_capacity);
+    char *new_buffer = arena_alloc_tagged(sb->arena, new_capacity, ARENA_TAG_STRINGS);
     if (!new_buffer) {
         fprintf(stderr, "Arena allocation failed for string buffer resize\n");
         return false;
@@ -57,6 +114,9 @@ static bool ensure_capacity(StringBuffer *sb, const size_t additional_needed) {
         memcpy(new_buffer, sb->buffer, sb->length);
         // Old buffer remains in the arena, but sb->buffer now points to the new one.
     }
+    if (sb->buffer) {
+        arena_note_superseded(sb->arena, sb->capacity, ARENA_TAG_STRINGS);
+    }
 
     sb->buffer = new_buffer;
     sb->capacity = new_capacity;
@@ -72,7 +132,7 @@ void string_buffer_init(StringBuffer *sb, Arena *arena, size_t initial_capacity)
     }
     // Allocate initial buffer from the arena
     sb->arena = arena;
-    sb->buffer = (char *) arena_alloc(sb->arena, initial_capacity);
+    sb->buffer = (char *) arena_alloc_tagged(sb->arena, initial_capacity, ARENA_TAG_STRINGS);
     if (!sb->buffer) {
         fprintf(stderr, "Arena allocation failed for string buffer init\n");
         exit(EXIT_FAILURE); // Critical error
@@ -80,6 +140,18 @@ void string_buffer_init(StringBuffer *sb, Arena *arena, size_t initial_capacity)
     sb->capacity = initial_capacity;
     sb->length = 0;
     sb->buffer[0] = '\0'; // Start with an empty, null-terminated string
+    sb->segment_size = 0;
+    sb->segment_base = 0;
+    sb->first_segment = NULL;
+    sb->last_segment = NULL;
+}
+
+void string_buffer_init_chunked(StringBuffer *sb, Arena *arena, size_t segment_size) {
+    if (segment_size < 2) {
+        segment_size = STRING_BUFFER_DEFAULT_SEGMENT_SIZE;
+    }
+    string_buffer_init(sb, arena, segment_size);
+    sb->segment_size = segment_size;
 }
 
 /**
@@ -89,15 +161,12 @@ void string_buffer_init(StringBuffer *sb, Arena *arena, size_t initial_capacity)
  * string is formatted according to the given format string and variable
  * arguments.
  *
- * The function first calculates the size of the new content using vsnprintf
- * and then checks if the buffer has enough capacity. If the buffer has
- * enough capacity, the function appends the formatted string using vsnprintf
- * again. If the buffer does not have enough capacity, the function doubles
- * its capacity until it has enough capacity and then appends the formatted
- * string.
+ * The string is formatted straight into the buffer's spare capacity. Only if
+ * it did not fit is the buffer grown (doubling until large enough) and the
+ * string formatted a second time, so the common case costs one vsnprintf.
  *
- * If the formatted string is too large to fit in the buffer, the function
- * prints an error message to stderr and does not append the string.
+ * If the buffer cannot be grown, the function prints an error message to
+ * stderr and leaves the buffer's content unchanged.
  *
  * @param sb The StringBuffer to append to.
  * @param format The format string for the new content.
@@ -108,38 +177,80 @@ void string_buffer_append(StringBuffer *sb, const char *format, ...) {
     va_start(args1, format);
     va_copy(args2, args1);
 
-    // Calculate required size for the new content
-    int required = vsnprintf(NULL, 0, format, args1);
+    // First attempt: write into the spare capacity (vsnprintf reports the full length even if truncated)
+    const size_t spare = sb->capacity - buffer_used(sb);
+    const int required = vsnprintf(buffer_cursor(sb), spare, format, args1);
     va_end(args1);
     if (required < 0) {
         fprintf(stderr, "StringBuffer Error: vsnprintf calculation failed.\n");
+        *buffer_cursor(sb) = '\0'; // Drop any partial output
         va_end(args2);
         return; // Or handle error more gracefully
     }
 
-    size_t additional_needed = (size_t) required;
-
-    // Ensure buffer has enough capacity
-    if (!ensure_capacity(sb, additional_needed)) {
+    if ((size_t) required < spare) {
+        sb->length += (size_t) required; // It fit, including the NUL terminator
         va_end(args2);
-        // Error already printed by ensure_capacity or realloc failed (exit)
         return;
     }
 
-    // Append the formatted string to the buffer
-    // We write to sb->buffer + sb->length because we want to append to the existing content
-    // We write at most sb->capacity - sb->length bytes to ensure we don't overflow the buffer
-    int written = vsnprintf(sb->buffer + sb->length, sb->capacity - sb->length, format, args2);
+    // Did not fit: grow once to the exact requirement and format again
+    *buffer_cursor(sb) = '\0'; // Drop the truncated output
+    if (!ensure_capacity(sb, (size_t) required)) {
+        va_end(args2);
+        // Error already printed by ensure_capacity
+        return;
+    }
+    const int written = vsnprintf(buffer_cursor(sb), sb->capacity - buffer_used(sb), format, args2);
     va_end(args2);
 
-    if (written < 0 || (size_t) written != additional_needed) {
+    if (written != required) {
         fprintf(stderr, "StringBuffer Error: vsnprintf writing failed or wrote unexpected size.\n");
-        // Handle potential buffer corruption or error state
+        *buffer_cursor(sb) = '\0';
     } else {
-        sb->length += written;
-        // Ensure null termination is maintained, though vsnprintf should do this.
-        sb->buffer[sb->length] = '\0'; // Usually not needed if ensure_capacity worked
+        sb->length += (size_t) written;
+    }
+}
+
+void string_buffer_append_n(StringBuffer *sb, const char *s, const size_t n) {
+    if (!ensure_capacity(sb, n)) {
+        return; // Error already printed by ensure_capacity
     }
+    char *cursor = buffer_cursor(sb);
+    memcpy(cursor, s, n);
+    cursor[n] = '\0';
+    sb->length += n;
+}
+
+void string_buffer_append_str(StringBuffer *sb, const char *s) {
+    string_buffer_append_n(sb, s, strlen(s));
+}
+
+size_t format_decimal_int(char *out, const long long value) {
+    // Work on the magnitude as unsigned so LLONG_MIN does not overflow
+    unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long) value : (unsigned long long) value;
+    char digits[DECIMAL_INT_BUFFER_SIZE];
+    size_t count = 0;
+    do {
+        digits[count++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    size_t length = 0;
+    if (value < 0) {
+        out[length++] = '-';
+    }
+    while (count > 0) {
+        out[length++] = digits[--count];
+    }
+    out[length] = '\0';
+    return length;
+}
+
+void string_buffer_append_int(StringBuffer *sb, const long long value) {
+    char digits[DECIMAL_INT_BUFFER_SIZE];
+    const size_t length = format_decimal_int(digits, value);
+    string_buffer_append_n(sb, digits, length);
 }
 
 void string_buffer_append_char(StringBuffer *sb, char c) {
@@ -147,9 +258,10 @@ void string_buffer_append_char(StringBuffer *sb, char c) {
         // Error handled by ensure_capacity (exit or return)
         return;
     }
-    sb->buffer[sb->length] = c;
+    char *cursor = buffer_cursor(sb);
+    cursor[0] = c;
+    cursor[1] = '\0'; // Maintain null termination
     sb->length++;
-    sb->buffer[sb->length] = '\0'; // Maintain null termination
 }
 
 // --- Get Content ---
@@ -162,15 +274,82 @@ const char *string_buffer_content_str(const StringBuffer *sb) {
         // or if length is 0 (buffer might be allocated but empty)
         return "";
     }
+    if (sb->first_segment) {
+        return NULL; // Chunked content spread over several segments
+    }
     // Buffer should already be null-terminated by append functions
     return sb->buffer;
 }
 
+bool string_buffer_for_each_segment(const StringBuffer *sb, const StringSegmentVisitor visit, void *context) {
+    if (!sb || !sb->buffer) {
+        return true;
+    }
+    for (const StringSegment *segment = sb->first_segment; segment; segment = segment->next) {
+        if (!visit(segment->data, segment->length, context)) {
+            return false;
+        }
+    }
+    const size_t used = buffer_used(sb);
+    return used == 0 || visit(sb->buffer, used, context);
+}
+
+static bool write_segment(const char *data, const size_t length, void *context) {
+    return fwrite(data, 1, length, (FILE *) context) == length;
+}
+
+bool string_buffer_write(const StringBuffer *sb, FILE *out) {
+    return string_buffer_for_each_segment(sb, write_segment, out);
+}
+
+static bool append_segment(const char *data, const size_t length, void *context) {
+    string_buffer_append_n(context, data, length);
+    return true;
+}
+
+void string_buffer_append_buffer(StringBuffer *sb, const StringBuffer *other) {
+    string_buffer_for_each_segment(other, append_segment, sb);
+}
+
+static bool copy_segment(const char *data, const size_t length, void *context) {
+    char **cursor = context;
+    memcpy(*cursor, data, length);
+    *cursor += length;
+    return true;
+}
+
+const char *string_buffer_flatten(StringBuffer *sb) {
+    if (!sb->first_segment) {
+        return string_buffer_content_str(sb);
+    }
+    // Offer at least one segment of spare room so appends after flattening do not spill right away
+    const size_t capacity = sb->length + (sb->segment_size > 0 ? sb->segment_size : 1);
+    char *flat = arena_alloc_tagged(sb->arena, capacity, ARENA_TAG_STRINGS);
+    if (!flat) {
+        fprintf(stderr, "Arena allocation failed for string buffer flatten\n");
+        return NULL;
+    }
+    char *cursor = flat;
+    string_buffer_for_each_segment(sb, copy_segment, &cursor);
+    *cursor = '\0';
+
+    sb->buffer = flat;
+    sb->capacity = capacity;
+    sb->segment_base = 0;
+    sb->first_segment = NULL;
+    sb->last_segment = NULL;
+    return sb->buffer;
+}
+
 // --- Reset ---
 void string_buffer_reset(StringBuffer *sb) {
     if (sb && sb->buffer) {
         // Reset length, keep buffer and capacity, ready for reuse
+        // (chunked: only the current segment is reused, the filled ones are dropped)
         sb->length = 0;
+        sb->segment_base = 0;
+        sb->first_segment = NULL;
+        sb->last_segment = NULL;
         sb->buffer[0] = '\0'; // Ensure it's an empty string
     }
 }
@@ -181,9 +360,21 @@ char* arena_strdup(Arena *arena, const char *s) {
     if (!arena) return NULL; // Cannot allocate without an arena
 
     size_t len = strlen(s);
-    char *new_str = (char *)arena_alloc(arena, len + 1);
+    char *new_str = (char *)arena_alloc_tagged(arena, len + 1, ARENA_TAG_STRINGS);
     if (!new_str) return NULL; // Allocation failed
     
     memcpy(new_str, s, len + 1); // Copy including the null terminator
     return new_str;
 }
+
+char* arena_strndup(Arena *arena, const char *s, const size_t n) {
+    if (!s) return NULL;
+    if (!arena) return NULL; // Cannot allocate without an arena
+
+    char *new_str = (char *)arena_alloc_tagged(arena, n + 1, ARENA_TAG_STRINGS);
+    if (!new_str) return NULL; // Allocation failed
+
+    memcpy(new_str, s, n);
+    new_str[n] = '\0';
+    return new_str;
+}
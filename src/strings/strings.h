@@ -2,13 +2,33 @@
 #define STRINGS_H
 
 #include "../memory/arena.h" // Include Arena for memory management
+#include <stdio.h>  // For FILE
+#include <stdbool.h>
+
+// Default segment size for chunked StringBuffers
+#define STRING_BUFFER_DEFAULT_SEGMENT_SIZE ((size_t) 64 * 1024)
+
+// A filled segment of a chunked StringBuffer; segments are linked oldest-first.
+typedef struct StringSegment {
+    struct StringSegment *next;
+    const char *data;
+    size_t length;
+} StringSegment;
 
 // Generic dynamic string buffer using Arena allocation
+// - Contiguous mode (string_buffer_init): one buffer, doubled and copied on growth.
+// - Chunked mode (string_buffer_init_chunked): appends fill fixed-size segments; a full segment
+//   is kept where it is and a new one is started, so growth never copies or leaves dead copies behind.
+//   A single append is never split, so every segment holds whole appends.
 typedef struct {
-    char *buffer; // Pointer to the allocated buffer within the arena
-    size_t capacity; // Current allocated capacity
-    size_t length; // Current length of the string (excluding null terminator)
+    char *buffer; // Pointer to the allocated buffer within the arena (chunked: the current segment)
+    size_t capacity; // Current allocated capacity of `buffer`
+    size_t length; // Current length of the string (excluding null terminator), across all segments
     Arena *arena;  // Pointer to the arena used for allocations
+    size_t segment_size;           // Segment size in chunked mode, 0 in contiguous mode
+    size_t segment_base;           // Bytes held in the filled segments before `buffer` (0 when contiguous)
+    StringSegment *first_segment;  // Filled segments (NULL when contiguous or still in the first segment)
+    StringSegment *last_segment;
 } StringBuffer;
 
 /**
@@ -19,6 +39,17 @@ typedef struct {
  */
 void string_buffer_init(StringBuffer *sb, Arena *arena, size_t initial_capacity);
 
+/**
+ * Initializes a StringBuffer in chunked mode: content lives in a chain of segments
+ * that are never copied on growth. Read it back with string_buffer_write or
+ * string_buffer_for_each_segment (or string_buffer_flatten when one string is needed).
+ * @param sb Pointer to the StringBuffer to initialize.
+ * @param arena The Arena to use for allocations.
+ * @param segment_size Size of each segment; 0 selects STRING_BUFFER_DEFAULT_SEGMENT_SIZE.
+ *                     Appends larger than a segment get a segment of their own size.
+ */
+void string_buffer_init_chunked(StringBuffer *sb, Arena *arena, size_t segment_size);
+
 /**
  * Appends a formatted string to the StringBuffer, resizing if necessary using the arena.
  * @param sb Pointer to the StringBuffer.
@@ -27,6 +58,29 @@ void string_buffer_init(StringBuffer *sb, Arena *arena, size_t initial_capacity)
  */
 void string_buffer_append(StringBuffer *sb, const char *format, ...);
 
+/**
+ * Appends a NUL-terminated string verbatim (no format parsing), resizing if necessary.
+ * Prefer this over string_buffer_append for fixed text: it is a single memcpy.
+ * @param sb Pointer to the StringBuffer.
+ * @param s The string to append (not a format string: '%' is copied as is).
+ */
+void string_buffer_append_str(StringBuffer *sb, const char *s);
+
+/**
+ * Appends the first n bytes of s verbatim, resizing if necessary.
+ * @param sb Pointer to the StringBuffer.
+ * @param s Bytes to append; need not be NUL-terminated.
+ * @param n Number of bytes to append.
+ */
+void string_buffer_append_n(StringBuffer *sb, const char *s, size_t n);
+
+/**
+ * Appends the decimal representation of an integer without going through printf.
+ * @param sb Pointer to the StringBuffer.
+ * @param value The value to format (the full range, including LLONG_MIN, is supported).
+ */
+void string_buffer_append_int(StringBuffer *sb, long long value);
+
 /**
  * Appends a single character to the StringBuffer, resizing if necessary using the arena.
  * @param sb Pointer to the StringBuffer.
@@ -34,9 +88,39 @@ void string_buffer_append(StringBuffer *sb, const char *format, ...);
  */
 void string_buffer_append_char(StringBuffer *sb, char c);
 
-// Get the content as a C string (read-only, pointer valid until next modification)
+// Get the content as a C string (read-only, pointer valid until next modification).
+// A chunked buffer that has spilled into a second segment has no single string: NULL is returned.
 const char *string_buffer_content_str(const StringBuffer *sb);
 
+// Callback for string_buffer_for_each_segment; returning false stops the walk.
+typedef bool (*StringSegmentVisitor)(const char *data, size_t length, void *context);
+
+/**
+ * Calls `visit` for each non-empty piece of the content, in order (once for a contiguous buffer).
+ * @return false if a visitor returned false, true otherwise.
+ */
+bool string_buffer_for_each_segment(const StringBuffer *sb, StringSegmentVisitor visit, void *context);
+
+/**
+ * Writes the whole content to a stream, segment by segment, without building one string first.
+ * @return true if every byte was written.
+ */
+bool string_buffer_write(const StringBuffer *sb, FILE *out);
+
+/**
+ * Appends the whole content of another buffer (contiguous or chunked), segment by segment.
+ * @param sb Pointer to the StringBuffer receiving the content.
+ * @param other The buffer to copy from; must not be sb.
+ */
+void string_buffer_append_buffer(StringBuffer *sb, const StringBuffer *other);
+
+/**
+ * Returns the content as one C string. A chunked buffer spanning several segments is copied into
+ * a single new segment once (later appends continue after it); otherwise no copy is made.
+ * @return The content, or NULL if the copy could not be allocated.
+ */
+const char *string_buffer_flatten(StringBuffer *sb);
+
 /**
  * Resets the StringBuffer to be empty, allowing reuse of the allocated buffer.
  * Does not free memory (arena handles that).
@@ -44,6 +128,17 @@ const char *string_buffer_content_str(const StringBuffer *sb);
  */
 void string_buffer_reset(StringBuffer *sb);
 
+// Enough room for any long long in decimal, with sign and NUL terminator
+#define DECIMAL_INT_BUFFER_SIZE 21
+
+/**
+ * @brief Formats an integer in decimal into a caller-provided buffer (no printf).
+ * @param out Buffer of at least DECIMAL_INT_BUFFER_SIZE bytes; receives a NUL-terminated string.
+ * @param value The value to format.
+ * @return The number of characters written, excluding the NUL terminator.
+ */
+size_t format_decimal_int(char *out, long long value);
+
 /**
  * @brief Duplicates a string into the given arena.
  * @param arena The Arena to use for allocating the new string.
@@ -52,4 +147,13 @@ void string_buffer_reset(StringBuffer *sb);
  */
 char* arena_strdup(Arena *arena, const char *s);
 
+/**
+ * @brief Copies the first n bytes of a string (or string slice) into the arena, NUL-terminating the copy.
+ * @param arena The Arena to use for allocating the new string.
+ * @param s Pointer to the bytes to copy; need not be NUL-terminated.
+ * @param n Number of bytes to copy.
+ * @return Pointer to the newly allocated string in the arena, or NULL if allocation fails or s is NULL.
+ */
+char* arena_strndup(Arena *arena, const char *s, size_t n);
+
 #endif // STRINGS_H
@@ -3,12 +3,69 @@
 #include "../strings/strings.h" // For arena_strdup
 #include <string.h> // For strcmp, memcpy
 #include <stdio.h>  // For NULL (though stddef.h is better), and potential debug fprintf
+#include <stdint.h> // For uintptr_t
 
 #define INITIAL_SCOPE_CAPACITY 4
 #define INITIAL_SYMBOL_CAPACITY 8
+#define INITIAL_SLOT_CAPACITY 16
+
+// Canonical names are equal exactly when their pointers are; plain copies need strcmp
+static bool names_equal(const SymbolTable *st, const char *a, const char *b) {
+    return st->interner ? a == b : strcmp(a, b) == 0;
+}
+
+// Canonical names hash by address; plain copies hash their bytes (FNV-1a)
+static size_t hash_name(const SymbolTable *st, const char *name) {
+    if (st->interner) {
+        return (size_t) (((uintptr_t) name >> 3) * 0x9E3779B97F4A7C15ull >> 16);
+    }
+    size_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) name; *p; ++p) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the slot holding `name` in the scope's index, or the empty slot where it would go.
+// If probes is non-NULL, it receives the number of slots examined.
+static int *find_slot(const SymbolTable *st, const Scope *scope, const char *name, size_t *probes) {
+    const size_t mask = (size_t) scope->slot_capacity - 1;
+    size_t index = hash_name(st, name) & mask;
+    size_t examined = 1;
+    while (scope->slots[index] >= 0 && !names_equal(st, scope->symbols[scope->slots[index]].name, name)) {
+        index = (index + 1) & mask;
+        examined++;
+    }
+    if (probes) *probes = examined;
+    return &scope->slots[index];
+}
+
+static const Symbol *scope_lookup(const SymbolTable *st, const Scope *scope, const char *name) {
+    if (scope->symbol_count == 0) return NULL;
+    const int index = *find_slot(st, scope, name, NULL);
+    return index >= 0 ? &scope->symbols[index] : NULL;
+}
+
+// Rebuilds the scope's index with the given number of slots
+static bool rebuild_slots(const SymbolTable *st, Scope *scope, const int new_capacity) {
+    int *slots = (int *)arena_alloc(st->arena, (size_t) new_capacity * sizeof(int));
+    if (!slots) return false; // Arena allocation failed
+    memset(slots, 0xFF, (size_t) new_capacity * sizeof(int)); // All slots -1 (empty)
+    scope->slots = slots;
+    scope->slot_capacity = new_capacity;
+    for (int i = 0; i < scope->symbol_count; ++i) {
+        *find_slot(st, scope, scope->symbols[i].name, NULL) = i;
+    }
+    return true;
+}
 
 void symbol_table_init(SymbolTable *st, Arena *arena) {
+    symbol_table_init_interned(st, arena, NULL);
+}
+
+void symbol_table_init_interned(SymbolTable *st, Arena *arena, const StringInterner *interner) {
     st->arena = arena;
+    st->interner = interner;
     st->scopes = NULL; 
     st->scope_count = 0;
     st->scope_capacity = 0;
@@ -49,6 +106,11 @@ bool symbol_table_enter_scope(SymbolTable *st) {
     new_scope->symbols = NULL;
     new_scope->symbol_count = 0;
     new_scope->symbol_capacity = 0;
+    new_scope->slots = NULL;
+    new_scope->slot_capacity = 0;
+    // Everything allocated from here on belongs to this scope and can be released when it exits
+    new_scope->mark = arena_mark(st->arena);
+    new_scope->scopes_at_entry = st->scopes;
 
     st->scope_count++;
     return true;
@@ -56,25 +118,27 @@ bool symbol_table_enter_scope(SymbolTable *st) {
 
 void symbol_table_exit_scope(SymbolTable *st) {
     if (st->scope_count > 0) { // Should not exit global scope if only 1, but allow for now
-        // Memory for the scope and its symbols remains in the arena.
-        // If arena had a per-scope sub-allocator or stack marker, it could be reset here.
         st->scope_count--;
+        const Scope *scope = &st->scopes[st->scope_count];
+        // Give the scope's symbols back to the arena, unless the scope stack itself was
+        // reallocated after this scope was entered (it would be freed along with them).
+        if (st->scopes == scope->scopes_at_entry) {
+            arena_release(st->arena, scope->mark);
+        }
     }
 }
 
 const Symbol *symbol_table_lookup_symbol_in_current_scope(const SymbolTable *st, const char *name) {
     if (st->scope_count == 0) return NULL;
-
-    const Scope *current_scope = &st->scopes[st->scope_count - 1];
-    for (int i = 0; i < current_scope->symbol_count; ++i) {
-        if (strcmp(current_scope->symbols[i].name, name) == 0) {
-            return &current_scope->symbols[i];
-        }
-    }
-    return NULL;
+    return scope_lookup(st, &st->scopes[st->scope_count - 1], name);
 }
 
 bool symbol_table_add_symbol(SymbolTable *st, const char *name, Token declaration_token) {
+    return symbol_table_add_symbol_with_temp(st, name, declaration_token, -1);
+}
+
+bool symbol_table_add_symbol_with_temp(SymbolTable *st, const char *name, Token declaration_token,
+                                       const int temp_id) {
     if (st->scope_count == 0) return false; // Should not happen if global scope is always present
 
     Scope *current_scope = &st->scopes[st->scope_count - 1];
@@ -97,24 +161,48 @@ bool symbol_table_add_symbol(SymbolTable *st, const char *name, Token declaratio
         current_scope->symbol_capacity = new_capacity;
     }
 
+    // Keep the index at most half full so probe sequences stay short
+    if ((current_scope->symbol_count + 1) * 2 > current_scope->slot_capacity) {
+        const int new_slot_capacity = current_scope->slot_capacity == 0 ? INITIAL_SLOT_CAPACITY
+                                                                         : current_scope->slot_capacity * 2;
+        if (!rebuild_slots(st, current_scope, new_slot_capacity)) return false;
+    }
+
     Symbol *new_symbol = &current_scope->symbols[current_scope->symbol_count];
-    new_symbol->name = arena_strdup(st->arena, name);
+    // Canonical names outlive the table; anything else is copied into the table's arena
+    new_symbol->name = st->interner ? name : arena_strdup(st->arena, name);
     if (!new_symbol->name) return false; // arena_strdup failed
     
     new_symbol->declaration_token = declaration_token;
+    new_symbol->temp_id = temp_id;
 
+    *find_slot(st, current_scope, new_symbol->name, NULL) = current_scope->symbol_count;
     current_scope->symbol_count++;
     return true;
 }
 
 const Symbol *symbol_table_lookup_symbol(const SymbolTable *st, const char *name) {
     for (int i = st->scope_count - 1; i >= 0; --i) {
+        const Symbol *symbol = scope_lookup(st, &st->scopes[i], name);
+        if (symbol) {
+            return symbol;
+        }
+    }
+    return NULL;
+}
+
+SymbolTableStats symbol_table_stats(const SymbolTable *st) {
+    SymbolTableStats stats = {0};
+    for (int i = 0; i < st->scope_count; ++i) {
         const Scope *scope = &st->scopes[i];
+        stats.slot_count += (size_t) scope->slot_capacity;
         for (int j = 0; j < scope->symbol_count; ++j) {
-            if (strcmp(scope->symbols[j].name, name) == 0) {
-                return &scope->symbols[j];
-            }
+            size_t probes;
+            find_slot(st, scope, scope->symbols[j].name, &probes);
+            stats.symbol_count++;
+            stats.total_probes += probes;
+            if (probes > stats.max_probes) stats.max_probes = probes;
         }
     }
-    return NULL;
+    return stats;
 }
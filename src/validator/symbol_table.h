@@ -4,19 +4,26 @@
 #include <stdbool.h>
 #include "../memory/arena.h"
 #include "../lexer/lexer.h" // For Token
+#include "../strings/interner.h"
 
 // Represents a declared symbol (e.g., a variable)
 typedef struct {
-    char *name;                // Name of the symbol
+    const char *name;          // Name of the symbol (canonical pointer when the table is interned)
     Token declaration_token;   // Token where the symbol was declared (for error reporting)
+    int temp_id;               // TAC temp holding the variable (fused validate+lower), -1 otherwise
     // Future: Add data type information here, e.g., DataType type;
 } Symbol;
 
 // Represents a single scope (e.g., a block or function body)
+// Symbols are stored in declaration order; `slots` is an open-addressing hash index over them.
 typedef struct {
     Symbol *symbols;           // Dynamic array of symbols in this scope
     int symbol_count;          // Number of symbols in this scope
     int symbol_capacity;       // Capacity of the symbols array
+    int *slots;                // Hash index: symbol index per slot, -1 when empty (NULL until the first symbol)
+    int slot_capacity;         // Number of slots (power of two, kept at most half full)
+    ArenaMark mark;            // Arena position when the scope was entered
+    const void *scopes_at_entry; // Scope stack array at entry; if it moved, the mark cannot be released
 } Scope;
 
 // Represents the symbol table, managing a stack of scopes
@@ -25,8 +32,17 @@ typedef struct {
     int scope_count;           // Number of active scopes (current stack depth)
     int scope_capacity;        // Capacity of the scopes array
     Arena *arena;              // Arena allocator for all symbol table memory
+    const StringInterner *interner; // When set, names are canonical and compared by pointer
 } SymbolTable;
 
+// Hash index statistics over all active scopes, used to check that lookups stay O(1).
+typedef struct {
+    size_t symbol_count;     // Symbols across all active scopes
+    size_t slot_count;       // Hash slots across all active scopes
+    size_t total_probes;     // Sum over all symbols of the slots probed to find it
+    size_t max_probes;       // Longest probe sequence of any symbol
+} SymbolTableStats;
+
 // --- Public Symbol Table Interface ---
 
 /**
@@ -36,6 +52,16 @@ typedef struct {
  */
 void symbol_table_init(SymbolTable *st, Arena *arena);
 
+/**
+ * @brief Initializes a symbol table whose names all come from the given interner.
+ *        Every name passed to add/lookup must then be a canonical pointer returned by the
+ *        interner: symbols keep the pointer instead of a copy, and lookups compare pointers.
+ * @param st Pointer to the SymbolTable to initialize.
+ * @param arena Pointer to the memory arena to use for allocations.
+ * @param interner The interner that owns every name used with this table.
+ */
+void symbol_table_init_interned(SymbolTable *st, Arena *arena, const StringInterner *interner);
+
 /**
  * @brief Frees resources associated with the symbol table.
  *        Note: Memory for symbols/scopes themselves is managed by the arena.
@@ -55,6 +81,8 @@ bool symbol_table_enter_scope(SymbolTable *st);
 
 /**
  * @brief Exits the current scope (pops it from the scope stack).
+ *        Everything allocated from the table's arena since the scope was entered
+ *        (the scope's symbols and their names) is given back to the arena.
  * @param st Pointer to the SymbolTable.
  */
 void symbol_table_exit_scope(SymbolTable *st);
@@ -70,8 +98,20 @@ void symbol_table_exit_scope(SymbolTable *st);
  */
 bool symbol_table_add_symbol(SymbolTable *st, const char *name, Token declaration_token);
 
+/**
+ * @brief Same as symbol_table_add_symbol, also recording the TAC temp that holds the variable,
+ *        so that resolving a use of the name yields its storage directly.
+ * @param st Pointer to the SymbolTable.
+ * @param name The name of the symbol to add.
+ * @param declaration_token The token corresponding to this symbol's declaration.
+ * @param temp_id The temp to store in Symbol.temp_id.
+ * @return true if the symbol was added, false on re-declaration or allocation failure.
+ */
+bool symbol_table_add_symbol_with_temp(SymbolTable *st, const char *name, Token declaration_token, int temp_id);
+
 /**
  * @brief Looks up a symbol by name, searching from the current scope outwards to global.
+ *        Each scope costs one hash probe sequence, independent of how many symbols it holds.
  * @param st Pointer to the SymbolTable.
  * @param name The name of the symbol to find.
  * @return Const pointer to the Symbol if found, otherwise NULL.
@@ -87,4 +127,12 @@ const Symbol *symbol_table_lookup_symbol(const SymbolTable *st, const char *name
  */
 const Symbol *symbol_table_lookup_symbol_in_current_scope(const SymbolTable *st, const char *name);
 
+/**
+ * @brief Reports how well each scope's hash index spreads its symbols.
+ *        Walks every symbol, so it is meant for tests and benchmarks, not the hot path.
+ * @param st Pointer to the SymbolTable.
+ * @return Probe statistics for all active scopes.
+ */
+SymbolTableStats symbol_table_stats(const SymbolTable *st);
+
 #endif // SYMBOL_TABLE_H
@@ -2,21 +2,50 @@
 #include "../parser/ast.h"
 #include "symbol_table.h"
 #include "../memory/arena.h"
+#include "../memory/arena_stack.h"
+#include "../parser/flat_ast.h"
 
 #include <stdio.h> // For temporary error printing
 #include <string.h> // For strcmp, etc.
 
-// Forward declarations for static visitor functions
-static bool validate_node(AstNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_program_node(ProgramNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_func_def_node(FuncDefNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_block_node(BlockNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_var_decl_node(VarDeclNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_identifier_node(IdentifierNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_return_stmt_node(ReturnStmtNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_unary_op_node(UnaryOpNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_binary_op_node(BinaryOpNode* node, SymbolTable* st, Arena* error_arena);
-static bool validate_int_literal_node(IntLiteralNode* node, SymbolTable* st, Arena* error_arena);
+// One pending step of the walk: a node to validate, or the end of a block's scope
+typedef struct {
+    AstNode *node;    // Node to validate (NULL for a scope exit, or a missing optional child)
+    bool exits_scope; // Leave the innermost scope instead of validating a node
+} ValidationFrame;
+
+// Forward declarations for static visitor functions. Each one checks its node and pushes the
+// children still to be validated onto `pending`; validate_node runs them from an explicit
+// stack, so deeply nested expressions do not exhaust the C stack.
+static bool validate_node(AstNode* node, SymbolTable* st, Arena* stack_arena);
+static bool push_pending(ArenaStack* pending, AstNode* node, bool exits_scope);
+static bool validate_program_node(ProgramNode* node, ArenaStack* pending);
+static bool validate_func_def_node(FuncDefNode* node, ArenaStack* pending);
+static bool validate_block_node(BlockNode* node, SymbolTable* st, ArenaStack* pending);
+static bool validate_var_decl_node(VarDeclNode* node, SymbolTable* st, ArenaStack* pending);
+static bool validate_identifier_node(IdentifierNode* node, SymbolTable* st);
+static bool validate_return_stmt_node(ReturnStmtNode* node, ArenaStack* pending);
+static bool validate_unary_op_node(UnaryOpNode* node, ArenaStack* pending);
+static bool validate_binary_op_node(BinaryOpNode* node, ArenaStack* pending);
+static bool validate_int_literal_node(IntLiteralNode* node);
+static bool validate_flat_nodes(const FlatAst* ast, SymbolTable* st, Arena* stack_arena);
+
+// The pending-work stack gets an arena of its own: leaving a scope rolls the symbol table's
+// arena back to the scope's mark, which would free stack chunks added while the scope was open.
+#define VALIDATOR_STACK_ARENA_SIZE 4096
+
+static void init_symbol_table(SymbolTable* st, const StringInterner* interner, Arena* error_arena) {
+    // Assuming the error_arena can also be used by the symbol table for its internal allocations if needed,
+    // or the symbol table uses its own part of a larger arena system.
+    // For now, symbol_table_init takes an arena, let's use the error_arena for simplicity.
+    // In a more complex setup, the symbol table might have its own dedicated arena.
+    // Parsed trees carry the interner that owns their names, so symbols can be matched by pointer.
+    if (interner) {
+        symbol_table_init_interned(st, error_arena, interner);
+    } else {
+        symbol_table_init(st, error_arena); // Or a dedicated arena for the symbol table
+    }
+}
 
 // Main validation function
 bool validate_program(AstNode *program_node, Arena* error_arena) {
@@ -27,88 +56,155 @@ bool validate_program(AstNode *program_node, Arena* error_arena) {
         return false;
     }
 
+    // The symbol table is scratch memory: give it back once validation is done
+    const ArenaMark mark = arena_mark(error_arena);
     SymbolTable st;
-    // Assuming the error_arena can also be used by the symbol table for its internal allocations if needed,
-    // or the symbol table uses its own part of a larger arena system.
-    // For now, symbol_table_init takes an arena, let's use the error_arena for simplicity.
-    // In a more complex setup, the symbol table might have its own dedicated arena.
-    symbol_table_init(&st, error_arena); // Or a dedicated arena for the symbol table
+    init_symbol_table(&st, ((ProgramNode *) program_node)->interner, error_arena);
 
-    bool is_valid = validate_node(program_node, &st, error_arena);
+    Arena stack_arena = arena_create(VALIDATOR_STACK_ARENA_SIZE);
+    if (!stack_arena.start) {
+        fprintf(stderr, "Error: Failed to create the validation stack arena.\n");
+        symbol_table_free(&st);
+        arena_release(error_arena, mark);
+        return false;
+    }
+    bool is_valid = validate_node(program_node, &st, &stack_arena);
 
-    // symbol_table_free(&st); // Arena handles memory, but good for resetting if ST reused
+    arena_destroy(&stack_arena);
+    symbol_table_free(&st);
+    arena_release(error_arena, mark);
     return is_valid;
 }
 
-// Dispatcher function
-static bool validate_node(AstNode* node, SymbolTable* st, Arena* error_arena) {
-    if (!node) return true; // Or handle as an error, depending on context
-
-    switch (node->type) {
-        case NODE_PROGRAM:       return validate_program_node((ProgramNode*)node, st, error_arena);
-        case NODE_FUNC_DEF:      return validate_func_def_node((FuncDefNode*)node, st, error_arena);
-        case NODE_BLOCK:         return validate_block_node((BlockNode*)node, st, error_arena);
-        case NODE_VAR_DECL:      return validate_var_decl_node((VarDeclNode*)node, st, error_arena);
-        case NODE_IDENTIFIER:    return validate_identifier_node((IdentifierNode*)node, st, error_arena);
-        case NODE_RETURN_STMT:   return validate_return_stmt_node((ReturnStmtNode*)node, st, error_arena);
-        case NODE_UNARY_OP:      return validate_unary_op_node((UnaryOpNode*)node, st, error_arena);
-        case NODE_BINARY_OP:     return validate_binary_op_node((BinaryOpNode*)node, st, error_arena);
-        case NODE_INT_LITERAL:   return validate_int_literal_node((IntLiteralNode*)node, st, error_arena);
-        // Add cases for other node types as they are implemented
-        // e.g., NODE_EXPRESSION_STMT, NODE_IF_STMT, NODE_WHILE_STMT, etc.
-        default:
-            fprintf(stderr, "Warning: validate_node encountered unhandled AST node type: %d\n", node->type);
-            return true; // Or false if unhandled nodes mean an error
+bool validate_flat_program(const FlatAst *ast, Arena* error_arena) {
+    if (!ast || ast->root == AST_HANDLE_NONE || flat_ast_node(ast, ast->root)->type != NODE_PROGRAM) {
+        fprintf(stderr, "Error: validate_program called with invalid root node.\n");
+        return false;
+    }
+
+    const ArenaMark mark = arena_mark(error_arena);
+    SymbolTable st;
+    init_symbol_table(&st, ast->interner, error_arena);
+
+    Arena stack_arena = arena_create(VALIDATOR_STACK_ARENA_SIZE);
+    if (!stack_arena.start) {
+        fprintf(stderr, "Error: Failed to create the validation stack arena.\n");
+        symbol_table_free(&st);
+        arena_release(error_arena, mark);
+        return false;
+    }
+    bool is_valid = validate_flat_nodes(ast, &st, &stack_arena);
+
+    arena_destroy(&stack_arena);
+    symbol_table_free(&st);
+    arena_release(error_arena, mark);
+    return is_valid;
+}
+
+// Dispatcher function: validates the subtree in source order, stopping at the first error
+static bool validate_node(AstNode* node, SymbolTable* st, Arena* stack_arena) {
+    ArenaStack pending;
+    arena_stack_init(&pending, stack_arena, sizeof(ValidationFrame));
+    if (!push_pending(&pending, node, false)) {
+        return false;
+    }
+
+    bool is_valid = true;
+    while (is_valid && !arena_stack_is_empty(&pending)) {
+        const ValidationFrame frame = *(const ValidationFrame *) arena_stack_top(&pending);
+        arena_stack_pop(&pending);
+        if (frame.exits_scope) {
+            symbol_table_exit_scope(st);
+            continue;
+        }
+        AstNode* current = frame.node;
+        if (!current) continue; // Or handle as an error, depending on context
+
+        switch (current->type) {
+            case NODE_PROGRAM:       is_valid = validate_program_node((ProgramNode*)current, &pending); break;
+            case NODE_FUNC_DEF:      is_valid = validate_func_def_node((FuncDefNode*)current, &pending); break;
+            case NODE_BLOCK:         is_valid = validate_block_node((BlockNode*)current, st, &pending); break;
+            case NODE_VAR_DECL:      is_valid = validate_var_decl_node((VarDeclNode*)current, st, &pending); break;
+            case NODE_IDENTIFIER:    is_valid = validate_identifier_node((IdentifierNode*)current, st); break;
+            case NODE_RETURN_STMT:   is_valid = validate_return_stmt_node((ReturnStmtNode*)current, &pending); break;
+            case NODE_UNARY_OP:      is_valid = validate_unary_op_node((UnaryOpNode*)current, &pending); break;
+            case NODE_BINARY_OP:     is_valid = validate_binary_op_node((BinaryOpNode*)current, &pending); break;
+            case NODE_INT_LITERAL:   is_valid = validate_int_literal_node((IntLiteralNode*)current); break;
+            // Add cases for other node types as they are implemented
+            // e.g., NODE_EXPRESSION_STMT, NODE_IF_STMT, NODE_WHILE_STMT, etc.
+            default:
+                fprintf(stderr, "Warning: validate_node encountered unhandled AST node type: %d\n", current->type);
+                break; // Or an error if unhandled nodes mean one
+        }
+    }
+
+    // Ensure the scopes of unfinished blocks are exited on the error path
+    while (!arena_stack_is_empty(&pending)) {
+        const ValidationFrame *frame = arena_stack_top(&pending);
+        if (frame->exits_scope) {
+            symbol_table_exit_scope(st);
+        }
+        arena_stack_pop(&pending);
+    }
+    return is_valid;
+}
+
+// Schedules a node (or a scope exit). The stack is LIFO: children are pushed last to first.
+static bool push_pending(ArenaStack* pending, AstNode* node, const bool exits_scope) {
+    ValidationFrame* frame = arena_stack_push(pending);
+    if (!frame) {
+        fprintf(stderr, "Error: Out of memory while validating nested nodes.\n");
+        return false;
     }
+    frame->node = node;
+    frame->exits_scope = exits_scope;
+    return true;
 }
 
 // --- Stub implementations for specific node types --- 
 
-static bool validate_program_node(ProgramNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_program_node(ProgramNode* node, ArenaStack* pending) {
     // A program usually consists of a list of function definitions or other top-level statements.
     // For cleric, it's currently a single function definition.
-    if (node->function) {
-        return validate_node((AstNode*)node->function, st, error_arena);
-    }
-    return true;
+    return push_pending(pending, (AstNode*)node->function, false);
 }
 
-static bool validate_func_def_node(FuncDefNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_func_def_node(FuncDefNode* node, ArenaStack* pending) {
     // TODO: Add function name to symbol table? (depends on function scope handling)
     // TODO: Process parameters - add to a new scope for the function body.
     // For now, just validate the body.
-    if (node->body) {
-        return validate_node((AstNode*)node->body, st, error_arena);
-    }
-    return true;
+    return push_pending(pending, (AstNode*)node->body, false);
 }
 
-static bool validate_block_node(BlockNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_block_node(BlockNode* node, SymbolTable* st, ArenaStack* pending) {
     if (!symbol_table_enter_scope(st)) {
         fprintf(stderr, "Error: Failed to enter new scope.\n"); // Should ideally use error_arena
         return false;
     }
 
-    for (int i = 0; i < node->num_items; ++i) {
-        if (!validate_node(node->items[i], st, error_arena)) {
-            // Error already printed by the failing validate_node call, or will be.
-            symbol_table_exit_scope(st); // Ensure scope is exited on error path
-            return false; // Propagate error
+    // The scope is exited once every item has been validated, or when the walk is abandoned
+    if (!push_pending(pending, NULL, true)) {
+        symbol_table_exit_scope(st);
+        return false;
+    }
+    for (int i = node->num_items - 1; i >= 0; --i) {
+        if (!push_pending(pending, node->items[i], false)) {
+            return false;
         }
     }
-    symbol_table_exit_scope(st);
     return true;
 }
 
-static bool validate_var_decl_node(VarDeclNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_var_decl_node(VarDeclNode* node, SymbolTable* st, ArenaStack* pending) {
     // Synthesize a dummy token for the declaration.
     // Ideally, AST nodes would store or link back to original tokens for accurate error reporting.
     Token dummy_decl_token; // Not fully initialized, symbol_table_add_symbol only uses .lexeme effectively from it if arena_strdup is used for name
     // However, symbol_table_add_symbol copies the token structure, so we should make it valid.
     dummy_decl_token.type = TOKEN_IDENTIFIER; // Arbitrary, but makes some sense
-    dummy_decl_token.lexeme = (char*)node->var_name; // Will be strdup'd by symbol_table_add_symbol if it uses arena_strdup
+    dummy_decl_token.lexeme = node->var_name;
+    dummy_decl_token.length = (uint32_t) strlen(node->var_name);
     dummy_decl_token.position = 0; // Placeholder
-    // dummy_decl_token.line, dummy_decl_token.col, dummy_decl_token.length are missing from Token struct
+    // dummy_decl_token.line, dummy_decl_token.col are missing from Token struct
 
     if (!symbol_table_add_symbol(st, node->var_name, dummy_decl_token)) {
         // TODO: Improve error message with line/col if Token struct is enhanced.
@@ -117,15 +213,11 @@ static bool validate_var_decl_node(VarDeclNode* node, SymbolTable* st, Arena* er
         return false;
     }
 
-    if (node->initializer) {
-        if (!validate_node(node->initializer, st, error_arena)) {
-            return false; // Propagate error from initializer validation
-        }
-    }
-    return true;
+    // The variable is in scope in its own initializer
+    return push_pending(pending, node->initializer, false);
 }
 
-static bool validate_identifier_node(IdentifierNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_identifier_node(IdentifierNode* node, SymbolTable* st) {
     const Symbol* found_symbol = symbol_table_lookup_symbol(st, node->name);
     if (!found_symbol) {
         // TODO: Improve error message with line/col from the identifier's token.
@@ -136,24 +228,16 @@ static bool validate_identifier_node(IdentifierNode* node, SymbolTable* st, Aren
     return true;
 }
 
-static bool validate_return_stmt_node(ReturnStmtNode* node, SymbolTable* st, Arena* error_arena) {
-    if (node->expression) {
-        return validate_node(node->expression, st, error_arena);
-    }
-    return true; // Return without expression is valid for void, but cleric is int-only for now.
+static bool validate_return_stmt_node(ReturnStmtNode* node, ArenaStack* pending) {
+    // Return without expression is valid for void, but cleric is int-only for now.
+    return push_pending(pending, node->expression, false);
 }
 
-static bool validate_unary_op_node(UnaryOpNode* node, SymbolTable* st, Arena* error_arena) {
-    if (node->operand) {
-        return validate_node(node->operand, st, error_arena);
-    }
-    return true;
+static bool validate_unary_op_node(UnaryOpNode* node, ArenaStack* pending) {
+    return push_pending(pending, node->operand, false);
 }
 
-static bool validate_binary_op_node(BinaryOpNode* node, SymbolTable* st, Arena* error_arena) {
-    bool left_valid = true;
-    bool right_valid = true;
-
+static bool validate_binary_op_node(BinaryOpNode* node, ArenaStack* pending) {
     // Specific check for assignment operator's left-hand side (l-value)
     if (node->op == OPERATOR_ASSIGN) {
         if (!node->left || node->left->type != NODE_IDENTIFIER) {
@@ -164,23 +248,123 @@ static bool validate_binary_op_node(BinaryOpNode* node, SymbolTable* st, Arena*
     }
 
     // Validate left and right sub-expressions regardless of the operator
-    // (unless assignment check already failed)
-    if (node->left) {
-        left_valid = validate_node(node->left, st, error_arena);
-        if (!left_valid) return false; // Propagate error early
-    }
-    if (node->right) {
-        right_valid = validate_node(node->right, st, error_arena);
-        if (!right_valid) return false; // Propagate error early
-    }
-    return left_valid && right_valid;
+    // (unless assignment check already failed); the left one is validated first
+    return push_pending(pending, node->right, false) && push_pending(pending, node->left, false);
 }
 
-static bool validate_int_literal_node(IntLiteralNode* node, SymbolTable* st, Arena* error_arena) {
+static bool validate_int_literal_node(IntLiteralNode* node) {
     // Integer literals are generally always valid by themselves in terms of semantic checks at this level.
     // Type checking might happen here later if types are more complex.
     (void)node; // Unused for now
-    (void)st;   // Unused for now
-    (void)error_arena; // Unused for now
     return true;
 }
+
+// --- Flat tree ---
+// The same walk as validate_node over a FlatAst, with the same checks and messages
+
+// One pending step of the flat walk: a node to validate, or the end of a block's scope
+typedef struct {
+    AstHandle node;   // AST_HANDLE_NONE for a scope exit, or a missing optional child
+    bool exits_scope;
+} FlatValidationFrame;
+
+static bool push_flat_pending(ArenaStack* pending, const AstHandle node, const bool exits_scope) {
+    FlatValidationFrame* frame = arena_stack_push(pending);
+    if (!frame) {
+        fprintf(stderr, "Error: Out of memory while validating nested nodes.\n");
+        return false;
+    }
+    frame->node = node;
+    frame->exits_scope = exits_scope;
+    return true;
+}
+
+// Checks one flat node and schedules its children (last to first, so they run in source order)
+static bool validate_flat_node(const FlatAst* ast, const FlatAstNode* node, SymbolTable* st, ArenaStack* pending) {
+    switch ((NodeType) node->type) {
+        case NODE_PROGRAM:
+        case NODE_RETURN_STMT:
+        case NODE_UNARY_OP:
+            return push_flat_pending(pending, node->first, false);
+        case NODE_FUNC_DEF:
+            return push_flat_pending(pending, node->second, false);
+        case NODE_BLOCK:
+            if (!symbol_table_enter_scope(st)) {
+                fprintf(stderr, "Error: Failed to enter new scope.\n");
+                return false;
+            }
+            if (!push_flat_pending(pending, AST_HANDLE_NONE, true)) {
+                symbol_table_exit_scope(st);
+                return false;
+            }
+            for (uint32_t i = node->second; i > 0; --i) {
+                if (!push_flat_pending(pending, flat_ast_block_item(ast, node, i - 1), false)) {
+                    return false;
+                }
+            }
+            return true;
+        case NODE_VAR_DECL: {
+            const char* var_name = flat_ast_name(ast, node->first);
+            Token decl_token; // Synthesized, as for the pointer tree
+            decl_token.type = TOKEN_IDENTIFIER;
+            decl_token.lexeme = var_name;
+            decl_token.length = (uint32_t) strlen(var_name);
+            decl_token.position = 0;
+            if (!symbol_table_add_symbol(st, var_name, decl_token)) {
+                fprintf(stderr, "Error: Redeclaration of variable '%s'.\n", var_name);
+                return false;
+            }
+            // The variable is in scope in its own initializer
+            return push_flat_pending(pending, node->second, false);
+        }
+        case NODE_IDENTIFIER: {
+            const char* name = flat_ast_name(ast, node->first);
+            if (!symbol_table_lookup_symbol(st, name)) {
+                fprintf(stderr, "Error: Undeclared variable '%s'.\n", name);
+                return false;
+            }
+            return true;
+        }
+        case NODE_BINARY_OP:
+            if (node->op == OPERATOR_ASSIGN &&
+                (node->first == AST_HANDLE_NONE || flat_ast_node(ast, node->first)->type != NODE_IDENTIFIER)) {
+                fprintf(stderr, "Error: Left-hand side of assignment must be an l-value (e.g., a variable name).\n");
+                return false;
+            }
+            return push_flat_pending(pending, node->second, false) && push_flat_pending(pending, node->first, false);
+        case NODE_INT_LITERAL:
+            return true;
+        default:
+            fprintf(stderr, "Warning: validate_node encountered unhandled AST node type: %d\n", node->type);
+            return true;
+    }
+}
+
+static bool validate_flat_nodes(const FlatAst* ast, SymbolTable* st, Arena* stack_arena) {
+    ArenaStack pending;
+    arena_stack_init(&pending, stack_arena, sizeof(FlatValidationFrame));
+    if (!push_flat_pending(&pending, ast->root, false)) {
+        return false;
+    }
+
+    bool is_valid = true;
+    while (is_valid && !arena_stack_is_empty(&pending)) {
+        const FlatValidationFrame frame = *(const FlatValidationFrame *) arena_stack_top(&pending);
+        arena_stack_pop(&pending);
+        if (frame.exits_scope) {
+            symbol_table_exit_scope(st);
+        } else if (frame.node != AST_HANDLE_NONE) {
+            is_valid = validate_flat_node(ast, flat_ast_node(ast, frame.node), st, &pending);
+        }
+    }
+
+    // Ensure the scopes of unfinished blocks are exited on the error path
+    while (!arena_stack_is_empty(&pending)) {
+        const FlatValidationFrame *frame = arena_stack_top(&pending);
+        if (frame->exits_scope) {
+            symbol_table_exit_scope(st);
+        }
+        arena_stack_pop(&pending);
+    }
+    return is_valid;
+}
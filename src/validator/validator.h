@@ -2,6 +2,7 @@
 #define CLERIC_VALIDATOR_H
 
 #include "../parser/ast.h"
+#include "../parser/flat_ast.h"
 #include "../memory/arena.h"
 #include <stdbool.h>
 
@@ -14,4 +15,13 @@
  */
 bool validate_program(AstNode *program_node, Arena* error_arena);
 
+/**
+ * @brief Validates a program in flat form (see flat_ast.h), with the same checks and
+ *        error messages as validate_program.
+ * @param ast The flat tree, rooted at a NODE_PROGRAM node.
+ * @param error_arena Arena for the symbol table and walk; both are released before returning.
+ * @return true if the program is valid, false otherwise.
+ */
+bool validate_flat_program(const FlatAst *ast, Arena* error_arena);
+
 #endif //CLERIC_VALIDATOR_H
@@ -1,10 +1,15 @@
 #include "../_unity/unity.h"
 #include "../../src/codegen/codegen.h"
+#include "../../src/codegen/machine.h"
+#include "../../src/codegen/regalloc.h"
 #include "../../src/parser/ast.h"
 #include "../../src/ir/tac.h"
+#include "../../src/optimizer/optimizer.h"
 #include "../../src/strings/strings.h"
 #include "../../src/memory/arena.h"
 #include "ir/ast_to_tac.h"
+#include <stdio.h>
+#include <string.h>
 
 // --- Helper Functions for Testing Codegen ---
 
@@ -546,6 +551,642 @@ static void test_codegen_return_negated_parenthesized_constant(void) {
 
 // --- Test Runner ---
 
+// Test that a file sink receives the same assembly as a buffer, one function at a time
+static void test_codegen_streams_functions_to_file_sink(void) {
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *tac_program = create_tac_program(&arena);
+    const char *names[] = {"first", "second", "main"};
+    for (int i = 0; i < 3; ++i) {
+        TacFunction *func = create_tac_function(names[i], &arena);
+        add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(0),
+                                                                      create_tac_operand_const(i), &arena), &arena);
+        add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(0), &arena), &arena);
+        add_function_to_program(tac_program, func, &arena);
+    }
+
+    StringBuffer expected;
+    string_buffer_init(&expected, &arena, 256);
+    TEST_ASSERT_TRUE(codegen_generate_program(tac_program, &expected));
+
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    OutputSink sink;
+    output_sink_init_file(&sink, file, &arena);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(tac_program, &sink, NULL));
+    TEST_ASSERT_EQUAL(0, output_sink_buffer(&sink)->length); // Flushed after the last function
+    TEST_ASSERT_TRUE(output_sink_finish(&sink));
+    TEST_ASSERT_EQUAL(expected.length, output_sink_total_bytes(&sink));
+
+    char written[1024] = {0};
+    rewind(file);
+    const size_t read = fread(written, 1, sizeof(written) - 1, file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(expected.length, read);
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&expected), written);
+
+    arena_destroy(&arena);
+}
+
+// Builds a program of eight small functions with foldable arithmetic and dead temps
+static TacProgram *create_many_function_program(Arena *arena) {
+    TacProgram *tac_program = create_tac_program(arena);
+    char names[8][16];
+    for (int i = 0; i < 8; ++i) {
+        snprintf(names[i], sizeof(names[i]), i == 7 ? "main" : "f%d", i);
+        TacFunction *func = create_tac_function(names[i], arena);
+        add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(0),
+                                                                      create_tac_operand_const(i), arena), arena);
+        add_instruction_to_function(func, create_tac_instruction_add(create_tac_operand_temp(1),
+                                                                     create_tac_operand_temp(0),
+                                                                     create_tac_operand_const(3), arena), arena);
+        add_instruction_to_function(func, create_tac_instruction_negate(create_tac_operand_temp(2),
+                                                                        create_tac_operand_temp(1), arena), arena);
+        add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(1), arena), arena);
+        add_function_to_program(tac_program, func, arena);
+    }
+    return tac_program;
+}
+
+// Optimizes and generates the program with the given number of jobs into a buffer
+static void optimize_and_generate(TacProgram *tac_program, const int jobs, Arena *arena, StringBuffer *out) {
+    OptimizerOptions optimizer_options;
+    optimizer_options_for_level(&optimizer_options, 1);
+    optimizer_options.jobs = jobs;
+    bool changed = false;
+    TEST_ASSERT_TRUE(optimize_tac_program(tac_program, &optimizer_options, arena, &changed));
+    TEST_ASSERT_TRUE(changed);
+
+    CodegenOptions codegen_options;
+    codegen_options_init(&codegen_options);
+    codegen_options.jobs = jobs;
+    string_buffer_init(out, arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, out);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(tac_program, &sink, &codegen_options));
+    TEST_ASSERT_TRUE(output_sink_finish(&sink));
+}
+
+// Test that optimizing and generating functions on several threads gives the serial listing
+static void test_codegen_function_jobs_match_serial_output(void) {
+    Arena arena = arena_create(16384);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    StringBuffer serial;
+    optimize_and_generate(create_many_function_program(&arena), 1, &arena, &serial);
+    StringBuffer parallel;
+    optimize_and_generate(create_many_function_program(&arena), 4, &arena, &parallel);
+
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&serial), "f6:"));
+    TEST_ASSERT_NULL(strstr(string_buffer_content_str(&serial), "negl")); // Dead negation removed
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&serial), string_buffer_content_str(&parallel));
+    arena_destroy(&arena);
+}
+
+// Test that the machine printer renders every operand kind and condition in AT&T order
+static void test_machine_print_operands_and_conditions(void) {
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "f");
+
+    machine_emit(&mf, MACHINE_OP_GLOBL, machine_label("f"), machine_none());
+    machine_emit(&mf, MACHINE_OP_FUNCTION_LABEL, machine_label("f"), machine_none());
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(-2147483647 - 1), machine_stack(-16));
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-16), machine_reg(MACHINE_REG_R10, MACHINE_WIDTH_LONG));
+    machine_emit(&mf, MACHINE_OP_MOVQ, machine_reg(MACHINE_REG_SP, MACHINE_WIDTH_QUAD),
+                 machine_reg(MACHINE_REG_BP, MACHINE_WIDTH_QUAD));
+    machine_emit_cond(&mf, MACHINE_OP_SETCC, MACHINE_COND_LE, machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_BYTE));
+    machine_emit_cond(&mf, MACHINE_OP_JCC, MACHINE_COND_NZ, machine_local_label(3));
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(3), machine_none());
+    machine_emit(&mf, MACHINE_OP_CLTD, machine_none(), machine_none());
+    machine_emit(&mf, MACHINE_OP_NEGL, machine_stack(-8), machine_none());
+    machine_emit(&mf, MACHINE_OP_LEAL, machine_address(MACHINE_REG_SI, -4),
+                 machine_reg(MACHINE_REG_R8, MACHINE_WIDTH_LONG));
+    machine_emit(&mf, MACHINE_OP_LEAL, machine_address(MACHINE_REG_DI, 0),
+                 machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_LONG));
+    TEST_ASSERT_FALSE(mf.failed);
+
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 64);
+    machine_print_function(&sb, &mf);
+    TEST_ASSERT_EQUAL_STRING(".globl _f\n"
+                             "_f:\n"
+                             "    movl $-2147483648, -16(%rbp)\n"
+                             "    movl -16(%rbp), %r10d\n"
+                             "    movq %rsp, %rbp\n"
+                             "    setle %dl\n"
+                             "    jnz L3\n"
+                             "L3:\n"
+                             "    cltd\n"
+                             "    negl -8(%rbp)\n"
+                             "    leal -4(%rsi), %r8d\n"
+                             "    leal (%rdi), %eax\n",
+                             string_buffer_content_str(&sb));
+
+    // Reset keeps the capacity and starts an empty list for the next function
+    const size_t capacity = mf.capacity;
+    machine_function_reset(&mf, "g");
+    TEST_ASSERT_EQUAL(0, mf.count);
+    TEST_ASSERT_EQUAL(capacity, mf.capacity);
+
+    arena_destroy(&arena);
+}
+
+// Test that -O1 keeps temps in registers: t0 = 5; t1 = -t0; t2 = t1 + t0; return t2;
+static void test_codegen_allocates_temps_to_registers(void) {
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+
+    TacOperand t0 = create_tac_operand_temp(0);
+    TacOperand t1 = create_tac_operand_temp(1);
+    TacOperand t2 = create_tac_operand_temp(2);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_negate(t1, t0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t2, t1, t0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t2, &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.allocate_registers = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    // t0 and t1 overlap; t2 reuses t1's register since t1 dies where t2 is defined
+    const char *expected_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    subq $32, %rsp\n"
+            "    movl $5, %esi\n"
+            "    movl %esi, %eax\n"
+            "    negl %eax\n"
+            "    movl %eax, %edi\n"
+            "    movl %edi, %eax\n"
+            "    addl %esi, %eax\n"
+            "    movl %eax, %esi\n"
+            "    movl %esi, %eax\n"
+            "    leave\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected_asm, string_buffer_content_str(&sb));
+    arena_destroy(&arena);
+}
+
+// With every temp in a register no stack slot is used: the frame goes, or shrinks to the saved %rbp
+static void test_codegen_omits_unused_frame(void) {
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    TacOperand t0 = create_tac_operand_temp(0);
+    add_instruction_to_function(func, create_tac_instruction_negate(t0, create_tac_operand_const(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.allocate_registers = true;
+    options.trim_frame = true;
+    options.omit_frame_pointer = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+    const char *frameless_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    movl $5, %eax\n"
+            "    negl %eax\n"
+            "    movl %eax, %esi\n"
+            "    movl %esi, %eax\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(frameless_asm, string_buffer_content_str(&sb));
+
+    // --no-omit-frame-pointer: the frame stays for profilers, still without the 32-byte minimum
+    options.omit_frame_pointer = false;
+    string_buffer_init(&sb, &arena, 256);
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+    const char *framed_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    movl $5, %eax\n"
+            "    negl %eax\n"
+            "    movl %eax, %esi\n"
+            "    movl %esi, %eax\n"
+            "    popq %rbp\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(framed_asm, string_buffer_content_str(&sb));
+    arena_destroy(&arena);
+}
+
+// Test that a temp stays live across a branch: t0 = 1; if_false t0 goto L; t1 = 2; L: return t0;
+static void test_regalloc_liveness_across_labels(void) {
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacFunction *func = create_tac_function("main", &arena);
+    TacOperand t0 = create_tac_operand_temp(0);
+    TacOperand t1 = create_tac_operand_temp(1);
+    TacOperand label = create_tac_operand_label(0);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(t0, label, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(2), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(label, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+
+    LiveInterval *intervals;
+    size_t count;
+    int temp_count;
+    TEST_ASSERT_TRUE(compute_live_intervals(func, &arena, &intervals, &count, &temp_count));
+    TEST_ASSERT_EQUAL(2, temp_count);
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_EQUAL(1, intervals[0].start); // Defined by instruction 0 (point 2*0 + 1)
+    TEST_ASSERT_EQUAL(8, intervals[0].end);   // Used by the return (point 2*4)
+    TEST_ASSERT_EQUAL(5, intervals[1].start); // Dead store: live only at its definition
+    TEST_ASSERT_EQUAL(5, intervals[1].end);
+
+    // t1 is defined while t0 is live, so they need different registers
+    RegisterAllocation allocation;
+    TEST_ASSERT_TRUE(allocate_registers(func, &arena, &allocation));
+    TEST_ASSERT_EQUAL(TEMP_LOCATION_REGISTER, allocation.locations[0].kind);
+    TEST_ASSERT_EQUAL(TEMP_LOCATION_REGISTER, allocation.locations[1].kind);
+    TEST_ASSERT_NOT_EQUAL(allocation.locations[0].reg, allocation.locations[1].reg);
+    TEST_ASSERT_EQUAL(0, allocation.spill_slot_count);
+    arena_destroy(&arena);
+}
+
+// Test that packed stack slots follow live temps: a chain t(i+1) = -t(i) needs one slot, not one per id
+static void test_codegen_packs_stack_slots(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(0),
+                                                                  create_tac_operand_const(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_negate(create_tac_operand_temp(1),
+                                                                    create_tac_operand_temp(0), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(2),
+                                                                  create_tac_operand_temp(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(2), &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.pack_stack_slots = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    // All three temps share -8(%rbp); the copy t2 = t1 becomes a self-move and disappears
+    const char *expected_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    subq $32, %rsp\n"
+            "    movl $5, -8(%rbp)\n"
+            "    movl -8(%rbp), %eax\n"
+            "    negl %eax\n"
+            "    movl %eax, -8(%rbp)\n"
+            "    movl -8(%rbp), %eax\n"
+            "    leave\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected_asm, string_buffer_content_str(&sb));
+
+    // A long chain keeps the same frame, where one slot per id would need 8 * 40 bytes
+    TacFunction *chain = create_tac_function("chain", &arena);
+    add_instruction_to_function(chain, create_tac_instruction_copy(create_tac_operand_temp(0),
+                                                                   create_tac_operand_const(1), &arena), &arena);
+    for (int i = 1; i < 40; ++i) {
+        add_instruction_to_function(chain, create_tac_instruction_negate(create_tac_operand_temp(i),
+                                                                         create_tac_operand_temp(i - 1), &arena),
+                                    &arena);
+    }
+    add_instruction_to_function(chain, create_tac_instruction_return(create_tac_operand_temp(39), &arena), &arena);
+    RegisterAllocation layout;
+    TEST_ASSERT_TRUE(pack_stack_slots(chain, &arena, &layout));
+    TEST_ASSERT_EQUAL(1, layout.spill_slot_count);
+    TEST_ASSERT_EQUAL(TEMP_LOCATION_STACK, layout.locations[39].kind);
+    TEST_ASSERT_EQUAL(0, layout.locations[39].spill_slot);
+    TEST_ASSERT_EQUAL(320, (calculate_max_temp_id(chain) + 1) * 8);
+    arena_destroy(&arena);
+}
+
+// Test that pressure beyond the register file spills, and that callee-saved registers are saved/restored
+static void test_regalloc_spills_under_pressure(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    // t0..t11 = -i, all live at once, then summed into t12: 12 live temps for 10 registers
+    enum { LIVE = 12 };
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    for (int i = 0; i < LIVE; ++i) {
+        add_instruction_to_function(func, create_tac_instruction_negate(create_tac_operand_temp(i),
+                                                                        create_tac_operand_const(i), &arena),
+                                    &arena);
+    }
+    TacOperand sum = create_tac_operand_temp(LIVE);
+    add_instruction_to_function(func, create_tac_instruction_copy(sum, create_tac_operand_const(0), &arena), &arena);
+    for (int i = 0; i < LIVE; ++i) {
+        add_instruction_to_function(func, create_tac_instruction_add(sum, sum, create_tac_operand_temp(i), &arena),
+                                    &arena);
+    }
+    add_instruction_to_function(func, create_tac_instruction_return(sum, &arena), &arena);
+
+    RegisterAllocation allocation;
+    TEST_ASSERT_TRUE(allocate_registers(func, &arena, &allocation));
+    TEST_ASSERT_EQUAL(LIVE + 1, allocation.temp_count);
+    TEST_ASSERT_EQUAL(3, allocation.spill_slot_count); // 13 overlapping intervals, 10 registers
+
+    // No two temps share a register (every interval overlaps every other one)
+    bool seen[MACHINE_REG_COUNT] = {false};
+    int in_registers = 0;
+    for (int t = 0; t <= LIVE; ++t) {
+        const TempLocation *location = &allocation.locations[t];
+        if (location->kind == TEMP_LOCATION_REGISTER) {
+            TEST_ASSERT_FALSE(seen[location->reg]);
+            TEST_ASSERT_NOT_EQUAL(MACHINE_REG_AX, location->reg); // Scratch registers are never handed out
+            TEST_ASSERT_NOT_EQUAL(MACHINE_REG_R10, location->reg);
+            seen[location->reg] = true;
+            in_registers++;
+        }
+    }
+    TEST_ASSERT_EQUAL(REGALLOC_REGISTER_COUNT, in_registers);
+    TEST_ASSERT_TRUE(allocation.callee_saved_used[MACHINE_REG_BX]);
+    TEST_ASSERT_TRUE(allocation.callee_saved_used[MACHINE_REG_R15]);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.allocate_registers = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 2048);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+    const char *asm_text = string_buffer_content_str(&sb);
+
+    // Frame: 3 spill slots + 5 saved registers = 64 bytes; saves follow the spill slots
+    TEST_ASSERT_NOT_NULL(strstr(asm_text, "    subq $64, %rsp\n"
+                                          "    movq %rbx, -32(%rbp)\n"
+                                          "    movq %r12, -40(%rbp)\n"));
+    TEST_ASSERT_NOT_NULL(strstr(asm_text, "    movq -32(%rbp), %rbx\n"));
+    TEST_ASSERT_NOT_NULL(strstr(asm_text, "    movq -64(%rbp), %r15\n"
+                                          "    leave\n"
+                                          "    retq\n"));
+    arena_destroy(&arena);
+}
+
+// A comparison read only by the next conditional jump branches on the flags directly
+static void test_codegen_fuses_compare_and_branch(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    const TacOperand l0 = create_tac_operand_label(0);
+    add_instruction_to_function(func, create_tac_instruction_negate(create_tac_operand_temp(0),
+                                                                    create_tac_operand_const(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_less(create_tac_operand_temp(1),
+                                                                  create_tac_operand_temp(0),
+                                                                  create_tac_operand_const(3), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(create_tac_operand_temp(1), l0, &arena),
+                                &arena);
+    // t2 is also returned, so it still has to be materialized
+    add_instruction_to_function(func, create_tac_instruction_equal(create_tac_operand_temp(2),
+                                                                   create_tac_operand_temp(0),
+                                                                   create_tac_operand_const(-5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_true_goto(create_tac_operand_temp(2), l0, &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(2), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(1), &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.fuse_compare_branches = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    const char *expected_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    subq $32, %rsp\n"
+            "    movl $5, %eax\n"
+            "    negl %eax\n"
+            "    movl %eax, -8(%rbp)\n"
+            "    movl -8(%rbp), %eax\n"
+            "    cmpl $3, %eax\n"
+            "    jge L0\n" // if_false of <
+            "    movl -8(%rbp), %eax\n"
+            "    cmpl $-5, %eax\n"
+            "    sete %al\n"
+            "    movzbl %al, %eax\n"
+            "    movl %eax, -24(%rbp)\n"
+            "    movl -24(%rbp), %eax\n"
+            "    testl %eax, %eax\n"
+            "    jnz L0\n"
+            "    movl -24(%rbp), %eax\n" // Returns early with the epilogue repeated in place
+            "    leave\n"
+            "    retq\n"
+            "L0:\n"
+            "    movl $1, %eax\n"
+            "    leave\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected_asm, string_buffer_content_str(&sb));
+    arena_destroy(&arena);
+}
+
+// ADD/SUB, comparisons and conditional jumps work on the temps' own slots
+static void test_codegen_selects_in_place_forms(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand t2 = create_tac_operand_temp(2);
+    const TacOperand l0 = create_tac_operand_label(0);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t0, t0, create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_sub(t1, t0, create_tac_operand_const(10), &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t0, t1, t0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_less(t2, create_tac_operand_const(3), t0, &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(t2, l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(0), &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.select_in_place = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    const char *expected_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    subq $32, %rsp\n"
+            "    movl $5, -8(%rbp)\n"
+            "    incl -8(%rbp)\n"
+            "    movl -8(%rbp), %r10d\n" // Copy, then subtract the constant in place
+            "    movl %r10d, -16(%rbp)\n"
+            "    subl $10, -16(%rbp)\n"
+            "    movl -16(%rbp), %r10d\n" // Both operands in memory
+            "    addl %r10d, -8(%rbp)\n"
+            "    cmpl $3, -8(%rbp)\n" // 3 < t0 is t0 > 3
+            "    setg %al\n"
+            "    movzbl %al, %eax\n"
+            "    movl %eax, -24(%rbp)\n"
+            "    cmpl $0, -24(%rbp)\n"
+            "    jz L0\n"
+            "    movl -8(%rbp), %eax\n"
+            "    leave\n"
+            "    retq\n"
+            "L0:\n"
+            "    movl $0, %eax\n"
+            "    leave\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected_asm, string_buffer_content_str(&sb));
+    arena_destroy(&arena);
+}
+
+// With the temps in registers, copy-and-add becomes leal and the zero test becomes testl
+static void test_codegen_selects_leal_and_testl_for_registers(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand t2 = create_tac_operand_temp(2);
+    const TacOperand l0 = create_tac_operand_label(0);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(7), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t1, create_tac_operand_const(-4), t0, &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_sub(t2, t0, create_tac_operand_const(-1), &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_true_goto(t1, l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t1, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t2, &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.select_in_place = true;
+    options.allocate_registers = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    const char *expected_asm =
+            ".globl _main\n"
+            "_main:\n"
+            "    pushq %rbp\n"
+            "    movq %rsp, %rbp\n"
+            "    subq $32, %rsp\n"
+            "    movl $7, %esi\n"
+            "    leal -4(%rsi), %edi\n"
+            "    incl %esi\n" // t2 takes over the register of t0, which dies here
+            "    testl %edi, %edi\n"
+            "    jnz L0\n"
+            "    movl %edi, %eax\n"
+            "    leave\n"
+            "    retq\n"
+            "L0:\n"
+            "    movl %esi, %eax\n"
+            "    leave\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected_asm, string_buffer_content_str(&sb));
+    arena_destroy(&arena);
+}
+
+// With callee-saved registers to restore, an early RETURN jumps to the one epilogue instead of repeating it
+static void test_codegen_early_return_jumps_to_shared_epilogue(void) {
+    Arena arena = arena_create(8192);
+    TEST_ASSERT_NOT_NULL(arena.start);
+
+    TacProgram *prog = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_function_to_program(prog, func, &arena);
+    const TacOperand l0 = create_tac_operand_label(0);
+    for (int i = 0; i < 6; ++i) {
+        // Six temps live at once: one more than the caller-saved registers
+        add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(i),
+                                                                      create_tac_operand_const(i + 1), &arena),
+                                    &arena);
+    }
+    add_instruction_to_function(func, create_tac_instruction_if_true_goto(create_tac_operand_temp(0), l0, &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(create_tac_operand_temp(6), create_tac_operand_temp(1),
+                                                                 create_tac_operand_temp(2), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(6), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(create_tac_operand_temp(7), create_tac_operand_temp(3),
+                                                                 create_tac_operand_temp(4), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(create_tac_operand_temp(8), create_tac_operand_temp(7),
+                                                                 create_tac_operand_temp(5), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(8), &arena), &arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.allocate_registers = true;
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &sb);
+    TEST_ASSERT_TRUE(codegen_generate_program_to_sink(prog, &sink, &options));
+
+    const char *assembly = string_buffer_content_str(&sb);
+    TEST_ASSERT_NOT_NULL(strstr(assembly, "movq %rbx, ")); // Saved in the prologue
+    TEST_ASSERT_NOT_NULL(strstr(assembly, "    jmp L1\n")); // Past the function's own label L0
+    const char *epilogue = strstr(assembly, "L1:\n");
+    TEST_ASSERT_NOT_NULL(epilogue);
+    TEST_ASSERT_NOT_NULL(strstr(epilogue, ", %rbx\n    leave\n    retq\n"));
+    const char *ret = strstr(assembly, "retq");
+    TEST_ASSERT_NOT_NULL(ret);
+    TEST_ASSERT_NULL(strstr(ret + 1, "retq")); // One epilogue
+    arena_destroy(&arena);
+}
+
 void run_codegen_tests(void) {
     RUN_TEST(test_codegen_simple_return);
     RUN_TEST(test_operand_to_assembly_string_const_ok);
@@ -569,4 +1210,16 @@ void run_codegen_tests(void) {
     RUN_TEST(test_codegen_complement_of_negated_constant);
     RUN_TEST(test_codegen_stack_allocation_for_many_temps);
     RUN_TEST(test_codegen_return_negated_parenthesized_constant);
+    RUN_TEST(test_codegen_streams_functions_to_file_sink);
+    RUN_TEST(test_codegen_function_jobs_match_serial_output);
+    RUN_TEST(test_machine_print_operands_and_conditions);
+    RUN_TEST(test_codegen_allocates_temps_to_registers);
+    RUN_TEST(test_codegen_omits_unused_frame);
+    RUN_TEST(test_regalloc_liveness_across_labels);
+    RUN_TEST(test_regalloc_spills_under_pressure);
+    RUN_TEST(test_codegen_packs_stack_slots);
+    RUN_TEST(test_codegen_fuses_compare_and_branch);
+    RUN_TEST(test_codegen_selects_in_place_forms);
+    RUN_TEST(test_codegen_selects_leal_and_testl_for_registers);
+    RUN_TEST(test_codegen_early_return_jumps_to_shared_epilogue);
 }
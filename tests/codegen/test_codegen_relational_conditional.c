@@ -653,7 +653,7 @@ static void test_codegen_if_false_goto_jumps(void) {
     TacOperand const0 = create_tac_operand_const(0);
     TacOperand const10 = create_tac_operand_const(10);
     TacOperand const20 = create_tac_operand_const(20);
-    TacOperand label0 = create_tac_operand_label("_L0");
+    TacOperand label0 = create_tac_operand_label(0);
 
     // Instructions
     // t0 = 0
@@ -686,9 +686,9 @@ static void test_codegen_if_false_goto_jumps(void) {
             "    movl $0, -8(%rbp)\n"
             "    movl -8(%rbp), %eax\n"
             "    testl %eax, %eax\n"
-            "    jz _L0\n"
+            "    jz L0\n"
             "    movl $10, -16(%rbp)\n"
-            "_L0:\n"
+            "L0:\n"
             "    movl $20, -16(%rbp)\n"
             "    movl -16(%rbp), %eax\n"
             "    leave\n"
@@ -710,23 +710,23 @@ static void test_codegen_if_false_goto_no_jump(void) {
     TacOperand const1 = create_tac_operand_const(1);
     TacOperand const10 = create_tac_operand_const(10);
     TacOperand const20 = create_tac_operand_const(20);
-    TacOperand label0 = create_tac_operand_label("_L0");
-    TacOperand label1 = create_tac_operand_label("_L1");
+    TacOperand label0 = create_tac_operand_label(0);
+    TacOperand label1 = create_tac_operand_label(1);
 
     // Instructions
     // t0 = 1 (true)
     TacInstruction *instr1 = create_tac_instruction_copy(t0, const1, &test_arena);
-    // IF_FALSE t0 GOTO _L0 (no jump)
+    // IF_FALSE t0 GOTO L0 (no jump)
     TacInstruction *instr2 = create_tac_instruction_if_false_goto(t0, label0, &test_arena);
     // t1 = 10 (executed)
     TacInstruction *instr3 = create_tac_instruction_copy(t1, const10, &test_arena);
-    // GOTO _L1
+    // GOTO L1
     TacInstruction *instr4 = create_tac_instruction_goto(label1, &test_arena);
-    // _L0: (skipped section)
+    // L0: (skipped section)
     TacInstruction *instr5 = create_tac_instruction_label(label0, &test_arena);
     // t1 = 20 (skipped)
     TacInstruction *instr6 = create_tac_instruction_copy(t1, const20, &test_arena);
-    // _L1: (continue execution)
+    // L1: (continue execution)
     TacInstruction *instr7 = create_tac_instruction_label(label1, &test_arena);
     // RETURN t1 (should be 10)
     TacInstruction *instr8 = create_tac_instruction_return(t1, &test_arena);
@@ -750,12 +750,12 @@ static void test_codegen_if_false_goto_no_jump(void) {
             "    movl $1, -8(%rbp)\n"
             "    movl -8(%rbp), %eax\n"
             "    testl %eax, %eax\n"
-            "    jz _L0\n"
+            "    jz L0\n"
             "    movl $10, -16(%rbp)\n"
-            "    jmp _L1\n"
-            "_L0:\n"
+            "    jmp L1\n"
+            "L0:\n"
             "    movl $20, -16(%rbp)\n"
-            "_L1:\n"
+            "L1:\n"
             "    movl -16(%rbp), %eax\n"
             "    leave\n"
             "    retq\n";
@@ -777,16 +777,16 @@ static void test_codegen_if_true_goto_jumps(void) {
     TacOperand const1 = create_tac_operand_const(1); // For t0 = 1 (true condition)
     TacOperand const10 = create_tac_operand_const(10);
     TacOperand const20 = create_tac_operand_const(20);
-    TacOperand label0 = create_tac_operand_label("_L0");
+    TacOperand label0 = create_tac_operand_label(0);
 
     // Instructions
     // t0 = 1
     TacInstruction *instr1 = create_tac_instruction_copy(t0, const1, &test_arena);
-    // IF_TRUE t0 GOTO _L0 (jump occurs because t0 is true)
+    // IF_TRUE t0 GOTO L0 (jump occurs because t0 is true)
     TacInstruction *instr2 = create_tac_instruction_if_true_goto(t0, label0, &test_arena);
     // t1 = 10 (skipped)
     TacInstruction *instr3 = create_tac_instruction_copy(t1, const10, &test_arena);
-    // _L0:
+    // L0:
     TacInstruction *instr4 = create_tac_instruction_label(label0, &test_arena);
     // t1 = 20 (executed)
     TacInstruction *instr5 = create_tac_instruction_copy(t1, const20, &test_arena);
@@ -810,9 +810,9 @@ static void test_codegen_if_true_goto_jumps(void) {
             "    movl $1, -8(%rbp)\n"
             "    movl -8(%rbp), %eax\n"
             "    testl %eax, %eax\n"
-            "    jnz _L0\n"
+            "    jnz L0\n"
             "    movl $10, -16(%rbp)\n"
-            "_L0:\n"
+            "L0:\n"
             "    movl $20, -16(%rbp)\n"
             "    movl -16(%rbp), %eax\n"
             "    leave\n"
@@ -834,23 +834,23 @@ static void test_codegen_if_true_goto_no_jump(void) {
     TacOperand const0 = create_tac_operand_const(0); // For t0 = 0 (false condition)
     TacOperand const10 = create_tac_operand_const(10);
     TacOperand const20 = create_tac_operand_const(20);
-    TacOperand label0 = create_tac_operand_label("_L0");
-    TacOperand label1 = create_tac_operand_label("_L1");
+    TacOperand label0 = create_tac_operand_label(0);
+    TacOperand label1 = create_tac_operand_label(1);
 
     // Instructions
     // t0 = 0
     TacInstruction *instr1 = create_tac_instruction_copy(t0, const0, &test_arena);
-    // IF_TRUE t0 GOTO _L0 (no jump because t0 is false)
+    // IF_TRUE t0 GOTO L0 (no jump because t0 is false)
     TacInstruction *instr2 = create_tac_instruction_if_true_goto(t0, label0, &test_arena);
     // t1 = 10 (executed)
     TacInstruction *instr3 = create_tac_instruction_copy(t1, const10, &test_arena);
-    // GOTO _L1
+    // GOTO L1
     TacInstruction *instr4 = create_tac_instruction_goto(label1, &test_arena);
-    // _L0: (skipped section)
+    // L0: (skipped section)
     TacInstruction *instr5 = create_tac_instruction_label(label0, &test_arena);
     // t1 = 20 (skipped)
     TacInstruction *instr6 = create_tac_instruction_copy(t1, const20, &test_arena);
-    // _L1: (continue execution)
+    // L1: (continue execution)
     TacInstruction *instr7 = create_tac_instruction_label(label1, &test_arena);
     // RETURN t1 (should be 10)
     TacInstruction *instr8 = create_tac_instruction_return(t1, &test_arena);
@@ -874,12 +874,12 @@ static void test_codegen_if_true_goto_no_jump(void) {
             "    movl $0, -8(%rbp)\n"
             "    movl -8(%rbp), %eax\n"
             "    testl %eax, %eax\n"
-            "    jnz _L0\n"
+            "    jnz L0\n"
             "    movl $10, -16(%rbp)\n"
-            "    jmp _L1\n"
-            "_L0:\n"
+            "    jmp L1\n"
+            "L0:\n"
             "    movl $20, -16(%rbp)\n"
-            "_L1:\n"
+            "L1:\n"
             "    movl -16(%rbp), %eax\n"
             "    leave\n"
             "    retq\n";
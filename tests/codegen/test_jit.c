@@ -0,0 +1,115 @@
+#include "unity.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/compiler/code_cache.h"
+#include "../../src/codegen/jit.h"
+#include <stdio.h>
+#include <string.h>
+
+// Compiles one source into memory and returns what main returned
+static int run_source(const char *source, const CompileOptions *options, CodeCache *cache) {
+    int result = -1;
+    TEST_ASSERT_TRUE_MESSAGE(compile_and_run(source, strlen(source), options, cache, &result), source);
+    return result;
+}
+
+static void require_jit(void) {
+    if (!jit_supported()) {
+        TEST_IGNORE_MESSAGE("Running generated code needs an x86-64 POSIX host");
+    }
+}
+
+// --- Test Cases ---
+
+static void test_run_returns_main_result(void) {
+    require_jit();
+    CompileOptions options;
+    compile_options_init(&options);
+    TEST_ASSERT_EQUAL_INT(42, run_source("int main(void) { return 6 * 7; }", &options, NULL));
+    TEST_ASSERT_EQUAL_INT(-3, run_source("int main(void) { return -(10 / 3); }", &options, NULL));
+    TEST_ASSERT_EQUAL_INT(1, run_source("int main(void) { return (1 < 2) && !(3 == 4); }", &options, NULL));
+}
+
+static void test_run_optimized_variables(void) {
+    require_jit();
+    CompileOptions options;
+    compile_options_init(&options);
+    options.fuse_validation = true; // Lowers the variables
+    const char *source = "int main(void) { int a = 6; int b = a * 7; a = b % 5 + a; return a - (b > 40); }";
+    TEST_ASSERT_EQUAL_INT(7, run_source(source, &options, NULL));
+    options.optimization_level = 1;
+    TEST_ASSERT_EQUAL_INT(7, run_source(source, &options, NULL));
+    options.no_peephole = true;
+    TEST_ASSERT_EQUAL_INT(7, run_source(source, &options, NULL));
+}
+
+static void test_cache_compiles_each_source_once(void) {
+    require_jit();
+    CodeCache cache;
+    TEST_ASSERT_TRUE(code_cache_init(&cache));
+    CompileOptions options;
+    compile_options_init(&options);
+
+    const char *source = "int main(void) { return 2 + 3 * 4; }";
+    TEST_ASSERT_EQUAL_INT(14, run_source(source, &options, &cache));
+    TEST_ASSERT_EQUAL_INT(14, run_source(source, &options, &cache));
+    TEST_ASSERT_EQUAL_size_t(1, cache.count);
+    TEST_ASSERT_EQUAL_size_t(1, cache.hits);
+    TEST_ASSERT_EQUAL_size_t(1, cache.misses);
+
+    // Another source, or other code-affecting options, is a separate entry
+    TEST_ASSERT_EQUAL_INT(15, run_source("int main(void) { return 3 + 3 * 4; }", &options, &cache));
+    options.optimization_level = 1;
+    TEST_ASSERT_EQUAL_INT(14, run_source(source, &options, &cache));
+    TEST_ASSERT_EQUAL_size_t(3, cache.count);
+    TEST_ASSERT_EQUAL_size_t(1, cache.hits);
+
+    // Only the first `length` bytes are the key
+    TEST_ASSERT_NOT_NULL(code_cache_lookup(&cache, "int main(void) { return 2 + 3 * 4; } trailing", strlen(source),
+                                           &options));
+    code_cache_destroy(&cache);
+}
+
+static void test_cache_grows(void) {
+    require_jit();
+    CodeCache cache;
+    TEST_ASSERT_TRUE(code_cache_init(&cache));
+    CompileOptions options;
+    compile_options_init(&options);
+
+    char source[64];
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            snprintf(source, sizeof(source), "int main(void) { return %d - 100; }", i);
+            TEST_ASSERT_EQUAL_INT(i - 100, run_source(source, &options, &cache));
+        }
+    }
+    TEST_ASSERT_EQUAL_size_t(200, cache.count);
+    TEST_ASSERT_EQUAL_size_t(200, cache.hits);
+    TEST_ASSERT_EQUAL_size_t(200, cache.misses);
+    TEST_ASSERT_TRUE(cache.capacity * 3 >= cache.count * 4);
+    code_cache_destroy(&cache);
+}
+
+static void test_run_rejects_what_it_cannot_run(void) {
+    CompileOptions options;
+    compile_options_init(&options);
+    int result = -1;
+    const char *no_main = "int helper(void) { return 1; }";
+    TEST_ASSERT_FALSE(compile_and_run(no_main, strlen(no_main), &options, NULL, &result));
+    const char *invalid = "int main(void) { return x; }";
+    TEST_ASSERT_FALSE(compile_and_run(invalid, strlen(invalid), &options, NULL, &result));
+    const char *source = "int main(void) { return 1; }";
+    options.tac_only = true;
+    TEST_ASSERT_FALSE(compile_and_run(source, strlen(source), &options, NULL, &result));
+    TEST_ASSERT_EQUAL_INT(-1, result);
+}
+
+// --- Test Runner ---
+
+void run_jit_tests(void) {
+    RUN_TEST(test_run_returns_main_result);
+    RUN_TEST(test_run_optimized_variables);
+    RUN_TEST(test_cache_compiles_each_source_once);
+    RUN_TEST(test_cache_grows);
+    RUN_TEST(test_run_rejects_what_it_cannot_run);
+}
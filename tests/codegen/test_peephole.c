@@ -0,0 +1,109 @@
+#include "../_unity/unity.h"
+#include "../../src/codegen/peephole.h"
+#include "../../src/codegen/machine.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/memory/arena.h"
+#include "../../src/strings/strings.h"
+#include <string.h>
+
+#define EAX machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_LONG)
+#define ESI machine_reg(MACHINE_REG_SI, MACHINE_WIDTH_LONG)
+#define R10D machine_reg(MACHINE_REG_R10, MACHINE_WIDTH_LONG)
+#define AL machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE)
+#define NONE machine_none()
+
+// Runs the pass and returns the printed result
+static const char *optimize_and_print(MachineFunction *mf, PeepholeStats *stats, Arena *arena) {
+    peephole_optimize(mf, stats);
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 256);
+    machine_print_function(&sb, mf);
+    return string_buffer_content_str(&sb);
+}
+
+// --- Test Cases ---
+
+static void test_peephole_store_load_and_relay(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    machine_emit(&mf, MACHINE_OP_MOVL, EAX, machine_stack(-8));
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX);  // Dropped
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), ESI);  // Reads %eax instead
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(4), R10D);
+    machine_emit(&mf, MACHINE_OP_MOVL, R10D, machine_stack(-16)); // Direct: movl $4, -16(%rbp)
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), R10D);
+    machine_emit(&mf, MACHINE_OP_MOVL, R10D, machine_stack(-24)); // Memory to memory: kept
+
+    PeepholeStats stats = {0};
+    const char *expected =
+            "    movl %eax, -8(%rbp)\n"
+            "    movl %eax, %esi\n"
+            "    movl $4, -16(%rbp)\n"
+            "    movl -8(%rbp), %r10d\n"
+            "    movl %r10d, -24(%rbp)\n";
+    TEST_ASSERT_EQUAL_STRING(expected, optimize_and_print(&mf, &stats, &arena));
+    TEST_ASSERT_TRUE(stats.ran);
+    TEST_ASSERT_EQUAL(2, stats.hits[PEEPHOLE_RULE_STORE_LOAD]);
+    TEST_ASSERT_EQUAL(1, stats.hits[PEEPHOLE_RULE_SCRATCH_RELAY]);
+    arena_destroy(&arena);
+}
+
+static void test_peephole_zero_idiom_and_jump_to_next(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    machine_emit(&mf, MACHINE_OP_CMPL, machine_imm(1), ESI);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(0), EAX); // Flags read by sete below: kept
+    machine_emit_cond(&mf, MACHINE_OP_SETCC, MACHINE_COND_E, AL);
+    machine_emit(&mf, MACHINE_OP_JMP, machine_label("L0"), NONE);
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_label("L0"), NONE);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(0), EAX);
+    machine_emit(&mf, MACHINE_OP_RETQ, NONE, NONE);
+
+    PeepholeStats stats = {0};
+    const char *expected =
+            "    cmpl $1, %esi\n"
+            "    movl $0, %eax\n"
+            "    sete %al\n"
+            "L0:\n"
+            "    xorl %eax, %eax\n"
+            "    retq\n";
+    TEST_ASSERT_EQUAL_STRING(expected, optimize_and_print(&mf, &stats, &arena));
+    TEST_ASSERT_EQUAL(1, stats.hits[PEEPHOLE_RULE_ZERO_IDIOM]);
+    TEST_ASSERT_EQUAL(1, stats.hits[PEEPHOLE_RULE_JUMP_TO_NEXT]);
+    TEST_ASSERT_EQUAL_STRING("zero-idiom", peephole_rule_name(PEEPHOLE_RULE_ZERO_IDIOM));
+    arena_destroy(&arena);
+}
+
+// -O1 runs the pass and reports it; --no-peephole turns it off
+static void test_compile_no_peephole(void) {
+    Arena arena = arena_create(1024 * 16);
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = 1;
+    CompileStats stats;
+    const char *source = "int main(void) { return 0 || 0; }";
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &arena, &stats));
+    TEST_ASSERT_TRUE(stats.peephole.ran);
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&sb), "    xorl "));
+
+    options.no_peephole = true;
+    string_buffer_reset(&sb);
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &arena, &stats));
+    TEST_ASSERT_FALSE(stats.peephole.ran);
+    TEST_ASSERT_NULL(strstr(string_buffer_content_str(&sb), "xorl"));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_peephole_tests(void) {
+    RUN_TEST(test_peephole_store_load_and_relay);
+    RUN_TEST(test_peephole_zero_idiom_and_jump_to_next);
+    RUN_TEST(test_compile_no_peephole);
+}
@@ -0,0 +1,235 @@
+#include "../_unity/unity.h"
+#include "../../src/codegen/strength_reduction.h"
+#include "../../src/codegen/machine.h"
+#include "../../src/codegen/codegen.h"
+#include "../../src/codegen/jit.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+#include "../../src/strings/strings.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Dividends where sign handling and rounding go wrong first
+static const int edge_dividends[] = {
+    INT_MIN, INT_MIN + 1, INT_MIN + 2, -1000000007, -65537, -65536, -1001, -1000, -999, -101, -100, -17, -16, -15,
+    -11, -10, -9, -8, -7, -6, -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 15, 16, 17, 99, 100, 101,
+    999, 1000, 1001, 65535, 65536, 1000000007, INT_MAX - 2, INT_MAX - 1, INT_MAX,
+};
+
+static const int divisors[] = {
+    2, 3, 5, 6, 7, 9, 10, 11, 12, 13, 25, 100, 125, 641, 1000, 7919, 12345, 65537, 1000000007, INT_MAX,
+    -2, -3, -5, -7, -10, -100, -641, -9999, -65537, -INT_MAX, INT_MIN,
+};
+
+#define COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+// What the emitted magic sequence computes, step by step (two's complement wrap like the hardware)
+static int magic_quotient(const int x, const int divisor) {
+    DivisionMagic magic;
+    TEST_ASSERT_TRUE(signed_division_magic(divisor, &magic));
+    uint32_t high = (uint32_t) (((int64_t) magic.multiplier * x) >> 32); // imull: %edx
+    if (divisor > 0 && magic.multiplier < 0) {
+        high += (uint32_t) x;
+    } else if (divisor < 0 && magic.multiplier > 0) {
+        high -= (uint32_t) x;
+    }
+    int q = (int) high >> magic.shift; // sarl (arithmetic on every supported compiler)
+    q = (int) ((uint32_t) q + ((uint32_t) q >> 31));
+    return q;
+}
+
+// Generates `t0 = x; t1 = t0 <op> constant; return t1` with strength reduction on and runs it. The TAC is
+// built by hand, so no optimizer folds the known dividend away: the code runs on x like on any value.
+static int run_operation(const TacInstructionType op, const int x, const int constant, const bool registers,
+                         Arena *arena) {
+    const ArenaMark mark = arena_mark(arena);
+    TacProgram *program = create_tac_program(arena);
+    TacFunction *func = create_tac_function("main", arena);
+    add_function_to_program(program, func, arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand c = create_tac_operand_const(constant);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(x), arena), arena);
+    const TacInstruction *instr = op == TAC_INS_DIV   ? create_tac_instruction_div(t1, t0, c, arena)
+                                  : op == TAC_INS_MOD ? create_tac_instruction_mod(t1, t0, c, arena)
+                                                      : create_tac_instruction_mul(t1, t0, c, arena);
+    add_instruction_to_function(func, instr, arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t1, arena), arena);
+
+    CodegenOptions options;
+    codegen_options_init(&options);
+    options.reduce_strength = true;
+    options.allocate_registers = registers; // The dividend in a register rather than a stack slot
+    ObjectWriter object;
+    object_writer_init(&object, arena);
+    JitCode code;
+    TEST_ASSERT_TRUE(codegen_generate_program_to_object(program, &object, &options));
+    TEST_ASSERT_TRUE(jit_load(&object, "main", &code));
+    const int result = code.entry();
+    jit_release(&code);
+    arena_release(arena, mark);
+    return result;
+}
+
+static const char *print(const MachineFunction *mf, Arena *arena) {
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 512);
+    machine_print_function(&sb, mf);
+    return string_buffer_content_str(&sb);
+}
+
+// --- Test Cases ---
+
+// Reference values from Hacker's Delight, table 10-1
+static void test_division_magic_numbers(void) {
+    DivisionMagic magic;
+    TEST_ASSERT_TRUE(signed_division_magic(3, &magic));
+    TEST_ASSERT_EQUAL_HEX32(0x55555556, magic.multiplier);
+    TEST_ASSERT_EQUAL(0, magic.shift);
+    TEST_ASSERT_TRUE(signed_division_magic(7, &magic));
+    TEST_ASSERT_EQUAL_HEX32(0x92492493, magic.multiplier);
+    TEST_ASSERT_EQUAL(2, magic.shift);
+    TEST_ASSERT_TRUE(signed_division_magic(10, &magic));
+    TEST_ASSERT_EQUAL_HEX32(0x66666667, magic.multiplier);
+    TEST_ASSERT_EQUAL(2, magic.shift);
+    TEST_ASSERT_TRUE(signed_division_magic(-5, &magic));
+    TEST_ASSERT_EQUAL_HEX32(0x99999999, magic.multiplier);
+    TEST_ASSERT_EQUAL(1, magic.shift);
+    TEST_ASSERT_TRUE(signed_division_magic(-7, &magic));
+    TEST_ASSERT_EQUAL_HEX32(0x6DB6DB6D, magic.multiplier);
+    TEST_ASSERT_EQUAL(2, magic.shift);
+    TEST_ASSERT_FALSE(signed_division_magic(0, &magic));
+    TEST_ASSERT_FALSE(signed_division_magic(1, &magic));
+    TEST_ASSERT_FALSE(signed_division_magic(-1, &magic));
+}
+
+// The magic sequence matches the compiler's own truncating / and % on the int32 edge cases
+static void test_division_magic_matches_c_division(void) {
+    for (size_t d = 0; d < COUNT(divisors); ++d) {
+        for (size_t x = 0; x < COUNT(edge_dividends); ++x) {
+            const int dividend = edge_dividends[x];
+            const int divisor = divisors[d];
+            const int q = magic_quotient(dividend, divisor);
+            TEST_ASSERT_EQUAL_INT(dividend / divisor, q);
+            TEST_ASSERT_EQUAL_INT(dividend % divisor, (int) ((uint32_t) dividend - (uint32_t) q * (uint32_t) divisor));
+        }
+    }
+}
+
+// The emitted / % and * code, run, matches the host compiler's operators on the int32 edge cases
+static void test_strength_reduced_code_matches_c_operators(void) {
+    if (!jit_supported()) {
+        TEST_IGNORE_MESSAGE("Running generated code needs an x86-64 POSIX host");
+    }
+    Arena arena = arena_create(64 * 1024);
+    char message[96];
+    for (size_t d = 0; d < COUNT(divisors); ++d) {
+        const int divisor = divisors[d];
+        // The table, then the dividends around ±divisor that still fit an int
+        int dividends[COUNT(edge_dividends) + 6];
+        size_t count = 0;
+        for (size_t x = 0; x < COUNT(edge_dividends); ++x) {
+            dividends[count++] = edge_dividends[x];
+        }
+        for (int sign = -1; sign <= 1; sign += 2) {
+            for (int offset = -1; offset <= 1; ++offset) {
+                const int64_t near = (int64_t) sign * divisor + offset;
+                if (near >= INT_MIN && near <= INT_MAX) {
+                    dividends[count++] = (int) near;
+                }
+            }
+        }
+        for (size_t x = 0; x < count; ++x) {
+            const int dividend = dividends[x];
+            snprintf(message, sizeof(message), "x = %d, constant = %d", dividend, divisor);
+            for (int registers = 0; registers < 2; ++registers) {
+                TEST_ASSERT_EQUAL_INT_MESSAGE(dividend / divisor,
+                                              run_operation(TAC_INS_DIV, dividend, divisor, registers, &arena),
+                                              message);
+                TEST_ASSERT_EQUAL_INT_MESSAGE(dividend % divisor,
+                                              run_operation(TAC_INS_MOD, dividend, divisor, registers, &arena),
+                                              message);
+                TEST_ASSERT_EQUAL_INT_MESSAGE((int) ((uint32_t) dividend * (uint32_t) divisor),
+                                              run_operation(TAC_INS_MUL, dividend, divisor, registers, &arena),
+                                              message);
+            }
+        }
+    }
+    arena_destroy(&arena);
+}
+
+static void test_power_of_two_sequences(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    const MachineOperand x = machine_stack(-8);
+    const MachineOperand dst = machine_reg(MACHINE_REG_SI, MACHINE_WIDTH_LONG);
+
+    TEST_ASSERT_TRUE(emit_divide_by_constant(&mf, x, 8, false, dst));
+    TEST_ASSERT_EQUAL_STRING("    movl -8(%rbp), %eax\n"
+                             "    movl %eax, %edx\n"
+                             "    sarl $31, %edx\n"
+                             "    shrl $29, %edx\n" // 7 for negative x, else 0
+                             "    addl %edx, %eax\n"
+                             "    sarl $3, %eax\n"
+                             "    movl %eax, %esi\n", print(&mf, &arena));
+
+    machine_function_reset(&mf, "main");
+    TEST_ASSERT_TRUE(emit_divide_by_constant(&mf, x, 16, true, dst));
+    TEST_ASSERT_EQUAL_STRING("    movl -8(%rbp), %eax\n"
+                             "    movl %eax, %edx\n"
+                             "    sarl $31, %edx\n"
+                             "    shrl $28, %edx\n"
+                             "    addl %edx, %eax\n"
+                             "    andl $15, %eax\n"
+                             "    subl %edx, %eax\n"
+                             "    movl %eax, %esi\n", print(&mf, &arena));
+
+    machine_function_reset(&mf, "main");
+    TEST_ASSERT_TRUE(emit_multiply_by_constant(&mf, x, -8, dst));
+    TEST_ASSERT_EQUAL_STRING("    movl -8(%rbp), %eax\n"
+                             "    shll $3, %eax\n"
+                             "    negl %eax\n"
+                             "    movl %eax, %esi\n", print(&mf, &arena));
+
+    // No cheaper form, or the division has to trap like idivl
+    machine_function_reset(&mf, "main");
+    TEST_ASSERT_FALSE(emit_multiply_by_constant(&mf, x, 10, dst));
+    TEST_ASSERT_FALSE(emit_divide_by_constant(&mf, x, 0, false, dst));
+    TEST_ASSERT_FALSE(emit_divide_by_constant(&mf, x, -1, true, dst));
+    TEST_ASSERT_EQUAL(0, mf.count);
+    arena_destroy(&arena);
+}
+
+static void test_magic_division_sequence(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    TEST_ASSERT_TRUE(emit_divide_by_constant(&mf, machine_stack(-8), 7, true, machine_stack(-16)));
+    TEST_ASSERT_EQUAL_STRING("    movl -8(%rbp), %ecx\n"
+                             "    movl $-1840700269, %eax\n" // 0x92492493
+                             "    imull %ecx\n"
+                             "    addl %ecx, %edx\n"         // The multiplier went negative
+                             "    sarl $2, %edx\n"
+                             "    movl %edx, %eax\n"
+                             "    shrl $31, %eax\n"
+                             "    addl %eax, %edx\n"
+                             "    imull $7, %edx\n"
+                             "    movl %ecx, %eax\n"
+                             "    subl %edx, %eax\n"
+                             "    movl %eax, -16(%rbp)\n", print(&mf, &arena));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_strength_reduction_tests(void) {
+    RUN_TEST(test_division_magic_numbers);
+    RUN_TEST(test_division_magic_matches_c_division);
+    RUN_TEST(test_strength_reduced_code_matches_c_operators);
+    RUN_TEST(test_power_of_two_sequences);
+    RUN_TEST(test_magic_division_sequence);
+}
@@ -0,0 +1,92 @@
+#include "../_unity/unity.h"
+#include "../../src/codegen/value_cache.h"
+#include "../../src/codegen/machine.h"
+#include "../../src/memory/arena.h"
+#include "../../src/strings/strings.h"
+
+#define EAX machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_LONG)
+#define ECX machine_reg(MACHINE_REG_CX, MACHINE_WIDTH_LONG)
+#define EDX machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_LONG)
+#define ESI machine_reg(MACHINE_REG_SI, MACHINE_WIDTH_LONG)
+#define R10D machine_reg(MACHINE_REG_R10, MACHINE_WIDTH_LONG)
+#define AL machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE)
+#define NONE machine_none()
+
+// Runs the pass and returns the printed result
+static const char *cache_and_print(MachineFunction *mf, size_t *changes, Arena *arena) {
+    *changes = cache_register_values(mf, arena);
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 256);
+    machine_print_function(&sb, mf);
+    return string_buffer_content_str(&sb);
+}
+
+// --- Test Cases ---
+
+static void test_value_cache_drops_reloads(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    machine_emit(&mf, MACHINE_OP_MOVL, EAX, machine_stack(-8));
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(3), R10D);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EDX); // Reads %eax instead
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX); // Already there: dropped
+    machine_emit(&mf, MACHINE_OP_MOVL, EAX, ESI);
+    machine_emit(&mf, MACHINE_OP_MOVL, ESI, EAX);               // Relay back: dropped
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(3), R10D);   // Same constant: dropped
+    machine_emit(&mf, MACHINE_OP_ADDL, machine_imm(1), EAX);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX); // %eax changed: reads %edx
+    machine_emit(&mf, MACHINE_OP_CLTD, NONE, NONE);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), ECX); // %edx was overwritten: reads %eax
+    machine_emit(&mf, MACHINE_OP_MOVL, EAX, machine_stack(-8)); // Slot holds it already: dropped
+
+    size_t changes = 0;
+    const char *expected =
+            "    movl %eax, -8(%rbp)\n"
+            "    movl $3, %r10d\n"
+            "    movl %eax, %edx\n"
+            "    movl %eax, %esi\n"
+            "    addl $1, %eax\n"
+            "    movl %edx, %eax\n"
+            "    cltd\n"
+            "    movl %eax, %ecx\n";
+    TEST_ASSERT_EQUAL_STRING(expected, cache_and_print(&mf, &changes, &arena));
+    TEST_ASSERT_EQUAL(7, changes);
+    arena_destroy(&arena);
+}
+
+static void test_value_cache_forgets_at_labels_and_writes(void) {
+    Arena arena = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "main");
+    machine_emit(&mf, MACHINE_OP_MOVL, EAX, machine_stack(-8));
+    machine_emit(&mf, MACHINE_OP_CMPL, machine_imm(0), ESI);
+    machine_emit_cond(&mf, MACHINE_OP_JCC, MACHINE_COND_E, machine_local_label(1));
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX); // Fall-through keeps the block: dropped
+    machine_emit_cond(&mf, MACHINE_OP_SETCC, MACHINE_COND_E, AL);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX); // sete wrote %al: kept
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(1), NONE);
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), EAX); // Another way in: kept
+
+    size_t changes = 0;
+    const char *expected =
+            "    movl %eax, -8(%rbp)\n"
+            "    cmpl $0, %esi\n"
+            "    je L1\n"
+            "    sete %al\n"
+            "    movl -8(%rbp), %eax\n"
+            "L1:\n"
+            "    movl -8(%rbp), %eax\n";
+    TEST_ASSERT_EQUAL_STRING(expected, cache_and_print(&mf, &changes, &arena));
+    TEST_ASSERT_EQUAL(1, changes);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_value_cache_tests(void) {
+    RUN_TEST(test_value_cache_drops_reloads);
+    RUN_TEST(test_value_cache_forgets_at_labels_and_writes);
+}
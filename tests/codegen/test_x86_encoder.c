@@ -0,0 +1,281 @@
+#include "../_unity/unity.h"
+#include "../../src/codegen/x86_encoder.h"
+#include "../../src/codegen/object_writer.h"
+#include "../../src/codegen/machine.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/files/files.h"
+#include "../../src/memory/arena.h"
+#include "../../src/strings/strings.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#define NONE machine_none()
+
+// --- Helpers ---
+
+// Little-endian fields of an ELF image
+static uint64_t read_le(const uint8_t *at, const int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = value << 8 | at[i];
+    }
+    return value;
+}
+
+// Finds a section of a relocatable ELF64 image by name; *out_size receives its size
+static const uint8_t *elf_section(const uint8_t *image, const char *name, size_t *out_size) {
+    TEST_ASSERT_EQUAL_MEMORY("\x7f" "ELF", image, 4);
+    const uint64_t section_headers = read_le(image + 40, 8);
+    const uint64_t section_count = read_le(image + 60, 2);
+    const uint8_t *names_header = image + section_headers + read_le(image + 62, 2) * 64;
+    const char *names = (const char *) image + read_le(names_header + 24, 8);
+    for (uint64_t i = 0; i < section_count; ++i) {
+        const uint8_t *header = image + section_headers + i * 64;
+        if (strcmp(names + read_le(header, 4), name) == 0) {
+            *out_size = (size_t) read_le(header + 32, 8);
+            return image + read_le(header + 24, 8);
+        }
+    }
+    TEST_FAIL_MESSAGE(name);
+    return NULL;
+}
+
+// Encodes a single instruction and checks its bytes
+static void assert_encoding(const MachineInstruction instr, const char *expected, const size_t expected_length) {
+    Arena arena = arena_create(8192);
+    Arena scratch = arena_create(8192);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "f");
+    machine_append(&mf, &instr);
+    ObjectWriter object;
+    object_writer_init(&object, &arena);
+    TEST_ASSERT_TRUE(x86_encode_function(&mf, &object, &scratch));
+
+    StringBuffer printed;
+    string_buffer_init(&printed, &arena, 64);
+    machine_print_instruction(&printed, &instr);
+    TEST_ASSERT_EQUAL_MESSAGE(expected_length, object.text_size, string_buffer_content_str(&printed));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, object.text, expected_length, string_buffer_content_str(&printed));
+    arena_destroy(&scratch);
+    arena_destroy(&arena);
+}
+
+static MachineInstruction make(const MachineOpcode opcode, const MachineOperand first, const MachineOperand second) {
+    const MachineInstruction instr = {opcode, MACHINE_COND_E, {first, second}};
+    return instr;
+}
+
+static MachineInstruction make_cond(const MachineOpcode opcode, const MachineCondition condition,
+                                    const MachineOperand operand) {
+    const MachineInstruction instr = {opcode, condition, {operand, NONE}};
+    return instr;
+}
+
+static MachineOperand reg32(const MachineRegister reg) {
+    return machine_reg(reg, MACHINE_WIDTH_LONG);
+}
+
+// Compiles `source` to an ELF image (emit_obj) or to assembly text
+static const StringBuffer *compile_source(const char *source, const int level, const bool emit_obj, Arena *arena) {
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = level;
+    options.emit_obj = emit_obj;
+    options.fuse_validation = true; // Lowers the variables too
+    StringBuffer *sb = arena_alloc(arena, sizeof(StringBuffer));
+    string_buffer_init(sb, arena, 4096);
+    TEST_ASSERT_TRUE_MESSAGE(compile_with_options(source, &options, sb, arena, NULL), source);
+    return sb;
+}
+
+#define ROUND_TRIP_SOURCE_COUNT 4
+
+// Sources exercising every emitter; the last one needs rel32 jumps
+static const char *round_trip_source(const int i, Arena *arena) {
+    static const char *const sources[ROUND_TRIP_SOURCE_COUNT - 1] = {
+        "int main(void) { return (1 + 2 * -3 % 4) / 2 - ~5; }",
+        "int main(void) { int a = 5; int b = a * 3; { int c = b - a; a = c / 2 + (a < b) + (a >= c); }"
+        " return a % 7 == 1 || !(b != 15); }",
+        "int main(void) { int a = 37; int b = a / 8 + a % 4 + a / 7 + a * 12 - a / -5; return b - a * -1 + (b && a); }",
+    };
+    if (i < ROUND_TRIP_SOURCE_COUNT - 1) {
+        return sources[i];
+    }
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 2048);
+    string_buffer_append_str(&sb, "int main(void) { int x = 3; int y = 0; return x > 1 && (y");
+    for (int k = 0; k < 40; ++k) {
+        string_buffer_append(&sb, " + x * %d - y / %d", k + 2, k + 3);
+    }
+    string_buffer_append_str(&sb, ") || y; }");
+    return string_buffer_content_str(&sb);
+}
+
+// --- Test Cases ---
+
+// The encodings the assembler picks for the same AT&T instructions
+static void test_encode_instruction_forms(void) {
+    const MachineOperand rbp_8 = machine_stack(-8);
+    assert_encoding(make(MACHINE_OP_MOVL, machine_imm(5), reg32(MACHINE_REG_AX)), "\xb8\x05\x00\x00\x00", 5);
+    assert_encoding(make(MACHINE_OP_MOVL, machine_imm(-1), rbp_8), "\xc7\x45\xf8\xff\xff\xff\xff", 7);
+    assert_encoding(make(MACHINE_OP_MOVL, reg32(MACHINE_REG_AX), rbp_8), "\x89\x45\xf8", 3);
+    assert_encoding(make(MACHINE_OP_MOVL, machine_stack(-200), reg32(MACHINE_REG_R10)), "\x44\x8b\x95\x38\xff\xff\xff",
+                    7);
+    assert_encoding(make(MACHINE_OP_MOVL, reg32(MACHINE_REG_R12), reg32(MACHINE_REG_SI)), "\x44\x89\xe6", 3);
+    assert_encoding(make(MACHINE_OP_ADDL, machine_imm(1000), reg32(MACHINE_REG_AX)), "\x05\xe8\x03\x00\x00", 5);
+    assert_encoding(make(MACHINE_OP_ADDL, machine_imm(1000), reg32(MACHINE_REG_BX)), "\x81\xc3\xe8\x03\x00\x00", 6);
+    assert_encoding(make(MACHINE_OP_SUBL, rbp_8, reg32(MACHINE_REG_AX)), "\x2b\x45\xf8", 3);
+    assert_encoding(make(MACHINE_OP_CMPL, machine_imm(0), reg32(MACHINE_REG_SI)), "\x83\xfe\x00", 3);
+    assert_encoding(make(MACHINE_OP_SUBQ, machine_imm(32), machine_reg(MACHINE_REG_SP, MACHINE_WIDTH_QUAD)),
+                    "\x48\x83\xec\x20", 4);
+    assert_encoding(make(MACHINE_OP_MOVQ, machine_reg(MACHINE_REG_BX, MACHINE_WIDTH_QUAD), machine_stack(-16)),
+                    "\x48\x89\x5d\xf0", 4);
+    assert_encoding(make(MACHINE_OP_PUSHQ, machine_reg(MACHINE_REG_BP, MACHINE_WIDTH_QUAD), NONE), "\x55", 1);
+    assert_encoding(make(MACHINE_OP_IMULL, machine_imm(10), reg32(MACHINE_REG_DX)), "\x6b\xd2\x0a", 3);
+    assert_encoding(make(MACHINE_OP_IMULL, rbp_8, reg32(MACHINE_REG_AX)), "\x0f\xaf\x45\xf8", 4);
+    assert_encoding(make(MACHINE_OP_IDIVL, reg32(MACHINE_REG_CX), NONE), "\xf7\xf9", 2);
+    assert_encoding(make(MACHINE_OP_INCL, rbp_8, NONE), "\xff\x45\xf8", 3);
+    assert_encoding(make(MACHINE_OP_SHLL, machine_imm(1), reg32(MACHINE_REG_AX)), "\xd1\xe0", 2);
+    assert_encoding(make(MACHINE_OP_SARL, machine_imm(31), reg32(MACHINE_REG_DX)), "\xc1\xfa\x1f", 3);
+    assert_encoding(make(MACHINE_OP_LEAL, machine_address(MACHINE_REG_R12, 5), reg32(MACHINE_REG_CX)),
+                    "\x41\x8d\x4c\x24\x05", 5);
+    assert_encoding(make(MACHINE_OP_LEAL, machine_address(MACHINE_REG_SI, -1), reg32(MACHINE_REG_AX)), "\x8d\x46\xff",
+                    3);
+    assert_encoding(make_cond(MACHINE_OP_SETCC, MACHINE_COND_L, machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE)),
+                    "\x0f\x9c\xc0", 3);
+    // %sil needs a REX prefix, or the same ModRM byte would mean %dh
+    assert_encoding(make_cond(MACHINE_OP_SETCC, MACHINE_COND_E, machine_reg(MACHINE_REG_SI, MACHINE_WIDTH_BYTE)),
+                    "\x40\x0f\x94\xc6", 4);
+    assert_encoding(make(MACHINE_OP_MOVZBL, machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE), reg32(MACHINE_REG_AX)),
+                    "\x0f\xb6\xc0", 3);
+    assert_encoding(make(MACHINE_OP_ANDB, machine_reg(MACHINE_REG_DX, MACHINE_WIDTH_BYTE),
+                         machine_reg(MACHINE_REG_AX, MACHINE_WIDTH_BYTE)), "\x20\xd0", 2);
+    assert_encoding(make(MACHINE_OP_LEAVE, NONE, NONE), "\xc9", 1);
+}
+
+// Jumps stay rel8 while their target is in reach and grow to rel32 otherwise
+static void test_encode_relaxes_jumps(void) {
+    Arena arena = arena_create(16384);
+    Arena scratch = arena_create(4096);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    machine_function_reset(&mf, "f");
+    machine_emit(&mf, MACHINE_OP_FUNCTION_LABEL, machine_label("f"), NONE);
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(3), NONE);
+    machine_emit_cond(&mf, MACHINE_OP_JCC, MACHINE_COND_NE, machine_local_label(4)); // 7 * 20 bytes ahead
+    for (int i = 0; i < 20; ++i) {
+        machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(i), machine_stack(-8)); // 7 bytes each
+    }
+    machine_emit(&mf, MACHINE_OP_JMP, machine_local_label(3), NONE); // Back to the start
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(4), NONE);
+    machine_emit(&mf, MACHINE_OP_RETQ, NONE, NONE);
+
+    ObjectWriter object;
+    object_writer_init(&object, &arena);
+    TEST_ASSERT_TRUE(x86_encode_function(&mf, &object, &scratch));
+    TEST_ASSERT_EQUAL(6 + 140 + 5 + 1, object.text_size);
+    TEST_ASSERT_EQUAL_MEMORY("\x0f\x85\x91\x00\x00\x00", object.text, 6); // jne +145
+    TEST_ASSERT_EQUAL_MEMORY("\xe9\x69\xff\xff\xff", object.text + 146, 5); // jmp -151
+    TEST_ASSERT_EQUAL_UINT8(0xc3, object.text[151]);
+    TEST_ASSERT_EQUAL(1, object.symbol_count);
+    TEST_ASSERT_EQUAL_STRING("f", object.symbols[0].name);
+    TEST_ASSERT_EQUAL(152, object.symbols[0].size);
+
+    // Out of 20 only one movl: both jumps fit in a byte
+    machine_function_reset(&mf, "g");
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(3), NONE);
+    machine_emit_cond(&mf, MACHINE_OP_JCC, MACHINE_COND_NE, machine_local_label(4));
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_imm(0), machine_stack(-8));
+    machine_emit(&mf, MACHINE_OP_JMP, machine_local_label(3), NONE);
+    machine_emit(&mf, MACHINE_OP_LABEL, machine_local_label(4), NONE);
+    object_writer_init(&object, &arena);
+    TEST_ASSERT_TRUE(x86_encode_function(&mf, &object, &scratch));
+    TEST_ASSERT_EQUAL(2 + 7 + 2, object.text_size);
+    TEST_ASSERT_EQUAL_MEMORY("\x75\x09", object.text, 2);
+    TEST_ASSERT_EQUAL_MEMORY("\xeb\xf5", object.text + 9, 2);
+    arena_destroy(&scratch);
+    arena_destroy(&arena);
+}
+
+// No encoding for an operand combination the lowering never produces, and no jump out of the function
+static void test_encode_rejects_unencodable(void) {
+    Arena arena = arena_create(8192);
+    Arena scratch = arena_create(4096);
+    MachineFunction mf;
+    machine_function_init(&mf, &arena);
+    ObjectWriter object;
+    object_writer_init(&object, &arena);
+
+    machine_function_reset(&mf, "f");
+    machine_emit(&mf, MACHINE_OP_MOVL, machine_stack(-8), machine_stack(-16)); // Memory to memory
+    TEST_ASSERT_FALSE(x86_encode_function(&mf, &object, &scratch));
+
+    machine_function_reset(&mf, "f");
+    machine_emit(&mf, MACHINE_OP_JMP, machine_local_label(9), NONE);
+    TEST_ASSERT_FALSE(x86_encode_function(&mf, &object, &scratch));
+    TEST_ASSERT_EQUAL(0, object.text_size);
+    arena_destroy(&scratch);
+    arena_destroy(&arena);
+}
+
+// -O0 and -O1: the encoded .text equals what the assembler makes of the --codegen text
+static void test_emit_obj_matches_assembler(void) {
+    for (int i = 0; i < ROUND_TRIP_SOURCE_COUNT; ++i) {
+        for (int level = 0; level <= 1; ++level) {
+            Arena arena = arena_create(1024 * 64);
+            const char *source = round_trip_source(i, &arena);
+            const StringBuffer *assembly = compile_source(source, level, false, &arena);
+            const StringBuffer *object = compile_source(source, level, true, &arena);
+            TEST_ASSERT_TRUE(write_string_buffer_to_file("test_encoder.s", assembly));
+            TEST_ASSERT_EQUAL_INT(0, system("gcc -c test_encoder.s -o test_encoder.o"));
+
+            long assembled_size = 0;
+            char *assembled = read_entire_file("test_encoder.o", &assembled_size);
+            TEST_ASSERT_NOT_NULL(assembled);
+            size_t expected_size, actual_size;
+            const uint8_t *expected = elf_section((const uint8_t *) assembled, ".text", &expected_size);
+            const uint8_t *actual = elf_section((const uint8_t *) string_buffer_content_str(object), ".text",
+                                                &actual_size);
+            TEST_ASSERT_EQUAL_MESSAGE(expected_size, actual_size, source);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, expected_size, source);
+            free(assembled);
+            arena_destroy(&arena);
+        }
+    }
+    remove("test_encoder.s");
+    remove("test_encoder.o");
+}
+
+// The object links on its own and the program computes the same result
+static void test_emit_obj_links_and_runs(void) {
+    Arena arena = arena_create(1024 * 64);
+    const StringBuffer *object = compile_source("int main(void) { int a = 6; a = a * 7; return a - (a > 40); }", 1,
+                                                true, &arena);
+    size_t strtab_size;
+    const char *strtab = (const char *) elf_section((const uint8_t *) string_buffer_content_str(object), ".strtab",
+                                                    &strtab_size);
+    TEST_ASSERT_EQUAL_STRING("_main", strtab + 1);
+
+    TEST_ASSERT_TRUE(write_string_buffer_to_file("test_encoder_run.o", object));
+    TEST_ASSERT_EQUAL_INT(0, system("gcc test_encoder_run.o -o test_encoder_run -Wl,--defsym,main=_main"));
+    const int status = system("./test_encoder_run");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(41, WEXITSTATUS(status));
+    remove("test_encoder_run.o");
+    remove("test_encoder_run");
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_x86_encoder_tests(void) {
+    RUN_TEST(test_encode_instruction_forms);
+    RUN_TEST(test_encode_relaxes_jumps);
+    RUN_TEST(test_encode_rejects_unencodable);
+    RUN_TEST(test_emit_obj_matches_assembler);
+    RUN_TEST(test_emit_obj_links_and_runs);
+}
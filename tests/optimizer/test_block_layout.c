@@ -0,0 +1,99 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/block_layout.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static TacOperand l(const uint32_t id) {
+    return create_tac_operand_label(id);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+static void assert_label(const TacInstruction *instr, const uint32_t id) {
+    TEST_ASSERT_EQUAL(TAC_INS_LABEL, instr->type);
+    TEST_ASSERT_EQUAL_UINT32(id, tac_label(instr).value.label_id);
+}
+
+// --- Test Cases ---
+
+// if_false t0 goto L0; goto L1; L0: ... becomes if_true t0 goto L1; L0: ...
+static void test_lay_out_inverts_jump_over_goto(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), l(0), &arena), &arena);
+    add(func, create_tac_instruction_goto(l(1), &arena), &arena);
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(1), c(1), &arena), &arena); // Falls into L1, which stays put
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+
+    TEST_ASSERT_TRUE(lay_out_blocks(func, &arena));
+    TEST_ASSERT_EQUAL(5, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_IF_TRUE_GOTO, func->instructions[0].type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(&func->instructions[0]).value.label_id);
+    assert_label(&func->instructions[1], 0);
+    TEST_ASSERT_FALSE(lay_out_blocks(func, &arena));
+    arena_destroy(&arena);
+}
+
+// The block only the GOTO enters moves up behind it, and the GOTO goes
+static void test_lay_out_moves_goto_target_after_goto(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), l(0), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(1), c(1), &arena), &arena);
+    add(func, create_tac_instruction_goto(l(1), &arena), &arena);
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_return(c(0), &arena), &arena);
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_add(t(2), t(1), c(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(lay_out_blocks(func, &arena));
+    TEST_ASSERT_EQUAL(7, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_IF_FALSE_GOTO, func->instructions[0].type);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[1].type);
+    assert_label(&func->instructions[2], 1);
+    TEST_ASSERT_EQUAL(TAC_INS_ADD, func->instructions[3].type);
+    TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[4].type);
+    assert_label(&func->instructions[5], 0);
+    TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[6].type);
+    arena_destroy(&arena);
+}
+
+// Jumps to the labels right after them go, however many there are in a row
+static void test_lay_out_drops_jumps_to_next(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), l(1), &arena), &arena);
+    add(func, create_tac_instruction_goto(l(1), &arena), &arena); // Both jumps lead to the next label
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+
+    TEST_ASSERT_TRUE(lay_out_blocks(func, &arena));
+    TEST_ASSERT_EQUAL(3, func->instruction_count);
+    assert_label(&func->instructions[0], 0);
+    assert_label(&func->instructions[1], 1);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_block_layout_tests(void) {
+    RUN_TEST(test_lay_out_inverts_jump_over_goto);
+    RUN_TEST(test_lay_out_moves_goto_target_after_goto);
+    RUN_TEST(test_lay_out_drops_jumps_to_next);
+}
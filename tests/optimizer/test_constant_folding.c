@@ -0,0 +1,177 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/constant_folding.h"
+#include "../../src/optimizer/optimizer.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+#include <limits.h>
+#include <string.h>
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+// Asserts that instruction i is `dst = src` with a constant source
+static void assert_copy_of_const(const TacFunction *func, const size_t i, const int dst, const int value) {
+    const TacInstruction *instr = &func->instructions[i];
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, instr->type);
+    TEST_ASSERT_EQUAL(dst, tac_dst(instr).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL(value, tac_src(instr).value.constant_value);
+}
+
+// --- Test Cases ---
+
+// 1 + 2 * 3: t1 = 2 * 3; t2 = 1 + t1; return t2 folds all the way into the return
+static void test_fold_nested_arithmetic(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_mul(t(1), c(2), c(3), &arena), &arena);
+    add(func, create_tac_instruction_add(t(2), c(1), t(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(fold_constants(func, &arena));
+    TEST_ASSERT_EQUAL(3, func->instruction_count);
+    assert_copy_of_const(func, 0, 1, 6);
+    assert_copy_of_const(func, 1, 2, 7);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_CONST, tac_src(&func->instructions[2]).type);
+    TEST_ASSERT_EQUAL(7, tac_src(&func->instructions[2]).value.constant_value);
+
+    // A second run has nothing left to do
+    TEST_ASSERT_FALSE(fold_constants(func, &arena));
+    arena_destroy(&arena);
+}
+
+// Unary operators, wrap-around and relational results
+static void test_fold_unary_relational_and_overflow(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_negate(t(0), c(INT_MIN), &arena), &arena);
+    add(func, create_tac_instruction_complement(t(1), c(5), &arena), &arena);
+    add(func, create_tac_instruction_logical_not(t(2), c(0), &arena), &arena);
+    add(func, create_tac_instruction_add(t(3), c(INT_MAX), c(1), &arena), &arena);
+    add(func, create_tac_instruction_less_equal(t(4), t(1), c(-6), &arena), &arena);
+    add(func, create_tac_instruction_mod(t(5), c(-7), c(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(fold_constants(func, &arena));
+    assert_copy_of_const(func, 0, 0, INT_MIN); // -INT_MIN wraps like negl does
+    assert_copy_of_const(func, 1, 1, -6);
+    assert_copy_of_const(func, 2, 2, 1);
+    assert_copy_of_const(func, 3, 3, INT_MIN);
+    assert_copy_of_const(func, 4, 4, 1); // ~5 <= -6
+    assert_copy_of_const(func, 5, 5, -1); // Truncating remainder, like idivl
+    arena_destroy(&arena);
+}
+
+// Identities on an unknown temp (t9 is never defined in the function)
+static void test_fold_algebraic_identities(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_mul(t(1), t(9), c(1), &arena), &arena);
+    add(func, create_tac_instruction_sub(t(2), t(9), c(0), &arena), &arena);
+    add(func, create_tac_instruction_mul(t(3), c(0), t(9), &arena), &arena);
+    add(func, create_tac_instruction_sub(t(4), t(9), t(9), &arena), &arena);
+    add(func, create_tac_instruction_equal(t(5), t(9), t(9), &arena), &arena);
+    add(func, create_tac_instruction_logical_and(t(6), t(9), c(0), &arena), &arena);
+    add(func, create_tac_instruction_logical_or(t(7), c(0), t(9), &arena), &arena);
+    add(func, create_tac_instruction_add(t(8), t(9), t(9), &arena), &arena);
+
+    TEST_ASSERT_TRUE(fold_constants(func, &arena));
+    const TacInstruction *instr = func->instructions;
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, instr[0].type); // x * 1 -> x
+    TEST_ASSERT_EQUAL(9, tac_src(&instr[0]).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, instr[1].type); // x - 0 -> x
+    TEST_ASSERT_EQUAL(9, tac_src(&instr[1]).value.temp_id);
+    assert_copy_of_const(func, 2, 3, 0); // 0 * x
+    assert_copy_of_const(func, 3, 4, 0); // x - x
+    assert_copy_of_const(func, 4, 5, 1); // x == x
+    assert_copy_of_const(func, 5, 6, 0); // x && 0
+    TEST_ASSERT_EQUAL(TAC_INS_NOT_EQUAL, instr[6].type); // 0 || x -> x != 0
+    TEST_ASSERT_EQUAL(9, tac_src1(&instr[6]).value.temp_id);
+    TEST_ASSERT_EQUAL(0, tac_src2(&instr[6]).value.constant_value);
+    TEST_ASSERT_EQUAL(TAC_INS_ADD, instr[7].type); // Nothing to simplify
+    arena_destroy(&arena);
+}
+
+// Division and remainder that would trap are kept so the program still traps
+static void test_fold_leaves_trapping_division(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_div(t(0), c(1), c(0), &arena), &arena);
+    add(func, create_tac_instruction_mod(t(1), c(INT_MIN), c(-1), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(2), c(0), &arena), &arena);
+    add(func, create_tac_instruction_div(t(3), c(8), t(2), &arena), &arena);
+
+    fold_constants(func, &arena);
+    TEST_ASSERT_EQUAL(TAC_INS_DIV, func->instructions[0].type);
+    TEST_ASSERT_EQUAL(TAC_INS_MOD, func->instructions[1].type);
+    TEST_ASSERT_EQUAL(TAC_INS_DIV, func->instructions[3].type);
+    TEST_ASSERT_EQUAL(0, tac_src2(&func->instructions[3]).value.constant_value); // Propagated
+    arena_destroy(&arena);
+}
+
+// Constant conditions become a GOTO or vanish; constants are not carried past a label
+static void test_fold_conditional_jumps_and_block_boundaries(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand label = create_tac_operand_label(0);
+    add(func, create_tac_instruction_copy(t(0), c(1), &arena), &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), label, &arena), &arena); // Never jumps: removed
+    add(func, create_tac_instruction_if_true_goto(t(0), label, &arena), &arena);  // Always jumps: goto
+    add(func, create_tac_instruction_label(label, &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+
+    TEST_ASSERT_TRUE(fold_constants(func, &arena));
+    TEST_ASSERT_EQUAL(4, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[0].type);
+    TEST_ASSERT_EQUAL(TAC_INS_GOTO, func->instructions[1].type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(&func->instructions[1]).value.label_id);
+    TEST_ASSERT_EQUAL(TAC_INS_LABEL, func->instructions[2].type);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_TEMP, tac_src(&func->instructions[3]).type); // Another path may join at L0
+    arena_destroy(&arena);
+}
+
+// -O1 folds the whole expression; -O0 leaves the program alone
+static void test_compile_o1_folds_constant_expression(void) {
+    Arena arena = arena_create(1024 * 16);
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = 1;
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { return (1 + 2 * 3) * 1 - 0 == 7 && !0; }", &options,
+                                          &sb, &arena, NULL));
+    const char *asm_text = string_buffer_content_str(&sb);
+    TEST_ASSERT_NOT_NULL(strstr(asm_text, "    movl $1, ")); // 7 == 7 && !0, the dead temps gone
+    TEST_ASSERT_NULL(strstr(asm_text, "    movl $7, "));
+    TEST_ASSERT_NULL(strstr(asm_text, "imull"));
+    TEST_ASSERT_NULL(strstr(asm_text, "cmpl"));
+    TEST_ASSERT_NULL(strstr(asm_text, "jz")); // The && is lowered without branches and folded away
+    TEST_ASSERT_NULL(strstr(asm_text, "jmp"));
+
+    OptimizerOptions none;
+    optimizer_options_for_level(&none, 0);
+    TEST_ASSERT_FALSE(none.fold_constants);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_constant_folding_tests(void) {
+    RUN_TEST(test_fold_nested_arithmetic);
+    RUN_TEST(test_fold_unary_relational_and_overflow);
+    RUN_TEST(test_fold_algebraic_identities);
+    RUN_TEST(test_fold_leaves_trapping_division);
+    RUN_TEST(test_fold_conditional_jumps_and_block_boundaries);
+    RUN_TEST(test_compile_o1_folds_constant_expression);
+}
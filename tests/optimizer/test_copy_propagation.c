@@ -0,0 +1,84 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/copy_propagation.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+// --- Test Cases ---
+
+// t1 = t0; t2 = t1; return t2 reads t0 all the way down
+static void test_propagate_copy_chain(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_negate(t(0), c(5), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(1), t(0), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(2), t(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(propagate_copies(func, &arena));
+    TEST_ASSERT_EQUAL(4, func->instruction_count); // The copies stay for dead-temp elimination
+    TEST_ASSERT_EQUAL(0, tac_src(&func->instructions[2]).value.temp_id);
+    TEST_ASSERT_EQUAL(0, tac_src(&func->instructions[3]).value.temp_id);
+    TEST_ASSERT_FALSE(propagate_copies(func, &arena));
+    arena_destroy(&arena);
+}
+
+// Redefining the source or the copy ends the copy; a self copy is dropped
+static void test_propagate_stops_at_redefinition(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_copy(t(1), t(0), &arena), &arena);
+    add(func, create_tac_instruction_negate(t(0), c(1), &arena), &arena); // t1 still holds the old t0
+    add(func, create_tac_instruction_add(t(2), t(1), t(0), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(3), t(2), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(2), t(3), &arena), &arena); // Becomes t2 = t2
+    add(func, create_tac_instruction_return(t(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(propagate_copies(func, &arena));
+    TEST_ASSERT_EQUAL(5, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_ADD, func->instructions[2].type);
+    TEST_ASSERT_EQUAL(1, tac_src1(&func->instructions[2]).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[3].type);
+    TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[4].type);
+    TEST_ASSERT_EQUAL(2, tac_src(&func->instructions[4]).value.temp_id);
+    arena_destroy(&arena);
+}
+
+// Copies survive a conditional fall-through but not a label another jump reaches
+static void test_propagate_follows_straight_line_blocks(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand label = create_tac_operand_label(0);
+    add(func, create_tac_instruction_copy(t(1), t(0), &arena), &arena);
+    add(func, create_tac_instruction_if_false_goto(t(1), label, &arena), &arena);
+    add(func, create_tac_instruction_return(t(1), &arena), &arena); // Only reached by falling through
+    add(func, create_tac_instruction_label(label, &arena), &arena);
+    add(func, create_tac_instruction_return(t(1), &arena), &arena); // Reached by the jump only, but past a label
+
+    TEST_ASSERT_TRUE(propagate_copies(func, &arena));
+    TEST_ASSERT_EQUAL(0, tac_src(&func->instructions[1]).value.temp_id);
+    TEST_ASSERT_EQUAL(0, tac_src(&func->instructions[2]).value.temp_id);
+    TEST_ASSERT_EQUAL(1, tac_src(&func->instructions[4]).value.temp_id);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_copy_propagation_tests(void) {
+    RUN_TEST(test_propagate_copy_chain);
+    RUN_TEST(test_propagate_stops_at_redefinition);
+    RUN_TEST(test_propagate_follows_straight_line_blocks);
+}
@@ -0,0 +1,93 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/dead_code.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+#include <string.h>
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+// --- Test Cases ---
+
+// A chain of temps that only feed each other goes in one pass
+static void test_eliminate_dead_chain(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_copy(t(0), c(5), &arena), &arena);
+    add(func, create_tac_instruction_negate(t(1), t(0), &arena), &arena); // Dead, and so is t0
+    add(func, create_tac_instruction_copy(t(2), c(7), &arena), &arena);
+    add(func, create_tac_instruction_return(t(2), &arena), &arena);
+
+    TEST_ASSERT_TRUE(eliminate_dead_temps(func, &arena));
+    TEST_ASSERT_EQUAL(2, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[0].type);
+    TEST_ASSERT_EQUAL(2, tac_dst(&func->instructions[0]).value.temp_id);
+    TEST_ASSERT_FALSE(eliminate_dead_temps(func, &arena));
+    arena_destroy(&arena);
+}
+
+// A temp read in a later block stays live across the boundary; a division that may trap stays
+static void test_eliminate_keeps_live_and_trapping(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand label = create_tac_operand_label(0);
+    add(func, create_tac_instruction_copy(t(0), c(1), &arena), &arena);
+    add(func, create_tac_instruction_div(t(1), c(8), t(0), &arena), &arena); // Unknown divisor: kept
+    add(func, create_tac_instruction_div(t(2), c(8), c(2), &arena), &arena); // Cannot trap: removed
+    add(func, create_tac_instruction_if_false_goto(t(0), label, &arena), &arena);
+    add(func, create_tac_instruction_copy(t(3), c(4), &arena), &arena);
+    add(func, create_tac_instruction_label(label, &arena), &arena);
+    add(func, create_tac_instruction_return(t(3), &arena), &arena);
+
+    TEST_ASSERT_TRUE(eliminate_dead_temps(func, &arena));
+    TEST_ASSERT_EQUAL(6, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_DIV, func->instructions[1].type);
+    TEST_ASSERT_EQUAL(TAC_INS_IF_FALSE_GOTO, func->instructions[2].type);
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[3].type); // Read after L0
+    arena_destroy(&arena);
+}
+
+// -O1 reduces `return 1 + 2` to a single return, and the stats show it
+static void test_compile_o1_reports_removed_instructions(void) {
+    Arena arena = arena_create(1024 * 16);
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 512);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = 1;
+    CompileStats stats;
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { return 1 + 2; }", &options, &sb, &arena, &stats));
+    TEST_ASSERT_EQUAL(2, stats.tac_instruction_count);
+    TEST_ASSERT_EQUAL(1, stats.optimized_tac_instruction_count); // return 3
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&sb), "    movl $3, %eax\n"));
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    compile_stats_print(&stats, TIME_REPORT_TEXT, out);
+    char buffer[2048] = {0};
+    rewind(out);
+    TEST_ASSERT_GREATER_THAN(0, fread(buffer, 1, sizeof(buffer) - 1, out));
+    fclose(out);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "TAC instructions after optimization: 1 (1 removed, 50.0%)"));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_dead_code_tests(void) {
+    RUN_TEST(test_eliminate_dead_chain);
+    RUN_TEST(test_eliminate_keeps_live_and_trapping);
+    RUN_TEST(test_compile_o1_reports_removed_instructions);
+}
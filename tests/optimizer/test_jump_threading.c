@@ -0,0 +1,69 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/jump_threading.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static TacOperand l(const uint32_t id) {
+    return create_tac_operand_label(id);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+// --- Test Cases ---
+
+// A jump to `L0: goto L1` and on through the empty L1 lands on L2; L0 and L1 lose their jumps and go
+static void test_thread_jumps_through_goto_and_label_run(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), l(0), &arena), &arena);
+    add(func, create_tac_instruction_return(c(1), &arena), &arena);
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_goto(l(1), &arena), &arena);
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_label(l(2), &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+
+    TEST_ASSERT_TRUE(thread_jumps(func, &arena));
+    TEST_ASSERT_EQUAL(5, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_IF_FALSE_GOTO, func->instructions[0].type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(&func->instructions[0]).value.label_id);
+    TEST_ASSERT_EQUAL(TAC_INS_GOTO, func->instructions[2].type); // No longer reached; left for later passes
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(&func->instructions[2]).value.label_id);
+    TEST_ASSERT_EQUAL(TAC_INS_LABEL, func->instructions[3].type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(&func->instructions[3]).value.label_id);
+    TEST_ASSERT_FALSE(thread_jumps(func, &arena));
+    arena_destroy(&arena);
+}
+
+// A block that jumps to itself is not a way through
+static void test_thread_jumps_stops_at_self_loop(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_true_goto(t(0), l(0), &arena), &arena);
+    add(func, create_tac_instruction_return(c(0), &arena), &arena);
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_goto(l(0), &arena), &arena);
+
+    TEST_ASSERT_FALSE(thread_jumps(func, &arena));
+    TEST_ASSERT_EQUAL(4, func->instruction_count);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_jump_threading_tests(void) {
+    RUN_TEST(test_thread_jumps_through_goto_and_label_run);
+    RUN_TEST(test_thread_jumps_stops_at_self_loop);
+}
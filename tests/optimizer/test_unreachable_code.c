@@ -0,0 +1,74 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/unreachable_code.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static TacOperand l(const uint32_t id) {
+    return create_tac_operand_label(id);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+// --- Test Cases ---
+
+// Code after a RETURN and a block only an unreachable jump names go, along with that jump's label
+static void test_unreachable_code_after_return_and_orphaned_block(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_if_false_goto(t(0), l(0), &arena), &arena);
+    add(func, create_tac_instruction_return(c(1), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(1), c(2), &arena), &arena);  // After a return
+    add(func, create_tac_instruction_goto(l(1), &arena), &arena);        // Only jump to L1
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(1), &arena), &arena);
+
+    TEST_ASSERT_TRUE(eliminate_unreachable_code(func, &arena));
+    TEST_ASSERT_EQUAL(4, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_IF_FALSE_GOTO, func->instructions[0].type);
+    TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[1].type);
+    TEST_ASSERT_EQUAL(TAC_INS_LABEL, func->instructions[2].type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(&func->instructions[2]).value.label_id);
+    TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[3].type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(&func->instructions[3]).value.temp_id);
+    TEST_ASSERT_FALSE(eliminate_unreachable_code(func, &arena));
+    arena_destroy(&arena);
+}
+
+// A label nothing jumps to is dropped even where control falls into it; a loop reached from the entry stays
+static void test_unreachable_code_drops_unused_labels_only(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_label(l(0), &arena), &arena);       // Unused
+    add(func, create_tac_instruction_label(l(1), &arena), &arena);
+    add(func, create_tac_instruction_sub(t(0), t(0), c(1), &arena), &arena);
+    add(func, create_tac_instruction_if_true_goto(t(0), l(1), &arena), &arena);
+    add(func, create_tac_instruction_return(t(0), &arena), &arena);
+
+    TEST_ASSERT_TRUE(eliminate_unreachable_code(func, &arena));
+    TEST_ASSERT_EQUAL(4, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_LABEL, func->instructions[0].type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(&func->instructions[0]).value.label_id);
+    TEST_ASSERT_FALSE(eliminate_unreachable_code(func, &arena));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_unreachable_code_tests(void) {
+    RUN_TEST(test_unreachable_code_after_return_and_orphaned_block);
+    RUN_TEST(test_unreachable_code_drops_unused_labels_only);
+}
@@ -0,0 +1,104 @@
+#include "../_unity/unity.h"
+#include "../../src/optimizer/value_numbering.h"
+#include "../../src/ir/tac.h"
+#include "../../src/memory/arena.h"
+
+// --- Helpers ---
+
+static TacOperand t(const int id) {
+    return create_tac_operand_temp(id);
+}
+
+static TacOperand c(const int value) {
+    return create_tac_operand_const(value);
+}
+
+static void add(TacFunction *func, const TacInstruction *instr, Arena *arena) {
+    add_instruction_to_function(func, instr, arena);
+}
+
+static void assert_copy(const TacInstruction *instr, const int dst, const int src) {
+    TEST_ASSERT_EQUAL(TAC_INS_COPY, instr->type);
+    TEST_ASSERT_EQUAL(dst, tac_dst(instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src, tac_src(instr).value.temp_id);
+}
+
+// --- Test Cases ---
+
+// (a + b) < c && c > (b + a): the second sum and comparison are the first ones
+static void test_number_values_repeated_predicate(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_add(t(3), t(0), t(1), &arena), &arena);
+    add(func, create_tac_instruction_less(t(4), t(3), t(2), &arena), &arena);
+    add(func, create_tac_instruction_add(t(5), t(1), t(0), &arena), &arena);
+    add(func, create_tac_instruction_greater(t(6), t(2), t(5), &arena), &arena);
+    add(func, create_tac_instruction_logical_and(t(7), t(4), t(6), &arena), &arena);
+    add(func, create_tac_instruction_return(t(7), &arena), &arena);
+
+    TEST_ASSERT_TRUE(number_values(func, &arena));
+    TEST_ASSERT_EQUAL(6, func->instruction_count);
+    TEST_ASSERT_EQUAL(TAC_INS_ADD, func->instructions[0].type);
+    assert_copy(&func->instructions[2], 5, 3);
+    assert_copy(&func->instructions[3], 6, 4);
+    TEST_ASSERT_EQUAL(TAC_INS_LOGICAL_AND, func->instructions[4].type);
+    TEST_ASSERT_EQUAL(6, tac_src2(&func->instructions[4]).value.temp_id); // Left for copy propagation
+    TEST_ASSERT_FALSE(number_values(func, &arena));
+    arena_destroy(&arena);
+}
+
+// A value computed before a branch serves both sides; one computed on a side serves neither the other nor the join
+static void test_number_values_follows_dominators(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand l0 = create_tac_operand_label(0);
+    const TacOperand l1 = create_tac_operand_label(1);
+    add(func, create_tac_instruction_sub(t(2), t(0), t(1), &arena), &arena);
+    add(func, create_tac_instruction_if_false_goto(t(2), l0, &arena), &arena);
+    add(func, create_tac_instruction_sub(t(3), t(0), t(1), &arena), &arena); // 2: reuses t2
+    add(func, create_tac_instruction_mul(t(4), t(0), t(1), &arena), &arena);
+    add(func, create_tac_instruction_goto(l1, &arena), &arena);
+    add(func, create_tac_instruction_label(l0, &arena), &arena);
+    add(func, create_tac_instruction_mul(t(4), t(1), t(0), &arena), &arena); // 6: not dominated by 3
+    add(func, create_tac_instruction_label(l1, &arena), &arena);
+    add(func, create_tac_instruction_mul(t(5), t(0), t(1), &arena), &arena); // 8: not dominated by either
+    add(func, create_tac_instruction_add(t(6), t(4), t(5), &arena), &arena);
+    add(func, create_tac_instruction_return(t(6), &arena), &arena);
+
+    TEST_ASSERT_TRUE(number_values(func, &arena));
+    assert_copy(&func->instructions[2], 3, 2);
+    TEST_ASSERT_EQUAL(TAC_INS_MUL, func->instructions[3].type);
+    TEST_ASSERT_EQUAL(TAC_INS_MUL, func->instructions[6].type);
+    TEST_ASSERT_EQUAL(TAC_INS_MUL, func->instructions[8].type);
+    TEST_ASSERT_EQUAL(4, tac_dst(&func->instructions[6]).value.temp_id); // Back out of SSA form
+    TEST_ASSERT_EQUAL(4, tac_src1(&func->instructions[9]).value.temp_id);
+    arena_destroy(&arena);
+}
+
+// Redefining an operand gives a new value; overwriting the holder loses the old one
+static void test_number_values_respects_redefinitions(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    add(func, create_tac_instruction_add(t(2), t(0), t(1), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(0), c(5), &arena), &arena);
+    add(func, create_tac_instruction_add(t(3), t(0), t(1), &arena), &arena); // A different t0
+    add(func, create_tac_instruction_negate(t(4), t(1), &arena), &arena);
+    add(func, create_tac_instruction_copy(t(4), c(7), &arena), &arena);
+    add(func, create_tac_instruction_negate(t(5), t(1), &arena), &arena); // t4 no longer holds -t1
+    add(func, create_tac_instruction_add(t(6), t(1), t(0), &arena), &arena); // Same as 2
+    add(func, create_tac_instruction_return(t(6), &arena), &arena);
+
+    TEST_ASSERT_TRUE(number_values(func, &arena));
+    TEST_ASSERT_EQUAL(TAC_INS_ADD, func->instructions[2].type);
+    TEST_ASSERT_EQUAL(TAC_INS_NEGATE, func->instructions[5].type);
+    assert_copy(&func->instructions[6], 6, 3);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_value_numbering_tests(void) {
+    RUN_TEST(test_number_values_repeated_predicate);
+    RUN_TEST(test_number_values_follows_dominators);
+    RUN_TEST(test_number_values_respects_redefinitions);
+}
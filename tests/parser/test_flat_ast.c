@@ -0,0 +1,245 @@
+#include "unity.h"
+#include "../../src/lexer/lexer.h"
+#include "../../src/parser/parser.h"
+#include "../../src/parser/ast.h"
+#include "../../src/parser/flat_ast.h"
+#include "../../src/validator/validator.h"
+#include "../../src/ir/ast_to_tac.h"
+#include "../../src/compiler/compiler.h"
+#include "../../src/memory/arena.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h> // For dup/dup2, to capture the pretty-printers' stdout
+
+// --- Helpers ---
+
+static ProgramNode *parse_source(const char *source, Arena *arena) {
+    Lexer lexer;
+    Parser parser;
+    lexer_init(&lexer, source, arena);
+    parser_init(&parser, &lexer, arena);
+    ProgramNode *program = parse_program(&parser);
+    TEST_ASSERT_FALSE_MESSAGE(parser.error_flag, parser.error_message);
+    return program;
+}
+
+static FlatAst *flatten_source(const char *source, Arena *arena) {
+    FlatAst *ast = flat_ast_from_program(parse_source(source, arena), arena);
+    TEST_ASSERT_NOT_NULL(ast);
+    return ast;
+}
+
+// Runs print(...) with stdout redirected into `buffer`
+static void capture_stdout(void (*print)(const void *), const void *arg, char *buffer, const size_t size) {
+    FILE *capture = tmpfile();
+    TEST_ASSERT_NOT_NULL(capture);
+    fflush(stdout);
+    const int saved = dup(fileno(stdout));
+    dup2(fileno(capture), fileno(stdout));
+    print(arg);
+    fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+
+    rewind(capture);
+    const size_t length = fread(buffer, 1, size - 1, capture);
+    buffer[length] = '\0';
+    fclose(capture);
+}
+
+static void print_pointer_tree(const void *program) {
+    ast_pretty_print((AstNode *) program, 0);
+}
+
+static void print_flat_tree(const void *ast) {
+    flat_ast_pretty_print(ast, ((const FlatAst *) ast)->root, 0);
+}
+
+static const char *tac_text(const TacProgram *program, Arena *arena) {
+    TEST_ASSERT_NOT_NULL(program);
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 1024);
+    tac_print_program(&sb, program);
+    return string_buffer_content_str(&sb);
+}
+
+// --- Test Cases ---
+
+// Children precede their parents, the root comes last, and blocks list their items in order
+static void test_flat_ast_post_order_layout(void) {
+    Arena arena = arena_create(1024 * 16);
+    const FlatAst *ast = flatten_source("int main(void) { int a = 2; { int b; } return a * -3; }", &arena);
+
+    TEST_ASSERT_EQUAL(12, sizeof(FlatAstNode));
+    TEST_ASSERT_EQUAL_UINT32(ast->node_count - 1, ast->root);
+    TEST_ASSERT_EQUAL(NODE_PROGRAM, flat_ast_node(ast, ast->root)->type);
+    for (AstHandle h = 0; h < ast->node_count; ++h) {
+        const FlatAstNode *node = flat_ast_node(ast, h);
+        switch ((NodeType) node->type) {
+            case NODE_PROGRAM:
+            case NODE_RETURN_STMT:
+            case NODE_UNARY_OP:
+                TEST_ASSERT_LESS_THAN_UINT32(h, node->first);
+                break;
+            case NODE_BINARY_OP:
+                TEST_ASSERT_LESS_THAN_UINT32(node->second, node->first); // Left subtree first
+                TEST_ASSERT_LESS_THAN_UINT32(h, node->second);
+                break;
+            case NODE_BLOCK:
+                for (uint32_t i = 0; i < node->second; ++i) {
+                    TEST_ASSERT_LESS_THAN_UINT32(h, flat_ast_block_item(ast, node, i));
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    const FlatAstNode *function = flat_ast_node(ast, flat_ast_node(ast, ast->root)->first);
+    TEST_ASSERT_EQUAL(NODE_FUNC_DEF, function->type);
+    TEST_ASSERT_EQUAL_STRING("main", flat_ast_name(ast, function->first));
+    const FlatAstNode *body = flat_ast_node(ast, function->second);
+    TEST_ASSERT_EQUAL(NODE_BLOCK, body->type);
+    TEST_ASSERT_EQUAL_UINT32(3, body->second);
+    TEST_ASSERT_EQUAL(NODE_VAR_DECL, flat_ast_node(ast, flat_ast_block_item(ast, body, 0))->type);
+    TEST_ASSERT_EQUAL(NODE_BLOCK, flat_ast_node(ast, flat_ast_block_item(ast, body, 1))->type);
+
+    // `int b;` has no initializer
+    const FlatAstNode *inner = flat_ast_node(ast, flat_ast_block_item(ast, body, 1));
+    const FlatAstNode *decl_b = flat_ast_node(ast, flat_ast_block_item(ast, inner, 0));
+    TEST_ASSERT_EQUAL_UINT32(AST_HANDLE_NONE, decl_b->second);
+    TEST_ASSERT_EQUAL_STRING("b", flat_ast_name(ast, decl_b->first));
+    TEST_ASSERT_EQUAL_STRING("int", flat_ast_name(ast, decl_b->first + 1));
+
+    // return a * -3
+    const FlatAstNode *ret = flat_ast_node(ast, flat_ast_block_item(ast, body, 2));
+    const FlatAstNode *mul = flat_ast_node(ast, ret->first);
+    TEST_ASSERT_EQUAL(NODE_BINARY_OP, mul->type);
+    TEST_ASSERT_EQUAL(OPERATOR_MULTIPLY, mul->op);
+    const FlatAstNode *use_a = flat_ast_node(ast, mul->first);
+    TEST_ASSERT_EQUAL(NODE_IDENTIFIER, use_a->type);
+    // Names stay the interned pointers of the pointer tree
+    TEST_ASSERT_EQUAL_PTR(flat_ast_name(ast, flat_ast_node(ast, flat_ast_block_item(ast, body, 0))->first),
+                          flat_ast_name(ast, use_a->first));
+    const FlatAstNode *negate = flat_ast_node(ast, mul->second);
+    TEST_ASSERT_EQUAL(OPERATOR_NEGATE, negate->op);
+    TEST_ASSERT_EQUAL_INT(3, flat_ast_int_value(flat_ast_node(ast, negate->first)));
+    arena_destroy(&arena);
+}
+
+// --parse prints the flat tree exactly as it prints the pointer tree
+static void test_flat_ast_pretty_print_matches_pointer_tree(void) {
+    const char *sources[] = {
+        "int main(void) { int a = 2; { int b; b = a; } return a * -3; }",
+        "int main(void) { int x; return !(~1 < 2 || 3 >= 4 && x == 5); }",
+    };
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        Arena arena = arena_create(1024 * 16);
+        const ProgramNode *program = parse_source(sources[i], &arena);
+        const FlatAst *ast = flat_ast_from_program(program, &arena);
+        TEST_ASSERT_NOT_NULL(ast);
+
+        static char expected[8192];
+        static char actual[8192];
+        capture_stdout(print_pointer_tree, program, expected, sizeof(expected));
+        capture_stdout(print_flat_tree, ast, actual, sizeof(actual));
+        TEST_ASSERT_NOT_NULL(strstr(expected, "Program(\n"));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+        arena_destroy(&arena);
+    }
+}
+
+// Same checks and outcomes as validate_program
+static void test_flat_ast_validation(void) {
+    const struct {
+        const char *source;
+        bool valid;
+    } cases[] = {
+        {"int main(void) { int a = 1; { int a = 2; } return a; }", true}, // Shadowing
+        {"int main(void) { int a = a; return a; }", true},                // In scope in its initializer
+        {"int main(void) { return b; }", false},                           // Undeclared
+        {"int main(void) { int a; int a; return 0; }", false},             // Redeclared
+        {"int main(void) { int a; 1 = a; return 0; }", false},             // Not an l-value
+        {"int main(void) { { int a; } return a; }", false},                // Out of scope
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        Arena arena = arena_create(1024 * 16);
+        ProgramNode *program = parse_source(cases[i].source, &arena);
+        const FlatAst *ast = flat_ast_from_program(program, &arena);
+        TEST_ASSERT_EQUAL_MESSAGE(validate_program((AstNode *) program, &arena), cases[i].valid, cases[i].source);
+        TEST_ASSERT_EQUAL_MESSAGE(cases[i].valid, validate_flat_program(ast, &arena), cases[i].source);
+        arena_destroy(&arena);
+    }
+}
+
+// A block long enough to grow the pending stack, then a block whose declarations reuse its scope's memory
+static void test_flat_ast_validation_long_block_then_scope(void) {
+    static char source[4096];
+    size_t length = (size_t) snprintf(source, sizeof(source), "int main(void) { {");
+    for (int i = 0; i < 48; ++i) {
+        length += (size_t) snprintf(source + length, sizeof(source) - length, " return %d;", i);
+    }
+    length += (size_t) snprintf(source + length, sizeof(source) - length, " } {");
+    for (int i = 0; i < 48; ++i) {
+        length += (size_t) snprintf(source + length, sizeof(source) - length, " int a%d = %d;", i, i);
+    }
+    snprintf(source + length, sizeof(source) - length, " return a1 + a47; } }");
+
+    Arena arena = arena_create(1024 * 16);
+    ProgramNode *program = parse_source(source, &arena);
+    TEST_ASSERT_NOT_NULL(program);
+    const FlatAst *ast = flat_ast_from_program(program, &arena);
+    TEST_ASSERT_TRUE(validate_program((AstNode *) program, &arena));
+    TEST_ASSERT_TRUE(validate_flat_program(ast, &arena));
+    arena_destroy(&arena);
+}
+
+// Lowering the flat tree gives the same instructions, temps and labels
+static void test_flat_ast_lowers_to_same_tac(void) {
+    const char *sources[] = {
+        "int main(void) { return 1 + 2 * -3 % 4; }",
+        "int main(void) { return (1 && 2) || !(3 < 4 && 5 != 6); }",
+        "int main(void) { { return ~(7 - 8) >= 9 == 0; } }",
+    };
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        Arena arena = arena_create(1024 * 16);
+        ProgramNode *program = parse_source(sources[i], &arena);
+        const FlatAst *ast = flat_ast_from_program(program, &arena);
+        const char *expected = tac_text(ast_to_tac(program, &arena), &arena);
+        const char *actual = tac_text(flat_ast_to_tac(ast, &arena), &arena);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, sources[i]);
+        arena_destroy(&arena);
+    }
+}
+
+// --flat-ast changes the walk, not the output
+static void test_compile_with_flat_ast(void) {
+    const char *source = "int main(void) { return (3 > 2 || 0) + -(4 / 2) * 5; }";
+    for (int level = 0; level <= 1; ++level) {
+        Arena arena = arena_create(1024 * 64);
+        CompileOptions options;
+        compile_options_init(&options);
+        options.optimization_level = level;
+        StringBuffer pointer_asm;
+        string_buffer_init(&pointer_asm, &arena, 1024);
+        TEST_ASSERT_TRUE(compile_with_options(source, &options, &pointer_asm, &arena, NULL));
+
+        options.flat_ast = true;
+        StringBuffer flat_asm;
+        string_buffer_init(&flat_asm, &arena, 1024);
+        TEST_ASSERT_TRUE(compile_with_options(source, &options, &flat_asm, &arena, NULL));
+        TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&pointer_asm), string_buffer_content_str(&flat_asm));
+        arena_destroy(&arena);
+    }
+}
+
+// --- Test Runner ---
+
+void run_flat_ast_tests(void) {
+    RUN_TEST(test_flat_ast_post_order_layout);
+    RUN_TEST(test_flat_ast_pretty_print_matches_pointer_tree);
+    RUN_TEST(test_flat_ast_validation);
+    RUN_TEST(test_flat_ast_validation_long_block_then_scope);
+    RUN_TEST(test_flat_ast_lowers_to_same_tac);
+    RUN_TEST(test_compile_with_flat_ast);
+}
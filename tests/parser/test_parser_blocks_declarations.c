@@ -222,6 +222,38 @@ void test_parse_mixed_declarations_and_statements(void) {
 }
 
 
+// Every occurrence of a name in the parsed tree shares the interner's canonical pointer
+void test_parse_names_are_interned(void) {
+    Lexer lexer;
+    Parser parser;
+    Arena ast_arena, lexer_arena;
+    setup_parser_for_test("int main() { int x; int y = x; return x; }", &lexer, &parser, &ast_arena, &lexer_arena);
+
+    ProgramNode *program = parse_program(&parser);
+    TEST_ASSERT_NOT_NULL_MESSAGE(program, "Program node should not be NULL.");
+    TEST_ASSERT_FALSE_MESSAGE(parser.error_flag, parser.error_message);
+    TEST_ASSERT_NOT_NULL(program->interner);
+
+    BlockNode *body = program->function->body;
+    TEST_ASSERT_EQUAL_INT(3, body->num_items);
+    const VarDeclNode *decl_x = (VarDeclNode *) body->items[0];
+    const VarDeclNode *decl_y = (VarDeclNode *) body->items[1];
+    const ReturnStmtNode *ret = (ReturnStmtNode *) body->items[2];
+    TEST_ASSERT_EQUAL_UINT(NODE_IDENTIFIER, decl_y->initializer->type);
+    TEST_ASSERT_EQUAL_UINT(NODE_IDENTIFIER, ret->expression->type);
+
+    const char *x = interner_find_n(program->interner, "x", 1);
+    TEST_ASSERT_NOT_NULL(x);
+    TEST_ASSERT_EQUAL_PTR(x, decl_x->var_name);
+    TEST_ASSERT_EQUAL_PTR(x, ((IdentifierNode *) decl_y->initializer)->name);
+    TEST_ASSERT_EQUAL_PTR(x, ((IdentifierNode *) ret->expression)->name);
+    TEST_ASSERT_EQUAL_PTR(decl_x->type_name, decl_y->type_name);
+    TEST_ASSERT_EQUAL_PTR(interner_find_n(program->interner, "main", 4), program->function->name);
+
+    arena_destroy(&ast_arena);
+    arena_destroy(&lexer_arena);
+}
+
 void run_parser_blocks_declarations_tests(void) {
     RUN_TEST(test_parse_empty_block__empty_function_body);
     RUN_TEST(test_parse_simple_declaration__single_int_var);
@@ -231,4 +263,5 @@ void run_parser_blocks_declarations_tests(void) {
     RUN_TEST(test_parse_nested_block__inner_block_with_declaration);
     RUN_TEST(test_parse_multiple_declarations);
     RUN_TEST(test_parse_mixed_declarations_and_statements);
+    RUN_TEST(test_parse_names_are_interned);
 }
@@ -121,9 +121,56 @@ void test_parse_function_empty_body(void) {
 }
 
 // --- Test Runner --- //
+// Test parsing from a pre-lexed token array gives the same tree as lexing on demand
+void test_parse_program_from_token_array(void) {
+    const char *input = "int main(void) { int a = 1; return a + 2; }";
+    Arena test_arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, input, &test_arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+
+    Parser parser;
+    parser_init_tokens(&parser, &tokens, &test_arena);
+    ProgramNode *program = parse_program(&parser);
+
+    TEST_ASSERT_NOT_NULL_MESSAGE(program, parser.error_message);
+    TEST_ASSERT_FALSE(parser.error_flag);
+    TEST_ASSERT_EQUAL_STRING("main", program->function->name);
+    BlockNode *body = program->function->body;
+    TEST_ASSERT_EQUAL_INT(2, body->num_items);
+    TEST_ASSERT_EQUAL(NODE_VAR_DECL, body->items[0]->type);
+    TEST_ASSERT_EQUAL(NODE_RETURN_STMT, body->items[1]->type);
+    ReturnStmtNode *ret = (ReturnStmtNode *) body->items[1];
+    TEST_ASSERT_EQUAL(NODE_BINARY_OP, ret->expression->type);
+
+    arena_destroy(&test_arena);
+}
+
+// Test that syntax errors are still reported when reading a token array
+void test_parse_token_array_missing_semicolon(void) {
+    const char *input = "int main(void) { return 42 }";
+    Arena test_arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, input, &test_arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+
+    Parser parser;
+    parser_init_tokens(&parser, &tokens, &test_arena);
+    TEST_ASSERT_NULL(parse_program(&parser));
+    TEST_ASSERT_TRUE(parser.error_flag);
+
+    arena_destroy(&test_arena);
+}
+
 void run_parser_program_tests(void) {
     RUN_TEST(test_parse_valid_program);
     RUN_TEST(test_parse_missing_semicolon);
     RUN_TEST(test_parse_missing_brace);
     RUN_TEST(test_parse_function_empty_body);
+    RUN_TEST(test_parse_program_from_token_array);
+    RUN_TEST(test_parse_token_array_missing_semicolon);
 }
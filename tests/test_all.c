@@ -28,6 +28,8 @@ void run_parser_blocks_declarations_tests(void); // Forward declaration for the
 
 void run_parser_assignments_tests(void); // Forward declaration for assignments tests
 
+void run_flat_ast_tests(void);
+
 void run_strings_tests(void); // Forward declaration for string tests
 
 void run_codegen_tests(void); // Forward declaration for codegen tests
@@ -36,14 +38,35 @@ void run_codegen_logical_tests(void); // Forward declaration for codegen tests
 
 void run_codegen_relational_conditional_tests(void); // Forward declaration for codegen tests
 
+void run_peephole_tests(void);
+void run_value_cache_tests(void);
+void run_strength_reduction_tests(void);
+void run_x86_encoder_tests(void);
+void run_jit_tests(void);
+
 void run_compiler_tests(void); // Forward declaration for integration tests
+void run_trace_tests(void);
 
 void run_arena_tests(void); // Forward declaration for arena tests
+void run_slab_tests(void);
 
 void run_tac_tests(void);
+void run_tac_interpreter_tests(void);
+void run_tac_file_tests(void);
 
 void run_ast_to_tac_tests(void);
 
+void run_cfg_tests(void);
+void run_ssa_tests(void);
+
+void run_constant_folding_tests(void);
+void run_copy_propagation_tests(void);
+void run_dead_code_tests(void);
+void run_value_numbering_tests(void);
+void run_jump_threading_tests(void);
+void run_unreachable_code_tests(void);
+void run_block_layout_tests(void);
+
 void run_symbol_table_tests(void); // Forward declaration for symbol table tests
 
 void run_validator_tests(void); // Added validator test runner
@@ -84,6 +107,7 @@ int main(void) {
     run_parser_errors_and_literals_tests();
     run_parser_blocks_declarations_tests();
     run_parser_assignments_tests();
+    run_flat_ast_tests();
 
     printf("\n--- Running Strings Tests --- \n");
     run_strings_tests();
@@ -94,21 +118,43 @@ int main(void) {
 
     printf("\n--- Running Arena Tests --- \n");
     run_arena_tests();
+    run_slab_tests();
 
     printf("\n--- Running TAC Tests --- \n");
     run_tac_tests();
+    run_tac_interpreter_tests();
+    run_tac_file_tests();
 
     printf("\n--- Running AST to TAC Tests --- \n");
     run_ast_to_tac_tests();
 
+    printf("\n--- Running CFG Tests --- \n");
+    run_cfg_tests();
+    run_ssa_tests();
+
+    printf("\n--- Running Optimizer Tests --- \n");
+    run_constant_folding_tests();
+    run_copy_propagation_tests();
+    run_dead_code_tests();
+    run_value_numbering_tests();
+    run_jump_threading_tests();
+    run_unreachable_code_tests();
+    run_block_layout_tests();
+
     printf("\n--- Running Codegen Tests --- \n");
     run_codegen_tests();
     run_codegen_logical_tests();
     run_codegen_relational_conditional_tests();
+    run_peephole_tests();
+    run_value_cache_tests();
+    run_strength_reduction_tests();
+    run_x86_encoder_tests();
+    run_jit_tests();
 
     /* -- integration tests -- */
     printf("\n--- Running Compiler Tests --- \n");
     run_compiler_tests();
+    run_trace_tests();
 
     return UNITY_END(); // Use UNITY_END() in the main runner
 }
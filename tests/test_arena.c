@@ -1,7 +1,9 @@
 #include "unity.h"
 #include "memory/arena.h"
+#include "memory/arena_stack.h"
 #include <stddef.h> // For size_t
 #include <stdint.h> // For uintptr_t
+#include <string.h> // For memset
 
 // Define alignment based on the implementation in arena.c (using compiler extension)
 #define MAX_ALIGNMENT __alignof__(long double)
@@ -88,35 +90,93 @@ void test_arena_alloc_alignment(void) {
 }
 
 
-void test_arena_alloc_out_of_memory(void) {
+void test_arena_alloc_grows_new_chunk(void) {
     Arena arena = arena_create(100); // Small arena
     void *ptr1 = arena_alloc(&arena, 80);
     TEST_ASSERT_NOT_NULL(ptr1);
     TEST_ASSERT_TRUE(is_aligned(ptr1, MAX_ALIGNMENT));
+    char *first_chunk = arena.start;
 
-    // This allocation should fail
+    // This allocation does not fit in the first chunk: a new one is chained in
     void *ptr2 = arena_alloc(&arena, 50);
-    TEST_ASSERT_NULL(ptr2); // Expect NULL when out of memory
+    TEST_ASSERT_NOT_NULL(ptr2);
+    TEST_ASSERT_TRUE(is_aligned(ptr2, MAX_ALIGNMENT));
+    TEST_ASSERT_TRUE(arena.start != first_chunk);
+    TEST_ASSERT_EQUAL_PTR(arena.start, ptr2); // First allocation of the new chunk
+    TEST_ASSERT_EQUAL(200, arena.total_size); // Chunks grow geometrically
+    TEST_ASSERT_EQUAL(50, arena.offset);
 
-    // Verify offset didn't change after failed allocation
-    size_t offset_after_fail = arena.offset;
+    // Memory from the first chunk stays valid
+    ((char *) ptr1)[79] = 'x';
+    TEST_ASSERT_EQUAL('x', ((char *) ptr1)[79]);
 
-    // Try small allocation again, should succeed if there's *some* room left
+    // Subsequent allocations bump within the new chunk
     void *ptr3 = arena_alloc(&arena, 1);
-    // Check if it succeeded (it should if ptr1 didn't exactly fill the arena)
-    size_t expected_available = arena.total_size - offset_after_fail;
-    if (expected_available >= 1) {
-        TEST_ASSERT_NOT_NULL(ptr3);
-        TEST_ASSERT_TRUE(is_aligned(ptr3, MAX_ALIGNMENT));
-        // Check that ptr3 is positioned correctly after the first allocation + alignment padding
-        TEST_ASSERT_EQUAL_PTR((void*)(arena.start + align_up(offset_after_fail - 80, MAX_ALIGNMENT) + 80), ptr3);
-        TEST_ASSERT_GREATER_OR_EQUAL(offset_after_fail + 1, arena.offset); // Offset should advance
-    } else {
-        // If somehow ptr1 perfectly filled it, then ptr3 should be NULL
-        TEST_ASSERT_NULL(ptr3);
-        TEST_ASSERT_EQUAL(offset_after_fail, arena.offset);
-    }
+    TEST_ASSERT_NOT_NULL(ptr3);
+    TEST_ASSERT_EQUAL_PTR((void*)(arena.start + align_up(50, MAX_ALIGNMENT)), ptr3);
+
+    arena_destroy(&arena);
+}
 
+void test_arena_alloc_larger_than_growth(void) {
+    Arena arena = arena_create(64);
+    // A request bigger than the doubled chunk size gets a chunk of its own size
+    char *big = arena_alloc(&arena, 10000);
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_TRUE(is_aligned(big, MAX_ALIGNMENT));
+    TEST_ASSERT_GREATER_OR_EQUAL(10000, arena.total_size);
+    big[9999] = 1; // Touch the last byte
+    arena_destroy(&arena);
+}
+
+void test_arena_stats(void) {
+    Arena arena = arena_create(128);
+    ArenaStats stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(0, stats.used_bytes);
+    TEST_ASSERT_EQUAL(1, stats.chunk_count);
+    TEST_ASSERT_EQUAL(128, stats.reserved_bytes);
+
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100));
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // Forces a second chunk
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(2, stats.chunk_count);
+    TEST_ASSERT_EQUAL(128 + 256, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(28, stats.wasted_tail_bytes); // Unused tail of the first chunk
+    TEST_ASSERT_EQUAL(200, stats.used_bytes);
+    TEST_ASSERT_EQUAL(200, stats.peak_bytes);
+
+    // Peak survives a reset, which keeps only the newest chunk
+    arena_reset(&arena);
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(0, stats.used_bytes);
+    TEST_ASSERT_EQUAL(200, stats.peak_bytes);
+    TEST_ASSERT_EQUAL(1, stats.chunk_count);
+    TEST_ASSERT_EQUAL(256, stats.reserved_bytes);
+    TEST_ASSERT_EQUAL(0, stats.wasted_tail_bytes);
+
+    arena_destroy(&arena);
+}
+
+void test_arena_stats_counts_allocations(void) {
+    Arena arena = arena_create(128);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 10));
+    const ArenaMark mark = arena_mark(&arena);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 30));
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 200)); // Slow path (new chunk) is counted too
+    ArenaStats stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(3, stats.alloc_count);
+    TEST_ASSERT_EQUAL(240, stats.alloc_bytes);
+
+    // Counters are cumulative: releasing scratch memory does not lower them
+    arena_release(&arena, mark);
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(3, stats.alloc_count);
+    TEST_ASSERT_EQUAL(240, stats.alloc_bytes);
+
+    arena_reset(&arena);
+    stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(0, stats.alloc_count);
+    TEST_ASSERT_EQUAL(0, stats.alloc_bytes);
     arena_destroy(&arena);
 }
 
@@ -144,6 +204,234 @@ void test_arena_reset(void) {
     arena_destroy(&arena);
 }
 
+void test_arena_mark_release_same_chunk(void) {
+    Arena arena = arena_create(1024);
+    void *keep = arena_alloc(&arena, 40);
+    TEST_ASSERT_NOT_NULL(keep);
+    const size_t offset_at_mark = arena.offset;
+
+    const ArenaMark mark = arena_mark(&arena);
+    void *scratch = arena_alloc(&arena, 200);
+    TEST_ASSERT_NOT_NULL(scratch);
+    arena_release(&arena, mark);
+    TEST_ASSERT_EQUAL(offset_at_mark, arena.offset);
+
+    // The released space is handed out again
+    void *again = arena_alloc(&arena, 200);
+    TEST_ASSERT_EQUAL_PTR(scratch, again);
+
+    arena_destroy(&arena);
+}
+
+void test_arena_mark_release_frees_new_chunks(void) {
+    Arena arena = arena_create(128);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 64));
+    char *first_chunk = arena.start;
+
+    const ArenaMark outer = arena_mark(&arena);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // Second chunk
+    const ArenaMark inner = arena_mark(&arena);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 1000)); // Third chunk
+    TEST_ASSERT_EQUAL(3, arena_stats(&arena).chunk_count);
+
+    arena_release(&arena, inner);
+    TEST_ASSERT_EQUAL(2, arena_stats(&arena).chunk_count);
+    TEST_ASSERT_EQUAL(100, arena.offset);
+
+    arena_release(&arena, outer);
+    ArenaStats stats = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(1, stats.chunk_count);
+    TEST_ASSERT_EQUAL_PTR(first_chunk, arena.start);
+    TEST_ASSERT_EQUAL(128, arena.total_size);
+    TEST_ASSERT_EQUAL(64, stats.used_bytes);
+    TEST_ASSERT_EQUAL(0, stats.wasted_tail_bytes);
+    TEST_ASSERT_EQUAL(64 + 100 + 1000, stats.peak_bytes); // Peak still reflects the scratch usage
+
+    arena_destroy(&arena);
+}
+
+// A mark taken in another arena is refused before any chunk is freed
+void test_arena_release_foreign_mark_leaves_arena_untouched(void) {
+    Arena arena = arena_create(128);
+    Arena other = arena_create(128);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 64));
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 100)); // Second chunk
+    const ArenaMark foreign = arena_mark(&other);
+    char *start = arena.start;
+    const size_t offset = arena.offset;
+
+    arena_release(&arena, foreign);
+    TEST_ASSERT_EQUAL(2, arena_stats(&arena).chunk_count);
+    TEST_ASSERT_EQUAL_PTR(start, arena.start);
+    TEST_ASSERT_EQUAL(offset, arena.offset);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 16));
+
+    arena_destroy(&other);
+    arena_destroy(&arena);
+}
+
+void test_arena_reset_zeroes_up_to_high_water(void) {
+    Arena arena = arena_create(1024);
+    unsigned char *kept = arena_alloc(&arena, 64);
+    memset(kept, 0xAB, 64);
+    const ArenaMark mark = arena_mark(&arena);
+    unsigned char *scratch = arena_alloc(&arena, 256);
+    memset(scratch, 0xCD, 256);
+    arena_release(&arena, mark); // Offset moves back, but the high-water mark stays
+
+    arena_reset(&arena);
+    TEST_ASSERT_EQUAL(0, arena.offset);
+    for (size_t i = 0; i < 64; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(0, kept[i]);
+    }
+    for (size_t i = 0; i < 256; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(0, scratch[i]);
+    }
+
+    arena_destroy(&arena);
+}
+
+void test_arena_reset_dirty_keeps_contents(void) {
+    Arena arena = arena_create(1024);
+    unsigned char *ptr = arena_alloc(&arena, 32);
+    memset(ptr, 0x5A, 32);
+
+    arena_reset_with_mode(&arena, ARENA_RESET_DIRTY);
+    TEST_ASSERT_EQUAL(0, arena.offset);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, ptr[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, ptr[31]);
+
+    // Callers that need cleared memory ask for it explicitly
+    unsigned char *zeroed = arena_alloc_zeroed(&arena, 32);
+    TEST_ASSERT_EQUAL_PTR(ptr, zeroed);
+    for (size_t i = 0; i < 32; ++i) {
+        TEST_ASSERT_EQUAL_UINT8(0, zeroed[i]);
+    }
+
+    arena_destroy(&arena);
+}
+
+void test_arena_stack_push_pop_across_chunks(void) {
+    Arena arena = arena_create(1024);
+    ArenaStack stack;
+    arena_stack_init(&stack, &arena, sizeof(int));
+    TEST_ASSERT_TRUE(arena_stack_is_empty(&stack));
+    TEST_ASSERT_NULL(arena_stack_top(&stack));
+
+    // Enough items to need several chunks
+    const int count = ARENA_STACK_FIRST_CHUNK_ITEMS * 10;
+    int *first = NULL;
+    for (int i = 0; i < count; ++i) {
+        int *item = arena_stack_push(&stack);
+        TEST_ASSERT_NOT_NULL(item);
+        *item = i;
+        if (i == 0) first = item;
+    }
+    TEST_ASSERT_EQUAL(count, stack.depth);
+    TEST_ASSERT_NOT_NULL(stack.top->below); // Spilled into a second chunk
+    TEST_ASSERT_EQUAL(0, *first);           // Items never move
+
+    for (int i = count - 1; i >= 0; --i) {
+        TEST_ASSERT_EQUAL(i, *(int *) arena_stack_top(&stack));
+        arena_stack_pop(&stack);
+    }
+    TEST_ASSERT_TRUE(arena_stack_is_empty(&stack));
+    arena_stack_pop(&stack); // No-op on an empty stack
+    TEST_ASSERT_EQUAL(0, stack.depth);
+    arena_destroy(&arena);
+}
+
+void test_arena_stack_reuses_chunks_and_truncates(void) {
+    Arena arena = arena_create(1024);
+    ArenaStack stack;
+    arena_stack_init(&stack, &arena, sizeof(long));
+    for (int i = 0; i < 100; ++i) {
+        *(long *) arena_stack_push(&stack) = i;
+    }
+    arena_stack_truncate(&stack, 40);
+    TEST_ASSERT_EQUAL(40, stack.depth);
+    TEST_ASSERT_EQUAL(39, *(long *) arena_stack_top(&stack));
+    arena_stack_truncate(&stack, 0);
+    TEST_ASSERT_TRUE(arena_stack_is_empty(&stack));
+
+    // Filling it again to the same depth allocates nothing new
+    const ArenaStats before = arena_stats(&arena);
+    for (int i = 0; i < 100; ++i) {
+        *(long *) arena_stack_push(&stack) = -i;
+    }
+    const ArenaStats after = arena_stats(&arena);
+    TEST_ASSERT_EQUAL(before.used_bytes, after.used_bytes);
+    TEST_ASSERT_EQUAL(-99, *(long *) arena_stack_top(&stack));
+    arena_destroy(&arena);
+}
+
+// A reserved arena stays in one chunk while it commits more of its range, and drops its pages on reset
+void test_arena_reserved_commits_on_demand(void) {
+    const ArenaOptions options = {.reserve_size = 64 * 1024 * 1024};
+    Arena arena = arena_create_with_options(4096, &options);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    TEST_ASSERT_TRUE(is_aligned(arena.start, MAX_ALIGNMENT));
+    const size_t first_commit = arena.total_size;
+    TEST_ASSERT_GREATER_OR_EQUAL(4096, first_commit);
+    for (int i = 0; i < 16; ++i) {
+        char *block = arena_alloc(&arena, 1024 * 1024);
+        TEST_ASSERT_NOT_NULL(block);
+        memset(block, 0xAB, 1024 * 1024); // Committed memory is writable
+    }
+    TEST_ASSERT_EQUAL(1, arena.chunk_count);
+    TEST_ASSERT_GREATER_OR_EQUAL(16 * 1024 * 1024, arena.total_size);
+    TEST_ASSERT_EQUAL(arena.total_size, arena_stats(&arena).reserved_bytes); // Only the committed part counts
+
+    arena_reset(&arena);
+    const unsigned char *again = arena_alloc(&arena, 8 * 1024 * 1024);
+    TEST_ASSERT_NOT_NULL(again);
+    TEST_ASSERT_EQUAL(0, again[0]);
+    TEST_ASSERT_EQUAL(0, again[5 * 1024 * 1024 + 3]); // Dropped pages come back zeroed
+
+    // Past the reservation a second range is chained in
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 60 * 1024 * 1024));
+    TEST_ASSERT_EQUAL(2, arena.chunk_count);
+    arena_destroy(&arena);
+
+    const ArenaOptions huge = {.reserve_size = 8 * 1024 * 1024, .huge_pages = true};
+    arena = arena_create_with_options(100, &huge);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 3 * 1024 * 1024));
+    TEST_ASSERT_EQUAL(1, arena.chunk_count);
+    arena_destroy(&arena);
+}
+
+// Tagged allocations are ordinary allocations; only CLERIC_ARENA_TAGS builds count them per tag
+static void test_arena_alloc_tagged_counts_per_tag(void) {
+    Arena arena = arena_create(1024);
+    TEST_ASSERT_NOT_NULL(arena_alloc_tagged(&arena, 100, ARENA_TAG_TAC));
+    TEST_ASSERT_NOT_NULL(arena_alloc_tagged(&arena, 28, ARENA_TAG_TAC));
+    TEST_ASSERT_NOT_NULL(arena_alloc_tagged(&arena, 10, ARENA_TAG_AST));
+    TEST_ASSERT_NOT_NULL(arena_alloc(&arena, 7));
+    arena_note_superseded(&arena, 100, ARENA_TAG_TAC);
+    TEST_ASSERT_EQUAL(4, arena_stats(&arena).alloc_count);
+    TEST_ASSERT_EQUAL(145, arena_stats(&arena).alloc_bytes);
+
+    ArenaTagStats tags[ARENA_TAG_COUNT];
+#ifdef CLERIC_ARENA_TAGS
+    TEST_ASSERT_TRUE(arena_tag_stats(&arena, tags));
+    TEST_ASSERT_EQUAL(2, tags[ARENA_TAG_TAC].alloc_count);
+    TEST_ASSERT_EQUAL(128, tags[ARENA_TAG_TAC].alloc_bytes);
+    TEST_ASSERT_EQUAL(100, tags[ARENA_TAG_TAC].superseded_bytes);
+    TEST_ASSERT_EQUAL(10, tags[ARENA_TAG_AST].alloc_bytes);
+    TEST_ASSERT_EQUAL(0, tags[ARENA_TAG_STRINGS].alloc_count);
+    arena_reset(&arena);
+    TEST_ASSERT_TRUE(arena_tag_stats(&arena, tags));
+    TEST_ASSERT_EQUAL(0, tags[ARENA_TAG_TAC].alloc_bytes); // Reset with the other counters
+#else
+    TEST_ASSERT_FALSE(arena_tag_stats(&arena, tags));
+    TEST_ASSERT_EQUAL(0, tags[ARENA_TAG_TAC].alloc_count);
+#endif
+    TEST_ASSERT_EQUAL_STRING("tac", arena_tag_name(ARENA_TAG_TAC));
+    TEST_ASSERT_EQUAL_STRING("untagged", arena_tag_name(ARENA_TAG_COUNT));
+    arena_destroy(&arena);
+}
+
 // --- Test Runner Function ---
 // This function will be called by the main test runner (test_all.c)
 void run_arena_tests(void) {
@@ -152,6 +440,18 @@ void run_arena_tests(void) {
     RUN_TEST(test_arena_alloc_basic);
     RUN_TEST(test_arena_alloc_multiple);
     RUN_TEST(test_arena_alloc_alignment);
-    RUN_TEST(test_arena_alloc_out_of_memory);
+    RUN_TEST(test_arena_alloc_grows_new_chunk);
+    RUN_TEST(test_arena_alloc_larger_than_growth);
+    RUN_TEST(test_arena_stats);
+    RUN_TEST(test_arena_stats_counts_allocations);
+    RUN_TEST(test_arena_reserved_commits_on_demand);
+    RUN_TEST(test_arena_alloc_tagged_counts_per_tag);
     RUN_TEST(test_arena_reset);
+    RUN_TEST(test_arena_mark_release_same_chunk);
+    RUN_TEST(test_arena_mark_release_frees_new_chunks);
+    RUN_TEST(test_arena_release_foreign_mark_leaves_arena_untouched);
+    RUN_TEST(test_arena_reset_zeroes_up_to_high_water);
+    RUN_TEST(test_arena_reset_dirty_keeps_contents);
+    RUN_TEST(test_arena_stack_push_pop_across_chunks);
+    RUN_TEST(test_arena_stack_reuses_chunks_and_truncates);
 }
@@ -164,6 +164,173 @@ void test_parse_args_codegen_only_missing_file(void) {
     TEST_ASSERT_FALSE(codegen_only);
 }
 
+void test_parse_args_with_options_time_report(void) {
+    char *argv[] = {"cleric", "--time-report", "prog.c"};
+    CompileOptions options;
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv, &options));
+    TEST_ASSERT_EQUAL(TIME_REPORT_TEXT, options.time_report);
+    TEST_ASSERT_FALSE(compile_options_stops_early(&options));
+
+    // Report options combine with a stage option, in any order
+    char *argv_json[] = {"cleric", "prog.c", "--codegen", "--time-report=json"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_json, &options));
+    TEST_ASSERT_EQUAL(TIME_REPORT_JSON, options.time_report);
+    TEST_ASSERT_TRUE(options.codegen_only);
+    TEST_ASSERT_TRUE(compile_options_stops_early(&options));
+    TEST_ASSERT_NULL(options.trace_path);
+
+    char *argv_trace[] = {"cleric", "--trace=out.json", "prog.c", "--time-report"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_trace, &options));
+    TEST_ASSERT_EQUAL_STRING("out.json", options.trace_path);
+    TEST_ASSERT_EQUAL(TIME_REPORT_TEXT, options.time_report);
+}
+
+void test_parse_args_with_options_rejects_invalid(void) {
+    CompileOptions options;
+    char *argv_format[] = {"cleric", "--time-report=xml", "prog.c"};
+    TEST_ASSERT_NULL(parse_args_with_options(3, argv_format, &options));
+    TEST_ASSERT_EQUAL(TIME_REPORT_NONE, options.time_report);
+
+    char *argv_empty_trace[] = {"cleric", "--trace=", "prog.c"};
+    TEST_ASSERT_NULL(parse_args_with_options(3, argv_empty_trace, &options));
+
+    char *argv_two_stages[] = {"cleric", "--lex", "--parse", "prog.c"};
+    TEST_ASSERT_NULL(parse_args_with_options(4, argv_two_stages, &options));
+    TEST_ASSERT_FALSE(options.lex_only); // Options are reset on failure
+    TEST_ASSERT_FALSE(options.parse_only);
+
+    char *argv_no_file[] = {"cleric", "--time-report"};
+    TEST_ASSERT_NULL(parse_args_with_options(2, argv_no_file, &options));
+}
+
+void test_parse_args_with_options_optimization_level(void) {
+    CompileOptions options;
+    char *argv_default[] = {"cleric", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(2, argv_default, &options));
+    TEST_ASSERT_EQUAL(0, options.optimization_level);
+
+    char *argv_o1[] = {"cleric", "-O1", "--codegen", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_o1, &options));
+    TEST_ASSERT_EQUAL(1, options.optimization_level);
+    TEST_ASSERT_TRUE(options.codegen_only);
+
+    // The last level wins, and unsupported levels are rejected
+    char *argv_o0[] = {"cleric", "-O1", "prog.c", "-O0"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_o0, &options));
+    TEST_ASSERT_EQUAL(0, options.optimization_level);
+
+    char *argv_o3[] = {"cleric", "-O3", "prog.c"};
+    TEST_ASSERT_NULL(parse_args_with_options(3, argv_o3, &options));
+    TEST_ASSERT_EQUAL(0, options.optimization_level);
+
+    char *argv_no_peephole[] = {"cleric", "-O1", "--no-peephole", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_no_peephole, &options));
+    TEST_ASSERT_TRUE(options.no_peephole);
+    TEST_ASSERT_FALSE(options.codegen_only); // Not a stage option
+    TEST_ASSERT_FALSE(options.no_omit_frame_pointer);
+
+    char *argv_frame_pointer[] = {"cleric", "-O1", "--no-omit-frame-pointer", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_frame_pointer, &options));
+    TEST_ASSERT_TRUE(options.no_omit_frame_pointer);
+
+    char *argv_lex_thread[] = {"cleric", "--lex-thread", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv_lex_thread, &options));
+    TEST_ASSERT_TRUE(options.lex_thread);
+
+    char *argv_flat_ast[] = {"cleric", "--flat-ast", "--tac", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_flat_ast, &options));
+    TEST_ASSERT_TRUE(options.flat_ast);
+    TEST_ASSERT_TRUE(options.tac_only);
+    TEST_ASSERT_FALSE(options.fuse_validation);
+
+    char *argv_fused[] = {"cleric", "--fuse-validation", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv_fused, &options));
+    TEST_ASSERT_TRUE(options.fuse_validation);
+    TEST_ASSERT_FALSE(options.flat_ast);
+
+    char *argv_pipe[] = {"cleric", "--pipe", "-O1", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_pipe, &options));
+    TEST_ASSERT_TRUE(options.pipe);
+    TEST_ASSERT_FALSE(options.fuse_validation);
+
+    char *argv_stream[] = {"cleric", "--stream", "-"};
+    TEST_ASSERT_EQUAL_STRING("-", parse_args_with_options(3, argv_stream, &options));
+    TEST_ASSERT_TRUE(options.stream);
+    TEST_ASSERT_TRUE(options.pipe);
+
+    char *argv_emit_obj[] = {"cleric", "--emit-obj", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv_emit_obj, &options));
+    TEST_ASSERT_TRUE(options.emit_obj);
+    TEST_ASSERT_FALSE(options.pipe);
+
+    char *argv_emit_tac[] = {"cleric", "--emit-tac", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv_emit_tac, &options));
+    TEST_ASSERT_TRUE(options.emit_tac);
+    TEST_ASSERT_FALSE(options.emit_obj);
+
+    char *argv_run[] = {"cleric", "--run", "-O1", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(4, argv_run, &options));
+    TEST_ASSERT_TRUE(options.run);
+    TEST_ASSERT_EQUAL_INT(1, options.optimization_level);
+    TEST_ASSERT_FALSE(options.emit_obj);
+    TEST_ASSERT_FALSE(options.interpret);
+
+    char *argv_interpret[] = {"cleric", "--interpret", "prog.c"};
+    TEST_ASSERT_EQUAL_STRING("prog.c", parse_args_with_options(3, argv_interpret, &options));
+    TEST_ASSERT_TRUE(options.interpret);
+    TEST_ASSERT_FALSE(options.run);
+
+    // Several inputs and -j: only parse_args_with_inputs takes more than one file
+    char *argv_jobs[] = {"cleric", "-j", "8", "a.c", "--quiet", "b.c", "-j3", "c.c"};
+    const char *inputs[8];
+    TEST_ASSERT_EQUAL_size_t(3, parse_args_with_inputs(8, argv_jobs, &options, inputs));
+    TEST_ASSERT_EQUAL_STRING("a.c", inputs[0]);
+    TEST_ASSERT_EQUAL_STRING("b.c", inputs[1]);
+    TEST_ASSERT_EQUAL_STRING("c.c", inputs[2]);
+    TEST_ASSERT_EQUAL_INT(3, options.jobs);
+    TEST_ASSERT_TRUE(options.quiet);
+    TEST_ASSERT_NULL(parse_args_with_options(8, argv_jobs, &options));
+    TEST_ASSERT_EQUAL_INT(1, options.jobs);
+
+    char *argv_bad_jobs[] = {"cleric", "-j0", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_bad_jobs, &options, inputs));
+    char *argv_missing_jobs[] = {"cleric", "a.c", "-j"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_missing_jobs, &options, inputs));
+
+    char *argv_function_jobs[] = {"cleric", "--function-jobs=6", "a.c"};
+    TEST_ASSERT_NOT_NULL(parse_args_with_options(3, argv_function_jobs, &options));
+    TEST_ASSERT_EQUAL_INT(6, options.function_jobs);
+    char *argv_bad_function_jobs[] = {"cleric", "--function-jobs=x", "a.c"};
+    TEST_ASSERT_NULL(parse_args_with_options(3, argv_bad_function_jobs, &options));
+
+    // A server takes no input file; a client takes any number
+    char *argv_server[] = {"cleric", "--server=/tmp/cleric.sock", "--quiet"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_server, &options, inputs));
+    TEST_ASSERT_EQUAL_STRING("/tmp/cleric.sock", options.server_socket);
+    char *argv_server_with_input[] = {"cleric", "--server=/tmp/cleric.sock", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_server_with_input, &options, inputs));
+    TEST_ASSERT_NULL(options.server_socket);
+    char *argv_connect[] = {"cleric", "--connect=/tmp/cleric.sock", "-j", "2", "a.c", "b.c"};
+    TEST_ASSERT_EQUAL_size_t(2, parse_args_with_inputs(6, argv_connect, &options, inputs));
+    TEST_ASSERT_EQUAL_STRING("/tmp/cleric.sock", options.connect_socket);
+    char *argv_empty_connect[] = {"cleric", "--connect=", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_empty_connect, &options, inputs));
+
+    char *argv_cache[] = {"cleric", "--cache-dir=.cache", "--cache-max-mb=16", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(1, parse_args_with_inputs(4, argv_cache, &options, inputs));
+    TEST_ASSERT_EQUAL_STRING(".cache", options.cache_dir);
+    TEST_ASSERT_EQUAL_size_t((size_t) 16 * 1024 * 1024, options.cache_max_bytes);
+    char *argv_bad_cache[] = {"cleric", "--cache-max-mb=0", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_bad_cache, &options, inputs));
+
+    char *argv_arena[] = {"cleric", "--arena-reserve-mb=512", "--huge-pages", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(1, parse_args_with_inputs(4, argv_arena, &options, inputs));
+    TEST_ASSERT_EQUAL_size_t((size_t) 512 * 1024 * 1024, options.arena_reserve_bytes);
+    TEST_ASSERT_TRUE(options.huge_pages);
+    char *argv_bad_arena[] = {"cleric", "--arena-reserve-mb=lots", "a.c"};
+    TEST_ASSERT_EQUAL_size_t(0, parse_args_with_inputs(3, argv_bad_arena, &options, inputs));
+}
+
 void run_main_args_tests(void) {
     RUN_TEST(test_parse_args_no_args);
     RUN_TEST(test_parse_args_too_many_args);
@@ -175,4 +342,7 @@ void run_main_args_tests(void) {
     RUN_TEST(test_parse_args_parse_only_missing_file);
     RUN_TEST(test_parse_args_codegen_only_valid);
     RUN_TEST(test_parse_args_codegen_only_missing_file);
+    RUN_TEST(test_parse_args_with_options_time_report);
+    RUN_TEST(test_parse_args_with_options_rejects_invalid);
+    RUN_TEST(test_parse_args_with_options_optimization_level);
 }
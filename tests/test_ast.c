@@ -341,6 +341,35 @@ static void test_ast_pretty_print_new_nodes(void) {
 }
 
 // Runner function for AST tests
+// Builds `int <name>(void) { int x = <value>; return x + 1; }`
+static FuncDefNode *build_fingerprinted_function(const char *name, const int value, Arena *arena) {
+    BlockNode *body = create_block_node(arena);
+    block_node_add_item(body, (AstNode *) create_var_decl_node("int", "x",
+                                                               (AstNode *) create_int_literal_node(value, arena),
+                                                               arena), arena);
+    AstNode *sum = (AstNode *) create_binary_op_node(OPERATOR_ADD, (AstNode *) create_identifier_node("x", arena),
+                                                     (AstNode *) create_int_literal_node(1, arena), arena);
+    block_node_add_item(body, (AstNode *) create_return_stmt_node(sum, arena), arena);
+    return create_func_def_node(name, body, arena);
+}
+
+static void test_ast_fingerprint_is_structural(void) {
+    Arena test_arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    // Separately built copies (names at different addresses) fingerprint alike
+    const AstFingerprint a = ast_fingerprint((AstNode *) build_fingerprinted_function("main", 5, &test_arena));
+    const AstFingerprint b = ast_fingerprint((AstNode *) build_fingerprinted_function("main", 5, &test_arena));
+    TEST_ASSERT_TRUE(ast_fingerprint_equal(a, b));
+
+    // Any change to a literal, a name or the function's name shows
+    const AstFingerprint other_value = ast_fingerprint((AstNode *) build_fingerprinted_function("main", 6, &test_arena));
+    const AstFingerprint other_name = ast_fingerprint((AstNode *) build_fingerprinted_function("mainx", 5, &test_arena));
+    TEST_ASSERT_FALSE(ast_fingerprint_equal(a, other_value));
+    TEST_ASSERT_FALSE(ast_fingerprint_equal(a, other_name));
+    TEST_ASSERT_FALSE(ast_fingerprint_equal(a, ast_fingerprint(NULL)));
+    arena_destroy(&test_arena);
+}
+
 void run_ast_tests(void) {
     RUN_TEST(test_create_int_literal);
     RUN_TEST(test_create_return_stmt);
@@ -359,4 +388,5 @@ void run_ast_tests(void) {
     RUN_TEST(test_block_node_add_items);
     RUN_TEST(test_create_func_def_with_block_body);
     RUN_TEST(test_ast_pretty_print_new_nodes);
+    RUN_TEST(test_ast_fingerprint_is_structural);
 }
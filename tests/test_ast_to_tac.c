@@ -4,6 +4,10 @@
 #include "ir/tac.h"
 #include "memory/arena.h"
 #include "parser/ast.h"
+#include "parser/flat_ast.h"
+#include "parser/parser.h"
+#include "compiler/compiler.h"
+#include "validator/validator.h"
 #include <string.h> // For strcmp
 
 // Forward declarations for test functions
@@ -37,6 +41,21 @@ static void test_return_logical_or_rhs_evaluates(void);
 // Test returning the result of a logical OR operation (short-circuit)
 static void test_return_logical_or_short_circuit(void);
 
+// Test that the fused validate+lower pass emits the same TAC as ast_to_tac without variables
+static void test_fused_matches_separate_passes(void);
+
+// Test that the fused pass keeps each variable in the temp its declaration got
+static void test_fused_lowers_variables_to_temps(void);
+
+// Test that the fused pass rejects what the validator rejects
+static void test_fused_reports_semantic_errors(void);
+
+// Test that statements after a return are checked but emit nothing
+static void test_fused_drops_code_after_return(void);
+
+// Test --fuse-validation end to end
+static void test_compile_with_fused_validation(void);
+
 // Add more test function declarations here...
 
 
@@ -67,8 +86,8 @@ static void test_return_int_literal(void) {
     // Check the RETURN instruction
     const TacInstruction *instr = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(5, instr->operands.ret.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(5, tac_src(instr).value.constant_value);
 
     // Clean up arena
     arena_destroy(&test_arena);
@@ -100,16 +119,16 @@ static void test_return_unary_negate(void) {
     // Check the NEGATE instruction (t0 = - 10)
     const TacInstruction *instr0 = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NEGATE, instr0->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0->operands.unary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.unary_op.dst.value.temp_id); // First temporary t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.unary_op.src.type);
-    TEST_ASSERT_EQUAL_INT(10, instr0->operands.unary_op.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0).value.temp_id); // First temporary t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr0).type);
+    TEST_ASSERT_EQUAL_INT(10, tac_src(instr0).value.constant_value);
 
     // Check the RETURN instruction (RETURN t0)
     const TacInstruction *instr1 = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr1->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1->operands.ret.src.value.temp_id); // Should return t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1).value.temp_id); // Should return t0
 
     // Clean up arena
     arena_destroy(&test_arena);
@@ -141,16 +160,16 @@ static void test_return_unary_complement(void) {
     // Check the COMPLEMENT instruction (t0 = ~ 20)
     const TacInstruction *instr0_comp = &func_comp->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COMPLEMENT, instr0_comp->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0_comp->operands.unary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0_comp->operands.unary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0_comp->operands.unary_op.src.type);
-    TEST_ASSERT_EQUAL_INT(20, instr0_comp->operands.unary_op.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0_comp).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0_comp).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr0_comp).type);
+    TEST_ASSERT_EQUAL_INT(20, tac_src(instr0_comp).value.constant_value);
 
     // Check the RETURN instruction (RETURN t0)
     const TacInstruction *instr1_comp = &func_comp->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr1_comp->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1_comp->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1_comp->operands.ret.src.value.temp_id);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1_comp).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1_comp).value.temp_id);
 
     // Clean up arena
     arena_destroy(&test_arena);
@@ -184,24 +203,24 @@ static void test_return_unary_complement_negate(void) {
     // Check the NEGATE instruction (t0 = -2)
     const TacInstruction *instr0 = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NEGATE, instr0->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0->operands.unary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.unary_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.unary_op.src.type);
-    TEST_ASSERT_EQUAL_INT(2, instr0->operands.unary_op.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr0).type);
+    TEST_ASSERT_EQUAL_INT(2, tac_src(instr0).value.constant_value);
 
     // Check the COMPLEMENT instruction (t1 = ~t0)
     const TacInstruction *instr1 = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COMPLEMENT, instr1->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.unary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(1, instr1->operands.unary_op.dst.value.temp_id); // t1
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.unary_op.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1->operands.unary_op.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr1).type);
+    TEST_ASSERT_EQUAL_INT(1, tac_dst(instr1).value.temp_id); // t1
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1).value.temp_id); // t0
 
     // Check the RETURN instruction (RETURN t1)
     const TacInstruction *instr2 = &func->instructions[2];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr2->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr2->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(1, instr2->operands.ret.src.value.temp_id); // t1
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr2).type);
+    TEST_ASSERT_EQUAL_INT(1, tac_src(instr2).value.temp_id); // t1
 
     // Clean up arena
     arena_destroy(&test_arena);
@@ -236,18 +255,18 @@ static void test_return_binary_add_literals(void) {
     // Check the ADD instruction (t0 = 5 + 3)
     const TacInstruction *instr0 = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_ADD, instr0->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0->operands.binary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.binary_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.binary_op.src1.type);
-    TEST_ASSERT_EQUAL_INT(5, instr0->operands.binary_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.binary_op.src2.type);
-    TEST_ASSERT_EQUAL_INT(3, instr0->operands.binary_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr0).type);
+    TEST_ASSERT_EQUAL_INT(5, tac_src1(instr0).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr0).type);
+    TEST_ASSERT_EQUAL_INT(3, tac_src2(instr0).value.constant_value);
 
     // Check the RETURN instruction (RETURN t0)
     const TacInstruction *instr1 = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr1->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1).value.temp_id); // t0
 
     // Clean up arena
     arena_destroy(&test_arena);
@@ -279,16 +298,16 @@ static void test_return_logical_not(void) {
     // Check the LOGICAL_NOT instruction (t0 = ! 0)
     const TacInstruction *instr0 = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LOGICAL_NOT, instr0->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0->operands.unary_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.unary_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.unary_op.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.unary_op.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr0).value.constant_value);
 
     // Check the RETURN instruction (RETURN t0)
     const TacInstruction *instr1 = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr1->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
@@ -321,18 +340,18 @@ static void test_return_relational_less(void) {
     // Check the LESS instruction (t0 = 3 < 5)
     const TacInstruction *instr0 = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LESS, instr0->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr0->operands.relational_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(0, instr0->operands.relational_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.relational_op.src1.type);
-    TEST_ASSERT_EQUAL_INT(3, instr0->operands.relational_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr0->operands.relational_op.src2.type);
-    TEST_ASSERT_EQUAL_INT(5, instr0->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr0).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(instr0).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr0).type);
+    TEST_ASSERT_EQUAL_INT(3, tac_src1(instr0).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr0).type);
+    TEST_ASSERT_EQUAL_INT(5, tac_src2(instr0).value.constant_value);
 
     // Check the RETURN instruction (RETURN t0)
     const TacInstruction *instr1 = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr1->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr1->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr1->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr1).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr1).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
@@ -369,53 +388,53 @@ static void test_return_logical_and_rhs_evaluates(void) {
     // instr[0]: if_false const 1 goto L0
     instr = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_IF_FALSE_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.conditional_goto.condition_src.type); // LHS is const 1
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.conditional_goto.condition_src.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.conditional_goto.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L0", instr->operands.conditional_goto.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type); // LHS is const 1
+    TEST_ASSERT_EQUAL_INT(1, tac_src(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(instr).value.label_id);
 
     // instr[1]: t0 = (rhs_result != 0)  (e.g. t0 = (const 0 != const 0) -> t0 = 0)
     // Original AST: 1 && 0. So rhs_result is const 0.
     instr = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NOT_EQUAL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.relational_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.relational_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src1.type); // rhs_result (const 0)
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src2.type); // const 0 to compare against
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr).type); // rhs_result (const 0)
+    TEST_ASSERT_EQUAL_INT(0, tac_src1(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr).type); // const 0 to compare against
+    TEST_ASSERT_EQUAL_INT(0, tac_src2(instr).value.constant_value);
 
     // instr[2]: goto L1
     instr = &func->instructions[2];
     TEST_ASSERT_EQUAL_INT(TAC_INS_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.go_to.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.go_to.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[3]: L0:
     instr = &func->instructions[3];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L0", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(instr).value.label_id);
 
     // instr[4]: t0 = 0 (dest_temp = false)
     instr = &func->instructions[4];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.copy.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.copy.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.copy.src.type); // Assigning constant 0
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.copy.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type); // Assigning constant 0
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr).value.constant_value);
 
     // instr[5]: L1:
     instr = &func->instructions[5];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[6]: return t0
     instr = &func->instructions[6];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_src(instr).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
@@ -452,54 +471,54 @@ static void test_return_logical_and_short_circuit(void) {
     // instr[0]: if_false const 0 goto L0
     instr = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_IF_FALSE_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.conditional_goto.condition_src.type); // LHS is const 0
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.conditional_goto.condition_src.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.conditional_goto.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L0", instr->operands.conditional_goto.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type); // LHS is const 0
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(instr).value.label_id);
 
     // instr[1]: t0 = (rhs_result != 0) (e.g. t0 = (const 1 != const 0) -> t0 = 1)
     // This instruction is generated but skipped due to short-circuiting for 0 && 1.
     // Original AST: 0 && 1. So rhs_result is const 1.
     instr = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NOT_EQUAL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.relational_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.relational_op.dst.value.temp_id); // t0 (dest_temp)
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src1.type); // rhs_result (const 1)
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.relational_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src2.type); // const 0 to compare against
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0 (dest_temp)
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr).type); // rhs_result (const 1)
+    TEST_ASSERT_EQUAL_INT(1, tac_src1(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr).type); // const 0 to compare against
+    TEST_ASSERT_EQUAL_INT(0, tac_src2(instr).value.constant_value);
 
     // instr[2]: goto L1
     instr = &func->instructions[2];
     TEST_ASSERT_EQUAL_INT(TAC_INS_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.go_to.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.go_to.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[3]: L0:
     instr = &func->instructions[3];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L0", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(0, tac_label(instr).value.label_id);
 
     // instr[4]: t0 = 0 (dest_temp = false - this path is taken)
     instr = &func->instructions[4];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.copy.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.copy.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.copy.src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.copy.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr).value.constant_value);
 
     // instr[5]: L1:
     instr = &func->instructions[5];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[6]: return t0
     instr = &func->instructions[6];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_src(instr).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
@@ -535,52 +554,52 @@ static void test_return_logical_or_rhs_evaluates(void) {
     // instr[0]: if_true const 0 goto L_true_exit (L1)
     instr = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_IF_TRUE_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.conditional_goto.condition_src.type);
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.conditional_goto.condition_src.value.constant_value); // LHS is const 0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.conditional_goto.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.conditional_goto.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(instr).value.constant_value); // LHS is const 0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[1]: t0 = (rhs_result != 0) (e.g. t0 = (const 1 != const 0) -> t0 = 1)
     instr = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NOT_EQUAL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.relational_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.relational_op.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src1.type); // rhs_result (const 1)
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.relational_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src2.type); // const 0 to compare against
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr).type); // rhs_result (const 1)
+    TEST_ASSERT_EQUAL_INT(1, tac_src1(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr).type); // const 0 to compare against
+    TEST_ASSERT_EQUAL_INT(0, tac_src2(instr).value.constant_value);
 
     // instr[2]: goto L_end (L2)
     instr = &func->instructions[2];
     TEST_ASSERT_EQUAL_INT(TAC_INS_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.go_to.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L2", instr->operands.go_to.target_label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(instr).value.label_id);
 
     // instr[3]: L_true_exit: (L1)
     instr = &func->instructions[3];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[4]: t0 = 1 (if LHS was true path)
     instr = &func->instructions[4];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.copy.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.copy.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.copy.src.type);
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.copy.src.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(1, tac_src(instr).value.constant_value);
 
     // instr[5]: L_end: (L2)
     instr = &func->instructions[5];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L2", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(instr).value.label_id);
 
     // instr[6]: return t0
     instr = &func->instructions[6];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_src(instr).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
@@ -616,57 +635,244 @@ static void test_return_logical_or_short_circuit(void) {
     // instr[0]: if_true const 1 goto L_true_exit (L1)
     instr = &func->instructions[0];
     TEST_ASSERT_EQUAL_INT(TAC_INS_IF_TRUE_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.conditional_goto.condition_src.type);
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.conditional_goto.condition_src.value.constant_value); // LHS is const 1
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.conditional_goto.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.conditional_goto.target_label.value.label_name); // L_true_exit
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(1, tac_src(instr).value.constant_value); // LHS is const 1
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id); // L_true_exit
 
     // Path for 1 || 0 (LHS is true, short-circuits):
     // instr[1]: t0 = (const 0 != const 0) -> t0 = 0 (Generated, but skipped. RHS is 0)
     instr = &func->instructions[1];
     TEST_ASSERT_EQUAL_INT(TAC_INS_NOT_EQUAL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.relational_op.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.relational_op.dst.value.temp_id); // t0 (dest_temp)
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src1.type); // rhs_result (const 0)
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.relational_op.src2.type); // const 0 to compare against
-    TEST_ASSERT_EQUAL_INT(0, instr->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0 (dest_temp)
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src1(instr).type); // rhs_result (const 0)
+    TEST_ASSERT_EQUAL_INT(0, tac_src1(instr).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src2(instr).type); // const 0 to compare against
+    TEST_ASSERT_EQUAL_INT(0, tac_src2(instr).value.constant_value);
 
     // instr[2]: goto L_end (L2) (Generated, but skipped)
     instr = &func->instructions[2];
     TEST_ASSERT_EQUAL_INT(TAC_INS_GOTO, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.go_to.target_label.type);
-    TEST_ASSERT_EQUAL_STRING("L2", instr->operands.go_to.target_label.value.label_name); // L_end_logical_or is L2
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(instr).value.label_id); // L_end_logical_or is L2
 
     // instr[3]: L_true_exit: (L1)
     instr = &func->instructions[3];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L1", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(1, tac_label(instr).value.label_id);
 
     // instr[4]: t0 = 1 (Executed, because LHS was true)
     instr = &func->instructions[4];
     TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.copy.dst.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.copy.dst.value.temp_id); // t0
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, instr->operands.copy.src.type);
-    TEST_ASSERT_EQUAL_INT(1, instr->operands.copy.src.value.constant_value); // Assign 1 because LHS was true
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_dst(instr).value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_CONST, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(1, tac_src(instr).value.constant_value); // Assign 1 because LHS was true
 
     // instr[5]: L_end: (L2)
     instr = &func->instructions[5];
     TEST_ASSERT_EQUAL_INT(TAC_INS_LABEL, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING("L2", instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(2, tac_label(instr).value.label_id);
 
     // instr[6]: return t0
     instr = &func->instructions[6];
     TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr->type);
-    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, instr->operands.ret.src.type);
-    TEST_ASSERT_EQUAL_INT(temp_id_dest, instr->operands.ret.src.value.temp_id); // t0
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(instr).type);
+    TEST_ASSERT_EQUAL_INT(temp_id_dest, tac_src(instr).value.temp_id); // t0
 
     arena_destroy(&test_arena);
 }
 
+// --- Fused validation and lowering ---
+
+static ProgramNode *parse_source(const char *source, Arena *arena) {
+    Lexer lexer;
+    Parser parser;
+    lexer_init(&lexer, source, arena);
+    parser_init(&parser, &lexer, arena);
+    ProgramNode *program = parse_program(&parser);
+    TEST_ASSERT_FALSE_MESSAGE(parser.error_flag, parser.error_message);
+    return program;
+}
+
+static const char *tac_text(const TacProgram *program, Arena *arena) {
+    TEST_ASSERT_NOT_NULL(program);
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 1024);
+    tac_print_program(&sb, program);
+    return string_buffer_content_str(&sb);
+}
+
+static void test_fused_matches_separate_passes(void) {
+    const char *sources[] = {
+        "int main(void) { return 1 + 2 * -3 % 4; }",
+        "int main(void) { { return (1 && 2) || !(3 < 4 && 5 != 6); } }",
+    };
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        Arena arena = arena_create(1024 * 16);
+        ProgramNode *program = parse_source(sources[i], &arena);
+        const FlatAst *flat = flat_ast_from_program(program, &arena);
+        const char *expected = tac_text(ast_to_tac(program, &arena), &arena);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, tac_text(ast_to_tac_fused(program, &arena), &arena), sources[i]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, tac_text(flat_ast_to_tac_fused(flat, &arena), &arena),
+                                         sources[i]);
+        arena_destroy(&arena);
+    }
+}
+
+static void test_fused_lowers_variables_to_temps(void) {
+    Arena arena = arena_create(1024 * 16);
+    ProgramNode *program =
+            parse_source("int main(void) { int a = 2; { int a = 3; a = a + 1; } int b; return a; }", &arena);
+    const TacProgram *tac_program = ast_to_tac_fused(program, &arena);
+    TEST_ASSERT_NOT_NULL(tac_program);
+    const TacFunction *func = tac_program->functions[0];
+    TEST_ASSERT_EQUAL(5, func->instruction_count);
+    const TacInstruction *instr = func->instructions;
+
+    // Outer a is t0, inner a is t1 and their sum t2; `int b;` takes t3 but emits nothing
+    TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr[0].type);
+    TEST_ASSERT_EQUAL_INT(0, tac_dst(&instr[0]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(2, tac_src(&instr[0]).value.constant_value);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr[1].type);
+    TEST_ASSERT_EQUAL_INT(1, tac_dst(&instr[1]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_ADD, instr[2].type);
+    TEST_ASSERT_EQUAL_INT(2, tac_dst(&instr[2]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(1, tac_src1(&instr[2]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, instr[3].type); // a = t2 stores into the inner a
+    TEST_ASSERT_EQUAL_INT(1, tac_dst(&instr[3]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(2, tac_src(&instr[3]).value.temp_id);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, instr[4].type); // The outer a again after the block
+    TEST_ASSERT_EQUAL_INT(TAC_OPERAND_TEMP, tac_src(&instr[4]).type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(&instr[4]).value.temp_id);
+
+    // The flat form resolves the same way
+    const FlatAst *flat = flat_ast_from_program(program, &arena);
+    TEST_ASSERT_EQUAL_STRING(tac_text(tac_program, &arena), tac_text(flat_ast_to_tac_fused(flat, &arena), &arena));
+    arena_destroy(&arena);
+}
+
+static void test_fused_reports_semantic_errors(void) {
+    const char *sources[] = {
+        "int main(void) { return b; }",
+        "int main(void) { int a; int a; return 0; }",
+        "int main(void) { int a; 1 = a; return 0; }",
+        "int main(void) { { int a; } return a; }",
+        "int main(void) { int a = 1; return a && (c = 2); }",
+        "int main(void) { return 0; return b; }",
+    };
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        Arena arena = arena_create(1024 * 16);
+        ProgramNode *program = parse_source(sources[i], &arena);
+        const FlatAst *flat = flat_ast_from_program(program, &arena);
+        TEST_ASSERT_FALSE_MESSAGE(validate_program((AstNode *) program, &arena), sources[i]);
+        TEST_ASSERT_NULL_MESSAGE(ast_to_tac_fused(program, &arena), sources[i]);
+        TEST_ASSERT_NULL_MESSAGE(flat_ast_to_tac_fused(flat, &arena), sources[i]);
+        arena_destroy(&arena);
+    }
+}
+
+static void test_fused_drops_code_after_return(void) {
+    Arena arena = arena_create(1024 * 16);
+    ProgramNode *program =
+            parse_source("int main(void) { int a = 2; { return a; a = 3; } int b = a && 1; return b; }", &arena);
+    const TacProgram *tac_program = ast_to_tac_fused(program, &arena);
+    TEST_ASSERT_NOT_NULL(tac_program);
+    const TacFunction *func = tac_program->functions[0];
+    TEST_ASSERT_EQUAL(2, func->instruction_count);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_COPY, func->instructions[0].type);
+    TEST_ASSERT_EQUAL_INT(TAC_INS_RETURN, func->instructions[1].type);
+    TEST_ASSERT_EQUAL_INT(0, tac_src(&func->instructions[1]).value.temp_id);
+
+    const FlatAst *flat = flat_ast_from_program(program, &arena);
+    TEST_ASSERT_EQUAL_STRING(tac_text(tac_program, &arena), tac_text(flat_ast_to_tac_fused(flat, &arena), &arena));
+    arena_destroy(&arena);
+}
+
+static void test_compile_with_fused_validation(void) {
+    Arena arena = arena_create(1024 * 64);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = 1;
+    StringBuffer separate_asm;
+    string_buffer_init(&separate_asm, &arena, 1024);
+    const char *source = "int main(void) { return (3 > 2 || 0) + -(4 / 2) * 5; }";
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &separate_asm, &arena, NULL));
+
+    options.fuse_validation = true;
+    StringBuffer fused_asm;
+    string_buffer_init(&fused_asm, &arena, 1024);
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &fused_asm, &arena, NULL));
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&separate_asm), string_buffer_content_str(&fused_asm));
+
+    // Semantic errors fail the compilation, and the validate phase no longer runs on its own
+    CompileStats stats;
+    TEST_ASSERT_FALSE(compile_with_options("int main(void) { return x; }", &options, &fused_asm, &arena, &stats));
+    TEST_ASSERT_FALSE(stats.phases[COMPILE_PHASE_VALIDATE].ran);
+    TEST_ASSERT_TRUE(stats.phases[COMPILE_PHASE_IRGEN].ran);
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { int x = 4; x = x * x; return x - 1; }", &options,
+                                          &fused_asm, &arena, NULL));
+    arena_destroy(&arena);
+}
+
+
+// Counts the instructions of a type in the program's only function
+static size_t count_instructions(const TacProgram *program, const TacInstructionType type) {
+    size_t count = 0;
+    const TacFunction *func = program->functions[0];
+    for (size_t i = 0; i < func->instruction_count; ++i) {
+        count += func->instructions[i].type == type;
+    }
+    return count;
+}
+
+static void test_branchless_logical_lowering(void) {
+    Arena arena = arena_create(1024 * 16);
+    const TacLoweringOptions options = {.fuse_validation = true, .branchless_logical = true};
+
+    // The && has a pure right operand and loses its branches; the || keeps them around a division
+    ProgramNode *program = parse_source("int main(void) { int a = 3; return a < 4 && -a != 0 || 8 / a; }", &arena);
+    const TacProgram *tac_program = ast_to_tac_with_options(program, &options, &arena);
+    TEST_ASSERT_NOT_NULL(tac_program);
+    TEST_ASSERT_EQUAL_size_t(1, count_instructions(tac_program, TAC_INS_LOGICAL_AND));
+    TEST_ASSERT_EQUAL_size_t(0, count_instructions(tac_program, TAC_INS_IF_FALSE_GOTO));
+    TEST_ASSERT_EQUAL_size_t(1, count_instructions(tac_program, TAC_INS_IF_TRUE_GOTO));
+    const FlatAst *flat = flat_ast_from_program(program, &arena);
+    TEST_ASSERT_EQUAL_STRING(tac_text(tac_program, &arena),
+                             tac_text(flat_ast_to_tac_with_options(flat, &options, &arena), &arena));
+
+    // An assignment on the right must still be skipped when the left decides
+    program = parse_source("int main(void) { int a = 0; int b = 1 || (a = 5); return a + b; }", &arena);
+    tac_program = ast_to_tac_with_options(program, &options, &arena);
+    TEST_ASSERT_NOT_NULL(tac_program);
+    TEST_ASSERT_EQUAL_size_t(0, count_instructions(tac_program, TAC_INS_LOGICAL_OR));
+    TEST_ASSERT_EQUAL_size_t(1, count_instructions(tac_program, TAC_INS_IF_TRUE_GOTO));
+
+    // Both lowerings compute the same values
+    const char *sources[] = {
+        "int main(void) { int a = 3; return a < 4 && -a != 0 || 8 / a; }",
+        "int main(void) { int a = 0; return a && a + 1 || !a && ~a; }",
+        "int main(void) { int a = 0; int b = 1 || (a = 5); return a + b; }",
+    };
+    const int expected[] = {1, 1, 1};
+    CompileOptions compile_options;
+    compile_options_init(&compile_options);
+    compile_options.quiet = true;
+    compile_options.fuse_validation = true;
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); ++i) {
+        for (int level = 0; level <= 1; ++level) {
+            compile_options.optimization_level = level;
+            int result = -1;
+            TEST_ASSERT_TRUE_MESSAGE(compile_and_run(sources[i], strlen(sources[i]), &compile_options, NULL, &result),
+                                     sources[i]);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(expected[i], result, sources[i]);
+        }
+    }
+    arena_destroy(&arena);
+}
 
 // --- Test Runner ---
 
@@ -682,5 +888,11 @@ void run_ast_to_tac_tests(void) {
     RUN_TEST(test_return_logical_and_short_circuit);
     RUN_TEST(test_return_logical_or_rhs_evaluates);
     RUN_TEST(test_return_logical_or_short_circuit);
+    RUN_TEST(test_fused_matches_separate_passes);
+    RUN_TEST(test_fused_lowers_variables_to_temps);
+    RUN_TEST(test_fused_reports_semantic_errors);
+    RUN_TEST(test_fused_drops_code_after_return);
+    RUN_TEST(test_compile_with_fused_validation);
+    RUN_TEST(test_branchless_logical_lowering);
     // Add more tests here...
 }
@@ -0,0 +1,107 @@
+#include "unity.h"
+#include "../src/ir/cfg.h"
+#include "../src/ir/tac.h"
+#include "../src/memory/arena.h"
+
+// --- Test Cases ---
+
+void test_cfg_empty_function(void) {
+    Arena arena = arena_create(1024);
+    TacFunction *func = create_tac_function("main", &arena);
+    Cfg cfg;
+    TEST_ASSERT_TRUE(cfg_build(func, &arena, &cfg));
+    TEST_ASSERT_EQUAL(0, cfg.block_count);
+    TEST_ASSERT_EQUAL(-1, cfg_block_for_label(&cfg, 0));
+    arena_destroy(&arena);
+}
+
+// The shape `a && b` lowers to:
+//   0: t0 = 1              B0
+//   1: if_false t0 goto L0
+//   2: t1 = 1              B1
+//   3: goto L1
+//   4: L0:                 B2
+//   5: t1 = 0
+//   6: L1:                 B3
+//   7: return t1
+void test_cfg_diamond_edges(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand l0 = create_tac_operand_label(0);
+    const TacOperand l1 = create_tac_operand_label(1);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(t0, l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_goto(l1, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(0), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l1, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t1, &arena), &arena);
+
+    Cfg cfg;
+    TEST_ASSERT_TRUE(cfg_build(func, &arena, &cfg));
+    TEST_ASSERT_EQUAL(4, cfg.block_count);
+    TEST_ASSERT_EQUAL(0, cfg.blocks[0].first);
+    TEST_ASSERT_EQUAL(1, cfg.blocks[0].last);
+    TEST_ASSERT_EQUAL(4, cfg.blocks[2].first);
+    TEST_ASSERT_EQUAL_UINT32(0, cfg.blocks[2].label);
+    TEST_ASSERT_EQUAL_UINT32(TAC_NO_LABEL, cfg.blocks[1].label);
+    TEST_ASSERT_EQUAL(3, cfg.block_of[7]);
+    TEST_ASSERT_EQUAL(1, cfg.block_of[3]);
+
+    // The conditional jump: target first, then fall-through
+    TEST_ASSERT_EQUAL(2, cfg.blocks[0].successor_count);
+    TEST_ASSERT_EQUAL(2, cfg.blocks[0].successors[0]);
+    TEST_ASSERT_EQUAL(1, cfg.blocks[0].successors[1]);
+    // goto L1 does not fall through into L0
+    TEST_ASSERT_EQUAL(1, cfg.blocks[1].successor_count);
+    TEST_ASSERT_EQUAL(3, cfg.blocks[1].successors[0]);
+    TEST_ASSERT_EQUAL(0, cfg.blocks[3].successor_count);
+
+    TEST_ASSERT_EQUAL(0, cfg.blocks[0].predecessor_count);
+    TEST_ASSERT_EQUAL(2, cfg.blocks[3].predecessor_count);
+    TEST_ASSERT_EQUAL(1, cfg.blocks[3].predecessors[0]);
+    TEST_ASSERT_EQUAL(2, cfg.blocks[3].predecessors[1]);
+
+    TEST_ASSERT_EQUAL(3, cfg_block_for_label(&cfg, 1));
+    TEST_ASSERT_EQUAL(-1, cfg_block_for_label(&cfg, 7)); // Past the highest label id
+    TEST_ASSERT_EQUAL(-1, cfg_block_for_label(&cfg, TAC_NO_LABEL));
+    arena_destroy(&arena);
+}
+
+// Code after a return starts a block nothing reaches
+void test_cfg_reachability(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand l0 = create_tac_operand_label(0);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_true_goto(t0, l0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, &arena), &arena); // Jump and fall-through meet
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(2), &arena), &arena);
+
+    Cfg cfg;
+    TEST_ASSERT_TRUE(cfg_build(func, &arena, &cfg));
+    TEST_ASSERT_EQUAL(3, cfg.block_count);
+    TEST_ASSERT_EQUAL(1, cfg.blocks[0].successor_count); // Both edges lead to L0: one edge
+    TEST_ASSERT_EQUAL(1, cfg.blocks[1].predecessor_count);
+    TEST_ASSERT_EQUAL(0, cfg.blocks[2].predecessor_count);
+
+    bool reachable[3];
+    TEST_ASSERT_TRUE(cfg_mark_reachable(&cfg, reachable, &arena));
+    TEST_ASSERT_TRUE(reachable[0]);
+    TEST_ASSERT_TRUE(reachable[1]);
+    TEST_ASSERT_FALSE(reachable[2]);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_cfg_tests(void) {
+    RUN_TEST(test_cfg_empty_function);
+    RUN_TEST(test_cfg_diamond_edges);
+    RUN_TEST(test_cfg_reachability);
+}
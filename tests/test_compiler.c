@@ -3,7 +3,10 @@
 #include "../src/parser/ast.h" // For AstNode type
 #include "../src/compiler/compiler.h" // Include the new compiler header
 #include "../src/memory/arena.h" // Needed for Arena
+#include "../src/compiler/function_cache.h"
 #include <stdlib.h> // For NULL
+#include <stdio.h> // For tmpfile
+#include <string.h> // For strstr
 
 
 // --- Test Cases ---
@@ -410,6 +413,283 @@ static void test_compile_complex_logical_and_short_circuit(void) {
 
 // --- Test Runner ---
 
+static void test_compile_with_options_collects_stats(void) {
+    Arena test_arena = arena_create(1024 * 8);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 256);
+    CompileOptions options;
+    compile_options_init(&options);
+    CompileStats stats;
+    const char *source = "int main(void) { return 1 + 2; }";
+
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &test_arena, &stats));
+    for (int i = 0; i < COMPILE_PHASE_COUNT; ++i) {
+        // The optimizer only runs at -O1 and above
+        TEST_ASSERT_EQUAL_MESSAGE(i != COMPILE_PHASE_OPTIMIZE, stats.phases[i].ran, compile_phase_name((CompilePhase) i));
+    }
+    TEST_ASSERT_EQUAL(strlen(source), stats.source_bytes);
+    TEST_ASSERT_EQUAL(13, stats.token_count); // int main ( void ) { return 1 + 2 ; } EOF
+    TEST_ASSERT_EQUAL(7, stats.ast_node_count); // Program, Function, Block, Return, BinaryOp, 2 literals
+    TEST_ASSERT_EQUAL(2, stats.tac_instruction_count); // t0 = 1 + 2; return t0
+    TEST_ASSERT_EQUAL(2, stats.optimized_tac_instruction_count); // Nothing optimized at -O0
+    TEST_ASSERT_GREATER_OR_EQUAL(stats.tac_instruction_count, stats.tac_instruction_capacity);
+    TEST_ASSERT_EQUAL(0, stats.tac_regrowth_count);
+    TEST_ASSERT_EQUAL(sb.length, stats.assembly_bytes);
+    TEST_ASSERT_GREATER_THAN(0, stats.phases[COMPILE_PHASE_PARSE].alloc_count);
+    TEST_ASSERT_GREATER_OR_EQUAL(stats.phases[COMPILE_PHASE_CODEGEN].retained_bytes, stats.arena_peak_bytes);
+
+    // Stopping early leaves the later phases unmeasured
+    options.parse_only = true;
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { return 0; }", &options, &sb, &test_arena, &stats));
+    TEST_ASSERT_TRUE(stats.phases[COMPILE_PHASE_PARSE].ran);
+    TEST_ASSERT_FALSE(stats.phases[COMPILE_PHASE_VALIDATE].ran);
+    TEST_ASSERT_EQUAL(0, stats.tac_instruction_count);
+
+    arena_destroy(&test_arena);
+}
+
+// A long expression gets its instruction array sized once, from the parser's node count
+static void test_compile_presizes_tac_from_ast(void) {
+    Arena test_arena = arena_create(1024 * 64);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 4096);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.tac_only = true;
+    char source[2048] = "int main(void) { return 1";
+    for (int i = 0; i < 200; ++i) {
+        strcat(source, i % 2 ? " * 3" : " - -2"); // Negations add instructions too
+    }
+    strcat(source, "; }");
+    CompileStats stats;
+
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &test_arena, &stats));
+    TEST_ASSERT_EQUAL(301, stats.tac_instruction_count); // 200 operators, 100 negations, the return
+    TEST_ASSERT_GREATER_OR_EQUAL(stats.tac_instruction_count, stats.tac_instruction_capacity);
+    TEST_ASSERT_EQUAL(0, stats.tac_regrowth_count);
+    arena_destroy(&test_arena);
+}
+
+// Builds `int main(void) { return <prefix * depth> 1 <suffix * depth>; }` in malloc'ed memory
+static char *nested_source(const char *prefix, const char *suffix, const int depth) {
+    const size_t prefix_len = strlen(prefix);
+    const size_t suffix_len = strlen(suffix);
+    char *source = malloc(64 + (prefix_len + suffix_len) * (size_t) depth);
+    TEST_ASSERT_NOT_NULL(source);
+    char *end = source + sprintf(source, "int main(void) { return ");
+    for (int i = 0; i < depth; ++i, end += prefix_len) memcpy(end, prefix, prefix_len);
+    *end++ = '1';
+    for (int i = 0; i < depth; ++i, end += suffix_len) memcpy(end, suffix, suffix_len);
+    strcpy(end, "; }");
+    return source;
+}
+
+// Parsing, validation and lowering walk expressions on explicit stacks, so nesting far
+// beyond what recursion on the C stack survives still compiles
+static void test_compile_deeply_nested_expressions(void) {
+    enum { DEPTH = 100000 };
+    const struct {
+        const char *prefix;
+        const char *suffix;
+        size_t tac_instructions;
+    } cases[] = {
+        {"(", ")", 1},              // return 1
+        {"- ", "", DEPTH + 1},      // One negation per level
+        {"2 - (", ")", DEPTH + 1},  // Right-nested subtraction
+        {"!(0 || ", ")", 7 * DEPTH + 1}, // Short-circuit labels at every level
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        Arena test_arena = arena_create(1024 * 1024);
+        StringBuffer sb;
+        string_buffer_init(&sb, &test_arena, 4096);
+        CompileOptions options;
+        compile_options_init(&options); // Full compilation: the stop-early stages also dump the AST
+        CompileStats stats;
+        char *source = nested_source(cases[c].prefix, cases[c].suffix, DEPTH);
+
+        TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &test_arena, &stats));
+        TEST_ASSERT_EQUAL(cases[c].tac_instructions, stats.tac_instruction_count);
+        free(source);
+        arena_destroy(&test_arena);
+    }
+}
+
+// Errors deep inside a nested expression are still reported, and the stacks unwound
+static void test_compile_deeply_nested_errors(void) {
+    Arena test_arena = arena_create(1024 * 1024);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 4096);
+    CompileOptions options;
+    compile_options_init(&options);
+    char *source = nested_source("(", "", 50000); // Missing every ')'
+    TEST_ASSERT_FALSE(compile_with_options(source, &options, &sb, &test_arena, NULL));
+    free(source);
+
+    source = nested_source("-(", " + x)", 50000); // x is undeclared
+    TEST_ASSERT_FALSE(compile_with_options(source, &options, &sb, &test_arena, NULL));
+    free(source);
+    arena_destroy(&test_arena);
+}
+
+// The lexer thread hands the parser the same tokens; its errors read as without it
+static void test_compile_with_lexer_thread(void) {
+    Arena test_arena = arena_create(1024 * 1024);
+    StringBuffer expected;
+    string_buffer_init(&expected, &test_arena, 4096);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 4096);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.quiet = true;
+    char *source = nested_source("2 - (", ")", 5000);
+    CompileStats expected_stats;
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &expected, &test_arena, &expected_stats));
+    options.lex_thread = true;
+    CompileStats stats;
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &sb, &test_arena, &stats));
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&expected), string_buffer_content_str(&sb));
+    TEST_ASSERT_EQUAL_size_t(expected_stats.token_count, stats.token_count);
+    TEST_ASSERT_EQUAL_size_t(expected_stats.ast_node_count, stats.ast_node_count);
+    free(source);
+
+    StringBuffer messages;
+    string_buffer_init(&messages, &test_arena, 256);
+    Diagnostics diagnostics;
+    diagnostics_init(&diagnostics, &messages);
+    OutputSink sink;
+    string_buffer_reset(&sb);
+    output_sink_init_buffer(&sink, &sb);
+    const char *unknown = "int main(void) { return 1 @ 2; }";
+    TEST_ASSERT_FALSE(cleric_compile(&options, unknown, strlen(unknown), &sink, &diagnostics));
+    TEST_ASSERT_EQUAL_size_t(1, diagnostics.error_count);
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&messages), "Lexical error: unknown token"));
+
+    source = nested_source("(", "", 50000); // Missing every ')': the parser gives up long before the lexer
+    TEST_ASSERT_FALSE(compile_with_options(source, &options, &sb, &test_arena, NULL));
+    free(source);
+    arena_destroy(&test_arena);
+}
+
+static void test_compile_stats_print_json(void) {
+    CompileStats stats = {0};
+    stats.phases[COMPILE_PHASE_LEX] = (PhaseStats){true, 1500, 3, 336, 1360};
+    stats.token_count = 22;
+
+    FILE *out = tmpfile();
+    TEST_ASSERT_NOT_NULL(out);
+    compile_stats_print(&stats, TIME_REPORT_JSON, out);
+    char buffer[512] = {0};
+    rewind(out);
+    TEST_ASSERT_GREATER_THAN(0, fread(buffer, 1, sizeof(buffer) - 1, out));
+    fclose(out);
+
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "{\"name\":\"lex\",\"wall_ns\":1500,\"alloc_count\":3"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"tokens\":22"));
+    TEST_ASSERT_NULL(strstr(buffer, "\"parse\"")); // Phases that did not run are omitted
+}
+
+static void test_compile_reuses_cached_function_assembly(void) {
+    FunctionCache cache;
+    TEST_ASSERT_TRUE(function_cache_init(&cache));
+    Arena arena = arena_create(1024 * 8);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.quiet = true;
+    options.optimization_level = 1;
+    options.function_cache = &cache;
+
+    // First compilation generates and stores; the same function (spelled differently) is then reused
+    const char *first = "int main(void) { int a = 3; return a * 4; }";
+    const char *same = "int main(void)\n{\n    int a = 3;\n    return (a * 4);\n}\n";
+    StringBuffer generated;
+    string_buffer_init(&generated, &arena, 256);
+    CompileStats stats;
+    TEST_ASSERT_TRUE(compile_with_options(first, &options, &generated, &arena, &stats));
+    TEST_ASSERT_EQUAL_size_t(1, stats.function_cache_misses);
+    StringBuffer reused;
+    string_buffer_init(&reused, &arena, 256);
+    TEST_ASSERT_TRUE(compile_with_options(same, &options, &reused, &arena, &stats));
+    TEST_ASSERT_EQUAL_size_t(1, stats.function_cache_hits);
+    TEST_ASSERT_FALSE(stats.phases[COMPILE_PHASE_IRGEN].ran);
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&generated), string_buffer_content_str(&reused));
+
+    // A changed function, or other code-affecting options, are compiled again
+    string_buffer_reset(&reused);
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { int a = 3; return a * 5; }", &options, &reused,
+                                          &arena, NULL));
+    options.optimization_level = 0;
+    string_buffer_reset(&reused);
+    TEST_ASSERT_TRUE(compile_with_options(first, &options, &reused, &arena, NULL));
+    TEST_ASSERT_EQUAL_size_t(1, cache.hits);
+    TEST_ASSERT_EQUAL_size_t(3, cache.misses);
+
+    // Validation still runs for a cached function
+    TEST_ASSERT_FALSE(compile_with_options("int main(void) { int a = 3; int a = 4; return a; }", &options,
+                                           &reused, &arena, NULL));
+
+    arena_destroy(&arena);
+    function_cache_destroy(&cache);
+}
+
+// Test that the library entry point compiles into a sink and reports failures into diagnostics
+// Streamed functions are compiled separately, each numbering its labels from 0: the names keep them apart
+static void test_compile_stream_qualifies_labels(void) {
+    Arena arena = arena_create(1024 * 16);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.quiet = true;
+    const char *source = "int f(void) { return 1 && 2; }";
+
+    StringBuffer plain;
+    string_buffer_init(&plain, &arena, 256);
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &plain, &arena, NULL));
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&plain), "jz L0\n"));
+
+    options.stream = true;
+    StringBuffer qualified;
+    string_buffer_init(&qualified, &arena, 256);
+    TEST_ASSERT_TRUE(compile_with_options(source, &options, &qualified, &arena, NULL));
+    const char *text = string_buffer_content_str(&qualified);
+    TEST_ASSERT_NOT_NULL(strstr(text, "jz L0_f\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nL0_f:\n"));
+    TEST_ASSERT_NULL(strstr(text, "L0\n"));
+
+    arena_destroy(&arena);
+}
+
+static void test_cleric_compile_reports_into_diagnostics(void) {
+    Arena arena = arena_create(1024 * 8);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    CompileOptions options;
+    compile_options_init(&options); // Not quiet: the library never prints progress anyway
+    StringBuffer output;
+    string_buffer_init(&output, &arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &output);
+    StringBuffer messages;
+    string_buffer_init(&messages, &arena, 256);
+    Diagnostics diagnostics;
+    diagnostics_init(&diagnostics, &messages);
+
+    const char *source = "int main(void) { return 7; }";
+    TEST_ASSERT_TRUE(cleric_compile(&options, source, strlen(source), &sink, &diagnostics));
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&output), "main:"));
+    TEST_ASSERT_EQUAL_size_t(0, diagnostics.error_count);
+
+    // The parser's own message comes first, then the failed phase
+    const char *broken = "int main(void) { return 7 }";
+    TEST_ASSERT_FALSE(cleric_compile(&options, broken, strlen(broken), &sink, &diagnostics));
+    TEST_ASSERT_EQUAL_size_t(2, diagnostics.error_count);
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&messages), "Parse Error"));
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&messages), "Parsing failed due to errors.\n"));
+
+    options.tac_only = true;
+    TEST_ASSERT_FALSE(cleric_compile(&options, source, strlen(source), &sink, &diagnostics));
+    TEST_ASSERT_EQUAL_size_t(3, diagnostics.error_count);
+    arena_destroy(&arena);
+}
+
 void run_compiler_tests(void) {
     RUN_TEST(test_compile_return_4);
     RUN_TEST(test_compile_return_negated_parenthesized_constant);
@@ -421,4 +701,13 @@ void run_compiler_tests(void) {
     RUN_TEST(test_compile_logical_or_false_true);
     RUN_TEST(test_compile_complex_logical_or);
     RUN_TEST(test_compile_complex_logical_and_short_circuit);
+    RUN_TEST(test_compile_with_options_collects_stats);
+    RUN_TEST(test_compile_presizes_tac_from_ast);
+    RUN_TEST(test_compile_deeply_nested_expressions);
+    RUN_TEST(test_compile_deeply_nested_errors);
+    RUN_TEST(test_compile_with_lexer_thread);
+    RUN_TEST(test_compile_stats_print_json);
+    RUN_TEST(test_compile_reuses_cached_function_assembly);
+    RUN_TEST(test_compile_stream_qualifies_labels);
+    RUN_TEST(test_cleric_compile_reports_into_diagnostics);
 }
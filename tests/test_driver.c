@@ -1,9 +1,18 @@
 #include "_unity/unity.h"
 #include "../src/compiler/driver.h"
+#include "../src/compiler/options.h"
+#include "../src/compiler/server.h"
+#include "../src/compiler/disk_cache.h"
+#include "../src/args/args.h"
+#include <dirent.h>
+#include <utime.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 void test_run_preprocessor_creates_i_file(void) {
     // Create a temporary C file
@@ -165,6 +174,344 @@ void test_run_assembler_linker_creates_executable_and_removes_s(void) {
     remove(test_exe_file);
 }
 
+void test_run_pipeline_leaves_no_intermediate_files(void) {
+    const char *test_c_file = "test_pipe.c";
+    FILE *f = fopen(test_c_file, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "#define RESULT 6\nint main(void) { return RESULT * 7; }\n");
+    fclose(f);
+
+    CompileOptions options;
+    compile_options_init(&options);
+    TEST_ASSERT_EQUAL_INT(0, run_pipeline(test_c_file, &options));
+
+    // The executable is there and runs; no .i or .s was ever written
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat("test_pipe", &st));
+    TEST_ASSERT_TRUE(st.st_mode & S_IXUSR);
+    TEST_ASSERT_NOT_EQUAL(0, stat("test_pipe.i", &st));
+    TEST_ASSERT_NOT_EQUAL(0, stat("test_pipe.s", &st));
+    const int status = system("./test_pipe");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(42, WEXITSTATUS(status));
+
+    remove("test_pipe");
+    remove(test_c_file);
+}
+
+void test_run_pipeline_failure_leaves_no_executable(void) {
+    const char *test_c_file = "test_pipe_error.c";
+    FILE *f = fopen(test_c_file, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "int main(void) { return undeclared; }\n");
+    fclose(f);
+
+    CompileOptions options;
+    compile_options_init(&options);
+    TEST_ASSERT_EQUAL_INT(1, run_pipeline(test_c_file, &options));
+    struct stat st;
+    TEST_ASSERT_NOT_EQUAL(0, stat("test_pipe_error", &st));
+
+    // Preprocessor errors are reported too
+    TEST_ASSERT_EQUAL_INT(1, run_pipeline("does_not_exist_pipe.c", &options));
+    remove(test_c_file);
+}
+
+void test_run_parallel_builds_every_file(void) {
+    char sources[8][32];
+    const char *inputs[8];
+    for (int i = 0; i < 8; ++i) {
+        snprintf(sources[i], sizeof(sources[i]), "test_parallel_%d.c", i);
+        inputs[i] = sources[i];
+        FILE *f = fopen(sources[i], "w");
+        TEST_ASSERT_NOT_NULL(f);
+        // The last file does not compile; the others are still built
+        if (i == 7) {
+            fprintf(f, "int main(void) { return undeclared; }\n");
+        } else {
+            fprintf(f, "int main(void) { return %d * 3; }\n", i);
+        }
+        fclose(f);
+    }
+
+    CompileOptions options;
+    compile_options_init(&options);
+    options.jobs = 4;
+    TEST_ASSERT_EQUAL_INT(1, run_parallel(inputs, 8, &options));
+    TEST_ASSERT_EQUAL_INT(0, run_parallel(inputs, 7, &options));
+    options.emit_obj = true;
+    TEST_ASSERT_EQUAL_INT(0, run_parallel(inputs + 4, 3, &options));
+
+    struct stat st;
+    for (int i = 0; i < 8; ++i) {
+        char executable[32];
+        snprintf(executable, sizeof(executable), "test_parallel_%d", i);
+        if (i == 7) {
+            TEST_ASSERT_NOT_EQUAL(0, stat(executable, &st));
+        } else {
+            char command[48];
+            snprintf(command, sizeof(command), "./%s", executable);
+            const int status = system(command);
+            TEST_ASSERT_TRUE(WIFEXITED(status));
+            TEST_ASSERT_EQUAL_INT(i * 3, WEXITSTATUS(status));
+            remove(executable);
+        }
+        remove(sources[i]);
+    }
+}
+
+static void *serve_until_stopped(void *data) {
+    CompileServer *server = data;
+    while (compile_server_serve_one(server)) {
+    }
+    return NULL;
+}
+
+void test_compile_server_answers_clients(void) {
+    const char *socket_path = "test_server.sock";
+    CompileServer server;
+    TEST_ASSERT_TRUE(compile_server_open(&server, socket_path));
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, serve_until_stopped, &server));
+
+    // The server returns the assembly
+    CompileOptions options;
+    compile_options_init(&options);
+    const char *source = "int main(void) { return 6 * 7; }";
+    char *output = NULL;
+    size_t output_size = 0;
+    TEST_ASSERT_TRUE(
+        compile_server_request(socket_path, source, strlen(source), &options, &output, &output_size, NULL));
+    TEST_ASSERT_EQUAL_size_t(strlen(output), output_size);
+    TEST_ASSERT_NOT_NULL(strstr(output, "main"));
+    free(output);
+
+    // A failing source gets the server's errors back instead
+    Arena arena = arena_create(4096);
+    StringBuffer messages;
+    string_buffer_init(&messages, &arena, 256);
+    Diagnostics diagnostics;
+    diagnostics_init(&diagnostics, &messages);
+    const char *broken = "int main(void) { return undeclared; }";
+    TEST_ASSERT_FALSE(
+        compile_server_request(socket_path, broken, strlen(broken), &options, &output, &output_size, &diagnostics));
+    TEST_ASSERT_GREATER_THAN(0, diagnostics.error_count);
+    TEST_ASSERT_NOT_NULL(strstr(string_buffer_content_str(&messages), "validation failed"));
+    arena_destroy(&arena);
+
+    // Clients build executables from what the server sends, as assembly or as an object
+    const char *test_c_file = "test_client.c";
+    FILE *f = fopen(test_c_file, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "#define RESULT 5\nint main(void) { return RESULT + 1; }\n");
+    fclose(f);
+    options.connect_socket = socket_path;
+    options.quiet = true;
+    TEST_ASSERT_EQUAL_INT(0, run_client(test_c_file, &options));
+    int status = system("./test_client");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(6, WEXITSTATUS(status));
+    remove("test_client");
+    options.emit_obj = true;
+    TEST_ASSERT_EQUAL_INT(0, run_client(test_c_file, &options));
+    status = system("./test_client");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(6, WEXITSTATUS(status));
+    struct stat st;
+    TEST_ASSERT_NOT_EQUAL(0, stat("test_client.o", &st));
+
+    TEST_ASSERT_TRUE(compile_server_stop(socket_path));
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_size_t(4, server.requests_served);
+    compile_server_close(&server);
+    TEST_ASSERT_NOT_EQUAL(0, stat(socket_path, &st)); // The socket file is gone
+    remove("test_client");
+    remove(test_c_file);
+}
+
+// A server never removes a file that is not a socket to make room for its own
+void test_compile_server_keeps_other_files_at_its_path(void) {
+    const char *path = "test_server_source.c";
+    FILE *f = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "int main(void) { return 0; }\n");
+    fclose(f);
+    CompileServer server;
+    TEST_ASSERT_FALSE(compile_server_open(&server, path));
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat(path, &st));
+    TEST_ASSERT_TRUE(S_ISREG(st.st_mode));
+    remove(path);
+}
+
+// Regular files in a directory, or -1 if it cannot be read
+static int count_files(const char *directory) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return -1;
+    }
+    int count = 0;
+    const struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+void test_disk_cache_reuses_output_of_unchanged_source(void) {
+    const char *cache_dir = "test_cache_dir";
+    const char *test_c_file = "test_cached.c";
+    FILE *f = fopen(test_c_file, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "int main(void) { return 11; }\n");
+    fclose(f);
+
+    CompileOptions options;
+    compile_options_init(&options);
+    options.cache_dir = cache_dir;
+    options.quiet = true;
+    TEST_ASSERT_EQUAL_INT(0, run_pipeline(test_c_file, &options));
+    TEST_ASSERT_EQUAL_INT(1, count_files(cache_dir));
+    remove("test_cached");
+
+    // The entry is found again: the executable is built from it, and nothing new is stored
+    TEST_ASSERT_EQUAL_INT(0, run_pipeline(test_c_file, &options));
+    TEST_ASSERT_EQUAL_INT(1, count_files(cache_dir));
+    int status = system("./test_cached");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(11, WEXITSTATUS(status));
+    remove("test_cached");
+
+    // Other code-affecting options get their own entry, and the classic .i path shares the cache
+    options.optimization_level = 1;
+    TEST_ASSERT_EQUAL_INT(0, run_pipeline(test_c_file, &options));
+    TEST_ASSERT_EQUAL_INT(2, count_files(cache_dir));
+    f = fopen("test_cached.i", "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "int main(void) { return 11; }\n");
+    fclose(f);
+    TEST_ASSERT_EQUAL_INT(0, run_compiler_with_options("test_cached.i", &options));
+    TEST_ASSERT_EQUAL_INT(2, count_files(cache_dir));
+    TEST_ASSERT_EQUAL_INT(0, run_assembler_linker("test_cached.s"));
+    status = system("./test_cached");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(11, WEXITSTATUS(status));
+
+    remove("test_cached");
+    remove(test_c_file);
+    system("rm -rf test_cache_dir");
+}
+
+void test_disk_cache_evicts_least_recently_used(void) {
+    const char *cache_dir = "test_cache_lru";
+    CompileOptions options;
+    compile_options_init(&options);
+    DiskCacheKey keys[3];
+    const char *sources[3] = {"int a;", "int b;", "int c;"};
+    char output[100];
+    memset(output, 'x', sizeof(output));
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_TRUE(disk_cache_key(cache_dir, sources[i], strlen(sources[i]), &options, &keys[i]));
+        TEST_ASSERT_TRUE(disk_cache_store(cache_dir, &keys[i], output, sizeof(output), 1000));
+        // Distinct ages, oldest first, without waiting for the clock
+        const struct utimbuf times = {1000000 + i * 10, 1000000 + i * 10};
+        utime(keys[i].path, &times);
+    }
+    TEST_ASSERT_EQUAL_INT(3, count_files(cache_dir));
+    size_t size = 0;
+    char *loaded = disk_cache_load(&keys[0], &size); // The oldest becomes the newest
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_size_t(sizeof(output), size);
+    free(loaded);
+
+    // Room for two entries: the least recently used one (b) goes
+    DiskCacheKey fourth;
+    TEST_ASSERT_TRUE(disk_cache_key(cache_dir, "int d;", 6, &options, &fourth));
+    TEST_ASSERT_TRUE(disk_cache_store(cache_dir, &fourth, output, sizeof(output), 250));
+    TEST_ASSERT_EQUAL_INT(2, count_files(cache_dir));
+    TEST_ASSERT_NULL(disk_cache_load(&keys[1], &size));
+    TEST_ASSERT_NULL(disk_cache_load(&keys[2], &size));
+    loaded = disk_cache_load(&keys[0], &size);
+    TEST_ASSERT_NOT_NULL(loaded);
+    free(loaded);
+    system("rm -rf test_cache_lru");
+}
+
+// Eviction only touches files named like an entry, so a cache directory shared with sources is safe
+void test_disk_cache_eviction_spares_foreign_files(void) {
+    const char *cache_dir = "test_cache_shared";
+    mkdir(cache_dir, 0755);
+    const char *foreign[2] = {"test_cache_shared/main.c", "test_cache_shared/0123456789abcdef0123456789abcdeg"};
+    for (int i = 0; i < 2; ++i) {
+        FILE *f = fopen(foreign[i], "w");
+        TEST_ASSERT_NOT_NULL(f);
+        fputs("int main(void) { return 0; }\n", f);
+        fclose(f);
+        const struct utimbuf times = {1000000, 1000000}; // Older than any entry
+        utime(foreign[i], &times);
+    }
+
+    CompileOptions options;
+    compile_options_init(&options);
+    char output[100];
+    memset(output, 'x', sizeof(output));
+    DiskCacheKey key;
+    TEST_ASSERT_TRUE(disk_cache_key(cache_dir, "int a;", 6, &options, &key));
+    TEST_ASSERT_TRUE(disk_cache_store(cache_dir, &key, output, sizeof(output), 0)); // Evicts every entry
+    size_t size = 0;
+    TEST_ASSERT_NULL(disk_cache_load(&key, &size));
+    for (int i = 0; i < 2; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, access(foreign[i], F_OK));
+    }
+    system("rm -rf test_cache_shared");
+}
+
+// --quiet leaves stdout empty for a successful build, whatever the order of its options
+void test_quiet_build_prints_nothing(void) {
+    const char *test_c_file = "test_quiet.c";
+    FILE *f = fopen(test_c_file, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "int main(void) { return 3; }\n");
+    fclose(f);
+
+    FILE *capture = tmpfile();
+    TEST_ASSERT_NOT_NULL(capture);
+    fflush(stdout);
+    const int saved = dup(fileno(stdout));
+    dup2(fileno(capture), fileno(stdout));
+
+    CompileOptions options;
+    char *stage_argv[] = {"cleric", "--tac", "--quiet", "test_quiet.c"};
+    const bool stage_parsed = parse_args_with_options(4, stage_argv, &options) != NULL && options.tac_only;
+    char *argv[] = {"cleric", "test_quiet.c", "--quiet"};
+    const bool parsed = parse_args_with_options(3, argv, &options) != NULL;
+    const int preprocessed = run_preprocessor_with_options(test_c_file, &options);
+    const int compiled = run_compiler_with_options("test_quiet.i", &options);
+    const int linked = run_assembler_linker_with_options("test_quiet.s", &options);
+    options.pipe = true;
+    const int piped = run_pipeline(test_c_file, &options);
+
+    fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+    const long printed = ftell(capture);
+    fclose(capture);
+
+    TEST_ASSERT_TRUE(stage_parsed);
+    TEST_ASSERT_TRUE(parsed);
+    TEST_ASSERT_EQUAL_INT(0, preprocessed);
+    TEST_ASSERT_EQUAL_INT(0, compiled);
+    TEST_ASSERT_EQUAL_INT(0, linked);
+    TEST_ASSERT_EQUAL_INT(0, piped);
+    TEST_ASSERT_EQUAL_INT(0, printed);
+    const int status = system("./test_quiet");
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(3, WEXITSTATUS(status));
+    remove("test_quiet");
+    remove(test_c_file);
+}
+
 void run_driver_tests(void) {
     RUN_TEST(test_run_preprocessor_creates_i_file);
     RUN_TEST(test_run_compiler_creates_s_file_and_removes_i);
@@ -172,4 +519,13 @@ void run_driver_tests(void) {
     RUN_TEST(test_run_compiler_parse_only);
     RUN_TEST(test_run_compiler_codegen_only);
     RUN_TEST(test_run_assembler_linker_creates_executable_and_removes_s);
+    RUN_TEST(test_run_pipeline_leaves_no_intermediate_files);
+    RUN_TEST(test_run_pipeline_failure_leaves_no_executable);
+    RUN_TEST(test_quiet_build_prints_nothing);
+    RUN_TEST(test_run_parallel_builds_every_file);
+    RUN_TEST(test_compile_server_answers_clients);
+    RUN_TEST(test_compile_server_keeps_other_files_at_its_path);
+    RUN_TEST(test_disk_cache_reuses_output_of_unchanged_source);
+    RUN_TEST(test_disk_cache_evicts_least_recently_used);
+    RUN_TEST(test_disk_cache_eviction_spares_foreign_files);
 }
@@ -1,4 +1,5 @@
 #include "../src/files/files.h"
+#include "../src/files/function_reader.h"
 #include "_unity/unity.h"
 #include <stdio.h>
 #include <string.h>
@@ -49,6 +50,139 @@ void test_read_entire_file_nonexistent(void) {
     TEST_ASSERT_NULL(contents);
 }
 
+void test_read_entire_stream_grows(void) {
+    FILE *f = tmpfile();
+    TEST_ASSERT_NOT_NULL(f);
+    const size_t size = 200000; // Past the first buffer, so it has to double twice
+    for (size_t i = 0; i < size; ++i) {
+        fputc('a' + (int) (i % 26), f);
+    }
+    rewind(f);
+    size_t read_size = 0;
+    char *contents = read_entire_stream(f, &read_size);
+    fclose(f);
+    TEST_ASSERT_NOT_NULL(contents);
+    TEST_ASSERT_EQUAL_size_t(size, read_size);
+    TEST_ASSERT_EQUAL_size_t(size, strlen(contents));
+    TEST_ASSERT_EQUAL_CHAR('a' + (int) ((size - 1) % 26), contents[size - 1]);
+    free(contents);
+}
+
+// --- Tests for FunctionReader ---
+
+void test_function_reader_splits_definitions(void) {
+    FILE *f = tmpfile();
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("int f(void) { { return 1; } }\n\nint main(void) {\n  return 2;\n}\n  int x", f);
+    rewind(f);
+    FunctionReader reader;
+    function_reader_init(&reader, f);
+    const char *text;
+    size_t length;
+    size_t line;
+    TEST_ASSERT_TRUE(function_reader_next(&reader, &text, &length, &line));
+    TEST_ASSERT_EQUAL_STRING("int f(void) { { return 1; } }", text);
+    TEST_ASSERT_EQUAL_size_t(strlen(text), length);
+    TEST_ASSERT_EQUAL_size_t(1, line);
+    TEST_ASSERT_TRUE(function_reader_next(&reader, &text, &length, &line));
+    TEST_ASSERT_EQUAL_STRING("int main(void) {\n  return 2;\n}", text);
+    TEST_ASSERT_EQUAL_size_t(3, line);
+    // What follows the last definition comes back whole, for the compiler to report
+    TEST_ASSERT_TRUE(function_reader_next(&reader, &text, &length, &line));
+    TEST_ASSERT_EQUAL_STRING("int x", text);
+    TEST_ASSERT_EQUAL_size_t(6, line);
+    TEST_ASSERT_FALSE(function_reader_next(&reader, &text, &length, &line));
+    TEST_ASSERT_FALSE(reader.failed);
+    function_reader_destroy(&reader);
+    fclose(f);
+}
+
+void test_function_reader_buffer_follows_largest_definition(void) {
+    FILE *f = tmpfile();
+    TEST_ASSERT_NOT_NULL(f);
+    // Many small definitions, then one spanning several reads
+    const size_t small_count = 20000;
+    for (size_t i = 0; i < small_count; ++i) {
+        fprintf(f, "int f%zu(void) { return %zu; }\n", i, i);
+    }
+    const size_t body_size = 3 * FUNCTION_READER_READ_SIZE;
+    fputs("int main(void) {", f);
+    for (size_t i = 0; i < body_size; ++i) {
+        fputc(i % 64 == 63 ? '\n' : ' ', f);
+    }
+    fputs("return 0; }\n", f);
+    rewind(f);
+
+    FunctionReader reader;
+    function_reader_init(&reader, f);
+    const char *text;
+    size_t length;
+    size_t line;
+    size_t count = 0;
+    size_t capacity_before_main = 0;
+    while (function_reader_next(&reader, &text, &length, &line)) {
+        TEST_ASSERT_EQUAL_CHAR('}', text[length - 1]);
+        if (++count == small_count) {
+            capacity_before_main = reader.capacity;
+        }
+    }
+    TEST_ASSERT_FALSE(reader.failed);
+    TEST_ASSERT_EQUAL_size_t(small_count + 1, count);
+    TEST_ASSERT_EQUAL_size_t(small_count + 1, line); // main starts on the line after the small ones
+    TEST_ASSERT_TRUE(reader.largest > body_size);
+    // Over half a megabyte of small definitions went through a buffer sized for one read
+    TEST_ASSERT_EQUAL_size_t(2 * FUNCTION_READER_READ_SIZE, capacity_before_main);
+    TEST_ASSERT_TRUE(reader.capacity <= 4 * reader.largest);
+    function_reader_destroy(&reader);
+    fclose(f);
+}
+
+// --- Tests for map_entire_file ---
+
+// Writes `size` bytes of 'x' (so the file holds no NUL of its own)
+static void write_file_of_size(const char *fname, const size_t size) {
+    FILE *f = fopen(fname, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    for (size_t i = 0; i < size; ++i) {
+        fputc('x', f);
+    }
+    fclose(f);
+}
+
+void test_map_entire_file_terminated(void) {
+    const char *fname = "test_map_file.txt";
+    // One size inside a page, and page-aligned sizes, which need the extra zero page
+    const size_t sizes[] = {14, 4096, 2 * 65536};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        write_file_of_size(fname, sizes[i]);
+        MappedFile file;
+        TEST_ASSERT_TRUE(map_entire_file(fname, &file));
+        TEST_ASSERT_EQUAL_size_t(sizes[i], file.size);
+        TEST_ASSERT_EQUAL_CHAR('x', file.data[0]);
+        TEST_ASSERT_EQUAL_CHAR('x', file.data[sizes[i] - 1]);
+        TEST_ASSERT_EQUAL_CHAR('\0', file.data[sizes[i]]);
+        TEST_ASSERT_EQUAL_size_t(sizes[i], strlen(file.data));
+        unmap_file(&file);
+        TEST_ASSERT_NULL(file.data);
+    }
+    remove(fname);
+}
+
+void test_map_entire_file_empty_and_nonexistent(void) {
+    const char *fname = "test_map_empty.txt";
+    write_file_of_size(fname, 0);
+    MappedFile file;
+    TEST_ASSERT_TRUE(map_entire_file(fname, &file)); // Copied: empty files cannot be mapped
+    TEST_ASSERT_EQUAL_size_t(0, file.size);
+    TEST_ASSERT_NULL(file.mapping);
+    TEST_ASSERT_EQUAL_STRING("", file.data);
+    unmap_file(&file);
+    remove(fname);
+
+    TEST_ASSERT_FALSE(map_entire_file("does_not_exist_12345.txt", &file));
+    TEST_ASSERT_NULL(file.data);
+}
+
 // --- Tests for filename_has_ext ---
 void test_filename_has_ext_true(void) {
     TEST_ASSERT_TRUE(filename_has_ext("file.c", ".c"));
@@ -122,16 +256,45 @@ void test_write_string_to_file_invalid_args(void) {
     TEST_ASSERT_FALSE(write_string_to_file(".", "content")); // Writing to current dir
 }
 
+void test_write_string_buffer_to_file_chunked(void) {
+    const char *filename = "./test_write_chunked.txt";
+    Arena arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(arena.start);
+    StringBuffer sb;
+    string_buffer_init_chunked(&sb, &arena, 16); // Small segments so the content spans several
+    for (int i = 0; i < 20; ++i) {
+        string_buffer_append(&sb, "line %d\n", i);
+    }
+    TEST_ASSERT_NOT_NULL(sb.first_segment);
+    TEST_ASSERT_TRUE(write_string_buffer_to_file(filename, &sb));
+
+    long size = 0;
+    char *read_content = read_entire_file(filename, &size);
+    TEST_ASSERT_NOT_NULL(read_content);
+    TEST_ASSERT_EQUAL_STRING(string_buffer_flatten(&sb), read_content);
+    TEST_ASSERT_EQUAL(sb.length, size);
+
+    free(read_content);
+    remove(filename); // Clean up
+    arena_destroy(&arena);
+}
+
 void run_files_tests(void) {
     RUN_TEST(test_filename_replace_ext_basic);
     RUN_TEST(test_filename_replace_ext_long_name);
     RUN_TEST(test_filename_replace_ext_buffer_too_small);
     RUN_TEST(test_read_entire_file_basic);
     RUN_TEST(test_read_entire_file_nonexistent);
+    RUN_TEST(test_read_entire_stream_grows);
+    RUN_TEST(test_function_reader_splits_definitions);
+    RUN_TEST(test_function_reader_buffer_follows_largest_definition);
+    RUN_TEST(test_map_entire_file_terminated);
+    RUN_TEST(test_map_entire_file_empty_and_nonexistent);
     RUN_TEST(test_filename_has_ext_true);
     RUN_TEST(test_filename_has_ext_false);
     RUN_TEST(test_filename_has_ext_edge_cases);
     RUN_TEST(test_write_string_to_file_success);
     RUN_TEST(test_write_string_to_file_overwrite);
     RUN_TEST(test_write_string_to_file_invalid_args);
+    RUN_TEST(test_write_string_buffer_to_file_chunked);
 }
@@ -1,7 +1,12 @@
 #include <string.h>
+#include <ctype.h>
 #include <stdio.h> // For snprintf in helper
+#include <stdlib.h>
 
 #include "../src/lexer/lexer.h"
+#include "../src/lexer/keywords.h"
+#include "../src/lexer/char_class.h"
+#include "../src/lexer/token_ring.h"
 #include "_unity/unity.h"
 #include "memory/arena.h"
 
@@ -56,10 +61,14 @@ static void run_single_lexer_test(const LexerTestCase *test_case, Arena *arena)
 
         if (test_case->expected_tokens[i].lexeme) {
             snprintf(assert_msg, sizeof(assert_msg),
-                     "[%s] Token %zu: Lexeme mismatch. Expected '%s', Got '%s'",
-                     test_case->name, i + 1, test_case->expected_tokens[i].lexeme, tok.lexeme ? tok.lexeme : "NULL");
+                     "[%s] Token %zu: Lexeme mismatch. Expected '%s', Got '%.*s'",
+                     test_case->name, i + 1, test_case->expected_tokens[i].lexeme,
+                     tok.lexeme ? (int) tok.length : 4, tok.lexeme ? tok.lexeme : "NULL");
             TEST_ASSERT_NOT_NULL_MESSAGE(tok.lexeme, assert_msg);
-            TEST_ASSERT_EQUAL_STRING_MESSAGE(test_case->expected_tokens[i].lexeme, tok.lexeme, assert_msg);
+            // Lexemes are slices of the source: compare the length, then the bytes
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(strlen(test_case->expected_tokens[i].lexeme), tok.length, assert_msg);
+            TEST_ASSERT_EQUAL_STRING_LEN_MESSAGE(test_case->expected_tokens[i].lexeme, tok.lexeme, tok.length,
+                                                 assert_msg);
         }
     }
 
@@ -360,6 +369,291 @@ void test_token_to_string_buffer_limit(void) {
     TEST_ASSERT_EQUAL('\0', small_buffer[sizeof(small_buffer) - 1]);
 }
 
+void test_lexer_tokenize_fills_token_array(void) {
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, "int main(void) { return 42; }", &arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+    TEST_ASSERT_EQUAL(11, tokens.count); // 10 tokens + EOF
+
+    TEST_ASSERT_EQUAL(TOKEN_KEYWORD_INT, tokens.types[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, tokens.offsets[0]);
+    TEST_ASSERT_EQUAL_UINT32(3, tokens.lengths[0]);
+    TEST_ASSERT_EQUAL(TOKEN_IDENTIFIER, tokens.types[1]);
+    TEST_ASSERT_EQUAL_UINT32(4, tokens.offsets[1]);
+    TEST_ASSERT_EQUAL_UINT32(4, tokens.lengths[1]);
+    TEST_ASSERT_EQUAL_STRING_LEN("main", tokens.src + tokens.offsets[1], tokens.lengths[1]);
+    TEST_ASSERT_EQUAL(TOKEN_CONSTANT, tokens.types[7]);
+    TEST_ASSERT_EQUAL_UINT32(2, tokens.lengths[7]);
+    TEST_ASSERT_EQUAL(TOKEN_EOF, tokens.types[10]);
+
+    // Reading past the end keeps yielding EOF
+    const Token past_end = token_array_get(&tokens, 100);
+    TEST_ASSERT_EQUAL(TOKEN_EOF, past_end.type);
+
+    arena_destroy(&arena);
+}
+
+void test_lexer_tokenize_stops_at_unknown(void) {
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, "return @ 1;", &arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+    TEST_ASSERT_EQUAL(2, tokens.count);
+    TEST_ASSERT_EQUAL(TOKEN_UNKNOWN, tokens.types[1]);
+    TEST_ASSERT_EQUAL_UINT32(7, tokens.offsets[1]);
+
+    arena_destroy(&arena);
+}
+
+// Many times the ring's capacity, so the lexer thread waits on a full ring over and over
+void test_lexer_thread_matches_lexer(void) {
+    enum { SOURCE_SIZE = 64 * 1024 };
+    char *source = malloc(SOURCE_SIZE);
+    TEST_ASSERT_NOT_NULL(source);
+    const char *pattern = "int x = (a1 + 42) * -b; ";
+    for (size_t i = 0; i < SOURCE_SIZE - 1; ++i) {
+        source[i] = pattern[i % strlen(pattern)];
+    }
+    source[SOURCE_SIZE - 1] = '\0';
+
+    Arena arena = arena_create(64 * 1024);
+    Lexer reference;
+    lexer_init(&reference, source, &arena);
+    Lexer lexer;
+    lexer_init(&lexer, source, &arena);
+    LexerThread thread;
+    TEST_ASSERT_TRUE(lexer_thread_start(&thread, &lexer, &arena));
+    size_t count = 0;
+    Token expected;
+    Token token;
+    do {
+        TEST_ASSERT_TRUE(lexer_next_token(&reference, &expected));
+        TEST_ASSERT_TRUE(token_ring_pop(thread.ring, &token));
+        TEST_ASSERT_EQUAL(expected.type, token.type);
+        TEST_ASSERT_EQUAL_size_t(expected.position, token.position);
+        TEST_ASSERT_EQUAL_UINT32(expected.length, token.length);
+        count++;
+    } while (expected.type != TOKEN_EOF);
+    TEST_ASSERT_TRUE(token_ring_pop(thread.ring, &token)); // Past the end: the final token again
+    TEST_ASSERT_EQUAL(TOKEN_EOF, token.type);
+    lexer_thread_finish(&thread);
+    TEST_ASSERT_EQUAL_size_t(count, thread.token_count);
+    TEST_ASSERT_FALSE(thread.saw_unknown);
+    free(source);
+    arena_destroy(&arena);
+}
+
+// The unknown token ends the stream; a consumer that stops early releases a waiting lexer
+void test_lexer_thread_stops_at_unknown_and_close(void) {
+    Arena arena = arena_create(64 * 1024);
+    Lexer lexer;
+    lexer_init(&lexer, "return @ 1;", &arena);
+    LexerThread thread;
+    TEST_ASSERT_TRUE(lexer_thread_start(&thread, &lexer, &arena));
+    Token token;
+    TEST_ASSERT_TRUE(token_ring_pop(thread.ring, &token));
+    TEST_ASSERT_EQUAL(TOKEN_KEYWORD_RETURN, token.type);
+    TEST_ASSERT_TRUE(token_ring_pop(thread.ring, &token));
+    TEST_ASSERT_EQUAL(TOKEN_UNKNOWN, token.type);
+    lexer_thread_finish(&thread);
+    TEST_ASSERT_TRUE(thread.saw_unknown);
+    TEST_ASSERT_EQUAL_size_t(7, thread.unknown.position);
+
+    char source[4 * TOKEN_RING_CAPACITY + 1];
+    memset(source, '+', sizeof(source) - 1);
+    source[sizeof(source) - 1] = '\0';
+    lexer_init(&lexer, source, &arena);
+    TEST_ASSERT_TRUE(lexer_thread_start(&thread, &lexer, &arena));
+    TEST_ASSERT_TRUE(token_ring_pop(thread.ring, &token));
+    lexer_thread_finish(&thread); // Returns although most tokens were never taken
+    TEST_ASSERT_TRUE(thread.token_count < sizeof(source) - 1);
+    arena_destroy(&arena);
+}
+
+void test_lexer_tokenize_grows_array(void) {
+    // Far more tokens than the initial len/4 estimate: "+" has no whitespace between tokens
+    char source[512];
+    memset(source, '+', sizeof(source) - 1);
+    source[sizeof(source) - 1] = '\0';
+
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, source, &arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+    TEST_ASSERT_EQUAL(sizeof(source), tokens.count); // 511 '+' tokens + EOF
+    TEST_ASSERT_EQUAL(TOKEN_SYMBOL_PLUS, tokens.types[510]);
+    TEST_ASSERT_EQUAL_UINT32(510, tokens.offsets[510]);
+    TEST_ASSERT_EQUAL(TOKEN_EOF, tokens.types[511]);
+
+    arena_destroy(&arena);
+}
+
+void test_lexer_init_with_length_stops_at_length(void) {
+    // No terminator after the bytes to lex, as with a source mapped straight from a file
+    const char source[] = {'r', 'e', 't', 'u', 'r', 'n', ' ', '7', ';', 'x', 'y', 'z'};
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init_with_length(&lexer, source, 9, &arena);
+
+    TokenArray tokens;
+    TEST_ASSERT_TRUE(lexer_tokenize(&lexer, &tokens));
+    TEST_ASSERT_EQUAL(4, tokens.count); // return 7 ; EOF
+    TEST_ASSERT_EQUAL(TOKEN_KEYWORD_RETURN, tokens.types[0]);
+    TEST_ASSERT_EQUAL(TOKEN_SYMBOL_SEMICOLON, tokens.types[2]);
+    TEST_ASSERT_EQUAL(TOKEN_EOF, tokens.types[3]);
+    TEST_ASSERT_EQUAL_UINT32(9, tokens.offsets[3]);
+
+    arena_destroy(&arena);
+}
+
+void test_lexer_lexemes_are_source_slices(void) {
+    const char *source = "int counter = 12345;";
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, source, &arena);
+
+    const size_t offset_before = arena.offset;
+    Token tok;
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok)); // int
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok)); // counter
+    TEST_ASSERT_EQUAL(TOKEN_IDENTIFIER, tok.type);
+    TEST_ASSERT_EQUAL_PTR(source + 4, tok.lexeme);
+    TEST_ASSERT_EQUAL_UINT32(7, tok.length);
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok)); // =
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok)); // 12345
+    TEST_ASSERT_EQUAL(TOKEN_CONSTANT, tok.type);
+    TEST_ASSERT_EQUAL_PTR(source + 14, tok.lexeme);
+    TEST_ASSERT_EQUAL_UINT32(5, tok.length);
+
+    // No lexeme was copied into the arena
+    TEST_ASSERT_EQUAL(offset_before, arena.offset);
+
+    arena_destroy(&arena);
+}
+
+void test_keyword_table_recognizes_every_keyword(void) {
+    static const struct {
+        const char *text;
+        TokenType type;
+    } keywords[] = {
+#define KEYWORD_ENTRY(text, first, last, type) {text, type},
+        CLERIC_KEYWORDS(KEYWORD_ENTRY)
+#undef KEYWORD_ENTRY
+    };
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i) {
+        TokenType type = TOKEN_UNKNOWN;
+        TEST_ASSERT_TRUE_MESSAGE(keyword_table_lookup(&cleric_keyword_table, keywords[i].text,
+                                                      strlen(keywords[i].text), &type), keywords[i].text);
+        TEST_ASSERT_EQUAL_MESSAGE(keywords[i].type, type, keywords[i].text);
+    }
+}
+
+void test_keyword_table_rejects_near_misses(void) {
+    const char *identifiers[] = {"in", "integer", "voids", "retur", "returns", "Int", "nt", "x", "main"};
+    for (size_t i = 0; i < sizeof(identifiers) / sizeof(identifiers[0]); ++i) {
+        TokenType type = TOKEN_UNKNOWN;
+        TEST_ASSERT_FALSE_MESSAGE(keyword_table_lookup(&cleric_keyword_table, identifiers[i],
+                                                       strlen(identifiers[i]), &type), identifiers[i]);
+        TEST_ASSERT_EQUAL(TOKEN_UNKNOWN, type);
+    }
+    // Slices are matched by length, not by NUL terminator
+    TokenType type = TOKEN_UNKNOWN;
+    TEST_ASSERT_TRUE(keyword_table_lookup(&cleric_keyword_table, "integer", 3, &type));
+    TEST_ASSERT_EQUAL(TOKEN_KEYWORD_INT, type);
+}
+
+void test_keyword_hash_is_perfect_for_c99_keywords(void) {
+    // Guards the hash against a keyword set grown to full C99
+    const char *c99_keywords[] = {
+        "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else",
+        "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+        "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+        "unsigned", "void", "volatile", "while", "_Bool", "_Complex", "_Imaginary"
+    };
+    const size_t count = sizeof(c99_keywords) / sizeof(c99_keywords[0]);
+    KeywordTable table;
+    memset(&table, 0, sizeof(table));
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_TRUE_MESSAGE(keyword_table_add(&table, c99_keywords[i], (TokenType) i), c99_keywords[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        TokenType type = TOKEN_UNKNOWN;
+        TEST_ASSERT_TRUE(keyword_table_lookup(&table, c99_keywords[i], strlen(c99_keywords[i]), &type));
+        TEST_ASSERT_EQUAL((TokenType) i, type);
+    }
+    // Adding an existing keyword again is reported as a collision
+    TEST_ASSERT_FALSE(keyword_table_add(&table, "int", TOKEN_KEYWORD_INT));
+}
+
+void test_char_class_table_matches_c_locale(void) {
+    // The process runs in the "C" locale unless setlocale is called, so ctype is the reference
+    for (int c = 0; c < 256; ++c) {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "byte 0x%02x", c);
+        const char ch = (char) c;
+        TEST_ASSERT_EQUAL_MESSAGE(isspace(c) != 0, char_has_class(ch, CHAR_CLASS_SPACE), msg);
+        TEST_ASSERT_EQUAL_MESSAGE(isdigit(c) != 0, char_has_class(ch, CHAR_CLASS_DIGIT), msg);
+        TEST_ASSERT_EQUAL_MESSAGE(isalpha(c) || c == '_', char_has_class(ch, CHAR_CLASS_IDENT_START), msg);
+        TEST_ASSERT_EQUAL_MESSAGE(isalnum(c) || c == '_', char_has_class(ch, CHAR_CLASS_IDENT), msg);
+    }
+}
+
+// Byte-at-a-time references for the (possibly SIMD) scan functions
+static size_t reference_scan(const char *src, size_t pos, const size_t len, const int identifier) {
+    while (pos < len && (identifier ? (isalnum((unsigned char) src[pos]) || src[pos] == '_')
+                                    : isspace((unsigned char) src[pos]))) {
+        pos++;
+    }
+    return pos;
+}
+
+void test_char_scan_matches_reference_at_every_offset(void) {
+    // Runs that straddle 16-byte blocks, plus bytes that sit just outside each class range
+    char buffer[96];
+    const char *pattern = "   \t\n\v\f\r  abc_XYZ09` @[{/:\x80\xff\x08\x0e" "identifier_with_a_long_tail_0123456789";
+    const size_t pattern_len = strlen(pattern);
+    for (size_t i = 0; i < sizeof(buffer); ++i) {
+        buffer[i] = pattern[i % pattern_len];
+    }
+    for (size_t len = 0; len <= sizeof(buffer); ++len) {
+        for (size_t pos = 0; pos <= len; ++pos) {
+            TEST_ASSERT_EQUAL(reference_scan(buffer, pos, len, 0), char_scan_whitespace(buffer, pos, len));
+            TEST_ASSERT_EQUAL(reference_scan(buffer, pos, len, 1), char_scan_identifier(buffer, pos, len));
+        }
+    }
+}
+
+void test_lexer_long_whitespace_and_identifier_runs(void) {
+    char source[256];
+    memset(source, ' ', 70);
+    memcpy(source + 3, "\t\n", 2);
+    memset(source + 70, 'a', 50);
+    memcpy(source + 120, "_9 \n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n;", 22);
+    source[142] = '\0';
+
+    Arena arena = arena_create(1024);
+    Lexer lexer;
+    lexer_init(&lexer, source, &arena);
+    Token tok;
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok));
+    TEST_ASSERT_EQUAL(TOKEN_IDENTIFIER, tok.type);
+    TEST_ASSERT_EQUAL(70, tok.position);
+    TEST_ASSERT_EQUAL_UINT32(52, tok.length);
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok));
+    TEST_ASSERT_EQUAL(TOKEN_SYMBOL_SEMICOLON, tok.type);
+    TEST_ASSERT_EQUAL(141, tok.position);
+    TEST_ASSERT_TRUE(lexer_next_token(&lexer, &tok));
+    TEST_ASSERT_EQUAL(TOKEN_EOF, tok.type);
+    arena_destroy(&arena);
+}
+
 void run_lexer_tests(void) {
     // Run the consolidated tokenization tests
     RUN_TEST(test_lexer_runner);
@@ -372,4 +666,23 @@ void run_lexer_tests(void) {
     RUN_TEST(test_token_to_string_eof);
     RUN_TEST(test_token_to_string_unknown);
     RUN_TEST(test_token_to_string_buffer_limit);
+
+    // Single-pass token array
+    RUN_TEST(test_lexer_tokenize_fills_token_array);
+    RUN_TEST(test_lexer_tokenize_stops_at_unknown);
+    RUN_TEST(test_lexer_tokenize_grows_array);
+    RUN_TEST(test_lexer_thread_matches_lexer);
+    RUN_TEST(test_lexer_thread_stops_at_unknown_and_close);
+    RUN_TEST(test_lexer_init_with_length_stops_at_length);
+    RUN_TEST(test_lexer_lexemes_are_source_slices);
+
+    // Keyword perfect hash
+    RUN_TEST(test_keyword_table_recognizes_every_keyword);
+    RUN_TEST(test_keyword_table_rejects_near_misses);
+    RUN_TEST(test_keyword_hash_is_perfect_for_c99_keywords);
+
+    // Character classification and block scans
+    RUN_TEST(test_char_class_table_matches_c_locale);
+    RUN_TEST(test_char_scan_matches_reference_at_every_offset);
+    RUN_TEST(test_lexer_long_whitespace_and_identifier_runs);
 }
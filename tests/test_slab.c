@@ -0,0 +1,122 @@
+#include "unity.h"
+#include "memory/slab.h"
+#include <stdint.h> // For uintptr_t
+#include <string.h>
+
+// --- Test Cases ---
+
+static void test_slab_rounds_to_size_classes_and_reuses_blocks(void) {
+    Slab slab;
+    TEST_ASSERT_TRUE(slab_init(&slab));
+    TEST_ASSERT_NULL(slab_alloc(&slab, 0));
+
+    char *small = slab_alloc(&slab, 1);
+    char *mid = slab_alloc(&slab, 100);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(mid);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) small % SLAB_MIN_SIZE);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) mid % SLAB_MIN_SIZE);
+    SlabStats stats = slab_stats(&slab);
+    TEST_ASSERT_EQUAL(SLAB_MIN_SIZE + 128, stats.live_bytes);
+    TEST_ASSERT_EQUAL(2, stats.page_count); // One page per class used
+
+    slab_free(&slab, mid, 100);
+    TEST_ASSERT_EQUAL_PTR(mid, slab_alloc(&slab, 128)); // Same class: the freed block comes back
+    slab_free(&slab, NULL, 8);
+
+    char *zeroed = slab_alloc_zeroed(&slab, 40);
+    TEST_ASSERT_NOT_NULL(zeroed);
+    for (int i = 0; i < 40; ++i) {
+        TEST_ASSERT_EQUAL(0, zeroed[i]);
+    }
+    stats = slab_stats(&slab);
+    TEST_ASSERT_EQUAL(4, stats.alloc_count);
+    TEST_ASSERT_EQUAL(1, stats.free_count);
+    slab_destroy(&slab);
+}
+
+static void test_slab_keeps_memory_flat_under_churn(void) {
+    Slab slab;
+    TEST_ASSERT_TRUE(slab_init(&slab));
+    enum { BLOCKS = 2000, SIZE = 200 }; // 256-byte class: several pages
+    static void *blocks[BLOCKS];
+    size_t peak_pages = 0;
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < BLOCKS; ++i) {
+            blocks[i] = slab_alloc(&slab, SIZE);
+            TEST_ASSERT_NOT_NULL(blocks[i]);
+            memset(blocks[i], round, SIZE);
+        }
+        const SlabStats full = slab_stats(&slab);
+        if (round == 0) {
+            peak_pages = full.page_count;
+        }
+        TEST_ASSERT_EQUAL(peak_pages, full.page_count); // Freed pages are taken again, not added to
+        for (int i = 0; i < BLOCKS; ++i) {
+            slab_free(&slab, blocks[i], SIZE);
+        }
+        const SlabStats empty = slab_stats(&slab);
+        TEST_ASSERT_EQUAL(0, empty.live_bytes);
+        TEST_ASSERT_EQUAL(1, empty.page_count); // Only the class's spare page is kept
+    }
+    TEST_ASSERT_TRUE(peak_pages > 1);
+    slab_destroy(&slab);
+}
+
+static void test_slab_large_blocks_and_destroy_with_live_blocks(void) {
+    Slab slab;
+    TEST_ASSERT_TRUE(slab_init(&slab));
+    char *large = slab_alloc(&slab, SLAB_MAX_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) large % SLAB_MIN_SIZE);
+    memset(large, 7, SLAB_MAX_SIZE + 1);
+    char *other = slab_alloc(&slab, 3 * SLAB_MAX_SIZE);
+    TEST_ASSERT_EQUAL(4 * SLAB_MAX_SIZE + 1, slab_stats(&slab).large_bytes);
+    TEST_ASSERT_EQUAL(0, slab_stats(&slab).page_count);
+    slab_free(&slab, large, SLAB_MAX_SIZE + 1);
+    TEST_ASSERT_EQUAL(3 * SLAB_MAX_SIZE, slab_stats(&slab).large_bytes);
+    TEST_ASSERT_NOT_NULL(other);
+    TEST_ASSERT_NOT_NULL(slab_alloc(&slab, 64));
+    slab_destroy(&slab); // Frees `other` and the page of the 64-byte block
+}
+
+static void test_slab_cache_takes_and_returns_batches(void) {
+    Slab slab;
+    TEST_ASSERT_TRUE(slab_init(&slab));
+    SlabCache cache;
+    slab_cache_init(&cache, &slab);
+
+    void *first = slab_cache_alloc(&cache, 24);
+    TEST_ASSERT_NOT_NULL(first);
+    // A whole batch left the slab; the cache holds all but the one handed out
+    TEST_ASSERT_EQUAL(SLAB_CACHE_BATCH * 32, slab_stats(&slab).live_bytes);
+    TEST_ASSERT_EQUAL(SLAB_CACHE_BATCH - 1, cache.block_counts[1]);
+    slab_cache_free(&cache, first, 24);
+    TEST_ASSERT_EQUAL_PTR(first, slab_cache_alloc(&cache, 32));
+
+    // Frees beyond two batches go back to the slab
+    void *blocks[3 * SLAB_CACHE_BATCH];
+    for (int i = 0; i < 3 * SLAB_CACHE_BATCH; ++i) {
+        blocks[i] = slab_cache_alloc(&cache, 32);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+    }
+    for (int i = 0; i < 3 * SLAB_CACHE_BATCH; ++i) {
+        slab_cache_free(&cache, blocks[i], 32);
+    }
+    TEST_ASSERT_TRUE(cache.block_counts[1] < 2 * SLAB_CACHE_BATCH);
+    slab_cache_free(&cache, first, 32);
+
+    slab_cache_flush(&cache);
+    TEST_ASSERT_EQUAL(0, cache.block_counts[1]);
+    TEST_ASSERT_EQUAL(0, slab_stats(&slab).live_bytes);
+    slab_destroy(&slab);
+}
+
+// --- Test Runner ---
+
+void run_slab_tests(void) {
+    RUN_TEST(test_slab_rounds_to_size_classes_and_reuses_blocks);
+    RUN_TEST(test_slab_keeps_memory_flat_under_churn);
+    RUN_TEST(test_slab_large_blocks_and_destroy_with_live_blocks);
+    RUN_TEST(test_slab_cache_takes_and_returns_batches);
+}
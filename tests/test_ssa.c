@@ -0,0 +1,101 @@
+#include "unity.h"
+#include "../src/ir/ssa.h"
+#include "../src/ir/tac.h"
+#include "../src/memory/arena.h"
+#include <string.h>
+
+// --- Helpers ---
+
+// t1 is set on both sides of a diamond and read where they meet:
+//   0: t0 = 1              B0
+//   1: if_false t0 goto L0
+//   2: t1 = 1              B1
+//   3: goto L1
+//   4: L0:                 B2
+//   5: t1 = 0
+//   6: L1:                 B3
+//   7: return t1
+static TacFunction *create_diamond(Arena *arena) {
+    TacFunction *func = create_tac_function("main", arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand l0 = create_tac_operand_label(0);
+    const TacOperand l1 = create_tac_operand_label(1);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(1), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(t0, l0, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(1), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_goto(l1, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(0), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l1, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t1, arena), arena);
+    return func;
+}
+
+// --- Test Cases ---
+
+void test_ssa_dominator_tree_of_diamond(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_diamond(&arena);
+    SsaFunction ssa;
+    TEST_ASSERT_TRUE(ssa_construct(func, &arena, &ssa));
+    TEST_ASSERT_EQUAL(-1, ssa.idom[0]);
+    TEST_ASSERT_EQUAL(0, ssa.idom[1]);
+    TEST_ASSERT_EQUAL(0, ssa.idom[2]);
+    TEST_ASSERT_EQUAL(0, ssa.idom[3]); // Neither side dominates the join
+    TEST_ASSERT_TRUE(ssa_dominates(&ssa, 0, 3));
+    TEST_ASSERT_FALSE(ssa_dominates(&ssa, 1, 3));
+    TEST_ASSERT_EQUAL(4, ssa.order_count);
+    TEST_ASSERT_EQUAL(0, ssa.preorder[0]);
+    TEST_ASSERT_EQUAL(4, ssa.subtree_end[0]);
+    arena_destroy(&arena);
+}
+
+// Each definition gets its own name and the join reads them through a phi
+void test_ssa_phi_at_join(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_diamond(&arena);
+    SsaFunction ssa;
+    TEST_ASSERT_TRUE(ssa_construct(func, &arena, &ssa));
+
+    TEST_ASSERT_NULL(ssa.phis[0]);
+    TEST_ASSERT_NULL(ssa.phis[1]);
+    TEST_ASSERT_NULL(ssa.phis[2]);
+    const SsaPhi *phi = ssa.phis[3];
+    TEST_ASSERT_NOT_NULL(phi);
+    TEST_ASSERT_NULL(phi->next); // t0 has a single definition: no phi
+    TEST_ASSERT_EQUAL(1, phi->temp);
+    const int then_name = tac_dst(&func->instructions[2]).value.temp_id;
+    const int else_name = tac_dst(&func->instructions[5]).value.temp_id;
+    TEST_ASSERT_NOT_EQUAL(then_name, else_name);
+    TEST_ASSERT_EQUAL(1, ssa.original_of[then_name]);
+    TEST_ASSERT_EQUAL(1, ssa.original_of[else_name]);
+    TEST_ASSERT_EQUAL(then_name, phi->args[0]); // B1 comes first among the predecessors of B3
+    TEST_ASSERT_EQUAL(else_name, phi->args[1]);
+    TEST_ASSERT_EQUAL(phi->name, tac_src(&func->instructions[7]).value.temp_id);
+    TEST_ASSERT_EQUAL(tac_dst(&func->instructions[0]).value.temp_id,
+                      tac_src(&func->instructions[1]).value.temp_id);
+    arena_destroy(&arena);
+}
+
+// Leaving SSA form gives back the function as it was
+void test_ssa_destruct_restores_temps(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_diamond(&arena);
+    TacInstruction before[8];
+    memcpy(before, func->instructions, sizeof(before));
+    SsaFunction ssa;
+    TEST_ASSERT_TRUE(ssa_construct(func, &arena, &ssa));
+    TEST_ASSERT_TRUE(memcmp(before, func->instructions, sizeof(before)) != 0);
+    ssa_destruct(&ssa);
+    TEST_ASSERT_EQUAL_MEMORY(before, func->instructions, sizeof(before));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_ssa_tests(void) {
+    RUN_TEST(test_ssa_dominator_tree_of_diamond);
+    RUN_TEST(test_ssa_phi_at_join);
+    RUN_TEST(test_ssa_destruct_restores_temps);
+}
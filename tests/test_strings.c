@@ -1,7 +1,11 @@
 #include "unity.h"
 #include "../src/strings/strings.h"
+#include "../src/strings/interner.h"
+#include "../src/strings/output_sink.h"
 #include "../src/memory/arena.h"
 #include <string.h> // For strlen
+#include <stdio.h> // For snprintf
+#include <limits.h> // For LLONG_MIN/LLONG_MAX
 
 // --- Test Cases ---
 
@@ -144,6 +148,216 @@ static void test_string_buffer_append_empty(void) {
     arena_destroy(&test_arena);
 }
 
+// Test that a formatted append landing exactly on the capacity boundary is retried after growing
+static void test_string_buffer_append_formatted_retry_on_boundary(void) {
+    Arena test_arena = arena_create(1024);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 8);
+
+    string_buffer_append(&sb, "%d-%s", 12, "abcd"); // 7 chars + NUL: exactly fits
+    TEST_ASSERT_EQUAL_STRING("12-abcd", sb.buffer);
+    TEST_ASSERT_EQUAL(8, sb.capacity);
+
+    string_buffer_append(&sb, "%s", "x"); // Spare is 1 byte: truncated first pass, then retried
+    TEST_ASSERT_EQUAL_STRING("12-abcdx", sb.buffer);
+    TEST_ASSERT_EQUAL(8, sb.length);
+
+    string_buffer_append(&sb, "[%05d|%s]", 42, "a much longer argument than the capacity");
+    TEST_ASSERT_EQUAL_STRING("12-abcdx[00042|a much longer argument than the capacity]", sb.buffer);
+    TEST_ASSERT_EQUAL(strlen(sb.buffer), sb.length);
+
+    arena_destroy(&test_arena);
+}
+
+// Test the verbatim appends: '%' is not interpreted and growth works
+static void test_string_buffer_append_str_and_n(void) {
+    Arena test_arena = arena_create(1024);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 4);
+
+    string_buffer_append_str(&sb, "    movl %eax, -8(%rbp)\n");
+    TEST_ASSERT_EQUAL_STRING("    movl %eax, -8(%rbp)\n", sb.buffer);
+    TEST_ASSERT_EQUAL(strlen("    movl %eax, -8(%rbp)\n"), sb.length);
+
+    string_buffer_append_n(&sb, "retq and more", 4); // Only the first 4 bytes
+    string_buffer_append_str(&sb, "");
+    string_buffer_append_n(&sb, "ignored", 0);
+    TEST_ASSERT_EQUAL_STRING("    movl %eax, -8(%rbp)\nretq", sb.buffer);
+    TEST_ASSERT_EQUAL(strlen(sb.buffer), sb.length);
+
+    arena_destroy(&test_arena);
+}
+
+// Test the hand-rolled integer formatter against printf across edge values
+static void test_string_buffer_append_int(void) {
+    Arena test_arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 2);
+
+    const long long values[] = {0, 7, -7, 10, -10, 123456789, INT_MAX, INT_MIN, LLONG_MAX, LLONG_MIN};
+    char expected[512] = "";
+    size_t expected_length = 0;
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        char digits[DECIMAL_INT_BUFFER_SIZE];
+        const size_t length = format_decimal_int(digits, values[i]);
+        char reference[64];
+        snprintf(reference, sizeof(reference), "%lld", values[i]);
+        TEST_ASSERT_EQUAL_STRING(reference, digits);
+        TEST_ASSERT_EQUAL(strlen(reference), length);
+
+        string_buffer_append_int(&sb, values[i]);
+        string_buffer_append_char(&sb, ' ');
+        expected_length += (size_t) snprintf(expected + expected_length, sizeof(expected) - expected_length,
+                                             "%lld ", values[i]);
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, sb.buffer);
+    TEST_ASSERT_EQUAL(expected_length, sb.length);
+
+    arena_destroy(&test_arena);
+}
+
+// Test that chunked appends match a contiguous buffer and never copy sealed segments
+static void test_string_buffer_chunked_matches_contiguous(void) {
+    Arena test_arena = arena_create(64 * 1024);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    StringBuffer flat;
+    StringBuffer chunked;
+    string_buffer_init(&flat, &test_arena, 16);
+    string_buffer_init_chunked(&chunked, &test_arena, 32);
+
+    for (int i = 0; i < 200; ++i) {
+        string_buffer_append(&flat, "    movl -%d(%%rbp), %%eax\n", i * 8);
+        string_buffer_append(&chunked, "    movl -%d(%%rbp), %%eax\n", i * 8);
+        string_buffer_append_char(&flat, '#');
+        string_buffer_append_char(&chunked, '#');
+    }
+    string_buffer_append_str(&flat, "a long tail that is larger than one whole segment on its own\n");
+    string_buffer_append_str(&chunked, "a long tail that is larger than one whole segment on its own\n");
+    TEST_ASSERT_EQUAL(flat.length, chunked.length);
+
+    // Every filled segment is within the segment size unless one append alone was bigger
+    size_t segments = 0;
+    size_t total = 0;
+    for (const StringSegment *segment = chunked.first_segment; segment; segment = segment->next) {
+        TEST_ASSERT_TRUE(segment->length > 0 && segment->length < 32);
+        total += segment->length;
+        ++segments;
+    }
+    TEST_ASSERT_GREATER_THAN(100, segments);
+    TEST_ASSERT_EQUAL(chunked.length, total + (chunked.length - chunked.segment_base));
+    TEST_ASSERT_NULL(string_buffer_content_str(&chunked)); // No single string until flattened
+
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&flat), string_buffer_flatten(&chunked));
+    TEST_ASSERT_NULL(chunked.first_segment);
+
+    string_buffer_append_str(&chunked, "!");
+    string_buffer_append_str(&flat, "!");
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&flat), string_buffer_flatten(&chunked));
+
+    string_buffer_reset(&chunked);
+    TEST_ASSERT_EQUAL(0, chunked.length);
+    TEST_ASSERT_EQUAL_STRING("", string_buffer_content_str(&chunked));
+
+    arena_destroy(&test_arena);
+}
+
+// Test that a large chunked listing costs about its own size in arena bytes, unlike doubling
+static void test_string_buffer_chunked_uses_less_memory(void) {
+    const char *line = "    movl %r10d, -1024(%rbp)\n";
+    size_t requested[2];
+    for (int mode = 0; mode < 2; ++mode) {
+        Arena test_arena = arena_create(64 * 1024);
+        TEST_ASSERT_NOT_NULL(test_arena.start);
+        StringBuffer sb;
+        if (mode == 0) {
+            string_buffer_init(&sb, &test_arena, 1024);
+        } else {
+            string_buffer_init_chunked(&sb, &test_arena, 4096);
+        }
+        for (int i = 0; i < 40000; ++i) {
+            string_buffer_append_str(&sb, line);
+        }
+        TEST_ASSERT_EQUAL(40000 * strlen(line), sb.length);
+        requested[mode] = arena_stats(&test_arena).alloc_bytes;
+        arena_destroy(&test_arena);
+    }
+    const size_t content = 40000 * strlen(line);
+    TEST_ASSERT_TRUE(requested[0] > content * 3 / 2); // Dead copies left behind by doubling
+    TEST_ASSERT_TRUE(requested[1] < content + content / 10); // Segments plus small headers
+}
+
+// Test walking the segments of a contiguous buffer and stopping early
+static bool count_segment(const char *data, const size_t length, void *context) {
+    (void) data;
+    size_t *count = context;
+    *count += length;
+    return *count < 8;
+}
+
+static void test_string_buffer_for_each_segment(void) {
+    Arena test_arena = arena_create(1024);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 16);
+    size_t count = 0;
+    TEST_ASSERT_TRUE(string_buffer_for_each_segment(&sb, count_segment, &count)); // Empty: no visits
+    TEST_ASSERT_EQUAL(0, count);
+
+    string_buffer_append_str(&sb, "abc");
+    TEST_ASSERT_TRUE(string_buffer_for_each_segment(&sb, count_segment, &count));
+    TEST_ASSERT_EQUAL(3, count);
+
+    StringBuffer chunked;
+    string_buffer_init_chunked(&chunked, &test_arena, 4);
+    string_buffer_append_str(&chunked, "abc");
+    string_buffer_append_str(&chunked, "def");
+    string_buffer_append_str(&chunked, "ghi");
+    count = 0;
+    TEST_ASSERT_FALSE(string_buffer_for_each_segment(&chunked, count_segment, &count)); // Stops after 9 >= 8
+    TEST_ASSERT_EQUAL(9, count);
+
+    arena_destroy(&test_arena);
+}
+
+// Test that a buffer sink keeps everything while a file sink only holds the text since the last flush
+static void test_output_sink_buffer_and_file(void) {
+    Arena test_arena = arena_create(4096);
+    TEST_ASSERT_NOT_NULL(test_arena.start);
+
+    StringBuffer sb;
+    string_buffer_init(&sb, &test_arena, 16);
+    OutputSink buffer_sink;
+    output_sink_init_buffer(&buffer_sink, &sb);
+    string_buffer_append_str(output_sink_buffer(&buffer_sink), "one\n");
+    TEST_ASSERT_TRUE(output_sink_flush(&buffer_sink));
+    string_buffer_append_str(output_sink_buffer(&buffer_sink), "two\n");
+    TEST_ASSERT_TRUE(output_sink_finish(&buffer_sink));
+    TEST_ASSERT_EQUAL_STRING("one\ntwo\n", string_buffer_content_str(&sb));
+    TEST_ASSERT_EQUAL(8, output_sink_total_bytes(&buffer_sink));
+
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    OutputSink file_sink;
+    output_sink_init_file(&file_sink, file, &test_arena);
+    string_buffer_append_str(output_sink_buffer(&file_sink), "one\n");
+    TEST_ASSERT_TRUE(output_sink_flush(&file_sink));
+    TEST_ASSERT_EQUAL(0, output_sink_buffer(&file_sink)->length);
+    string_buffer_append_str(output_sink_buffer(&file_sink), "two\n");
+    TEST_ASSERT_EQUAL(8, output_sink_total_bytes(&file_sink));
+    TEST_ASSERT_TRUE(output_sink_finish(&file_sink));
+
+    char written[16] = {0};
+    rewind(file);
+    TEST_ASSERT_EQUAL(8, fread(written, 1, sizeof(written) - 1, file));
+    TEST_ASSERT_EQUAL_STRING("one\ntwo\n", written);
+    fclose(file);
+
+    arena_destroy(&test_arena);
+}
+
 // Test content access and clearing/resetting
 static void test_string_buffer_content_access_and_reset(void) {
     Arena test_arena = arena_create(1024);
@@ -273,6 +487,69 @@ static void test_arena_strdup_multiple(void) {
     arena_destroy(&test_arena);
 }
 
+// --- Interner Tests ---
+
+static void test_interner_equal_names_share_pointer(void) {
+    Arena test_arena = arena_create(1024);
+    StringInterner interner;
+    TEST_ASSERT_TRUE(interner_init(&interner, &test_arena, 0));
+
+    const char *source = "counter counter count";
+    const char *a = interner_intern_n(&interner, source, 7);
+    const char *b = interner_intern_n(&interner, source + 8, 7);
+    const char *c = interner_intern_n(&interner, source + 16, 5);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQUAL_PTR(a, b);
+    TEST_ASSERT_TRUE(a != c);
+    TEST_ASSERT_EQUAL_STRING("counter", a); // Canonical copies are NUL-terminated
+    TEST_ASSERT_EQUAL_STRING("count", c);
+    TEST_ASSERT_EQUAL_PTR(a, interner_intern(&interner, "counter"));
+    TEST_ASSERT_EQUAL(2, interner.count);
+
+    arena_destroy(&test_arena);
+}
+
+static void test_interner_find_does_not_insert(void) {
+    Arena test_arena = arena_create(1024);
+    StringInterner interner;
+    TEST_ASSERT_TRUE(interner_init(&interner, &test_arena, 0));
+
+    TEST_ASSERT_NULL(interner_find_n(&interner, "x", 1));
+    const size_t offset_before = test_arena.offset;
+    TEST_ASSERT_NULL(interner_find_n(&interner, "x", 1));
+    TEST_ASSERT_EQUAL(offset_before, test_arena.offset);
+    TEST_ASSERT_EQUAL(0, interner.count);
+
+    const char *x = interner_intern(&interner, "x");
+    TEST_ASSERT_EQUAL_PTR(x, interner_find_n(&interner, "x", 1));
+    TEST_ASSERT_NULL(interner_intern(&interner, NULL));
+
+    arena_destroy(&test_arena);
+}
+
+static void test_interner_growth_keeps_canonical_pointers(void) {
+    Arena test_arena = arena_create(1024);
+    StringInterner interner;
+    TEST_ASSERT_TRUE(interner_init(&interner, &test_arena, 0));
+    const size_t initial_capacity = interner.capacity;
+
+    const char *names[500];
+    char name[16];
+    for (int i = 0; i < 500; ++i) {
+        snprintf(name, sizeof(name), "tmp.%d", i);
+        names[i] = interner_intern(&interner, name);
+        TEST_ASSERT_NOT_NULL(names[i]);
+    }
+    TEST_ASSERT_GREATER_THAN(initial_capacity, interner.capacity);
+    TEST_ASSERT_EQUAL(500, interner.count);
+    for (int i = 0; i < 500; ++i) {
+        snprintf(name, sizeof(name), "tmp.%d", i);
+        TEST_ASSERT_EQUAL_PTR(names[i], interner_intern(&interner, name));
+    }
+
+    arena_destroy(&test_arena);
+}
+
 // --- Test Runner --- -
 
 // We need a function to run all tests in this suite
@@ -285,6 +562,13 @@ void run_strings_tests(void) {
     RUN_TEST(test_string_buffer_append_realloc);
     RUN_TEST(test_string_buffer_append_char_realloc);
     RUN_TEST(test_string_buffer_append_empty);
+    RUN_TEST(test_string_buffer_append_formatted_retry_on_boundary);
+    RUN_TEST(test_string_buffer_append_str_and_n);
+    RUN_TEST(test_string_buffer_append_int);
+    RUN_TEST(test_string_buffer_chunked_matches_contiguous);
+    RUN_TEST(test_string_buffer_chunked_uses_less_memory);
+    RUN_TEST(test_string_buffer_for_each_segment);
+    RUN_TEST(test_output_sink_buffer_and_file);
     RUN_TEST(test_string_buffer_content_access_and_reset);
     RUN_TEST(test_string_buffer_free_data_simple);
     RUN_TEST(test_string_buffer_free_data_empty);
@@ -294,4 +578,9 @@ void run_strings_tests(void) {
     RUN_TEST(test_arena_strdup_empty_string);
     RUN_TEST(test_arena_strdup_null_input);
     RUN_TEST(test_arena_strdup_multiple);
+
+    // Interner tests
+    RUN_TEST(test_interner_equal_names_share_pointer);
+    RUN_TEST(test_interner_find_does_not_insert);
+    RUN_TEST(test_interner_growth_keeps_canonical_pointers);
 }
@@ -2,6 +2,7 @@
 #include "../src/memory/arena.h" // For Arena allocator
 #include "../src/ir/tac.h"      // Header for the TAC module we are testing
 #include "../src/strings/strings.h" // For StringBuffer
+#include "../src/compiler/compiler.h" // For compile_and_interpret
 
 #include <stddef.h> // For size_t
 #include <string.h> // For strcmp
@@ -22,12 +23,9 @@ void test_create_operands(void) {
     TEST_ASSERT_EQUAL(5, temp_op.value.temp_id);
 
     // Test Label Operand
-    Arena label_arena = arena_create(256);
-    const char *label_name_str = "L1";
-    TacOperand label_op = create_tac_operand_label(label_name_str);
+    TacOperand label_op = create_tac_operand_label(1);
     TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, label_op.type);
-    TEST_ASSERT_EQUAL_STRING(label_name_str, label_op.value.label_name);
-    arena_destroy(&label_arena);
+    TEST_ASSERT_EQUAL_UINT32(1, label_op.value.label_id);
 }
 
 // Test creating basic instructions
@@ -44,30 +42,30 @@ void test_create_instructions(void) {
     TacInstruction *copy_instr = create_tac_instruction_copy(dst, src_const, &test_arena);
     TEST_ASSERT_NOT_NULL(copy_instr);
     TEST_ASSERT_EQUAL(TAC_INS_COPY, copy_instr->type);
-    TEST_ASSERT_EQUAL(dst.type, copy_instr->operands.copy.dst.type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, copy_instr->operands.copy.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src_const.type, copy_instr->operands.copy.src.type);
-    TEST_ASSERT_EQUAL(src_const.value.constant_value, copy_instr->operands.copy.src.value.constant_value);
+    TEST_ASSERT_EQUAL(dst.type, tac_dst(copy_instr).type);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(copy_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src_const.type, tac_src(copy_instr).type);
+    TEST_ASSERT_EQUAL(src_const.value.constant_value, tac_src(copy_instr).value.constant_value);
 
     // Test NEGATE
     TacInstruction *negate_instr = create_tac_instruction_negate(dst, src_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(negate_instr);
     TEST_ASSERT_EQUAL(TAC_INS_NEGATE, negate_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, negate_instr->operands.unary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src_temp.value.temp_id, negate_instr->operands.unary_op.src.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(negate_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src_temp.value.temp_id, tac_src(negate_instr).value.temp_id);
 
     // Test COMPLEMENT
     TacInstruction *comp_instr = create_tac_instruction_complement(dst, src_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(comp_instr);
     TEST_ASSERT_EQUAL(TAC_INS_COMPLEMENT, comp_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, comp_instr->operands.unary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src_temp.value.temp_id, comp_instr->operands.unary_op.src.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(comp_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src_temp.value.temp_id, tac_src(comp_instr).value.temp_id);
 
     // Test RETURN
     TacInstruction *ret_instr = create_tac_instruction_return(src_const, &test_arena);
     TEST_ASSERT_NOT_NULL(ret_instr);
     TEST_ASSERT_EQUAL(TAC_INS_RETURN, ret_instr->type);
-    TEST_ASSERT_EQUAL(src_const.value.constant_value, ret_instr->operands.ret.src.value.constant_value);
+    TEST_ASSERT_EQUAL(src_const.value.constant_value, tac_src(ret_instr).value.constant_value);
 
     // Destroy the local arena
     arena_destroy(&test_arena);
@@ -88,41 +86,41 @@ void test_create_binary_instructions(void) {
     TacInstruction *add_instr = create_tac_instruction_add(dst, src1_temp, src2_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(add_instr);
     TEST_ASSERT_EQUAL(TAC_INS_ADD, add_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, add_instr->operands.binary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, add_instr->operands.binary_op.src1.value.temp_id);
-    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, add_instr->operands.binary_op.src2.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(add_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src1(add_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, tac_src2(add_instr).value.temp_id);
 
     // Test SUB (const - temp)
     TacInstruction *sub_instr = create_tac_instruction_sub(dst, src1_const, src2_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(sub_instr);
     TEST_ASSERT_EQUAL(TAC_INS_SUB, sub_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, sub_instr->operands.binary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_const.value.constant_value, sub_instr->operands.binary_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, sub_instr->operands.binary_op.src2.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(sub_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_const.value.constant_value, tac_src1(sub_instr).value.constant_value);
+    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, tac_src2(sub_instr).value.temp_id);
 
     // Test MUL (temp * const)
     TacInstruction *mul_instr = create_tac_instruction_mul(dst, src1_temp, src2_const, &test_arena);
     TEST_ASSERT_NOT_NULL(mul_instr);
     TEST_ASSERT_EQUAL(TAC_INS_MUL, mul_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, mul_instr->operands.binary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, mul_instr->operands.binary_op.src1.value.temp_id);
-    TEST_ASSERT_EQUAL(src2_const.value.constant_value, mul_instr->operands.binary_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(mul_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src1(mul_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src2_const.value.constant_value, tac_src2(mul_instr).value.constant_value);
 
     // Test DIV (const / const)
     TacInstruction *div_instr = create_tac_instruction_div(dst, src1_const, src2_const, &test_arena);
     TEST_ASSERT_NOT_NULL(div_instr);
     TEST_ASSERT_EQUAL(TAC_INS_DIV, div_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, div_instr->operands.binary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_const.value.constant_value, div_instr->operands.binary_op.src1.value.constant_value);
-    TEST_ASSERT_EQUAL(src2_const.value.constant_value, div_instr->operands.binary_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(div_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_const.value.constant_value, tac_src1(div_instr).value.constant_value);
+    TEST_ASSERT_EQUAL(src2_const.value.constant_value, tac_src2(div_instr).value.constant_value);
 
     // Test MOD (temp % temp)
     TacInstruction *mod_instr = create_tac_instruction_mod(dst, src1_temp, src2_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(mod_instr);
     TEST_ASSERT_EQUAL(TAC_INS_MOD, mod_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, mod_instr->operands.binary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, mod_instr->operands.binary_op.src1.value.temp_id);
-    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, mod_instr->operands.binary_op.src2.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(mod_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src1(mod_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, tac_src2(mod_instr).value.temp_id);
 
     arena_destroy(&test_arena);
 }
@@ -141,51 +139,51 @@ void test_create_new_tac_instructions(void) {
     TacInstruction *logical_not_instr = create_tac_instruction_logical_not(dst, src1_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(logical_not_instr);
     TEST_ASSERT_EQUAL(TAC_INS_LOGICAL_NOT, logical_not_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, logical_not_instr->operands.unary_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, logical_not_instr->operands.unary_op.src.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(logical_not_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src(logical_not_instr).value.temp_id);
 
     // Test LESS (dst = src1_temp < src2_temp)
     TacInstruction *less_instr = create_tac_instruction_less(dst, src1_temp, src2_temp, &test_arena);
     TEST_ASSERT_NOT_NULL(less_instr);
     TEST_ASSERT_EQUAL(TAC_INS_LESS, less_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, less_instr->operands.relational_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, less_instr->operands.relational_op.src1.value.temp_id);
-    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, less_instr->operands.relational_op.src2.value.temp_id);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(less_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src1(less_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src2_temp.value.temp_id, tac_src2(less_instr).value.temp_id);
 
     // Test GREATER_EQUAL (dst = src1_temp >= const_op)
     TacInstruction *ge_instr = create_tac_instruction_greater_equal(dst, src1_temp, const_op, &test_arena);
     TEST_ASSERT_NOT_NULL(ge_instr);
     TEST_ASSERT_EQUAL(TAC_INS_GREATER_EQUAL, ge_instr->type);
-    TEST_ASSERT_EQUAL(dst.value.temp_id, ge_instr->operands.relational_op.dst.value.temp_id);
-    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, ge_instr->operands.relational_op.src1.value.temp_id);
-    TEST_ASSERT_EQUAL(const_op.value.constant_value, ge_instr->operands.relational_op.src2.value.constant_value);
+    TEST_ASSERT_EQUAL(dst.value.temp_id, tac_dst(ge_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(src1_temp.value.temp_id, tac_src1(ge_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(const_op.value.constant_value, tac_src2(ge_instr).value.constant_value);
 
-    // Test LABEL (LBL1:)
-    const char *lbl_name = "LBL1";
-    TacOperand label_op_def = create_tac_operand_label(lbl_name);
+    // Test LABEL (L1:)
+    const uint32_t lbl_id = 1;
+    TacOperand label_op_def = create_tac_operand_label(lbl_id);
     TacInstruction *label_instr = create_tac_instruction_label(label_op_def, &test_arena);
     TEST_ASSERT_NOT_NULL(label_instr);
     TEST_ASSERT_EQUAL(TAC_INS_LABEL, label_instr->type);
-    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, label_instr->operands.label_def.label.type);
-    TEST_ASSERT_EQUAL_STRING(lbl_name, label_instr->operands.label_def.label.value.label_name);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, tac_label(label_instr).type);
+    TEST_ASSERT_EQUAL_UINT32(lbl_id, tac_label(label_instr).value.label_id);
 
-    // Test GOTO (GOTO LBL1)
-    TacOperand target_label_op = create_tac_operand_label(lbl_name);
+    // Test GOTO (GOTO L1)
+    TacOperand target_label_op = create_tac_operand_label(lbl_id);
     TacInstruction *goto_instr = create_tac_instruction_goto(target_label_op, &test_arena);
     TEST_ASSERT_NOT_NULL(goto_instr);
     TEST_ASSERT_EQUAL(TAC_INS_GOTO, goto_instr->type);
-    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, goto_instr->operands.go_to.target_label.type);
-    TEST_ASSERT_EQUAL_STRING(lbl_name, goto_instr->operands.go_to.target_label.value.label_name);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, tac_label(goto_instr).type);
+    TEST_ASSERT_EQUAL_UINT32(lbl_id, tac_label(goto_instr).value.label_id);
 
-    // Test IF_FALSE_GOTO (IF_FALSE src1_temp GOTO LBL1)
+    // Test IF_FALSE_GOTO (IF_FALSE src1_temp GOTO L1)
     TacInstruction *if_false_goto_instr = create_tac_instruction_if_false_goto(src1_temp, target_label_op, &test_arena);
     TEST_ASSERT_NOT_NULL(if_false_goto_instr);
     TEST_ASSERT_EQUAL(TAC_INS_IF_FALSE_GOTO, if_false_goto_instr->type);
-    TEST_ASSERT_EQUAL(src1_temp.type, if_false_goto_instr->operands.conditional_goto.condition_src.type);
+    TEST_ASSERT_EQUAL(src1_temp.type, tac_src(if_false_goto_instr).type);
     TEST_ASSERT_EQUAL(src1_temp.value.temp_id,
-                      if_false_goto_instr->operands.conditional_goto.condition_src.value.temp_id);
-    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, if_false_goto_instr->operands.conditional_goto.target_label.type);
-    TEST_ASSERT_EQUAL_STRING(lbl_name, if_false_goto_instr->operands.conditional_goto.target_label.value.label_name);
+                      tac_src(if_false_goto_instr).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, tac_label(if_false_goto_instr).type);
+    TEST_ASSERT_EQUAL_UINT32(lbl_id, tac_label(if_false_goto_instr).value.label_id);
 
     arena_destroy(&test_arena);
 }
@@ -234,8 +232,8 @@ void test_add_instructions(void) {
         TEST_ASSERT_EQUAL(i + 1, func->instruction_count);
         TEST_ASSERT_EQUAL(initial_capacity, func->instruction_capacity);
         TEST_ASSERT_EQUAL(TAC_INS_COPY, func->instructions[i].type);
-        TEST_ASSERT_EQUAL(t0.value.temp_id, func->instructions[i].operands.copy.dst.value.temp_id);
-        TEST_ASSERT_EQUAL(c10.value.constant_value, func->instructions[i].operands.copy.src.value.constant_value);
+        TEST_ASSERT_EQUAL(t0.value.temp_id, tac_dst(&func->instructions[i]).value.temp_id);
+        TEST_ASSERT_EQUAL(c10.value.constant_value, tac_src(&func->instructions[i]).value.constant_value);
     }
 
     // Add one more instruction to trigger reallocation
@@ -248,7 +246,7 @@ void test_add_instructions(void) {
 
     // Verify the instruction added after reallocation is correct
     TEST_ASSERT_EQUAL(TAC_INS_RETURN, func->instructions[initial_capacity].type);
-    TEST_ASSERT_EQUAL(t0.value.temp_id, func->instructions[initial_capacity].operands.ret.src.value.temp_id);
+    TEST_ASSERT_EQUAL(t0.value.temp_id, tac_src(&func->instructions[initial_capacity]).value.temp_id);
 
     // Add more to potentially trigger another realloc (depending on growth factor)
     size_t final_capacity = func->instruction_capacity;
@@ -316,6 +314,66 @@ void test_add_functions(void) {
     arena_destroy(&test_arena);
 }
 
+// Reserving up front: appending within the reserved capacity copies nothing
+void test_reserve_instructions(void) {
+    Arena test_arena = arena_create(8192);
+    TacFunction *func = create_tac_function("reserved_func", &test_arena);
+    tac_function_reserve(func, 100, &test_arena);
+    TEST_ASSERT_EQUAL(100, func->instruction_capacity);
+    tac_function_reserve(func, 10, &test_arena); // Already fits
+    TEST_ASSERT_EQUAL(100, func->instruction_capacity);
+
+    const TacInstruction *array = func->instructions;
+    for (int i = 0; i < 100; ++i) {
+        add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(i), &test_arena),
+                                    &test_arena);
+    }
+    TEST_ASSERT_EQUAL_PTR(array, func->instructions);
+    TEST_ASSERT_EQUAL(0, func->instruction_regrowths);
+
+    // One past the reservation grows by copying, and is counted
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(100), &test_arena),
+                                &test_arena);
+    TEST_ASSERT_EQUAL(1, func->instruction_regrowths);
+    TEST_ASSERT_EQUAL(99, tac_src(&func->instructions[99]).value.constant_value);
+    arena_destroy(&test_arena);
+}
+
+// Test the packed encoding: 16 bytes per instruction, operands rebuilt intact from their slots
+void test_packed_instruction_layout(void) {
+    Arena test_arena = arena_create(1024);
+    TEST_ASSERT_EQUAL(16, sizeof(TacInstruction));
+
+    TacInstruction *instr = create_tac_instruction_less(create_tac_operand_temp(7), create_tac_operand_const(-1),
+                                                        create_tac_operand_temp(0), &test_arena);
+    TEST_ASSERT_EQUAL(TAC_INS_LESS, instr->type);
+    TEST_ASSERT_TRUE(tac_instruction_has_def(instr));
+    TEST_ASSERT_EQUAL(2, tac_instruction_use_count(instr));
+    TEST_ASSERT_EQUAL(TAC_OPERAND_TEMP, tac_operand_kind(instr, TAC_SLOT_DST));
+    TEST_ASSERT_EQUAL(7, tac_dst(instr).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_CONST, tac_src1(instr).type);
+    TEST_ASSERT_EQUAL(-1, tac_src1(instr).value.constant_value); // Negative payloads survive the round trip
+    TEST_ASSERT_TRUE(tac_slot_is_temp(instr, TAC_SLOT_SRC2));
+
+    // Overwriting one slot leaves the kinds of the others alone
+    tac_set_operand(instr, TAC_SLOT_SRC1, create_tac_operand_temp(3));
+    TEST_ASSERT_EQUAL(TAC_OPERAND_TEMP, tac_src1(instr).type);
+    TEST_ASSERT_EQUAL(3, tac_src1(instr).value.temp_id);
+    TEST_ASSERT_EQUAL(TAC_OPERAND_TEMP, tac_dst(instr).type);
+    TEST_ASSERT_EQUAL(0, tac_src2(instr).value.temp_id);
+
+    // A conditional jump reads its condition and names a label, but writes nothing
+    instr = create_tac_instruction_if_false_goto(create_tac_operand_temp(2), create_tac_operand_label(UINT32_MAX - 1),
+                                                 &test_arena);
+    TEST_ASSERT_FALSE(tac_instruction_has_def(instr));
+    TEST_ASSERT_EQUAL(1, tac_instruction_use_count(instr));
+    TEST_ASSERT_EQUAL(TAC_OPERAND_LABEL, tac_label(instr).type);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX - 1, tac_label(instr).value.label_id);
+    TEST_ASSERT_EQUAL(2, tac_src(instr).value.temp_id);
+
+    arena_destroy(&test_arena);
+}
+
 // Test the TAC pretty printing functionality
 static void test_print_tac_program(void) {
     Arena test_arena = arena_create(8192); // Increased from 2048
@@ -348,10 +406,8 @@ static void test_print_tac_program(void) {
     TacOperand const_bool_true = create_tac_operand_const(1); // For boolean true
 
     // Operands for control flow
-    const char *label_L0_name = "L0";
-    const char *label_L1_name = "L1";
-    TacOperand label_L0 = create_tac_operand_label(label_L0_name);
-    TacOperand label_L1 = create_tac_operand_label(label_L1_name);
+    TacOperand label_L0 = create_tac_operand_label(0);
+    TacOperand label_L1 = create_tac_operand_label(1);
 
     // 5. Create and add TacInstructions to the function
     TacInstruction *instr1 = create_tac_instruction_copy(t0, const_val2, &test_arena);
@@ -439,6 +495,31 @@ static void test_print_tac_program(void) {
 
 // --- Test Runner ---
 
+// The interpreter as an oracle: the optimized TAC must compute what the unoptimized TAC does
+static void test_optimizer_agrees_with_interpreter(void) {
+    static const struct {
+        const char *source;
+        int expected;
+    } programs[] = {
+            {"int main(void) { return (1 + 2) * (3 - 4) / 2 % 5 + !6; }", -1},
+            {"int main(void) { int a = 3; int b = a * a; a = b - a; return a > b || a == 6 && b != 9; }", 0},
+            {"int main(void) { int x = 7; int y = x + 1; int z = x + 1; return (y == z) + y * (x < y); }", 9},
+            {"int main(void) { int a = 2; int b = 0; b = (a > 1) * a * 10 - (a <= 1) * a; return b + (a && b); }", 21},
+    };
+    CompileOptions options;
+    compile_options_init(&options);
+    options.fuse_validation = true;
+    options.quiet = true;
+    for (size_t i = 0; i < sizeof(programs) / sizeof(programs[0]); ++i) {
+        for (int level = 0; level <= 1; ++level) {
+            options.optimization_level = level;
+            int result = 0;
+            TEST_ASSERT_TRUE(compile_and_interpret(programs[i].source, strlen(programs[i].source), &options, &result));
+            TEST_ASSERT_EQUAL_MESSAGE(programs[i].expected, result, programs[i].source);
+        }
+    }
+}
+
 void run_tac_tests(void) {
     RUN_TEST(test_create_operands);
     RUN_TEST(test_create_instructions);
@@ -448,5 +529,8 @@ void run_tac_tests(void) {
     RUN_TEST(test_add_instructions);
     RUN_TEST(test_create_program);
     RUN_TEST(test_add_functions);
+    RUN_TEST(test_reserve_instructions);
+    RUN_TEST(test_packed_instruction_layout);
     RUN_TEST(test_print_tac_program);
+    RUN_TEST(test_optimizer_agrees_with_interpreter);
 }
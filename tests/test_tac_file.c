@@ -0,0 +1,297 @@
+#include "unity.h"
+#include "../src/ir/tac_file.h"
+#include "../src/ir/tac.h"
+#include "../src/compiler/compiler.h"
+#include "../src/compiler/options.h"
+#include "../src/strings/strings.h"
+#include "../src/strings/output_sink.h"
+#include "../src/memory/arena.h"
+#include <stdio.h>
+#include <string.h>
+
+// --- Helpers ---
+
+static const char *listing(const TacProgram *program, Arena *arena) {
+    StringBuffer sb;
+    string_buffer_init(&sb, arena, 256);
+    tac_print_program(&sb, program);
+    return string_buffer_content_str(&sb);
+}
+
+static void write_bytes_to(const char *filename, const void *data, const size_t size) {
+    FILE *f = fopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(size, fwrite(data, 1, size, f));
+    fclose(f);
+}
+
+// --- Test Cases ---
+
+// A module reloads to the same program, and that program compiles to the same code
+static void test_tac_file_round_trip(void) {
+    Arena arena = arena_create(64 * 1024);
+    const char *source = "int main(void) { int a = 6; int b = a * 7; return (b > 40 && a < 10) || b - 2; }";
+    CompileOptions options;
+    compile_options_init(&options);
+    options.fuse_validation = true;
+    TacProgram *program = NULL;
+    TEST_ASSERT_TRUE(compile_source_to_tac(source, strlen(source), &options, &arena, &program));
+    const char *filename = "test_tac_file_round_trip.ctac";
+    TEST_ASSERT_TRUE(tac_file_write(program, filename));
+
+    TacProgram *loaded = create_tac_program(&arena);
+    TacModule module;
+    TEST_ASSERT_TRUE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+    TEST_ASSERT_EQUAL(1, module.function_count);
+    TEST_ASSERT_EQUAL(1, loaded->function_count);
+    TEST_ASSERT_EQUAL_STRING("main", loaded->functions[0]->name);
+    TEST_ASSERT_EQUAL_STRING(listing(program, &arena), listing(loaded, &arena));
+
+    StringBuffer expected;
+    StringBuffer actual;
+    string_buffer_init(&expected, &arena, 256);
+    string_buffer_init(&actual, &arena, 256);
+    OutputSink sink;
+    output_sink_init_buffer(&sink, &expected);
+    TEST_ASSERT_TRUE(compile_tac_with_sink(program, &options, &sink, &arena, NULL));
+    output_sink_init_buffer(&sink, &actual);
+    TEST_ASSERT_TRUE(compile_tac_with_sink(loaded, &options, &sink, &arena, NULL));
+    TEST_ASSERT_EQUAL_STRING(string_buffer_content_str(&expected), string_buffer_content_str(&actual));
+
+    // Appending to a loaded function moves its instructions out of the mapping
+    TacFunction *func = loaded->functions[0];
+    const size_t count = func->instruction_count;
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(1), &arena), &arena);
+    TEST_ASSERT_EQUAL(count + 1, func->instruction_count);
+
+    tac_file_unload(&module);
+    remove(filename);
+    arena_destroy(&arena);
+}
+
+// Compiles a source into a module file
+static void write_module(const char *source, const char *filename, Arena *arena) {
+    CompileOptions options;
+    compile_options_init(&options);
+    options.fuse_validation = true;
+    TacProgram *program = NULL;
+    TEST_ASSERT_TRUE(compile_source_to_tac(source, strlen(source), &options, arena, &program));
+    TEST_ASSERT_TRUE(tac_file_write(program, filename));
+}
+
+// Modules append their functions after those already loaded
+static void test_tac_file_loads_several_modules(void) {
+    Arena arena = arena_create(64 * 1024);
+    write_module("int main(void) { return 4; }", "test_tac_file_a.ctac", &arena);
+    TEST_ASSERT_TRUE(tac_file_write(create_tac_program(&arena), "test_tac_file_b.ctac"));
+
+    TacProgram *linked = create_tac_program(&arena);
+    TacModule modules[2];
+    TEST_ASSERT_TRUE(tac_file_load("test_tac_file_a.ctac", linked, modules, 0, &arena, &modules[0]));
+    TEST_ASSERT_TRUE(tac_file_load("test_tac_file_b.ctac", linked, modules, 1, &arena, &modules[1]));
+    TEST_ASSERT_EQUAL(1, linked->function_count);
+    TEST_ASSERT_EQUAL_STRING("main", linked->functions[0]->name);
+    TEST_ASSERT_EQUAL(0, modules[0].first_function);
+    TEST_ASSERT_EQUAL(1, modules[1].first_function);
+    TEST_ASSERT_EQUAL(0, modules[1].function_count);
+    TEST_ASSERT_EQUAL_STRING("test_tac_file_a.ctac", modules[0].filename);
+
+    for (int i = 0; i < 2; ++i) {
+        tac_file_unload(&modules[i]);
+    }
+    remove("test_tac_file_a.ctac");
+    remove("test_tac_file_b.ctac");
+    arena_destroy(&arena);
+}
+
+// Every parsed program defines main, so two real modules collide: the second is rejected whole
+static void test_tac_file_rejects_duplicate_functions(void) {
+    Arena arena = arena_create(64 * 1024);
+    write_module("int main(void) { return 1; }", "test_tac_file_first.ctac", &arena);
+    write_module("int main(void) { int a = 2; return a * 3; }", "test_tac_file_second.ctac", &arena);
+
+    TacProgram *linked = create_tac_program(&arena);
+    TacModule modules[2];
+    TEST_ASSERT_TRUE(tac_file_load("test_tac_file_first.ctac", linked, modules, 0, &arena, &modules[0]));
+    TEST_ASSERT_FALSE(tac_file_load("test_tac_file_second.ctac", linked, modules, 1, &arena, &modules[1]));
+    TEST_ASSERT_EQUAL(1, linked->function_count);
+    TEST_ASSERT_EQUAL(1, (int) linked->functions[0]->instructions[0].payloads[TAC_SLOT_SRC1]);
+
+    // A module naming a function twice is rejected on its own as well
+    TacProgram *twice = create_tac_program(&arena);
+    for (int i = 0; i < 2; ++i) {
+        TacFunction *func = create_tac_function("main", &arena);
+        add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(i), &arena),
+                                    &arena);
+        add_function_to_program(twice, func, &arena);
+    }
+    TEST_ASSERT_TRUE(tac_file_write(twice, "test_tac_file_twice.ctac"));
+    TacProgram *empty = create_tac_program(&arena);
+    TEST_ASSERT_FALSE(tac_file_load("test_tac_file_twice.ctac", empty, NULL, 0, &arena, &modules[1]));
+    TEST_ASSERT_EQUAL(0, empty->function_count);
+
+    tac_file_unload(&modules[0]);
+    remove("test_tac_file_first.ctac");
+    remove("test_tac_file_second.ctac");
+    remove("test_tac_file_twice.ctac");
+    arena_destroy(&arena);
+}
+
+// Damaged modules are rejected and leave the program as it was
+static void test_tac_file_rejects_damaged_modules(void) {
+    Arena arena = arena_create(16 * 1024);
+    TacProgram *program = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(0), &arena), &arena);
+    add_function_to_program(program, func, &arena);
+    const char *filename = "test_tac_file_damaged.ctac";
+    TEST_ASSERT_TRUE(tac_file_write(program, filename));
+    FILE *f = fopen(filename, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    char bytes[512];
+    const size_t size = fread(bytes, 1, sizeof(bytes), f);
+    fclose(f);
+    TEST_ASSERT_TRUE(size > sizeof(TacFileHeader) + sizeof(TacInstruction));
+
+    TacProgram *loaded = create_tac_program(&arena);
+    TacModule module;
+    char damaged[512];
+
+    memcpy(damaged, bytes, size);
+    damaged[0] = 'X'; // Magic
+    write_bytes_to(filename, damaged, size);
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+
+    write_bytes_to(filename, bytes, size - 1); // Truncated instruction array
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+
+    memcpy(damaged, bytes, size);
+    damaged[size - sizeof(TacInstruction)] = (char) 0xff; // Opcode of the only instruction
+    write_bytes_to(filename, damaged, size);
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+
+    TEST_ASSERT_EQUAL(0, loaded->function_count);
+    TEST_ASSERT_FALSE(tac_file_load("test_tac_file_missing.ctac", loaded, NULL, 0, &arena, &module));
+    remove(filename);
+    arena_destroy(&arena);
+}
+
+// Reads a whole module file into `bytes`, returning its size
+static size_t read_bytes_from(const char *filename, char *bytes, const size_t capacity) {
+    FILE *f = fopen(filename, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    const size_t size = fread(bytes, 1, capacity, f);
+    fclose(f);
+    TEST_ASSERT_TRUE(size < capacity);
+    return size;
+}
+
+// Writes `bytes` with one instruction payload replaced and checks the module is refused
+static void assert_payload_rejected(const char *filename, const char *bytes, const size_t size,
+                                    const size_t instruction, const TacOperandSlot slot, const uint32_t payload) {
+    char forged[1024];
+    memcpy(forged, bytes, size);
+    TacInstruction *instructions = (TacInstruction *) (forged + size) - 5;
+    instructions[instruction].payloads[slot] = payload;
+    write_bytes_to(filename, forged, size);
+    Arena arena = arena_create(4096);
+    TacProgram *loaded = create_tac_program(&arena);
+    TacModule module;
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+    TEST_ASSERT_EQUAL(0, loaded->function_count);
+    arena_destroy(&arena);
+}
+
+// Forged operands are rejected: ids past the instruction count, a jump to no label, a kind the opcode does not take
+static void test_tac_file_rejects_malformed_instructions(void) {
+    Arena arena = arena_create(16 * 1024);
+    TacProgram *program = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(0),
+                                                                  create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(create_tac_operand_temp(0),
+                                                                           create_tac_operand_label(0), &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_const(1), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(create_tac_operand_label(0), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(0), &arena), &arena);
+    add_function_to_program(program, func, &arena);
+    const char *filename = "test_tac_file_forged.ctac";
+    TEST_ASSERT_TRUE(tac_file_write(program, filename));
+    char bytes[1024];
+    const size_t size = read_bytes_from(filename, bytes, sizeof(bytes));
+
+    TacProgram *loaded = create_tac_program(&arena);
+    TacModule module;
+    TEST_ASSERT_TRUE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+    tac_file_unload(&module);
+    loaded = create_tac_program(&arena);
+
+    assert_payload_rejected(filename, bytes, size, 0, TAC_SLOT_DST, 0x70000000);   // Temp id sizing a huge frame
+    assert_payload_rejected(filename, bytes, size, 1, TAC_SLOT_LABEL, 0x7fffffff); // Label id past the count
+    assert_payload_rejected(filename, bytes, size, 1, TAC_SLOT_LABEL, 1);          // Label never defined
+    assert_payload_rejected(filename, bytes, size, 2, TAC_SLOT_DST, 3);            // Slot a return leaves unused
+
+    // A return of a label, and a jump whose target is a constant
+    char forged[1024];
+    memcpy(forged, bytes, size);
+    TacInstruction *instructions = (TacInstruction *) (forged + size) - 5;
+    tac_set_operand(&instructions[2], TAC_SLOT_SRC1, create_tac_operand_label(0));
+    write_bytes_to(filename, forged, size);
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+    memcpy(forged, bytes, size);
+    tac_set_operand(&instructions[1], TAC_SLOT_LABEL, create_tac_operand_const(0));
+    write_bytes_to(filename, forged, size);
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+
+    // The label defined twice
+    memcpy(forged, bytes, size);
+    instructions[2] = instructions[3];
+    write_bytes_to(filename, forged, size);
+    TEST_ASSERT_FALSE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+
+    TEST_ASSERT_EQUAL(0, loaded->function_count);
+    remove(filename);
+    arena_destroy(&arena);
+}
+
+// Ids the optimizer left sparse are renumbered on writing, so the module passes the loader's bounds
+static void test_tac_file_renumbers_sparse_ids(void) {
+    Arena arena = arena_create(16 * 1024);
+    TacProgram *program = create_tac_program(&arena);
+    TacFunction *func = create_tac_function("main", &arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(create_tac_operand_temp(1000),
+                                                                  create_tac_operand_const(7), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_goto(create_tac_operand_label(500), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_label(create_tac_operand_label(500), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(create_tac_operand_temp(1000), &arena), &arena);
+    add_function_to_program(program, func, &arena);
+    const char *filename = "test_tac_file_sparse.ctac";
+    TEST_ASSERT_TRUE(tac_file_write(program, filename));
+
+    TacProgram *loaded = create_tac_program(&arena);
+    TacModule module;
+    TEST_ASSERT_TRUE(tac_file_load(filename, loaded, NULL, 0, &arena, &module));
+    TEST_ASSERT_EQUAL_STRING("program:\n"
+                             "  function main:\n"
+                             "    t0 = 7\n"
+                             "    goto L0\n"
+                             "    L0:\n"
+                             "    return t0\n"
+                             "end program\n",
+                             listing(loaded, &arena));
+    tac_file_unload(&module);
+    remove(filename);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_tac_file_tests(void) {
+    RUN_TEST(test_tac_file_round_trip);
+    RUN_TEST(test_tac_file_loads_several_modules);
+    RUN_TEST(test_tac_file_rejects_duplicate_functions);
+    RUN_TEST(test_tac_file_rejects_damaged_modules);
+    RUN_TEST(test_tac_file_rejects_malformed_instructions);
+    RUN_TEST(test_tac_file_renumbers_sparse_ids);
+}
@@ -0,0 +1,103 @@
+#include "unity.h"
+#include "../src/ir/tac_interpreter.h"
+#include "../src/ir/tac.h"
+#include "../src/memory/arena.h"
+
+// --- Helpers ---
+
+// Sums 1..n with a backward jump, as no lowering emits yet:
+//   t0 = 0; t1 = n
+//   L0: if_false t1 goto L1
+//   t0 = t0 + t1; t1 = t1 - 1; goto L0
+//   L1: return t0
+static TacFunction *create_sum_loop(const int n, Arena *arena) {
+    TacFunction *func = create_tac_function("main", arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand l0 = create_tac_operand_label(0);
+    const TacOperand l1 = create_tac_operand_label(1);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(0), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_copy(t1, create_tac_operand_const(n), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l0, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_if_false_goto(t1, l1, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t0, t0, t1, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_sub(t1, t1, create_tac_operand_const(1), arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_goto(l0, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_label(l1, arena), arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, arena), arena);
+    return func;
+}
+
+// --- Test Cases ---
+
+static void test_interpreter_runs_loop_repeatedly(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_sum_loop(100, &arena);
+    TacInterpretedFunction decoded;
+    TEST_ASSERT_TRUE(tac_interpreter_decode(func, &arena, &decoded));
+    TEST_ASSERT_EQUAL(7, decoded.count); // Labels are gone
+    for (int run = 0; run < 3; ++run) {
+        int result = -1;
+        TEST_ASSERT_TRUE(tac_interpreter_run(&decoded, &result));
+        TEST_ASSERT_EQUAL(5050, result); // Every run starts from the initial registers
+    }
+    arena_destroy(&arena);
+}
+
+// Wrapping arithmetic, swapped comparisons and running off the end
+static void test_interpreter_operators(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    const TacOperand t1 = create_tac_operand_temp(1);
+    const TacOperand t2 = create_tac_operand_temp(2);
+    add_instruction_to_function(func, create_tac_instruction_copy(t0, create_tac_operand_const(2147483647), &arena),
+                                &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t0, t0, create_tac_operand_const(1), &arena),
+                                &arena); // INT_MIN
+    add_instruction_to_function(func, create_tac_instruction_greater(t1, create_tac_operand_const(0), t0, &arena),
+                                &arena); // 0 > INT_MIN
+    add_instruction_to_function(func, create_tac_instruction_mod(t2, create_tac_operand_const(-7),
+                                                                 create_tac_operand_const(3), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_add(t1, t1, t2, &arena), &arena); // 1 + -1
+    TacProgram *program = create_tac_program(&arena);
+    add_function_to_program(program, func, &arena);
+
+    int result = -1;
+    TEST_ASSERT_TRUE(tac_interpret_program(program, "main", &arena, &result));
+    TEST_ASSERT_EQUAL(0, result); // No return: main returns 0
+
+    add_instruction_to_function(func, create_tac_instruction_return(t1, &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+    TEST_ASSERT_TRUE(tac_interpret_program(program, "main", &arena, &result));
+    TEST_ASSERT_EQUAL(0, result);
+    arena_destroy(&arena);
+}
+
+static void test_interpreter_reports_errors(void) {
+    Arena arena = arena_create(4096);
+    TacFunction *func = create_tac_function("main", &arena);
+    const TacOperand t0 = create_tac_operand_temp(0);
+    add_instruction_to_function(func, create_tac_instruction_div(t0, create_tac_operand_const(1),
+                                                                 create_tac_operand_const(0), &arena), &arena);
+    add_instruction_to_function(func, create_tac_instruction_return(t0, &arena), &arena);
+    TacProgram *program = create_tac_program(&arena);
+    add_function_to_program(program, func, &arena);
+    int result = 0;
+    TEST_ASSERT_FALSE(tac_interpret_program(program, "main", &arena, &result)); // Division trap
+    TEST_ASSERT_FALSE(tac_interpret_program(program, "other", &arena, &result));
+
+    TacFunction *jumper = create_tac_function("main", &arena);
+    add_instruction_to_function(jumper, create_tac_instruction_goto(create_tac_operand_label(3), &arena), &arena);
+    TacInterpretedFunction decoded;
+    TEST_ASSERT_FALSE(tac_interpreter_decode(jumper, &arena, &decoded));
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_tac_interpreter_tests(void) {
+    RUN_TEST(test_interpreter_runs_loop_repeatedly);
+    RUN_TEST(test_interpreter_operators);
+    RUN_TEST(test_interpreter_reports_errors);
+}
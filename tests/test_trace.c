@@ -0,0 +1,100 @@
+#include "unity.h"
+#include "../src/compiler/trace.h"
+#include "../src/compiler/compiler.h"
+#include "../src/memory/arena.h"
+#include "../src/strings/strings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const TRACE_FILE = "test_trace.json";
+
+// --- Helpers ---
+
+// Reads the whole trace file; to be freed by the caller
+static char *read_trace(void) {
+    FILE *f = fopen(TRACE_FILE, "r");
+    TEST_ASSERT_NOT_NULL(f);
+    fseek(f, 0, SEEK_END);
+    const long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *json = malloc((size_t) length + 1);
+    TEST_ASSERT_NOT_NULL(json);
+    TEST_ASSERT_EQUAL(length, (long) fread(json, 1, (size_t) length, f));
+    json[length] = '\0';
+    fclose(f);
+    return json;
+}
+
+static size_t count_occurrences(const char *text, const char *needle) {
+    size_t count = 0;
+    for (const char *p = strstr(text, needle); p; p = strstr(p + 1, needle)) {
+        count++;
+    }
+    return count;
+}
+
+// --- Test Cases ---
+
+static void test_trace_writes_nested_events(void) {
+    trace_begin("phase", "dropped"); // Not recording yet
+    TEST_ASSERT_TRUE(trace_start(TRACE_FILE));
+    TEST_ASSERT_EQUAL(0, trace_event_count());
+    trace_begin("process", "gcc \"quoted\\path\"");
+    trace_begin("pass", "fold_constants");
+    trace_end("pass", "fold_constants");
+    trace_end("process", NULL);
+    TEST_ASSERT_EQUAL(4, trace_event_count());
+    TEST_ASSERT_TRUE(trace_stop());
+    trace_end("phase", "dropped");
+    TEST_ASSERT_TRUE(trace_stop()); // Nothing recording: nothing to write
+
+    char *json = read_trace();
+    TEST_ASSERT_EQUAL_STRING_LEN("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", json, 39);
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"gcc \\\"quoted\\\\path\\\"\",\"cat\":\"process\",\"ph\":\"B\""));
+    TEST_ASSERT_NOT_NULL(strstr(json, "{\"name\":\"fold_constants\",\"cat\":\"pass\",\"ph\":\"E\""));
+    TEST_ASSERT_EQUAL(2, count_occurrences(json, "\"ph\":\"B\""));
+    TEST_ASSERT_EQUAL(2, count_occurrences(json, "\"ph\":\"E\""));
+    TEST_ASSERT_NULL(strstr(json, "dropped"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "}\n]}\n"));
+    free(json);
+    remove(TRACE_FILE);
+}
+
+static void test_trace_covers_phases_passes_and_functions(void) {
+    Arena arena = arena_create(64 * 1024);
+    StringBuffer sb;
+    string_buffer_init(&sb, &arena, 1024);
+    CompileOptions options;
+    compile_options_init(&options);
+    options.optimization_level = 1;
+    options.quiet = true;
+
+    TEST_ASSERT_TRUE(trace_start(TRACE_FILE));
+    TEST_ASSERT_TRUE(compile_with_options("int main(void) { return 2 + 3; }", &options, &sb, &arena, NULL));
+    TEST_ASSERT_TRUE(trace_stop());
+
+    char *json = read_trace();
+    static const char *const expected[] = {
+        "{\"name\":\"lex\",\"cat\":\"phase\"",
+        "{\"name\":\"optimize\",\"cat\":\"phase\"",
+        "{\"name\":\"codegen\",\"cat\":\"phase\"",
+        "{\"name\":\"main\",\"cat\":\"optimize\"",
+        "{\"name\":\"fold_constants\",\"cat\":\"pass\"",
+        "{\"name\":\"main\",\"cat\":\"codegen\"",
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        TEST_ASSERT_NOT_NULL_MESSAGE(strstr(json, expected[i]), expected[i]);
+    }
+    TEST_ASSERT_EQUAL(count_occurrences(json, "\"ph\":\"B\""), count_occurrences(json, "\"ph\":\"E\""));
+    free(json);
+    remove(TRACE_FILE);
+    arena_destroy(&arena);
+}
+
+// --- Test Runner ---
+
+void run_trace_tests(void) {
+    RUN_TEST(test_trace_writes_nested_events);
+    RUN_TEST(test_trace_covers_phases_passes_and_functions);
+}
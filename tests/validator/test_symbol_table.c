@@ -3,7 +3,9 @@
 #include "memory/arena.h"
 #include "lexer/lexer.h" // For Token struct
 #include "strings/strings.h" // For arena_strdup
+#include "strings/interner.h"
 #include <string.h> // For strcmp
+#include <stdio.h> // For snprintf
 
 // Helper to create a dummy token for tests
 static Token create_dummy_token(Arena* arena, TokenType type, const char* lexeme, int line_unused, int col_unused) {
@@ -12,6 +14,7 @@ static Token create_dummy_token(Arena* arena, TokenType type, const char* lexeme
     // Duplicate the lexeme into the provided arena to avoid const issues and manage memory
     // ReSharper disable once CppDFAConstantConditions
     t.lexeme = lexeme ? arena_strdup(arena, lexeme) : NULL;
+    t.length = lexeme ? (uint32_t) strlen(lexeme) : 0;
     t.position = 0; // Initialize position for the dummy token
     return t;
 }
@@ -146,6 +149,87 @@ static void test_symbol_table_lookup_in_current_scope_only(void) {
     arena_destroy(&local_arena);
 }
 
+static void test_symbol_table_exit_scope_releases_memory(void) {
+    Arena local_arena = arena_create(1024 * 4);
+    SymbolTable local_st;
+    symbol_table_init(&local_st, &local_arena);
+
+    symbol_table_enter_scope(&local_st);
+    const size_t offset_at_entry = local_arena.offset;
+    Token token = create_dummy_token(&local_arena, TOKEN_IDENTIFIER, "tmp", 9, 1);
+    TEST_ASSERT_TRUE(symbol_table_add_symbol(&local_st, "tmp", token));
+    TEST_ASSERT_GREATER_THAN(offset_at_entry, local_arena.offset);
+
+    // Leaving the scope gives its symbols back; the arena returns to where the scope began
+    symbol_table_exit_scope(&local_st);
+    TEST_ASSERT_EQUAL(offset_at_entry, local_arena.offset);
+
+    arena_destroy(&local_arena);
+}
+
+static void test_symbol_table_interned_names_match_by_pointer(void) {
+    Arena local_arena = arena_create(1024 * 4);
+    StringInterner interner;
+    TEST_ASSERT_TRUE(interner_init(&interner, &local_arena, 0));
+    const char *a = interner_intern(&interner, "a");
+    const char *b = interner_intern(&interner, "b");
+
+    SymbolTable local_st;
+    symbol_table_init_interned(&local_st, &local_arena, &interner);
+    Token token_a = create_dummy_token(&local_arena, TOKEN_IDENTIFIER, "a", 1, 1);
+    TEST_ASSERT_TRUE(symbol_table_add_symbol(&local_st, a, token_a));
+
+    // The symbol keeps the canonical pointer rather than a copy
+    const Symbol *found = symbol_table_lookup_symbol(&local_st, interner_intern(&interner, "a"));
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_EQUAL_PTR(a, found->name);
+    TEST_ASSERT_NULL(symbol_table_lookup_symbol(&local_st, b));
+    TEST_ASSERT_FALSE(symbol_table_add_symbol(&local_st, a, token_a)); // Redeclaration
+
+    // Shadowing works the same way as with copied names
+    symbol_table_enter_scope(&local_st);
+    TEST_ASSERT_TRUE(symbol_table_add_symbol(&local_st, a, token_a));
+    const Symbol *inner = symbol_table_lookup_symbol(&local_st, a);
+    TEST_ASSERT_TRUE(inner != found);
+    symbol_table_exit_scope(&local_st);
+    TEST_ASSERT_EQUAL_PTR(found, symbol_table_lookup_symbol(&local_st, a));
+
+    arena_destroy(&local_arena);
+}
+
+// Lookup cost is measured in hash probes, which is deterministic (unlike wall-clock time).
+// The average must not grow with the number of symbols in a scope.
+static void test_symbol_table_probe_count_flat_up_to_100k_symbols(void) {
+    const int sizes[] = {100, 1000, 10000, 100000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        Arena local_arena = arena_create(1024 * 64);
+        SymbolTable local_st;
+        symbol_table_init(&local_st, &local_arena);
+        const Token token = create_dummy_token(&local_arena, TOKEN_IDENTIFIER, "v", 1, 1);
+
+        char name[32];
+        for (int i = 0; i < sizes[s]; ++i) {
+            snprintf(name, sizeof(name), "local_var_%d", i);
+            TEST_ASSERT_TRUE(symbol_table_add_symbol(&local_st, name, token));
+        }
+        for (int i = 0; i < sizes[s]; i += 97) {
+            snprintf(name, sizeof(name), "local_var_%d", i);
+            const Symbol *found = symbol_table_lookup_symbol(&local_st, name);
+            TEST_ASSERT_NOT_NULL(found);
+            TEST_ASSERT_EQUAL_STRING(name, found->name);
+        }
+        TEST_ASSERT_NULL(symbol_table_lookup_symbol(&local_st, "not_declared"));
+
+        const SymbolTableStats stats = symbol_table_stats(&local_st);
+        TEST_ASSERT_EQUAL(sizes[s], stats.symbol_count);
+        TEST_ASSERT_GREATER_OR_EQUAL(2 * stats.symbol_count, stats.slot_count); // At most half full
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%d symbols: %zu probes total", sizes[s], stats.total_probes);
+        TEST_ASSERT_TRUE_MESSAGE(stats.total_probes <= 2 * stats.symbol_count, msg);
+
+        arena_destroy(&local_arena);
+    }
+}
 
 void run_symbol_table_tests(void) {
     RUN_TEST(test_symbol_table_init_and_global_scope);
@@ -155,4 +239,7 @@ void run_symbol_table_tests(void) {
     RUN_TEST(test_symbol_table_enter_exit_scopes);
     RUN_TEST(test_symbol_table_shadowing_and_lookup_order);
     RUN_TEST(test_symbol_table_lookup_in_current_scope_only);
+    RUN_TEST(test_symbol_table_exit_scope_releases_memory);
+    RUN_TEST(test_symbol_table_interned_names_match_by_pointer);
+    RUN_TEST(test_symbol_table_probe_count_flat_up_to_100k_symbols);
 }
@@ -14,6 +14,7 @@ static void test_validate_redeclared_variable_same_scope(void);
 static void test_validate_shadowed_variable_inner_scope(void);
 static void test_validate_valid_variable_usage(void);
 static void test_validate_invalid_assignment_lvalue(void);
+static void test_validate_releases_symbol_table_memory(void);
 
 // Test Suite Runner
 void run_validator_tests(void) {
@@ -23,6 +24,7 @@ void run_validator_tests(void) {
     RUN_TEST(test_validate_shadowed_variable_inner_scope);
     RUN_TEST(test_validate_valid_variable_usage);
     RUN_TEST(test_validate_invalid_assignment_lvalue);
+    RUN_TEST(test_validate_releases_symbol_table_memory);
     // Add more tests here
 }
 
@@ -221,3 +223,35 @@ static void test_validate_invalid_assignment_lvalue(void) {
     // Cleanup
     arena_destroy(&test_arena);
 }
+
+static void test_validate_releases_symbol_table_memory(void) {
+    // Arrange: AST for "int main() { int a; { int b; } return a; }"
+    Arena test_arena = arena_create(1024 * 4);
+
+    VarDeclNode* var_decl_a = create_var_decl_node("int", "a", NULL, &test_arena);
+    VarDeclNode* var_decl_b = create_var_decl_node("int", "b", NULL, &test_arena);
+    BlockNode* inner_block = create_block_node(&test_arena);
+    block_node_add_item(inner_block, (AstNode*)var_decl_b, &test_arena);
+    IdentifierNode* ident_a = create_identifier_node("a", &test_arena);
+    ReturnStmtNode* return_stmt = create_return_stmt_node((AstNode*)ident_a, &test_arena);
+
+    BlockNode* block_node = create_block_node(&test_arena);
+    block_node_add_item(block_node, (AstNode*)var_decl_a, &test_arena);
+    block_node_add_item(block_node, (AstNode*)inner_block, &test_arena);
+    block_node_add_item(block_node, (AstNode*)return_stmt, &test_arena);
+    FuncDefNode* func_def = create_func_def_node("main", block_node, &test_arena);
+    ProgramNode* program_node = create_program_node(func_def, &test_arena);
+
+    const size_t used_before = arena_stats(&test_arena).used_bytes;
+
+    // Act: Validate the program
+    bool is_valid = validate_program((AstNode*)program_node, &test_arena);
+
+    // Assert: the symbol table was scratch memory and has been given back
+    TEST_ASSERT_TRUE(is_valid);
+    TEST_ASSERT_EQUAL(used_before, arena_stats(&test_arena).used_bytes);
+    TEST_ASSERT_GREATER_THAN(used_before, arena_stats(&test_arena).peak_bytes);
+
+    // Cleanup
+    arena_destroy(&test_arena);
+}